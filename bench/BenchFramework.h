@@ -0,0 +1,102 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+/// <summary>
+/// A minimal benchmark harness for the headless benchmark project. Benchmarks register themselves like
+/// the test cases do, and BenchMain.cpp runs them all (or the ones whose names contain the first command
+/// line argument). Each benchmark times its own before/after variants with Measure, and prints them with
+/// Report and Compare so the results can be pasted straight into a review
+///
+/// Benchmarks must not touch OpenGL, there is no window or context in the benchmark project. Only release
+/// builds give meaningful numbers
+/// </summary>
+namespace Benchmark {
+	typedef void(*BenchFunction)();
+
+	struct BenchCase {
+		const char*   Name;
+		BenchFunction Function;
+	};
+
+	/// <summary>
+	/// The timings from a set of runs of a single variant, in milliseconds
+	/// </summary>
+	struct Result {
+		double MedianMs = 0.0;
+		double MinMs    = 0.0;
+	};
+
+	/// <summary>
+	/// Gets every benchmark that has been registered
+	/// </summary>
+	std::vector<BenchCase>& GetBenchCases();
+
+	/// <summary>
+	/// Registers a benchmark from a static initializer
+	/// </summary>
+	struct Registrar {
+		Registrar(const char* name, BenchFunction function) {
+			GetBenchCases().push_back({ name, function });
+		}
+	};
+
+	namespace detail {
+		// The pointer itself is volatile, so stores to it can't be dropped
+		inline const void* volatile Sink = nullptr;
+	}
+
+	/// <summary>
+	/// Keeps the compiler from optimizing away a result that is otherwise never used
+	/// </summary>
+	template <typename T>
+	inline void DoNotOptimize(const T& value) {
+		detail::Sink = &value;
+	}
+
+	/// <summary>
+	/// Runs a function once to warm up, then times it over several runs
+	/// </summary>
+	/// <param name="runs">The number of timed runs</param>
+	/// <param name="function">The function to time, any setup that shouldn't be timed must happen outside of it</param>
+	template <typename Function>
+	Result Measure(uint32_t runs, Function&& function) {
+		using Clock = std::chrono::steady_clock;
+		function();
+
+		std::vector<double> times(runs);
+		for (double& time : times) {
+			Clock::time_point start = Clock::now();
+			function();
+			time = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+		}
+		std::sort(times.begin(), times.end());
+
+		Result result;
+		result.MedianMs = times[times.size() / 2];
+		result.MinMs = times.front();
+		return result;
+	}
+
+	/// <summary>
+	/// Prints the timings for a single variant
+	/// </summary>
+	inline void Report(const char* label, const Result& result) {
+		printf("    %-40s median %9.3f ms   min %9.3f ms\n", label, result.MedianMs, result.MinMs);
+	}
+
+	/// <summary>
+	/// Prints how much faster (or slower) a variant is than a baseline, by median time
+	/// </summary>
+	inline void Compare(const char* label, const Result& baseline, const Result& result) {
+		printf("    %-40s %.2fx\n", label, baseline.MedianMs / result.MedianMs);
+	}
+}
+
+#define BENCHMARK(name) \
+	static void name(); \
+	static Benchmark::Registrar name##_registrar(#name, &name); \
+	static void name()
@@ -0,0 +1,47 @@
+#include <cstdio>
+#include <cstring>
+#include <exception>
+
+#include "Logging.h"
+#include "Utils/JobSystem.h"
+
+#include "BenchFramework.h"
+
+namespace Benchmark {
+	std::vector<BenchCase>& GetBenchCases() {
+		// Function local so that it exists before any of the static registrars run
+		static std::vector<BenchCase> benchCases;
+		return benchCases;
+	}
+}
+
+int main(int argc, char** args) {
+	Logger::Init();
+	// Same worker count as the application, so the parallel benchmarks match what the game would see
+	JobSystem::Init();
+
+#ifdef _DEBUG
+	printf("WARNING: this is a debug build, the timings are not representative\n");
+#endif
+	printf("%u job system workers (plus the main thread)\n", JobSystem::GetWorkerCount());
+
+	const char* filter = argc > 1 ? args[1] : nullptr;
+	int failed = 0;
+	for (const Benchmark::BenchCase& bench : Benchmark::GetBenchCases()) {
+		if (filter != nullptr && strstr(bench.Name, filter) == nullptr) {
+			continue;
+		}
+
+		printf("%s\n", bench.Name);
+		try {
+			bench.Function();
+		} catch (const std::exception& e) {
+			printf("    failed with exception: %s\n", e.what());
+			failed++;
+		}
+	}
+
+	JobSystem::Shutdown();
+	Logger::Uninitialize();
+	return failed;
+}
@@ -0,0 +1,110 @@
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <typeindex>
+#include <unordered_map>
+#include <vector>
+
+#include <GLM/glm.hpp>
+
+#include "Gameplay/Components/ComponentPool.h"
+
+#include "BenchFramework.h"
+
+// IComponent drags in the whole engine (GameObject, ImGui, the resource manager), so these stand in for it.
+// They have the same shape as far as iteration is concerned: a polymorphic base with an enabled flag and a
+// weak pointer to itself, and a concrete type with a small amount of per-frame state like RotatingBehaviour
+namespace {
+	struct BenchComponent {
+		virtual ~BenchComponent() = default;
+		bool IsEnabled = true;
+		std::weak_ptr<BenchComponent> WeakSelf;
+	};
+
+	struct BenchRotating : public BenchComponent {
+		glm::vec3 Rotation = glm::vec3(0.0f);
+		glm::vec3 RotationSpeed = glm::vec3(0.0f, 0.0f, 90.0f);
+
+		void Update(float deltaTime) {
+			Rotation += RotationSpeed * deltaTime;
+		}
+	};
+
+	// The old ComponentManager::Each, weak pointers per type_index, locked and dynamic cast for every component
+	template <typename ComponentType>
+	void EachWeak(std::unordered_map<std::type_index, std::vector<std::weak_ptr<BenchComponent>>>& components,
+		std::function<void(const std::shared_ptr<ComponentType>&)> callback, bool includeDisabled = false)
+	{
+		std::type_index type = std::type_index(typeid(ComponentType));
+		for (auto& wptr : components[type]) {
+			std::shared_ptr<BenchComponent> sptr = wptr.lock();
+			if (sptr && sptr->IsEnabled | includeDisabled) {
+				callback(std::dynamic_pointer_cast<ComponentType>(sptr));
+			}
+		}
+	}
+
+	// The loop from the pooled ComponentManager::Each. The pool stores IComponent pointers, which it never
+	// dereferences, so the stand-ins are stored in it as-is
+	template <typename ComponentType, typename Callback>
+	void EachPooled(Gameplay::ComponentPool& pool, Callback&& callback, bool includeDisabled = false) {
+		for (size_t ix = 0; ix < pool.Size(); ix++) {
+			ComponentType* component = reinterpret_cast<ComponentType*>(pool[ix]);
+			if (component->IsEnabled || includeDisabled) {
+				if constexpr (std::is_invocable_v<Callback, ComponentType&>) {
+					callback(*component);
+				} else {
+					callback(std::static_pointer_cast<ComponentType>(component->WeakSelf.lock()));
+				}
+			}
+		}
+	}
+}
+
+// Iterating 100k components of one type, the same count the request for the component pools used
+BENCHMARK(ComponentEach) {
+	const size_t count = 100000;
+	const float dt = 1.0f / 60.0f;
+
+	// Other types in the map, like a real scene would have
+	std::unordered_map<std::type_index, std::vector<std::weak_ptr<BenchComponent>>> weakLists;
+	weakLists[std::type_index(typeid(BenchComponent))];
+	weakLists[std::type_index(typeid(int))];
+
+	Gameplay::ComponentPool pool;
+	std::vector<std::shared_ptr<BenchRotating>> owners;
+	owners.reserve(count);
+	for (size_t ix = 0; ix < count; ix++) {
+		std::shared_ptr<BenchRotating> component = std::make_shared<BenchRotating>();
+		component->WeakSelf = component;
+		owners.push_back(component);
+		weakLists[std::type_index(typeid(BenchRotating))].push_back(component);
+		pool.Add(reinterpret_cast<Gameplay::IComponent*>(static_cast<BenchComponent*>(component.get())));
+	}
+	printf("  %zu components\n", count);
+
+	Benchmark::Result weak = Benchmark::Measure(20, [&]() {
+		EachWeak<BenchRotating>(weakLists, [&](const std::shared_ptr<BenchRotating>& component) {
+			component->Update(dt);
+		});
+	});
+	Benchmark::Report("weak_ptr lists (old Each)", weak);
+
+	Benchmark::Result pooledShared = Benchmark::Measure(20, [&]() {
+		EachPooled<BenchRotating>(pool, [&](const std::shared_ptr<BenchRotating>& component) {
+			component->Update(dt);
+		});
+	});
+	Benchmark::Report("pool, shared_ptr callback", pooledShared);
+
+	Benchmark::Result pooled = Benchmark::Measure(20, [&]() {
+		EachPooled<BenchRotating>(pool, [&](BenchRotating& component) {
+			component.Update(dt);
+		});
+	});
+	Benchmark::Report("pool, reference callback", pooled);
+
+	Benchmark::Compare("speedup, shared_ptr callback", weak, pooledShared);
+	Benchmark::Compare("speedup, reference callback", weak, pooled);
+	Benchmark::DoNotOptimize(owners.front()->Rotation);
+}
@@ -0,0 +1,209 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <malloc.h>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "json.hpp"
+#include "Gameplay/SceneBinary.h"
+#include "Utils/FileHelpers.h"
+
+#include "BenchFramework.h"
+
+// Counts the bytes that are allocated and live on the heap, so that we can see how much memory each loader
+// needs at its peak, and how much it churns through. Replacing the global allocation functions affects the
+// whole benchmark binary, so the counting only happens inside ReportAllocations. Sizes come from the heap
+// itself rather than a header on each block, so blocks allocated before we started counting can still be
+// freed, and the other benchmarks see the same allocations as usual
+namespace {
+	std::atomic<bool>   s_Counting{ false };
+	std::atomic<size_t> s_LiveBytes{ 0 };
+	std::atomic<size_t> s_PeakBytes{ 0 };
+	std::atomic<size_t> s_TotalBytes{ 0 };
+
+	size_t GetBlockSize(void* block) {
+	#ifdef _MSC_VER
+		return _msize(block);
+	#else
+		return malloc_usable_size(block);
+	#endif
+	}
+
+	void* CountedAlloc(size_t size) {
+		void* block = std::malloc(size == 0 ? 1 : size);
+		if (block != nullptr && s_Counting.load(std::memory_order_relaxed)) {
+			size = GetBlockSize(block);
+			s_TotalBytes.fetch_add(size, std::memory_order_relaxed);
+			size_t live = s_LiveBytes.fetch_add(size, std::memory_order_relaxed) + size;
+			size_t peak = s_PeakBytes.load(std::memory_order_relaxed);
+			while (live > peak && !s_PeakBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) { }
+		}
+		return block;
+	}
+
+	void CountedFree(void* block) {
+		if (block != nullptr && s_Counting.load(std::memory_order_relaxed)) {
+			s_LiveBytes.fetch_sub(GetBlockSize(block), std::memory_order_relaxed);
+		}
+		std::free(block);
+	}
+
+	// Runs a function and prints the most heap memory that was in use during it over what was in use
+	// before, and the total size of every allocation it made
+	template <typename Function>
+	void ReportAllocations(Function&& function) {
+		size_t before = s_LiveBytes.load(std::memory_order_relaxed);
+		size_t totalBefore = s_TotalBytes.load(std::memory_order_relaxed);
+		s_PeakBytes.store(before, std::memory_order_relaxed);
+		s_Counting.store(true, std::memory_order_relaxed);
+		function();
+		s_Counting.store(false, std::memory_order_relaxed);
+		printf("      peak %.1f KB live, %.1f KB allocated in total\n",
+			(s_PeakBytes.load(std::memory_order_relaxed) - before) / 1024.0,
+			(s_TotalBytes.load(std::memory_order_relaxed) - totalBefore) / 1024.0);
+	}
+}
+
+void* operator new(size_t size) {
+	void* result = CountedAlloc(size);
+	if (result == nullptr) {
+		throw std::bad_alloc();
+	}
+	return result;
+}
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return CountedAlloc(size); }
+void operator delete(void* ptr) noexcept { CountedFree(ptr); }
+void operator delete(void* ptr, size_t) noexcept { CountedFree(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { CountedFree(ptr); }
+
+namespace {
+	nlohmann::json Vec(float x, float y, float z) {
+		return { { "x", x }, { "y", y }, { "z", z } };
+	}
+
+	// Builds an object the same way GameObject::ToJson does
+	nlohmann::json MakeObject(uint32_t index, const Guid& guid, const Guid& parent) {
+		nlohmann::json components = {
+			{ "RenderComponent", {
+				{ "guid", Guid::New().str() }, { "enabled", true },
+				{ "mesh", Guid::New().str() }, { "material", Guid::New().str() }
+			} }
+		};
+		if (index % 2 == 0) {
+			components["RotatingBehaviour"] = { { "guid", Guid::New().str() }, { "enabled", true }, { "speed", Vec(0.0f, 0.0f, 90.0f) } };
+		}
+		if (index % 5 == 0) {
+			nlohmann::json collider = {
+				{ "type", "Box" }, { "guid", Guid::New().str() }, { "position", Vec(0.0f, 0.0f, 0.0f) },
+				{ "rotation", Vec(0.0f, 0.0f, 0.0f) }, { "scale", Vec(1.0f, 1.0f, 1.0f) }, { "extents", Vec(0.5f, 0.5f, 0.5f) }
+			};
+			components["Gameplay::Physics::RigidBody"] = {
+				{ "guid", Guid::New().str() }, { "enabled", true }, { "type", "Dynamic" }, { "mass", 1.0f },
+				{ "colliders", { collider } }
+			};
+		}
+
+		nlohmann::json result;
+		result["name"] = "Object " + std::to_string(index);
+		result["guid"] = guid.str();
+		result["parent"] = parent.isValid() ? parent.str() : "null";
+		result["position"] = Vec((float)(index % 100), (float)(index / 100), 0.0f);
+		result["rotation"] = { { "x", 0.0f }, { "y", 0.0f }, { "z", 0.0f }, { "w", 1.0f } };
+		result["scale"] = Vec(1.0f, 1.0f, 1.0f);
+		result["hide_in_inspector"] = false;
+		result["components"] = components;
+		result["children"] = std::vector<nlohmann::json>();
+		return result;
+	}
+
+	// A scene in the layout that Scene::ToJson writes, made of groups of a root object and 9 children.
+	// Like Scene::ToJson, children are listed in the flat object list and nested in their parent
+	nlohmann::json MakeScene(uint32_t count) {
+		nlohmann::json objects = nlohmann::json::array();
+		Guid root;
+		size_t rootIndex = 0;
+		for (uint32_t ix = 0; ix < count; ix++) {
+			if (ix % 10 == 0) {
+				root = Guid::New();
+				rootIndex = objects.size();
+				objects.push_back(MakeObject(ix, root, Guid()));
+			} else {
+				nlohmann::json child = MakeObject(ix, Guid::New(), root);
+				objects[rootIndex]["children"].push_back(child);
+				objects.push_back(std::move(child));
+			}
+		}
+
+		nlohmann::json scene;
+		scene["default_material"] = "null";
+		scene["main_camera"] = "null";
+		scene["ambient"] = Vec(0.1f, 0.1f, 0.1f);
+		scene["objects"] = std::move(objects);
+		return scene;
+	}
+}
+
+// Loading a generated scene of 1k and 10k objects, each with 1 to 3 components. Scene::Load parses the
+// whole JSON file into a document before it creates any objects. For binary scenes it opens the file with
+// SceneBinary::Reader and decodes each component's blob on its own, which is timed here for every component.
+// Creating the objects and components is the same for both, and isn't timed
+BENCHMARK(SceneLoad) {
+	std::filesystem::path folder = std::filesystem::temp_directory_path() / "scene-load-bench";
+	std::filesystem::create_directories(folder);
+
+	for (uint32_t count : { 1000u, 10000u }) {
+		std::string jsonPath = (folder / ("scene" + std::to_string(count) + ".json")).string();
+		std::string binaryPath = (folder / ("scene" + std::to_string(count) + Gameplay::SceneBinary::EXTENSION)).string();
+		{
+			nlohmann::json scene = MakeScene(count);
+			// Scenes are saved indented, see Scene::Save
+			FileHelpers::WriteContentsToFile(jsonPath, scene.dump(1, '\t'));
+			Gameplay::SceneBinary::Write(scene, binaryPath);
+		}
+		printf("  %u objects, JSON %.2f MB, binary %.2f MB\n", count,
+			std::filesystem::file_size(jsonPath) / (1024.0 * 1024.0), std::filesystem::file_size(binaryPath) / (1024.0 * 1024.0));
+
+		auto loadJson = [&]() {
+			std::string content = FileHelpers::ReadFile(jsonPath);
+			nlohmann::json blob = nlohmann::json::parse(content);
+			Benchmark::DoNotOptimize(blob);
+		};
+		size_t components = 0;
+		auto loadBinary = [&]() {
+			Gameplay::SceneBinary::Reader reader;
+			if (!reader.Open(binaryPath)) {
+				throw std::runtime_error("Failed to open " + binaryPath);
+			}
+			components = 0;
+			for (uint32_t ix = 0; ix < reader.GetNumObjects(); ix++) {
+				const Gameplay::SceneBinary::BinaryObject& record = reader.GetObjectRecord(ix);
+				std::string name(reader.GetString(record.Name));
+				Benchmark::DoNotOptimize(name);
+				for (uint32_t componentIx = record.FirstComponent; componentIx < record.FirstComponent + record.NumComponents; componentIx++) {
+					const Gameplay::SceneBinary::BinaryComponent& componentRecord = reader.GetComponentRecord(componentIx);
+					std::string typeName(reader.GetTypeName(componentRecord.Type));
+					nlohmann::json data = reader.ReadComponentData(componentRecord);
+					Benchmark::DoNotOptimize(data);
+					components++;
+				}
+			}
+		};
+
+		Benchmark::Result json = Benchmark::Measure(5, loadJson);
+		Benchmark::Report("read and parse JSON", json);
+		ReportAllocations(loadJson);
+
+		Benchmark::Result binary = Benchmark::Measure(5, loadBinary);
+		Benchmark::Report("open binary and decode components", binary);
+		ReportAllocations(loadBinary);
+		printf("      %zu components, the mapped file isn't counted\n", components);
+		Benchmark::Compare("speedup", json, binary);
+	}
+
+	std::filesystem::remove_all(folder);
+}
@@ -0,0 +1,261 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Gameplay/ObjectList.h"
+
+#include "BenchFramework.h"
+
+// GameObject needs a scene, and a Scene owns a Bullet physics world, so these stand in for them. The object
+// has the GUID and name that the lookups use, and the lists below are the versions of Scene's object list
+// that ObjectList replaced
+namespace {
+	struct BenchObject {
+		Guid        Id = Guid::New();
+		std::string Name;
+
+		Guid GetGUID() const { return Id; }
+		const std::string& GetName() const { return Name; }
+	};
+	typedef std::shared_ptr<BenchObject> BenchObjectPtr;
+
+	// The original Scene, which scanned every object for lookups, and found and erased each deleted object
+	struct LinearObjectList {
+		std::vector<BenchObjectPtr> Objects;
+
+		void Add(const BenchObjectPtr& object) { Objects.push_back(object); }
+
+		BenchObjectPtr FindByGuid(const Guid& guid) const {
+			auto it = std::find_if(Objects.begin(), Objects.end(), [&](const BenchObjectPtr& object) { return object->Id == guid; });
+			return it == Objects.end() ? nullptr : *it;
+		}
+		BenchObjectPtr FindByName(const std::string& name) const {
+			auto it = std::find_if(Objects.begin(), Objects.end(), [&](const BenchObjectPtr& object) { return object->Name == name; });
+			return it == Objects.end() ? nullptr : *it;
+		}
+		void Remove(const std::vector<BenchObjectPtr>& objects) {
+			for (const BenchObjectPtr& object : objects) {
+				auto it = std::find(Objects.begin(), Objects.end(), object);
+				if (it != Objects.end()) {
+					Objects.erase(it);
+				}
+			}
+		}
+	};
+
+	// The first indexed Scene, with multimap lookups and deleted objects swapped out for the last object.
+	// Lookups where names or GUIDs collide return whichever entry the multimap finds first
+	struct SwapRemoveObjectList {
+		std::vector<BenchObjectPtr> Objects;
+		std::unordered_multimap<Guid, size_t> Indices;
+		std::unordered_multimap<std::string, BenchObject*> ByName;
+
+		void Add(const BenchObjectPtr& object) {
+			Indices.emplace(object->Id, Objects.size());
+			ByName.emplace(object->Name, object.get());
+			Objects.push_back(object);
+		}
+
+		BenchObjectPtr FindByGuid(const Guid& guid) const {
+			auto it = Indices.find(guid);
+			return it == Indices.end() ? nullptr : Objects[it->second];
+		}
+		BenchObject* FindByName(const std::string& name) const {
+			auto it = ByName.find(name);
+			return it == ByName.end() ? nullptr : it->second;
+		}
+
+		std::unordered_multimap<Guid, size_t>::iterator FindIndexEntry(const Guid& guid, size_t index) {
+			auto range = Indices.equal_range(guid);
+			for (auto it = range.first; it != range.second; it++) {
+				if (it->second == index) {
+					return it;
+				}
+			}
+			return Indices.end();
+		}
+
+		void RemoveAt(size_t index) {
+			BenchObjectPtr object = Objects[index];
+			auto indexIt = FindIndexEntry(object->Id, index);
+			if (indexIt != Indices.end()) {
+				Indices.erase(indexIt);
+			}
+			auto range = ByName.equal_range(object->Name);
+			for (auto it = range.first; it != range.second; it++) {
+				if (it->second == object.get()) {
+					ByName.erase(it);
+					break;
+				}
+			}
+
+			size_t last = Objects.size() - 1;
+			if (index != last) {
+				Objects[index] = std::move(Objects[last]);
+				auto lastIt = FindIndexEntry(Objects[index]->Id, last);
+				if (lastIt != Indices.end()) {
+					lastIt->second = index;
+				}
+			}
+			Objects.pop_back();
+		}
+
+		void Remove(const std::vector<BenchObjectPtr>& objects) {
+			for (const BenchObjectPtr& object : objects) {
+				auto range = Indices.equal_range(object->Id);
+				for (auto it = range.first; it != range.second; it++) {
+					if (Objects[it->second] == object) {
+						RemoveAt(it->second);
+						break;
+					}
+				}
+			}
+		}
+	};
+
+	// Times a function over several runs, calling setup before each run without timing it. Deleting
+	// objects changes the list, so every run needs to start from a freshly built one
+	template <typename Setup, typename Function>
+	Benchmark::Result MeasureWithSetup(uint32_t runs, Setup&& setup, Function&& function) {
+		using Clock = std::chrono::steady_clock;
+		std::vector<double> times(runs);
+		for (double& time : times) {
+			setup();
+			Clock::time_point start = Clock::now();
+			function();
+			time = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+		}
+		std::sort(times.begin(), times.end());
+		return Benchmark::Result{ times[times.size() / 2], times.front() };
+	}
+}
+
+// Looking up and deleting objects in scenes of 10k and 100k objects, with the original linear scans, the
+// first indexed version that swap removed deleted objects, and ObjectList, which Scene now uses. Every
+// tenth object is named "Tree", like instanced props, and the rest have unique names. Deletes are timed as
+// a single _FlushDeleteQueue, for one object near the start of the scene, and for 1% and 10% of the scene
+BENCHMARK(SceneObjects) {
+	for (size_t count : { 10000, 100000 }) {
+		std::mt19937 random(1234);
+		std::vector<BenchObjectPtr> objects(count);
+		for (size_t ix = 0; ix < count; ix++) {
+			objects[ix] = std::make_shared<BenchObject>();
+			objects[ix]->Name = ix % 10 == 0 ? "Tree" : "Object " + std::to_string(ix);
+		}
+		printf("  %zu objects\n", count);
+
+		// Lookups for objects spread through the scene, like WeakRef::Resolve and components finding
+		// each other in Awake. The linear scans are slow enough at 100k that they get fewer lookups
+		std::vector<Guid> guids(10000);
+		std::vector<std::string> names(guids.size());
+		for (size_t ix = 0; ix < guids.size(); ix++) {
+			const BenchObjectPtr& object = objects[std::uniform_int_distribution<size_t>(0, count - 1)(random)];
+			guids[ix] = object->Id;
+			names[ix] = object->Name;
+		}
+		const size_t linearLookups = count > 10000 ? 1000 : guids.size();
+
+		LinearObjectList linear;
+		SwapRemoveObjectList swapRemove;
+		Gameplay::ObjectList<BenchObject> list;
+		for (const BenchObjectPtr& object : objects) {
+			linear.Add(object);
+			swapRemove.Add(object);
+			list.Add(object);
+		}
+
+		Benchmark::Result linearGuid = Benchmark::Measure(3, [&]() {
+			for (size_t ix = 0; ix < linearLookups; ix++) {
+				Benchmark::DoNotOptimize(linear.FindByGuid(guids[ix]));
+			}
+		});
+		Benchmark::Result swapGuid = Benchmark::Measure(10, [&]() {
+			for (const Guid& guid : guids) {
+				Benchmark::DoNotOptimize(swapRemove.FindByGuid(guid));
+			}
+		});
+		Benchmark::Result listGuid = Benchmark::Measure(10, [&]() {
+			for (const Guid& guid : guids) {
+				Benchmark::DoNotOptimize(list.FindByGuid(guid));
+			}
+		});
+		Benchmark::Result linearName = Benchmark::Measure(3, [&]() {
+			for (size_t ix = 0; ix < linearLookups; ix++) {
+				Benchmark::DoNotOptimize(linear.FindByName(names[ix]));
+			}
+		});
+		Benchmark::Result swapName = Benchmark::Measure(10, [&]() {
+			for (const std::string& name : names) {
+				Benchmark::DoNotOptimize(swapRemove.FindByName(name));
+			}
+		});
+		Benchmark::Result listName = Benchmark::Measure(10, [&]() {
+			for (const std::string& name : names) {
+				Benchmark::DoNotOptimize(list.FindByName(name));
+			}
+		});
+
+		// The linear scans do fewer lookups, so they're compared per lookup
+		auto perLookup = [](Benchmark::Result result, size_t lookups) {
+			result.MedianMs /= lookups;
+			result.MinMs /= lookups;
+			return result;
+		};
+		auto reportLookups = [](const char* label, const Benchmark::Result& result, size_t lookups) {
+			Benchmark::Report(label, result);
+			printf("      %.1f ns per lookup\n", result.MedianMs * 1000000.0 / lookups);
+		};
+		printf("    %zu lookups (%zu for the linear scans)\n", guids.size(), linearLookups);
+		reportLookups("by GUID, linear scan (original)", linearGuid, linearLookups);
+		reportLookups("by GUID, multimap (swap remove)", swapGuid, guids.size());
+		reportLookups("by GUID, ObjectList", listGuid, guids.size());
+		Benchmark::Compare("speedup over linear scan", perLookup(linearGuid, linearLookups), perLookup(listGuid, guids.size()));
+		reportLookups("by name, linear scan (original)", linearName, linearLookups);
+		reportLookups("by name, multimap (swap remove)", swapName, names.size());
+		reportLookups("by name, ObjectList", listName, names.size());
+		Benchmark::Compare("speedup over linear scan", perLookup(linearName, linearLookups), perLookup(listName, names.size()));
+
+		for (size_t deleteCount : { (size_t)1, count / 100, count / 10 }) {
+			// A single delete is the worst case for in order removal, since everything after it moves
+			std::vector<BenchObjectPtr> deleting;
+			if (deleteCount == 1) {
+				deleting.push_back(objects[count / 100]);
+			} else {
+				std::vector<BenchObjectPtr> shuffled = objects;
+				std::shuffle(shuffled.begin(), shuffled.end(), random);
+				deleting.assign(shuffled.begin(), shuffled.begin() + deleteCount);
+			}
+			printf("    deleting %zu object%s\n", deleteCount, deleteCount > 1 ? "s" : "");
+
+			Benchmark::Result linearDelete = MeasureWithSetup(3, [&]() {
+				linear = LinearObjectList();
+				for (const BenchObjectPtr& object : objects) {
+					linear.Add(object);
+				}
+			}, [&]() { linear.Remove(deleting); });
+			Benchmark::Result swapDelete = MeasureWithSetup(5, [&]() {
+				swapRemove = SwapRemoveObjectList();
+				for (const BenchObjectPtr& object : objects) {
+					swapRemove.Add(object);
+				}
+			}, [&]() { swapRemove.Remove(deleting); });
+			Benchmark::Result listDelete = MeasureWithSetup(5, [&]() {
+				list.Clear();
+				for (const BenchObjectPtr& object : objects) {
+					list.Add(object);
+				}
+			}, [&]() { list.Remove(deleting, [](BenchObject&) { }); });
+
+			Benchmark::Report("find and erase each (original)", linearDelete);
+			Benchmark::Report("swap remove each", swapDelete);
+			Benchmark::Report("ObjectList::Remove, in order", listDelete);
+			Benchmark::Compare("speedup over original", linearDelete, listDelete);
+			Benchmark::Compare("speedup over swap remove", swapDelete, listDelete);
+		}
+	}
+}
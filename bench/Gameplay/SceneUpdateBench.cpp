@@ -0,0 +1,162 @@
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <GLM/glm.hpp>
+#include <GLM/gtc/quaternion.hpp>
+
+#include "Gameplay/Components/ComponentPool.h"
+#include "Gameplay/TransformStore.h"
+#include "Utils/JobSystem.h"
+
+#include "BenchFramework.h"
+
+// GameObject and the real components need a scene, physics and ImGui, so these stand in for them. The
+// objects keep their transforms in a real TransformStore, and the component updates do the same work as
+// RotatingBehaviour and EnemyBehaviour through the same getters and setters
+namespace {
+	struct BenchObject {
+		Gameplay::TransformStore* Store = nullptr;
+		uint32_t Transform = 0;
+
+		const glm::vec3& GetPosition() const { return Store->GetPosition(Transform); }
+		void SetPosition(const glm::vec3& value) { Store->SetPosition(Transform, value); }
+		glm::vec3 GetRotationEuler() const { return glm::degrees(glm::eulerAngles(Store->GetRotation(Transform))); }
+		void SetRotation(const glm::vec3& eulerAngles) { Store->SetRotation(Transform, glm::quat(glm::radians(eulerAngles))); }
+	};
+
+	struct BenchComponent {
+		virtual ~BenchComponent() = default;
+		// Like IComponent::Update, most types never override this
+		virtual void Update(float deltaTime) { }
+
+		bool IsEnabled = true;
+		BenchObject* Object = nullptr;
+	};
+
+	// Stands in for RenderComponent, which every object in the scene has
+	struct BenchRenderer : public BenchComponent { };
+
+	struct BenchRotating : public BenchComponent {
+		glm::vec3 RotationSpeed = glm::vec3(0.0f, 0.0f, 90.0f);
+
+		virtual void Update(float deltaTime) override {
+			Object->SetRotation(Object->GetRotationEuler() + RotationSpeed * deltaTime);
+		}
+	};
+
+	struct BenchEnemy : public BenchComponent {
+		BenchObject* Player = nullptr;
+		float Speed = 0.01f;
+
+		virtual void Update(float deltaTime) override {
+			glm::vec3 direction = glm::normalize(Player->GetPosition() + glm::vec3(0.f, 0.f, 3.f) - Object->GetPosition());
+			Object->SetPosition(Object->GetPosition() + ((direction) * Speed));
+		}
+	};
+
+	// The update loop from the new Scene::_UpdateComponents, for the types that run in parallel
+	template <typename ComponentType>
+	void UpdateType(std::vector<std::unique_ptr<ComponentType>>& components, float dt) {
+		JobSystem::ParallelFor(components.size(), Gameplay::ComponentPool::UPDATE_BATCH_SIZE, [&](size_t begin, size_t end) {
+			for (size_t ix = begin; ix < end; ix++) {
+				if (components[ix]->IsEnabled) {
+					components[ix]->Update(dt);
+				}
+			}
+		});
+	}
+}
+
+// Updating a scene of 50k objects, half rotating and half chasing the player, each with a renderer that
+// doesn't override Update. The old Scene::Update walks every object and calls Update on each of its
+// components, the new one updates the types that override Update in parallel batches
+BENCHMARK(SceneUpdate) {
+	const size_t count = 50000;
+	const float dt = 1.0f / 60.0f;
+
+	Gameplay::TransformStore store;
+	BenchObject player;
+	player.Store = &store;
+	player.Transform = store.Create();
+
+	std::vector<std::unique_ptr<BenchObject>> objects;
+	std::vector<std::unique_ptr<BenchRenderer>> renderers;
+	std::vector<std::unique_ptr<BenchRotating>> rotating;
+	std::vector<std::unique_ptr<BenchEnemy>> enemies;
+	std::vector<std::vector<BenchComponent*>> objectComponents;
+	for (size_t ix = 0; ix < count; ix++) {
+		std::unique_ptr<BenchObject> object = std::make_unique<BenchObject>();
+		object->Store = &store;
+		object->Transform = store.Create();
+
+		std::vector<BenchComponent*> components;
+		renderers.push_back(std::make_unique<BenchRenderer>());
+		renderers.back()->Object = object.get();
+		components.push_back(renderers.back().get());
+		if (ix % 2 == 0) {
+			rotating.push_back(std::make_unique<BenchRotating>());
+			rotating.back()->Object = object.get();
+			components.push_back(rotating.back().get());
+		} else {
+			enemies.push_back(std::make_unique<BenchEnemy>());
+			enemies.back()->Object = object.get();
+			enemies.back()->Player = &player;
+			components.push_back(enemies.back().get());
+		}
+		objectComponents.push_back(std::move(components));
+		objects.push_back(std::move(object));
+	}
+	printf("  %zu objects, %zu rotating, %zu enemies\n", count, rotating.size(), enemies.size());
+
+	// The cost of the updates changes as the objects move, so every variant starts from the same state
+	auto reset = [&]() {
+		for (size_t ix = 0; ix < count; ix++) {
+			objects[ix]->SetPosition(glm::vec3((float)(ix % 256), (float)(ix / 256), 0.0f));
+			objects[ix]->SetRotation(glm::vec3(0.0f));
+		}
+	};
+
+	reset();
+
+	Benchmark::Result serial = Benchmark::Measure(20, [&]() {
+		for (std::vector<BenchComponent*>& components : objectComponents) {
+			for (BenchComponent* component : components) {
+				if (component->IsEnabled) {
+					component->Update(dt);
+				}
+			}
+		}
+	});
+	Benchmark::Report("per object, serial (old Update)", serial);
+
+	// Restart the job system with more threads each time, up to the number of hardware threads. With no
+	// job system running ParallelFor runs every batch on the calling thread
+	uint32_t hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+	JobSystem::Shutdown();
+	for (uint32_t threads = 1; threads <= hardwareThreads; threads *= 2) {
+		if (threads > 1) {
+			JobSystem::Init(threads - 1);
+		}
+
+		reset();
+
+		Benchmark::Result result = Benchmark::Measure(20, [&]() {
+			UpdateType(rotating, dt);
+			UpdateType(enemies, dt);
+		});
+
+		char label[64];
+		snprintf(label, sizeof(label), "per type, %u thread%s", threads, threads > 1 ? "s" : "");
+		Benchmark::Report(label, result);
+		Benchmark::Compare("speedup", serial, result);
+
+		JobSystem::Shutdown();
+	}
+	JobSystem::Init();
+
+	printf("    %u hardware threads, scaling past that was not measured\n", hardwareThreads);
+	Benchmark::DoNotOptimize(store.GetPosition(objects.back()->Transform));
+}
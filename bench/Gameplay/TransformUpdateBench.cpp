@@ -0,0 +1,185 @@
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include <GLM/glm.hpp>
+#include <GLM/gtc/matrix_transform.hpp>
+#include <GLM/gtc/quaternion.hpp>
+
+#include "Gameplay/TransformStore.h"
+
+#include "BenchFramework.h"
+
+namespace {
+	const glm::mat4 IDENTITY = glm::mat4(1.0f);
+
+	// The old version only dirtied the direct children of a moved object, so grandchildren kept stale world
+	// transforms. When set, children are also dirtied whenever a world transform changes, which is what the
+	// old version would have had to do to give the same results as the store
+	bool s_DirtyWholeSubtree = false;
+
+	// The transform half of the old GameObject, four cached matrices behind dirty flags, with world
+	// transforms pulled recursively through the parent
+	struct LegacyTransform {
+		glm::vec3 Position = glm::vec3(0.0f);
+		glm::quat Rotation = glm::quat(glm::vec3(0.0f));
+		glm::vec3 Scale = glm::vec3(1.0f);
+
+		std::weak_ptr<LegacyTransform> Parent;
+		std::vector<std::weak_ptr<LegacyTransform>> Children;
+
+		mutable glm::mat4 LocalTransform = IDENTITY;
+		mutable glm::mat4 InverseLocalTransform = IDENTITY;
+		mutable bool      IsLocalTransformDirty = true;
+		mutable glm::mat4 WorldTransform = IDENTITY;
+		mutable glm::mat4 InverseWorldTransform = IDENTITY;
+		mutable bool      IsWorldTransformDirty = true;
+
+		void RecalcLocalTransform() const {
+			if (IsLocalTransformDirty) {
+				LocalTransform = glm::translate(IDENTITY, Position) * glm::mat4_cast(Rotation) * glm::scale(IDENTITY, Scale);
+				InverseLocalTransform = glm::inverse(LocalTransform);
+				IsLocalTransformDirty = false;
+				IsWorldTransformDirty = true;
+
+				for (const auto& childPtr : Children) {
+					std::shared_ptr<LegacyTransform> childSptr = childPtr.lock();
+					if (childSptr != nullptr) {
+						childSptr->IsWorldTransformDirty = true;
+					}
+				}
+			}
+		}
+
+		void RecalcWorldTransform() const {
+			RecalcLocalTransform();
+			if (IsWorldTransformDirty) {
+				std::shared_ptr<LegacyTransform> parent = Parent.lock();
+				if (parent != nullptr) {
+					WorldTransform = parent->GetTransform() * LocalTransform;
+					InverseWorldTransform = glm::inverse(WorldTransform);
+				} else {
+					WorldTransform = LocalTransform;
+					InverseWorldTransform = InverseLocalTransform;
+				}
+				IsWorldTransformDirty = false;
+
+				if (s_DirtyWholeSubtree) {
+					for (const auto& childPtr : Children) {
+						std::shared_ptr<LegacyTransform> childSptr = childPtr.lock();
+						if (childSptr != nullptr) {
+							childSptr->IsWorldTransformDirty = true;
+						}
+					}
+				}
+			}
+		}
+
+		const glm::mat4& GetTransform() const {
+			RecalcWorldTransform();
+			return WorldTransform;
+		}
+	};
+}
+
+// A frame of transform updates for a 100k node hierarchy where 10% of the nodes move every frame. The old
+// GameObject::Update recalculated each object's transforms in scene order, the new Scene::Update makes one
+// TransformStore::Update pass
+BENCHMARK(TransformUpdate) {
+	const uint32_t count = 100000;
+	const uint32_t rootCount = 1000;
+
+	// Every node after the roots gets a random parent from the nodes before it, which gives a shallow,
+	// bushy hierarchy like a scene full of props
+	std::mt19937 random(1234);
+	std::vector<uint32_t> parents(count, Gameplay::TransformStore::INVALID_HANDLE);
+	for (uint32_t ix = rootCount; ix < count; ix++) {
+		parents[ix] = std::uniform_int_distribution<uint32_t>(0, ix - 1)(random);
+	}
+	std::vector<uint32_t> moving;
+	for (uint32_t ix = 0; ix < count; ix++) {
+		if (std::uniform_real_distribution<float>(0.0f, 1.0f)(random) < 0.1f) {
+			moving.push_back(ix);
+		}
+	}
+
+	std::vector<std::shared_ptr<LegacyTransform>> legacy(count);
+	Gameplay::TransformStore store;
+	std::vector<uint32_t> handles(count);
+	uint32_t maxDepth = 0;
+	std::vector<uint32_t> depths(count, 0);
+	for (uint32_t ix = 0; ix < count; ix++) {
+		glm::vec3 position = glm::vec3((float)(ix % 7), (float)(ix % 5), (float)(ix % 3));
+
+		legacy[ix] = std::make_shared<LegacyTransform>();
+		legacy[ix]->Position = position;
+		handles[ix] = store.Create();
+		store.SetPosition(handles[ix], position);
+
+		if (parents[ix] != Gameplay::TransformStore::INVALID_HANDLE) {
+			legacy[ix]->Parent = legacy[parents[ix]];
+			legacy[parents[ix]]->Children.push_back(legacy[ix]);
+			store.SetParent(handles[ix], handles[parents[ix]]);
+			depths[ix] = depths[parents[ix]] + 1;
+			maxDepth = std::max(maxDepth, depths[ix]);
+		}
+	}
+	printf("  %u nodes, %u roots, %u levels, %zu moving per frame\n", count, rootCount, maxDepth + 1, moving.size());
+
+	// Every version moves the same nodes by the same amount each frame, and ends up with the same rotations
+	float angle = 0.0f;
+	Benchmark::Result result = Benchmark::Measure(20, [&]() {
+		angle += 0.01f;
+		for (uint32_t ix : moving) {
+			store.SetRotation(handles[ix], glm::quat(glm::vec3(0.0f, angle, 0.0f)));
+		}
+		store.Update();
+	});
+
+	auto runLegacy = [&]() {
+		angle = 0.0f;
+		return Benchmark::Measure(20, [&]() {
+			angle += 0.01f;
+			for (uint32_t ix : moving) {
+				legacy[ix]->Rotation = glm::quat(glm::vec3(0.0f, angle, 0.0f));
+				legacy[ix]->IsLocalTransformDirty = true;
+			}
+			for (const std::shared_ptr<LegacyTransform>& transform : legacy) {
+				transform->RecalcLocalTransform();
+				transform->RecalcWorldTransform();
+			}
+		});
+	};
+	// The number of nodes where the old version disagrees with the store
+	auto countStale = [&]() {
+		uint32_t stale = 0;
+		for (uint32_t ix = 0; ix < count; ix++) {
+			const glm::mat4& expected = store.GetWorldTransform(handles[ix]);
+			const glm::mat4& actual = legacy[ix]->WorldTransform;
+			for (int column = 0; column < 4; column++) {
+				if (glm::length(expected[column] - actual[column]) > 1e-3f) {
+					stale++;
+					break;
+				}
+			}
+		}
+		return stale;
+	};
+
+	Benchmark::Result old = runLegacy();
+	uint32_t oldStale = countStale();
+	s_DirtyWholeSubtree = true;
+	Benchmark::Result fixed = runLegacy();
+	uint32_t fixedStale = countStale();
+	s_DirtyWholeSubtree = false;
+
+	Benchmark::Report("per object matrices (old)", old);
+	printf("      %u nodes left with stale world transforms\n", oldStale);
+	Benchmark::Report("per object, whole subtrees dirtied", fixed);
+	printf("      %u nodes left with stale world transforms\n", fixedStale);
+	Benchmark::Report("TransformStore::Update", result);
+	Benchmark::Compare("speedup over old", old, result);
+	Benchmark::Compare("speedup over whole subtrees", fixed, result);
+}
@@ -0,0 +1,76 @@
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include <GLM/glm.hpp>
+#include <GLM/gtc/matrix_transform.hpp>
+
+#include "Graphics/LightClusterer.h"
+#include "Utils/JobSystem.h"
+
+#include "BenchFramework.h"
+
+// Building the light clusters for 1k, 5k and 10k point lights scattered through the view frustum, the way
+// RenderLayer::_BuildLightClusters does every frame. The lights get their radii from GetInfluenceRadius,
+// with the intensities and attenuations that Light components give. The old light pass shaded every pixel
+// with every light, so the number of lights each cluster holds is what a fragment now loops over instead
+BENCHMARK(LightClusterBuild) {
+	const float zNear = 0.1f;
+	const float zFar = 100.0f;
+	const glm::mat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, zNear, zFar);
+	uint32_t hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+
+	for (size_t count : { 1000, 5000, 10000 }) {
+		std::mt19937 random(1234);
+		std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+		std::vector<ClusterLight> lights(count);
+		for (ClusterLight& light : lights) {
+			float depth = 1.0f + unit(random) * (zFar - 1.0f);
+			light.Position = glm::vec3((unit(random) * 2.0f - 1.0f) * depth, (unit(random) * 2.0f - 1.0f) * depth * 0.6f, -depth);
+			// Light::GetRadius of 0.5 to 4 and an intensity of 0.02 to 0.1, which gives radii of about 2 to 8, same conversion as _BuildLightClusters
+			float attenuation = 1.0f / (1.0f + 0.5f + unit(random) * 3.5f);
+			light.Radius = LightClusterer::GetInfluenceRadius(0.02f + unit(random) * 0.08f, glm::vec3(1.0f), attenuation);
+		}
+
+		LightClusterer clusterer;
+		clusterer.SetProjection(projection, zNear, zFar);
+		printf("  %zu lights\n", count);
+
+		// Restart the job system with more threads each time, like SceneUpdate. With no job system running,
+		// every slice is built on the calling thread. Workers are always tried at least once, so that their
+		// overhead shows up even on a single core
+		JobSystem::Shutdown();
+		Benchmark::Result serial;
+		for (uint32_t threads = 1; threads <= std::max(hardwareThreads, 2u); threads *= 2) {
+			if (threads > 1) {
+				JobSystem::Init(threads - 1);
+			}
+
+			Benchmark::Result result = Benchmark::Measure(10, [&]() {
+				clusterer.Build(lights.data(), lights.size());
+			});
+
+			char label[64];
+			snprintf(label, sizeof(label), "build, %u thread%s%s", threads, threads > 1 ? "s" : "", threads > hardwareThreads ? " (oversubscribed)" : "");
+			Benchmark::Report(label, result);
+			if (threads == 1) {
+				serial = result;
+			} else {
+				Benchmark::Compare("speedup", serial, result);
+			}
+
+			JobSystem::Shutdown();
+		}
+		JobSystem::Init();
+
+		const std::vector<LightCluster>& clusters = clusterer.GetClusters();
+		size_t occupied = std::count_if(clusters.begin(), clusters.end(), [](const LightCluster& cluster) { return cluster.Count > 0; });
+		printf("      %zu light indices, %.1f lights per occupied cluster (%zu of %zu), at most %u\n",
+			clusterer.GetLightIndices().size(), (double)clusterer.GetLightIndices().size() / std::max<size_t>(occupied, 1),
+			occupied, clusters.size(), clusterer.GetMaxClusterLights());
+		printf("      the old light pass evaluated all %zu lights for every pixel\n", count);
+	}
+	printf("    %u hardware threads, scaling past that was not measured\n", hardwareThreads);
+}
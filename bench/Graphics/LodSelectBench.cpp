@@ -0,0 +1,94 @@
+#include <cstdio>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <GLM/glm.hpp>
+#include <GLM/gtc/matrix_transform.hpp>
+
+#include "Graphics/MeshLod.h"
+#include "Utils/MeshOptimizer.h"
+#include "Utils/MeshSimplifier.h"
+#include "Utils/ParallelObjParser.h"
+
+#include "BenchFramework.h"
+#include "Utils/ObjTestData.h"
+
+// Drawing 10k instances of each mesh in res/ spread from 2 to 200 bounding radii in front of a 1080p camera.
+// Each instance goes through the same GetProjectedRadius and SelectLevel calls as RenderComponent::GetMesh and
+// MeshResource::SelectLod, with RenderLayer's default of 1 pixel of error, and we count the triangles drawn
+// with and without the LOD chain. The levels are built the same way ConvertToBinary builds them, without the
+// GPU buffers
+BENCHMARK(LodSelect) {
+	std::vector<std::string> files = FindResObjFiles();
+	if (files.empty()) {
+		throw std::runtime_error("res/ was not found, run the benchmarks from the project directory");
+	}
+
+	const size_t instanceCount = 10000;
+	const float screenHeight = 1080.0f;
+	const float maxPixelError = 1.0f;
+	const glm::mat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 10000.0f);
+
+	for (const std::string& file : files) {
+		ParallelObjParser::Result obj;
+		ParallelObjParser::ParseFile(file, obj);
+		std::vector<uint32_t> indices = obj.Indices;
+		MeshOptimizer::OptimizeVertexCache(indices, obj.Vertices.size());
+
+		std::vector<glm::vec3> positions(obj.Vertices.size());
+		for (size_t ix = 0; ix < obj.Vertices.size(); ix++) {
+			positions[ix] = obj.Positions[obj.Vertices[ix].x];
+		}
+		AABB bounds = AABB::FromPoints(positions.data(), sizeof(glm::vec3), positions.size());
+
+		// Level 0 is the full detail mesh, like MeshResource::Lods
+		std::vector<MeshSimplifier::Lod> simplified = MeshSimplifier::GenerateLods(indices, positions.data(), sizeof(glm::vec3), positions.size());
+		std::vector<MeshLod> lods(simplified.size() + 1);
+		std::vector<size_t> triangles(simplified.size() + 1, indices.size() / 3);
+		for (size_t ix = 0; ix < simplified.size(); ix++) {
+			lods[ix + 1].Error = simplified[ix].Error;
+			triangles[ix + 1] = simplified[ix].Indices.size() / 3;
+		}
+
+		// Spread the instances through the view frustum, the same for every mesh relative to its size
+		std::mt19937 random(1234);
+		std::vector<glm::mat4> modelViews(instanceCount);
+		for (glm::mat4& modelView : modelViews) {
+			float distance = bounds.GetRadius() * std::uniform_real_distribution<float>(2.0f, 200.0f)(random);
+			float x = std::uniform_real_distribution<float>(-0.5f, 0.5f)(random) * distance;
+			float y = std::uniform_real_distribution<float>(-0.3f, 0.3f)(random) * distance;
+			float angle = std::uniform_real_distribution<float>(0.0f, 6.2832f)(random);
+			modelView = glm::rotate(glm::translate(glm::mat4(1.0f), glm::vec3(x, y, -distance)), angle, glm::vec3(0.0f, 1.0f, 0.0f));
+		}
+
+		std::vector<size_t> selected(instanceCount);
+		Benchmark::Result result = Benchmark::Measure(20, [&]() {
+			for (size_t ix = 0; ix < instanceCount; ix++) {
+				selected[ix] = MeshLod::SelectLevel(lods, MeshLod::GetProjectedRadius(bounds, modelViews[ix], projection, screenHeight), maxPixelError);
+			}
+		});
+
+		std::vector<size_t> levelCounts(lods.size(), 0);
+		size_t lodTriangles = 0;
+		for (size_t level : selected) {
+			levelCounts[level]++;
+			lodTriangles += triangles[level];
+		}
+		size_t fullTriangles = instanceCount * triangles[0];
+
+		std::string name = file.substr(file.find_last_of("/\\") + 1);
+		printf("  %s, %zu triangles, %zu LOD%s\n", name.c_str(), triangles[0], simplified.size(), simplified.size() == 1 ? "" : "s");
+		Benchmark::Report("select levels", result);
+		printf("      %.1f ns per instance\n", result.MedianMs * 1000000.0 / instanceCount);
+		for (size_t ix = 0; ix < lods.size(); ix++) {
+			printf("      level %zu: %5zu instances, %zu triangles, error %.4f\n", ix, levelCounts[ix], triangles[ix], lods[ix].Error);
+		}
+		printf("      %.1fM triangles without LODs, %.1fM with (%.1f%%)\n", fullTriangles / 1000000.0, lodTriangles / 1000000.0,
+			lodTriangles * 100.0 / fullTriangles);
+		if (simplified.empty()) {
+			printf("      the simplifier couldn't reduce this mesh enough to add a level, so it is always drawn at full detail\n");
+		}
+	}
+}
@@ -0,0 +1,230 @@
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <GLM/glm.hpp>
+
+#include "Graphics/UniformBlockPacker.h"
+
+#include "BenchFramework.h"
+
+// Material and ShaderProgram need an OpenGL context, so these stand in for them. The parameter blocks are
+// packed and the texture slots assigned with the real UniformBlockPacker, and the apply loops do the same
+// walks as Material::Apply before and after parameter blocks. Calls that would go to OpenGL are recorded
+// into a list instead, so both versions pay the same small cost per call and we can count them
+namespace {
+	// Stands in for the OpenGL calls that applying a material makes
+	struct GlCall {
+		enum Kind : uint32_t { SetUniform, BindTexture, UploadBuffer, BindBuffer } Type;
+		int         Target;
+		const void* Data;
+		size_t      Size;
+	};
+
+	struct BenchParameter {
+		std::string        Name;
+		UniformBlockMember Member;
+		// Reflected location if the parameter is set as a plain uniform
+		int                Location;
+	};
+
+	// The reflected layout of a shader with a std140 b_Material block, see UniformBlockPackerTests.cpp
+	struct BenchShader {
+		std::vector<BenchParameter> Parameters;
+		std::vector<std::string>    Samplers;
+		size_t                      BlockSize = 288;
+
+		BenchShader() {
+			auto add = [&](const char* name, ShaderDataType type, int offset, size_t arraySize, int arrayStride, int matrixStride) {
+				BenchParameter parameter;
+				parameter.Name = name;
+				parameter.Member.Type = type;
+				parameter.Member.Offset = offset;
+				parameter.Member.ArraySize = arraySize;
+				parameter.Member.ArrayStride = arrayStride;
+				parameter.Member.MatrixStride = matrixStride;
+				parameter.Location = static_cast<int>(Parameters.size());
+				Parameters.push_back(parameter);
+			};
+			add("u_Tint",        ShaderDataType::Float3, 0,   1, 0,  0);
+			add("u_Shininess",   ShaderDataType::Float,  12,  1, 0,  0);
+			add("u_UvTransform", ShaderDataType::Mat3,   16,  1, 0,  16);
+			add("u_Weights",     ShaderDataType::Float,  64,  3, 16, 0);
+			add("u_Flags",       ShaderDataType::Bool,   112, 2, 16, 0);
+			add("u_Mask",        ShaderDataType::Bool3,  144, 1, 0,  0);
+			add("u_Bones",       ShaderDataType::Mat4,   160, 2, 64, 16);
+			Samplers = { "s_Specular", "s_Albedo", "s_Normal", "s_Emissive" };
+		}
+	};
+
+	// A material's values, stored the way UniformData stores them
+	struct BenchValue {
+		ShaderDataType Type;
+		size_t         ArraySize;
+		int            Location;
+		uint8_t        Value[128];
+	};
+
+	// The original Material, with every uniform in a map by name that Apply walks
+	struct LegacyMaterial {
+		std::unordered_map<std::string, BenchValue> Values;
+		std::unordered_map<std::string, int>        Textures;
+
+		void Apply(std::vector<GlCall>& calls) const {
+			int textureSlot = 0;
+			for (const auto& [name, value] : Values) {
+				calls.push_back({ GlCall::SetUniform, value.Location, value.Value, value.ArraySize });
+			}
+			for (const auto& [name, texture] : Textures) {
+				calls.push_back({ GlCall::BindTexture, textureSlot, &texture, 1 });
+				calls.push_back({ GlCall::SetUniform, -1, &textureSlot, 1 });
+				textureSlot++;
+			}
+		}
+	};
+
+	// The current Material, with a packed parameter block and an apply table per shader
+	struct BlockMaterial {
+		struct ApplyTable {
+			std::weak_ptr<BenchShader> Shader;
+			std::vector<int>           TextureSlots;
+		};
+
+		std::vector<uint8_t>    Block;
+		bool                    Dirty = true;
+		std::vector<int>        Textures;
+		std::vector<ApplyTable> Tables;
+
+		const ApplyTable& GetApplyTable(const std::shared_ptr<BenchShader>& shader) {
+			for (const ApplyTable& table : Tables) {
+				if (!table.Shader.owner_before(shader) && !shader.owner_before(table.Shader)) {
+					return table;
+				}
+			}
+			ApplyTable table;
+			table.Shader = shader;
+			for (size_t index : UniformBlockPacker::AssignTextureSlots(shader->Samplers, 14)) {
+				table.TextureSlots.push_back(static_cast<int>(index));
+			}
+			Tables.push_back(std::move(table));
+			return Tables.back();
+		}
+
+		void Apply(const std::shared_ptr<BenchShader>& shader, std::vector<GlCall>& calls) {
+			if (Dirty) {
+				calls.push_back({ GlCall::UploadBuffer, 0, Block.data(), Block.size() });
+				Dirty = false;
+			}
+			calls.push_back({ GlCall::BindBuffer, 0, nullptr, 0 });
+
+			const ApplyTable& table = GetApplyTable(shader);
+			for (size_t slot = 0; slot < table.TextureSlots.size(); slot++) {
+				calls.push_back({ GlCall::BindTexture, static_cast<int>(slot), &Textures[table.TextureSlots[slot]], 1 });
+			}
+		}
+	};
+
+	// Fills in a value with a recognisable pattern, the contents don't matter beyond being different per material
+	void FillValue(uint8_t* value, size_t size, size_t seed) {
+		for (size_t ix = 0; ix < size; ix++) {
+			value[ix] = static_cast<uint8_t>(seed + ix);
+		}
+	}
+}
+
+// Packing parameters and applying 10k materials that share a shader with a 7 parameter std140 block and 4
+// textures. Packing covers a material's first build and changing one parameter, and applying is timed
+// with the apply tables already built, and again when each material has to build its table first
+BENCHMARK(MaterialApply) {
+	const size_t count = 10000;
+	std::shared_ptr<BenchShader> shader = std::make_shared<BenchShader>();
+
+	// Every parameter's value for every material, as the materials store them
+	std::vector<std::vector<BenchValue>> values(count);
+	for (size_t material = 0; material < count; material++) {
+		for (const BenchParameter& parameter : shader->Parameters) {
+			BenchValue value;
+			value.Type = parameter.Member.Type;
+			value.ArraySize = parameter.Member.ArraySize;
+			value.Location = parameter.Location;
+			FillValue(value.Value, sizeof(value.Value), material);
+			values[material].push_back(value);
+		}
+	}
+
+	std::vector<LegacyMaterial> legacy(count);
+	std::vector<BlockMaterial> blocks(count);
+	for (size_t material = 0; material < count; material++) {
+		for (size_t ix = 0; ix < shader->Parameters.size(); ix++) {
+			legacy[material].Values[shader->Parameters[ix].Name] = values[material][ix];
+		}
+		for (size_t ix = 0; ix < shader->Samplers.size(); ix++) {
+			legacy[material].Textures[shader->Samplers[ix]] = static_cast<int>(material * 4 + ix);
+			blocks[material].Textures.push_back(static_cast<int>(material * 4 + ix));
+		}
+		blocks[material].Block.resize(shader->BlockSize);
+	}
+
+	printf("  %zu materials, %zu parameters and %zu textures each\n", count, shader->Parameters.size(), shader->Samplers.size());
+
+	Benchmark::Result packAll = Benchmark::Measure(10, [&]() {
+		for (size_t material = 0; material < count; material++) {
+			BlockMaterial& target = blocks[material];
+			for (size_t ix = 0; ix < shader->Parameters.size(); ix++) {
+				UniformBlockPacker::Write(shader->Parameters[ix].Member, values[material][ix].Value, target.Block.data(), target.Block.size());
+			}
+			target.Dirty = true;
+		}
+	});
+	Benchmark::Result packOne = Benchmark::Measure(10, [&]() {
+		for (size_t material = 0; material < count; material++) {
+			BlockMaterial& target = blocks[material];
+			UniformBlockPacker::Write(shader->Parameters[2].Member, values[material][2].Value, target.Block.data(), target.Block.size());
+			target.Dirty = true;
+		}
+	});
+	Benchmark::Report("pack every parameter", packAll);
+	printf("      %.1f ns per material\n", packAll.MedianMs * 1000000.0 / count);
+	Benchmark::Report("pack one mat3 parameter (Set)", packOne);
+	printf("      %.1f ns per material\n", packOne.MedianMs * 1000000.0 / count);
+
+	std::vector<GlCall> calls;
+	calls.reserve(count * 16);
+	size_t legacyCalls = 0;
+	size_t blockCalls = 0;
+	Benchmark::Result legacyApply = Benchmark::Measure(10, [&]() {
+		calls.clear();
+		for (const LegacyMaterial& material : legacy) {
+			material.Apply(calls);
+		}
+		legacyCalls = calls.size();
+	});
+
+	// The first time each material is applied it builds its table, and uploads its block
+	Benchmark::Result firstApply = Benchmark::Measure(10, [&]() {
+		calls.clear();
+		for (BlockMaterial& material : blocks) {
+			material.Tables.clear();
+			material.Dirty = true;
+			material.Apply(shader, calls);
+		}
+	});
+	Benchmark::Result blockApply = Benchmark::Measure(10, [&]() {
+		calls.clear();
+		for (BlockMaterial& material : blocks) {
+			material.Apply(shader, calls);
+		}
+		blockCalls = calls.size();
+	});
+
+	Benchmark::Report("apply, uniforms one by one (original)", legacyApply);
+	printf("      %.1f ns and %.1f calls per material\n", legacyApply.MedianMs * 1000000.0 / count, (double)legacyCalls / count);
+	Benchmark::Report("apply, building tables and uploading", firstApply);
+	printf("      %.1f ns per material\n", firstApply.MedianMs * 1000000.0 / count);
+	Benchmark::Report("apply, parameter block", blockApply);
+	printf("      %.1f ns and %.1f calls per material\n", blockApply.MedianMs * 1000000.0 / count, (double)blockCalls / count);
+	Benchmark::Compare("speedup over one by one", legacyApply, blockApply);
+}
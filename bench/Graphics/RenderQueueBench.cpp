@@ -0,0 +1,132 @@
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include "Graphics/RenderQueue.h"
+
+#include "BenchFramework.h"
+
+namespace {
+	// The parts of a draw that RenderLayer::_RenderScene sorts and batches by. The pointers are only
+	// compared, so they point into arrays of placeholder bytes rather than real shaders, materials and meshes
+	struct BenchDraw {
+		const void* Shader;
+		const void* Material;
+		const void* Mesh;
+		float       Depth;
+		bool        Transparent;
+	};
+
+	// Gives each unique pointer a small ID to sort by, the same as _RenderScene's getSortId
+	uint32_t GetSortId(std::unordered_map<const void*, uint32_t>& ids, const void* ptr) {
+		return ids.emplace(ptr, static_cast<uint32_t>(ids.size())).first->second;
+	}
+}
+
+// Building keys for, sorting, and finding the batches in a frame's worth of draws, the way
+// RenderLayer::_RenderScene does. The scene has 16 shaders, 256 materials and 128 meshes in scene order,
+// with a quarter of the materials transparent. The radix sort is compared with std::stable_sort on the
+// same keys, which is what the queue would use otherwise, since transparent draws need a stable order
+BENCHMARK(RenderQueueSort) {
+	const uint32_t shaderCount = 16;
+	const uint32_t materialCount = 256;
+	const uint32_t meshCount = 128;
+	static const uint8_t shaders[shaderCount] = {};
+	static const uint8_t materials[materialCount] = {};
+	static const uint8_t meshes[meshCount] = {};
+
+	for (size_t count : { 10000, 100000, 1000000 }) {
+		std::mt19937 random(1234);
+		std::vector<BenchDraw> draws(count);
+		for (BenchDraw& draw : draws) {
+			uint32_t material = std::uniform_int_distribution<uint32_t>(0, materialCount - 1)(random);
+			draw.Material = &materials[material];
+			draw.Shader = &shaders[material % shaderCount];
+			draw.Mesh = &meshes[std::uniform_int_distribution<uint32_t>(0, meshCount - 1)(random)];
+			draw.Depth = std::uniform_real_distribution<float>(0.1f, 500.0f)(random);
+			draw.Transparent = material % 4 == 0;
+		}
+		printf("  %zu draws\n", count);
+
+		RenderQueue queue;
+		std::unordered_map<const void*, uint32_t> shaderIds;
+		std::unordered_map<const void*, uint32_t> materialIds;
+		std::unordered_map<const void*, uint32_t> meshIds;
+		auto buildKeys = [&]() {
+			shaderIds.clear();
+			materialIds.clear();
+			meshIds.clear();
+			queue.Clear();
+			queue.Reserve(count);
+			for (size_t ix = 0; ix < count; ix++) {
+				const BenchDraw& draw = draws[ix];
+				queue.Push(RenderQueue::MakeKey(
+					draw.Transparent ? RenderBucket::Transparent : RenderBucket::Opaque,
+					GetSortId(shaderIds, draw.Shader),
+					GetSortId(materialIds, draw.Material),
+					GetSortId(meshIds, draw.Mesh),
+					draw.Depth
+				), static_cast<uint32_t>(ix));
+			}
+		};
+
+		Benchmark::Result build = Benchmark::Measure(10, buildKeys);
+		Benchmark::Report("build keys", build);
+
+		// Both sorts start from the same unsorted items every run, copying them back is timed for both
+		const std::vector<RenderQueue::Item> unsorted = queue.GetItems();
+		std::vector<RenderQueue::Item> items;
+		Benchmark::Result stable = Benchmark::Measure(10, [&]() {
+			items = unsorted;
+			std::stable_sort(items.begin(), items.end(), [](const RenderQueue::Item& a, const RenderQueue::Item& b) {
+				return a.Key < b.Key;
+			});
+		});
+		Benchmark::Report("std::stable_sort", stable);
+
+		Benchmark::Result radix = Benchmark::Measure(10, [&]() {
+			queue.Clear();
+			for (const RenderQueue::Item& item : unsorted) {
+				queue.Push(item.Key, item.Payload);
+			}
+			queue.Sort();
+		});
+		Benchmark::Report("RenderQueue::Sort", radix);
+		Benchmark::Compare("radix sort speedup", stable, radix);
+
+		const std::vector<RenderQueue::Item>& sorted = queue.GetItems();
+		size_t mismatches = 0;
+		for (size_t ix = 0; ix < count; ix++) {
+			mismatches += (sorted[ix].Key != items[ix].Key || sorted[ix].Payload != items[ix].Payload) ? 1 : 0;
+		}
+		printf("      %zu items differ from std::stable_sort\n", mismatches);
+
+		// Walking the sorted queue in runs that share a mesh and material, like the submit loop
+		size_t runs = 0;
+		Benchmark::Result walk = Benchmark::Measure(10, [&]() {
+			runs = 0;
+			for (size_t ix = 0; ix < sorted.size();) {
+				const BenchDraw& draw = draws[sorted[ix].Payload];
+				ix = queue.GetRunEnd(ix, [&](const RenderQueue::Item&, const RenderQueue::Item& next) {
+					const BenchDraw& nextDraw = draws[next.Payload];
+					return nextDraw.Mesh == draw.Mesh && nextDraw.Material == draw.Material;
+				});
+				runs++;
+			}
+		});
+		Benchmark::Report("GetRunEnd over the queue", walk);
+
+		// How many times the material would change when submitting in scene order, and in sorted order
+		size_t sceneChanges = 0;
+		size_t sortedChanges = 0;
+		for (size_t ix = 1; ix < count; ix++) {
+			sceneChanges += draws[ix].Material != draws[ix - 1].Material ? 1 : 0;
+			sortedChanges += draws[sorted[ix].Payload].Material != draws[sorted[ix - 1].Payload].Material ? 1 : 0;
+		}
+		printf("      %zu runs, %.1f draws per run\n", runs, (double)count / runs);
+		printf("      %zu material changes in scene order, %zu sorted\n", sceneChanges, sortedChanges);
+		printf("      total %.2f ms per frame\n", build.MedianMs + radix.MedianMs + walk.MedianMs);
+	}
+}
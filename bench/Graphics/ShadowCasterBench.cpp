@@ -0,0 +1,120 @@
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include <GLM/glm.hpp>
+
+#include "Graphics/ShadowCasterTracker.h"
+
+#include "BenchFramework.h"
+
+// A synthetic scene of 2000 shadow casters and 8 shadowed lights, run for 600 frames (10 seconds at 60 FPS).
+// 100 casters move every frame (characters, physics), 20 more move for a frame once every 150 frames (doors,
+// props getting bumped), and one light moves for frames 200 to 260. Each light only sees the casters within
+// its range, like the frustum culling in _RenderScene. We count the casters each light draws per frame the
+// way _RenderShadowMaps does: with the static cache off every visible caster is drawn every frame, with it on
+// the static casters are only re-drawn when the light's cache goes stale, and the dynamic casters every frame
+BENCHMARK(ShadowCasterDraws) {
+	const size_t casterCount = 2000;
+	const size_t alwaysMovingCount = 100;
+	const size_t sometimesMovingCount = 20;
+	const uint32_t sometimesMovingPeriod = 150;
+	const size_t lightCount = 8;
+	const float lightRange = 25.0f;
+	const uint32_t frameCount = 600;
+	const size_t movingLight = 3;
+	const uint32_t lightMoveStart = 200;
+	const uint32_t lightMoveEnd = 260;
+
+	std::mt19937 random(1234);
+	std::uniform_real_distribution<float> position(0.0f, 100.0f);
+	std::vector<glm::vec3> casters(casterCount);
+	for (glm::vec3& caster : casters) {
+		caster = glm::vec3(position(random), 0.0f, position(random));
+	}
+	std::vector<glm::vec3> lights(lightCount);
+	for (glm::vec3& light : lights) {
+		light = glm::vec3(position(random), 10.0f, position(random));
+	}
+
+	// Which casters each light can see, the moving casters only move a little so this doesn't change
+	std::vector<std::vector<uint32_t>> visible(lightCount);
+	for (size_t lightIx = 0; lightIx < lightCount; lightIx++) {
+		for (uint32_t casterIx = 0; casterIx < casterCount; casterIx++) {
+			glm::vec3 offset = casters[casterIx] - lights[lightIx];
+			if (offset.x * offset.x + offset.z * offset.z <= lightRange * lightRange) {
+				visible[lightIx].push_back(casterIx);
+			}
+		}
+	}
+
+	// Runs every frame of the scene, counting the draws for each light with the cache off and on
+	std::vector<uint32_t> transformVersions(casterCount);
+	std::vector<uint8_t> isStatic(casterCount);
+	std::vector<uint64_t> drawsUncached(lightCount);
+	std::vector<uint64_t> drawsCached(lightCount);
+	std::vector<uint32_t> rebuilds(lightCount);
+	auto runScene = [&]() {
+		ShadowCasterTracker tracker;
+		std::fill(transformVersions.begin(), transformVersions.end(), 0);
+		std::fill(drawsUncached.begin(), drawsUncached.end(), 0);
+		std::fill(drawsCached.begin(), drawsCached.end(), 0);
+		std::fill(rebuilds.begin(), rebuilds.end(), 0);
+		// The static version that each light's cache was built with, nothing is cached at the start
+		std::vector<uint64_t> cacheVersions(lightCount, ~0ull);
+
+		for (uint32_t frame = 0; frame < frameCount; frame++) {
+			for (size_t ix = 0; ix < alwaysMovingCount; ix++) {
+				transformVersions[ix]++;
+			}
+			for (size_t ix = 0; ix < sometimesMovingCount; ix++) {
+				if ((frame + ix * 7) % sometimesMovingPeriod == 0) {
+					transformVersions[alwaysMovingCount + ix]++;
+				}
+			}
+
+			tracker.BeginFrame();
+			for (uint32_t ix = 0; ix < casterCount; ix++) {
+				isStatic[ix] = tracker.Track(&casters[ix], transformVersions[ix]) ? 1 : 0;
+			}
+			tracker.EndFrame();
+
+			for (size_t lightIx = 0; lightIx < lightCount; lightIx++) {
+				uint32_t staticVisible = 0;
+				for (uint32_t casterIx : visible[lightIx]) {
+					staticVisible += isStatic[casterIx];
+				}
+				uint32_t dynamicVisible = static_cast<uint32_t>(visible[lightIx].size()) - staticVisible;
+
+				bool lightMoved = lightIx == movingLight && frame >= lightMoveStart && frame < lightMoveEnd;
+				if (lightMoved || cacheVersions[lightIx] != tracker.GetStaticVersion()) {
+					drawsCached[lightIx] += staticVisible;
+					cacheVersions[lightIx] = tracker.GetStaticVersion();
+					rebuilds[lightIx]++;
+				}
+				drawsCached[lightIx] += dynamicVisible;
+				drawsUncached[lightIx] += visible[lightIx].size();
+			}
+		}
+	};
+
+	Benchmark::Result result = Benchmark::Measure(10, runScene);
+	Benchmark::Report("track casters, all frames", result);
+	printf("      %.3f ms per frame for %zu casters\n", result.MedianMs / frameCount, casterCount);
+
+	printf("    %-8s %8s %14s %14s %10s %8s\n", "light", "visible", "draws/frame", "draws/frame", "rebuilds", "saved");
+	printf("    %-8s %8s %14s %14s %10s %8s\n", "", "", "cache off", "cache on", "", "");
+	uint64_t totalUncached = 0;
+	uint64_t totalCached = 0;
+	for (size_t lightIx = 0; lightIx < lightCount; lightIx++) {
+		totalUncached += drawsUncached[lightIx];
+		totalCached += drawsCached[lightIx];
+		printf("    %-8zu %8zu %14.1f %14.1f %10u %7.1f%%%s\n", lightIx, visible[lightIx].size(),
+			(double)drawsUncached[lightIx] / frameCount, (double)drawsCached[lightIx] / frameCount, rebuilds[lightIx],
+			drawsUncached[lightIx] > 0 ? 100.0 * (1.0 - (double)drawsCached[lightIx] / drawsUncached[lightIx]) : 0.0,
+			lightIx == movingLight ? " (moves)" : "");
+	}
+	printf("    %-8s %8s %14.1f %14.1f %10s %7.1f%%\n", "all", "",
+		(double)totalUncached / frameCount, (double)totalCached / frameCount, "",
+		100.0 * (1.0 - (double)totalCached / totalUncached));
+}
@@ -0,0 +1,131 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "Utils/FileHelpers.h"
+#include "Utils/ParallelObjParser.h"
+#include "Utils/ResourceManager/ResourceManager.h"
+
+#include "BenchFramework.h"
+#include "Utils/ObjTestData.h"
+
+// MeshResource needs an OpenGL context to finish loading, so this stands in for it. Decode does the same
+// OBJ parsing that MeshResource does off the main thread, and FromDecoded keeps the parsed mesh in place of
+// uploading it
+class BenchMeshResource : public IResource {
+public:
+	MAKE_PTRS(BenchMeshResource);
+
+	std::shared_ptr<ParallelObjParser::Result> Mesh;
+
+	static std::shared_ptr<ParallelObjParser::Result> Decode(const nlohmann::json& data) {
+		std::shared_ptr<ParallelObjParser::Result> result = std::make_shared<ParallelObjParser::Result>();
+		ParallelObjParser::ParseFile(data["filename"].get<std::string>(), *result);
+		return result;
+	}
+
+	static BenchMeshResource::Sptr FromDecoded(const nlohmann::json& data, const std::shared_ptr<ParallelObjParser::Result>& decoded) {
+		BenchMeshResource::Sptr result = std::make_shared<BenchMeshResource>();
+		result->Mesh = decoded;
+		return result;
+	}
+
+	static BenchMeshResource::Sptr FromJson(const nlohmann::json& data) {
+		return FromDecoded(data, Decode(data));
+	}
+
+	nlohmann::json ToJson() const override {
+		return {};
+	}
+};
+
+// Startup with a manifest of 48 meshes, where the first scene only references 8 of them. The old startup
+// loaded every asset on the main thread before the first frame, the new one queues them all with
+// LoadManifest(path, true), finishes the ones the scene needs, and streams the rest in with ProcessUploads
+BENCHMARK(AssetLoad) {
+	using Clock = std::chrono::steady_clock;
+	const uint32_t assetCount = 48;
+	const uint32_t sceneAssetCount = 8;
+
+	std::filesystem::path folder = std::filesystem::temp_directory_path() / "asset-load-bench";
+	std::filesystem::create_directories(folder);
+	std::string text = MakeGridObj(96);
+
+	std::vector<Guid> ids;
+	nlohmann::json items = nlohmann::json::object();
+	for (uint32_t ix = 0; ix < assetCount; ix++) {
+		std::string filename = (folder / ("mesh" + std::to_string(ix) + ".obj")).string();
+		std::ofstream(filename, std::ios::binary) << text;
+
+		Guid id = Guid::New();
+		items[id.str()] = { { "guid", id.str() }, { "filename", filename } };
+		ids.push_back(id);
+	}
+	nlohmann::json manifest;
+	manifest[StringTools::SanitizeClassName(typeid(BenchMeshResource).name())] = items;
+	std::string manifestPath = (folder / "manifest.json").string();
+	FileHelpers::WriteContentsToFile(manifestPath, manifest.dump());
+	printf("  %u meshes of %.1f MB, %u used by the first scene\n", assetCount, text.size() / (1024.0 * 1024.0), sceneAssetCount);
+
+	auto reset = [&]() {
+		ResourceManager::Cleanup();
+		ResourceManager::RegisterType<BenchMeshResource>();
+	};
+
+	Benchmark::Result old = Benchmark::Measure(5, [&]() {
+		reset();
+		ResourceManager::LoadManifest(manifestPath);
+		for (const Guid& id : ids) {
+			Benchmark::DoNotOptimize(ResourceManager::Get<BenchMeshResource>(id));
+		}
+	});
+	Benchmark::Report("everything on the main thread (old)", old);
+
+	// The time to the first frame, and to every asset being loaded with a 4 ms upload budget per frame. No
+	// frame work is simulated, so the second number is the best case for streaming the remaining assets.
+	// Both are timed from the same runs, so this doesn't use Measure
+	std::vector<double> firstFrameTimes;
+	std::vector<double> loadedTimes;
+	uint32_t frames = 0;
+	for (uint32_t run = 0; run <= 5; run++) {
+		reset();
+		Clock::time_point start = Clock::now();
+		ResourceManager::LoadManifest(manifestPath, true);
+		for (uint32_t ix = 0; ix < sceneAssetCount; ix++) {
+			Benchmark::DoNotOptimize(ResourceManager::Get<BenchMeshResource>(ids[ix]));
+		}
+		double firstFrameMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+		frames = 0;
+		while (ResourceManager::GetPendingLoadCount() > 0) {
+			ResourceManager::ProcessUploads(4.0f);
+			frames++;
+		}
+		double loadedMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+		// The first run is a warmup, like in Measure
+		if (run > 0) {
+			firstFrameTimes.push_back(firstFrameMs);
+			loadedTimes.push_back(loadedMs);
+		}
+	}
+	auto toResult = [](std::vector<double>& times) {
+		std::sort(times.begin(), times.end());
+		return Benchmark::Result{ times[times.size() / 2], times.front() };
+	};
+	Benchmark::Result firstFrame = toResult(firstFrameTimes);
+	Benchmark::Result loaded = toResult(loadedTimes);
+
+	Benchmark::Report("background decode, first frame", firstFrame);
+	Benchmark::Report("background decode, everything loaded", loaded);
+	printf("    %u frames to load the assets the scene didn't need\n", frames);
+	Benchmark::Compare("time to first frame", old, firstFrame);
+	Benchmark::Compare("time to everything loaded", old, loaded);
+
+	ResourceManager::Cleanup();
+	std::filesystem::remove_all(folder);
+}
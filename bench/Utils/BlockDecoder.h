@@ -0,0 +1,210 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Utils/TextureCompressor.h"
+
+/// <summary>
+/// A reference decoder for the block compressed formats that TextureCompressor writes, written from the
+/// format specifications rather than from the encoder, so that the benchmarks can measure the encoder's
+/// quality without a GPU. Only BC7 modes 5 and 6 are supported, since those are the only modes the
+/// encoder uses
+/// </summary>
+namespace BlockDecoder {
+	namespace detail {
+		inline void Decode565(uint16_t value, uint8_t* rgb) {
+			uint8_t r = (value >> 11) & 31;
+			uint8_t g = (value >> 5) & 63;
+			uint8_t b = value & 31;
+			rgb[0] = (r << 3) | (r >> 2);
+			rgb[1] = (g << 2) | (g >> 4);
+			rgb[2] = (b << 3) | (b >> 2);
+		}
+
+		// BC1 color block, writing RGBA. BC3 always uses the 4 color mode for its color block
+		inline void DecodeColorBlock(const uint8_t* block, bool forceFourColors, uint8_t* pixels) {
+			uint16_t c0 = block[0] | (block[1] << 8);
+			uint16_t c1 = block[2] | (block[3] << 8);
+			uint8_t palette[4][4] = {};
+			Decode565(c0, palette[0]);
+			Decode565(c1, palette[1]);
+			palette[0][3] = palette[1][3] = palette[2][3] = 255;
+			if (c0 > c1 || forceFourColors) {
+				palette[3][3] = 255;
+				for (int ix = 0; ix < 3; ix++) {
+					palette[2][ix] = (2 * palette[0][ix] + palette[1][ix]) / 3;
+					palette[3][ix] = (palette[0][ix] + 2 * palette[1][ix]) / 3;
+				}
+			} else {
+				// The fourth entry is transparent black
+				for (int ix = 0; ix < 3; ix++) {
+					palette[2][ix] = (palette[0][ix] + palette[1][ix]) / 2;
+				}
+			}
+
+			uint32_t indices = block[4] | (block[5] << 8) | (block[6] << 16) | ((uint32_t)block[7] << 24);
+			for (int ix = 0; ix < 16; ix++) {
+				memcpy(pixels + ix * 4, palette[(indices >> (ix * 2)) & 3], 4);
+			}
+		}
+
+		// BC4 block, writing one channel of RGBA pixels
+		inline void DecodeSingleChannelBlock(const uint8_t* block, int channel, uint8_t* pixels) {
+			uint8_t e0 = block[0];
+			uint8_t e1 = block[1];
+			uint8_t palette[8] = { e0, e1 };
+			if (e0 > e1) {
+				for (int ix = 1; ix < 7; ix++) {
+					palette[ix + 1] = ((7 - ix) * e0 + ix * e1) / 7;
+				}
+			} else {
+				for (int ix = 1; ix < 5; ix++) {
+					palette[ix + 1] = ((5 - ix) * e0 + ix * e1) / 5;
+				}
+				palette[6] = 0;
+				palette[7] = 255;
+			}
+
+			uint64_t indices = 0;
+			for (int ix = 0; ix < 6; ix++) {
+				indices |= (uint64_t)block[2 + ix] << (ix * 8);
+			}
+			for (int ix = 0; ix < 16; ix++) {
+				pixels[ix * 4 + channel] = palette[(indices >> (ix * 3)) & 7];
+			}
+		}
+
+		// Reads bits from a 128 bit block, least significant bit first
+		class BitReader {
+		public:
+			explicit BitReader(const uint8_t* block) : _block(block), _position(0) { }
+
+			uint32_t Read(int count) {
+				uint32_t result = 0;
+				for (int ix = 0; ix < count; ix++, _position++) {
+					result |= ((_block[_position / 8] >> (_position % 8)) & 1) << ix;
+				}
+				return result;
+			}
+
+		private:
+			const uint8_t* _block;
+			int            _position;
+		};
+
+		inline uint8_t Interpolate(uint8_t e0, uint8_t e1, uint32_t weight) {
+			return static_cast<uint8_t>(((64 - weight) * e0 + weight * e1 + 32) >> 6);
+		}
+
+		inline void DecodeBC7Block(const uint8_t* block, uint8_t* pixels) {
+			static const uint32_t weights2[4] = { 0, 21, 43, 64 };
+			static const uint32_t weights4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+			BitReader bits(block);
+			int mode = 0;
+			while (mode < 8 && bits.Read(1) == 0) {
+				mode++;
+			}
+
+			if (mode == 6) {
+				uint8_t endpoints[2][4];
+				for (int channel = 0; channel < 4; channel++) {
+					endpoints[0][channel] = static_cast<uint8_t>(bits.Read(7) << 1);
+					endpoints[1][channel] = static_cast<uint8_t>(bits.Read(7) << 1);
+				}
+				uint32_t p0 = bits.Read(1);
+				uint32_t p1 = bits.Read(1);
+				for (int channel = 0; channel < 4; channel++) {
+					endpoints[0][channel] |= p0;
+					endpoints[1][channel] |= p1;
+				}
+				for (int ix = 0; ix < 16; ix++) {
+					uint32_t index = bits.Read(ix == 0 ? 3 : 4);
+					for (int channel = 0; channel < 4; channel++) {
+						pixels[ix * 4 + channel] = Interpolate(endpoints[0][channel], endpoints[1][channel], weights4[index]);
+					}
+				}
+			}
+			else if (mode == 5) {
+				uint32_t rotation = bits.Read(2);
+				uint8_t endpoints[2][4];
+				for (int channel = 0; channel < 3; channel++) {
+					for (int ix = 0; ix < 2; ix++) {
+						uint8_t value = static_cast<uint8_t>(bits.Read(7));
+						endpoints[ix][channel] = (value << 1) | (value >> 6);
+					}
+				}
+				endpoints[0][3] = static_cast<uint8_t>(bits.Read(8));
+				endpoints[1][3] = static_cast<uint8_t>(bits.Read(8));
+
+				uint32_t colorIndices[16];
+				for (int ix = 0; ix < 16; ix++) {
+					colorIndices[ix] = bits.Read(ix == 0 ? 1 : 2);
+				}
+				for (int ix = 0; ix < 16; ix++) {
+					uint32_t alphaIndex = bits.Read(ix == 0 ? 1 : 2);
+					uint8_t* pixel = pixels + ix * 4;
+					for (int channel = 0; channel < 3; channel++) {
+						pixel[channel] = Interpolate(endpoints[0][channel], endpoints[1][channel], weights2[colorIndices[ix]]);
+					}
+					pixel[3] = Interpolate(endpoints[0][3], endpoints[1][3], weights2[alphaIndex]);
+					if (rotation != 0) {
+						std::swap(pixel[3], pixel[rotation - 1]);
+					}
+				}
+			}
+			else {
+				throw std::runtime_error("BC7 mode " + std::to_string(mode) + " is not supported by the reference decoder");
+			}
+		}
+	}
+
+	/// <summary>
+	/// Decodes a compressed image back to tightly packed RGBA8 pixels. Channels that the format doesn't
+	/// store are left at 0, with alpha at 255
+	/// </summary>
+	inline std::vector<uint8_t> Decode(const uint8_t* data, uint32_t width, uint32_t height, BlockCompression format) {
+		std::vector<uint8_t> result((size_t)width * height * 4, 0);
+		const size_t blockSize = TextureCompressor::GetBlockSize(format);
+		const uint32_t blocksWide = (width + 3) / 4;
+		const uint32_t blocksTall = (height + 3) / 4;
+
+		uint8_t pixels[16 * 4];
+		for (uint32_t by = 0; by < blocksTall; by++) {
+			for (uint32_t bx = 0; bx < blocksWide; bx++) {
+				const uint8_t* block = data + ((size_t)by * blocksWide + bx) * blockSize;
+				memset(pixels, 0, sizeof(pixels));
+				for (int ix = 0; ix < 16; ix++) {
+					pixels[ix * 4 + 3] = 255;
+				}
+
+				switch (format) {
+					case BlockCompression::BC1: detail::DecodeColorBlock(block, false, pixels); break;
+					case BlockCompression::BC3:
+						detail::DecodeColorBlock(block + 8, true, pixels);
+						detail::DecodeSingleChannelBlock(block, 3, pixels);
+						break;
+					case BlockCompression::BC4: detail::DecodeSingleChannelBlock(block, 0, pixels); break;
+					case BlockCompression::BC5:
+						detail::DecodeSingleChannelBlock(block, 0, pixels);
+						detail::DecodeSingleChannelBlock(block + 8, 1, pixels);
+						break;
+					case BlockCompression::BC7: detail::DecodeBC7Block(block, pixels); break;
+					default: throw std::runtime_error("Unsupported format");
+				}
+
+				// Blocks that hang off the edge of the image only have some of their pixels kept
+				for (uint32_t y = 0; y < 4 && by * 4 + y < height; y++) {
+					for (uint32_t x = 0; x < 4 && bx * 4 + x < width; x++) {
+						memcpy(&result[(((size_t)by * 4 + y) * width + bx * 4 + x) * 4], pixels + (y * 4 + x) * 4, 4);
+					}
+				}
+			}
+		}
+		return result;
+	}
+}
@@ -0,0 +1,51 @@
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "Utils/MeshOptimizer.h"
+#include "Utils/MeshSimplifier.h"
+#include "Utils/ParallelObjParser.h"
+
+#include "BenchFramework.h"
+#include "Utils/ObjTestData.h"
+
+// The cost of building a LOD chain when a mesh is converted to its binary cache, compared to the rest of
+// the conversion (parsing and optimizing), and how many triangles each level saves
+BENCHMARK(LodBuild) {
+	for (uint32_t size : { 64u, 256u }) {
+		std::string text = MakeGridObj(size);
+		ParallelObjParser::Result obj;
+		ParallelObjParser::Parse(text.data(), text.size(), obj, 1);
+		printf("  %u x %u grid, %zu triangles\n", size, size, obj.Indices.size() / 3);
+
+		// Converting without LODs, like ConvertToBinary with generateLods off
+		std::vector<uint32_t> optimized;
+		Benchmark::Result convert = Benchmark::Measure(5, [&]() {
+			ParallelObjParser::Parse(text.data(), text.size(), obj, 1);
+			optimized = obj.Indices;
+			MeshOptimizer::OptimizeVertexCache(optimized, obj.Vertices.size());
+		});
+		Benchmark::Report("parse and optimize", convert);
+
+		std::vector<glm::vec3> positions(obj.Vertices.size());
+		for (size_t ix = 0; ix < obj.Vertices.size(); ix++) {
+			positions[ix] = obj.Positions[obj.Vertices[ix].x];
+		}
+
+		// The extra work ConvertToBinary does with generateLods on
+		std::vector<MeshSimplifier::Lod> lods;
+		Benchmark::Result build = Benchmark::Measure(5, [&]() {
+			lods = MeshSimplifier::GenerateLods(optimized, positions.data(), sizeof(glm::vec3), positions.size());
+			for (MeshSimplifier::Lod& lod : lods) {
+				MeshOptimizer::OptimizeVertexCache(lod.Indices, positions.size());
+			}
+		});
+		Benchmark::Report("generate and optimize LODs", build);
+		printf("    LODs add %.0f%% to the conversion time\n", build.MedianMs / convert.MedianMs * 100.0);
+
+		for (size_t ix = 0; ix < lods.size(); ix++) {
+			printf("    LOD %zu: %zu triangles (%.1f%%), error %.4f\n", ix + 1, lods[ix].Indices.size() / 3,
+				lods[ix].Indices.size() * 100.0 / optimized.size(), lods[ix].Error);
+		}
+	}
+}
@@ -0,0 +1,106 @@
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "Utils/ParallelObjParser.h"
+
+#include "BenchFramework.h"
+#include "Utils/ObjTestData.h"
+
+namespace {
+	template <typename T>
+	bool BytesEqual(const std::vector<T>& a, const std::vector<T>& b) {
+		return a.size() == b.size() && (a.empty() || memcmp(a.data(), b.data(), a.size() * sizeof(T)) == 0);
+	}
+
+	bool SameResult(const ParallelObjParser::Result& a, const ParallelObjParser::Result& b) {
+		return BytesEqual(a.Positions, b.Positions) && BytesEqual(a.UVs, b.UVs) && BytesEqual(a.Normals, b.Normals) &&
+			BytesEqual(a.Vertices, b.Vertices) && BytesEqual(a.Indices, b.Indices);
+	}
+}
+
+// Parsing an OBJ file from disk with the old iostream loader vs ParallelObjParser, for a mesh around the
+// size of the larger models in res/ and for one much larger than that
+BENCHMARK(ObjParse) {
+	for (uint32_t size : { 128u, 512u }) {
+		std::string path = (std::filesystem::temp_directory_path() / "obj-parse-bench.obj").string();
+		std::string text = MakeGridObj(size);
+		std::ofstream(path, std::ios::binary) << text;
+		printf("  %u x %u grid, %.1f MB\n", size, size, text.size() / (1024.0 * 1024.0));
+
+		ParallelObjParser::Result result;
+		Benchmark::Result legacy = Benchmark::Measure(5, [&]() {
+			std::ifstream file(path, std::ios::binary);
+			LegacyParseObj(file, result);
+		});
+		Benchmark::Report("iostream loader", legacy);
+
+		Benchmark::Result single = Benchmark::Measure(5, [&]() {
+			ParallelObjParser::ParseFile(path, result, 1);
+		});
+		Benchmark::Report("ParallelObjParser, 1 thread", single);
+
+		Benchmark::Result parallel = Benchmark::Measure(5, [&]() {
+			ParallelObjParser::ParseFile(path, result);
+		});
+		Benchmark::Report("ParallelObjParser, all threads", parallel);
+
+		Benchmark::Compare("speedup, 1 thread", legacy, single);
+		Benchmark::Compare("speedup, all threads", legacy, parallel);
+		std::filesystem::remove(path);
+	}
+}
+
+// The same comparison for every mesh that ships in res/, which is what the game actually loads
+BENCHMARK(ObjParseResMeshes) {
+	std::vector<std::string> files = FindResObjFiles();
+	if (files.empty()) {
+		throw std::runtime_error("res/ has no OBJ files, run the benchmarks from the project directory");
+	}
+
+	Benchmark::Result legacyTotal, singleTotal, parallelTotal;
+	for (const std::string& path : files) {
+		printf("  %s, %.1f KB\n", path.c_str(), std::filesystem::file_size(path) / 1024.0);
+
+		ParallelObjParser::Result legacyResult, result;
+		Benchmark::Result legacy = Benchmark::Measure(9, [&]() {
+			std::ifstream file(path, std::ios::binary);
+			LegacyParseObj(file, legacyResult);
+		});
+		Benchmark::Report("iostream loader", legacy);
+
+		Benchmark::Result single = Benchmark::Measure(9, [&]() {
+			ParallelObjParser::ParseFile(path, result, 1);
+		});
+		Benchmark::Report("ParallelObjParser, 1 thread", single);
+
+		Benchmark::Result parallel = Benchmark::Measure(9, [&]() {
+			ParallelObjParser::ParseFile(path, result);
+		});
+		Benchmark::Report("ParallelObjParser, all threads", parallel);
+		Benchmark::Compare("speedup, all threads", legacy, parallel);
+
+		// The timings mean nothing if the output changed (the tests compare the final meshes as well)
+		if (!SameResult(result, legacyResult)) {
+			throw std::runtime_error("ParallelObjParser output differs from the iostream loader for " + path);
+		}
+
+		legacyTotal.MedianMs += legacy.MedianMs;
+		legacyTotal.MinMs += legacy.MinMs;
+		singleTotal.MedianMs += single.MedianMs;
+		singleTotal.MinMs += single.MinMs;
+		parallelTotal.MedianMs += parallel.MedianMs;
+		parallelTotal.MinMs += parallel.MinMs;
+	}
+
+	printf("  all %zu files\n", files.size());
+	Benchmark::Report("iostream loader", legacyTotal);
+	Benchmark::Report("ParallelObjParser, 1 thread", singleTotal);
+	Benchmark::Report("ParallelObjParser, all threads", parallelTotal);
+	Benchmark::Compare("speedup, 1 thread", legacyTotal, singleTotal);
+	Benchmark::Compare("speedup, all threads", legacyTotal, parallelTotal);
+}
@@ -0,0 +1,113 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <stb_image.h>
+
+#include "Utils/TextureCompressor.h"
+
+#include "BenchFramework.h"
+#include "Utils/BlockDecoder.h"
+
+namespace {
+	struct SourceImage {
+		std::string          Name;
+		uint32_t             Width;
+		uint32_t             Height;
+		std::vector<uint8_t> Pixels;
+	};
+
+	// Loads every image directly in res/textures as RGBA8, the same way Texture2D does before it compresses
+	std::vector<SourceImage> LoadTextures() {
+		const std::filesystem::path folder = "res/textures";
+		if (!std::filesystem::is_directory(folder)) {
+			throw std::runtime_error("res/textures was not found, run the benchmarks from the project directory");
+		}
+
+		std::vector<std::filesystem::path> paths;
+		for (const auto& entry : std::filesystem::directory_iterator(folder)) {
+			if (entry.is_regular_file()) {
+				paths.push_back(entry.path());
+			}
+		}
+		std::sort(paths.begin(), paths.end());
+
+		std::vector<SourceImage> result;
+		for (const std::filesystem::path& path : paths) {
+			int width, height, numChannels;
+			uint8_t* data = stbi_load(path.string().c_str(), &width, &height, &numChannels, 4);
+			if (data == nullptr) {
+				continue;
+			}
+			SourceImage image;
+			image.Name = path.filename().string();
+			image.Width = width;
+			image.Height = height;
+			image.Pixels.assign(data, data + (size_t)width * height * 4);
+			stbi_image_free(data);
+			result.push_back(std::move(image));
+		}
+		return result;
+	}
+
+	// The PSNR over the channels that a format stores, in dB
+	double CalculatePsnr(const std::vector<uint8_t>& expected, const std::vector<uint8_t>& actual, BlockCompression format) {
+		int numChannels = 4;
+		switch (format) {
+			case BlockCompression::BC1: numChannels = 3; break;
+			case BlockCompression::BC4: numChannels = 1; break;
+			case BlockCompression::BC5: numChannels = 2; break;
+			default: break;
+		}
+
+		double error = 0.0;
+		for (size_t pixel = 0; pixel < expected.size(); pixel += 4) {
+			for (int channel = 0; channel < numChannels; channel++) {
+				double diff = (double)expected[pixel + channel] - (double)actual[pixel + channel];
+				error += diff * diff;
+			}
+		}
+		double mse = error / ((expected.size() / 4) * numChannels);
+		return mse == 0.0 ? 99.0 : 10.0 * std::log10(255.0 * 255.0 / mse);
+	}
+}
+
+// The quality and speed of the block compressor on every texture in res/textures, for each format it can
+// write. Quality is measured by decoding the output with an independent decoder, see BlockDecoder.h
+BENCHMARK(TextureCompress) {
+	std::vector<SourceImage> images = LoadTextures();
+	size_t totalPixels = 0;
+	for (const SourceImage& image : images) {
+		totalPixels += (size_t)image.Width * image.Height;
+	}
+	printf("  %zu images, %.1f Mpix\n", images.size(), totalPixels / 1000000.0);
+
+	for (BlockCompression format : { BlockCompression::BC1, BlockCompression::BC3, BlockCompression::BC4, BlockCompression::BC5, BlockCompression::BC7 }) {
+		double totalMs = 0.0;
+		double psnrSum = 0.0;
+		double worstPsnr = 1000.0;
+		std::string worstImage;
+
+		for (const SourceImage& image : images) {
+			std::vector<uint8_t> compressed(TextureCompressor::GetCompressedSize(format, image.Width, image.Height));
+			Benchmark::Result result = Benchmark::Measure(3, [&]() {
+				TextureCompressor::Compress(image.Pixels.data(), image.Width, image.Height, format, compressed.data());
+			});
+			totalMs += result.MedianMs;
+
+			double psnr = CalculatePsnr(image.Pixels, BlockDecoder::Decode(compressed.data(), image.Width, image.Height, format), format);
+			psnrSum += psnr;
+			if (psnr < worstPsnr) {
+				worstPsnr = psnr;
+				worstImage = image.Name;
+			}
+		}
+
+		printf("    %-4s %6.1f Mpix/s   mean PSNR %5.1f dB   worst %5.1f dB (%s)\n", (~format).c_str(),
+			totalPixels / totalMs / 1000.0, psnrSum / images.size(), worstPsnr, worstImage.c_str());
+	}
+}
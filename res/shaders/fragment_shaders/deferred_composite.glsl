@@ -10,6 +10,7 @@ uniform layout(binding = 3) sampler2D s_SpecularAccumulation;
 uniform layout(binding = 4) sampler2D s_Emissive;
 
 #include "../fragments/frame_uniforms.glsl"
+#include "../fragments/gbuffer_encoding.glsl"
 #include "../fragments/color_correction.glsl"
 #include "../fragments/multiple_point_lights.glsl"
 
@@ -17,25 +18,23 @@ void main() {
     vec3 albedo = texture(s_Albedo, inUV).rgb;
     vec3 diffuse = texture(s_DiffuseAccumulation, inUV).rgb;
     vec3 specular = texture(s_SpecularAccumulation, inUV).rgb;
-    vec4 emissive = texture(s_Emissive, inUV);
-
-    vec3 normal = texture(s_NormalsMetallic, inUV).rgb;
+    vec3 emissive = DecodeGBufferEmissive(texture(s_Emissive, inUV));
 
     if (IsFlagSet(FLAG_ENABLE_DIFFUSE_LIGHT))
     {
 
-        outColor = vec4(albedo * (diffuse + 0 + (emissive.rgb * emissive.a)), 1.0);
+        outColor = vec4(albedo * (diffuse + 0 + emissive), 1.0);
     }
     else if (IsFlagSet(FLAG_ENABLE_AMBIENT_LIGHT))
     {
-        outColor = vec4(albedo * (0 + 0 + (emissive.rgb * emissive.a)), 1.0);
+        outColor = vec4(albedo * (0 + 0 + emissive), 1.0);
     }
 
     else if (IsFlagSet(FLAG_ENABLE_SPECULAR_LIGHT))
     {
-        outColor = vec4(albedo * (0 + specular + (emissive.rgb * emissive.a)), 1.0);
+        outColor = vec4(albedo * (0 + specular + emissive), 1.0);
     }
 
-    else outColor = vec4(albedo * (diffuse + specular + (emissive.rgb * emissive.a)), 1.0);
+    else outColor = vec4(albedo * (diffuse + specular + emissive), 1.0);
     
 }
\ No newline at end of file
@@ -16,28 +16,55 @@ struct Material {
 	sampler2D EmissiveMap;
 	sampler2D NormalMap;
 	sampler2D MetallicShininessMap;
-	float     DiscardThreshold;
 };
 // Create a uniform for the material
 uniform Material u_Material;
 
+// The material's parameters, the material packs these into a uniform buffer (see Material::Apply)
+layout (std140, binding = 3) uniform b_Material {
+    // Fragments with an alpha below this are discarded when ALPHA_TEST is enabled
+    uniform float u_DiscardThreshold;
+};
+
+// Features are enabled per material with keywords, so that materials that
+// don't use them don't pay for them (see Material::SetKeywords)
+//   ALPHA_TEST   - discards fragments with an alpha below u_DiscardThreshold
+//   TOON_SHADING - remaps the albedo through the s_ToonTerm lookup table
+#ifdef TOON_SHADING
+uniform sampler1D s_ToonTerm;
+#endif
+
 #include "../fragments/frame_uniforms.glsl"
+#include "../fragments/gbuffer_encoding.glsl"
 
 // https://learnopengl.com/Advanced-Lighting/Advanced-Lighting
 void main() {
 	// Get albedo from the material
 	vec4 albedoColor = texture(u_Material.AlbedoMap, inUV);
 
+#ifdef TOON_SHADING
+    // Using a LUT to allow artists to tweak toon shading settings
+    albedoColor.r = texture(s_ToonTerm, albedoColor.r).r;
+    albedoColor.g = texture(s_ToonTerm, albedoColor.g).g;
+    albedoColor.b = texture(s_ToonTerm, albedoColor.b).b;
+#endif
+
 	// We can use another texture to store things like our lighting settings
 	vec4 lightingParams = texture(u_Material.MetallicShininessMap, inUV);
 
+#ifdef ALPHA_TEST
 	// Discarding fragments who's alpha is below the material's threshold
-	if (albedoColor.a < u_Material.DiscardThreshold) {
+	if (albedoColor.a < u_DiscardThreshold) {
 		discard;
 	}
+#endif
 
 	// Extract albedo from material, and store shininess
+#ifdef TOON_SHADING
+	albedo_specPower = vec4(albedoColor.rgb, lightingParams.x);
+#else
 	albedo_specPower = vec4(albedoColor.rgb, 1.0f);//lightingParams.x);
+#endif
 	
 	// Normalize our input normal
     // Read our tangent from the map, and convert from the [0,1] range to [-1,1] range
@@ -46,13 +73,11 @@ void main() {
 
     // Here we apply the TBN matrix to transform the normal from tangent space to view space
     normal = normalize(inTBN * normal);
-	
-	// Map [-1, 1] to [0, 1]
-	normal = clamp((normal + 1) / 2.0, 0, 1);
-	normal_metallic = vec4(normal, lightingParams.y);
+	normal_metallic = EncodeGBufferNormal(normal, lightingParams.y);
 
 	// Extract emissive from the material
-	emissive = texture(u_Material.EmissiveMap, inUV);
+	emissive = EncodeGBufferEmissive(texture(u_Material.EmissiveMap, inUV), lightingParams.y);
 
+	// Compact G-buffers have no position attachment, so this write goes nowhere
 	view_pos = inViewPos;
 }
\ No newline at end of file
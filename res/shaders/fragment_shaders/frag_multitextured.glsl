@@ -9,6 +9,7 @@ layout(location = 7) in vec4 inTextureWeights;
 ////////////////////////////////////////////////////////////////
 
 #include "../fragments/frame_uniforms.glsl"
+#include "../fragments/gbuffer_encoding.glsl"
 
 ////////////////////////////////////////////////////////////////
 /////////////// Instance Level Uniforms ////////////////////////
@@ -65,15 +66,14 @@ void main() {
 	
     // Here we apply the TBN matrix to transform the normal from tangent space to view space
     normal = normalize(inTBN * normal);
-	
-	// Map [-1, 1] to [0, 1]
-	normal = clamp((normal + 1) / 2.0, 0, 1);
-	normal_metallic = vec4(normal, 0.0f);
+	normal_metallic = EncodeGBufferNormal(normal, 0.0f);
 
 	// Extract emissive from the material
-	emissive = 
+	emissive = EncodeGBufferEmissive(
 		texture(u_Material.EmissiveA, inUV).rgba * inTextureWeights.x +
-		texture(u_Material.EmissiveB, inUV).rgba * inTextureWeights.y;
+		texture(u_Material.EmissiveB, inUV).rgba * inTextureWeights.y,
+		0.0f
+	);
 		
 	view_pos = inViewPos;
 }
\ No newline at end of file
@@ -4,9 +4,6 @@ layout(location = 0) in vec2 inUV;
 layout(location = 0) out vec4 outDiffuse;
 layout(location = 1) out vec4 outSpecular;
 
-// The maximum number of lights the shader supports, increasing this will lower performance!
-#define MAX_LIGHTS 8
-
 // Represents a single light source
 struct Light {
 	vec4  PositionIntensity;
@@ -14,25 +11,31 @@ struct Light {
 	vec4  ColorAttenuation;
 };
 
-// Our uniform buffer that will store all our lighting data
-// so that it can be shared between shaders
-layout (std140, binding = 2) uniform b_LightBlock {
-    // Stores ambient light color in rgb, and number
-	// of lights in w, allowing for easier struct packing
-	// on the C++ side
-    vec4  AmbientColAndNumLights;
+// Every light in the scene, with positions in view space
+layout (std430, binding = 0) readonly buffer b_ClusterLights {
+    Light Lights[];
+};
 
-    // Our array of all lights
-    Light Lights[MAX_LIGHTS];
+// The view frustum is split into a grid of clusters (see LightClusterer), each cluster stores
+// the offset and count of its range in the light index list
+layout (std430, binding = 1) readonly buffer b_Clusters {
+    uvec2 Clusters[];
+};
 
-    // The rotation of the skybox/environment map
-	mat3  EnvironmentRotation;
+// The indices of the lights in each cluster, sorted by cluster
+layout (std430, binding = 2) readonly buffer b_ClusterLightIndices {
+    uint LightIndices[];
 };
 
-#include "../fragments/deferred_post_common.glsl"
+// The number of clusters along the x, y and z axes
+uniform uvec3 u_ClusterGridSize;
+// The scale and bias for finding a depth slice, slice = log(depth) * x - y
+uniform vec2  u_ClusterDepthParams;
 
 #include "../fragments/frame_uniforms.glsl"
 
+#include "../fragments/deferred_post_common.glsl"
+
 // Calculates the contribution the given point light has 
 // for the current fragment
 // @param viewPos   The fragment's position in view space
@@ -60,6 +63,16 @@ void CalcPointLightContribution(vec3 viewPos, vec3 normal, Light light, float sh
         specular += VdotR * light.ColorAttenuation.rgb * shininess * attenuation * light.PositionIntensity.w;
 }
 
+// Finds the cluster that a fragment falls in
+// @param uv      The fragment's screen coordinates, between 0 and 1
+// @param viewPos The fragment's position in view space
+uint GetClusterIndex(vec2 uv, vec3 viewPos) {
+    uvec2 tile = min(uvec2(uv * vec2(u_ClusterGridSize.xy)), u_ClusterGridSize.xy - 1);
+    float slice = floor(log(max(-viewPos.z, 1e-4)) * u_ClusterDepthParams.x - u_ClusterDepthParams.y);
+    uint z = uint(clamp(slice, 0, float(u_ClusterGridSize.z - 1)));
+    return (z * u_ClusterGridSize.y + tile.y) * u_ClusterGridSize.x + tile.x;
+}
+
 void main() {
     vec3 normal = GetNormal(inUV);
     
@@ -76,8 +89,10 @@ void main() {
 
     vec3 diffuse = vec3(0);
     vec3 specular = vec3(0);
-    for (int ix = 0; ix < AmbientColAndNumLights.w && ix < MAX_LIGHTS; ix++) {
-        CalcPointLightContribution(viewPos, normal, Lights[ix], specularPow, diffuse, specular);
+    // Only the lights in this fragment's cluster can reach it
+    uvec2 cluster = Clusters[GetClusterIndex(inUV, viewPos)];
+    for (uint ix = 0; ix < cluster.y; ix++) {
+        CalcPointLightContribution(viewPos, normal, Lights[LightIndices[cluster.x + ix]], specularPow, diffuse, specular);
     }
 
     outDiffuse = vec4(diffuse, 1);
@@ -21,6 +21,7 @@ uniform float u_DepthNormThresholdScale;
 uniform vec2  u_PixelSize;
 
 #include "../../fragments/frame_uniforms.glsl"
+#include "../../fragments/gbuffer_encoding.glsl"
 
 float GetDepth(vec2 uv) {
     return texelFetch(s_Depth, ivec2(uv * textureSize(s_Depth, 0)), 0).r;
@@ -29,7 +30,7 @@ float GetDepth(vec2 uv) {
 void main() {
 
     float depth = GetDepth(inUV);
-    vec3 norm = texture(s_Normals, inUV).rgb * 2 - 1;
+    vec3 norm = DecodeGBufferNormal(texture(s_Normals, inUV));
 
     float halfScale = u_Scale * 0.5f;
 
@@ -46,10 +47,10 @@ void main() {
     float d3 = GetDepth(inUV);
 
     // Grab normals
-    vec3 n0 = texture(s_Normals, u0).rgb * 2 - 1;
-    vec3 n1 = texture(s_Normals, u1).rgb * 2 - 1;
-    vec3 n2 = texture(s_Normals, u2).rgb * 2 - 1;
-    vec3 n3 = texture(s_Normals, u3).rgb * 2 - 1;
+    vec3 n0 = DecodeGBufferNormal(texture(s_Normals, u0));
+    vec3 n1 = DecodeGBufferNormal(texture(s_Normals, u1));
+    vec3 n2 = DecodeGBufferNormal(texture(s_Normals, u2));
+    vec3 n3 = DecodeGBufferNormal(texture(s_Normals, u3));
 
     // Compute a threshold term based on the dot product between the camera and the normal
     float nDotV = 1 - dot(norm, -inViewDir);
@@ -14,6 +14,16 @@ layout (binding = 6) uniform sampler2D s_ProjectionMask;
 
 // Matrix to go from view space to shadow clip space
 uniform mat4  u_ViewToShadow;
+// The light's tile in the shadow atlas, offset in xy and scale in zw (in UV space)
+uniform vec4  u_ShadowAtlasRect;
+
+// Cascaded lights replace the matrix and tile above with one per cascade, see ShadowCascades
+#define MAX_CASCADES 4
+uniform uint  u_CascadeCount;
+uniform mat4  u_CascadeViewToShadow[MAX_CASCADES];
+uniform vec4  u_CascadeAtlasRect[MAX_CASCADES];
+// The view depth that each cascade ends at
+uniform vec4  u_CascadeSplits;
 // Light's direction in view space
 uniform vec3  u_LightDirViewspace;
 // Light's position in view space
@@ -50,20 +60,12 @@ struct Light {
 	vec4  ColorAttenuation;
 };
 
-#include "../fragments/deferred_post_common.glsl"
 #include "../fragments/frame_uniforms.glsl"
+#include "../fragments/deferred_post_common.glsl"
 
-// Showing off another way to extract view pos from depth
+// We always rebuild the view position from depth here, whichever G-buffer layout is in use
 vec4 GetViewPos(vec2 uv) {
-	// Get the depth buffer value at this pixel, map from [0,1] to [-1,1]    
-	float zOverW = GetDepth(uv) * 2 - 1;
-	// We convert the range [0,1] to [-1,1], create a point to inverse project    
-	vec4 currentPos = vec4(uv.xy * 2 - 1, zOverW, 1);
-	// Transform by the view-projection inverse    
-	vec4 D = inverse(u_Projection) * currentPos;
-	// Divide by w for perspective divide    
-	vec4 viewPos = D / D.w;
-	return viewPos;
+	return vec4(ViewPositionFromDepth(uv, GetDepth(uv)), 1.0);
 }
 
 // Calculates the contribution the given point light has 
@@ -96,16 +98,32 @@ void CalcDirectionalLightContribution(vec3 viewPos, vec3 normal, Light light, fl
         specular += VdotR * light.ColorAttenuation.rgb * shininess * attenuation * light.PositionIntensity.w;
 }
 
+// Samples the light's tile in the shadow atlas, keeping the sample half a texel inside
+// the tile so that filtering never picks up depth from the neighbouring tiles
+// @param atlasUV   The position in the atlas to sample
+// @param depth     The depth to compare against
+// @param texelSize The size of one texel of the atlas
+// @param tile      The tile to sample, offset in xy and scale in zw
+float SampleShadowAtlas(vec2 atlasUV, float depth, vec2 texelSize, vec4 tile) {
+    vec2 tileMin = tile.xy + texelSize * 0.5;
+    vec2 tileMax = tile.xy + tile.zw - texelSize * 0.5;
+    return texture(s_ShadowDepth, vec3(clamp(atlasUV, tileMin, tileMax), depth));
+}
+
 // This function will sample multiple points around our sample, and average the results
 // This gives a slight blur to the edges of the shadows, and helps to soften them up
 // @param fragPos The position in the shadow's normalized clip space to sample
 // @param bias The shadow bias factor to use
-float PCF(vec3 fragPos, float bias) {
+// @param tile The light's tile in the shadow atlas, offset in xy and scale in zw
+float PCF(vec3 fragPos, float bias, vec4 tile) {
+    vec2 texelSize = 1.0 / textureSize(s_ShadowDepth, 0); // Determine the texel size of the shadow sampler
+
+    // Move from the light's [0,1] space into its tile of the atlas
+    vec2 atlasUV = tile.xy + fragPos.xy * tile.zw;
 
     // If we're doing PCF, we want to take multiple samples
     if (ShadowFlagSet(FLAG_ENABLE_PCF)) {
         float result = 0.0; // accumulator
-        vec2 texelSize = 1.0 / textureSize(s_ShadowDepth, 0); // Determine the texel size of the shadow sampler
         
         // 5x5 kernel
         if (ShadowFlagSet(FLAG_ENABLE_WIDE_PCF)) {
@@ -125,11 +143,7 @@ float PCF(vec3 fragPos, float bias) {
                     // OpenGL will take care of the rest and return a value between 0 and 1
                     // as long as the texture is a sampler2DShadow. This is also where bias is
                     // applied.
-                    float contrib =
-                        texture(
-                            s_ShadowDepth, 
-                            vec3(fragPos.xy + vec2(x,y) * texelSize, fragPos.z - bias)
-                        );
+                    float contrib = SampleShadowAtlas(atlasUV + vec2(x,y) * texelSize, fragPos.z - bias, texelSize, tile);
                     // Apply kernel weights to the result
                     result += contrib * kernel[x+2][y+2];
                 }    
@@ -148,7 +162,7 @@ float PCF(vec3 fragPos, float bias) {
             for(int x = -1; x <= 1; ++x) { 
                 for(int y = -1; y <= 1; ++y) {
                     // See above notes about texture
-                    float contrib = texture(s_ShadowDepth, vec3(fragPos.xy + vec2(x,y) * texelSize, fragPos.z - bias));
+                    float contrib = SampleShadowAtlas(atlasUV + vec2(x,y) * texelSize, fragPos.z - bias, texelSize, tile);
                     result += contrib * kernel[x+1][y+1];
                 }    
             }
@@ -159,7 +173,7 @@ float PCF(vec3 fragPos, float bias) {
     // PCF is not enabled, take 1 sample
     else {
         // See above notes about texture
-        float contrib = texture(s_ShadowDepth, vec3(fragPos.xy, fragPos.z - bias));
+        float contrib = SampleShadowAtlas(atlasUV, fragPos.z - bias, texelSize, tile);
         return contrib; // Perform the depth test, and return the result
     }
 }
@@ -182,15 +196,30 @@ void main() {
     // Get viewspace from depth re-construction method (just to show how it works!)
     vec3 viewPos = GetViewPos(inUV).xyz;
 
+    // Cascaded lights use the first cascade that reaches past this pixel's depth
+    mat4 viewToShadow = u_ViewToShadow;
+    vec4 shadowTile = u_ShadowAtlasRect;
+    bool inCascade = false;
+    for (uint ix = 0; ix < u_CascadeCount; ix++) {
+        if (-viewPos.z <= u_CascadeSplits[ix]) {
+            viewToShadow = u_CascadeViewToShadow[ix];
+            shadowTile = u_CascadeAtlasRect[ix];
+            inCascade = true;
+            break;
+        }
+    }
+
     // Determine the position in light clip space
-	vec4 shadowPos = u_ViewToShadow * vec4(viewPos, 1.0);  
+	vec4 shadowPos = viewToShadow * vec4(viewPos, 1.0);  
 	shadowPos /= shadowPos.w;                // Perspective divide
 	shadowPos = shadowPos * 0.5 + 0.5;       // Normalize from clip space to [0,1]
     
-    // If pixel on screen is outside the bounds of the light, skip it
-    if (shadowPos.x < 0 || shadowPos.x > 1 || 
-        shadowPos.y < 0 || shadowPos.y > 1 || 
-        shadowPos.z < 0 || shadowPos.z > 1) {
+    // If pixel on screen is outside the bounds of the light, skip it. Cascaded lights light
+    // everything, but only cast shadows out to the end of the last cascade
+    bool inBounds = !(shadowPos.x < 0 || shadowPos.x > 1 || 
+                      shadowPos.y < 0 || shadowPos.y > 1 || 
+                      shadowPos.z < 0 || shadowPos.z > 1);
+    if (u_CascadeCount == 0 && !inBounds) {
         //outDiffuse  = vec4(1, 0, 0, 1);
         //outSpecular = vec4(1, 0, 0, 1);
         //return;
@@ -201,7 +230,10 @@ void main() {
     float bias = max(u_NormalBias * (1.0 - dot(normal, u_LightDirViewspace)), u_ShadowBias);
 
     // Determine how much of the pixel on the screen is in shadow
-    float lightContrib = PCF(shadowPos.xyz, bias);
+    float lightContrib = 1.0;
+    if (u_CascadeCount == 0 || (inCascade && inBounds)) {
+        lightContrib = PCF(shadowPos.xyz, bias, shadowTile);
+    }
 
     vec3 diffuse = vec3(0);
     vec3 specular = vec3(0);
@@ -213,8 +245,8 @@ void main() {
         Light l;
         l.PositionIntensity = vec4(u_LightPosViewspace, u_Intensity);
 
-        // If we want to use the projection mask, we sample it and multiply by light color
-        if (ShadowFlagSet(FLAG_PROJECTION_ENABLED)) {
+        // If we want to use the projection mask, we sample it and multiply by light color (cascades each have their own projection, so they can't project)
+        if (ShadowFlagSet(FLAG_PROJECTION_ENABLED) && u_CascadeCount == 0) {
             vec3 color = texture(s_ProjectionMask, shadowPos.xy).rgb * u_LightColor;
             l.ColorAttenuation = vec4(color, u_Attenuation);
         }
@@ -1,3 +1,5 @@
+// Reads the G-buffer, requires frame_uniforms.glsl to be included first
+#include "gbuffer_encoding.glsl"
 
 uniform layout(binding=0) sampler2D s_Depth;
 uniform layout(binding=1) sampler2D s_AlbedoSpec;
@@ -7,17 +9,21 @@ uniform layout(binding=4) sampler2D s_Position;
 
 
 vec3 GetNormal(vec2 uv) {
-    return ((texture(s_NormalsMetallic, uv).xyz) * 2) - 1;
+    return DecodeGBufferNormal(texture(s_NormalsMetallic, uv));
 }
 
 vec3 GetAlbedo(vec2 uv) {
     return texture(s_AlbedoSpec, uv).rgb;
 }
 
-vec3 GetViewPosition(vec2 uv) {
-    return texture(s_Position, uv).rgb;
-}
-
 float GetDepth(vec2 uv) {
     return texelFetch(s_Depth, ivec2(uv * textureSize(s_Depth, 0)), 0).r;
+}
+
+vec3 GetViewPosition(vec2 uv) {
+    // Compact G-buffers don't store position, we get it back from the depth instead
+    if (IsCompactGBuffer()) {
+        return ViewPositionFromDepth(uv, GetDepth(uv));
+    }
+    return texture(s_Position, uv).rgb;
 }
\ No newline at end of file
@@ -35,7 +35,8 @@ layout (std140, binding = 0) uniform b_FrameLevelUniforms {
 
 };
 
-// Stores uniforms that change every object/instance
+// Stores uniforms that change every object/instance, instanced shaders read these from vertex attributes instead
+#ifndef INSTANCED
 layout (std140, binding = 1) uniform b_InstanceLevelUniforms {
     // Complete MVP
     uniform mat4 u_ModelViewProjection;
@@ -46,6 +47,7 @@ layout (std140, binding = 1) uniform b_InstanceLevelUniforms {
     // Normal Matrix for transforming normals
     uniform mat4 u_NormalMatrix;
 };
+#endif
 
 #define FLAG_ENABLE_DIFFUSE_LIGHT (1 << 0)
 #define FLAG_ENABLE_AMBIENT_LIGHT (1 << 1)
@@ -0,0 +1,50 @@
+// Shared encoding for the G-buffer, the render layer picks the layout (see GBufferLayout in RenderLayer.h)
+//   Full:    albedo + spec (RGBA8), normal + metallic (RGBA8), emissive (RGBA8), view position (RGBA16F)
+//   Compact: albedo + spec (RGBA8), octahedral normal (RG16), pre-multiplied emissive + metallic (RGBA8),
+//            and the view position is rebuilt from depth
+// Requires frame_uniforms.glsl to be included first
+
+#include "gbuffer_packing.glsl"
+
+#define FLAG_COMPACT_GBUFFER (1 << 4)
+
+bool IsCompactGBuffer() {
+    return IsFlagSet(FLAG_COMPACT_GBUFFER);
+}
+
+// Encodes a view space normal for the normal attachment
+vec4 EncodeGBufferNormal(vec3 normal, float metallic) {
+    if (IsCompactGBuffer()) {
+        return vec4(PackOctNormal(normal), 0, 0);
+    }
+    return vec4(clamp((normal + 1) / 2.0, 0, 1), metallic);
+}
+
+// Decodes a texel from the normal attachment into a view space normal
+vec3 DecodeGBufferNormal(vec4 texel) {
+    if (IsCompactGBuffer()) {
+        return UnpackOctNormal(texel.rg);
+    }
+    return texel.rgb * 2 - 1;
+}
+
+// Encodes a material's emissive color for the emissive attachment, compact G-buffers store metallic in its alpha
+vec4 EncodeGBufferEmissive(vec4 emissive, float metallic) {
+    if (IsCompactGBuffer()) {
+        return vec4(emissive.rgb * emissive.a, metallic);
+    }
+    return emissive;
+}
+
+// Decodes a texel from the emissive attachment into the emitted light
+vec3 DecodeGBufferEmissive(vec4 texel) {
+    if (IsCompactGBuffer()) {
+        return texel.rgb;
+    }
+    return texel.rgb * texel.a;
+}
+
+// Rebuilds a view space position from a depth buffer value
+vec3 ViewPositionFromDepth(vec2 uv, float depth) {
+    return ViewPositionFromDepth(u_InvProjection, uv, depth);
+}
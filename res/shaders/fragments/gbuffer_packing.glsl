@@ -0,0 +1,45 @@
+// The math behind the compact G-buffer, without anything that depends on uniforms (see gbuffer_encoding.glsl)
+// tests/Graphics/GBufferEncodingTests.cpp also compiles this file as C++ against GLM, so only use what GLSL and
+// GLM have in common: no swizzles (other than single components), and float literals with an f suffix
+
+vec2 SignNotZero(vec2 v) {
+    return vec2(v.x >= 0.0f ? 1.0f : -1.0f, v.y >= 0.0f ? 1.0f : -1.0f);
+}
+
+// Maps a unit vector onto the octahedron, then unfolds it into a square, each component is in [-1,1]
+// http://jcgt.org/published/0003/02/01/
+vec2 OctEncode(vec3 n) {
+    n /= abs(n.x) + abs(n.y) + abs(n.z);
+    vec2 result = vec2(n.x, n.y);
+    if (n.z < 0.0f) {
+        result = (1.0f - abs(vec2(n.y, n.x))) * SignNotZero(vec2(n.x, n.y));
+    }
+    return result;
+}
+
+// Reverses OctEncode, the result is normalized
+vec3 OctDecode(vec2 e) {
+    vec3 n = vec3(e.x, e.y, 1.0f - abs(e.x) - abs(e.y));
+    if (n.z < 0.0f) {
+        vec2 xy = (1.0f - abs(vec2(n.y, n.x))) * SignNotZero(vec2(n.x, n.y));
+        n = vec3(xy.x, xy.y, n.z);
+    }
+    return normalize(n);
+}
+
+// Encodes a unit vector into the [0,1] range of an RG16 attachment
+vec2 PackOctNormal(vec3 normal) {
+    return OctEncode(normal) * 0.5f + 0.5f;
+}
+
+// Reverses PackOctNormal
+vec3 UnpackOctNormal(vec2 texel) {
+    return OctDecode(texel * 2.0f - 1.0f);
+}
+
+// Rebuilds a view space position from a depth buffer value and the inverse of the projection matrix
+vec3 ViewPositionFromDepth(mat4 invProjection, vec2 uv, float depth) {
+    vec4 clipPos = vec4(uv * 2.0f - 1.0f, depth * 2.0f - 1.0f, 1.0f);
+    vec4 viewPos = invProjection * clipPos;
+    return vec3(viewPos) / viewPos.w;
+}
@@ -17,3 +17,16 @@ layout(location = 4) out mat3 outTBN;
 
 // Include the matrices and frame level parameters
 #include "frame_uniforms.glsl"
+
+// When compiled as an instanced variant, the per-object matrices come from the renderer's instance
+// buffer instead of the instance uniform block. Attributes 0-5 are used by our common inputs, so we
+// start at 8 to leave some space. The model matrix consumes 4 slots, and the normal matrix consumes 3
+#ifdef INSTANCED
+layout(location = 8) in mat4 inModelTransform;
+layout(location = 12) in mat3 inNormalMatrix;
+
+#define u_Model               inModelTransform
+#define u_ModelView           (u_View * inModelTransform)
+#define u_ModelViewProjection (u_ViewProjection * inModelTransform)
+#define u_NormalMatrix        mat4(inNormalMatrix)
+#endif
@@ -8,7 +8,10 @@
 
 uniform sampler2D s_Heightmap;
 uniform sampler2D s_NormalMap;
-uniform float u_Scale;
+// The material's parameters for the vertex stage, the material packs these into a uniform buffer
+layout (std140, binding = 4) uniform b_MaterialVertex {
+    uniform float u_Scale;
+};
 
 void main() {
     
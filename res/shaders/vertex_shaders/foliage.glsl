@@ -3,10 +3,13 @@
 // Include our common vertex shader attributes and uniforms
 #include "../fragments/vs_common.glsl"
 
-uniform vec3  u_WindDirection;
-uniform float u_WindStrength;
-uniform float u_VerticalScale;
-uniform float u_WindSpeed;
+// The material's parameters for the vertex stage, the material packs these into a uniform buffer
+layout (std140, binding = 4) uniform b_MaterialVertex {
+    uniform vec3  u_WindDirection;
+    uniform float u_WindStrength;
+    uniform float u_VerticalScale;
+    uniform float u_WindSpeed;
+};
 
 void main() {
     // Determine the offset based on our simple wind calcualtion
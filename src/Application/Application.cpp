@@ -12,6 +12,7 @@
 #include "Utils/FileHelpers.h"
 #include "Utils/ResourceManager/ResourceManager.h"
 #include "Utils/ImGuiHelper.h"
+#include "Utils/JobSystem.h"
 
 // Graphics
 #include "Graphics/Buffers/IndexBuffer.h"
@@ -69,6 +70,12 @@ std::string Application::_applicationName = "INFR-2350U - DEMO";
 
 #define DEFAULT_WINDOW_WIDTH 1280
 #define DEFAULT_WINDOW_HEIGHT 720
+// How long we spend creating assets that were loaded in the background each frame, in milliseconds
+#define DEFAULT_ASSET_UPLOAD_BUDGET_MS 4.0f
+// How much memory loaded assets can use before unused ones are evicted, in megabytes (0 for no limit)
+#define DEFAULT_ASSET_MEMORY_BUDGET_MB 1024
+// Where linked shader programs are cached, so we can skip compiling them on the next run (empty to disable)
+#define DEFAULT_SHADER_CACHE_DIR "shader_cache"
 
 Application::Application() :
 	_window(nullptr),
@@ -121,7 +128,9 @@ bool Application::LoadScene(const std::string& path) {
 		std::string manifestPath = std::filesystem::path(path).stem().string() + "-manifest.json";
 		if (std::filesystem::exists(manifestPath)) {
 			LOG_INFO("Loading manifest from \"{}\"", manifestPath);
-			ResourceManager::LoadManifest(manifestPath);
+			// Start decoding every asset in the background, the scene will finish any that it needs
+			// right away, and the rest will be created over the next few frames
+			ResourceManager::LoadManifest(manifestPath, true);
 		}
 
 		Gameplay::Scene::Sptr scene = Gameplay::Scene::Load(path);
@@ -174,16 +183,28 @@ void Application::_Run()
 	// By default, we want our viewport to be the whole screen
 	_primaryViewport = { 0, 0, _windowSize.x, _windowSize.y };
 
+	// Start the worker threads for the job system
+	JobSystem::Init();
+
 	// Register all component and resource types
 	_RegisterClasses();
 
+	ResourceManager::SetMemoryBudget(JsonGet(_appSettings, "asset_memory_budget_mb", DEFAULT_ASSET_MEMORY_BUDGET_MB) * (size_t)1024 * 1024);
+	ShaderProgram::SetBinaryCacheDirectory(JsonGet(_appSettings, "shader_cache_dir", std::string(DEFAULT_SHADER_CACHE_DIR)));
 
 	// Load all layers
 	_Load();
 
+	// Report how much time the shader binary cache saved us during startup
+	const ShaderProgram::BinaryCacheStats& shaderStats = ShaderProgram::GetBinaryCacheStats();
+	LOG_INFO("Shaders: {} compiled in {:.2f} ms, {} loaded from cache in {:.2f} ms",
+		shaderStats.NumCompiled, shaderStats.CompileSeconds * 1000.0, shaderStats.NumCached, shaderStats.CacheSeconds * 1000.0);
+
 	// Grab current time as the previous frame
 	double lastFrame =  glfwGetTime();
 
+	float assetUploadBudget = JsonGet(_appSettings, "asset_upload_budget_ms", DEFAULT_ASSET_UPLOAD_BUDGET_MS);
+
 	// Done loading, app is now running!
 	_isRunning = true;
 
@@ -253,6 +274,9 @@ void Application::_Run()
 		}
 
 
+		// Create any assets that have finished loading in the background
+		ResourceManager::ProcessUploads(assetUploadBudget);
+
 		ImGuiHelper::StartFrame();
 		
 		// Core update loop
@@ -277,6 +301,8 @@ void Application::_Run()
 
 	// Unload all our layers
 	_Unload();
+
+	JobSystem::Shutdown();
 }
 
 void Application::_RegisterClasses()
@@ -488,6 +514,9 @@ nlohmann::json Application::_GetDefaultAppSettings()
 
 	result["window_width"]  = DEFAULT_WINDOW_WIDTH;
 	result["window_height"] = DEFAULT_WINDOW_HEIGHT;
+	result["asset_upload_budget_ms"] = DEFAULT_ASSET_UPLOAD_BUDGET_MS;
+	result["asset_memory_budget_mb"] = DEFAULT_ASSET_MEMORY_BUDGET_MB;
+	result["shader_cache_dir"] = DEFAULT_SHADER_CACHE_DIR;
 	return result;
 }
 
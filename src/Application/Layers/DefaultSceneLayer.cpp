@@ -157,12 +157,12 @@ void DefaultSceneLayer::_CreateScene()
 		});
 		displacementShader->SetDebugName("Displacement Mapping");
 
-		// This shader handles our cel shading example
-		ShaderProgram::Sptr celShader = ResourceManager::CreateAsset<ShaderProgram>(std::unordered_map<ShaderPartType, std::string>{
-			{ ShaderPartType::Vertex, "shaders/vertex_shaders/displacement_mapping.glsl" },
-			{ ShaderPartType::Fragment, "shaders/fragment_shaders/cel_shader.glsl" }
-		});
-		celShader->SetDebugName("Cel Shader");
+		// Compile the permutations that our materials select with keywords up front, each call compiles its
+		// permutations as a single batch so the driver can work on them in parallel
+		deferredForward->CompilePermutations({ { "INSTANCED" } });
+		foliageShader->CompilePermutations({ { "ALPHA_TEST" }, { "ALPHA_TEST", "INSTANCED" } });
+		// The cel shading example is the displacement shader with toon shading enabled
+		displacementShader->CompilePermutations({ { "TOON_SHADING" }, { "TOON_SHADING", "INSTANCED" } });
 
 
 		// Load in the meshes
@@ -312,9 +312,10 @@ void DefaultSceneLayer::_CreateScene()
 		Material::Sptr foliageMaterial = ResourceManager::CreateAsset<Material>(foliageShader);
 		{
 			foliageMaterial->Name = "Foliage Shader";
+			foliageMaterial->SetKeywords({ "ALPHA_TEST" });
 			foliageMaterial->Set("u_Material.AlbedoMap", leafTex);
 			foliageMaterial->Set("u_Material.Shininess", 0.1f);
-			foliageMaterial->Set("u_Material.DiscardThreshold", 0.1f);
+			foliageMaterial->Set("u_DiscardThreshold", 0.1f);
 			foliageMaterial->Set("u_Material.NormalMap", normalMapDefault);
 
 			foliageMaterial->Set("u_WindDirection", glm::vec3(1.0f, 1.0f, 0.0f));
@@ -324,9 +325,10 @@ void DefaultSceneLayer::_CreateScene()
 		}
 
 		// Our toon shader material
-		Material::Sptr toonMaterial = ResourceManager::CreateAsset<Material>(celShader);
+		Material::Sptr toonMaterial = ResourceManager::CreateAsset<Material>(displacementShader);
 		{
 			toonMaterial->Name = "Toon"; 
+			toonMaterial->SetKeywords({ "TOON_SHADING" });
 			toonMaterial->Set("u_Material.AlbedoMap", boxTexture);
 			toonMaterial->Set("u_Material.NormalMap", normalMapDefault);
 			toonMaterial->Set("s_ToonTerm", toonLut);
@@ -548,6 +550,8 @@ void DefaultSceneLayer::_CreateScene()
 			// Create and attach a renderer for the monkey
 			ShadowCamera::Sptr shadowCam = shadowCaster->Add<ShadowCamera>();
 			shadowCam->SetProjection(glm::perspective(glm::radians(120.0f), 1.0f, 0.1f, 100.0f));
+			// Light the whole terrain like the sun, with cascades that follow the camera around
+			shadowCam->SetCascadeCount(3);
 		}
 
 		GameObject::Sptr ballParticles = scene->CreateGameObject("Particles"); 
@@ -165,7 +165,7 @@ void ImGuiDebugLayer::OnRender(const Framebuffer::Sptr& prevLayer)
 
 				// Load scene item
 				if (ImGui::MenuItem("Load Scene", NULL, false)) {
-					std::optional<std::string> path = FileDialogs::OpenFile("Scene File\0*.json\0\0");
+					std::optional<std::string> path = FileDialogs::OpenFile("Scene File\0*.json;*.bscene\0\0");
 					if (path.has_value()) {
 						app.LoadScene(path.value());
 					}
@@ -173,7 +173,7 @@ void ImGuiDebugLayer::OnRender(const Framebuffer::Sptr& prevLayer)
 
 				// Save scene item
 				if (ImGui::MenuItem("Save Scene", NULL, false)) {
-					std::optional<std::string> path = FileDialogs::SaveFile("Scene File\0*.json\0\0");
+					std::optional<std::string> path = FileDialogs::SaveFile("JSON Scene\0*.json\0Binary Scene\0*.bscene\0\0");
 					if (path.has_value()) {
 						app.CurrentScene()->Save(path.value());
 
@@ -13,7 +13,8 @@
 #include "PostProcessing/PixelizationEffect.h"
 
 PostProcessingLayer::PostProcessingLayer() :
-	ApplicationLayer()
+	ApplicationLayer(),
+	_hasReportedGraphErrors(false)
 {
 	Name = "Post Processing";
 	Overrides =
@@ -43,18 +44,7 @@ void PostProcessingLayer::OnAppLoad(const nlohmann::json& config)
 	_effects.push_back(std::make_shared<FilmGrain>());
 	_effects.push_back(std::make_shared<PixelizationEffect>());
 
-	Application& app = Application::Get();
-	const glm::uvec4& viewport = app.GetPrimaryViewport();
-
-	// Initialize all the effect's output FBOs (inefficient) 
-	for (const auto& effect : _effects) {
-		FramebufferDescriptor fboDesc = FramebufferDescriptor();
-		fboDesc.Width  = viewport.z * effect->_outputScale.x;
-		fboDesc.Height = viewport.w * effect->_outputScale.y;
-		fboDesc.RenderTargets[RenderTargetAttachment::Color0] = RenderTargetDescriptor(effect->_format);
-
-		effect->_output = std::make_shared<Framebuffer>(fboDesc);
-	}
+	// Effect outputs are allocated from our render target pool as the effects are used, see OnPostRender
 
 	// We need a mesh for drawing fullscreen quads
 	glm::vec2 positions[6] = {
@@ -74,62 +64,88 @@ void PostProcessingLayer::OnAppLoad(const nlohmann::json& config)
 void PostProcessingLayer::OnPostRender()
 {
 	Application& app = Application::Get();
-	const glm::uvec4& viewport = app.GetPrimaryViewport();
+	const glm::uvec4 viewport = app.GetPrimaryViewport();
 
 	// Grab the render layer from the app, get it's output and the G-Buffer
 	const RenderLayer::Sptr& renderer = app.GetLayer<RenderLayer>();
-	const Framebuffer::Sptr& output = renderer->GetRenderOutput();
 	const Framebuffer::Sptr& gBuffer = renderer->GetGBuffer();
 
-	// Stores the input FBO to the effect, we start with the renderlayer's output 
-	Framebuffer::Sptr current = output;
-
-	// Disable depth testing and depth writing, as well as blending
-	glDisable(GL_DEPTH_TEST);
-	glDepthMask(false);
-	glDisable(GL_BLEND);
+	// Describe this frame's effects to the render graph, starting from the renderlayer's output
+	_renderGraph.Reset(glm::uvec2(viewport.z, viewport.w));
+	RenderGraph::Handle current = _targetPool.Import(_renderGraph, "Scene Color", renderer->GetRenderOutput());
+	RenderGraph::Handle gBufferTarget = _targetPool.Import(_renderGraph, "G-Buffer", gBuffer);
+	RenderGraph::Handle screen = _targetPool.Import(_renderGraph, "Screen", nullptr);
 
-	// Bind the quad VAO so our effects can use it
-	_quadVAO->Bind();
-
-	// Iterate over all the effects in the queue
 	for (const auto& effect : _effects) {
 		// Only render if it's enabled
-		if (effect->Enabled) {
+		if (!effect->Enabled) {
+			continue;
+		}
+
+		RenderGraph::Handle output = _renderGraph.CreateTarget(effect->Name, RenderGraph::TargetDescriptor(effect->_format, effect->_outputScale));
+		Effect* effectPtr = effect.get();
+		_renderGraph.AddPass(effect->Name, { current, gBufferTarget }, { output }, [this, effectPtr, current, output, gBuffer]() {
 			// Bind the FBO and make sure we're rendering to the whole thing
-			effect->_output->Bind();
-			glViewport(0, 0, effect->_output->GetWidth(), effect->_output->GetHeight());
+			effectPtr->_output = _targetPool.Get(output);
+			effectPtr->_output->Bind();
+			glViewport(0, 0, effectPtr->_output->GetWidth(), effectPtr->_output->GetHeight());
 
 			// Bind color 0 from previous pass to texture slot 0 so our effects can access
-			current->BindAttachment(RenderTargetAttachment::Color0, 0);
+			_targetPool.Get(current)->BindAttachment(RenderTargetAttachment::Color0, 0);
 
 			// Apply the effect and render the fullscreen quad
-			effect->Apply(gBuffer);
+			effectPtr->Apply(gBuffer);
 			_quadVAO->Draw();
 
-			// Unbind output and set it as input for next pass
-			effect->_output->Unbind();
-			current = effect->_output;
-		}
+			effectPtr->_output->Unbind();
+		});
+
+		// The output becomes the input for the next pass
+		current = output;
 	}
-	_quadVAO->Unbind();
 
-	// Restore viewport to game viewport
-	glViewport(viewport.x, viewport.y, viewport.z, viewport.w);
+	// Blit the color buffer of the last pass to our game window
+	_renderGraph.AddBlit("Present", current, screen, [this, current, viewport]() {
+		const Framebuffer::Sptr& source = _targetPool.Get(current);
+
+		// Restore viewport to game viewport
+		glViewport(viewport.x, viewport.y, viewport.z, viewport.w);
 
-	// Bind the output of our post processing as the source for the blit
-	current->Bind(FramebufferBinding::Read);
-	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+		// Bind the output of our post processing as the source for the blit
+		source->Bind(FramebufferBinding::Read);
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
 
-	// Blit the color buffer to our game window
-	current->Blit(
-		{ 0, 0, current->GetWidth(), current->GetHeight() },
-		{ viewport.x, viewport.y, viewport.x + viewport.z, viewport.y + viewport.w },
-		BufferFlags::Color,
-		MagFilter::Linear
-	);
+		Framebuffer::Blit(
+			{ 0, 0, source->GetWidth(), source->GetHeight() },
+			{ viewport.x, viewport.y, viewport.x + viewport.z, viewport.y + viewport.w },
+			BufferFlags::Color,
+			MagFilter::Linear
+		);
 
-	current->Unbind();
+		source->Unbind();
+	});
+
+	if (!_renderGraph.Compile()) {
+		// An invalid graph means the passes were declared wrong, so report it once and run the effects in order
+		if (!_hasReportedGraphErrors) {
+			for (const std::string& error : _renderGraph.GetErrors()) {
+				LOG_ERROR("Render graph: {}", error);
+			}
+			_hasReportedGraphErrors = true;
+		}
+		_renderGraph.CompileInOrder();
+	}
+	_targetPool.Realize(_renderGraph);
+
+	// Disable depth testing and depth writing, as well as blending
+	glDisable(GL_DEPTH_TEST);
+	glDepthMask(false);
+	glDisable(GL_BLEND);
+
+	// Bind the quad VAO so our effects can use it
+	_quadVAO->Bind();
+	_renderGraph.Execute();
+	_quadVAO->Unbind();
 }
 
 void PostProcessingLayer::OnSceneLoad()
@@ -148,9 +164,9 @@ void PostProcessingLayer::OnSceneUnload()
 
 void PostProcessingLayer::OnWindowResize(const glm::ivec2& oldSize, const glm::ivec2& newSize)
 {
+	// The render target pool resizes the effect outputs when they are next used
 	for (const auto& effect : _effects) {
 		effect->OnWindowResize(oldSize, newSize);
-		effect->_output->Resize(newSize.x, newSize.y);
 	}
 }
 
@@ -159,6 +175,16 @@ const std::vector<PostProcessingLayer::Effect::Sptr>& PostProcessingLayer::GetEf
 	return _effects;
 }
 
+const RenderGraph& PostProcessingLayer::GetRenderGraph() const
+{
+	return _renderGraph;
+}
+
+const RenderTargetPool& PostProcessingLayer::GetRenderTargetPool() const
+{
+	return _targetPool;
+}
+
 void PostProcessingLayer::Effect::DrawFullscreen()
 {
 	glDrawArrays(GL_TRIANGLES, 0, 6);
@@ -3,6 +3,8 @@
 #include "Application/ApplicationLayer.h"
 #include "Utils/Macros.h"
 #include "Graphics/VertexArrayObject.h"
+#include "Graphics/RenderGraph.h"
+#include "Graphics/RenderTargetPool.h"
 
 /**
  * The post processing layer will handle rendering effects after the primary
@@ -61,7 +63,8 @@ public:
 	protected:
 		friend class PostProcessingLayer;
 
-		// The output that this effect will render into
+		// The output that this effect is rendering into, this is handed out by the layer's render target
+		// pool every frame, and may be shared with other effects that aren't running at the same time
 		Framebuffer::Sptr _output = nullptr;
 		// The scaling between this effect's output and the screen size, default 1
 		glm::vec2 _outputScale = glm::vec2(1);
@@ -99,6 +102,15 @@ public:
 	 */
 	void AddEffect(const Effect::Sptr& effect);
 
+	/**
+	 * Gets the render graph that the enabled effects were run through in the last frame
+	 */
+	const RenderGraph& GetRenderGraph() const;
+	/**
+	 * Gets the pool that the effects' outputs are allocated from
+	 */
+	const RenderTargetPool& GetRenderTargetPool() const;
+
 	// Inherited from ApplicationLayer
 
 	virtual void OnAppLoad(const nlohmann::json& config) override;
@@ -112,4 +124,11 @@ protected:
 
 	std::vector<Effect::Sptr> _effects;
 	VertexArrayObject::Sptr _quadVAO;
+
+	// Every frame, each enabled effect is added to the graph as a pass that reads the previous effect's
+	// output, so effect outputs that are never needed at the same time can share a framebuffer
+	RenderGraph      _renderGraph;
+	RenderTargetPool _targetPool;
+	// Set once an invalid graph has been logged, so a broken graph doesn't flood the log every frame
+	bool             _hasReportedGraphErrors;
 };
\ No newline at end of file
@@ -9,8 +9,12 @@
 #include "Gameplay/Components/RenderComponent.h"
 #include "Gameplay/Components/Light.h"
 #include "Graphics/Buffers/UniformBuffer.h" 
+#include "Graphics/Buffers/GlFenceBackend.h"
+#include "PostProcessingLayer.h"
 
 // GLM math library
+#include <algorithm>
+#include <cstddef>
 #include <GLM/glm.hpp>
 #include <GLM/gtc/matrix_transform.hpp>
 #include <GLM/gtc/type_ptr.hpp>
@@ -26,6 +30,40 @@ RenderLayer::RenderLayer() :
 	_frameUniforms(nullptr),
 	_instanceUniforms(nullptr),
 	_renderFlags(RenderFlags::None),
+	_gBufferLayout(GBufferLayout::Full),
+	_lodPixelError(1.0f),
+	_cullingBvh(),
+	_cullingProxies(),
+	_unboundedRenderables(),
+	_visibleRenderables(),
+	_cullingFrame(0),
+	_drawCommands(),
+	_renderQueue(),
+	_shaderSortIds(),
+	_materialSortIds(),
+	_meshSortIds(),
+	_instanceBuffer(nullptr),
+	_instanceData(nullptr),
+	_instanceRing(nullptr),
+	_instanceUniformStream(nullptr),
+	_instancedShaders(),
+	_mainPassStats(),
+	_shadowPassStats(),
+	_shadowCasters(),
+	_shadowAtlas(nullptr),
+	_staticShadowAtlas(nullptr),
+	_shadowAtlasPacker(SHADOW_ATLAS_SIZE),
+	_shadowAtlasRequests(),
+	_shadowAtlasLights(),
+	_renderGraph(),
+	_targetPool(),
+	_hasReportedGraphErrors(false),
+	_lightClusterer(),
+	_clusterLightBounds(),
+	_clusterLightData(),
+	_clusterLightBuffer(nullptr),
+	_clusterBuffer(nullptr),
+	_clusterIndexBuffer(nullptr),
 	_clearColor({ 0.1f, 0.1f, 0.1f, 1.0f })
 {
 	Name = "Rendering";
@@ -88,6 +126,9 @@ void RenderLayer::OnPreRender()
 	// Draw physics debug
 	app.CurrentScene()->DrawPhysicsDebug();
 
+	// Claim the next segment of our streaming buffers for this frame
+	_BeginStreamingFrame();
+
 	_InitFrameUniforms();
 }
 
@@ -108,8 +149,12 @@ void RenderLayer::OnRender(const Framebuffer::Sptr& prevLayer)
 	// Grab shorthands to the camera and shader from the scene
 	Camera::Sptr camera = app.CurrentScene()->MainCamera;
 
+	// Make sure the culling BVH matches where objects are this frame
+	_UpdateCullingBvh();
+
 	// We can now render all our scene elements via the helper function
-	_RenderScene(camera->GetView(), camera->GetProjection(), _primaryFBO->GetSize());
+	_mainPassStats = CullingStats();
+	_RenderScene(camera->GetView(), camera->GetProjection(), _primaryFBO->GetSize(), _mainPassStats);
 
 	// Use our cubemap to draw our skybox
 	app.CurrentScene()->DrawSkybox();
@@ -123,35 +168,247 @@ void RenderLayer::OnPostRender() {
 	// Unbind our G-Buffer
 	_primaryFBO->Unbind(); 
 
-	// Composite our lighting 
-	_Composite();
+	// Shadows, lighting, and compositing run through our render graph, which also hands out the light accumulation buffer
+	_BuildRenderGraph();
+	if (!_renderGraph.Compile()) {
+		// An invalid graph means the passes were declared wrong, so report it once and run the passes as they were declared
+		if (!_hasReportedGraphErrors) {
+			for (const std::string& error : _renderGraph.GetErrors()) {
+				LOG_ERROR("Render graph: {}", error);
+			}
+			_hasReportedGraphErrors = true;
+		}
+		_renderGraph.CompileInOrder();
+	}
+	_targetPool.Realize(_renderGraph);
+	_renderGraph.Execute();
+
+	// Mark when the GPU is done reading this frame's streamed data
+	_EndStreamingFrame();
+}
 
+void RenderLayer::_BuildRenderGraph()
+{
 	Application& app = Application::Get();
-	const glm::uvec4& viewport = app.GetPrimaryViewport();
+	const glm::uvec4 viewport = app.GetPrimaryViewport();
 
-	// Restore viewport to game viewport
-	glViewport(viewport.x, viewport.y, viewport.z, viewport.w);
+	_renderGraph.Reset(glm::uvec2(_primaryFBO->GetSize()));
+	RenderGraph::Handle gBuffer = _targetPool.Import(_renderGraph, "G-Buffer", _primaryFBO);
+	RenderGraph::Handle shadowAtlas = _targetPool.Import(_renderGraph, "Shadow Atlas", _shadowAtlas);
+	RenderGraph::Handle output = _targetPool.Import(_renderGraph, "Output", _outputBuffer);
+	RenderGraph::Handle screen = _targetPool.Import(_renderGraph, "Screen", nullptr);
 
-	// Blit our depth to the primary framebuffer so that other rendering can use it
-	glBlitNamedFramebuffer(
-		_primaryFBO->GetHandle(), 0,
-		0, 0, _primaryFBO->GetWidth(), _primaryFBO->GetHeight(),
-		viewport.x, viewport.y, viewport.x + viewport.z, viewport.y + viewport.w,
-		GL_DEPTH_BUFFER_BIT,
-		GL_NEAREST
-	);
+	// The light accumulation buffer is only needed between the lighting and composite passes
+	RenderGraph::TargetDescriptor lightingDescriptor(RenderTargetType::ColorRgba8); // Diffuse
+	lightingDescriptor.Color[1] = RenderTargetType::ColorRgba8;                      // Specular
+	RenderGraph::Handle lighting = _renderGraph.CreateTarget("Lighting", lightingDescriptor);
 
-	// TODO: post processing effects
+	_renderGraph.AddPass("Shadow Maps", { }, { shadowAtlas }, [this]() {
+		// Re-render the scene for shadows
+		_RenderShadowMaps();
 
-	_outputBuffer->Unbind();
-	_outputBuffer->Bind(FramebufferBinding::Read);
-	Framebuffer::Blit(
-		{ 0, 0, _outputBuffer->GetWidth(), _outputBuffer->GetHeight() },
-		{ viewport.x, viewport.y, viewport.x + viewport.z, viewport.y + viewport.w },
-		BufferFlags::Color
-	);
+		// Restore frame level uniforms
+		_InitFrameUniforms();
+	});
 
-	_outputBuffer->Unbind();
+	_renderGraph.AddPass("Lighting", { gBuffer, shadowAtlas }, { lighting }, [this, lighting]() {
+		_lightingFBO = _targetPool.Get(lighting);
+		_AccumulateLighting();
+	});
+
+	_renderGraph.AddPass("Composite", { gBuffer, lighting }, { output }, [this]() {
+		_Composite();
+	});
+
+	_renderGraph.AddPass("Screen Depth", { gBuffer }, { screen }, [this, viewport]() {
+		// Restore viewport to game viewport
+		glViewport(viewport.x, viewport.y, viewport.z, viewport.w);
+
+		// Blit our depth to the primary framebuffer so that other rendering can use it
+		glBlitNamedFramebuffer(
+			_primaryFBO->GetHandle(), 0,
+			0, 0, _primaryFBO->GetWidth(), _primaryFBO->GetHeight(),
+			viewport.x, viewport.y, viewport.x + viewport.z, viewport.y + viewport.w,
+			GL_DEPTH_BUFFER_BIT,
+			GL_NEAREST
+		);
+	});
+
+	// The post processing layer always presents its own result over top of ours, so only present if it won't run
+	PostProcessingLayer::Sptr postProcessing = app.GetLayer<PostProcessingLayer>();
+	if (_blitFbo && (postProcessing == nullptr || !postProcessing->Enabled)) {
+		_renderGraph.AddBlit("Present", output, screen, [this, viewport]() {
+			_outputBuffer->Unbind();
+			_outputBuffer->Bind(FramebufferBinding::Read);
+			Framebuffer::Blit(
+				{ 0, 0, _outputBuffer->GetWidth(), _outputBuffer->GetHeight() },
+				{ viewport.x, viewport.y, viewport.x + viewport.z, viewport.y + viewport.w },
+				BufferFlags::Color
+			);
+
+			_outputBuffer->Unbind();
+		});
+	}
+}
+
+bool RenderLayer::_BuildLightClusters(const glm::mat4& view, const glm::mat4& projection, float zNear, float zFar)
+{
+	using namespace Gameplay;
+
+	Application& app = Application::Get();
+
+	_clusterLightBounds.clear();
+	_clusterLightData.clear();
+	app.CurrentScene()->Components().Each<Light>([&](Light& light) {
+		// Get the light's position in view space, since we're doing view space lighting
+		glm::vec4 pos = view * glm::vec4(light.GetGameObject()->GetWorldPosition(), 1.0f);
+
+		LightingUboStruct::Light data;
+		data.Position = (glm::vec3)(pos) / pos.w;
+		data.Intensity = light.GetIntensity();
+		data.Color = light.GetColor();
+		data.Attenuation = 1.0f / (1.0f + light.GetRadius());
+
+		// Lights that are too dim to be seen anywhere don't need to be shaded at all
+		float radius = LightClusterer::GetInfluenceRadius(data.Intensity, data.Color, data.Attenuation);
+		if (radius <= 0.0f) {
+			return;
+		}
+		_clusterLightData.push_back(data);
+		_clusterLightBounds.push_back({ data.Position, radius });
+	});
+
+	_lightClusterer.SetProjection(projection, zNear, zFar);
+	_lightClusterer.Build(_clusterLightBounds.data(), _clusterLightBounds.size());
+
+	const std::vector<LightCluster>& clusters = _lightClusterer.GetClusters();
+	const std::vector<uint32_t>& indices = _lightClusterer.GetLightIndices();
+	if (indices.empty()) {
+		return false;
+	}
+
+	// Upload the lights, the cluster ranges, and the index list once for the whole frame
+	_clusterLightBuffer->UpdateData(_clusterLightData.data(), sizeof(LightingUboStruct::Light), static_cast<uint32_t>(_clusterLightData.size()));
+	_clusterBuffer->UpdateData(clusters.data(), sizeof(LightCluster), static_cast<uint32_t>(clusters.size()));
+	_clusterIndexBuffer->UpdateData(indices.data(), sizeof(uint32_t), static_cast<uint32_t>(indices.size()));
+	return true;
+}
+
+void RenderLayer::_UpdateShadowAtlas()
+{
+	using namespace Gameplay;
+
+	Application& app = Application::Get();
+	Camera::Sptr camera = app.CurrentScene()->MainCamera;
+	const glm::mat4& view = camera->GetView();
+	// Scale from a view space radius to a fraction of the screen height, at a distance of 1
+	float projScale = camera->GetProjection()[1][1] * 0.5f;
+
+	_shadowAtlasRequests.clear();
+	_shadowAtlasLights.clear();
+	app.CurrentScene()->Components().Each<ShadowCamera>([&](const ShadowCamera::Sptr& shadowCam) {
+		// Cascaded lights cover the whole view, and need room for every cascade
+		if (shadowCam->GetCascadeCount() > 0) {
+			glm::uvec2 size = glm::uvec2(shadowCam->GetBufferResolution()) * shadowCam->GetCascadeGrid();
+			_shadowAtlasRequests.push_back({ shadowCam.get(), size, 1.0f });
+			_shadowAtlasLights.push_back(shadowCam.get());
+			return;
+		}
+
+		// Estimate how much of the screen the light can reach, from its range projected onto the main camera
+		glm::vec3 lightPos = view * shadowCam->GetGameObject()->GetTransform()[3];
+		float distance = glm::max(-lightPos.z, camera->GetNearPlane());
+		float coverage = glm::length(lightPos) <= shadowCam->Range ? 1.0f : glm::min(shadowCam->Range * projScale / distance, 1.0f);
+
+		// Quantize the tile size into a few steps, so that small camera movements don't re-pack the atlas
+		uint32_t shift = coverage >= 0.5f ? 0 : coverage >= 0.25f ? 1 : coverage >= 0.125f ? 2 : 3;
+		glm::uvec2 size = glm::max(glm::uvec2(shadowCam->GetBufferResolution()) >> shift, glm::uvec2(1));
+
+		_shadowAtlasRequests.push_back({ shadowCam.get(), size, coverage });
+		_shadowAtlasLights.push_back(shadowCam.get());
+	});
+
+	_shadowAtlasPacker.Update(_shadowAtlasRequests);
+
+	// Lights only see a change if their own tile moved, which is also what invalidates their cached static casters
+	const Texture2D::Sptr& atlas = _shadowAtlas->GetTextureAttachment(RenderTargetAttachment::Depth);
+	const std::vector<glm::uvec4>& tiles = _shadowAtlasPacker.GetTiles();
+	for (size_t ix = 0; ix < _shadowAtlasLights.size(); ix++) {
+		_shadowAtlasLights[ix]->SetAtlasTile(atlas, tiles[ix]);
+		// Cascades follow the main camera, so they're re-fit every frame once we know how big their tiles are
+		_shadowAtlasLights[ix]->UpdateCascades(camera->GetGameObject()->GetTransform(), camera->GetProjection(), camera->GetNearPlane(), camera->GetFarPlane());
+	}
+}
+
+void RenderLayer::_RenderShadowMaps()
+{
+	_UpdateShadowAtlas();
+	_shadowPassStats = CullingStats();
+
+	// Re-draw the static casters into the tiles whose cache has gone stale, the light or one of the static casters has changed
+	bool isStaticBound = false;
+	for (ShadowCamera* shadowCam : _shadowAtlasLights) {
+		// Cascades move with the main camera, so there's nothing worth caching for them
+		const glm::uvec4& tile = shadowCam->GetAtlasTile();
+		if (tile.z == 0 || shadowCam->GetCascadeCount() > 0) {
+			continue;
+		}
+		if (shadowCam->IsStaticCacheValid(_shadowCasters.GetStaticVersion())) {
+			_shadowPassStats.CachedPasses++;
+			continue;
+		}
+		if (!isStaticBound) {
+			_staticShadowAtlas->Bind();
+			isStaticBound = true;
+		}
+
+		// Only clear our own tile, the rest of the atlas belongs to other lights
+		glViewport(tile.x, tile.y, tile.z, tile.w);
+		glEnable(GL_SCISSOR_TEST);
+		glScissor(tile.x, tile.y, tile.z, tile.w);
+		glClear(GL_DEPTH_BUFFER_BIT);
+		glDisable(GL_SCISSOR_TEST);
+
+		_RenderScene(shadowCam->GetGameObject()->GetInverseTransform(), shadowCam->GetProjection(), glm::ivec2(tile.z, tile.w), _shadowPassStats, CasterFilter::Static);
+		shadowCam->MarkStaticCacheBuilt(_shadowCasters.GetStaticVersion());
+	}
+
+	// Start each tile from its cached depth, and draw the casters that may have moved over top of it
+	_shadowAtlas->Bind();
+	for (ShadowCamera* shadowCam : _shadowAtlasLights) {
+		const glm::uvec4& tile = shadowCam->GetAtlasTile();
+		if (tile.z == 0) {
+			continue;
+		}
+
+		// Each cascade only draws the casters that fall inside its own projection
+		if (shadowCam->GetCascadeCount() > 0) {
+			glEnable(GL_SCISSOR_TEST);
+			glScissor(tile.x, tile.y, tile.z, tile.w);
+			glClear(GL_DEPTH_BUFFER_BIT);
+			glDisable(GL_SCISSOR_TEST);
+
+			for (uint32_t cascadeIx = 0; cascadeIx < shadowCam->GetCascadeCount(); cascadeIx++) {
+				const ShadowCascades::Cascade& cascade = shadowCam->GetCascade(cascadeIx);
+				glm::uvec4 cascadeTile = shadowCam->GetCascadeTile(cascadeIx);
+				glViewport(cascadeTile.x, cascadeTile.y, cascadeTile.z, cascadeTile.w);
+				_RenderScene(cascade.View, cascade.Projection, glm::ivec2(cascadeTile.z, cascadeTile.w), _shadowPassStats, CasterFilter::All);
+			}
+			continue;
+		}
+
+		glBlitNamedFramebuffer(
+			_staticShadowAtlas->GetHandle(), _shadowAtlas->GetHandle(),
+			tile.x, tile.y, tile.x + tile.z, tile.y + tile.w,
+			tile.x, tile.y, tile.x + tile.z, tile.y + tile.w,
+			GL_DEPTH_BUFFER_BIT,
+			GL_NEAREST
+		);
+		glViewport(tile.x, tile.y, tile.z, tile.w);
+		_RenderScene(shadowCam->GetGameObject()->GetInverseTransform(), shadowCam->GetProjection(), glm::ivec2(tile.z, tile.w), _shadowPassStats, CasterFilter::Dynamic);
+	}
+
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
 }
 
 void RenderLayer::_AccumulateLighting()
@@ -200,80 +457,44 @@ void RenderLayer::_AccumulateLighting()
 	_primaryFBO->GetTextureAttachment(RenderTargetAttachment::Color0)->Bind(1); // albedo + spec
 	_primaryFBO->GetTextureAttachment(RenderTargetAttachment::Color1)->Bind(2); // normals + metallic
 	_primaryFBO->GetTextureAttachment(RenderTargetAttachment::Color2)->Bind(3); // emissive
-	_primaryFBO->GetTextureAttachment(RenderTargetAttachment::Color3)->Bind(4); // view pos
+	_primaryFBO->BindAttachment(RenderTargetAttachment::Color3, 4);            // view pos (full layout only)
 
 
 	// Send in how many active lights we have and the global lighting settings
 	data.AmbientCol = glm::vec3(0.1f);
-	int ix = 0;
-	app.CurrentScene()->Components().Each<Light>([&](const Light::Sptr& light) {
-		// Get the light's position in view space, since we're doing view space lighting
-		glm::vec4 pos = glm::vec4(light->GetGameObject()->GetWorldPosition(), 1.0f);
-		pos = view * pos;
-
-		// Copy to the ubo data
-		data.Lights[ix].Position = (glm::vec3)(pos) / pos.w;
-		data.Lights[ix].Intensity = light->GetIntensity();
-		data.Lights[ix].Color = light->GetColor();
-		data.Lights[ix].Attenuation = 1.0f / (1.0f + light->GetRadius());  
-
-		ix++;
-
-		// If we've reached the max # of lights the shader supports, draw to the screen and start the next batch
-		if (ix == MAX_LIGHTS) {
-			data.NumLights = MAX_LIGHTS;
-
-			// Send updated data to OpenGL
-			_lightingUbo->Update();
-
-			// Draw the fullscreen quad to accumulate the lights
-			_fullscreenQuad->Draw();
-
-			ix = 0;
-		}
-	});
 
-	// If we have lights left over that haven't been drawn, draw them now
-	if (ix > 0) {
-		data.NumLights = ix;
-
-		// Send updated data to OpenGL
-		_lightingUbo->Update();
+	// Assign every light to the clusters it touches, so each pixel only evaluates the lights that can reach it,
+	// and the whole scene's lighting is done in one fullscreen pass
+	if (_BuildLightClusters(view, camera->GetProjection(), camera->GetNearPlane(), camera->GetFarPlane())) {
+		_lightAccumulationShader->SetUniform("u_ClusterGridSize", _lightClusterer.GetGridSize());
+		_lightAccumulationShader->SetUniform("u_ClusterDepthParams", _lightClusterer.GetDepthSliceParams());
+		_clusterLightBuffer->Bind(CLUSTER_LIGHTS_BINDING);
+		_clusterBuffer->Bind(CLUSTERS_BINDING);
+		_clusterIndexBuffer->Bind(CLUSTER_INDICES_BINDING);
 
 		// Draw the fullscreen quad to accumulate the lights
 		_fullscreenQuad->Draw();
 	}
 
-	// Re-render the scene for shadows
-	app.CurrentScene()->Components().Each<ShadowCamera>([&](const ShadowCamera::Sptr& shadowCam) {
-		// Bind the shadow camera's depth buffer and clear it
-		shadowCam->GetDepthBuffer()->Bind();
-		glClear(GL_DEPTH_BUFFER_BIT);
-		glViewport(0, 0, shadowCam->GetBufferResolution().x, shadowCam->GetBufferResolution().y);
-
-		_RenderScene(shadowCam->GetGameObject()->GetInverseTransform(), shadowCam->GetProjection(), shadowCam->GetDepthBuffer()->GetSize());
-
-		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
-	});
-
-	// Restore frame level uniforms
-	_InitFrameUniforms();
-
-	_lightingFBO->Bind();
-	glViewport(0, 0, _lightingFBO->GetWidth(), _lightingFBO->GetHeight());
-
-	// Bind our G-Buffer textures so that they're readable
-	_primaryFBO->GetTextureAttachment(RenderTargetAttachment::Depth)->Bind(0);  // depth
-	_primaryFBO->GetTextureAttachment(RenderTargetAttachment::Color0)->Bind(1); // albedo + spec
-	_primaryFBO->GetTextureAttachment(RenderTargetAttachment::Color1)->Bind(2); // normals + metallic
-	_primaryFBO->GetTextureAttachment(RenderTargetAttachment::Color2)->Bind(3); // emissive
-	_primaryFBO->GetTextureAttachment(RenderTargetAttachment::Color3)->Bind(4); // view pos
+	// Forward shaders still read a fixed number of lights from the lighting UBO
+	data.NumLights = static_cast<float>(std::min<size_t>(_clusterLightData.size(), MAX_LIGHTS));
+	std::copy_n(_clusterLightData.begin(), static_cast<size_t>(data.NumLights), data.Lights);
+	_lightingUbo->Update();
 
+	// The shadow maps were already drawn by the shadow pass, so the lighting FBO and G-Buffer are still bound.
 	// Bind shadow composite shader
 	_shadowShader->Bind();
 
+	// Every light reads its depth from its own tile of the atlas, so we only need to bind it once
+	_shadowAtlas->BindAttachment(RenderTargetAttachment::Depth, 5);
+
 	// Add each shadow casting light to the lighting buffers
-	app.CurrentScene()->Components().Each<ShadowCamera>([&](const ShadowCamera::Sptr& shadowCam) {
+	for (ShadowCamera* shadowCam : _shadowAtlasLights) {
+		// Lights that didn't fit in the atlas have no shadow map to draw with
+		const glm::uvec4& tile = shadowCam->GetAtlasTile();
+		if (tile.z == 0) {
+			continue;
+		}
 
 		// This gets us the light -> view space matrix, which we'll inverse to go from view space to light space
 		glm::mat4 lightSpaceMatrix = camera->GetView() * shadowCam->GetGameObject()->GetTransform();
@@ -285,14 +506,33 @@ void RenderLayer::_AccumulateLighting()
 		glm::vec3 lightDirViewSpace = glm::mat3(lightSpaceMatrix) * glm::vec3(0, 0, -1.0f); 
 		glm::vec3 lightPosViewSpace = lightSpaceMatrix * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
 
-		// Bind depth and projection mask for reading, making sure not to stomp G-Buffer bindings
-		shadowCam->GetDepthBuffer()->BindAttachment(RenderTargetAttachment::Depth, 5);
+		// Bind projection mask for reading, making sure not to stomp G-Buffer bindings
 		if (shadowCam->GetProjectionMask() != nullptr) {
 			shadowCam->GetProjectionMask()->Bind(6);
 		}
 
 		//_shadowShader->SetUniformMatrix("u_ClipToShadow", clipToShadow); 
 		_shadowShader->SetUniformMatrix("u_ViewToShadow", viewToShadow); 
+		_shadowShader->SetUniform("u_ShadowAtlasRect", glm::vec4(tile) / static_cast<float>(SHADOW_ATLAS_SIZE));
+
+		// Cascaded lights pick the cascade to sample from by each pixel's depth
+		uint32_t cascadeCount = shadowCam->GetCascadeCount();
+		_shadowShader->SetUniform("u_CascadeCount", cascadeCount);
+		if (cascadeCount > 0) {
+			glm::mat4 cameraTransform = camera->GetGameObject()->GetTransform();
+			glm::mat4 cascadeViewToShadow[ShadowCascades::MAX_CASCADES];
+			glm::vec4 cascadeRects[ShadowCascades::MAX_CASCADES];
+			glm::vec4 cascadeSplits = glm::vec4(0.0f);
+			for (uint32_t ix = 0; ix < cascadeCount; ix++) {
+				const ShadowCascades::Cascade& cascade = shadowCam->GetCascade(ix);
+				cascadeViewToShadow[ix] = cascade.Projection * cascade.View * cameraTransform;
+				cascadeRects[ix] = glm::vec4(shadowCam->GetCascadeTile(ix)) / static_cast<float>(SHADOW_ATLAS_SIZE);
+				cascadeSplits[ix] = cascade.SplitFar;
+			}
+			_shadowShader->SetUniformMatrix("u_CascadeViewToShadow", cascadeViewToShadow, cascadeCount);
+			_shadowShader->SetUniform("u_CascadeAtlasRect", cascadeRects, cascadeCount);
+			_shadowShader->SetUniform("u_CascadeSplits", cascadeSplits);
+		}
 
 		// Get color and normalize it (strip the alpha)
 		glm::vec4 color = shadowCam->GetColor();
@@ -309,7 +549,7 @@ void RenderLayer::_AccumulateLighting()
 
 		// Draw the fullscreen quad to accumulate the lights
 		_fullscreenQuad->Draw();
-	});
+	}
 
 	// Unbind the lighting FBO so we can read its textures
 	_lightingFBO->Unbind();
@@ -322,8 +562,6 @@ void RenderLayer::_Composite()
 
 	Scene::Sptr& scene = app.CurrentScene();
 
-	_AccumulateLighting();
-
 	// We want to switch to our compositing shader
 	_compositingShader->Bind();
 
@@ -386,13 +624,43 @@ void RenderLayer::_ClearFramebuffer(Framebuffer::Sptr& buffer, const glm::vec4*
 	glDepthFunc(GL_LESS);
 }
 
+void RenderLayer::_CreateGBuffer(const glm::ivec2& size)
+{
+	FramebufferDescriptor fboDescriptor;
+	fboDescriptor.Width = size.x;
+	fboDescriptor.Height = size.y;
+
+	// We want to use a 32 bit depth buffer, we'll ignore the stencil buffer for now
+	fboDescriptor.RenderTargets[RenderTargetAttachment::Depth] = RenderTargetDescriptor(RenderTargetType::Depth32);
+	// Color layer 0 (albedo, specular)
+	fboDescriptor.RenderTargets[RenderTargetAttachment::Color0] = RenderTargetDescriptor(RenderTargetType::ColorRgba8);
+
+	if (_gBufferLayout == GBufferLayout::Compact) {
+		// Color layer 1 (octahedral normals)
+		fboDescriptor.RenderTargets[RenderTargetAttachment::Color1] = RenderTargetDescriptor(RenderTargetType::ColorRG16);
+		// Color layer 2 (pre-multiplied emissive, metallic)
+		fboDescriptor.RenderTargets[RenderTargetAttachment::Color2] = RenderTargetDescriptor(RenderTargetType::ColorRgba8);
+		// View space position is rebuilt from depth
+	} else {
+		// Color layer 1 (normals, metallic)
+		fboDescriptor.RenderTargets[RenderTargetAttachment::Color1] = RenderTargetDescriptor(RenderTargetType::ColorRgba8);
+		// Color layer 2 (emissive)  
+		fboDescriptor.RenderTargets[RenderTargetAttachment::Color2] = RenderTargetDescriptor(RenderTargetType::ColorRgba8);
+		// Color layer 3 (view space position)  
+		fboDescriptor.RenderTargets[RenderTargetAttachment::Color3] = RenderTargetDescriptor(RenderTargetType::ColorRgba16F);
+	}
+
+	_primaryFBO = std::make_shared<Framebuffer>(fboDescriptor);
+	LOG_INFO("Created {} G-buffer, {} bytes per pixel", ~_gBufferLayout, GetGBufferPixelSize());
+}
+
 void RenderLayer::OnWindowResize(const glm::ivec2& oldSize, const glm::ivec2& newSize)
 {
 	if (newSize.x * newSize.y == 0) return;
 
-	// Set viewport and resize our primary FBO and light accumulation FBO
+	// Set viewport and resize our primary FBO and output FBO, the render target pool resizes the light
+	// accumulation FBO when it is next used
 	_primaryFBO->Resize(newSize);
-	_lightingFBO->Resize(newSize);
 	_outputBuffer->Resize(newSize);
 
 	// Update the main camera's projection
@@ -419,33 +687,13 @@ void RenderLayer::OnAppLoad(const nlohmann::json& config)
 	glEnable(GL_CULL_FACE);
 	glCullFace(GL_BACK);
 
-	// Create a new descriptor for our FBO
+	// Create the primary FBO
+	_CreateGBuffer(app.GetWindowSize());
+
+	// Create an FBO to store final output, the light accumulation FBO comes from our render target pool
 	FramebufferDescriptor fboDescriptor;
 	fboDescriptor.Width = app.GetWindowSize().x;
 	fboDescriptor.Height = app.GetWindowSize().y;
-
-	// We want to use a 32 bit depth buffer, we'll ignore the stencil buffer for now
-	fboDescriptor.RenderTargets[RenderTargetAttachment::Depth] = RenderTargetDescriptor(RenderTargetType::Depth32);
-	// Color layer 0 (albedo, specular)
-	fboDescriptor.RenderTargets[RenderTargetAttachment::Color0] = RenderTargetDescriptor(RenderTargetType::ColorRgba8);
-	// Color layer 1 (normals, metallic)
-	fboDescriptor.RenderTargets[RenderTargetAttachment::Color1] = RenderTargetDescriptor(RenderTargetType::ColorRgba8);
-	// Color layer 2 (emissive)  
-	fboDescriptor.RenderTargets[RenderTargetAttachment::Color2] = RenderTargetDescriptor(RenderTargetType::ColorRgba8);
-	// Color layer 3 (view space position)  
-	fboDescriptor.RenderTargets[RenderTargetAttachment::Color3] = RenderTargetDescriptor(RenderTargetType::ColorRgba16F);
-	 
-	// Create the primary FBO
-	_primaryFBO = std::make_shared<Framebuffer>(fboDescriptor);
-
-	fboDescriptor.RenderTargets.clear();
-	fboDescriptor.RenderTargets[RenderTargetAttachment::Color0] = RenderTargetDescriptor(RenderTargetType::ColorRgba8); // Diffuse
-	fboDescriptor.RenderTargets[RenderTargetAttachment::Color1] = RenderTargetDescriptor(RenderTargetType::ColorRgba8); // Specular
-
-	_lightingFBO = std::make_shared<Framebuffer>(fboDescriptor);
-
-	// Create an FBO to store final output
-	fboDescriptor.RenderTargets.clear();
 	fboDescriptor.RenderTargets[RenderTargetAttachment::Depth] = RenderTargetDescriptor(RenderTargetType::Depth32);
 	fboDescriptor.RenderTargets[RenderTargetAttachment::Color0] = RenderTargetDescriptor(RenderTargetType::ColorRgba8);
 
@@ -472,6 +720,16 @@ void RenderLayer::OnAppLoad(const nlohmann::json& config)
 	_shadowShader->LoadShaderPartFromFile("shaders/fragment_shaders/shadow_composite.glsl", ShaderPartType::Fragment);
 	_shadowShader->Link();
 
+	// Every shadow casting light renders into a tile of the shadow atlas, with the static casters cached in a second atlas
+	FramebufferDescriptor atlasDescriptor;
+	atlasDescriptor.Width  = SHADOW_ATLAS_SIZE;
+	atlasDescriptor.Height = SHADOW_ATLAS_SIZE;
+	atlasDescriptor.RenderTargets[RenderTargetAttachment::Depth] = RenderTargetDescriptor(RenderTargetType::Depth32, true, true);
+	_shadowAtlas = std::make_shared<Framebuffer>(atlasDescriptor);
+
+	atlasDescriptor.RenderTargets[RenderTargetAttachment::Depth] = RenderTargetDescriptor(RenderTargetType::Depth32, true, false);
+	_staticShadowAtlas = std::make_shared<Framebuffer>(atlasDescriptor);
+
 	// We need a mesh for drawing fullscreen quads
 
 	glm::vec2 positions[6] = {
@@ -491,6 +749,15 @@ void RenderLayer::OnAppLoad(const nlohmann::json& config)
 	_frameUniforms = std::make_shared<UniformBuffer<FrameLevelUniforms>>(BufferUsage::DynamicDraw);
 	_instanceUniforms = std::make_shared<UniformBuffer<InstanceLevelUniforms>>(BufferUsage::DynamicDraw);
 	_lightingUbo = std::make_shared<UniformBuffer<LightingUboStruct>>(BufferUsage::DynamicDraw);
+
+	// Create the storage buffers for clustered lighting, these grow to fit the scene's lights
+	_clusterLightBuffer = ShaderStorageBuffer::Create(BufferUsage::DynamicDraw);
+	_clusterBuffer = ShaderStorageBuffer::Create(BufferUsage::DynamicDraw);
+	_clusterIndexBuffer = ShaderStorageBuffer::Create(BufferUsage::DynamicDraw);
+
+	// Create the buffers we'll stream instance data and per-draw uniforms into
+	_CreateInstanceBuffer(4096);
+	_instanceUniformStream = StreamingUniformBuffer::Create(1024 * sizeof(InstanceLevelUniforms), FRAMES_IN_FLIGHT);
 }
 
 const Framebuffer::Sptr& RenderLayer::GetPrimaryFBO() const {
@@ -498,7 +765,7 @@ const Framebuffer::Sptr& RenderLayer::GetPrimaryFBO() const {
 }
 
 bool RenderLayer::IsBlitEnabled() const {
-	return false;
+	return _blitFbo;
 }
 
 void RenderLayer::SetBlitEnabled(bool value) {
@@ -525,10 +792,67 @@ RenderFlags RenderLayer::GetRenderFlags() const {
 	return _renderFlags;
 }
 
+GBufferLayout RenderLayer::GetGBufferLayout() const {
+	return _gBufferLayout;
+}
+
+void RenderLayer::SetGBufferLayout(GBufferLayout value) {
+	if (value == _gBufferLayout) {
+		return;
+	}
+	_gBufferLayout = value;
+	if (_primaryFBO != nullptr) {
+		_CreateGBuffer(_primaryFBO->GetSize());
+	}
+}
+
+uint32_t RenderLayer::GetGBufferPixelSize() const {
+	uint32_t result = 0;
+	for (RenderTargetAttachment attachment : { RenderTargetAttachment::Depth, RenderTargetAttachment::Color0, RenderTargetAttachment::Color1, RenderTargetAttachment::Color2, RenderTargetAttachment::Color3 }) {
+		Texture2D::Sptr texture = _primaryFBO->GetTextureAttachment(attachment);
+		if (texture != nullptr) {
+			result += GetRenderTargetPixelSize((RenderTargetType)*texture->GetFormat());
+		}
+	}
+	return result;
+}
+
+float RenderLayer::GetLodPixelError() const {
+	return _lodPixelError;
+}
+
+void RenderLayer::SetLodPixelError(float value) {
+	_lodPixelError = value;
+}
+
+const RenderLayer::CullingStats& RenderLayer::GetMainPassStats() const {
+	return _mainPassStats;
+}
+
+const RenderLayer::CullingStats& RenderLayer::GetShadowPassStats() const {
+	return _shadowPassStats;
+}
+
+const LightClusterer& RenderLayer::GetLightClusterer() const {
+	return _lightClusterer;
+}
+
+const ShadowAtlasPacker& RenderLayer::GetShadowAtlasPacker() const {
+	return _shadowAtlasPacker;
+}
+
 const Framebuffer::Sptr& RenderLayer::GetLightingBuffer() const {
 	return _lightingFBO;
 }
 
+const RenderGraph& RenderLayer::GetRenderGraph() const {
+	return _renderGraph;
+}
+
+const RenderTargetPool& RenderLayer::GetRenderTargetPool() const {
+	return _targetPool;
+}
+
 const Framebuffer::Sptr& RenderLayer::GetGBuffer() const
 {
 	return _primaryFBO;
@@ -556,7 +880,7 @@ void RenderLayer::_InitFrameUniforms()
 	frameData.u_CameraPos = glm::vec4(camera->GetGameObject()->GetPosition(), 1.0f);
 	frameData.u_Time = static_cast<float>(Timing::Current().TimeSinceSceneLoad());
 	frameData.u_DeltaTime = Timing::Current().DeltaTime();
-	frameData.u_RenderFlags = _renderFlags;
+	frameData.u_RenderFlags = _renderFlags | (_gBufferLayout == GBufferLayout::Compact ? RenderFlags::CompactGBuffer : RenderFlags::None);
 	frameData.u_ZNear = camera->GetNearPlane();
 	frameData.u_ZFar = camera->GetFarPlane();
 	frameData.u_Viewport = { 0.0f, 0.0f, _primaryFBO->GetWidth(), _primaryFBO->GetHeight() };
@@ -567,7 +891,57 @@ void RenderLayer::_InitFrameUniforms()
 	_frameUniforms->Update();
 }
 
-void RenderLayer::_RenderScene(const glm::mat4& view, const glm::mat4& projection, const glm::ivec2& screenSize)
+void RenderLayer::_UpdateCullingBvh()
+{
+	using namespace Gameplay;
+
+	Application& app = Application::Get();
+
+	_cullingFrame++;
+	_unboundedRenderables.clear();
+	_shadowCasters.BeginFrame();
+
+	// Insert new renderers, and move any existing ones that have left their fat bounds
+	app.CurrentScene()->Components().Each<RenderComponent>([&](RenderComponent& renderable) {
+		if (renderable.GetMesh() == nullptr) {
+			return;
+		}
+
+		// Keep track of which casters have stopped moving, so their shadows can be cached
+		_shadowCasters.Track(&renderable, renderable.GetGameObject()->GetTransformVersion(), renderable.GetShadowMode());
+
+		AABB bounds = renderable.GetWorldBounds();
+		if (!bounds.IsValid()) {
+			_unboundedRenderables.push_back(&renderable);
+			return;
+		}
+
+		auto it = _cullingProxies.find(&renderable);
+		if (it == _cullingProxies.end()) {
+			CullingProxy proxy;
+			proxy.Proxy = _cullingBvh.Insert(bounds, &renderable);
+			proxy.LastSeenFrame = _cullingFrame;
+			_cullingProxies[&renderable] = proxy;
+		} else {
+			_cullingBvh.Update(it->second.Proxy, bounds);
+			it->second.LastSeenFrame = _cullingFrame;
+		}
+	});
+
+	_shadowCasters.EndFrame();
+
+	// Anything we didn't see this frame has been destroyed, disabled, or lost its bounds
+	for (auto it = _cullingProxies.begin(); it != _cullingProxies.end();) {
+		if (it->second.LastSeenFrame != _cullingFrame) {
+			_cullingBvh.Remove(it->second.Proxy);
+			it = _cullingProxies.erase(it);
+		} else {
+			it++;
+		}
+	}
+}
+
+void RenderLayer::_RenderScene(const glm::mat4& view, const glm::mat4& projection, const glm::ivec2& screenSize, CullingStats& stats, CasterFilter filter)
 {
 	using namespace Gameplay;
 
@@ -576,8 +950,10 @@ void RenderLayer::_RenderScene(const glm::mat4& view, const glm::mat4& projectio
 	glm::mat4 viewProj = projection * view;
 
 	// The current material that is bound for rendering
-	Material::Sptr currentMat = nullptr;
-	ShaderProgram::Sptr shader = nullptr;
+	// The shader that is bound, and the material and shader that material parameters were last sent to
+	ShaderProgram* boundShader = nullptr;
+	Material*      appliedMat = nullptr;
+	ShaderProgram* appliedShader = nullptr;
 
 	Material::Sptr defaultMat = app.CurrentScene()->DefaultMaterial;
 
@@ -589,13 +965,36 @@ void RenderLayer::_RenderScene(const glm::mat4& view, const glm::mat4& projectio
 	frameData.u_Viewport = { 0.0f, 0.0f, screenSize.x, screenSize.y };
 	_frameUniforms->Update();
 
-	// Render all our objects
-	app.CurrentScene()->Components().Each<RenderComponent>([&](const RenderComponent::Sptr& renderable) {
-		// Early bail if mesh not set
-		if (renderable->GetMesh() == nullptr) {
-			return;
-		}
+	// Gather the objects that are inside the frustum, objects without bounds are always drawn
+	_visibleRenderables.assign(_unboundedRenderables.begin(), _unboundedRenderables.end());
+	stats.NodesTested += _cullingBvh.Query(Frustum(viewProj), [&](void* userData) {
+		_visibleRenderables.push_back(static_cast<RenderComponent*>(userData));
+	});
+	uint32_t candidates = _cullingBvh.GetProxyCount() + static_cast<uint32_t>(_unboundedRenderables.size());
+	stats.Tested += candidates;
+	stats.Culled += candidates - static_cast<uint32_t>(_visibleRenderables.size());
+
+	// Shadow passes may only want the static or dynamic casters
+	if (filter != CasterFilter::All) {
+		bool wantStatic = filter == CasterFilter::Static;
+		_visibleRenderables.erase(std::remove_if(_visibleRenderables.begin(), _visibleRenderables.end(), [&](RenderComponent* renderable) {
+			return _shadowCasters.IsStatic(renderable) != wantStatic;
+		}), _visibleRenderables.end());
+	}
 
+	// Gives each unique shader, material, or mesh in this pass a small ID to sort by
+	auto getSortId = [](std::unordered_map<const void*, uint32_t>& ids, const void* ptr) {
+		return ids.emplace(ptr, static_cast<uint32_t>(ids.size())).first->second;
+	};
+	_shaderSortIds.clear();
+	_materialSortIds.clear();
+	_meshSortIds.clear();
+
+	// Build a draw command and sort key for all our visible objects
+	_drawCommands.clear();
+	_renderQueue.Clear();
+	_renderQueue.Reserve(_visibleRenderables.size());
+	for (RenderComponent* renderable : _visibleRenderables) {
 		// If we don't have a material, try getting the scene's fallback material
 		// If none exists, do not draw anything
 		if (renderable->GetMaterial() == nullptr) {
@@ -603,36 +1002,198 @@ void RenderLayer::_RenderScene(const glm::mat4& view, const glm::mat4& projectio
 				renderable->SetMaterial(defaultMat);
 			}
 			else {
-				return;
+				continue;
 			}
 		}
+		const Material::Sptr& material = renderable->GetMaterial();
 
-		// If the material has changed, we need to bind the new shader and set up our material and frame data
-		// Note: This is a good reason why we should be sorting the render components in ComponentManager
-		if (renderable->GetMaterial() != currentMat) {
-			currentMat = renderable->GetMaterial();
-			shader = currentMat->GetShader();
+		// Select a simpler level of detail if the object is small on screen
+		GameObject* object = renderable->GetGameObject();
+		glm::mat4 modelView = view * object->GetTransform();
+		VertexArrayObject* mesh = renderable->GetMesh(modelView, projection, static_cast<float>(screenSize.y), _lodPixelError).get();
+
+		// Sort by the distance to the center of the object along the view direction
+		AABB bounds = renderable->GetMeshResource()->Bounds;
+		glm::vec3 center = bounds.IsValid() ? bounds.GetCenter() : glm::vec3(0.0f);
+		float depth = -(modelView * glm::vec4(center, 1.0f)).z;
+
+		uint64_t key = RenderQueue::MakeKey(
+			material->IsTransparent ? RenderBucket::Transparent : RenderBucket::Opaque,
+			getSortId(_shaderSortIds, material->GetShader().get()),
+			getSortId(_materialSortIds, material.get()),
+			getSortId(_meshSortIds, mesh),
+			depth
+		);
+		_renderQueue.Push(key, static_cast<uint32_t>(_drawCommands.size()));
+		_drawCommands.push_back({ renderable, mesh, modelView });
+	}
+	_renderQueue.Sort();
+
+	// Submit in sorted order. Runs of draws that share a mesh and material are drawn with a single instanced
+	// draw if their shader supports it, and otherwise we only switch shaders and materials once per run
+	const std::vector<RenderQueue::Item>& items = _renderQueue.GetItems();
+	for (size_t ix = 0; ix < items.size();) {
+		const DrawCommand& command = _drawCommands[items[ix].Payload];
+		const Material::Sptr& material = command.Renderable->GetMaterial();
+
+		// Find the end of the run of draws that use the same mesh and material
+		size_t runEnd = _renderQueue.GetRunEnd(ix, [&](const RenderQueue::Item&, const RenderQueue::Item& next) {
+			const DrawCommand& nextCommand = _drawCommands[next.Payload];
+			return nextCommand.Mesh == command.Mesh && nextCommand.Renderable->GetMaterial() == material;
+		});
+		uint32_t runLength = static_cast<uint32_t>(runEnd - ix);
+
+		// Use the instanced variant of the shader if we can, falling back to drawing objects one by one
+		const ShaderProgram::Sptr* shader = &material->GetShader();
+		uint32_t instanceOffset = FrameRing::INVALID_OFFSET;
+		if (runLength >= MIN_INSTANCE_RUN) {
+			const ShaderProgram::Sptr& variant = _GetInstancedShader(material->GetShader());
+			if (variant != nullptr) {
+				instanceOffset = _instanceRing->Allocate(runLength * sizeof(InstanceData));
+				if (instanceOffset != FrameRing::INVALID_OFFSET) {
+					shader = &variant;
+				}
+			}
+		}
+		bool instanced = instanceOffset != FrameRing::INVALID_OFFSET;
 
-			shader->Bind();
-			currentMat->Apply();
+		if (shader->get() != boundShader) {
+			boundShader = shader->get();
+			boundShader->Bind();
+		}
+		if (material.get() != appliedMat || shader->get() != appliedShader) {
+			appliedMat = material.get();
+			appliedShader = shader->get();
+			material->Apply(*shader);
 		}
 
-		// Grab the game object so we can do some stuff with it
-		GameObject* object = renderable->GetGameObject();
+		if (instanced) {
+			// Pack the run's transforms straight into this frame's segment of the instance buffer
+			uint32_t baseInstance = instanceOffset / sizeof(InstanceData);
+			for (size_t runIx = ix; runIx < runEnd; runIx++) {
+				const DrawCommand& instance = _drawCommands[items[runIx].Payload];
+				InstancePacker::Pack(instance.Renderable->GetGameObject()->GetTransform(), _instanceData[baseInstance + (runIx - ix)]);
+			}
+
+			_AttachInstanceBuffer(command.Mesh);
+			command.Mesh->DrawInstanced(runLength, baseInstance);
+			stats.Drawn += runLength;
+			stats.DrawCalls++;
+		} else {
+			for (size_t runIx = ix; runIx < runEnd; runIx++) {
+				const DrawCommand& single = _drawCommands[items[runIx].Payload];
+
+				const glm::mat4& transform = single.Renderable->GetGameObject()->GetTransform();
+				InstanceLevelUniforms instanceData;
+				instanceData.u_Model = transform;
+				instanceData.u_ModelViewProjection = projection * single.ModelView;
+				instanceData.u_ModelView = single.ModelView;
+				instanceData.u_NormalMatrix = glm::mat3(glm::transpose(glm::inverse(transform)));
+
+				// Stream the uniforms into their own slot, and only fall back to a synchronous update if the stream is full
+				if (!_instanceUniformStream->Push(instanceData, INSTANCE_UBO_BINDING)) {
+					_instanceUniforms->SetData(instanceData);
+					_instanceUniforms->Bind(INSTANCE_UBO_BINDING);
+				}
+
+				single.Mesh->Draw();
+				stats.Drawn++;
+				stats.DrawCalls++;
+			}
+		}
 
-		// Use our uniform buffer for our instance level uniforms
-		auto& instanceData = _instanceUniforms->GetData();
-		instanceData.u_Model = object->GetTransform();
-		instanceData.u_ModelViewProjection = viewProj * object->GetTransform();
-		instanceData.u_ModelView = view * object->GetTransform();
-		instanceData.u_NormalMatrix = glm::mat3(glm::transpose(glm::inverse(object->GetTransform())));
-		_instanceUniforms->Update();
+		ix = runEnd;
+	}
 
-		// Draw the object
-		renderable->GetMesh()->Draw();
+	// Anything else that draws after us expects the regular instance UBO to be bound
+	_instanceUniforms->Bind(INSTANCE_UBO_BINDING);
+}
 
-	});
+void RenderLayer::_CreateInstanceBuffer(uint32_t capacity)
+{
+	// Make sure the GPU is done with the old buffer before we drop it
+	if (_instanceRing != nullptr) {
+		_instanceRing->WaitForAll();
+	}
+	_instanceRing = std::make_unique<FrameRing>(GlFenceBackend::Get(), capacity * sizeof(InstanceData), FRAMES_IN_FLIGHT, sizeof(InstanceData));
+
+	// Persistently mapped and coherent, so we can write instances at any time without mapping or flushing
+	_instanceBuffer = VertexBuffer::Create(BufferUsage::StreamDraw);
+	_instanceBuffer->SetDebugName("Instance Buffer");
+	_instanceBuffer->AllocateStorage(nullptr, sizeof(InstanceData), capacity * FRAMES_IN_FLIGHT,
+		BufferStorageFlags::MapWrite | BufferStorageFlags::MapPersistent | BufferStorageFlags::MapCoherent);
+	_instanceData = reinterpret_cast<InstanceData*>(_instanceBuffer->MapRange(0, _instanceBuffer->GetTotalSize(),
+		BufferMapMode::Write | BufferMapMode::Persistent | BufferMapMode::Coherent));
+}
 
+void RenderLayer::_BeginStreamingFrame()
+{
+	// If we ran out of room last frame, grow the buffers. This waits for the GPU to finish with the old ones
+	if (_instanceRing->HasOverflowed()) {
+		uint32_t capacity = _instanceRing->GetSegmentSize() / sizeof(InstanceData);
+		LOG_INFO("Expanding instance buffer from {} to {} instances per frame", capacity, capacity * 2);
+		_CreateInstanceBuffer(capacity * 2);
+	}
+	if (_instanceUniformStream->GetRing().HasOverflowed()) {
+		uint32_t size = _instanceUniformStream->GetRing().GetSegmentSize();
+		LOG_INFO("Expanding streaming uniform buffer from {} to {} bytes per frame", size, size * 2);
+		_instanceUniformStream = StreamingUniformBuffer::Create(size * 2, FRAMES_IN_FLIGHT);
+	}
+
+	_instanceRing->BeginFrame();
+	_instanceUniformStream->BeginFrame();
+}
+
+void RenderLayer::_EndStreamingFrame()
+{
+	_instanceRing->EndFrame();
+	_instanceUniformStream->EndFrame();
+}
+
+void RenderLayer::_AttachInstanceBuffer(VertexArrayObject* mesh)
+{
+	// Matches the inModelTransform and inNormalMatrix attributes in fragments/vs_common.glsl
+	static const std::vector<BufferAttribute> instanceAttributes = {
+		BufferAttribute(8,  4, AttributeType::Float, sizeof(InstanceData), offsetof(InstanceData, Model) + 0  * sizeof(float), AttribUsage::InstanceTransform),
+		BufferAttribute(9,  4, AttributeType::Float, sizeof(InstanceData), offsetof(InstanceData, Model) + 4  * sizeof(float), AttribUsage::InstanceTransform),
+		BufferAttribute(10, 4, AttributeType::Float, sizeof(InstanceData), offsetof(InstanceData, Model) + 8  * sizeof(float), AttribUsage::InstanceTransform),
+		BufferAttribute(11, 4, AttributeType::Float, sizeof(InstanceData), offsetof(InstanceData, Model) + 12 * sizeof(float), AttribUsage::InstanceTransform),
+
+		BufferAttribute(12, 3, AttributeType::Float, sizeof(InstanceData), offsetof(InstanceData, NormalMatrix) + 0 * sizeof(float), AttribUsage::InstanceTransform),
+		BufferAttribute(13, 3, AttributeType::Float, sizeof(InstanceData), offsetof(InstanceData, NormalMatrix) + 4 * sizeof(float), AttribUsage::InstanceTransform),
+		BufferAttribute(14, 3, AttributeType::Float, sizeof(InstanceData), offsetof(InstanceData, NormalMatrix) + 8 * sizeof(float), AttribUsage::InstanceTransform),
+	};
+
+	// Meshes get the instance buffer added the first time they are instanced, and need to be
+	// pointed at the new buffer if it has grown since then
+	VertexArrayObject::VertexBufferBinding* binding = mesh->GetBufferBinding(AttribUsage::InstanceTransform);
+	if (binding == nullptr) {
+		mesh->AddVertexBuffer(_instanceBuffer, instanceAttributes, true);
+	} else if (binding->GetBuffer() != _instanceBuffer) {
+		mesh->ReplaceVertexBuffer(binding, _instanceBuffer);
+	}
+}
+
+const ShaderProgram::Sptr& RenderLayer::_GetInstancedShader(const ShaderProgram::Sptr& shader)
+{
+	// Shaders can be destroyed and have their address re-used, so make sure the entry is for this shader
+	auto it = _instancedShaders.find(shader.get());
+	if (it != _instancedShaders.end() && it->second.Base.lock() == shader) {
+		return it->second.Variant;
+	}
+
+	InstancedShader& entry = _instancedShaders[shader.get()];
+	entry.Base = shader;
+	entry.Variant = shader->GetPermutation({ "INSTANCED" });
+
+	// Shaders that don't use the common vertex inputs will never read the instance buffer
+	if (entry.Variant != nullptr && entry.Variant->GetAttributeLocation("inModelTransform") == -1) {
+		entry.Variant = nullptr;
+	}
+	if (entry.Variant == nullptr) {
+		LOG_INFO("Shader \"{}\" does not support instancing, objects using it will be drawn individually", shader->GetDebugName());
+	}
+	return entry.Variant;
 }
 
 const UniformBuffer<RenderLayer::FrameLevelUniforms>::Sptr& RenderLayer::GetFrameUniforms() const
@@ -1,9 +1,23 @@
 #pragma once
+#include <unordered_map>
 #include "../ApplicationLayer.h"
 #include "Graphics/Framebuffer.h"
 #include "Graphics/Buffers/UniformBuffer.h"
+#include "Graphics/Buffers/StreamingUniformBuffer.h"
+#include "Graphics/Buffers/ShaderStorageBuffer.h"
 #include "Graphics/ShaderProgram.h"
 #include "Graphics/VertexArrayObject.h"
+#include "Graphics/RenderQueue.h"
+#include "Graphics/InstancePacker.h"
+#include "Graphics/LightClusterer.h"
+#include "Graphics/ShadowCasterTracker.h"
+#include "Graphics/ShadowAtlasPacker.h"
+#include "Graphics/RenderGraph.h"
+#include "Graphics/RenderTargetPool.h"
+#include "Utils/DynamicBvh.h"
+
+class RenderComponent;
+class ShadowCamera;
 
 #define MAX_LIGHTS 8
 
@@ -12,7 +26,30 @@ ENUM_FLAGS(RenderFlags, uint32_t,
 	EnableDiffuseLight = 1 << 0,
 	EnableAmbientLight = 1 << 1,
 	EnableSpecularLight = 1 << 2,
-	EnableColorCorrection = 1 << 3
+	EnableColorCorrection = 1 << 3,
+	// Set by the render layer when the G-buffer uses the compact layout, see GBufferLayout
+	CompactGBuffer = 1 << 4
+);
+
+/// <summary>
+/// Selects how the G-buffer is stored, see fragments/gbuffer_encoding.glsl
+/// Full:    Albedo + spec, normals + metallic, and emissive in RGBA8, view space position in RGBA16F,
+///          and 32 bit depth (24 bytes per pixel)
+/// Compact: Albedo + spec in RGBA8, octahedral normals in RG16, pre-multiplied emissive + metallic in
+///          RGBA8, and 32 bit depth that the view space position is rebuilt from (16 bytes per pixel)
+/// </summary>
+ENUM(GBufferLayout, uint32_t,
+	Full    = 0,
+	Compact = 1
+);
+
+/// <summary>
+/// Selects which shadow casters a render pass draws, see ShadowCasterTracker
+/// </summary>
+ENUM(CasterFilter, uint32_t,
+	All     = 0,
+	Static  = 1,
+	Dynamic = 2
 );
 
 class RenderLayer final : public ApplicationLayer {
@@ -96,6 +133,24 @@ public:
 		glm::mat4 EnvironmentRotation;
 	};
 
+	/// <summary>
+	/// Counters for how many objects were considered, culled, and drawn in a render pass
+	/// </summary>
+	struct CullingStats {
+		// The number of renderables that were considered for drawing
+		uint32_t Tested      = 0;
+		// The number of renderables that were rejected by frustum culling
+		uint32_t Culled      = 0;
+		// The number of renderables that were drawn
+		uint32_t Drawn       = 0;
+		// The number of draw calls that were made, instanced draws count once
+		uint32_t DrawCalls   = 0;
+		// The number of BVH nodes that were tested against the frustum
+		uint32_t NodesTested = 0;
+		// The number of shadow maps that re-used their cached static casters instead of re-drawing them
+		uint32_t CachedPasses = 0;
+	};
+
 	RenderLayer();
 	virtual ~RenderLayer();
 
@@ -113,12 +168,54 @@ public:
 	void SetRenderFlags(RenderFlags value);
 	RenderFlags GetRenderFlags() const;
 
+	/// <summary>
+	/// Gets or sets how the G-buffer is stored, changing the layout re-creates the G-buffer
+	/// </summary>
+	GBufferLayout GetGBufferLayout() const;
+	void SetGBufferLayout(GBufferLayout value);
+	/// <summary>
+	/// Gets the number of bytes that each pixel of the G-buffer takes up, across all of its attachments
+	/// </summary>
+	uint32_t GetGBufferPixelSize() const;
+
 	const Framebuffer::Sptr& GetLightingBuffer() const;
 	const Framebuffer::Sptr& GetRenderOutput() const;
 	const Framebuffer::Sptr& GetGBuffer() const;
 
 	const UniformBuffer<FrameLevelUniforms>::Sptr& GetFrameUniforms() const;
 
+	/// <summary>
+	/// Gets or sets the largest mesh simplification error that we will accept, in pixels. Meshes will
+	/// switch to simpler levels of detail as they get smaller on screen while staying within this error
+	/// </summary>
+	float GetLodPixelError() const;
+	void SetLodPixelError(float value);
+
+	/// <summary>
+	/// Gets the culling statistics for the main camera pass in the last frame
+	/// </summary>
+	const CullingStats& GetMainPassStats() const;
+	/// <summary>
+	/// Gets the culling statistics for all shadow camera passes in the last frame, added together
+	/// </summary>
+	const CullingStats& GetShadowPassStats() const;
+	/// <summary>
+	/// Gets the clusters that the scene's lights were assigned to in the last frame
+	/// </summary>
+	const LightClusterer& GetLightClusterer() const;
+	/// <summary>
+	/// Gets the packer that splits the shadow atlas into tiles for each shadow casting light
+	/// </summary>
+	const ShadowAtlasPacker& GetShadowAtlasPacker() const;
+	/// <summary>
+	/// Gets the render graph that the shadow, lighting, and composite passes were run through in the last frame
+	/// </summary>
+	const RenderGraph& GetRenderGraph() const;
+	/// <summary>
+	/// Gets the pool that the render graph's transient targets are allocated from
+	/// </summary>
+	const RenderTargetPool& GetRenderTargetPool() const;
+
 	// Inherited from ApplicationLayer
 
 	virtual void OnAppLoad(const nlohmann::json& config) override;
@@ -132,6 +229,7 @@ public:
 
 protected:
 	Framebuffer::Sptr   _primaryFBO;
+	// Handed out by _targetPool every frame, only valid from the lighting pass onwards
 	Framebuffer::Sptr   _lightingFBO;
 	Framebuffer::Sptr   _outputBuffer;
 
@@ -145,19 +243,128 @@ protected:
 	bool              _blitFbo;
 	glm::vec4         _clearColor;
 	RenderFlags       _renderFlags;
+	GBufferLayout     _gBufferLayout;
+	float             _lodPixelError;
+
+	// Tracks a renderer that has been inserted into the culling BVH
+	struct CullingProxy {
+		uint32_t Proxy;
+		uint64_t LastSeenFrame;
+	};
+	// World space bounds of all renderers with a mesh, keyed by the render component
+	DynamicBvh        _cullingBvh;
+	std::unordered_map<RenderComponent*, CullingProxy> _cullingProxies;
+	// Renderers whose meshes have no bounds, these are never culled
+	std::vector<RenderComponent*> _unboundedRenderables;
+	// Scratch list of renderers that passed culling for the current pass
+	std::vector<RenderComponent*> _visibleRenderables;
+	uint64_t          _cullingFrame;
+
+	// A single draw that has passed culling, the render queue sorts indices into a list of these
+	struct DrawCommand {
+		RenderComponent*   Renderable;
+		VertexArrayObject* Mesh;
+		glm::mat4          ModelView;
+	};
+	std::vector<DrawCommand> _drawCommands;
+	RenderQueue       _renderQueue;
+	// Map shaders, materials, and meshes to small IDs for building sort keys, rebuilt every pass
+	std::unordered_map<const void*, uint32_t> _shaderSortIds;
+	std::unordered_map<const void*, uint32_t> _materialSortIds;
+	std::unordered_map<const void*, uint32_t> _meshSortIds;
+
+	// The number of frames the GPU may be behind us by, data that we stream to the GPU
+	// is split into one segment per frame (see FrameRing)
+	static constexpr uint32_t FRAMES_IN_FLIGHT = 3;
+	// The smallest run of identical draws that we'll draw with instancing
+	static constexpr uint32_t MIN_INSTANCE_RUN = 2;
+	// Instance data for instanced draws is streamed through a persistently mapped vertex buffer
+	VertexBuffer::Sptr _instanceBuffer;
+	InstanceData*     _instanceData;
+	std::unique_ptr<FrameRing> _instanceRing;
+
+	// Instanced variants of material shaders, the variant is null if the shader can't be instanced
+	struct InstancedShader {
+		std::weak_ptr<ShaderProgram> Base;
+		ShaderProgram::Sptr          Variant;
+	};
+	std::unordered_map<const ShaderProgram*, InstancedShader> _instancedShaders;
+
+	CullingStats      _mainPassStats;
+	CullingStats      _shadowPassStats;
+
+	// Sorts shadow casters into static casters, which are cached in each light's tile of the static
+	// shadow atlas, and dynamic casters, which are drawn over the cached depth every frame
+	ShadowCasterTracker _shadowCasters;
+
+	// Every shadow casting light renders into its own tile of one large depth texture, so the shadow
+	// passes don't need to switch framebuffers per light. Tiles are sized by how much of the screen
+	// the light covers, and only re-packed when the lights or their sizes change
+	static constexpr uint32_t SHADOW_ATLAS_SIZE = 4096;
+	Framebuffer::Sptr   _shadowAtlas;
+	Framebuffer::Sptr   _staticShadowAtlas;
+	ShadowAtlasPacker   _shadowAtlasPacker;
+	std::vector<ShadowAtlasPacker::Request> _shadowAtlasRequests;
+	std::vector<ShadowCamera*>              _shadowAtlasLights;
+
+	// The passes after the G-buffer is filled are run through a render graph every frame, so that targets
+	// which only live between two passes are pooled, and passes that nobody needs are skipped
+	RenderGraph         _renderGraph;
+	RenderTargetPool    _targetPool;
+	// Set once an invalid graph has been logged, so a broken graph doesn't flood the log every frame
+	bool                _hasReportedGraphErrors;
 
 	const int FRAME_UBO_BINDING = 0;
 	UniformBuffer<FrameLevelUniforms>::Sptr _frameUniforms;
 
 	const int INSTANCE_UBO_BINDING = 1;
 	UniformBuffer<InstanceLevelUniforms>::Sptr _instanceUniforms;
+	// Per-draw instance uniforms are streamed into their own slots, and only fall back to
+	// _instanceUniforms if the stream runs out of room in a frame
+	StreamingUniformBuffer::Sptr _instanceUniformStream;
 
 	const int LIGHTING_UBO_BINDING = 2;
 	UniformBuffer<LightingUboStruct>::Sptr _lightingUbo;
 
+	// The light accumulation pass reads every light in the scene from shader storage, and only shades the
+	// lights in each fragment's cluster (see LightClusterer). These are shader storage bindings, not uniform ones
+	const int CLUSTER_LIGHTS_BINDING = 0;
+	const int CLUSTERS_BINDING = 1;
+	const int CLUSTER_INDICES_BINDING = 2;
+	LightClusterer            _lightClusterer;
+	std::vector<ClusterLight> _clusterLightBounds;
+	std::vector<LightingUboStruct::Light> _clusterLightData;
+	ShaderStorageBuffer::Sptr _clusterLightBuffer;
+	ShaderStorageBuffer::Sptr _clusterBuffer;
+	ShaderStorageBuffer::Sptr _clusterIndexBuffer;
+
 	void _InitFrameUniforms();
-	void _RenderScene(const glm::mat4& view, const glm::mat4&Projection, const glm::ivec2& screenSize);
+	void _CreateGBuffer(const glm::ivec2& size);
+	void _UpdateCullingBvh();
+	void _CreateInstanceBuffer(uint32_t capacity);
+	void _BeginStreamingFrame();
+	void _EndStreamingFrame();
+	void _AttachInstanceBuffer(VertexArrayObject* mesh);
+	const ShaderProgram::Sptr& _GetInstancedShader(const ShaderProgram::Sptr& shader);
+	void _RenderScene(const glm::mat4& view, const glm::mat4&Projection, const glm::ivec2& screenSize, CullingStats& stats, CasterFilter filter = CasterFilter::All);
+	/// <summary>
+	/// Sizes each shadow camera's tile by its screen coverage, and assigns the tiles in the shadow atlas
+	/// </summary>
+	void _UpdateShadowAtlas();
+	/// <summary>
+	/// Renders the depth for all shadow cameras, only re-drawing static casters when their cache has gone stale
+	/// </summary>
+	void _RenderShadowMaps();
 
+	/// <summary>
+	/// Gathers the scene's lights in view space, assigns them to clusters, and uploads the results
+	/// </summary>
+	/// <returns>True if any light touches a cluster</returns>
+	bool _BuildLightClusters(const glm::mat4& view, const glm::mat4& projection, float zNear, float zFar);
+	/// <summary>
+	/// Declares this frame's shadow, lighting, composite, and present passes in the render graph
+	/// </summary>
+	void _BuildRenderGraph();
 	void _AccumulateLighting();
 	void _Composite();
 	void _ClearFramebuffer(Framebuffer::Sptr& buffer, const glm::vec4* colors, int layers);
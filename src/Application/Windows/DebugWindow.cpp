@@ -2,6 +2,7 @@
 #include "Application/Application.h"
 #include "Application/ApplicationLayer.h"
 #include "Application/Layers/RenderLayer.h"
+#include "Application/Layers/PostProcessingLayer.h"
 
 DebugWindow::DebugWindow() :
 	IEditorWindow()
@@ -37,4 +38,61 @@ void DebugWindow::RenderMenuBar()
 	if (changed) {
 		renderLayer->SetRenderFlags(flags);
 	}
+
+	// The compact G-buffer trades a little precision for a lot less bandwidth at high resolutions
+	bool compact = renderLayer->GetGBufferLayout() == GBufferLayout::Compact;
+	if (ImGui::Checkbox("Compact G-Buffer", &compact)) {
+		renderLayer->SetGBufferLayout(compact ? GBufferLayout::Compact : GBufferLayout::Full);
+	}
+	ImGui::SameLine();
+	ImGui::Text("(%u bytes/pixel)", renderLayer->GetGBufferPixelSize());
+
+	ImGui::Separator();
+
+	// Show how many objects frustum culling is saving us from drawing
+	const RenderLayer::CullingStats& mainStats = renderLayer->GetMainPassStats();
+	const RenderLayer::CullingStats& shadowStats = renderLayer->GetShadowPassStats();
+	ImGui::Text("Main: %u/%u drawn", mainStats.Drawn, mainStats.Tested);
+	if (ImGui::IsItemHovered()) {
+		ImGui::SetTooltip("Tested: %u\nCulled: %u\nDrawn: %u\nDraw calls: %u\nBVH nodes tested: %u", mainStats.Tested, mainStats.Culled, mainStats.Drawn, mainStats.DrawCalls, mainStats.NodesTested);
+	}
+	ImGui::Text("Shadows: %u/%u drawn", shadowStats.Drawn, shadowStats.Tested);
+	if (ImGui::IsItemHovered()) {
+		ImGui::SetTooltip("Tested: %u\nCulled: %u\nDrawn: %u\nDraw calls: %u\nBVH nodes tested: %u\nCached shadow maps: %u", shadowStats.Tested, shadowStats.Culled, shadowStats.Drawn, shadowStats.DrawCalls, shadowStats.NodesTested, shadowStats.CachedPasses);
+	}
+
+	// Show how well the lights are spread across the light clusters
+	const LightClusterer& clusterer = renderLayer->GetLightClusterer();
+	const glm::uvec3& gridSize = clusterer.GetGridSize();
+	ImGui::Text("Light clusters: %ux%ux%u", gridSize.x, gridSize.y, gridSize.z);
+	ImGui::Text("Light indices: %u (max %u per cluster)", static_cast<uint32_t>(clusterer.GetLightIndices().size()), clusterer.GetMaxClusterLights());
+
+	// Show how full the shadow atlas is
+	const ShadowAtlasPacker& atlasPacker = renderLayer->GetShadowAtlasPacker();
+	uint64_t atlasPixels = 0;
+	for (const glm::uvec4& tile : atlasPacker.GetTiles()) {
+		atlasPixels += static_cast<uint64_t>(tile.z) * tile.w;
+	}
+	float atlasFill = static_cast<float>(atlasPixels) / (static_cast<float>(atlasPacker.GetAtlasSize()) * atlasPacker.GetAtlasSize());
+	ImGui::Text("Shadow atlas: %u tiles, %.0f%% full", static_cast<uint32_t>(atlasPacker.GetTiles().size()) - atlasPacker.GetDroppedCount(), atlasFill * 100.0f);
+	if (atlasPacker.GetDroppedCount() > 0) {
+		ImGui::SameLine();
+		ImGui::Text("(%u lights dropped)", atlasPacker.GetDroppedCount());
+	}
+
+	// Show how many passes ran, and how many framebuffers the transient targets were packed into
+	auto renderGraphStats = [](const char* label, const RenderGraph& graph, const RenderTargetPool& pool) {
+		ImGui::Text("%s: %u passes, %u targets in %u framebuffers (%.1f MB)", label,
+			static_cast<uint32_t>(graph.GetPassOrder().size()), graph.GetTransientCount(),
+			pool.GetFramebufferCount(), pool.GetMemoryUsage() / (1024.0f * 1024.0f));
+		if (ImGui::IsItemHovered()) {
+			ImGui::SetTooltip("Culled passes: %u\nDropped blits: %u", graph.GetCulledPassCount(), graph.GetDroppedBlitCount());
+		}
+	};
+	renderGraphStats("Render graph", renderLayer->GetRenderGraph(), renderLayer->GetRenderTargetPool());
+
+	PostProcessingLayer::Sptr postProcessing = app.GetLayer<PostProcessingLayer>();
+	if (postProcessing != nullptr) {
+		renderGraphStats("Post processing", postProcessing->GetRenderGraph(), postProcessing->GetRenderTargetPool());
+	}
 }
@@ -29,9 +29,6 @@ void GBufferPreviews::Render()
 	Texture2D::Sptr& emissive = framebuffer->GetTextureAttachment(RenderTargetAttachment::Color2);
 	Texture2D::Sptr& viewspace = framebuffer->GetTextureAttachment(RenderTargetAttachment::Color3);
 
-	Texture2D::Sptr& diffuse = lightBuffer->GetTextureAttachment(RenderTargetAttachment::Color0);
-	Texture2D::Sptr& specular = lightBuffer->GetTextureAttachment(RenderTargetAttachment::Color1);
-
 	int width = (ImGui::GetContentRegionAvailWidth() / 2);
 	float aspect = app.GetWindowSize().x / (float)app.GetWindowSize().y;
 	int height = width / aspect;
@@ -49,20 +46,28 @@ void GBufferPreviews::Render()
 	_RenderTexture2D(color, size, "color");
 	ImGui::NextColumn();
 
-	_RenderTexture2D(normals, size, "normals");
+	// The compact layout stores octahedral normals, and rebuilds position from depth instead of storing it
+	bool isCompact = renderLayer->GetGBufferLayout() == GBufferLayout::Compact;
+
+	_RenderTexture2D(normals, size, isCompact ? "normals (octahedral)" : "normals");
 	ImGui::NextColumn();
 
-	_RenderTexture2D(emissive, size, "emissive"); 
+	_RenderTexture2D(emissive, size, isCompact ? "emissive (pre-multiplied)" : "emissive"); 
 	ImGui::NextColumn();  
 
-	_RenderTexture2D(viewspace, size, "position (viewspace)");
-	ImGui::NextColumn();
+	if (viewspace != nullptr) {
+		_RenderTexture2D(viewspace, size, "position (viewspace)");
+		ImGui::NextColumn();
+	}
 
-	_RenderTexture2D(diffuse, size, "Diffuse Lighting");
-	ImGui::NextColumn();
+	// The lighting buffer comes from the render layer's target pool, and won't exist until the first frame is drawn
+	if (lightBuffer != nullptr) {
+		_RenderTexture2D(lightBuffer->GetTextureAttachment(RenderTargetAttachment::Color0), size, "Diffuse Lighting");
+		ImGui::NextColumn();
 
-	_RenderTexture2D(specular, size, "Specular Lighting");
-	ImGui::NextColumn(); 
+		_RenderTexture2D(lightBuffer->GetTextureAttachment(RenderTargetAttachment::Color1), size, "Specular Lighting");
+		ImGui::NextColumn(); 
+	}
 
 	ImGui::Columns(1);
 }
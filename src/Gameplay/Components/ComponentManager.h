@@ -1,8 +1,10 @@
 #pragma once
 #include <functional>
 #include "IComponent.h"
+#include "ComponentPool.h"
 #include <typeindex>
 #include <optional>
+#include <type_traits>
 #include <Logging.h>
 
 namespace Gameplay {
@@ -10,14 +12,24 @@ namespace Gameplay {
 	/// Helper class for component types, this class is what lets us load component types
 	/// from scene files, as well as providing a way to iterate over all active components
 	/// of a given type (and sort them in the future!)
+	/// 
+	/// Each registered type gets a small integer ID, and each scene stores the live components
+	/// of a type in a dense ComponentPool indexed by that ID
 	/// </summary>
 	class ComponentManager {
 	public:
 		typedef std::function<IComponent::Sptr(const nlohmann::json&)> LoadComponentFunc;
 		typedef std::function<IComponent::Sptr()> CreateComponentFunc;
 
+		/// <summary>
+		/// The type ID of a component type that has not been registered
+		/// </summary>
+		static constexpr uint32_t INVALID_TYPE_ID = ~0u;
+
 		inline void Clear() {
-			_Components.clear();
+			for (ComponentPool& pool : _pools) {
+				pool.Clear();
+			}
 		}
 
 		/// <summary>
@@ -41,12 +53,35 @@ namespace Gameplay {
 					IComponent::Sptr result = callback(blob);
 					IComponent::LoadBaseJson(result, blob);
 
-					// Make sure the component knows it's own type
-					result->_realType = typeIndex.value();
-					result->_weakSelfPtr = result;
+					// Make sure the component knows it's own type, and add it to the pools
+					_Track(result, typeIndex.value());
+					return result;
+				}
+			}
+			return nullptr;
+		}
 
-					// Add the component to the global pools
-					_Components[result->_realType].push_back(result);
+		/// <summary>
+		/// Loads a component with the given type name from a JSON blob that does not contain the base
+		/// component data, used when the GUID and enabled state are stored separately (ex: binary scenes)
+		/// If the type name does not correspond to a registered type, will return nullptr
+		/// </summary>
+		/// <param name="typeName">The name of the type to load (taken from GetComponentTypeName of component)</param>
+		/// <param name="blob">The JSON blob to decode</param>
+		/// <param name="guid">The unique ID of the component</param>
+		/// <param name="isEnabled">True if the component should start enabled</param>
+		/// <returns>The component as decoded from the JSON data, or nullptr</returns>
+		inline IComponent::Sptr Load(const std::string& typeName, const nlohmann::json& blob, const Guid& guid, bool isEnabled) {
+			std::optional<std::type_index> typeIndex = _TypeNameMap[typeName];
+			if (typeIndex.has_value()) {
+				LoadComponentFunc callback = _TypeLoadRegistry[typeIndex.value()];
+				if (callback) {
+					IComponent::Sptr result = callback(blob);
+					result->OverrideGUID(guid);
+					result->IsEnabled = isEnabled;
+
+					// Make sure the component knows it's own type, and add it to the pools
+					_Track(result, typeIndex.value());
 					return result;
 				}
 			}
@@ -71,11 +106,8 @@ namespace Gameplay {
 				if (callback) {
 					// Invoke the loader, also load additional component data
 					IComponent::Sptr result = callback();
-					// Make sure the component knows it's own type
-					result->_realType = typeIndex.value();
-					result->_weakSelfPtr = result;
-					// Add the component to the global pools
-					_Components[result->_realType].push_back(result);
+					// Make sure the component knows it's own type, and add it to the pools
+					_Track(result, typeIndex.value());
 					return result;
 				}
 			}
@@ -98,11 +130,8 @@ namespace Gameplay {
 			if (callback) {
 				// Invoke the loader, also load additional component data
 				IComponent::Sptr result = callback();
-				// Make sure the component knows it's own type
-				result->_realType = type;
-				result->_weakSelfPtr = result;
-				// Add the component to the global pools
-				_Components[result->_realType].push_back(result);
+				// Make sure the component knows it's own type, and add it to the pools
+				_Track(result, type);
 				return result;
 			}
 			return nullptr;
@@ -132,19 +161,13 @@ namespace Gameplay {
 			typename ... TArgs, 
 			typename = typename std::enable_if<std::is_base_of<IComponent, ComponentType>::value>::type>
 		std::shared_ptr<ComponentType> Create(TArgs&& ... args) {
-			std::type_index type = std::type_index(typeid(ComponentType));
-			LOG_ASSERT(_TypeLoadRegistry[type] != nullptr, "You must register component types before creating them!");
+			LOG_ASSERT(_TypeId<ComponentType> != INVALID_TYPE_ID, "You must register component types before creating them!");
 
 			// Create component, forwarding arguments
 			std::shared_ptr<ComponentType> component = std::make_shared<ComponentType>(std::forward<TArgs>(args)...);
 
-			// Make sure the component knows it's concrete type
-			component->_realType = type;
-			// Give the component a weak pointer to itself that it can upcast to a shared pointer when needed
-			component->_weakSelfPtr = component;
-
-			// Add to global component list for that type
-			_Components[type].push_back(component);
+			// Make sure the component knows it's concrete type, and add it to the pool for that type
+			_Track(component, std::type_index(typeid(ComponentType)));
 
 			// Return the result
 			return component;
@@ -161,52 +184,55 @@ namespace Gameplay {
 			typename ComponentType,
 			typename = typename std::enable_if<std::is_base_of<IComponent, ComponentType>::value>::type>
 		std::shared_ptr<ComponentType> GetComponentByGUID(Guid id) {
-			// We can use typeid and type_index to get a unique ID for our types
-			std::type_index type = std::type_index(typeid(ComponentType));
-			LOG_ASSERT(_TypeLoadRegistry[type] != nullptr, "You must register component types before creating them!");
-
-			// Clear any dead weak pointers
-			auto removeIt = std::remove_if(_Components[type].begin(), _Components[type].end(), [](const std::weak_ptr<IComponent>& ptr) {
-				return ptr.expired();
-			});
-			_Components[type].erase(removeIt, _Components[type].end());
+			uint32_t typeId = _TypeId<ComponentType>;
+			LOG_ASSERT(typeId != INVALID_TYPE_ID, "You must register component types before creating them!");
+			if (typeId >= _pools.size()) {
+				return nullptr;
+			}
 
 			// Search the component store for a component that matches that ID
-			auto& it = std::find_if(_Components[type].begin(), _Components[type].end(), [&](const std::weak_ptr<IComponent>& ptr) {
-				return (ptr.lock())->GetGUID() == id;
-			});
-
-			// If the component was found, return it. Otherwise return nullptr
-			if (it != _Components[type].end()) {
-				// We need to lock the weak pointer to convert it to a shared ptr
-				return std::dynamic_pointer_cast<ComponentType>((*it).lock());
-			} else {
-				return nullptr;
+			for (IComponent* component : _pools[typeId].GetComponents()) {
+				if (component->GetGUID() == id) {
+					// We need to lock the weak pointer to convert it to a shared ptr
+					return std::static_pointer_cast<ComponentType>(component->_weakSelfPtr.lock());
+				}
 			}
+			return nullptr;
 		}
 
 		/// <summary>
-		/// Iterates over all components of the given type and invokes a method with them
+		/// Iterates over all components of the given type and invokes a method with them. The callback
+		/// should take a ComponentType&, callbacks that take a shared pointer are still supported but
+		/// need to lock each component's weak self pointer
+		/// 
+		/// Components that are added during iteration are visited, and if a component is removed during
+		/// iteration, the component that gets swapped into its place will be skipped
 		/// </summary>
 		/// <typeparam name="ComponentType">The type of component to iterate on</typeparam>
 		/// <param name="callback">The callback to invoke with the components</param>
 		/// <param name="includeDisabled">True to include disabled components, false if otherwise</param>
 		template <
 			typename ComponentType,
+			typename Callback,
 			typename = typename std::enable_if<std::is_base_of<IComponent, ComponentType>::value>::type>
-		void Each(std::function<void(const std::shared_ptr<ComponentType>&)> callback, bool includeDisabled = false) {
-			// We can use typeid and type_index to get a unique ID for our types
-			std::type_index type = std::type_index(typeid(ComponentType));
-			LOG_ASSERT(_TypeLoadRegistry[type] != nullptr, "You must register component types before creating them!");
+		void Each(Callback&& callback, bool includeDisabled = false) {
+			uint32_t typeId = _TypeId<ComponentType>;
+			LOG_ASSERT(typeId != INVALID_TYPE_ID, "You must register component types before creating them!");
+			if (typeId >= _pools.size()) {
+				return;
+			}
 
-			// Iterate over all the components in the store
-			for (auto& wptr : _Components[type]) {
-				// Lock the weak pointer to get a shared pointer (maybe)
-				std::shared_ptr<IComponent> sptr = wptr.lock();
-				// If the pointer is alive and matches our enabled criteria, invoke the callback
-				if (sptr && sptr->IsEnabled | includeDisabled) {
-					// Upcast to component type and invoke the callback
-					callback(std::dynamic_pointer_cast<ComponentType>(sptr));
+			// Pools only ever hold components of their exact type, so we can skip the dynamic cast. We
+			// index rather than use iterators since the callback may add components and grow the pool
+			ComponentPool& pool = _pools[typeId];
+			for (size_t ix = 0; ix < pool.Size(); ix++) {
+				ComponentType* component = static_cast<ComponentType*>(pool[ix]);
+				if (component->IsEnabled || includeDisabled) {
+					if constexpr (std::is_invocable_v<Callback, ComponentType&>) {
+						callback(*component);
+					} else {
+						callback(std::static_pointer_cast<ComponentType>(component->_weakSelfPtr.lock()));
+					}
 				}
 			}
 		}
@@ -231,14 +257,44 @@ namespace Gameplay {
 				_TypeLoadRegistry[type] = &ComponentManager::ParseTypeFromBlob<T>;
 				_TypeCreateRegistry[type] = &ComponentManager::_InternalCreate<T>;
 				_TypeNameMap[StringTools::SanitizeClassName(typeid(T).name())] = type;
+
+				// Give the type the next pool ID
+				uint32_t typeId = static_cast<uint32_t>(_TypeIdMap.size());
+				_TypeIdMap[type] = typeId;
+				_TypeId<T> = typeId;
+
+				// If the type doesn't override Update, &T::Update still refers to the base class version
+				UpdateInfo info;
+				info.Mode = T::UPDATE_MODE;
+				info.HasUpdate = !std::is_same<decltype(&T::Update), void (IComponent::*)(float)>::value;
+				_TypeUpdateInfo.push_back(info);
 			}
 		}
 
+		/// <summary>
+		/// Gets the number of component types that have been registered, type IDs are in the range [0, count)
+		/// </summary>
+		static uint32_t GetTypeCount() { return static_cast<uint32_t>(_TypeUpdateInfo.size()); }
+		/// <summary>
+		/// Gets how the component type with the given ID may be scheduled for updates
+		/// </summary>
+		static ComponentUpdateMode GetUpdateMode(uint32_t typeId) { return _TypeUpdateInfo[typeId].Mode; }
+		/// <summary>
+		/// Returns true if the component type with the given ID overrides IComponent::Update
+		/// </summary>
+		static bool HasUpdate(uint32_t typeId) { return _TypeUpdateInfo[typeId].HasUpdate; }
+
+		/// <summary>
+		/// Gets the pool that stores the components for the type with the given ID, or nullptr if no
+		/// components of that type have been created in this scene
+		/// </summary>
+		ComponentPool* GetPool(uint32_t typeId) { return typeId < _pools.size() ? &_pools[typeId] : nullptr; }
+
 		/// <summary>
 		/// Removes all components of all types from the registry, whether they are referenced elsewhere or not
 		/// </summary>
 		inline void FlushAll() {
-			_Components = std::unordered_map<std::type_index, std::vector<std::weak_ptr<IComponent>>>();
+			_pools = std::vector<ComponentPool>();
 		}
 
 	private:
@@ -254,10 +310,38 @@ namespace Gameplay {
 		// Stores functions to load components from JSON, indexed on the type that they load
 		inline static std::unordered_map<std::type_index, CreateComponentFunc> _TypeCreateRegistry;
 
-		// Weak pointers let us store a reference to an object stored by a shared pointer, without
-		// actually increasing the reference count. Thus components will be destroyed at the correct
-		// time (when the only reference is the one stored here).
-		std::unordered_map<std::type_index, std::vector<std::weak_ptr<IComponent>>> _Components;  
+		// Maps each registered type to the index of its pool
+		inline static std::unordered_map<std::type_index, uint32_t> _TypeIdMap;
+		struct UpdateInfo {
+			ComponentUpdateMode Mode = ComponentUpdateMode::MainThread;
+			bool                HasUpdate = true;
+		};
+		// How each registered type is updated, indexed by type ID
+		inline static std::vector<UpdateInfo> _TypeUpdateInfo;
+		// The pool index for each registered type, so that templated lookups don't need to hash anything
+		template <typename T>
+		inline static uint32_t _TypeId = INVALID_TYPE_ID;
+
+		// The components of each type, indexed by type ID. The pools only store raw pointers, components are
+		// removed from their pool when they are destroyed, so they still die when their game object lets go
+		std::vector<ComponentPool> _pools;
+
+		/// <summary>
+		/// Sets up a newly created component with its type and self pointer, and adds it to the pool for its type
+		/// </summary>
+		inline void _Track(const IComponent::Sptr& component, const std::type_index& type) {
+			component->_realType = type;
+			component->_weakSelfPtr = component;
+
+			auto it = _TypeIdMap.find(type);
+			LOG_ASSERT(it != _TypeIdMap.end(), "You must register component types before creating them!");
+			uint32_t typeId = it->second;
+			if (typeId >= _pools.size()) {
+				_pools.resize(typeId + 1);
+			}
+			component->_poolTypeId = typeId;
+			component->_poolHandle = _pools[typeId].Add(component.get());
+		}
 
 		template <typename T>
 		static IComponent::Sptr ParseTypeFromBlob(const nlohmann::json& blob) {
@@ -289,21 +373,9 @@ namespace Gameplay {
 		/// <param name="component">A raw pointer to the component to remove (should be called from IComponent destructor)</param>
 		/// <returns>True if the element was removed, false if not</returns>
 		inline void Remove(const IComponent* component) {
-			if (_Components.size() == 0) return;
-
-			// Make sure the component's type was one that was registered
-			LOG_ASSERT(_TypeLoadRegistry[component->_realType] != nullptr, "You must register component types before creating them!");
-
-			
-			// Get a reference to the vector of components for easy access
-			std::vector<std::weak_ptr<IComponent>>& componentStore = _Components[component->_realType];
-
-			// Clear any dead weak pointers
-			auto it = std::remove_if(componentStore.begin(), componentStore.end(), [](const std::weak_ptr<IComponent>& ptr) {
-				return ptr.expired();
-				});
-			if (it != componentStore.end()) {
-				componentStore.erase(it);
+			// Stale handles (such as after the pools have been cleared) are ignored by the pool
+			if (component->_poolTypeId < _pools.size()) {
+				_pools[component->_poolTypeId].Remove(component->_poolHandle);
 			}
 		}
 	};
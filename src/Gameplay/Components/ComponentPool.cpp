@@ -0,0 +1,81 @@
+#include "Gameplay/Components/ComponentPool.h"
+
+namespace Gameplay {
+	ComponentPool::ComponentPool() :
+		_dense(),
+		_denseSlots(),
+		_slots(),
+		_freeList(ComponentHandle::INVALID_INDEX)
+	{ }
+
+	ComponentHandle ComponentPool::Add(IComponent* component) {
+		// Re-use a free slot if we have one
+		uint32_t slot;
+		if (_freeList != ComponentHandle::INVALID_INDEX) {
+			slot = _freeList;
+			_freeList = _slots[slot].Dense;
+		} else {
+			slot = static_cast<uint32_t>(_slots.size());
+			_slots.push_back(Slot());
+		}
+
+		_slots[slot].Dense = static_cast<uint32_t>(_dense.size());
+		_dense.push_back(component);
+		_denseSlots.push_back(slot);
+
+		ComponentHandle result;
+		result.Index = slot;
+		result.Generation = _slots[slot].Generation;
+		return result;
+	}
+
+	bool ComponentPool::Remove(ComponentHandle handle) {
+		if (Get(handle) == nullptr) {
+			return false;
+		}
+
+		// Move the last component into the hole, and point its slot at its new home
+		uint32_t dense = _slots[handle.Index].Dense;
+		uint32_t last = static_cast<uint32_t>(_dense.size() - 1);
+		if (dense != last) {
+			_dense[dense] = _dense[last];
+			_denseSlots[dense] = _denseSlots[last];
+			_slots[_denseSlots[dense]].Dense = dense;
+		}
+		_dense.pop_back();
+		_denseSlots.pop_back();
+
+		// Free the slot, bumping the generation so that the old handle no longer matches
+		Slot& slot = _slots[handle.Index];
+		slot.Generation++;
+		slot.Dense = _freeList;
+		_freeList = handle.Index;
+		return true;
+	}
+
+	IComponent* ComponentPool::Get(ComponentHandle handle) const {
+		if (!handle.IsValid() || handle.Index >= _slots.size()) {
+			return nullptr;
+		}
+		const Slot& slot = _slots[handle.Index];
+		return slot.Generation == handle.Generation ? _dense[slot.Dense] : nullptr;
+	}
+
+	ComponentHandle ComponentPool::GetHandle(size_t index) const {
+		ComponentHandle result;
+		result.Index = _denseSlots[index];
+		result.Generation = _slots[result.Index].Generation;
+		return result;
+	}
+
+	void ComponentPool::Clear() {
+		// We keep the slots around rather than clearing them, so that handles from before the clear stay stale
+		for (uint32_t slot : _denseSlots) {
+			_slots[slot].Generation++;
+			_slots[slot].Dense = _freeList;
+			_freeList = slot;
+		}
+		_dense.clear();
+		_denseSlots.clear();
+	}
+}
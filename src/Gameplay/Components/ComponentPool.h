@@ -0,0 +1,93 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Gameplay {
+	// Pre-declare to avoid a circular include with IComponent.h
+	class IComponent;
+
+	/// <summary>
+	/// A handle to a component stored in a ComponentPool. Handles stay valid while their component
+	/// is in the pool, even as other components are added and removed, and a handle to a removed
+	/// component will never refer to a component that is added later
+	/// </summary>
+	struct ComponentHandle {
+		static constexpr uint32_t INVALID_INDEX = ~0u;
+
+		uint32_t Index      = INVALID_INDEX;
+		uint32_t Generation = 0;
+
+		bool IsValid() const { return Index != INVALID_INDEX; }
+	};
+
+	/// <summary>
+	/// Tracks all the live components of a single concrete type in a dense array, so that they can be
+	/// iterated without chasing weak pointers or skipping over dead entries. Removing a component swaps
+	/// the last component into its place, so the order of the components is not stable across removals
+	///
+	/// Components are still owned by their game objects, the pool only stores pointers to them
+	/// </summary>
+	class ComponentPool {
+	public:
+		/// <summary>
+		/// The number of components in each job when a pool is updated in parallel
+		/// </summary>
+		static constexpr size_t UPDATE_BATCH_SIZE = 256;
+
+		ComponentPool();
+		~ComponentPool() = default;
+
+		/// <summary>
+		/// Adds a component to the pool
+		/// </summary>
+		/// <param name="component">The component to add, should not already be in the pool</param>
+		/// <returns>A handle that can be used to look up or remove the component</returns>
+		ComponentHandle Add(IComponent* component);
+		/// <summary>
+		/// Removes a component from the pool
+		/// </summary>
+		/// <param name="handle">The handle returned when the component was added</param>
+		/// <returns>True if the component was removed, false if the handle was stale</returns>
+		bool Remove(ComponentHandle handle);
+		/// <summary>
+		/// Gets the component that a handle refers to, or nullptr if the handle is stale
+		/// </summary>
+		IComponent* Get(ComponentHandle handle) const;
+		/// <summary>
+		/// Gets the handle of the component at the given index in the dense array
+		/// </summary>
+		ComponentHandle GetHandle(size_t index) const;
+		/// <summary>
+		/// Removes all components from the pool, invalidating all existing handles
+		/// </summary>
+		void Clear();
+
+		/// <summary>
+		/// Gets the number of components in the pool
+		/// </summary>
+		size_t Size() const { return _dense.size(); }
+		/// <summary>
+		/// Gets the component at the given index in the dense array
+		/// </summary>
+		IComponent* operator[](size_t index) const { return _dense[index]; }
+		/// <summary>
+		/// Gets the dense array of components
+		/// </summary>
+		const std::vector<IComponent*>& GetComponents() const { return _dense; }
+
+	protected:
+		struct Slot {
+			// The index of the component in the dense array, or the next free slot if this slot is unused
+			uint32_t Dense      = ComponentHandle::INVALID_INDEX;
+			// Bumped every time the slot is freed, so old handles to the slot can be detected
+			uint32_t Generation = 0;
+		};
+
+		std::vector<IComponent*> _dense;
+		// Maps from a dense index back to the slot that refers to it, so we can patch the slot when swap removing
+		std::vector<uint32_t>    _denseSlots;
+		std::vector<Slot>        _slots;
+		uint32_t                 _freeList;
+	};
+}
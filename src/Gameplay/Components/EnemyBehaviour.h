@@ -7,6 +7,9 @@ class EnemyBehaviour : public Gameplay::IComponent {
 public:
 	typedef std::shared_ptr<EnemyBehaviour> Sptr;
 
+	// Moves our own object towards the player, which is only ever moved on the main thread
+	static constexpr Gameplay::ComponentUpdateMode UPDATE_MODE = Gameplay::ComponentUpdateMode::ReadsOtherObjects;
+
 	std::weak_ptr<Gameplay::IComponent> Panel;
 
 	EnemyBehaviour();
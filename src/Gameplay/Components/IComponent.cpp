@@ -28,7 +28,9 @@ namespace Gameplay {
 		IResource(),
 		IsEnabled(true),
 		_realType(typeid(IComponent)),
-		_context(nullptr)
+		_context(nullptr),
+		_poolTypeId(ComponentManager::INVALID_TYPE_ID),
+		_poolHandle()
 	{ }
 
 	IComponent::~IComponent() {
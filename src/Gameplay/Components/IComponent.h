@@ -3,11 +3,13 @@
 #include "json.hpp"
 #include <imgui.h>
 #include <GLM/glm.hpp>
+#include <EnumToString.h>
 
 #include "Utils/StringUtils.h"
 #include "Utils/ResourceManager/ResourceManager.h"
 #include "Utils/ResourceManager/IResource.h"
 #include "Utils/TypeHelpers.h"
+#include "Gameplay/Components/ComponentPool.h"
 
 namespace Gameplay {
 	// We pre-declare GameObject to avoid circular dependencies in the headers
@@ -18,6 +20,27 @@ namespace Gameplay {
 		class RigidBody;
 	}
 
+	/// <summary>
+	/// Describes how a component type's Update can be scheduled by the scene. Updates are grouped
+	/// by type, and each type's updates run one type at a time, so two components on the same
+	/// object are never updated at the same time
+	/// </summary>
+	ENUM(ComponentUpdateMode, uint8_t,
+		// Update only reads and writes the component and its own game object's local state (position,
+		// rotation, scale), so all components of the type can be updated in parallel. World transforms
+		// are brought up to date before the parallel updates start, and can be read as long as the object
+		// (and its parents) have not been moved since, an object's world transform can't be read after
+		// moving it
+		ThreadSafe        = 0,
+		// Like ThreadSafe, but Update also reads other objects. These types are updated in parallel after
+		// all ThreadSafe types, and must not read objects that are written by their own type. World
+		// transforms are updated again after the ThreadSafe types run, with the same rules
+		ReadsOtherObjects = 1,
+		// Update may do anything (input, physics, creating objects), and is run on the main thread
+		// after all parallel updates have finished
+		MainThread        = 2
+	);
+
 	/// <summary>
 	/// Base class for components that can be attached to game objects
 	/// 
@@ -27,11 +50,23 @@ namespace Gameplay {
 	/// static std::shared_ptr<Type> FromJson(const nlohmann::json&);
 	/// 
 	/// where Type is the Type of component
+	/// 
+	/// Components can also hide UPDATE_MODE to let the scene update them in parallel:
+	/// 
+	/// static constexpr ComponentUpdateMode UPDATE_MODE = ComponentUpdateMode::ThreadSafe;
+	/// 
+	/// Components updated off the main thread must queue structural changes (creating, removing, or
+	/// re-parenting objects) through Scene::Commands()
 	/// </summary>
 	class IComponent : public IResource {
 	public:
 		typedef std::shared_ptr<IComponent> Sptr;
 
+		/// <summary>
+		/// How the scene may schedule this component type's updates, see ComponentUpdateMode
+		/// </summary>
+		static constexpr ComponentUpdateMode UPDATE_MODE = ComponentUpdateMode::MainThread;
+
 		/// <summary>
 		/// True when this component is enabled and should perform update and 
 		/// renders
@@ -163,6 +198,10 @@ namespace Gameplay {
 		std::type_index _realType;
 		GameObject* _context;
 
+		// The pool that this component is tracked in, and its handle within that pool
+		uint32_t        _poolTypeId;
+		ComponentHandle _poolHandle;
+
 		// By storing a weak pointer to ourselves, we can pass a pointer to this
 		// for things like bullet user pointers
 		std::weak_ptr<IComponent> _weakSelfPtr;
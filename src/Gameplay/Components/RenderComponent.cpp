@@ -2,17 +2,20 @@
 
 #include "Utils/ResourceManager/ResourceManager.h"
 #include "Utils/ImGuiHelper.h"
+#include "Utils/JsonGlmHelpers.h"
 
 
 RenderComponent::RenderComponent(const Gameplay::MeshResource::Sptr& mesh, const Gameplay::Material::Sptr& material) :
 	_mesh(mesh), 
 	_material(material), 
+	_shadowMode(ShadowCasterMode::Auto),
 	_meshBuilderParams(std::vector<MeshBuilderParam>()) 
 { }
 
 RenderComponent::RenderComponent() : 
 	_mesh(nullptr), 
 	_material(nullptr), 
+	_shadowMode(ShadowCasterMode::Auto),
 	_meshBuilderParams(std::vector<MeshBuilderParam>())
 { }
 
@@ -29,6 +32,21 @@ VertexArrayObject::Sptr RenderComponent::GetMesh() const {
 	return _mesh ? _mesh->Mesh : nullptr;
 }
 
+VertexArrayObject::Sptr RenderComponent::GetMesh(const glm::mat4& modelView, const glm::mat4& projection, float screenHeight, float maxPixelError) const {
+	if (_mesh == nullptr || _mesh->Lods.size() < 2 || !_mesh->Bounds.IsValid()) {
+		return GetMesh();
+	}
+
+	return _mesh->SelectLod(MeshLod::GetProjectedRadius(_mesh->Bounds, modelView, projection, screenHeight), maxPixelError);
+}
+
+AABB RenderComponent::GetWorldBounds() const {
+	if (_mesh == nullptr || !_mesh->Bounds.IsValid()) {
+		return AABB();
+	}
+	return _mesh->Bounds.Transform(GetGameObject()->GetTransform());
+}
+
 RenderComponent* RenderComponent::SetMaterial(const Gameplay::Material::Sptr& mat) {
 	_material = mat;
 	return this;
@@ -38,10 +56,20 @@ const Gameplay::Material::Sptr& RenderComponent::GetMaterial() const {
 	return _material;
 }
 
+ShadowCasterMode RenderComponent::GetShadowMode() const {
+	return _shadowMode;
+}
+
+RenderComponent* RenderComponent::SetShadowMode(ShadowCasterMode value) {
+	_shadowMode = value;
+	return this;
+}
+
 nlohmann::json RenderComponent::ToJson() const {
 	nlohmann::json result;
 	result["mesh"] = _mesh ? _mesh->GetGUID().str() : "null";
 	result["material"] = _material ? _material->GetGUID().str() : "null";
+	result["shadow_mode"] = ~_shadowMode;
 	return result;
 }
 
@@ -49,6 +77,7 @@ RenderComponent::Sptr RenderComponent::FromJson(const nlohmann::json& data) {
 	RenderComponent::Sptr result = std::make_shared<RenderComponent>();
 	result->_mesh = ResourceManager::Get<Gameplay::MeshResource>(Guid(data["mesh"].get<std::string>()));
 	result->_material = ResourceManager::Get<Gameplay::Material>(Guid(data["material"].get<std::string>()));
+	result->_shadowMode = JsonParseEnum(ShadowCasterMode, data, "shadow_mode", ShadowCasterMode::Auto);
 
 	return result;
 }
@@ -56,8 +85,14 @@ RenderComponent::Sptr RenderComponent::FromJson(const nlohmann::json& data) {
 void RenderComponent::RenderImGui() {
 	ImGui::Text("Indexed:   %s", GetMesh() != nullptr ? (_mesh->Mesh->GetIndexBuffer() != nullptr ? "true" : "false") : "N/A");
 	ImGui::Text("Triangles: %d", GetMesh() != nullptr ? (_mesh->Mesh->GetElementCount() / 3) : 0);
+	ImGui::Text("LODs:      %d", _mesh != nullptr ? (int)_mesh->Lods.size() : 0);
 	ImGui::Text("Source:    %s", (_mesh == nullptr || _mesh->Filename.empty()) ? "Generated" : _mesh->Filename.c_str());
 	ImGui::Separator();
 	ImGui::Text("Material:  %s", _material != nullptr ? _material->Name.c_str() : "NULL");
 	ImGuiHelper::ResourceDragTarget<Gameplay::Material>(_material);
+
+	int shadowMode = *_shadowMode;
+	if (ImGui::Combo("Shadows", &shadowMode, "Auto\0Static\0Dynamic\0")) {
+		_shadowMode = (ShadowCasterMode)shadowMode;
+	}
 }
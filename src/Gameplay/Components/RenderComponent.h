@@ -3,6 +3,7 @@
 #include "Gameplay/MeshResource.h"
 #include "Gameplay/Material.h"
 #include "Utils/MeshFactory.h"
+#include "Graphics/ShadowCasterTracker.h"
 
 /// <summary>
 /// Provides information for a object to be rendered
@@ -26,9 +27,22 @@ public:
 	/// </summary>
 	VertexArrayObject::Sptr GetMesh() const;
 	/// <summary>
+	/// Gets the VAO for the level of detail that best suits how large the mesh appears on screen
+	/// </summary>
+	/// <param name="modelView">The object's model view matrix</param>
+	/// <param name="projection">The projection matrix that the object is being rendered with</param>
+	/// <param name="screenHeight">The height of the render target in pixels</param>
+	/// <param name="maxPixelError">The largest simplification error we are willing to accept, in pixels</param>
+	VertexArrayObject::Sptr GetMesh(const glm::mat4& modelView, const glm::mat4& projection, float screenHeight, float maxPixelError) const;
+	/// <summary>
 	/// Gets the material that this renderer is using
 	/// </summary>
 	const Gameplay::Material::Sptr& GetMaterial() const;
+	/// <summary>
+	/// Gets the world space bounds of this renderer, by transforming the mesh's bounds by the game object's
+	/// transform. Will return an invalid box if the mesh is not set or has no bounds
+	/// </summary>
+	AABB GetWorldBounds() const;
 
 	/// <summary>
 	/// Sets this render component's mesh resource, from which the VAO will be retrieved for rendering
@@ -42,6 +56,16 @@ public:
 	/// <param name="mat">The material for this object</param>
 	RenderComponent* SetMaterial(const Gameplay::Material::Sptr& mat);
 
+	/// <summary>
+	/// Gets how this object is treated by the cached shadow maps, default Auto
+	/// </summary>
+	ShadowCasterMode GetShadowMode() const;
+	/// <summary>
+	/// Sets how this object is treated by the cached shadow maps. Objects that are animated in their
+	/// shaders should be set to Dynamic, since their transforms don't change when they move
+	/// </summary>
+	RenderComponent* SetShadowMode(ShadowCasterMode value);
+
 	// Inherited from IComponent
 
 	virtual void RenderImGui() override;
@@ -54,6 +78,8 @@ protected:
 	Gameplay::MeshResource::Sptr _mesh;
 	// The object's material
 	Gameplay::Material::Sptr      _material;
+	// Whether the object is drawn into cached shadow maps, or re-drawn every frame
+	ShadowCasterMode              _shadowMode;
 
 	// If we want to use MeshFactory, we can populate this list
 	std::vector<MeshBuilderParam> _meshBuilderParams;
@@ -8,6 +8,9 @@ class RotatingBehaviour : public Gameplay::IComponent {
 public:
 	typedef std::shared_ptr<RotatingBehaviour> Sptr;
 
+	// Only rotates our own object, so we can be updated in parallel
+	static constexpr Gameplay::ComponentUpdateMode UPDATE_MODE = Gameplay::ComponentUpdateMode::ThreadSafe;
+
 	RotatingBehaviour() = default;
 	glm::vec3 RotationSpeed;
 
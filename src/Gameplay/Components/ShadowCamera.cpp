@@ -12,11 +12,19 @@ ShadowCamera::ShadowCamera() :
 	NormalBias(0.0001f),
 	Intensity(1.0f),
 	Range(100.0f),
-	_depthBuffer(nullptr),
+	CascadeSplitLambda(0.75f),
+	CascadeDistance(60.0f),
+	_atlas(nullptr),
+	_atlasTile(glm::uvec4(0)),
+	_isStaticCacheValid(false),
+	_cachedTransformVersion(0),
+	_cachedStaticVersion(0),
 	_projectionMask(nullptr),
 	_color(glm::vec4(1.0f)),
 	_bufferResolution(glm::ivec2(512)), 
-	_projectionMatrix(glm::perspective(glm::radians(90.0f), 1.0f, 0.1f, 100.0f))
+	_projectionMatrix(glm::perspective(glm::radians(90.0f), 1.0f, 0.1f, 100.0f)),
+	_cascadeCount(0),
+	_cascades()
 { }
 
 ShadowCamera::~ShadowCamera() = default;
@@ -32,9 +40,6 @@ const glm::vec4& ShadowCamera::GetColor() const {
 void ShadowCamera::SetBufferResolution(const glm::ivec2& value) {
 	LOG_ASSERT(value.x * value.y > 0, "Buffer size must be > 0");
 	_bufferResolution = value;
-	if (_depthBuffer != nullptr) {
-		_depthBuffer->Resize(value);
-	}
 }
 
 const glm::ivec2& ShadowCamera::GetBufferResolution() const {
@@ -43,6 +48,7 @@ const glm::ivec2& ShadowCamera::GetBufferResolution() const {
 
 void ShadowCamera::SetProjection(const glm::mat4& value) {
 	_projectionMatrix = value;
+	InvalidateStaticCache();
 }
 
 const glm::mat4& ShadowCamera::GetProjection() const {
@@ -54,6 +60,50 @@ glm::mat4 ShadowCamera::GetViewProjection() const
 	return _projectionMatrix * GetGameObject()->GetInverseTransform();
 }
 
+void ShadowCamera::SetCascadeCount(uint32_t value) {
+	LOG_ASSERT(value <= ShadowCascades::MAX_CASCADES, "A light can have at most {} cascades", ShadowCascades::MAX_CASCADES);
+	if (value != _cascadeCount) {
+		InvalidateStaticCache();
+	}
+	_cascadeCount = value;
+}
+
+uint32_t ShadowCamera::GetCascadeCount() const {
+	return _cascadeCount;
+}
+
+glm::uvec2 ShadowCamera::GetCascadeGrid() const {
+	return glm::uvec2(_cascadeCount > 1 ? 2 : 1, _cascadeCount > 2 ? 2 : 1);
+}
+
+void ShadowCamera::UpdateCascades(const glm::mat4& cameraTransform, const glm::mat4& cameraProjection, float zNear, float zFar) {
+	if (_cascadeCount == 0 || _atlasTile.z == 0) {
+		return;
+	}
+
+	float splits[ShadowCascades::MAX_CASCADES + 1];
+	ShadowCascades::ComputeSplits(zNear, glm::clamp(CascadeDistance, zNear + 0.01f, zFar), _cascadeCount, CascadeSplitLambda, splits);
+	for (uint32_t ix = 0; ix < _cascadeCount; ix++) {
+		glm::uvec4 tile = GetCascadeTile(ix);
+		// Pull the near plane back by the light's range, so casters outside of the camera's view still cast shadows into it
+		_cascades[ix] = ShadowCascades::FitCascade(
+			cameraTransform, cameraProjection, splits[ix], splits[ix + 1],
+			GetGameObject()->GetTransform(), glm::min(tile.z, tile.w), Range);
+	}
+}
+
+const ShadowCascades::Cascade& ShadowCamera::GetCascade(uint32_t index) const {
+	LOG_ASSERT(index < _cascadeCount, "Cascade index out of range");
+	return _cascades[index];
+}
+
+glm::uvec4 ShadowCamera::GetCascadeTile(uint32_t index) const {
+	glm::uvec2 grid = GetCascadeGrid();
+	glm::uvec2 size = glm::uvec2(_atlasTile.z, _atlasTile.w) / grid;
+	glm::uvec2 cell = glm::uvec2(index % grid.x, index / grid.x);
+	return glm::uvec4(_atlasTile.x + cell.x * size.x, _atlasTile.y + cell.y * size.y, size.x, size.y);
+}
+
 void ShadowCamera::SetProjectionMask(const Texture2D::Sptr& image) {
 	_projectionMask = image;
 
@@ -68,13 +118,7 @@ const Texture2D::Sptr& ShadowCamera::GetProjectionMask() const {
 void ShadowCamera::OnLoad()
 {
 	LOG_ASSERT(_bufferResolution.x * _bufferResolution.y > 0, "Buffer size must be > 0");
-
-	FramebufferDescriptor desc;
-	desc.Width  = _bufferResolution.x;
-	desc.Height = _bufferResolution.y;
-	desc.RenderTargets[RenderTargetAttachment::Depth] = RenderTargetDescriptor(RenderTargetType::Depth32, true, true);
-
-	_depthBuffer = std::make_shared<Framebuffer>(desc);
+	InvalidateStaticCache();
 }
 
 nlohmann::json ShadowCamera::ToJson() const
@@ -88,7 +132,10 @@ nlohmann::json ShadowCamera::ToJson() const
 		{ "resolution", _bufferResolution },
 		{ "flags", *Flags },
 		{ "mask", _projectionMask ? _projectionMask->GetGUID().str() : "null" },
-		{ "projection", _projectionMatrix }
+		{ "projection", _projectionMatrix },
+		{ "cascades", _cascadeCount },
+		{ "cascade_lambda", CascadeSplitLambda },
+		{ "cascade_distance", CascadeDistance }
 	};
 }
 
@@ -105,12 +152,48 @@ ShadowCamera::Sptr ShadowCamera::FromJson(const nlohmann::json& data)
 	result->_bufferResolution = JsonGet(data, "resolution", result->_bufferResolution);
 	result->_projectionMask = ResourceManager::Get<Texture2D>(Guid(JsonGet<std::string>(data, "mask", "null")));
 	result->_projectionMatrix = JsonGet(data, "projection", result->_projectionMatrix);
+	result->_cascadeCount = glm::min(JsonGet(data, "cascades", result->_cascadeCount), ShadowCascades::MAX_CASCADES);
+	result->CascadeSplitLambda = JsonGet(data, "cascade_lambda", result->CascadeSplitLambda);
+	result->CascadeDistance = JsonGet(data, "cascade_distance", result->CascadeDistance);
 	return result;
 }
 
-const Framebuffer::Sptr& ShadowCamera::GetDepthBuffer() const
+void ShadowCamera::SetAtlasTile(const Texture2D::Sptr& atlas, const glm::uvec4& tile)
+{
+	if (atlas != _atlas || tile != _atlasTile) {
+		InvalidateStaticCache();
+	}
+	_atlas = atlas;
+	_atlasTile = tile;
+}
+
+const glm::uvec4& ShadowCamera::GetAtlasTile() const
+{
+	return _atlasTile;
+}
+
+const Texture2D::Sptr& ShadowCamera::GetAtlas() const
+{
+	return _atlas;
+}
+
+bool ShadowCamera::IsStaticCacheValid(uint64_t staticVersion) const
+{
+	return _isStaticCacheValid &&
+		_cachedStaticVersion == staticVersion &&
+		_cachedTransformVersion == GetGameObject()->GetTransformVersion();
+}
+
+void ShadowCamera::MarkStaticCacheBuilt(uint64_t staticVersion)
 {
-	return _depthBuffer;
+	_isStaticCacheValid = true;
+	_cachedStaticVersion = staticVersion;
+	_cachedTransformVersion = GetGameObject()->GetTransformVersion();
+}
+
+void ShadowCamera::InvalidateStaticCache()
+{
+	_isStaticCacheValid = false;
 }
 
 void ShadowCamera::RenderImGui()
@@ -135,6 +218,18 @@ void ShadowCamera::RenderImGui()
 		SetBufferResolution(_bufferResolution);
 	}
 
+	// Cascades
+	{
+		int cascades = _cascadeCount;
+		if (ImGui::SliderInt("Cascades", &cascades, 0, ShadowCascades::MAX_CASCADES)) {
+			SetCascadeCount(cascades);
+		}
+		if (_cascadeCount > 0) {
+			ImGui::SliderFloat("Split Lambda", &CascadeSplitLambda, 0.0f, 1.0f);
+			ImGui::DragFloat("Shadow Distance", &CascadeDistance, 0.1f, 1.0f, 1000.0f);
+		}
+	}
+
 	// Projection Mask
 	{
 		ImGui::Text("Projector");
@@ -169,13 +264,16 @@ void ShadowCamera::RenderImGui()
 		if (ImGui::Checkbox("Show Depth", &checked)) {
 			ImGui::GetStateStorage()->SetBool(ImGui::GetID("show_depth"), checked);
 		}
-		if (_depthBuffer != nullptr && checked) {
-			Texture2D::Sptr depth = _depthBuffer->GetTextureAttachment(RenderTargetAttachment::Depth);
-
+		if (_atlas != nullptr && _atlasTile.z > 0 && checked) {
 			int width = ImGui::GetContentRegionAvailWidth();
 
+			// Only show our tile of the atlas
+			glm::vec2 atlasSize = glm::vec2(_atlas->GetWidth(), _atlas->GetHeight());
+			glm::vec2 uvMin = glm::vec2(_atlasTile.x, _atlasTile.y) / atlasSize;
+			glm::vec2 uvMax = glm::vec2(_atlasTile.x + _atlasTile.z, _atlasTile.y + _atlasTile.w) / atlasSize;
+
 			ImGui::Columns(1);
-			ImGuiHelper::DrawLinearDepthTexture(depth, glm::ivec2(width, width), 0.1f, 100.0f);
+			ImGuiHelper::DrawLinearDepthTexture(_atlas, glm::ivec2(width, width * _atlasTile.w / _atlasTile.z), 0.1f, 100.0f, uvMin, uvMax);
 		}
 	}
 
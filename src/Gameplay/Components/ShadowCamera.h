@@ -3,6 +3,7 @@
 #include "Graphics/Textures/Texture2D.h"
 #include "Gameplay/Components/IComponent.h"
 #include "Graphics/ShaderProgram.h"
+#include "Graphics/ShadowCascades.h"
 
 ENUM_FLAGS(ShadowFlags, uint32_t,
 	None = 0,
@@ -30,6 +31,15 @@ public:
 	float Intensity;
 	float Range;
 
+	/// <summary>
+	/// For cascaded lights, blends the cascade splits between uniform (0) and logarithmic (1)
+	/// </summary>
+	float CascadeSplitLambda;
+	/// <summary>
+	/// For cascaded lights, the distance from the main camera that shadows are drawn out to
+	/// </summary>
+	float CascadeDistance;
+
 	ShadowCamera();
 	virtual ~ShadowCamera();
 
@@ -45,12 +55,13 @@ public:
 	const glm::vec4& GetColor() const;
 
 	/// <summary>
-	/// Resizes this light's depth buffer, both dimensions must be non-zero
+	/// Sets the largest tile this light may be given in the shadow atlas, both dimensions must be non-zero.
+	/// The light gets smaller tiles when it covers less of the screen, or when the atlas is full
 	/// </summary>
-	/// <param name="value">The new size of the buffer, in pixels</param>
+	/// <param name="value">The new maximum size of the light's shadow map, in pixels</param>
 	void SetBufferResolution(const glm::ivec2& value);
 	/// <summary>
-	/// Returns the resolution of this light's depth buffer in pixels
+	/// Returns the largest size of this light's shadow map in pixels
 	/// </summary>
 	const glm::ivec2& GetBufferResolution() const;
 
@@ -69,6 +80,40 @@ public:
 	/// </summary>
 	glm::mat4 GetViewProjection() const;
 
+	/// <summary>
+	/// Sets the number of cascades to split the main camera's view into, between 0 and ShadowCascades::MAX_CASCADES.
+	/// With 0 cascades the light uses its own projection (see SetProjection), otherwise it acts as a directional
+	/// light, and each cascade gets an orthographic projection that is fit around a slice of the main camera's view
+	/// </summary>
+	/// <param name="value">The number of cascades to use</param>
+	void SetCascadeCount(uint32_t value);
+	/// <summary>
+	/// Gets the number of cascades the light is split into, 0 if the light is not cascaded
+	/// </summary>
+	uint32_t GetCascadeCount() const;
+	/// <summary>
+	/// Gets the number of columns and rows of cascades in the light's atlas tile, each cascade is GetBufferResolution in size
+	/// </summary>
+	glm::uvec2 GetCascadeGrid() const;
+	/// <summary>
+	/// Re-fits the cascades around the main camera, this is called by the renderer after the atlas tile has been assigned
+	/// </summary>
+	/// <param name="cameraTransform">The main camera's local to world transform</param>
+	/// <param name="cameraProjection">The main camera's projection matrix</param>
+	/// <param name="zNear">The main camera's near plane</param>
+	/// <param name="zFar">The main camera's far plane</param>
+	void UpdateCascades(const glm::mat4& cameraTransform, const glm::mat4& cameraProjection, float zNear, float zFar);
+	/// <summary>
+	/// Gets one of the light's cascades, as of the last UpdateCascades
+	/// </summary>
+	/// <param name="index">The index of the cascade, less than GetCascadeCount</param>
+	const ShadowCascades::Cascade& GetCascade(uint32_t index) const;
+	/// <summary>
+	/// Gets the part of the light's atlas tile that a cascade renders into (x, y, width, height) in pixels
+	/// </summary>
+	/// <param name="index">The index of the cascade, less than GetCascadeCount</param>
+	glm::uvec4 GetCascadeTile(uint32_t index) const;
+
 	/// <summary>
 	/// Sets the image to use for projection, and enables image projection
 	/// </summary>
@@ -80,9 +125,36 @@ public:
 	const Texture2D::Sptr& GetProjectionMask() const;
 
 	/// <summary>
-	/// Gets the shadow camera's depth buffer that it renders to
+	/// Sets the tile of the shadow atlas that this light renders its depth into, this is managed by the renderer.
+	/// Moving to a different tile invalidates the static cache
+	/// </summary>
+	/// <param name="atlas">The atlas depth texture</param>
+	/// <param name="tile">The light's tile in the atlas (x, y, width, height) in pixels, or all 0 if the light has no tile</param>
+	void SetAtlasTile(const Texture2D::Sptr& atlas, const glm::uvec4& tile);
+	/// <summary>
+	/// Gets the light's tile in the shadow atlas (x, y, width, height) in pixels, the width is 0 if the light has no tile
+	/// </summary>
+	const glm::uvec4& GetAtlasTile() const;
+	/// <summary>
+	/// Gets the shadow atlas that the light's depth is rendered into
+	/// </summary>
+	const Texture2D::Sptr& GetAtlas() const;
+
+	/// <summary>
+	/// Returns true if the static casters cached in the light's tile are still up to date, they go stale when
+	/// the light moves, its projection or tile changes, or the set of static casters changes
+	/// </summary>
+	/// <param name="staticVersion">The current version of the static casters, see ShadowCasterTracker</param>
+	bool IsStaticCacheValid(uint64_t staticVersion) const;
+	/// <summary>
+	/// Records that the static depth buffer has just been rendered
+	/// </summary>
+	/// <param name="staticVersion">The version of the static casters that were rendered</param>
+	void MarkStaticCacheBuilt(uint64_t staticVersion);
+	/// <summary>
+	/// Forces the static depth buffer to be re-rendered next frame
 	/// </summary>
-	const Framebuffer::Sptr& GetDepthBuffer() const;
+	void InvalidateStaticCache();
 
 	// Inherited from IComponent
 
@@ -93,14 +165,22 @@ public:
 	MAKE_TYPENAME(ShadowCamera);
 
 protected:
-	// Framebuffer we render into to get depth
-	Framebuffer::Sptr _depthBuffer;
+	// The shadow atlas, and our tile within it
+	Texture2D::Sptr   _atlas;
+	glm::uvec4        _atlasTile;
+	// What the static casters in our tile were last rendered with
+	bool              _isStaticCacheValid;
+	uint32_t          _cachedTransformVersion;
+	uint64_t          _cachedStaticVersion;
 	// The image to project from this light
 	Texture2D::Sptr   _projectionMask;
 	// The color of the light
 	glm::vec4         _color;
-	// The resolution of _depthBuffer in pixels
+	// The largest tile we want in the shadow atlas, in pixels
 	glm::ivec2        _bufferResolution;
 	// The projection matrix of the light
 	glm::mat4         _projectionMatrix;
+	// The cascades that the main camera's view is split into, if any
+	uint32_t          _cascadeCount;
+	ShadowCascades::Cascade _cascades[ShadowCascades::MAX_CASCADES];
 };
\ No newline at end of file
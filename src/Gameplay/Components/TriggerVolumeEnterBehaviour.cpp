@@ -12,21 +12,21 @@ TriggerVolumeEnterBehaviour::~TriggerVolumeEnterBehaviour() = default;
 
 void TriggerVolumeEnterBehaviour::OnTriggerVolumeEntered(const std::shared_ptr<Gameplay::Physics::RigidBody>& body)
 {
-	if (GetGameObject()->Name == "Win Trigger" && body->GetGameObject()->Name == "Player")
+	if (GetGameObject()->GetName() == "Win Trigger" && body->GetGameObject()->GetName() == "Player")
 	{
 		GetGameObject()->GetScene()->FindObjectByName("Win Text")->Get<GuiPanel>()->SetTransparency(1.0f);
 	}
-	if (GetGameObject()->Name == "Enemy" && body->GetGameObject()->Name == "Player")
+	if (GetGameObject()->GetName() == "Enemy" && body->GetGameObject()->GetName() == "Player")
 	{
 		GetGameObject()->GetScene()->FindObjectByName("Lose Text")->Get<GuiPanel>()->SetTransparency(1.0f);
 	}
 
-	LOG_INFO("Body has entered {} trigger volume: {}", GetGameObject()->Name, body->GetGameObject()->Name);
+	LOG_INFO("Body has entered {} trigger volume: {}", GetGameObject()->GetName(), body->GetGameObject()->GetName());
 	_playerInTrigger = true;
 }
 
 void TriggerVolumeEnterBehaviour::OnTriggerVolumeLeaving(const std::shared_ptr<Gameplay::Physics::RigidBody>& body) {
-	LOG_INFO("Body has left {} trigger volume: {}", GetGameObject()->Name, body->GetGameObject()->Name);
+	LOG_INFO("Body has left {} trigger volume: {}", GetGameObject()->GetName(), body->GetGameObject()->GetName());
 	_playerInTrigger = false;
 }
 
@@ -14,64 +14,22 @@
 #include "Gameplay/Scene.h"
 
 namespace Gameplay {
-	GameObject::GameObject() :
+	GameObject::GameObject(Scene* scene) :
 		IResource(),
-		Name("Unknown"),
 		HideInHierarchy(false),
+		_name("Unknown"),
 		_components(std::vector<IComponent::Sptr>()),
-		_scene(nullptr),
-		_position(ZERO),
-		_rotation(glm::quat(glm::vec3(0.0f))),
-		_scale(ONE),
-		_localTransform(MAT4_IDENTITY),
-		_inverseLocalTransform(MAT4_IDENTITY),
-		_isLocalTransformDirty(true),
-		_worldTransform(MAT4_IDENTITY),
-		_inverseWorldTransform(MAT4_IDENTITY),
-		_isWorldTransformDirty(true),
+		_scene(scene),
+		_transform(scene->_transforms.Create()),
 		_parent(WeakRef()),
 		_children(std::vector<WeakRef>())
 	{ }
 
-	void GameObject::_RecalcLocalTransform() const
-	{
-		if (_isLocalTransformDirty) {
-			_localTransform = glm::translate(MAT4_IDENTITY, _position) * glm::mat4_cast(_rotation) * glm::scale(MAT4_IDENTITY, _scale);
-			_inverseLocalTransform = glm::inverse(_localTransform);
-			_isLocalTransformDirty = false;
-			_isWorldTransformDirty = true;
-
-			// Dirty all the child objects world transforms
-			for (const auto& childPtr : _children) {
-				GameObject::Sptr childSptr = childPtr;
-				if (childSptr != nullptr) {
-					childSptr->_isWorldTransformDirty = true;
-				}
-			}
-		}
-	}
-
-	void GameObject::_RecalcWorldTransform() const {
-		// Start by determining our local transform if required
-		_RecalcLocalTransform();
-
-		// If our world transform has been marked as dirty, we need to recalculate it!
-		if (_isWorldTransformDirty) {
-			GameObject::Sptr parent = _parent;
-
-			// If out parent exists, we apply our local transformation relative to the parent's world transformation
-			if (parent != nullptr) {
-				_worldTransform = parent->GetTransform() * _localTransform;
-				_inverseWorldTransform = glm::inverse(_worldTransform);
-			}
+	GameObject::~GameObject() = default;
 
-			// If our parent is null, we can simply use the local transform as the world transform
-			else {
-				_worldTransform = _localTransform;
-				_inverseWorldTransform = _inverseLocalTransform;
-			}
-			_isWorldTransformDirty = false;
-		}
+	TransformStore& GameObject::_GetTransforms() const {
+		LOG_ASSERT(_transform != TransformStore::INVALID_HANDLE, "Object \"{}\" has been removed from its scene and no longer has a transform", _name);
+		return _scene->_transforms;
 	}
 
 	void GameObject::_PurgeDeletedChildren() {
@@ -82,7 +40,7 @@ namespace Gameplay {
 	}
 
 	void GameObject::LookAt(const glm::vec3& point) {
-		glm::mat4 rot = glm::lookAt(_position, point, glm::vec3(0.0f, 0.0f, 1.0f));
+		glm::mat4 rot = glm::lookAt(GetPosition(), point, glm::vec3(0.0f, 0.0f, 1.0f));
 		// Take the conjugate of the quaternion, as lookAt returns the *inverse* rotation
 		SetRotation(glm::conjugate(glm::quat_cast(rot)));
 	}
@@ -112,12 +70,11 @@ namespace Gameplay {
 	}
 
 	void GameObject::SetPosition(const glm::vec3& position) {
-		_position = position;
-		_isLocalTransformDirty = true;
+		_GetTransforms().SetPosition(_transform, position);
 	}
 
 	const glm::vec3& GameObject::GetPosition() const {
-		return _position;
+		return _GetTransforms().GetPosition(_transform);
 	}
 
 	glm::vec3 GameObject::GetWorldPosition() const {
@@ -125,51 +82,48 @@ namespace Gameplay {
 	}
 
 	void GameObject::SetRotation(const glm::quat& value) {
-		_rotation = value;
-		_isLocalTransformDirty = true;
+		_GetTransforms().SetRotation(_transform, value);
 	}
 
 	const glm::quat& GameObject::GetRotation() const {
-		return _rotation;
+		return _GetTransforms().GetRotation(_transform);
 	}
 
 	void GameObject::SetRotation(const glm::vec3& eulerAngles) {
-		_rotation = glm::quat(glm::radians(eulerAngles));
-		_isLocalTransformDirty = true;
+		_GetTransforms().SetRotation(_transform, glm::quat(glm::radians(eulerAngles)));
 	}
 
 	glm::vec3 GameObject::GetRotationEuler() const {
-		return glm::degrees(glm::eulerAngles(_rotation));
+		return glm::degrees(glm::eulerAngles(GetRotation()));
 	}
 
 	void GameObject::SetScale(const glm::vec3& value) {
-		_scale = value;
-		_isLocalTransformDirty = true;
+		_GetTransforms().SetScale(_transform, value);
 	}
 
 	const glm::vec3& GameObject::GetScale() const {
-		return _scale;
+		return _GetTransforms().GetScale(_transform);
 	}
 
 	const glm::mat4& GameObject::GetTransform() const {
-		_RecalcWorldTransform();
-		return _worldTransform;
+		return _GetTransforms().GetWorldTransform(_transform);
 	}
 
 	const glm::mat4& GameObject::GetInverseTransform() const {
-		_RecalcWorldTransform();
-		return _inverseWorldTransform;
+		return _GetTransforms().GetInverseWorldTransform(_transform);
+	}
+
+	uint32_t GameObject::GetTransformVersion() const {
+		return _GetTransforms().GetWorldVersion(_transform);
 	}
 
 	const glm::mat4& GameObject::GetLocalTransform() const
 	{
-		_RecalcLocalTransform();
-		return _localTransform;
+		return _GetTransforms().GetLocalTransform(_transform);
 	}
 
-	const glm::mat4& GameObject::GetInverseLocalTransform() const {
-		_RecalcLocalTransform();
-		return _inverseLocalTransform;
+	glm::mat4 GameObject::GetInverseLocalTransform() const {
+		return _GetTransforms().GetInverseLocalTransform(_transform);
 	}
 
 	void GameObject::RenderGUI() {
@@ -216,8 +170,10 @@ namespace Gameplay {
 			}
 		}
 
-		_RecalcLocalTransform();
-		_RecalcWorldTransform();
+		_FinishUpdate();
+	}
+
+	void GameObject::_FinishUpdate() {
 		_PurgeDeletedChildren();
 	}
 
@@ -275,13 +231,13 @@ namespace Gameplay {
 
 		// As long as the child is not already a child of this gameobject, add it
 		if (it == _children.end()) {
-			// Add child, set parent, and mark it's world transform as dirty, since the parent's transform now 
+			// Add child, set parent, and parent the child's transform to ours, since the parent's transform now 
 			// applies to the child
 			_children.push_back(child);
 			child->_parent = _selfRef.lock();
-			child->_isWorldTransformDirty = true;
+			_GetTransforms().SetParent(child->_transform, _transform);
 		} else {
-			LOG_WARN("Attempting to add same child twice, ignoring: {}", child->Name);
+			LOG_WARN("Attempting to add same child twice, ignoring: {}", child->GetName());
 		}
 	}
 
@@ -292,6 +248,10 @@ namespace Gameplay {
 		if (it != _children.end()) { 
 			// Clear the object's parent and remove from our list of children
 			child->_parent.Reset();
+			// Children that have already been removed from the scene have given up their transform
+			if (child->_transform != TransformStore::INVALID_HANDLE) {
+				_scene->_transforms.SetParent(child->_transform, TransformStore::INVALID_HANDLE);
+			}
 			_children.erase(it);
 			return true;
 		} else {
@@ -315,16 +275,16 @@ namespace Gameplay {
 		ImGui::PushID(this); // Push a new ImGui ID scope for this object
 		// Since we're allowing names to change, we need to use the ### to have a static ID for the header
 		static char buffer[256];
-		sprintf_s(buffer, 256, "%s###GO_HEADER", Name.c_str());
+		sprintf_s(buffer, 256, "%s###GO_HEADER", _name.c_str());
 		if (ImGui::CollapsingHeader(buffer)) {
 			ImGui::Indent();
 
 			// Draw a textbox for our name
 			static char nameBuff[256];
-			memcpy(nameBuff, Name.c_str(), Name.size());
-			nameBuff[Name.size()] = '\0';
+			memcpy(nameBuff, _name.c_str(), _name.size());
+			nameBuff[_name.size()] = '\0';
 			if (ImGui::InputText("", nameBuff, 256)) {
-				Name = nameBuff;
+				SetName(nameBuff);
 			}
 			ImGui::SameLine();
 			if (ImGuiHelper::WarningButton("Delete")) {
@@ -354,16 +314,19 @@ namespace Gameplay {
 			}
 
 			// Render position label
-			_isLocalTransformDirty |= LABEL_LEFT(ImGui::DragFloat3, "Position", &_position.x, 0.01f);
+			glm::vec3 position = GetPosition();
+			if (LABEL_LEFT(ImGui::DragFloat3, "Position", &position.x, 0.01f)) {
+				SetPosition(position);
+			}
 			
 			// Get the ImGui storage state so we can avoid gimbal locking issues by storing euler angles in the editor
 			glm::vec3 euler = GetRotationEuler();
 			ImGuiStorage* guiStore = ImGui::GetStateStorage();
 
-			// Extract the angles from the storage, note that we're only using the address of the position for unique IDs
-			euler.x = guiStore->GetFloat(ImGui::GetID(&_position.x), euler.x);
-			euler.y = guiStore->GetFloat(ImGui::GetID(&_position.y), euler.y);
-			euler.z = guiStore->GetFloat(ImGui::GetID(&_position.z), euler.z);
+			// Extract the angles from the storage, the IDs are unique since we're inside this object's ID scope
+			euler.x = guiStore->GetFloat(ImGui::GetID("##euler_x"), euler.x);
+			euler.y = guiStore->GetFloat(ImGui::GetID("##euler_y"), euler.y);
+			euler.z = guiStore->GetFloat(ImGui::GetID("##euler_z"), euler.z);
 
 			//Draw the slider for angles
 			if (LABEL_LEFT(ImGui::DragFloat3, "Rotation", &euler.x, 1.0f)) {
@@ -371,16 +334,19 @@ namespace Gameplay {
 				euler = Wrap(euler, -180.0f, 180.0f);
 
 				// Update the editor state with our new values
-				guiStore->SetFloat(ImGui::GetID(&_position.x), euler.x);
-				guiStore->SetFloat(ImGui::GetID(&_position.y), euler.y);
-				guiStore->SetFloat(ImGui::GetID(&_position.z), euler.z);
+				guiStore->SetFloat(ImGui::GetID("##euler_x"), euler.x);
+				guiStore->SetFloat(ImGui::GetID("##euler_y"), euler.y);
+				guiStore->SetFloat(ImGui::GetID("##euler_z"), euler.z);
 
 				//Send new rotation to the gameobject
 				SetRotation(euler);
 			}
 			
 			// Draw the scale
-			_isLocalTransformDirty |= LABEL_LEFT(ImGui::DragFloat3, "Scale   ", &_scale.x, 0.01f, 0.0f);
+			glm::vec3 scale = GetScale();
+			if (LABEL_LEFT(ImGui::DragFloat3, "Scale   ", &scale.x, 0.01f, 0.0f)) {
+				SetScale(scale);
+			}
 
 			ImGui::Separator();
 			ImGui::TextUnformatted("Components");
@@ -438,10 +404,17 @@ namespace Gameplay {
 			ImGui::Unindent();
 		}
 		ImGui::PopID(); // Pop the ImGui ID scope for the object
+	}
 
-		// For if we're not in play mode
-		_RecalcLocalTransform();
-		_RecalcWorldTransform();
+	void GameObject::SetName(const std::string& name) {
+		if (name == _name) {
+			return;
+		}
+		std::string oldName = _name;
+		_name = name;
+		if (_scene != nullptr) {
+			_scene->_OnObjectRenamed(this, oldName);
+		}
 	}
 
 	std::shared_ptr<GameObject> GameObject::SelfRef() {
@@ -452,19 +425,16 @@ namespace Gameplay {
 	{
 		// We need to manually construct since the GameObject constructor is
 		// protected. We can call it here since Scene is a friend class of GameObjects
-		GameObject::Sptr result(new GameObject());
-		result->_scene = scene;
+		GameObject::Sptr result(new GameObject(scene));
 
 		// Load in basic info
-		result->Name = data["name"];
+		result->_name = data["name"];
 		result->_guid = Guid(data["guid"]);
 		result->_parent = WeakRef(Guid(data.contains("parent") ? data["parent"] : "null"), nullptr);
-		result->_position = (data["position"]);
-		result->_rotation = (data["rotation"]);
-		result->_scale    = (data["scale"]);
+		result->SetPosition(data["position"]);
+		result->SetRotation((glm::quat)(data["rotation"]));
+		result->SetScale(data["scale"]);
 		result->HideInHierarchy = JsonGet(data, "hide_in_inspector", false);
-		result->_isLocalTransformDirty = true;
-		result->_isWorldTransformDirty = true;
 
 		// Since our components are stored based on the type name, we iterate
 		// on the keys and values from the components object
@@ -484,14 +454,50 @@ namespace Gameplay {
 		return result;
 	}
 
+	GameObject::Sptr GameObject::FromBinary(Scene* scene, const SceneBinary::Reader& reader, uint32_t index)
+	{
+		const SceneBinary::BinaryObject& record = reader.GetObjectRecord(index);
+		GameObject::Sptr result(new GameObject(scene));
+
+		// Load in basic info, everything is read straight out of the file
+		Guid parent = SceneBinary::ReadGuid(record.Parent);
+		result->_name = reader.GetString(record.Name);
+		result->_guid = SceneBinary::ReadGuid(record.Guid);
+		result->_parent = parent.isValid() ? WeakRef(parent, nullptr) : WeakRef();
+		result->SetPosition(glm::vec3(record.Position[0], record.Position[1], record.Position[2]));
+		result->SetRotation(glm::quat(record.Rotation[3], record.Rotation[0], record.Rotation[1], record.Rotation[2]));
+		result->SetScale(glm::vec3(record.Scale[0], record.Scale[1], record.Scale[2]));
+		result->HideInHierarchy = (record.Flags & SceneBinary::OBJECT_HIDE_IN_HIERARCHY) != 0;
+
+		// Components are still loaded from JSON, but each one only decodes its own small blob
+		result->_components.reserve(record.NumComponents);
+		for (uint32_t ix = record.FirstComponent; ix < record.FirstComponent + record.NumComponents; ix++) {
+			const SceneBinary::BinaryComponent& componentRecord = reader.GetComponentRecord(ix);
+			std::string typeName(reader.GetTypeName(componentRecord.Type));
+			IComponent::Sptr component = scene->Components().Load(typeName, reader.ReadComponentData(componentRecord),
+				SceneBinary::ReadGuid(componentRecord.Guid), (componentRecord.Flags & SceneBinary::COMPONENT_ENABLED) != 0);
+			if (component == nullptr) {
+				LOG_WARN("Skipping component of unknown type \"{}\" on \"{}\"", typeName, result->_name);
+				continue;
+			}
+			component->_context = result.get();
+
+			// Add component to object and allow it to perform self initialization
+			result->_components.push_back(component);
+			component->OnLoad();
+		}
+
+		return result;
+	}
+
 	nlohmann::json GameObject::ToJson() const {
 		GameObject::Sptr parent = _parent;
 		nlohmann::json result = {
-			{ "name", Name },
+			{ "name", _name },
 			{ "guid", _guid.str() },
-			{ "position", _position },
-			{ "rotation", _rotation },
-			{ "scale",    _scale },
+			{ "position", GetPosition() },
+			{ "rotation", GetRotation() },
+			{ "scale",    GetScale() },
 			{ "parent",   parent == nullptr ? "null" : parent->_guid.str() },
 			{ "hide_in_inspector", HideInHierarchy }
 		};
@@ -11,6 +11,7 @@
 // Others
 #include "Gameplay/Components/IComponent.h"
 #include "Gameplay/Components/ComponentManager.h"
+#include "Gameplay/SceneBinary.h"
 #include "Utils/ResourceManager/IResource.h"
 
 class InspectorWindow;
@@ -19,6 +20,7 @@ class HierarchyWindow;
 namespace Gameplay {
 // Predeclaration for Scene
 	class Scene;
+	class TransformStore;
 
 	namespace Physics {
 		class TriggerVolume;
@@ -133,12 +135,21 @@ namespace Gameplay {
 			void Reset();
 		};
 
-		// Human readable name for the object
-		std::string             Name;
-
 		// Hack to hide instances from the hierarchy (like when adding lots of instances)
 		bool HideInHierarchy = false;
 
+		virtual ~GameObject();
+
+		/// <summary>
+		/// Gets the human readable name for the object
+		/// </summary>
+		const std::string& GetName() const { return _name; }
+		/// <summary>
+		/// Renames this object, and updates the scene's name lookup to match
+		/// </summary>
+		/// <param name="name">The new name for the object</param>
+		void SetName(const std::string& name);
+
 		/// <summary>
 		/// Rotates this object to look at the given point in world coordinates
 		/// </summary>
@@ -176,7 +187,8 @@ namespace Gameplay {
 		/// <param name="position">The new position for the object in world space</param>
 		void SetPosition(const glm::vec3& position);
 		/// <summary>
-		/// Gets the object's position in world space
+		/// Gets the object's position relative to its parent. The reference is only valid until the next
+		/// object is created or the scene is updated
 		/// </summary>
 		const glm::vec3& GetPosition() const;
 
@@ -188,7 +200,8 @@ namespace Gameplay {
 		/// <param name="value">The rotation quaternion for the object</param>
 		void SetRotation(const glm::quat& value);
 		/// <summary>
-		/// Gets the object's rotation as a quaternion value
+		/// Gets the object's rotation as a quaternion value. The reference is only valid until the next
+		/// object is created or the scene is updated
 		/// </summary>
 		const glm::quat& GetRotation() const;
 
@@ -208,23 +221,35 @@ namespace Gameplay {
 		/// <param name="value">The new scaling factor for the game object</param>
 		void SetScale(const glm::vec3& value);
 		/// <summary>
-		/// Gets the scaling factor for the game object
+		/// Gets the scaling factor for the game object. The reference is only valid until the next
+		/// object is created or the scene is updated
 		/// </summary>
 		const glm::vec3& GetScale() const;
 
 		/// <summary>
-		/// Gets or recalculates and gets the object's world transform
-		/// This matrix transforms points from local space to world space
+		/// Gets the object's world transform, recalculating it and any parents if required
+		/// This matrix transforms points from local space to world space. The reference is only valid
+		/// until the next object is created or the scene is updated
 		/// </summary>
 		const glm::mat4& GetTransform() const;
 		/// <summary>
-		/// Gets or recalculates the inverse of this object's world transform
-		/// This matrix transforms points from world space to local space
+		/// Gets the inverse of this object's world transform, recalculating it if required
+		/// This matrix transforms points from world space to local space. The reference is only valid
+		/// until the next object is created or the scene is updated
 		/// </summary>
 		const glm::mat4& GetInverseTransform() const;
+		/// <summary>
+		/// Gets a value that changes whenever this object's world transform changes, including when
+		/// any of its parents move
+		/// </summary>
+		uint32_t GetTransformVersion() const;
 
+		/// <summary>
+		/// Gets the object's transform relative to its parent. The reference is only valid until the next
+		/// object is created or the scene is updated
+		/// </summary>
 		const glm::mat4& GetLocalTransform() const;
-		const glm::mat4& GetInverseLocalTransform() const;
+		glm::mat4 GetInverseLocalTransform() const;
 
 		/// <summary>
 		/// Allows components to render GUI elements to the screen
@@ -330,6 +355,13 @@ namespace Gameplay {
 		/// </summary>
 		static GameObject::Sptr FromJson(Scene* scene, const nlohmann::json& data);
 		/// <summary>
+		/// Loads an object from a binary scene file
+		/// </summary>
+		/// <param name="scene">The scene that the object is being loaded into</param>
+		/// <param name="reader">The binary scene being loaded</param>
+		/// <param name="index">The index of the object in the binary scene's object table</param>
+		static GameObject::Sptr FromBinary(Scene* scene, const SceneBinary::Reader& reader, uint32_t index);
+		/// <summary>
 		/// Converts this object into it's JSON representation for storage
 		/// </summary>
 		nlohmann::json ToJson() const;
@@ -339,21 +371,12 @@ namespace Gameplay {
 		friend class InspectorWindow;
 		friend class HierarchyWindow;
 
-		// Rotation of the object as a quaternion
-		glm::quat _rotation;
-		// Position of the object
-		glm::vec3 _position;
-		// The scale of the object
-		glm::vec3 _scale;
-
-		// The object's world transform
-		mutable glm::mat4 _localTransform;
-		mutable glm::mat4 _inverseLocalTransform;
-		mutable bool _isLocalTransformDirty;
+		// Human readable name for the object, only changed through SetName so the scene's name lookup stays in sync
+		std::string _name;
 
-		mutable glm::mat4 _worldTransform;
-		mutable glm::mat4 _inverseWorldTransform;
-		mutable bool _isWorldTransformDirty;
+		// The handle for our position, rotation, scale, and matrices in the scene's transform store. The scene
+		// releases it when the object is removed, since the object itself may outlive the scene
+		uint32_t _transform;
 
 		// For the hierarchy
 		WeakRef _parent;
@@ -371,13 +394,20 @@ namespace Gameplay {
 		/// <summary>
 		/// Only scenes will be allowed to create gameobjects
 		/// </summary>
-		GameObject();
-
-		// Recalculates the transform matrix for the object when required
-		void _RecalcLocalTransform() const;
-		void _RecalcWorldTransform() const;
+		/// <param name="scene">The scene that the object belongs to, which will store its transform</param>
+		GameObject(Scene* scene);
 
 		void _PurgeDeletedChildren();
+
+		/// <summary>
+		/// Gets the scene's transform store, asserting that this object still has a transform in it
+		/// </summary>
+		TransformStore& _GetTransforms() const;
+
+		/// <summary>
+		/// Cleans up children after all components have been updated
+		/// </summary>
+		void _FinishUpdate();
 	};
 
 }
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include "Gameplay/Material.h"
+#include <algorithm>
 #include "Utils/ResourceManager/ResourceManager.h"
 #include "Utils/JsonGlmHelpers.h"
 #include "Graphics/Textures/TextureCube.h"
@@ -7,19 +8,27 @@
 #include "Utils/ImGuiHelper.h"
 #include "Graphics/Textures/Texture1D.h"
 #include "Graphics/Textures/Texture3D.h"
+#include "Graphics/UniformBlockPacker.h"
 
 namespace Gameplay {
 	Material::Material(const ShaderProgram::Sptr& shader) :
 		IResource(),
+		IsTransparent(false),
 		_shader(shader),
+		_keywords(),
+		_permutation(shader),
 		_uniforms(std::unordered_map<std::string, UniformData>())
 	{
 		_PopulateUniforms();
+		_BuildParameterBlocks();
 	}
 
 	Material::Material() :
 		IResource(),
+		IsTransparent(false),
 		_shader(nullptr),
+		_keywords(),
+		_permutation(nullptr),
 		_uniforms(std::unordered_map<std::string, UniformData>())
 	{ }
 
@@ -48,6 +57,10 @@ namespace Gameplay {
 				else {
 					memcpy(uniform.Value, value, ShaderDataTypeSize(type));
 				}
+				// Parameters in a block get sent to the GPU the next time we're applied
+				if (uniform.BlockIndex >= 0) {
+					_WriteToBlock(uniform);
+				}
 			}
 		}
 		// We couldn't find that uniform, log a warning
@@ -57,43 +70,69 @@ namespace Gameplay {
 	}
 
 	const ShaderProgram::Sptr& Material::GetShader() const {
+		return _permutation;
+	}
+
+	const ShaderProgram::Sptr& Material::GetBaseShader() const {
 		return _shader;
 	}
 
+	void Material::SetKeywords(const std::vector<std::string>& keywords) {
+		_keywords = keywords;
+		std::sort(_keywords.begin(), _keywords.end());
+		_keywords.erase(std::unique(_keywords.begin(), _keywords.end()), _keywords.end());
+		_UpdatePermutation();
+	}
+
+	void Material::SetKeyword(const std::string& keyword, bool enabled) {
+		std::vector<std::string> keywords = _keywords;
+		auto it = std::find(keywords.begin(), keywords.end(), keyword);
+		if (enabled && it == keywords.end()) {
+			keywords.push_back(keyword);
+		} else if (!enabled && it != keywords.end()) {
+			keywords.erase(it);
+		} else {
+			return;
+		}
+		SetKeywords(keywords);
+	}
+
+	const std::vector<std::string>& Material::GetKeywords() const {
+		return _keywords;
+	}
+
 	void Material::Apply() {
-		if (_shader != nullptr) {
-			// Skip the reserved # of texture slots
-			int textureSlot = 0;
-			
-			// Iterate over the uniforms map
-			for (auto&[name, data] : _uniforms) {
-				// The typecode is basically the underlying type of the uniform
-				// ex: float, matrix, texture, etc...
-				ShaderDataTypecode typeCode = GetShaderDataTypeCode(data.Type);
-
-				// If the uniform is a texture, we try and bind it, then move to the next slot
-				if (typeCode == ShaderDataTypecode::Texture) {
-					if (textureSlot >= MAX_TEXTURE_SLOTS) {
-						LOG_WARN("Ignoring material binding, exceeds allowed number of textures");
-					}
-					else {
-						ITexture::Sptr texture = data.TextureAsset;
-						if (texture != nullptr) {
-							texture->Bind(textureSlot);
-						}
-						else {
-							ITexture::Unbind(textureSlot);
-						}
-						// Send the slot to the shader
-						_shader->SetUniform(data.Location, data.Type, &textureSlot);
-						textureSlot++;
-					}
+		Apply(_permutation);
+	}
+
+	void Material::Apply(const ShaderProgram::Sptr& shader) {
+		if (shader != nullptr) {
+			// Upload any parameter blocks that have changed since we were last applied
+			for (ParameterBlock& block : _parameterBlocks) {
+				if (block.Dirty) {
+					block.Buffer->LoadData(block.Data.data(), static_cast<uint32_t>(block.Data.size()), 1);
+					block.Dirty = false;
+				}
+				block.Buffer->Bind(block.Binding);
+			}
+
+			const ApplyTable& table = _GetApplyTable(shader);
+
+			// Bind our textures to the slots the table assigned them
+			for (const ApplyTable::TextureSlot& texture : table.Textures) {
+				if (texture.Uniform != nullptr && texture.Uniform->TextureAsset != nullptr) {
+					texture.Uniform->TextureAsset->Bind(texture.Slot);
 				}
-				// The uniform is a plain ol' value type, send it in
 				else {
-					_shader->SetUniform(data.Location, data.Type, data.ArraySize > 1 ? data.ArrayBlock : data.Value, data.ArraySize);
+					ITexture::Unbind(texture.Slot);
 				}
 			}
+
+			// Any parameters that aren't in a block get sent in one by one
+			for (const ApplyTable::ValueUniform& value : table.Values) {
+				UniformData& data = *value.Uniform;
+				shader->SetUniform(value.Location, data.Type, data.ArraySize > 1 ? data.ArrayBlock : data.Value, static_cast<int>(data.ArraySize));
+			}
 		}
 	}
 
@@ -105,11 +144,14 @@ namespace Gameplay {
 		ImGuiHelper::ResourceDragSource(this, Name);
 
 		if (open) {
-			ImGui::Text("Shader: %s", _shader != nullptr ? _shader->GetDebugName().c_str() : "null");
+			ImGui::Text("Shader: %s", _permutation != nullptr ? _permutation->GetDebugName().c_str() : "null");
+			ImGui::Checkbox("Transparent", &IsTransparent);
 			// Draw all of our valid uniforms
 			for (auto&[key, value] : _uniforms) {
 				if (value.Location != -2 && value.Location != -1) {
-					value.RenderImGui();
+					if (value.RenderImGui() && value.BlockIndex >= 0) {
+						_WriteToBlock(value);
+					}
 				}
 			}
 
@@ -131,7 +173,12 @@ namespace Gameplay {
 		Material::Sptr result = std::make_shared<Material>();
 		result->OverrideGUID(Guid(data["guid"]));
 		result->Name = data["name"].get<std::string>();
+		result->IsTransparent = JsonGet(data, "transparent", false);
 		result->_shader = ResourceManager::Get<ShaderProgram>(Guid(data["shader"]));
+		result->_permutation = result->_shader;
+		if (data.contains("keywords") && data["keywords"].is_array()) {
+			result->SetKeywords(data["keywords"].get<std::vector<std::string>>());
+		}
 		result->_PopulateUniforms();
 
 		// material specific parameters'
@@ -139,12 +186,13 @@ namespace Gameplay {
 			// Iterate over all objects
 			for (auto& [key, value] : data["parameters"].items()) {
 				// Try loading a uniform from the blob, if successful, store it
-				Material::UniformData uniform = Material::UniformData::FromJson(value, key, result->_shader);
+				Material::UniformData uniform = Material::UniformData::FromJson(value, key, result->_permutation);
 				if (uniform.Location != -2) {
 					result->_uniforms[key] = uniform;
 				}
 			}
 		}
+		result->_BuildParameterBlocks();
 		return result;
 	}
 
@@ -152,7 +200,9 @@ namespace Gameplay {
 		nlohmann::json result ={
 			{ "guid", GetGUID().str() },
 			{ "name", Name },
+			{ "transparent", IsTransparent },
 			{ "shader", _shader ? _shader->GetGUID().str() : "null" },
+			{ "keywords", _keywords },
 			{ "parameters", nlohmann::json() }
 		};
 
@@ -171,29 +221,171 @@ namespace Gameplay {
 		UniformData& data = _uniforms[name];
 		if (data.Location == -2) {
 			ShaderProgram::UniformInfo uniform;
-			if (_shader->FindUniform(name, &uniform)) {
+			if (_permutation->FindUniform(name, &uniform)) {
 				// Ignoring our reserved textures
 				if (GetShaderDataTypeCode(uniform.Type) == ShaderDataTypecode::Texture && uniform.Binding >= MAX_TEXTURE_SLOTS) {
 					data.Location = -1;
 				}
 				else {
-					data = UniformData(name, _shader);
+					data = UniformData(name, _permutation);
 				}
 			} else {
 				data.Location = -1;
 			}
+			// We have a new uniform, so our apply tables are out of date
+			_applyTables.clear();
 		}
 		return data;
 	}
 
 	void Material::_PopulateUniforms()
 	{
-		const auto& uniforms = _shader->GetUniforms();
+		const auto& uniforms = _permutation->GetUniforms();
 		for (const auto& [key, value] : uniforms) {
 			_uniforms[key] = _GetUniform(key);
 		}
 	}
 
+	void Material::_UpdatePermutation()
+	{
+		if (_shader == nullptr) {
+			return;
+		}
+
+		ShaderProgram::Sptr permutation = _keywords.empty() ? _shader : _shader->GetPermutation(_keywords);
+		if (permutation == nullptr) {
+			LOG_WARN("Failed to compile shader permutation for material \"{}\", falling back to the base shader", Name);
+			permutation = _shader;
+		}
+		if (permutation == _permutation) {
+			return;
+		}
+		_permutation = permutation;
+
+		// Uniform locations are specific to a program, so look up each of our uniforms in the new permutation,
+		// keeping their values. Uniforms that only exist in the new permutation get picked up afterwards
+		for (auto& [name, data] : _uniforms) {
+			ShaderProgram::UniformInfo uniform;
+			if (!_permutation->FindUniform(name, &uniform) ||
+				(GetShaderDataTypeCode(uniform.Type) == ShaderDataTypecode::Texture && uniform.Binding >= MAX_TEXTURE_SLOTS)) {
+				data.Location = -1;
+			} else if (data.Type == ShaderDataType::None) {
+				data.Location = -2;
+			} else {
+				data.Location = uniform.Location;
+			}
+		}
+		_PopulateUniforms();
+		_BuildParameterBlocks();
+	}
+
+	void Material::_BuildParameterBlocks()
+	{
+		_parameterBlocks.clear();
+		_applyTables.clear();
+		for (auto& [name, data] : _uniforms) {
+			data.BlockIndex = -1;
+		}
+		if (_permutation == nullptr) {
+			return;
+		}
+
+		for (const auto& [blockName, blockInfo] : _permutation->GetUniformBlocks()) {
+			if (blockName.rfind(PARAMETER_BLOCK_PREFIX, 0) != 0) {
+				continue;
+			}
+
+			int blockIndex = static_cast<int>(_parameterBlocks.size());
+			ParameterBlock& block = _parameterBlocks.emplace_back();
+			block.Name    = blockName;
+			block.Binding = blockInfo.CurrentBinding;
+			block.Data.resize(blockInfo.SizeInBytes, 0);
+			block.Buffer  = std::make_shared<AbstractUniformBuffer>(static_cast<uint32_t>(blockInfo.SizeInBytes));
+			block.Dirty   = true;
+
+			for (const ShaderProgram::UniformInfo& member : blockInfo.SubUniforms) {
+				UniformData& data = _uniforms[member.Name];
+				// Keep the value we have if it's compatible (ex: when switching permutations)
+				if (data.Type != member.Type || data.ArraySize != static_cast<size_t>(member.ArraySize)) {
+					data = UniformData(member.Name, _permutation);
+				}
+				data.Location     = member.Location;
+				data.ArrayStride  = member.ArrayStride;
+				data.MatrixStride = member.MatrixStride;
+				data.BlockIndex   = blockIndex;
+				_WriteToBlock(data);
+			}
+		}
+	}
+
+	void Material::_WriteToBlock(const UniformData& uniform)
+	{
+		ParameterBlock& block = _parameterBlocks[uniform.BlockIndex];
+		UniformBlockMember member;
+		member.Type         = uniform.Type;
+		member.ArraySize    = uniform.ArraySize;
+		member.Offset       = uniform.Location;
+		member.ArrayStride  = uniform.ArrayStride;
+		member.MatrixStride = uniform.MatrixStride;
+		UniformBlockPacker::Write(member, uniform.ArraySize > 1 ? uniform.ArrayBlock : uniform.Value, block.Data.data(), block.Data.size());
+		block.Dirty = true;
+	}
+
+	const Material::ApplyTable& Material::_GetApplyTable(const ShaderProgram::Sptr& shader)
+	{
+		// Compare owners so we don't need to lock the weak pointers just to find our table
+		for (const ApplyTable& table : _applyTables) {
+			if (!table.Shader.owner_before(shader) && !shader.owner_before(table.Shader)) {
+				return table;
+			}
+		}
+
+		ApplyTable table;
+		table.Shader = shader;
+
+		// Textures are given slots in order of their names, so every material that uses the shader will agree on
+		// which slot each texture goes in. That means we only have to set the sampler uniforms once per shader
+		std::vector<const ShaderProgram::UniformInfo*> textures;
+		std::vector<std::string> names;
+		for (const auto& [name, info] : shader->GetUniforms()) {
+			if (GetShaderDataTypeCode(info.Type) == ShaderDataTypecode::Texture && info.Binding < MAX_TEXTURE_SLOTS) {
+				textures.push_back(&info);
+				names.push_back(name);
+			}
+		}
+		std::vector<size_t> slots = UniformBlockPacker::AssignTextureSlots(names, MAX_TEXTURE_SLOTS);
+		if (slots.size() < textures.size()) {
+			LOG_WARN("Ignoring material binding, exceeds allowed number of textures");
+		}
+		for (size_t ix = 0; ix < slots.size(); ix++) {
+			const ShaderProgram::UniformInfo& info = *textures[slots[ix]];
+			int slot = static_cast<int>(ix);
+			shader->SetUniform(info.Location, info.Type, &slot);
+
+			auto it = _uniforms.find(info.Name);
+			bool hasTexture = it != _uniforms.end() && it->second.IsTextureResource() && it->second.Location != -1;
+			table.Textures.push_back({ hasTexture ? &it->second : nullptr, slot });
+		}
+
+		// Everything else that isn't in a parameter block needs its location in this shader
+		for (auto& [name, data] : _uniforms) {
+			if (data.IsTextureResource() || data.BlockIndex >= 0 || data.Type == ShaderDataType::None || data.Location < 0) {
+				continue;
+			}
+			int location = data.Location;
+			if (shader != _permutation) {
+				ShaderProgram::UniformInfo info;
+				location = shader->FindUniform(name, &info) ? info.Location : -1;
+			}
+			if (location != -1) {
+				table.Values.push_back({ &data, location });
+			}
+		}
+
+		_applyTables.push_back(std::move(table));
+		return _applyTables.back();
+	}
+
 	bool Material::UniformData::RenderImGui() {
 		ImGui::PushID(Name.c_str());
 
@@ -412,6 +604,32 @@ namespace Gameplay {
 				ArrayBlock = malloc(ShaderDataTypeSize(Type) * ArraySize);
 			}
 		}
+		// Parameters in a material block aren't in the shader's uniform list, so we check the blocks as well
+		else if (shader != nullptr) {
+			for (const auto& [blockName, block] : shader->GetUniformBlocks()) {
+				if (blockName.rfind(PARAMETER_BLOCK_PREFIX, 0) != 0) {
+					continue;
+				}
+				for (const ShaderProgram::UniformInfo& member : block.SubUniforms) {
+					if (member.Name == uniformName) {
+						Name = uniformName;
+						Location = member.Location;
+						Type = member.Type;
+						ArraySize = member.ArraySize;
+						ArrayStride = member.ArrayStride;
+						MatrixStride = member.MatrixStride;
+
+						// These get packed into the block right away, so make sure they start zeroed
+						if (ArraySize > 1) {
+							ArrayBlock = calloc(ArraySize, ShaderDataTypeSize(Type));
+						} else {
+							memset(Value, 0, sizeof(Value));
+						}
+						return;
+					}
+				}
+			}
+		}
 	}
 
 	Material::UniformData::UniformData(const UniformData& other) :
@@ -421,6 +639,9 @@ namespace Gameplay {
 		Location = other.Location;
 		ArraySize = other.ArraySize;
 		Type = other.Type;
+		BlockIndex = other.BlockIndex;
+		ArrayStride = other.ArrayStride;
+		MatrixStride = other.MatrixStride;
 
 		if (GetShaderDataTypeCode(Type) == ShaderDataTypecode::Texture) {
 			TextureAsset = other.TextureAsset;
@@ -441,6 +662,9 @@ namespace Gameplay {
 		Location  = other.Location;
 		ArraySize = other.ArraySize;
 		Type      = other.Type;
+		BlockIndex   = other.BlockIndex;
+		ArrayStride  = other.ArrayStride;
+		MatrixStride = other.MatrixStride;
 
 		if (GetShaderDataTypeCode(Type) == ShaderDataTypecode::Texture) {
 			TextureAsset = other.TextureAsset;
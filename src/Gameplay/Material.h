@@ -2,6 +2,7 @@
 #include <memory>
 #include "Graphics/ShaderProgram.h"
 #include "Graphics/Textures/ITexture.h"
+#include "Graphics/Buffers/UniformBuffer.h"
 
 namespace Gameplay {
 	/// <summary>
@@ -19,10 +20,21 @@ namespace Gameplay {
 		/// </summary>
 		static const int MAX_TEXTURE_SLOTS = 14;
 
+		/// <summary>
+		/// Uniform blocks with names starting with this prefix (ex: b_Material) hold material parameters. The
+		/// material packs its values for these into a uniform buffer that matches the shader's layout, so
+		/// applying the material only needs to bind the buffer instead of setting each uniform
+		/// </summary>
+		static constexpr const char* PARAMETER_BLOCK_PREFIX = "b_Material";
+
 		/// <summary>
 		/// A human readable name for the material
 		/// </summary>
 		std::string     Name;
+		/// <summary>
+		/// True if objects using this material should be drawn after all opaque objects, from back to front
+		/// </summary>
+		bool            IsTransparent;
 
 		/// <summary>
 		/// Default constructor, to be used by Resource manager and smart pointers only
@@ -56,15 +68,43 @@ namespace Gameplay {
 		void Set(const std::string& name, ShaderDataType type, const void* value, size_t arraySize = 1ul);
 
 		/// <summary>
-		/// Gets the shader that this material is using
+		/// Gets the shader that this material is using, this is the permutation selected
+		/// by the material's keywords, see SetKeywords
 		/// </summary>
 		const ShaderProgram::Sptr& GetShader() const;
+		/// <summary>
+		/// Gets the shader that the material was created with, before any keywords are applied
+		/// </summary>
+		const ShaderProgram::Sptr& GetBaseShader() const;
+
+		/// <summary>
+		/// Sets the feature keywords for this material, which are defined in the shader to select
+		/// a permutation of it (ex: "ALPHA_TEST" to enable alpha testing). This lets shaders
+		/// compile out features the material does not use, instead of branching on uniforms
+		/// </summary>
+		/// <param name="keywords">The keywords to enable, in any order</param>
+		void SetKeywords(const std::vector<std::string>& keywords);
+		/// <summary>
+		/// Enables or disables a single feature keyword, see SetKeywords
+		/// </summary>
+		void SetKeyword(const std::string& keyword, bool enabled);
+		/// <summary>
+		/// Gets the feature keywords that are enabled for this material
+		/// </summary>
+		const std::vector<std::string>& GetKeywords() const;
 
 		/// <summary>
 		/// Handles applying this material's state to the OpenGL pipeline
-		/// Will bind the shader, update material uniforms, and bind textures
+		/// Will upload any parameter blocks that have changed and bind them, bind textures, and
+		/// update any material uniforms that are not in a parameter block
 		/// </summary>
 		virtual void Apply();
+		/// <summary>
+		/// Applies this material's state to a different shader than the one the material was created with,
+		/// such as a variant of the material's shader. Uniforms are matched up by name
+		/// </summary>
+		/// <param name="shader">The shader to send the material's uniforms to</param>
+		void Apply(const ShaderProgram::Sptr& shader);
 
 		/// <summary>
 		/// Renders some UI controls for manipulating a material at runtime
@@ -108,6 +148,11 @@ namespace Gameplay {
 			// The size of the array, in elements
 			size_t         ArraySize;
 			int            BindingSlot;
+			// If the uniform is in a parameter block, the index of the block. Location will be the uniform's
+			// offset in the block, and the strides are used to lay out arrays and matrices to match the shader
+			int            BlockIndex = -1;
+			int            ArrayStride = 0;
+			int            MatrixStride = 0;
 
 			// The type of uniform
 			ShaderDataType Type = ShaderDataType::None;
@@ -118,6 +163,9 @@ namespace Gameplay {
 				TextureAsset(nullptr),
 				ArraySize(0),
 				BindingSlot(-1),
+				BlockIndex(-1),
+				ArrayStride(0),
+				MatrixStride(0),
 				Type(ShaderDataType::None) 
 			{ }
 			UniformData(const UniformData& other);
@@ -167,15 +215,73 @@ namespace Gameplay {
 		};
 	
 		/// <summary>
-		/// The shader that the material is using
+		/// The shader that the material was created with
 		/// </summary>
 		ShaderProgram::Sptr    _shader;
 		/// <summary>
+		/// The feature keywords that are enabled, sorted so they can be compared
+		/// </summary>
+		std::vector<std::string> _keywords;
+		/// <summary>
+		/// The permutation of the shader selected by our keywords, this is the shader we render with
+		/// </summary>
+		ShaderProgram::Sptr    _permutation;
+		/// <summary>
 		/// The uniforms that the material will be modifying
 		/// </summary>
 		std::unordered_map<std::string, UniformData> _uniforms;
 
+		/// <summary>
+		/// A uniform block of material parameters, with its contents laid out as the shader reflected them
+		/// </summary>
+		struct ParameterBlock {
+			std::string                 Name;
+			int                         Binding;
+			std::vector<uint8_t>        Data;
+			AbstractUniformBuffer::Sptr Buffer;
+			// True if Data has changed since it was last uploaded
+			bool                        Dirty;
+		};
+		std::vector<ParameterBlock> _parameterBlocks;
+
+		/// <summary>
+		/// Everything we need to apply the material to a given shader, worked out once so that applying
+		/// the material does not need to look anything up by name. Pointers are into _uniforms
+		/// </summary>
+		struct ApplyTable {
+			struct TextureSlot {
+				UniformData* Uniform;
+				int          Slot;
+			};
+			struct ValueUniform {
+				UniformData* Uniform;
+				int          Location;
+			};
+			std::weak_ptr<ShaderProgram> Shader;
+			std::vector<TextureSlot>     Textures;
+			// Parameters that are not in a parameter block, and need to be set one by one
+			std::vector<ValueUniform>    Values;
+		};
+		// Usually only has the permutation we render with, and maybe its instanced variant
+		std::vector<ApplyTable> _applyTables;
+
 		UniformData& _GetUniform(const std::string& name);
 		void _PopulateUniforms();
+		/// <summary>
+		/// Selects the permutation for our keywords, and updates our uniforms to match it
+		/// </summary>
+		void _UpdatePermutation();
+		/// <summary>
+		/// Creates our parameter blocks from the permutation's reflected layout, and packs our current values into them
+		/// </summary>
+		void _BuildParameterBlocks();
+		/// <summary>
+		/// Copies a uniform's value into its parameter block, converting it to the block's layout
+		/// </summary>
+		void _WriteToBlock(const UniformData& uniform);
+		/// <summary>
+		/// Gets the apply table for the given shader, building it if needed
+		/// </summary>
+		const ApplyTable& _GetApplyTable(const ShaderProgram::Sptr& shader);
 	};
 }
\ No newline at end of file
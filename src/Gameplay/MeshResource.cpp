@@ -1,13 +1,23 @@
 #include "MeshResource.h"
 #include <filesystem>
 
-#include "Utils/ObjLoader.h"
+#include "Utils/OptimizedObjLoader.h"
+#include "Utils/MeshSimplifier.h"
 
 namespace Gameplay {
+	struct MeshResource::DecodedData {
+		// Set when the mesh is loaded from a file
+		std::unique_ptr<OptimizedObjLoader::DecodedMesh> FileMesh;
+		// Set when the mesh is generated from mesh builder parameters
+		std::unique_ptr<MeshBuilder<VertexPosNormTexColTangents>> Builder;
+		std::vector<MeshSimplifier::Lod> BuilderLods;
+	};
+
 	MeshResource::MeshResource() :
 		IResource(),
 		Filename(""),
 		MeshBuilderParams(std::vector<MeshBuilderParam>()),
+		GenerateLods(false),
 		Mesh(nullptr),
 		BulletTriMesh(nullptr)
 	{ }
@@ -16,10 +26,11 @@ namespace Gameplay {
 		IResource(),
 		Filename(filename),
 		MeshBuilderParams(std::vector<MeshBuilderParam>()),
+		GenerateLods(false),
 		Mesh(nullptr),
 		BulletTriMesh(nullptr)
 	{
-		Mesh = ObjLoader::LoadFromFile(filename);
+		_LoadFromFile();
 	}
 
 	MeshResource::~MeshResource() = default;
@@ -33,34 +44,75 @@ namespace Gameplay {
 				params[ix] = MeshBuilderParams[ix].ToJson();
 			}
 			result["params"] = params;
+			result["generate_lods"] = GenerateLods;
 		} else {
 			result["filename"] = Filename.empty() ? "null" : Filename;
 		}
 		return result;
 	}
 
+	size_t MeshResource::GetMemoryUsage() const {
+		size_t result = 0;
+		if (Mesh != nullptr) {
+			for (const auto* binding : Mesh->GetVertexBuffers()) {
+				result += binding->GetBuffer()->GetTotalSize();
+			}
+			if (Lods.empty() && Mesh->GetIndexBuffer() != nullptr) {
+				result += Mesh->GetIndexBuffer()->GetTotalSize();
+			}
+		}
+		// The full detail level is Mesh, the simplified levels share its vertex buffers but have their own indices
+		for (const MeshLod& lod : Lods) {
+			if (lod.Mesh != nullptr && lod.Mesh->GetIndexBuffer() != nullptr) {
+				result += lod.Mesh->GetIndexBuffer()->GetTotalSize();
+			}
+		}
+		return result;
+	}
+
 	MeshResource::Sptr MeshResource::FromJson(const nlohmann::json & blob)
 	{
+		return FromDecoded(blob, Decode(blob));
+	}
+
+	std::shared_ptr<MeshResource::DecodedData> MeshResource::Decode(const nlohmann::json& blob) {
+		std::shared_ptr<DecodedData> result = std::make_shared<DecodedData>();
+		if (blob.contains("params") && blob["params"].is_array()) {
+			// Building and simplifying the mesh is all CPU work, only baking it needs OpenGL
+			result->Builder = std::make_unique<MeshBuilder<VertexPosNormTexColTangents>>();
+			for (const auto& param : blob["params"]) {
+				MeshFactory::AddParameterized(*result->Builder, MeshBuilderParam::FromJson(param));
+			}
+			MeshFactory::CalculateTBN(*result->Builder);
+			if (JsonGet(blob, "generate_lods", false)) {
+				result->BuilderLods = MeshSimplifier::GenerateLods(*result->Builder);
+			}
+		} else {
+			std::string filename = JsonGet<std::string>(blob, "filename", "null");
+			if (filename != "null" && std::filesystem::exists(filename)) {
+				result->FileMesh = std::make_unique<OptimizedObjLoader::DecodedMesh>();
+				if (!OptimizedObjLoader::Decode(filename, *result->FileMesh)) {
+					result->FileMesh = nullptr;
+				}
+			}
+		}
+		return result;
+	}
+
+	MeshResource::Sptr MeshResource::FromDecoded(const nlohmann::json& blob, const std::shared_ptr<DecodedData>& data) {
 		MeshResource::Sptr result = std::make_shared<MeshResource>();
 		if (blob.contains("params") && blob["params"].is_array()) {
-			std::vector<nlohmann::json> meshbuilderParams = blob["params"].get<std::vector<nlohmann::json>>();
-			MeshBuilder<VertexPosNormTexColTangents> mesh;
-			for (int ix = 0; ix < meshbuilderParams.size(); ix++) {
-				MeshBuilderParam p = MeshBuilderParam::FromJson(meshbuilderParams[ix]);
-				result->MeshBuilderParams.push_back(p);
-				MeshFactory::AddParameterized(mesh, p);
+			for (const auto& param : blob["params"]) {
+				result->MeshBuilderParams.push_back(MeshBuilderParam::FromJson(param));
+			}
+			result->GenerateLods = JsonGet(blob, "generate_lods", false);
+			if (data->Builder != nullptr) {
+				result->_LoadFromBuilder(*data->Builder, data->BuilderLods);
 			}
-			MeshFactory::CalculateTBN(mesh);
-			result->Mesh = mesh.Bake();
 		} else {
 			result->Filename = JsonGet<std::string>(blob, "filename", "null");
-			if (result->Filename != "null" && std::filesystem::exists(result->Filename)) {
-				#ifdef OPTIMIZED_OBJ_LOADER
-				result->Mesh = OptimizedObjLoader::LoadFromFile(result->Filename);
-				#else
-				result->Mesh = ObjLoader::LoadFromFile(result->Filename);
-				#endif
-
+			if (data->FileMesh != nullptr) {
+				result->Mesh = OptimizedObjLoader::Upload(*data->FileMesh, &result->Lods, &result->Bounds);
 			}
 		}
 		return result;
@@ -72,10 +124,38 @@ namespace Gameplay {
 			MeshFactory::AddParameterized(mesh, param);
 		}
 		MeshFactory::CalculateTBN(mesh);
-		Mesh = mesh.Bake();
+		_LoadFromBuilder(mesh);
 	}
 
 	void MeshResource::AddParam(const MeshBuilderParam & param) {
 		MeshBuilderParams.push_back(param);
 	}
+
+	const VertexArrayObject::Sptr& MeshResource::SelectLod(float projectedRadius, float maxPixelError) const {
+		size_t level = MeshLod::SelectLevel(Lods, projectedRadius, maxPixelError);
+		return level > 0 ? Lods[level].Mesh : Mesh;
+	}
+
+	void MeshResource::_LoadFromFile() {
+		// The binary mesh cache stores our levels of detail and bounds, so we don't need to regenerate them on every load
+		Lods.clear();
+		Bounds = AABB();
+		Mesh = OptimizedObjLoader::LoadFromFile(Filename, &Lods, &Bounds);
+	}
+
+	void MeshResource::_LoadFromBuilder(MeshBuilder<VertexPosNormTexColTangents>& mesh) {
+		// Generated meshes aren't cached, so we simplify them whenever they are created
+		_LoadFromBuilder(mesh, GenerateLods ? MeshSimplifier::GenerateLods(mesh) : std::vector<MeshSimplifier::Lod>());
+	}
+
+	void MeshResource::_LoadFromBuilder(MeshBuilder<VertexPosNormTexColTangents>& mesh, const std::vector<MeshSimplifier::Lod>& lods) {
+		VertexParamMap vMap = VertexParamMap(VertexPosNormTexColTangents::V_DECL);
+		Bounds = AABB::FromPoints(reinterpret_cast<const uint8_t*>(mesh.GetVertexDataPtr()) + vMap.PositionOffset, sizeof(VertexPosNormTexColTangents), mesh.GetVertexCount());
+
+		Mesh = mesh.Bake();
+		Lods = { MeshLod{ Mesh, 0.0f } };
+		for (const auto& lod : lods) {
+			Lods.push_back(MeshLod::Create(Mesh, lod.Indices.data(), IndexType::UInt, static_cast<uint32_t>(lod.Indices.size()), lod.Error));
+		}
+	}
 }
\ No newline at end of file
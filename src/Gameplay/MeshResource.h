@@ -1,7 +1,10 @@
 #pragma once
 #include "Utils/ResourceManager/IResource.h"
 #include "Graphics/VertexArrayObject.h"
+#include "Graphics/MeshLod.h"
 #include "Utils/MeshFactory.h"
+#include "Utils/MeshSimplifier.h"
+#include "Utils/BoundingVolumes.h"
 
 // bullet triangle mesh pre-declaration
 class btTriangleMesh;
@@ -35,12 +38,26 @@ namespace Gameplay {
 		/// The mesh builder parameters if this mesh resource is created at runtime
 		/// </summary>
 		std::vector<MeshBuilderParam>   MeshBuilderParams;
+		/// <summary>
+		/// True to generate levels of detail for a mesh built from MeshBuilderParams. Generated meshes aren't
+		/// cached, so they would be simplified on every load, and most of them are too simple to benefit from
+		/// it. Meshes loaded from a file always use the levels stored in their binary cache
+		/// </summary>
+		bool                            GenerateLods;
 
 		/// <summary>
 		/// The VAO for rendering this mesh in OpenGL
 		/// </summary>
 		VertexArrayObject::Sptr         Mesh;
-
+		/// <summary>
+		/// The levels of detail for this mesh, from most to least detailed. The first level is
+		/// always the full detail mesh
+		/// </summary>
+		std::vector<MeshLod>            Lods;
+		/// <summary>
+		/// The object space bounds of the mesh
+		/// </summary>
+		AABB                            Bounds;
 
 		/// <summary>
 		/// The optional mesh resource for generating colliders from this mesh
@@ -61,9 +78,47 @@ namespace Gameplay {
 		/// <param name="param">The parameter to add</param>
 		void AddParam(const MeshBuilderParam& param);
 
+		/// <summary>
+		/// Selects the simplest level of detail whose error would not be noticeable when the mesh is
+		/// drawn at the given size on screen
+		/// </summary>
+		/// <param name="projectedRadius">The radius of the mesh's bounding sphere on screen, in pixels</param>
+		/// <param name="maxPixelError">The largest error we are willing to accept, in pixels</param>
+		/// <returns>The VAO for the selected level</returns>
+		const VertexArrayObject::Sptr& SelectLod(float projectedRadius, float maxPixelError) const;
+
 		// Inherited from IResource
 
 		virtual nlohmann::json ToJson() const override;
 		static MeshResource::Sptr FromJson(const nlohmann::json& blob);
+		virtual size_t GetMemoryUsage() const override;
+
+		/// <summary>
+		/// The CPU side data for a mesh, see Decode
+		/// </summary>
+		struct DecodedData;
+		/// <summary>
+		/// Does all the file and mesh processing for loading a mesh from JSON without touching OpenGL,
+		/// so that the resource manager can run it on a worker thread
+		/// </summary>
+		static std::shared_ptr<DecodedData> Decode(const nlohmann::json& blob);
+		/// <summary>
+		/// Creates the mesh from data returned by Decode, must be called on the main thread
+		/// </summary>
+		static MeshResource::Sptr FromDecoded(const nlohmann::json& blob, const std::shared_ptr<DecodedData>& data);
+
+	protected:
+		/// <summary>
+		/// Loads the mesh, levels of detail and bounds from Filename
+		/// </summary>
+		void _LoadFromFile();
+		/// <summary>
+		/// Bakes the mesh from a mesh builder, generating levels of detail if GenerateLods is set, and bounds for it
+		/// </summary>
+		void _LoadFromBuilder(MeshBuilder<VertexPosNormTexColTangents>& mesh);
+		/// <summary>
+		/// Bakes the mesh from a mesh builder, using levels of detail that have already been generated
+		/// </summary>
+		void _LoadFromBuilder(MeshBuilder<VertexPosNormTexColTangents>& mesh, const std::vector<MeshSimplifier::Lod>& lods);
 	};
 }
\ No newline at end of file
@@ -0,0 +1,277 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "Utils/GUID.hpp"
+
+namespace Gameplay {
+	/// <summary>
+	/// The list of objects in a scene, in the order they were added, along with lookups from GUIDs and
+	/// names to positions in the list. Removing objects keeps the rest of the list in order, so when
+	/// several objects share a GUID or a name, the lookups always find the one that was added first
+	///
+	/// Objects need GetGUID() and GetName() members, and must call OnRenamed whenever their name changes
+	/// </summary>
+	/// <typeparam name="ObjectType">The type of object being stored</typeparam>
+	template <typename ObjectType>
+	class ObjectList {
+	public:
+		typedef std::shared_ptr<ObjectType> Sptr;
+
+		/// <summary>
+		/// Returned by IndexOf when an object is not in the list
+		/// </summary>
+		static constexpr size_t NOT_FOUND = ~static_cast<size_t>(0);
+
+		ObjectList() = default;
+		~ObjectList() = default;
+
+		size_t Size() const { return _objects.size(); }
+		bool Empty() const { return _objects.empty(); }
+		const Sptr& operator[](size_t index) const { return _objects[index]; }
+		typename std::vector<Sptr>::const_iterator begin() const { return _objects.begin(); }
+		typename std::vector<Sptr>::const_iterator end() const { return _objects.end(); }
+
+		/// <summary>
+		/// Reserves space for the given number of objects
+		/// </summary>
+		void Reserve(size_t count);
+
+		/// <summary>
+		/// Adds an object to the end of the list
+		/// </summary>
+		void Add(const Sptr& object);
+		/// <summary>
+		/// Removes objects from the list in a single pass, keeping the remaining objects in order. Objects
+		/// that aren't in the list are skipped, and objects may be given more than once
+		/// </summary>
+		/// <typeparam name="Callback">A callable with the signature void(ObjectType&)</typeparam>
+		/// <param name="objects">The objects to remove</param>
+		/// <param name="onRemoved">Invoked for each object as it is removed, while the list still holds it</param>
+		/// <returns>The number of objects that were removed</returns>
+		template <typename Callback>
+		size_t Remove(const std::vector<Sptr>& objects, Callback&& onRemoved);
+		/// <summary>
+		/// Removes all objects from the list
+		/// </summary>
+		void Clear();
+
+		/// <summary>
+		/// Finds the first object added with the given GUID, or nullptr if there is none
+		/// </summary>
+		Sptr FindByGuid(const Guid& guid) const;
+		/// <summary>
+		/// Finds the first object added with the given name, or nullptr if there is none
+		/// </summary>
+		Sptr FindByName(const std::string& name) const;
+		/// <summary>
+		/// Gets the position of an object in the list, or NOT_FOUND if it isn't in the list
+		/// </summary>
+		size_t IndexOf(const ObjectType* object) const;
+
+		/// <summary>
+		/// Updates the name lookup after an object has been renamed, objects that aren't in the list are ignored
+		/// </summary>
+		/// <param name="object">The object that was renamed</param>
+		/// <param name="oldName">The name that the object had before</param>
+		void OnRenamed(const ObjectType* object, const std::string& oldName);
+
+	protected:
+		std::vector<Sptr> _objects;
+		// The order that each object was added in, which only ever increases along the list. The lookups
+		// store these rather than positions, so that removing an object doesn't have to update the entries
+		// for every object after it, and a position is found again with a binary search
+		std::vector<uint64_t> _sequences;
+		uint64_t              _nextSequence = 0;
+
+		struct Entry {
+			uint64_t Sequence;
+			Sptr     Object;
+		};
+
+		// GUIDs should be unique, so the GUID lookup is a multimap that only has more than one entry per key for
+		// copied or hand edited scenes. Names are often shared (ex: instances), so each name has a list of
+		// entries, sorted so that the first entry is the first object added
+		std::unordered_multimap<Guid, Entry>                 _byGuid;
+		std::unordered_map<std::string, std::vector<Entry>>  _byName;
+
+		// Scratch list of the positions being removed, kept to avoid allocating on every Remove
+		std::vector<size_t> _removing;
+
+		/// <summary>
+		/// Gets the position of the object with the given sequence number, which must be in the list
+		/// </summary>
+		size_t _IndexOfSequence(uint64_t sequence) const;
+		/// <summary>
+		/// Removes the lookup entries for the object at the given position
+		/// </summary>
+		void _EraseEntries(size_t index);
+		/// <summary>
+		/// Removes the entry with the given sequence number from a name's list, if it's there
+		/// </summary>
+		void _EraseNameEntry(const std::string& name, uint64_t sequence);
+		/// <summary>
+		/// Finds where the given sequence number is, or would go, in a sorted list of entries
+		/// </summary>
+		static typename std::vector<Entry>::iterator _LowerBound(std::vector<Entry>& entries, uint64_t sequence);
+	};
+
+	template <typename ObjectType>
+	void ObjectList<ObjectType>::Reserve(size_t count) {
+		_objects.reserve(count);
+		_sequences.reserve(count);
+		_byGuid.reserve(count);
+	}
+
+	template <typename ObjectType>
+	void ObjectList<ObjectType>::Add(const Sptr& object) {
+		// The new object is always last, so the name's list stays sorted
+		Entry entry{ _nextSequence++, object };
+		_byGuid.emplace(object->GetGUID(), entry);
+		_byName[object->GetName()].push_back(entry);
+		_objects.push_back(object);
+		_sequences.push_back(entry.Sequence);
+	}
+
+	template <typename ObjectType>
+	template <typename Callback>
+	size_t ObjectList<ObjectType>::Remove(const std::vector<Sptr>& objects, Callback&& onRemoved) {
+		_removing.clear();
+		for (const Sptr& object : objects) {
+			size_t index = object == nullptr ? NOT_FOUND : IndexOf(object.get());
+			if (index != NOT_FOUND) {
+				_removing.push_back(index);
+			}
+		}
+		if (_removing.empty()) {
+			return 0;
+		}
+		std::sort(_removing.begin(), _removing.end());
+		_removing.erase(std::unique(_removing.begin(), _removing.end()), _removing.end());
+
+		// Objects are only destroyed once the list and lookups are consistent again, in case their
+		// destructors look at the list. The lookups hold references too, so entries are erased first
+		std::vector<Sptr> removed;
+		removed.reserve(_removing.size());
+		for (size_t index : _removing) {
+			_EraseEntries(index);
+			onRemoved(*_objects[index]);
+			removed.push_back(std::move(_objects[index]));
+		}
+
+		// Shift everything after the first removed object down over the gaps, the lookups don't
+		// store positions so only the lists themselves change
+		size_t next = 0;
+		size_t write = _removing[0];
+		for (size_t read = _removing[0]; read < _objects.size(); read++) {
+			if (next < _removing.size() && _removing[next] == read) {
+				next++;
+			} else {
+				_objects[write] = std::move(_objects[read]);
+				_sequences[write] = _sequences[read];
+				write++;
+			}
+		}
+		_objects.erase(_objects.begin() + write, _objects.end());
+		_sequences.erase(_sequences.begin() + write, _sequences.end());
+		return removed.size();
+	}
+
+	template <typename ObjectType>
+	void ObjectList<ObjectType>::Clear() {
+		_byGuid.clear();
+		_byName.clear();
+		_objects.clear();
+		_sequences.clear();
+	}
+
+	template <typename ObjectType>
+	typename ObjectList<ObjectType>::Sptr ObjectList<ObjectType>::FindByGuid(const Guid& guid) const {
+		auto range = _byGuid.equal_range(guid);
+		const Entry* first = nullptr;
+		for (auto it = range.first; it != range.second; it++) {
+			if (first == nullptr || it->second.Sequence < first->Sequence) {
+				first = &it->second;
+			}
+		}
+		return first == nullptr ? nullptr : first->Object;
+	}
+
+	template <typename ObjectType>
+	typename ObjectList<ObjectType>::Sptr ObjectList<ObjectType>::FindByName(const std::string& name) const {
+		auto it = _byName.find(name);
+		return it == _byName.end() ? nullptr : it->second.front().Object;
+	}
+
+	template <typename ObjectType>
+	size_t ObjectList<ObjectType>::IndexOf(const ObjectType* object) const {
+		auto range = _byGuid.equal_range(object->GetGUID());
+		for (auto it = range.first; it != range.second; it++) {
+			if (it->second.Object.get() == object) {
+				return _IndexOfSequence(it->second.Sequence);
+			}
+		}
+		return NOT_FOUND;
+	}
+
+	template <typename ObjectType>
+	void ObjectList<ObjectType>::OnRenamed(const ObjectType* object, const std::string& oldName) {
+		size_t index = IndexOf(object);
+		if (index == NOT_FOUND) {
+			return;
+		}
+		Entry entry{ _sequences[index], _objects[index] };
+		_EraseNameEntry(oldName, entry.Sequence);
+
+		// The object keeps its place in the list, so it goes ahead of any objects with the new name that were added after it
+		std::vector<Entry>& entries = _byName[object->GetName()];
+		entries.insert(_LowerBound(entries, entry.Sequence), entry);
+	}
+
+	template <typename ObjectType>
+	size_t ObjectList<ObjectType>::_IndexOfSequence(uint64_t sequence) const {
+		return std::lower_bound(_sequences.begin(), _sequences.end(), sequence) - _sequences.begin();
+	}
+
+	template <typename ObjectType>
+	void ObjectList<ObjectType>::_EraseEntries(size_t index) {
+		const ObjectType& object = *_objects[index];
+		const uint64_t sequence = _sequences[index];
+		auto range = _byGuid.equal_range(object.GetGUID());
+		for (auto it = range.first; it != range.second; it++) {
+			if (it->second.Sequence == sequence) {
+				_byGuid.erase(it);
+				break;
+			}
+		}
+		_EraseNameEntry(object.GetName(), sequence);
+	}
+
+	template <typename ObjectType>
+	void ObjectList<ObjectType>::_EraseNameEntry(const std::string& name, uint64_t sequence) {
+		auto nameIt = _byName.find(name);
+		if (nameIt != _byName.end()) {
+			std::vector<Entry>& entries = nameIt->second;
+			auto it = _LowerBound(entries, sequence);
+			if (it != entries.end() && it->Sequence == sequence) {
+				entries.erase(it);
+			}
+			if (entries.empty()) {
+				_byName.erase(nameIt);
+			}
+		}
+	}
+
+	template <typename ObjectType>
+	typename std::vector<typename ObjectList<ObjectType>::Entry>::iterator ObjectList<ObjectType>::_LowerBound(std::vector<Entry>& entries, uint64_t sequence) {
+		return std::lower_bound(entries.begin(), entries.end(), sequence, [](const Entry& entry, uint64_t value) {
+			return entry.Sequence < value;
+		});
+	}
+}
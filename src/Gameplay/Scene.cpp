@@ -2,9 +2,11 @@
 
 #include <GLFW/glfw3.h>
 #include <locale>
+#include <filesystem>
 #include <codecvt>
 
 #include "Utils/FileHelpers.h"
+#include "Utils/JobSystem.h"
 #include "Utils/GlmBulletConversions.h"
 
 #include "Gameplay/Physics/RigidBody.h"
@@ -19,8 +21,10 @@
 
 namespace Gameplay {
 	Scene::Scene() :
-		_objects(std::vector<GameObject::Sptr>()),
+		_objects(),
 		_deletionQueue(std::vector<std::weak_ptr<GameObject>>()),
+		_deleting(),
+		_commands(),
 		IsPlaying(false),
 		IsDestroyed(false),
 		MainCamera(nullptr),
@@ -47,7 +51,7 @@ namespace Gameplay {
 		_skyboxShader = nullptr;
 		_skyboxMesh = nullptr;
 		_skyboxTexture = nullptr;
-		_objects.clear();
+		_ClearObjects();
 		_components.Clear();
 		_CleanupPhysics();
 		IsDestroyed = true;
@@ -95,15 +99,19 @@ namespace Gameplay {
 
 	GameObject::Sptr Scene::CreateGameObject(const std::string& name)
 	{
-		GameObject::Sptr result(new GameObject());
-		result->Name = name;
-		result->_scene = this;
+		LOG_ASSERT(!JobSystem::IsInJob(), "Game objects can't be created from a job, use Scene::Commands() instead");
+		GameObject::Sptr result(new GameObject(this));
+		result->_name = name;
 		result->_selfRef = result;
-		_objects.push_back(result);
+		_AddObject(result);
 		return result;
 	}
 
 	void Scene::RemoveGameObject(const GameObject::Sptr& object) {
+		if (JobSystem::IsInJob()) {
+			_commands.RemoveGameObject(object);
+			return;
+		}
 		_deletionQueue.push_back(object);
 		for (const auto& child : object->_children) {
 			RemoveGameObject(child);
@@ -111,17 +119,11 @@ namespace Gameplay {
 	}
 
 	GameObject::Sptr Scene::FindObjectByName(const std::string name) const {
-		auto it = std::find_if(_objects.begin(), _objects.end(), [&](const GameObject::Sptr& obj) {
-			return obj->Name == name;
-		});
-		return it == _objects.end() ? nullptr : *it;
+		return _objects.FindByName(name);
 	}
 
 	GameObject::Sptr Scene::FindObjectByGUID(Guid id) const {
-		auto it = std::find_if(_objects.begin(), _objects.end(), [&](const GameObject::Sptr& obj) {
-			return obj->_guid == id;
-		});
-		return it == _objects.end() ? nullptr : *it;
+		return _objects.FindByGuid(id);
 	}
 
 	void Scene::SetAmbientLight(const glm::vec3& value) {
@@ -157,22 +159,22 @@ namespace Gameplay {
 	}
 
 	void Scene::DoPhysics(float dt) {
-		_components.Each<Gameplay::Physics::RigidBody>([=](const std::shared_ptr<Gameplay::Physics::RigidBody>& body) {
-			body->PhysicsPreStep(dt);
+		_components.Each<Gameplay::Physics::RigidBody>([=](Gameplay::Physics::RigidBody& body) {
+			body.PhysicsPreStep(dt);
 		});
-		_components.Each<Gameplay::Physics::TriggerVolume>([=](const std::shared_ptr<Gameplay::Physics::TriggerVolume>& body) {
-			body->PhysicsPreStep(dt);
+		_components.Each<Gameplay::Physics::TriggerVolume>([=](Gameplay::Physics::TriggerVolume& body) {
+			body.PhysicsPreStep(dt);
 		});
 
 		if (IsPlaying) {
 
 			_physicsWorld->stepSimulation(dt, 1);
 
-			_components.Each<Gameplay::Physics::RigidBody>([=](const std::shared_ptr<Gameplay::Physics::RigidBody>& body) {
-				body->PhysicsPostStep(dt);
+			_components.Each<Gameplay::Physics::RigidBody>([=](Gameplay::Physics::RigidBody& body) {
+				body.PhysicsPostStep(dt);
 			});
-			_components.Each<Gameplay::Physics::TriggerVolume>([=](const std::shared_ptr<Gameplay::Physics::TriggerVolume>& body) {
-				body->PhysicsPostStep(dt);
+			_components.Each<Gameplay::Physics::TriggerVolume>([=](Gameplay::Physics::TriggerVolume& body) {
+				body.PhysicsPostStep(dt);
 			});
 		}
 	}
@@ -187,13 +189,77 @@ namespace Gameplay {
 	void Scene::Update(float dt) {
 		_FlushDeleteQueue();
 		if (IsPlaying) {
-			for (int i = 0; i < _objects.size(); i++) {
-				_objects[i]->Update(dt);
+			_UpdateComponents(dt);
+		}
+
+		// Bring every moved object and its children up to date in one pass, this also runs while
+		// paused so that objects moved in the editor are up to date
+		_transforms.Update();
+
+		if (IsPlaying) {
+			for (size_t i = 0; i < _objects.Size(); i++) {
+				_objects[i]->_FinishUpdate();
 			}
+
+			// Sync point, apply any changes that components deferred during their updates
+			_commands.Flush(*this);
 		}
 		_FlushDeleteQueue();
 	}
 
+	void Scene::_UpdateComponents(float dt) {
+		auto updateComponent = [dt](IComponent* component) {
+			if (component->IsEnabled && component->GetGameObject() != nullptr) {
+				component->Update(dt);
+			}
+		};
+
+		// Thread safe types go first, then the types that read other objects once everything
+		// else that runs in parallel is done writing. Types that don't override Update are skipped
+		for (ComponentUpdateMode mode : { ComponentUpdateMode::ThreadSafe, ComponentUpdateMode::ReadsOtherObjects }) {
+			// Reading an out of date world transform writes to the transform store, so everything gets brought up to
+			// date before the parallel updates start, and again once the thread safe types have moved their objects
+			_transforms.Update();
+
+			for (uint32_t typeId = 0; typeId < ComponentManager::GetTypeCount(); typeId++) {
+				ComponentPool* pool = _components.GetPool(typeId);
+				if (pool == nullptr || !ComponentManager::HasUpdate(typeId) || ComponentManager::GetUpdateMode(typeId) != mode) {
+					continue;
+				}
+
+				JobSystem::ParallelFor(pool->Size(), ComponentPool::UPDATE_BATCH_SIZE, [&](size_t begin, size_t end) {
+					for (size_t ix = begin; ix < end; ix++) {
+						updateComponent((*pool)[ix]);
+					}
+				});
+			}
+		}
+
+		// Everything else runs here on the main thread. These updates may add or remove components, and removing
+		// one swaps another into its place, so we walk a snapshot of the handles instead. Components added during
+		// the loop wait for the next frame, and ones removed during the loop are skipped
+		std::vector<ComponentHandle> handles;
+		for (uint32_t typeId = 0; typeId < ComponentManager::GetTypeCount(); typeId++) {
+			ComponentPool* pool = _components.GetPool(typeId);
+			if (pool == nullptr || !ComponentManager::HasUpdate(typeId) || ComponentManager::GetUpdateMode(typeId) != ComponentUpdateMode::MainThread) {
+				continue;
+			}
+
+			handles.resize(pool->Size());
+			for (size_t ix = 0; ix < handles.size(); ix++) {
+				handles[ix] = pool->GetHandle(ix);
+			}
+			for (const ComponentHandle& handle : handles) {
+				// Look the pool up again, adding a component of a new type may have moved it
+				ComponentPool* current = _components.GetPool(typeId);
+				IComponent* component = current != nullptr ? current->Get(handle) : nullptr;
+				if (component != nullptr) {
+					updateComponent(component);
+				}
+			}
+		}
+	}
+
 	void Scene::RenderGUI()
 	{
 		for (auto& obj : _objects) {
@@ -213,7 +279,7 @@ namespace Gameplay {
 
 		Scene::Sptr result = std::make_shared<Scene>();
 		result->MainCamera = nullptr;
-		result->_objects.clear();
+		result->_ClearObjects();
 		result->DefaultMaterial = ResourceManager::Get<Material>(Guid(data["default_material"]));
 
 		if (data.contains("ambient")) {
@@ -235,7 +301,7 @@ namespace Gameplay {
 			obj->_scene = result.get();
 			obj->_parent.SceneContext = result.get();
 			obj->_selfRef = obj;
-			result->_objects.push_back(obj);
+			result->_AddObject(obj);
 		}
 
 		// Re-build the parent hierarchy 
@@ -251,6 +317,48 @@ namespace Gameplay {
 		return result;
 	}
 
+	Scene::Sptr Scene::FromBinary(const SceneBinary::Reader& reader)
+	{
+		const SceneBinary::BinaryHeader& header = reader.GetHeader();
+
+		Scene::Sptr result = std::make_shared<Scene>();
+		result->MainCamera = nullptr;
+		result->_ClearObjects();
+		result->DefaultMaterial = ResourceManager::Get<Material>(SceneBinary::ReadGuid(header.DefaultMaterial));
+
+		if (header.Flags & SceneBinary::SCENE_HAS_AMBIENT) {
+			result->SetAmbientLight(glm::vec3(header.AmbientLight[0], header.AmbientLight[1], header.AmbientLight[2]));
+		}
+
+		if (header.Flags & SceneBinary::SCENE_HAS_SKYBOX) {
+			const float* orientation = header.SkyboxOrientation;
+			result->_skyboxMesh = ResourceManager::Get<MeshResource>(SceneBinary::ReadGuid(header.SkyboxMesh));
+			result->SetSkyboxShader(ResourceManager::Get<ShaderProgram>(SceneBinary::ReadGuid(header.SkyboxShader)));
+			result->SetSkyboxTexture(ResourceManager::Get<TextureCube>(SceneBinary::ReadGuid(header.SkyboxTexture)));
+			result->SetSkyboxRotation(glm::mat3_cast(glm::quat(orientation[3], orientation[0], orientation[1], orientation[2])));
+		}
+
+		// Objects are loaded straight from the object table
+		result->_objects.Reserve(reader.GetNumObjects());
+		for (uint32_t ix = 0; ix < reader.GetNumObjects(); ix++) {
+			GameObject::Sptr obj = GameObject::FromBinary(result.get(), reader, ix);
+			obj->_parent.SceneContext = result.get();
+			obj->_selfRef = obj;
+			result->_AddObject(obj);
+		}
+
+		// Re-build the parent hierarchy 
+		for (const auto& object : result->_objects) {
+			if (object->GetParent() != nullptr) {
+				object->GetParent()->AddChild(object);
+			}
+		}
+
+		result->MainCamera = result->_components.GetComponentByGUID<Camera>(SceneBinary::ReadGuid(header.MainCamera));
+
+		return result;
+	}
+
 	nlohmann::json Scene::ToJson() const
 	{
 		nlohmann::json blob;
@@ -267,8 +375,8 @@ namespace Gameplay {
 
 		// Save renderables
 		std::vector<nlohmann::json> objects;
-		objects.resize(_objects.size());
-		for (int ix = 0; ix < _objects.size(); ix++) {
+		objects.resize(_objects.Size());
+		for (size_t ix = 0; ix < _objects.Size(); ix++) {
 			objects[ix] = _objects[ix]->ToJson();
 		}
 		blob["objects"] = objects;
@@ -281,23 +389,42 @@ namespace Gameplay {
 
 	void Scene::Save(const std::string& path) {
 		_filePath = path;
-		// Save data to file
-		FileHelpers::WriteContentsToFile(path, ToJson().dump(1, '\t'));
+		// Save data to file, picking the format from the extension
+		if (std::filesystem::path(path).extension() == SceneBinary::EXTENSION) {
+			SceneBinary::Write(ToJson(), path);
+		} else {
+			FileHelpers::WriteContentsToFile(path, ToJson().dump(1, '\t'));
+		}
 		LOG_INFO("Saved scene to \"{}\"", path);
 	}
 
 	Scene::Sptr Scene::Load(const std::string& path)
 	{
 		LOG_INFO("Loading scene from \"{}\"", path);
-		std::string content = FileHelpers::ReadFile(path);
-		nlohmann::json blob = nlohmann::json::parse(content);
-		Scene::Sptr result = FromJson(blob);
+		float startTime = static_cast<float>(glfwGetTime());
+
+		// Binary scenes are detected by their header, so they can be loaded no matter what they are named
+		Scene::Sptr result = nullptr;
+		if (SceneBinary::IsBinaryFile(path)) {
+			SceneBinary::Reader reader;
+			if (!reader.Open(path)) {
+				return nullptr;
+			}
+			result = FromBinary(reader);
+		} else {
+			std::string content = FileHelpers::ReadFile(path);
+			nlohmann::json blob = nlohmann::json::parse(content);
+			result = FromJson(blob);
+		}
 		result->_filePath = path;
+
+		float endTime = static_cast<float>(glfwGetTime());
+		LOG_TRACE("Loaded scene \"{}\" in {} seconds ({} objects)", path, endTime - startTime, result->_objects.Size());
 		return result;
 	}
 
 	int Scene::NumObjects() const {
-		return static_cast<int>(_objects.size());
+		return static_cast<int>(_objects.Size());
 	}
 
 	GameObject::Sptr Scene::GetObjectByIndex(int index) const {
@@ -335,14 +462,53 @@ namespace Gameplay {
 
 
 	void Scene::_FlushDeleteQueue() {
+		if (_deletionQueue.empty()) {
+			return;
+		}
+
+		// Objects can be queued more than once (ex: deleting a parent and child), or may have already been
+		// removed, the object list skips those
+		_deleting.clear();
 		for (auto& weakPtr : _deletionQueue) {
-			if (weakPtr.expired()) continue;
-			auto& it = std::find(_objects.begin(), _objects.end(), weakPtr.lock());
-			if (it != _objects.end()) {
-				_objects.erase(it);
+			GameObject::Sptr object = weakPtr.lock();
+			if (object != nullptr) {
+				_deleting.push_back(std::move(object));
 			}
 		}
 		_deletionQueue.clear();
+
+		// Objects can outlive the scene (ex: components holding on to other objects), so the object's
+		// transform is released here rather than when it is destroyed
+		_objects.Remove(_deleting, [this](GameObject& object) {
+			_ReleaseTransform(object);
+		});
+		_deleting.clear();
+	}
+
+	void Scene::_AddObject(const GameObject::Sptr& object) {
+		GameObject::Sptr existing = _objects.FindByGuid(object->GetGUID());
+		if (existing != nullptr) {
+			LOG_WARN("Object \"{}\" has the same GUID as \"{}\", the one added first will be found when looking up that GUID", object->GetName(), existing->GetName());
+		}
+		_objects.Add(object);
+	}
+
+	void Scene::_ReleaseTransform(GameObject& object) {
+		if (object._transform != TransformStore::INVALID_HANDLE) {
+			_transforms.Release(object._transform);
+			object._transform = TransformStore::INVALID_HANDLE;
+		}
+	}
+
+	void Scene::_ClearObjects() {
+		for (const GameObject::Sptr& object : _objects) {
+			_ReleaseTransform(*object);
+		}
+		_objects.Clear();
+	}
+
+	void Scene::_OnObjectRenamed(GameObject* object, const std::string& oldName) {
+		_objects.OnRenamed(object, oldName);
 	}
 
 	void Scene::DrawAllGameObjectGUIs()
@@ -4,6 +4,10 @@
 
 #include "Gameplay/Components/Camera.h"
 #include "Gameplay/GameObject.h"
+#include "Gameplay/ObjectList.h"
+#include "Gameplay/SceneBinary.h"
+#include "Gameplay/SceneCommandBuffer.h"
+#include "Gameplay/TransformStore.h"
 
 #include "Physics/BulletDebugDraw.h"
 
@@ -71,29 +75,31 @@ namespace Gameplay {
 
 		/// <summary>
 		/// Creates a game object with the given name
-		/// CreateGameObject is the only way to create game objects
+		/// CreateGameObject is the only way to create game objects, and must
+		/// not be called from a job (use Commands() instead)
 		/// </summary>
 		/// <param name="name">The name of the gameobject to create</param>
 		/// <returns>A new gameobject with the given name</returns>
 		GameObject::Sptr CreateGameObject(const std::string& name);
 
 		/// <summary>
-		/// Queues a game object for deletion at the call of the next Update function
+		/// Queues a game object for deletion at the call of the next Update function,
+		/// if called from a job the removal is deferred through Commands()
 		/// </summary>
 		/// <param name="object">The gameobject to delete</param>
 		void RemoveGameObject(const GameObject::Sptr& object);
 
 		/// <summary>
-		/// Searches all objects in the scene and returns the first
-		/// one who's name matches the one given, or nullptr if no object
-		/// is found
+		/// Returns an object in the scene who's name matches the one given,
+		/// or nullptr if no object is found. If several objects share the
+		/// name, the one that was added to the scene first is returned
 		/// </summary>
 		/// <param name="name">The name of the object to find</param>
 		GameObject::Sptr FindObjectByName(const std::string name) const;
 		/// <summary>
-		/// Searches all render objects in the scene and returns the first
-		/// one who's guid matches the one given, or nullptr if no object
-		/// is found
+		/// Returns the object in the scene who's guid matches the one given,
+		/// or nullptr if no object is found. If several objects share the
+		/// guid, the one that was added to the scene first is returned
 		/// </summary>
 		/// <param name="id">The guid of the object to find</param>
 		GameObject::Sptr FindObjectByGUID(Guid id) const;
@@ -134,7 +140,9 @@ namespace Gameplay {
 
 		/// <summary>
 		/// Performs updates on all enabled components and gameobjects in the
-		/// scene
+		/// scene. Component updates are grouped by type, and types that allow
+		/// it are updated in parallel (see ComponentUpdateMode). Commands that
+		/// were recorded during the update are applied at the end
 		/// 
 		/// Only invokes events if IsPlaying is true
 		/// </summary>
@@ -164,6 +172,10 @@ namespace Gameplay {
 		/// </summary>
 		static Scene::Sptr FromJson(const nlohmann::json& data);
 		/// <summary>
+		/// Loads a scene from a binary scene file that has been opened for reading
+		/// </summary>
+		static Scene::Sptr FromBinary(const SceneBinary::Reader& reader);
+		/// <summary>
 		/// Converts this object into it's JSON representation for storage
 		/// </summary>
 		nlohmann::json ToJson() const;
@@ -172,12 +184,19 @@ namespace Gameplay {
 		const ComponentManager& Components() const { return _components; }
 
 		/// <summary>
-		/// Saves this scene to an output JSON file
+		/// Gets the buffer that structural changes to the scene can be recorded into from any thread,
+		/// the commands are applied at the end of the next Update
+		/// </summary>
+		SceneCommandBuffer& Commands() { return _commands; }
+
+		/// <summary>
+		/// Saves this scene to an output file, paths ending in SceneBinary::EXTENSION are saved
+		/// in the binary scene format, and all other paths are saved as JSON
 		/// </summary>
 		/// <param name="path">The path of the file to write to</param>
 		void Save(const std::string& path);
 		/// <summary>
-		/// Loads a scene from an input JSON file
+		/// Loads a scene from an input JSON or binary scene file
 		/// </summary>
 		/// <param name="path">The path of the file to read from</param>
 		/// <returns>A new scene loaded from the file</returns>
@@ -193,6 +212,10 @@ namespace Gameplay {
 
 		// The component manager will store all components for objects in this scene
 		ComponentManager _components;
+		// Stores the position, rotation, scale, and matrices for all objects in this scene
+		TransformStore _transforms;
+		// Structural changes that have been deferred until the end of the update
+		SceneCommandBuffer _commands;
 
 		// Bullet physics stuff world
 		btDynamicsWorld*          _physicsWorld;
@@ -215,9 +238,13 @@ namespace Gameplay {
 		// Our physics scene's global gravity, default matches earth's gravity (m/s^2)
 		glm::vec3 _gravity;
 
-		// Stores all the objects in our scene
-		std::vector<GameObject::Sptr>  _objects;
+		// Stores all the objects in our scene in the order they were added, along with lookups by GUID
+		// and name. Deleted objects are queued and removed together in _FlushDeleteQueue, and the name
+		// lookup is kept up to date by GameObject::SetName
+		ObjectList<GameObject>  _objects;
 		std::vector<std::weak_ptr<GameObject>>  _deletionQueue;
+		// Scratch list for _FlushDeleteQueue, kept to avoid allocating every frame
+		std::vector<GameObject::Sptr>  _deleting;
 
 		// Info for rendering our skybox will be stored in the scene itself
 		std::shared_ptr<ShaderProgram>       _skyboxShader;
@@ -241,6 +268,31 @@ namespace Gameplay {
 		/// </summary>
 		void _CleanupPhysics();
 
+		/// <summary>
+		/// Removes every object in the deletion queue, keeping the remaining objects in order
+		/// </summary>
 		void _FlushDeleteQueue();
+
+		/// <summary>
+		/// Updates all enabled components, one component type at a time
+		/// </summary>
+		void _UpdateComponents(float dt);
+
+		/// <summary>
+		/// Adds an object to the scene's object list and lookups
+		/// </summary>
+		void _AddObject(const GameObject::Sptr& object);
+		/// <summary>
+		/// Releases an object's transform from the transform store, once it has been removed from the scene
+		/// </summary>
+		void _ReleaseTransform(GameObject& object);
+		/// <summary>
+		/// Removes all objects from the scene's object list and lookups
+		/// </summary>
+		void _ClearObjects();
+		/// <summary>
+		/// Updates the name lookup after an object in the scene has been renamed
+		/// </summary>
+		void _OnObjectRenamed(GameObject* object, const std::string& oldName);
 	};
 }
\ No newline at end of file
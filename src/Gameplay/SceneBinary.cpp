@@ -0,0 +1,444 @@
+#include "Gameplay/SceneBinary.h"
+
+#include <algorithm>
+#include <fstream>
+#include <filesystem>
+#include <cstring>
+#include <functional>
+#include <unordered_map>
+#include <Logging.h>
+
+#include "Utils/FileHelpers.h"
+#include "Utils/HashUtils.h"
+
+namespace Gameplay {
+	// The top level scene keys that have their own fields in the binary header, everything else is stored as extra data
+	static const char* SCENE_KEYS[] = { "default_material", "main_camera", "ambient", "skybox", "objects" };
+
+	// Checks that count elements of the given size starting at offset fit in a buffer, without overflowing
+	static bool FitsInRange(uint64_t offset, uint64_t count, uint64_t stride, uint64_t size) {
+		return offset <= size && (stride == 0 || count <= (size - offset) / stride);
+	}
+
+	// Writes a GUID string (or "null") into 16 raw bytes
+	static void WriteGuid(const nlohmann::json& value, uint8_t* result) {
+		Guid guid = value.is_string() ? Guid(value.get<std::string>()) : Guid();
+		memcpy(result, guid.bytes(), 16);
+	}
+
+	// Converts a GUID into the string form used by JSON scenes, where invalid GUIDs are stored as "null"
+	static std::string GuidToJson(const Guid& guid) {
+		return guid.isValid() ? guid.str() : "null";
+	}
+
+	SceneBinary::Reader::Reader() :
+		_file(),
+		_header(nullptr),
+		_strings(nullptr),
+		_types(nullptr),
+		_objects(nullptr),
+		_components(nullptr),
+		_blobs(nullptr)
+	{ }
+
+	bool SceneBinary::Reader::Open(const std::string& filename) {
+		if (!_file.Open(filename)) {
+			LOG_ERROR("Failed to open binary scene \"{}\"", filename);
+			return false;
+		}
+		if (!_Validate(filename)) {
+			_file.Close();
+			_header = nullptr;
+			return false;
+		}
+
+		const uint8_t* data = _file.GetData();
+		_header     = reinterpret_cast<const BinaryHeader*>(data);
+		_strings    = reinterpret_cast<const BinaryString*>(data + _header->StringsOffset);
+		_types      = reinterpret_cast<const uint32_t*>(data + _header->TypesOffset);
+		_objects    = reinterpret_cast<const BinaryObject*>(data + _header->ObjectsOffset);
+		_components = reinterpret_cast<const BinaryComponent*>(data + _header->ComponentsOffset);
+		_blobs      = data + _header->BlobsOffset;
+		return true;
+	}
+
+	bool SceneBinary::Reader::_Validate(const std::string& filename) {
+		const uint8_t* data = _file.GetData();
+		const size_t size = _file.GetSize();
+
+		BinaryHeader header;
+		if (size < sizeof(BinaryHeader) || memcmp(data, header.HeaderBytes, sizeof(header.HeaderBytes)) != 0) {
+			LOG_ERROR("\"{}\" is not a binary scene file!", filename);
+			return false;
+		}
+		memcpy(&header, data, sizeof(BinaryHeader));
+		if (header.Version != 0x01) {
+			LOG_ERROR("Unknown binary scene version {} in \"{}\"", header.Version, filename);
+			return false;
+		}
+		if (header.HeaderSize != sizeof(BinaryHeader) || header.FileSize != size) {
+			LOG_ERROR("Binary scene \"{}\" has an invalid header, or has been truncated", filename);
+			return false;
+		}
+		if (HashUtils::Hash(data + header.HeaderSize, size - header.HeaderSize) != header.Checksum) {
+			LOG_ERROR("Binary scene \"{}\" failed its checksum, the file is corrupt", filename);
+			return false;
+		}
+
+		// Make sure that every section lies within the file, and that the tables are aligned so we can read them in place
+		bool sectionsValid =
+			FitsInRange(header.StringsOffset, header.NumStrings, sizeof(BinaryString), size) &&
+			FitsInRange(header.TypesOffset, header.NumTypes, sizeof(uint32_t), size) &&
+			FitsInRange(header.ObjectsOffset, header.NumObjects, sizeof(BinaryObject), size) &&
+			FitsInRange(header.ComponentsOffset, header.NumComponents, sizeof(BinaryComponent), size) &&
+			FitsInRange(header.BlobsOffset, header.BlobsSize, 1, size) &&
+			FitsInRange(header.ExtraOffset, header.ExtraSize, 1, header.BlobsSize);
+		for (uint64_t offset : { header.StringsOffset, header.TypesOffset, header.ObjectsOffset, header.ComponentsOffset }) {
+			sectionsValid &= offset % SECTION_ALIGNMENT == 0;
+		}
+		if (!sectionsValid) {
+			LOG_ERROR("Binary scene \"{}\" has sections outside of the file", filename);
+			return false;
+		}
+
+		// Check every index and blob range up front, so that loading can trust the tables
+		const BinaryString* strings = reinterpret_cast<const BinaryString*>(data + header.StringsOffset);
+		const uint32_t* types = reinterpret_cast<const uint32_t*>(data + header.TypesOffset);
+		const BinaryObject* objects = reinterpret_cast<const BinaryObject*>(data + header.ObjectsOffset);
+		const BinaryComponent* components = reinterpret_cast<const BinaryComponent*>(data + header.ComponentsOffset);
+		const uint8_t* blobs = data + header.BlobsOffset;
+		for (uint32_t ix = 0; ix < header.NumStrings; ix++) {
+			// Strings need room for their null terminator
+			if (!FitsInRange(strings[ix].Offset, (uint64_t)strings[ix].Length + 1, 1, header.BlobsSize) || blobs[strings[ix].Offset + strings[ix].Length] != '\0') {
+				LOG_ERROR("Binary scene \"{}\" has an invalid string at index {}", filename, ix);
+				return false;
+			}
+		}
+		for (uint32_t ix = 0; ix < header.NumTypes; ix++) {
+			if (types[ix] >= header.NumStrings) {
+				LOG_ERROR("Binary scene \"{}\" has an invalid component type at index {}", filename, ix);
+				return false;
+			}
+		}
+		for (uint32_t ix = 0; ix < header.NumObjects; ix++) {
+			if (objects[ix].Name >= header.NumStrings || !FitsInRange(objects[ix].FirstComponent, objects[ix].NumComponents, 1, header.NumComponents)) {
+				LOG_ERROR("Binary scene \"{}\" has an invalid object at index {}", filename, ix);
+				return false;
+			}
+		}
+		for (uint32_t ix = 0; ix < header.NumComponents; ix++) {
+			if (components[ix].Type >= header.NumTypes || !FitsInRange(components[ix].BlobOffset, components[ix].BlobSize, 1, header.BlobsSize)) {
+				LOG_ERROR("Binary scene \"{}\" has an invalid component at index {}", filename, ix);
+				return false;
+			}
+		}
+		return true;
+	}
+
+	std::string_view SceneBinary::Reader::GetString(uint32_t index) const {
+		const BinaryString& entry = _strings[index];
+		return std::string_view(reinterpret_cast<const char*>(_blobs + entry.Offset), entry.Length);
+	}
+
+	nlohmann::json SceneBinary::Reader::ReadComponentData(const BinaryComponent& component) const {
+		if (component.BlobSize == 0) {
+			return nlohmann::json::object();
+		}
+		return nlohmann::json::from_cbor(_blobs + component.BlobOffset, _blobs + component.BlobOffset + component.BlobSize);
+	}
+
+	nlohmann::json SceneBinary::Reader::ReadExtraData() const {
+		if (_header->ExtraSize == 0) {
+			return nlohmann::json::object();
+		}
+		return nlohmann::json::from_cbor(_blobs + _header->ExtraOffset, _blobs + _header->ExtraOffset + _header->ExtraSize);
+	}
+
+	bool SceneBinary::IsBinaryFile(const std::string& filename) {
+		std::ifstream file(filename, std::ios::binary);
+		char headerBytes[4] = { 0 };
+		if (!file || !file.read(headerBytes, sizeof(headerBytes))) {
+			return false;
+		}
+		return memcmp(headerBytes, BinaryHeader().HeaderBytes, sizeof(headerBytes)) == 0;
+	}
+
+	Guid SceneBinary::ReadGuid(const uint8_t* bytes) {
+		// FromBytes wants a mutable pointer, even though it only copies the data
+		uint8_t copy[16];
+		memcpy(copy, bytes, 16);
+		return Guid::FromBytes(copy);
+	}
+
+	void SceneBinary::Write(const nlohmann::json& scene, const std::string& outFilename) {
+		BinaryHeader header = BinaryHeader();
+
+		std::vector<BinaryString> strings;
+		std::vector<uint32_t> types;
+		std::vector<BinaryObject> objects;
+		std::vector<BinaryComponent> components;
+		std::vector<uint8_t> blobs;
+
+		// Every string is only stored once, no matter how many objects use it
+		std::unordered_map<std::string, uint32_t> stringIndices;
+		auto addString = [&](const std::string& value) {
+			auto it = stringIndices.find(value);
+			if (it != stringIndices.end()) {
+				return it->second;
+			}
+			uint32_t index = static_cast<uint32_t>(strings.size());
+			strings.push_back({ static_cast<uint32_t>(blobs.size()), static_cast<uint32_t>(value.size()) });
+			blobs.insert(blobs.end(), value.begin(), value.end());
+			blobs.push_back('\0');
+			stringIndices[value] = index;
+			return index;
+		};
+		std::unordered_map<std::string, uint32_t> typeIndices;
+		auto addType = [&](const std::string& typeName) {
+			auto it = typeIndices.find(typeName);
+			if (it != typeIndices.end()) {
+				return it->second;
+			}
+			uint32_t index = static_cast<uint32_t>(types.size());
+			types.push_back(addString(typeName));
+			typeIndices[typeName] = index;
+			return index;
+		};
+		auto addBlob = [&](const std::vector<uint8_t>& data) {
+			uint32_t offset = static_cast<uint32_t>(blobs.size());
+			blobs.insert(blobs.end(), data.begin(), data.end());
+			return offset;
+		};
+		auto readVec = [](const nlohmann::json& value, float* result, int count) {
+			static const char* KEYS[] = { "x", "y", "z", "w" };
+			for (int ix = 0; ix < count; ix++) {
+				result[ix] = value.at(KEYS[ix]).get<float>();
+			}
+		};
+
+		// Scene settings
+		WriteGuid(scene.value("default_material", nlohmann::json()), header.DefaultMaterial);
+		WriteGuid(scene.value("main_camera", nlohmann::json()), header.MainCamera);
+		if (scene.contains("ambient")) {
+			header.Flags |= SCENE_HAS_AMBIENT;
+			readVec(scene["ambient"], header.AmbientLight, 3);
+		}
+		if (scene.contains("skybox") && scene["skybox"].is_object()) {
+			const nlohmann::json& skybox = scene["skybox"];
+			header.Flags |= SCENE_HAS_SKYBOX;
+			WriteGuid(skybox.value("mesh", nlohmann::json()), header.SkyboxMesh);
+			WriteGuid(skybox.value("shader", nlohmann::json()), header.SkyboxShader);
+			WriteGuid(skybox.value("texture", nlohmann::json()), header.SkyboxTexture);
+			readVec(skybox["orientation"], header.SkyboxOrientation, 4);
+		}
+
+		// Objects and their components. The nested children in JSON scenes are just copies of objects that are
+		// already in the object list, so we only store the parent and rebuild the children when converting back
+		LOG_ASSERT(scene["objects"].is_array(), "Objects not present in scene!");
+		for (const nlohmann::json& object : scene["objects"]) {
+			BinaryObject record;
+			WriteGuid(object["guid"], record.Guid);
+			WriteGuid(object.value("parent", nlohmann::json()), record.Parent);
+			record.Name = addString(object["name"].get<std::string>());
+			record.Flags = object.value("hide_in_inspector", false) ? OBJECT_HIDE_IN_HIERARCHY : 0;
+			readVec(object["position"], record.Position, 3);
+			readVec(object["rotation"], record.Rotation, 4);
+			readVec(object["scale"], record.Scale, 3);
+			record.FirstComponent = static_cast<uint32_t>(components.size());
+
+			// Objects without components store null rather than an empty object
+			const nlohmann::json& componentsBlob = object["components"];
+			if (componentsBlob.is_object()) {
+				for (const auto& [typeName, value] : componentsBlob.items()) {
+					BinaryComponent component;
+					component.Type = addType(typeName);
+					WriteGuid(value["guid"], component.Guid);
+					component.Flags = value.value("enabled", true) ? COMPONENT_ENABLED : 0;
+
+					// The GUID and enabled flag have their own fields, so strip them from the blob
+					nlohmann::json data = value;
+					data.erase("guid");
+					data.erase("enabled");
+					std::vector<uint8_t> cbor = nlohmann::json::to_cbor(data);
+					component.BlobOffset = addBlob(cbor);
+					component.BlobSize = static_cast<uint32_t>(cbor.size());
+					components.push_back(component);
+				}
+			}
+			record.NumComponents = static_cast<uint32_t>(components.size()) - record.FirstComponent;
+			objects.push_back(record);
+		}
+
+		// Anything else at the top level of the scene is kept as-is, so converting back to JSON doesn't lose it
+		nlohmann::json extra = nlohmann::json::object();
+		for (const auto& [key, value] : scene.items()) {
+			if (std::find(std::begin(SCENE_KEYS), std::end(SCENE_KEYS), key) == std::end(SCENE_KEYS)) {
+				extra[key] = value;
+			}
+		}
+		if (!extra.empty()) {
+			std::vector<uint8_t> cbor = nlohmann::json::to_cbor(extra);
+			header.ExtraOffset = addBlob(cbor);
+			header.ExtraSize = static_cast<uint32_t>(cbor.size());
+		}
+
+		// Lay out each section on an aligned boundary
+		auto align = [](size_t value) { return (value + SECTION_ALIGNMENT - 1) & ~(SECTION_ALIGNMENT - 1); };
+		size_t stringBytes    = strings.size() * sizeof(BinaryString);
+		size_t typeBytes      = types.size() * sizeof(uint32_t);
+		size_t objectBytes    = objects.size() * sizeof(BinaryObject);
+		size_t componentBytes = components.size() * sizeof(BinaryComponent);
+
+		header.HeaderSize       = sizeof(BinaryHeader);
+		header.NumStrings       = static_cast<uint32_t>(strings.size());
+		header.NumTypes         = static_cast<uint32_t>(types.size());
+		header.NumObjects       = static_cast<uint32_t>(objects.size());
+		header.NumComponents    = static_cast<uint32_t>(components.size());
+		header.StringsOffset    = align(sizeof(BinaryHeader));
+		header.TypesOffset      = align(header.StringsOffset + stringBytes);
+		header.ObjectsOffset    = align(header.TypesOffset + typeBytes);
+		header.ComponentsOffset = align(header.ObjectsOffset + objectBytes);
+		header.BlobsOffset      = align(header.ComponentsOffset + componentBytes);
+		header.BlobsSize        = blobs.size();
+		header.FileSize         = header.BlobsOffset + header.BlobsSize;
+
+		// Build the body of the file in memory so we can checksum it (padding is left zeroed). The section offsets
+		// are from the start of the file, and the body starts after the header
+		std::vector<uint8_t> body(header.FileSize - header.HeaderSize, 0);
+		if (stringBytes > 0)    { memcpy(body.data() + (header.StringsOffset - header.HeaderSize), strings.data(), stringBytes); }
+		if (typeBytes > 0)      { memcpy(body.data() + (header.TypesOffset - header.HeaderSize), types.data(), typeBytes); }
+		if (objectBytes > 0)    { memcpy(body.data() + (header.ObjectsOffset - header.HeaderSize), objects.data(), objectBytes); }
+		if (componentBytes > 0) { memcpy(body.data() + (header.ComponentsOffset - header.HeaderSize), components.data(), componentBytes); }
+		if (!blobs.empty())     { memcpy(body.data() + (header.BlobsOffset - header.HeaderSize), blobs.data(), blobs.size()); }
+		header.Checksum = HashUtils::Hash(body.data(), body.size());
+
+		// Write to a temporary file first, so that a crash mid-write never leaves a partial scene behind
+		std::string tempFile = outFilename + ".tmp";
+		{
+			std::ofstream file(tempFile, std::ios::binary);
+			if (!file) {
+				throw std::runtime_error("Failed to open output file");
+			}
+			file.write(reinterpret_cast<const char*>(&header), sizeof(BinaryHeader));
+			file.write(reinterpret_cast<const char*>(body.data()), body.size());
+			if (!file) {
+				throw std::runtime_error("Failed to write output file");
+			}
+		}
+
+		std::error_code error;
+		std::filesystem::rename(tempFile, outFilename, error);
+		if (error) {
+			std::filesystem::remove(tempFile, error);
+			throw std::runtime_error("Failed to replace output file");
+		}
+	}
+
+	nlohmann::json SceneBinary::ToJson(const Reader& reader) {
+		const BinaryHeader& header = reader.GetHeader();
+		auto writeVec = [](const float* values, int count) {
+			static const char* KEYS[] = { "x", "y", "z", "w" };
+			nlohmann::json result = nlohmann::json::object();
+			for (int ix = 0; ix < count; ix++) {
+				result[KEYS[ix]] = values[ix];
+			}
+			return result;
+		};
+
+		nlohmann::json result = reader.ReadExtraData();
+		result["default_material"] = GuidToJson(ReadGuid(header.DefaultMaterial));
+		result["main_camera"] = GuidToJson(ReadGuid(header.MainCamera));
+		if (header.Flags & SCENE_HAS_AMBIENT) {
+			result["ambient"] = writeVec(header.AmbientLight, 3);
+		}
+		if (header.Flags & SCENE_HAS_SKYBOX) {
+			result["skybox"] = {
+				{ "mesh", GuidToJson(ReadGuid(header.SkyboxMesh)) },
+				{ "shader", GuidToJson(ReadGuid(header.SkyboxShader)) },
+				{ "texture", GuidToJson(ReadGuid(header.SkyboxTexture)) },
+				{ "orientation", writeVec(header.SkyboxOrientation, 4) }
+			};
+		}
+
+		// Convert every object without its children first, we need all of them to rebuild the nested children
+		std::vector<nlohmann::json> objects(reader.GetNumObjects());
+		std::unordered_map<Guid, uint32_t> objectIndices;
+		for (uint32_t ix = 0; ix < reader.GetNumObjects(); ix++) {
+			const BinaryObject& record = reader.GetObjectRecord(ix);
+			nlohmann::json& object = objects[ix];
+			Guid guid = ReadGuid(record.Guid);
+			object["name"] = std::string(reader.GetString(record.Name));
+			object["guid"] = GuidToJson(guid);
+			object["parent"] = GuidToJson(ReadGuid(record.Parent));
+			object["position"] = writeVec(record.Position, 3);
+			object["rotation"] = writeVec(record.Rotation, 4);
+			object["scale"] = writeVec(record.Scale, 3);
+			object["hide_in_inspector"] = (record.Flags & OBJECT_HIDE_IN_HIERARCHY) != 0;
+			object["components"] = nlohmann::json();
+			for (uint32_t cx = record.FirstComponent; cx < record.FirstComponent + record.NumComponents; cx++) {
+				const BinaryComponent& component = reader.GetComponentRecord(cx);
+				nlohmann::json data = reader.ReadComponentData(component);
+				data["guid"] = ReadGuid(component.Guid).str();
+				data["enabled"] = (component.Flags & COMPONENT_ENABLED) != 0;
+				object["components"][std::string(reader.GetTypeName(component.Type))] = std::move(data);
+			}
+			objectIndices[guid] = ix;
+		}
+
+		// Find the children of each object, in the order they appear in the object list
+		std::vector<std::vector<uint32_t>> children(objects.size());
+		for (uint32_t ix = 0; ix < reader.GetNumObjects(); ix++) {
+			Guid parent = ReadGuid(reader.GetObjectRecord(ix).Parent);
+			auto it = parent.isValid() ? objectIndices.find(parent) : objectIndices.end();
+			if (it != objectIndices.end()) {
+				children[it->second].push_back(ix);
+			}
+		}
+
+		// Objects store full copies of their children, like GameObject::ToJson, depth is bounded by the
+		// number of objects so a broken hierarchy with a cycle can't recurse forever
+		std::function<nlohmann::json(uint32_t, uint32_t)> buildObject = [&](uint32_t index, uint32_t depth) {
+			nlohmann::json object = objects[index];
+			object["children"] = std::vector<nlohmann::json>();
+			if (depth < objects.size()) {
+				for (uint32_t child : children[index]) {
+					object["children"].push_back(buildObject(child, depth + 1));
+				}
+			}
+			return object;
+		};
+		std::vector<nlohmann::json> objectList;
+		objectList.reserve(objects.size());
+		for (uint32_t ix = 0; ix < reader.GetNumObjects(); ix++) {
+			objectList.push_back(buildObject(ix, 0));
+		}
+		result["objects"] = std::move(objectList);
+
+		return result;
+	}
+
+	void SceneBinary::ConvertJsonToBinary(const std::string& inFile, const std::string& outFile) {
+		std::string outFileName = outFile;
+		if (outFileName.empty()) {
+			outFileName = std::filesystem::path(inFile).replace_extension(EXTENSION).string();
+		}
+
+		nlohmann::json scene = nlohmann::json::parse(FileHelpers::ReadFile(inFile));
+		Write(scene, outFileName);
+		LOG_INFO("Converted scene \"{}\" to binary \"{}\"", inFile, outFileName);
+	}
+
+	void SceneBinary::ConvertBinaryToJson(const std::string& inFile, const std::string& outFile) {
+		std::string outFileName = outFile;
+		if (outFileName.empty()) {
+			outFileName = std::filesystem::path(inFile).replace_extension(".json").string();
+		}
+
+		Reader reader;
+		if (!reader.Open(inFile)) {
+			throw std::runtime_error("Failed to open binary scene");
+		}
+		FileHelpers::WriteContentsToFile(outFileName, ToJson(reader).dump(1, '\t'));
+		LOG_INFO("Converted binary scene \"{}\" to \"{}\"", inFile, outFileName);
+	}
+}
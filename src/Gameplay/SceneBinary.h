@@ -0,0 +1,222 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "json.hpp"
+#include "Utils/GUID.hpp"
+#include "Utils/Macros.h"
+#include "Utils/MemoryMappedFile.h"
+
+namespace Gameplay {
+	/// <summary>
+	/// Describes our binary scene format, which stores the same data as a JSON scene but can be
+	/// loaded straight out of a memory mapped file without building a JSON document for the whole
+	/// scene first. All strings are stored once in a string table, GUIDs are stored as raw bytes,
+	/// and transforms are stored as packed floats. Components are stored as small CBOR blobs
+	/// alongside a table of component type names, since components only know how to load from JSON
+	///
+	/// JSON is still the format that the editor works with, use ConvertJsonToBinary and
+	/// ConvertBinaryToJson to move between the two
+	/// </summary>
+	class SceneBinary {
+	public:
+		SceneBinary() = delete;
+
+		/// <summary>
+		/// The file extension that binary scenes are saved with
+		/// </summary>
+		static constexpr const char* EXTENSION = ".bscene";
+
+		// Header for a binary scene file, all fields are explicitly sized and each section is 16 byte aligned
+		struct alignas(16) BinaryHeader {
+			// A check value so we can ensure that we're loading in the right file type
+			char      HeaderBytes[4] = { 'B', 'S', 'C', 'N' };
+			// The version code, we can use this to create different loaders if our format changes
+			uint16_t  Version = 0x01;
+			// The size of this header, in bytes
+			uint16_t  HeaderSize = 0;
+			// The number of entries in each table
+			uint32_t  NumStrings = 0;
+			uint32_t  NumTypes = 0;
+			uint32_t  NumObjects = 0;
+			uint32_t  NumComponents = 0;
+			// Combination of the SCENE_ flags below
+			uint32_t  Flags = 0;
+			// The size of the CBOR blob holding any top level scene keys that we don't have fields for
+			uint32_t  ExtraSize = 0;
+			// Byte offsets from the start of the file to each section
+			uint64_t  StringsOffset = 0;
+			uint64_t  TypesOffset = 0;
+			uint64_t  ObjectsOffset = 0;
+			uint64_t  ComponentsOffset = 0;
+			// The blob section holds the characters for the string table and the data for each component
+			uint64_t  BlobsOffset = 0;
+			uint64_t  BlobsSize = 0;
+			// The offset of the extra scene data, relative to the start of the blob section
+			uint64_t  ExtraOffset = 0;
+			// The total size of the file in bytes
+			uint64_t  FileSize = 0;
+			// Hash of everything in the file after the header
+			uint64_t  Checksum = 0;
+			// Scene settings, GUIDs that are all zero refer to nothing
+			uint8_t   DefaultMaterial[16] = { 0 };
+			uint8_t   MainCamera[16] = { 0 };
+			uint8_t   SkyboxMesh[16] = { 0 };
+			uint8_t   SkyboxShader[16] = { 0 };
+			uint8_t   SkyboxTexture[16] = { 0 };
+			// Stored as x, y, z, w
+			float     SkyboxOrientation[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+			float     AmbientLight[3] = { 0.0f, 0.0f, 0.0f };
+			// Reserved for future use
+			uint32_t  Reserved[3] = { 0, 0, 0 };
+		};
+		static_assert(sizeof(BinaryHeader) == 224, "BinaryHeader layout has changed, update the version number!");
+
+		// Set when the scene has an ambient light value
+		static constexpr uint32_t SCENE_HAS_AMBIENT = 1 << 0;
+		// Set when the scene has a skybox
+		static constexpr uint32_t SCENE_HAS_SKYBOX  = 1 << 1;
+
+		// An entry in the string table, the string is null terminated in the blob section
+		struct BinaryString {
+			// The offset of the first character, relative to the start of the blob section
+			uint32_t Offset = 0;
+			// The length of the string, not including the null terminator
+			uint32_t Length = 0;
+		};
+		static_assert(sizeof(BinaryString) == 8, "BinaryString layout has changed, update the version number!");
+
+		// A single game object, the type table is just the string index of each type's name
+		struct BinaryObject {
+			uint8_t  Guid[16] = { 0 };
+			uint8_t  Parent[16] = { 0 };
+			// Index into the string table
+			uint32_t Name = 0;
+			// Combination of the OBJECT_ flags below
+			uint32_t Flags = 0;
+			// The range of the component table that belongs to this object
+			uint32_t FirstComponent = 0;
+			uint32_t NumComponents = 0;
+			float    Position[3] = { 0.0f, 0.0f, 0.0f };
+			// Stored as x, y, z, w
+			float    Rotation[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+			float    Scale[3] = { 1.0f, 1.0f, 1.0f };
+		};
+		static_assert(sizeof(BinaryObject) == 88, "BinaryObject layout has changed, update the version number!");
+
+		// Set when the object should be hidden in the hierarchy window
+		static constexpr uint32_t OBJECT_HIDE_IN_HIERARCHY = 1 << 0;
+
+		// A single component, the base component fields (GUID and enabled) are pulled out of the blob
+		struct BinaryComponent {
+			uint8_t  Guid[16] = { 0 };
+			// Index into the type table
+			uint32_t Type = 0;
+			// Combination of the COMPONENT_ flags below
+			uint32_t Flags = 0;
+			// The component's data encoded as CBOR, the offset is relative to the start of the blob section
+			uint32_t BlobOffset = 0;
+			uint32_t BlobSize = 0;
+		};
+		static_assert(sizeof(BinaryComponent) == 32, "BinaryComponent layout has changed, update the version number!");
+
+		// Set when the component is enabled
+		static constexpr uint32_t COMPONENT_ENABLED = 1 << 0;
+
+		// The alignment that each section in the file starts on
+		static constexpr size_t SECTION_ALIGNMENT = 16;
+
+		/// <summary>
+		/// Provides validated access to the sections of a binary scene that has been mapped into memory.
+		/// Once Open has succeeded, every index and offset in the file has been checked, so the
+		/// accessors don't need to do any further validation
+		/// </summary>
+		class Reader {
+		public:
+			NO_COPY(Reader);
+			NO_MOVE(Reader);
+
+			Reader();
+			~Reader() = default;
+
+			/// <summary>
+			/// Maps and validates the given binary scene file
+			/// </summary>
+			/// <param name="filename">The path of the file to open</param>
+			/// <returns>True if the file is a valid binary scene, false if otherwise</returns>
+			bool Open(const std::string& filename);
+
+			const BinaryHeader& GetHeader() const { return *_header; }
+
+			/// <summary>
+			/// Gets a string from the string table
+			/// </summary>
+			std::string_view GetString(uint32_t index) const;
+			/// <summary>
+			/// Gets the name of a component type from the type table
+			/// </summary>
+			std::string_view GetTypeName(uint32_t index) const { return GetString(_types[index]); }
+
+			uint32_t GetNumObjects() const { return _header->NumObjects; }
+			const BinaryObject& GetObjectRecord(uint32_t index) const { return _objects[index]; }
+			const BinaryComponent& GetComponentRecord(uint32_t index) const { return _components[index]; }
+
+			/// <summary>
+			/// Decodes the data for a component, this does not include the component's GUID or enabled state
+			/// </summary>
+			nlohmann::json ReadComponentData(const BinaryComponent& component) const;
+			/// <summary>
+			/// Decodes any top level keys for the scene that the binary format does not have fields for
+			/// </summary>
+			nlohmann::json ReadExtraData() const;
+
+		protected:
+			MemoryMappedFile       _file;
+			const BinaryHeader*    _header;
+			const BinaryString*    _strings;
+			const uint32_t*        _types;
+			const BinaryObject*    _objects;
+			const BinaryComponent* _components;
+			const uint8_t*         _blobs;
+
+			bool _Validate(const std::string& filename);
+		};
+
+		/// <summary>
+		/// Checks whether the file at the given path starts with the binary scene header bytes
+		/// </summary>
+		static bool IsBinaryFile(const std::string& filename);
+
+		/// <summary>
+		/// Encodes a scene that has been converted to JSON (see Scene::ToJson) and writes it to a binary file
+		/// </summary>
+		/// <param name="scene">The JSON representation of the scene</param>
+		/// <param name="outFilename">The path to write the binary scene to</param>
+		static void Write(const nlohmann::json& scene, const std::string& outFilename);
+		/// <summary>
+		/// Decodes a binary scene back into the same JSON representation that Scene::ToJson produces
+		/// </summary>
+		static nlohmann::json ToJson(const Reader& reader);
+
+		/// <summary>
+		/// Converts a JSON scene file to a binary scene file, without needing to load the scene
+		/// </summary>
+		/// <param name="inFile">The path to the JSON scene to convert</param>
+		/// <param name="outFile">The output path, or empty to use the inFile path with the extension replaced</param>
+		static void ConvertJsonToBinary(const std::string& inFile, const std::string& outFile = "");
+		/// <summary>
+		/// Converts a binary scene file back to a JSON scene file, without needing to load the scene
+		/// </summary>
+		/// <param name="inFile">The path to the binary scene to convert</param>
+		/// <param name="outFile">The output path, or empty to use the inFile path with the extension replaced by .json</param>
+		static void ConvertBinaryToJson(const std::string& inFile, const std::string& outFile = "");
+
+		/// <summary>
+		/// Reads a GUID that has been stored as raw bytes
+		/// </summary>
+		static Guid ReadGuid(const uint8_t* bytes);
+	};
+}
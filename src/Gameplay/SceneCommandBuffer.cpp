@@ -0,0 +1,75 @@
+#include "Gameplay/SceneCommandBuffer.h"
+#include "Gameplay/Scene.h"
+
+namespace Gameplay {
+	SceneCommandBuffer::SceneCommandBuffer() :
+		_mutex(),
+		_commands(),
+		_executing()
+	{ }
+
+	void SceneCommandBuffer::Push(Command command) {
+		std::lock_guard<std::mutex> lock(_mutex);
+		_commands.push_back(std::move(command));
+	}
+
+	void SceneCommandBuffer::CreateGameObject(const std::string& name, std::function<void(const GameObject::Sptr&)> onCreated) {
+		Push([name, onCreated](Scene& scene) {
+			GameObject::Sptr object = scene.CreateGameObject(name);
+			if (onCreated) {
+				onCreated(object);
+			}
+		});
+	}
+
+	void SceneCommandBuffer::RemoveGameObject(const GameObject::Sptr& object) {
+		std::weak_ptr<GameObject> weakObject = object;
+		Push([weakObject](Scene& scene) {
+			GameObject::Sptr object = weakObject.lock();
+			if (object != nullptr) {
+				scene.RemoveGameObject(object);
+			}
+		});
+	}
+
+	void SceneCommandBuffer::SetParent(const GameObject::Sptr& child, const GameObject::Sptr& parent) {
+		std::weak_ptr<GameObject> weakChild = child;
+		std::weak_ptr<GameObject> weakParent = parent;
+		bool hasParent = parent != nullptr;
+		Push([weakChild, weakParent, hasParent](Scene& scene) {
+			GameObject::Sptr child = weakChild.lock();
+			if (child == nullptr) {
+				return;
+			}
+			if (hasParent) {
+				GameObject::Sptr parent = weakParent.lock();
+				if (parent != nullptr) {
+					parent->AddChild(child);
+				}
+			} else if (child->GetParent() != nullptr) {
+				child->GetParent()->RemoveChild(child);
+			}
+		});
+	}
+
+	void SceneCommandBuffer::Flush(Scene& scene) {
+		while (true) {
+			{
+				std::lock_guard<std::mutex> lock(_mutex);
+				if (_commands.empty()) {
+					return;
+				}
+				_executing.swap(_commands);
+			}
+			for (Command& command : _executing) {
+				command(scene);
+			}
+			_executing.clear();
+		}
+	}
+
+	void SceneCommandBuffer::Clear() {
+		std::lock_guard<std::mutex> lock(_mutex);
+		_commands.clear();
+	}
+}
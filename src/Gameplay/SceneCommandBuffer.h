@@ -0,0 +1,67 @@
+#pragma once
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "Utils/Macros.h"
+#include "Gameplay/GameObject.h"
+
+namespace Gameplay {
+	class Scene;
+
+	/// <summary>
+	/// Records structural changes to a scene (creating, removing, and re-parenting objects) so that
+	/// components being updated off the main thread can request them safely. Commands can be recorded
+	/// from any thread, and are applied in the order they were recorded when the scene reaches its sync
+	/// point at the end of Scene::Update
+	/// </summary>
+	class SceneCommandBuffer {
+	public:
+		NO_COPY(SceneCommandBuffer);
+		NO_MOVE(SceneCommandBuffer);
+
+		typedef std::function<void(Scene&)> Command;
+
+		SceneCommandBuffer();
+		~SceneCommandBuffer() = default;
+
+		/// <summary>
+		/// Records an arbitrary command to run against the scene on the main thread
+		/// </summary>
+		void Push(Command command);
+
+		/// <summary>
+		/// Records the creation of a new game object
+		/// </summary>
+		/// <param name="name">The name of the object to create</param>
+		/// <param name="onCreated">An optional callback to set up the object once it has been created</param>
+		void CreateGameObject(const std::string& name, std::function<void(const GameObject::Sptr&)> onCreated = nullptr);
+		/// <summary>
+		/// Records the removal of a game object and its children
+		/// </summary>
+		void RemoveGameObject(const GameObject::Sptr& object);
+		/// <summary>
+		/// Records a change to an object's parent
+		/// </summary>
+		/// <param name="child">The object to re-parent</param>
+		/// <param name="parent">The new parent for the object, or nullptr to un-parent it</param>
+		void SetParent(const GameObject::Sptr& child, const GameObject::Sptr& parent);
+
+		/// <summary>
+		/// Applies all recorded commands to the scene, should only be called on the main thread.
+		/// Commands that are recorded while flushing are also applied
+		/// </summary>
+		void Flush(Scene& scene);
+		/// <summary>
+		/// Discards all recorded commands without applying them
+		/// </summary>
+		void Clear();
+
+	protected:
+		std::mutex           _mutex;
+		std::vector<Command> _commands;
+		// Swapped with _commands when flushing, so commands can be recorded while we run them
+		std::vector<Command> _executing;
+	};
+}
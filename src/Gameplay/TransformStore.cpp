@@ -0,0 +1,376 @@
+#include "Gameplay/TransformStore.h"
+
+#include <Logging.h>
+#include "Utils/JobSystem.h"
+
+// Use SSE for matrix composition when the target supports it (always true for x64)
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define TRANSFORM_STORE_USE_SSE
+#include <xmmintrin.h>
+#endif
+
+namespace Gameplay {
+	// The number of transforms in each job when updating a level of the hierarchy
+	static constexpr size_t UPDATE_BATCH_SIZE = 1024;
+
+	TransformStore::TransformStore() :
+		_positions(),
+		_rotations(),
+		_scales(),
+		_parents(),
+		_localTransforms(),
+		_worldTransforms(),
+		_inverseWorldTransforms(),
+		_worldVersions(),
+		_parentVersions(),
+		_isLocalDirty(),
+		_denseToHandle(),
+		_handleToDense(),
+		_handleParents(),
+		_freeHandles(),
+		_releasedHandles(),
+		_levelStarts(),
+		_isOrderDirty(false)
+	{ }
+
+	uint32_t TransformStore::Create() {
+		uint32_t handle;
+		if (!_freeHandles.empty()) {
+			handle = _freeHandles.back();
+			_freeHandles.pop_back();
+		} else {
+			handle = static_cast<uint32_t>(_handleToDense.size());
+			_handleToDense.push_back(INVALID_HANDLE);
+			_handleParents.push_back(INVALID_HANDLE);
+		}
+
+		// New transforms have no parent, so it's always safe to add them to the end
+		uint32_t dense = static_cast<uint32_t>(_positions.size());
+		_positions.push_back(glm::vec3(0.0f));
+		_rotations.push_back(glm::quat(1.0f, 0.0f, 0.0f, 0.0f));
+		_scales.push_back(glm::vec3(1.0f));
+		_parents.push_back(INVALID_HANDLE);
+		_localTransforms.push_back(glm::mat4(1.0f));
+		_worldTransforms.push_back(glm::mat4(1.0f));
+		_inverseWorldTransforms.push_back(glm::mat4(1.0f));
+		_worldVersions.push_back(0);
+		_parentVersions.push_back(0);
+		_isLocalDirty.push_back(1);
+		_denseToHandle.push_back(handle);
+
+		_handleToDense[handle] = dense;
+		_handleParents[handle] = INVALID_HANDLE;
+		_isOrderDirty = true;
+		return handle;
+	}
+
+	void TransformStore::Release(uint32_t handle) {
+		// We leave the data in place until the next sort, so that any children can still read it until then
+		uint32_t dense = _handleToDense[handle];
+		_denseToHandle[dense] = INVALID_HANDLE;
+		_handleToDense[handle] = INVALID_HANDLE;
+		_handleParents[handle] = INVALID_HANDLE;
+		_releasedHandles.push_back(handle);
+		_isOrderDirty = true;
+	}
+
+	void TransformStore::SetParent(uint32_t handle, uint32_t parent) {
+		if (_handleParents[handle] == parent) {
+			return;
+		}
+		_handleParents[handle] = parent;
+
+		// Marking the local transform as dirty forces the world transform to be rebuilt against the new parent
+		uint32_t dense = _handleToDense[handle];
+		_parents[dense] = parent == INVALID_HANDLE ? INVALID_HANDLE : _handleToDense[parent];
+		_isLocalDirty[dense] = 1;
+		_isOrderDirty = true;
+	}
+
+	void TransformStore::SetPosition(uint32_t handle, const glm::vec3& value) {
+		uint32_t dense = _handleToDense[handle];
+		_positions[dense] = value;
+		_isLocalDirty[dense] = 1;
+	}
+
+	void TransformStore::SetRotation(uint32_t handle, const glm::quat& value) {
+		uint32_t dense = _handleToDense[handle];
+		_rotations[dense] = value;
+		_isLocalDirty[dense] = 1;
+	}
+
+	void TransformStore::SetScale(uint32_t handle, const glm::vec3& value) {
+		uint32_t dense = _handleToDense[handle];
+		_scales[dense] = value;
+		_isLocalDirty[dense] = 1;
+	}
+
+	const glm::mat4& TransformStore::GetLocalTransform(uint32_t handle) {
+		uint32_t dense = _handleToDense[handle];
+		_ResolveNode(dense);
+		return _localTransforms[dense];
+	}
+
+	glm::mat4 TransformStore::GetInverseLocalTransform(uint32_t handle) const {
+		uint32_t dense = _handleToDense[handle];
+		return InverseTrs(_positions[dense], _rotations[dense], _scales[dense]);
+	}
+
+	const glm::mat4& TransformStore::GetWorldTransform(uint32_t handle) {
+		uint32_t dense = _handleToDense[handle];
+		_ResolveNode(dense);
+		return _worldTransforms[dense];
+	}
+
+	uint32_t TransformStore::GetWorldVersion(uint32_t handle) {
+		uint32_t dense = _handleToDense[handle];
+		_ResolveNode(dense);
+		return _worldVersions[dense];
+	}
+
+	const glm::mat4& TransformStore::GetInverseWorldTransform(uint32_t handle) {
+		uint32_t dense = _handleToDense[handle];
+		_ResolveNode(dense);
+		return _inverseWorldTransforms[dense];
+	}
+
+	void TransformStore::Update() {
+		if (_isOrderDirty) {
+			_SortByDepth();
+		}
+
+		// Every transform in a level only depends on the level above it, so each level can be done in parallel
+		for (size_t level = 0; level + 1 < _levelStarts.size(); level++) {
+			uint32_t begin = _levelStarts[level];
+			uint32_t end = _levelStarts[level + 1];
+			JobSystem::ParallelFor(end - begin, UPDATE_BATCH_SIZE, [&](size_t first, size_t last) {
+				for (size_t ix = first; ix < last; ix++) {
+					_UpdateNode(static_cast<uint32_t>(begin + ix));
+				}
+			});
+		}
+	}
+
+	void TransformStore::_UpdateNode(uint32_t index) {
+		// Released transforms stay in place until the next sort, but their children should stop following them right away
+		uint32_t parent = _parents[index];
+		if (parent != INVALID_HANDLE && _denseToHandle[parent] == INVALID_HANDLE) {
+			parent = INVALID_HANDLE;
+			_parents[index] = INVALID_HANDLE;
+			_isLocalDirty[index] = 1;
+		}
+
+		bool isLocalDirty = _isLocalDirty[index] != 0;
+		if (isLocalDirty) {
+			_localTransforms[index] = ComposeTrs(_positions[index], _rotations[index], _scales[index]);
+			_isLocalDirty[index] = 0;
+		}
+
+		if (parent == INVALID_HANDLE) {
+			if (isLocalDirty) {
+				_worldTransforms[index] = _localTransforms[index];
+				_inverseWorldTransforms[index] = InverseTrs(_positions[index], _rotations[index], _scales[index]);
+				_worldVersions[index]++;
+			}
+		}
+		// We only need to rebuild if we moved, or our parent's world transform has changed since we last looked
+		else if (isLocalDirty || _parentVersions[index] != _worldVersions[parent]) {
+			MultiplyAffine(_worldTransforms[parent], _localTransforms[index], _worldTransforms[index]);
+			_inverseWorldTransforms[index] = AffineInverse(_worldTransforms[index]);
+			_parentVersions[index] = _worldVersions[parent];
+			_worldVersions[index]++;
+		}
+	}
+
+	void TransformStore::_ResolveNode(uint32_t index) {
+		// Hierarchies are shallow, so recursing up to the root is fine
+		uint32_t parent = _parents[index];
+		if (parent != INVALID_HANDLE) {
+			_ResolveNode(parent);
+		}
+		// Jobs may read transforms in parallel, so they can only read transforms that are already up to date
+		LOG_ASSERT(!JobSystem::IsInJob() || !_IsNodeDirty(index), "Transform {} was read from a job before it was updated, see ComponentUpdateMode", _denseToHandle[index]);
+		_UpdateNode(index);
+	}
+
+	bool TransformStore::_IsNodeDirty(uint32_t index) const {
+		uint32_t parent = _parents[index];
+		if (_isLocalDirty[index] != 0) {
+			return true;
+		}
+		return parent != INVALID_HANDLE && (_denseToHandle[parent] == INVALID_HANDLE || _parentVersions[index] != _worldVersions[parent]);
+	}
+
+	void TransformStore::_SortByDepth() {
+		const uint32_t count = static_cast<uint32_t>(_denseToHandle.size());
+
+		// Find the depth of every live transform, by walking up to the nearest ancestor with a known depth
+		std::vector<uint32_t> depths(count, INVALID_HANDLE);
+		std::vector<uint32_t> stack;
+		uint32_t liveCount = 0;
+		uint32_t maxDepth = 0;
+		for (uint32_t ix = 0; ix < count; ix++) {
+			if (_denseToHandle[ix] == INVALID_HANDLE || depths[ix] != INVALID_HANDLE) {
+				continue;
+			}
+
+			// Roots start from INVALID_HANDLE so that they wrap around to a depth of 0
+			uint32_t depth = INVALID_HANDLE;
+			uint32_t node = ix;
+			while (true) {
+				stack.push_back(node);
+				uint32_t handle = _denseToHandle[node];
+				uint32_t parentHandle = _handleParents[handle];
+				uint32_t parent = parentHandle == INVALID_HANDLE ? INVALID_HANDLE : _handleToDense[parentHandle];
+
+				// Transforms whose parent has been released become roots
+				if (parent == INVALID_HANDLE) {
+					if (parentHandle != INVALID_HANDLE) {
+						_handleParents[handle] = INVALID_HANDLE;
+						_isLocalDirty[node] = 1;
+					}
+					break;
+				}
+				if (depths[parent] != INVALID_HANDLE) {
+					depth = depths[parent];
+					break;
+				}
+				if (stack.size() > count) {
+					LOG_ERROR("Cycle detected in transform hierarchy, breaking it at transform {}", handle);
+					_handleParents[handle] = INVALID_HANDLE;
+					_isLocalDirty[node] = 1;
+					break;
+				}
+				node = parent;
+			}
+
+			// Unwind from the top of the chain back down to where we started
+			for (size_t s = stack.size(); s-- > 0;) {
+				depths[stack[s]] = ++depth;
+				maxDepth = glm::max(maxDepth, depth);
+				liveCount++;
+			}
+			stack.clear();
+		}
+
+		// Counting sort by depth, this is stable so siblings keep their relative order
+		_levelStarts.assign(liveCount > 0 ? maxDepth + 2 : 1, 0);
+		for (uint32_t ix = 0; ix < count; ix++) {
+			if (depths[ix] != INVALID_HANDLE) {
+				_levelStarts[depths[ix] + 1]++;
+			}
+		}
+		for (size_t level = 1; level < _levelStarts.size(); level++) {
+			_levelStarts[level] += _levelStarts[level - 1];
+		}
+		std::vector<uint32_t> cursors(_levelStarts.begin(), _levelStarts.end());
+		std::vector<uint32_t> order(liveCount);
+		for (uint32_t ix = 0; ix < count; ix++) {
+			if (depths[ix] != INVALID_HANDLE) {
+				order[cursors[depths[ix]]++] = ix;
+			}
+		}
+
+		// Move all of our arrays into the new order, dropping released transforms
+		auto permute = [&](auto& values) {
+			typename std::remove_reference<decltype(values)>::type sorted(liveCount);
+			for (uint32_t ix = 0; ix < liveCount; ix++) {
+				sorted[ix] = values[order[ix]];
+			}
+			values.swap(sorted);
+		};
+		permute(_positions);
+		permute(_rotations);
+		permute(_scales);
+		permute(_localTransforms);
+		permute(_worldTransforms);
+		permute(_inverseWorldTransforms);
+		permute(_worldVersions);
+		permute(_parentVersions);
+		permute(_isLocalDirty);
+		permute(_denseToHandle);
+
+		// Rebuild the mappings now that everything has moved
+		for (uint32_t ix = 0; ix < liveCount; ix++) {
+			_handleToDense[_denseToHandle[ix]] = ix;
+		}
+		_parents.resize(liveCount);
+		for (uint32_t ix = 0; ix < liveCount; ix++) {
+			uint32_t parentHandle = _handleParents[_denseToHandle[ix]];
+			_parents[ix] = parentHandle == INVALID_HANDLE ? INVALID_HANDLE : _handleToDense[parentHandle];
+		}
+
+		// Nothing refers to the released handles anymore, so they can be handed out again
+		_freeHandles.insert(_freeHandles.end(), _releasedHandles.begin(), _releasedHandles.end());
+		_releasedHandles.clear();
+		_isOrderDirty = false;
+	}
+
+	glm::mat4 TransformStore::ComposeTrs(const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale) {
+		// Equivalent to translate * mat4_cast(rotation) * scale, the scale just multiplies the rotation's columns
+		glm::mat3 rot = glm::mat3_cast(rotation);
+		glm::mat4 result;
+		result[0] = glm::vec4(rot[0] * scale.x, 0.0f);
+		result[1] = glm::vec4(rot[1] * scale.y, 0.0f);
+		result[2] = glm::vec4(rot[2] * scale.z, 0.0f);
+		result[3] = glm::vec4(position, 1.0f);
+		return result;
+	}
+
+	glm::mat4 TransformStore::InverseTrs(const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale) {
+		// (T * R * S)^-1 = S^-1 * R^T * T^-1, so the rotation part is the transposed rotation with its rows divided by the scale
+		glm::mat3 inv = glm::transpose(glm::mat3_cast(rotation));
+		glm::vec3 invScale = 1.0f / scale;
+		inv[0] *= invScale;
+		inv[1] *= invScale;
+		inv[2] *= invScale;
+
+		glm::mat4 result;
+		result[0] = glm::vec4(inv[0], 0.0f);
+		result[1] = glm::vec4(inv[1], 0.0f);
+		result[2] = glm::vec4(inv[2], 0.0f);
+		result[3] = glm::vec4(-(inv * position), 1.0f);
+		return result;
+	}
+
+	glm::mat4 TransformStore::AffineInverse(const glm::mat4& value) {
+		// The rows of the inverse of a 3x3 matrix are the cross products of its columns, divided by the determinant
+		glm::vec3 c0 = glm::vec3(value[0]);
+		glm::vec3 c1 = glm::vec3(value[1]);
+		glm::vec3 c2 = glm::vec3(value[2]);
+		glm::vec3 r0 = glm::cross(c1, c2);
+		glm::vec3 r1 = glm::cross(c2, c0);
+		glm::vec3 r2 = glm::cross(c0, c1);
+		float det = glm::dot(c0, r0);
+		float invDet = det != 0.0f ? 1.0f / det : 0.0f;
+		glm::mat3 inv = glm::transpose(glm::mat3(r0 * invDet, r1 * invDet, r2 * invDet));
+
+		glm::mat4 result;
+		result[0] = glm::vec4(inv[0], 0.0f);
+		result[1] = glm::vec4(inv[1], 0.0f);
+		result[2] = glm::vec4(inv[2], 0.0f);
+		result[3] = glm::vec4(-(inv * glm::vec3(value[3])), 1.0f);
+		return result;
+	}
+
+	void TransformStore::MultiplyAffine(const glm::mat4& left, const glm::mat4& right, glm::mat4& result) {
+	#ifdef TRANSFORM_STORE_USE_SSE
+		__m128 l0 = _mm_loadu_ps(&left[0][0]);
+		__m128 l1 = _mm_loadu_ps(&left[1][0]);
+		__m128 l2 = _mm_loadu_ps(&left[2][0]);
+		__m128 l3 = _mm_loadu_ps(&left[3][0]);
+		for (int col = 0; col < 4; col++) {
+			__m128 sum = _mm_mul_ps(l0, _mm_set1_ps(right[col][0]));
+			sum = _mm_add_ps(sum, _mm_mul_ps(l1, _mm_set1_ps(right[col][1])));
+			sum = _mm_add_ps(sum, _mm_mul_ps(l2, _mm_set1_ps(right[col][2])));
+			// The bottom row of the right matrix is (0, 0, 0, 1), so only the translation column picks up l3
+			if (col == 3) {
+				sum = _mm_add_ps(sum, l3);
+			}
+			_mm_storeu_ps(&result[col][0], sum);
+		}
+	#else
+		result = left * right;
+	#endif
+	}
+}
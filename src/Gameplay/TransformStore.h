@@ -0,0 +1,151 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <GLM/glm.hpp>
+#include <GLM/gtc/quaternion.hpp>
+
+#include "Utils/Macros.h"
+
+namespace Gameplay {
+	/// <summary>
+	/// Stores the transforms for all the objects in a scene in structure of arrays form, sorted by their
+	/// depth in the hierarchy so that parents always come before their children. Update recalculates
+	/// the world matrices of every dirty subtree in a single pass, one hierarchy level at a time, and
+	/// individual transforms can also be brought up to date on demand when they are read
+	///
+	/// Transforms are referred to by handles, which stay the same as the store is re-sorted. References
+	/// returned by the getters are only valid until the next transform is created or Update is called
+	///
+	/// Reading a world transform that is out of date recalculates it in place, so from jobs only transforms
+	/// that have been brought up to date by Update (and not changed since) may be read
+	/// </summary>
+	class TransformStore {
+	public:
+		NO_COPY(TransformStore);
+		NO_MOVE(TransformStore);
+
+		/// <summary>
+		/// Value used to represent an invalid handle, or a transform with no parent
+		/// </summary>
+		static constexpr uint32_t INVALID_HANDLE = ~0u;
+
+		TransformStore();
+		~TransformStore() = default;
+
+		/// <summary>
+		/// Creates a new identity transform with no parent
+		/// </summary>
+		/// <returns>The handle for the new transform</returns>
+		uint32_t Create();
+		/// <summary>
+		/// Releases a transform, any children it had will become roots
+		/// </summary>
+		void Release(uint32_t handle);
+
+		/// <summary>
+		/// Sets the parent of a transform
+		/// </summary>
+		/// <param name="handle">The transform to re-parent</param>
+		/// <param name="parent">The new parent, or INVALID_HANDLE to make the transform a root</param>
+		void SetParent(uint32_t handle, uint32_t parent);
+		/// <summary>
+		/// Gets the parent of a transform, or INVALID_HANDLE if it is a root
+		/// </summary>
+		uint32_t GetParent(uint32_t handle) const { return _handleParents[handle]; }
+
+		void SetPosition(uint32_t handle, const glm::vec3& value);
+		void SetRotation(uint32_t handle, const glm::quat& value);
+		void SetScale(uint32_t handle, const glm::vec3& value);
+		const glm::vec3& GetPosition(uint32_t handle) const { return _positions[_handleToDense[handle]]; }
+		const glm::quat& GetRotation(uint32_t handle) const { return _rotations[_handleToDense[handle]]; }
+		const glm::vec3& GetScale(uint32_t handle) const { return _scales[_handleToDense[handle]]; }
+
+		/// <summary>
+		/// Gets the transform from the object's local space to its parent's space, recalculating it if required
+		/// </summary>
+		const glm::mat4& GetLocalTransform(uint32_t handle);
+		/// <summary>
+		/// Gets the inverse of the local transform, this is calculated directly from the position, rotation and scale
+		/// </summary>
+		glm::mat4 GetInverseLocalTransform(uint32_t handle) const;
+		/// <summary>
+		/// Gets the transform from the object's local space to world space, recalculating it and any dirty parents if required
+		/// </summary>
+		const glm::mat4& GetWorldTransform(uint32_t handle);
+		/// <summary>
+		/// Gets the transform from world space to the object's local space, recalculating it and any dirty parents if required
+		/// </summary>
+		const glm::mat4& GetInverseWorldTransform(uint32_t handle);
+		/// <summary>
+		/// Gets a value that changes whenever the transform's world matrix changes, recalculating it if required.
+		/// Useful for caching anything that depends on where an object is
+		/// </summary>
+		uint32_t GetWorldVersion(uint32_t handle);
+
+		/// <summary>
+		/// Re-sorts the store if the hierarchy has changed, and recalculates the world transforms of all
+		/// dirty subtrees. Should be called once per frame on the main thread
+		/// </summary>
+		void Update();
+
+		/// <summary>
+		/// Gets the number of transforms in the store, including released transforms that have not been compacted yet
+		/// </summary>
+		size_t Size() const { return _positions.size(); }
+
+		/// <summary>
+		/// Composes a translation, rotation and scale into a matrix, without any matrix multiplies
+		/// </summary>
+		static glm::mat4 ComposeTrs(const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale);
+		/// <summary>
+		/// Inverts a matrix that was built from a translation, rotation and scale
+		/// </summary>
+		static glm::mat4 InverseTrs(const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale);
+		/// <summary>
+		/// Inverts a matrix whose bottom row is (0, 0, 0, 1), such as any product of TRS matrices
+		/// </summary>
+		static glm::mat4 AffineInverse(const glm::mat4& value);
+		/// <summary>
+		/// Multiplies two matrices whose bottom rows are (0, 0, 0, 1), using SSE where available
+		/// </summary>
+		static void MultiplyAffine(const glm::mat4& left, const glm::mat4& right, glm::mat4& result);
+
+	protected:
+		// Per transform data, indexed by dense index and sorted so that parents come before children
+		std::vector<glm::vec3> _positions;
+		std::vector<glm::quat> _rotations;
+		std::vector<glm::vec3> _scales;
+		// The dense index of each transform's parent, or INVALID_HANDLE for roots
+		std::vector<uint32_t>  _parents;
+		std::vector<glm::mat4> _localTransforms;
+		std::vector<glm::mat4> _worldTransforms;
+		std::vector<glm::mat4> _inverseWorldTransforms;
+		// Bumped whenever a world transform changes, children compare this to the version they were
+		// last built against, so we never need to walk down the hierarchy to mark children dirty
+		std::vector<uint32_t>  _worldVersions;
+		std::vector<uint32_t>  _parentVersions;
+		std::vector<uint8_t>   _isLocalDirty;
+		std::vector<uint32_t>  _denseToHandle;
+
+		// Per handle data. The parent handles are the source of truth for the hierarchy, the dense
+		// parent indices are rebuilt from them when the store is sorted
+		std::vector<uint32_t>  _handleToDense;
+		std::vector<uint32_t>  _handleParents;
+		std::vector<uint32_t>  _freeHandles;
+		// Released handles can't be re-used until the store has been compacted
+		std::vector<uint32_t>  _releasedHandles;
+
+		// The dense index where each level of the hierarchy starts, with one extra entry for the end
+		std::vector<uint32_t>  _levelStarts;
+		// Set when transforms are added, removed, or re-parented, so the levels need to be rebuilt
+		bool                   _isOrderDirty;
+
+		void _UpdateNode(uint32_t index);
+		// Updates a transform and its parents, this writes to the store so it must not be used from jobs
+		// unless everything it touches is already up to date
+		void _ResolveNode(uint32_t index);
+		bool _IsNodeDirty(uint32_t index) const;
+		void _SortByDepth();
+	};
+}
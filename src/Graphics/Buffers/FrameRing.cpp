@@ -0,0 +1,70 @@
+#include "Graphics/Buffers/FrameRing.h"
+#include "Logging.h"
+
+FrameRing::FrameRing(IFenceBackend* backend, uint32_t segmentSize, uint32_t segmentCount, uint32_t alignment) :
+	_backend(backend),
+	_segmentSize(0),
+	_segmentCount(segmentCount),
+	_alignment(alignment == 0 ? 1 : alignment),
+	_segment(0),
+	_cursor(0),
+	_overflowed(false),
+	_fences(segmentCount, nullptr)
+{
+	LOG_ASSERT(_backend != nullptr, "A fence backend is required!");
+	LOG_ASSERT(_segmentCount > 0, "A frame ring needs at least one segment!");
+
+	// Each segment must start on an aligned offset, so round the segment size up
+	_segmentSize = ((segmentSize + _alignment - 1) / _alignment) * _alignment;
+}
+
+FrameRing::~FrameRing() {
+	for (void*& fence : _fences) {
+		if (fence != nullptr) {
+			_backend->DeleteFence(fence);
+			fence = nullptr;
+		}
+	}
+}
+
+void FrameRing::BeginFrame() {
+	_segment = (_segment + 1) % _segmentCount;
+	_WaitAndRelease(_segment);
+	_cursor = 0;
+	_overflowed = false;
+}
+
+void FrameRing::EndFrame() {
+	// A segment should only ever have one fence, but clean up if EndFrame was called twice
+	if (_fences[_segment] != nullptr) {
+		_backend->DeleteFence(_fences[_segment]);
+	}
+	_fences[_segment] = _backend->InsertFence();
+}
+
+void FrameRing::WaitForAll() {
+	for (uint32_t ix = 0; ix < _segmentCount; ix++) {
+		_WaitAndRelease(ix);
+	}
+}
+
+uint32_t FrameRing::Allocate(uint32_t size) {
+	uint32_t offset = ((_cursor + _alignment - 1) / _alignment) * _alignment;
+	if (size > _segmentSize || offset > _segmentSize - size) {
+		_overflowed = true;
+		return INVALID_OFFSET;
+	}
+	_cursor = offset + size;
+	return _segment * _segmentSize + offset;
+}
+
+void FrameRing::_WaitAndRelease(uint32_t segment) {
+	void*& fence = _fences[segment];
+	if (fence != nullptr) {
+		if (!_backend->WaitFence(fence)) {
+			LOG_WARN("Failed waiting for the GPU to release segment {} of a frame ring", segment);
+		}
+		_backend->DeleteFence(fence);
+		fence = nullptr;
+	}
+}
@@ -0,0 +1,109 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "Utils/Macros.h"
+
+/// <summary>
+/// Handles the bookkeeping for a GPU buffer that is written by the CPU while the GPU may still be reading
+/// earlier frames from it. The buffer is split into one segment per frame in flight, allocations for a
+/// frame are carved out of that frame's segment, and a fence is placed at the end of each frame so that
+/// we never write to a segment before the GPU is done with it
+///
+/// This class never touches OpenGL directly, fences go through an IFenceBackend so that the offset and
+/// fence logic can be exercised without a GL context
+/// </summary>
+class FrameRing {
+public:
+	NO_COPY(FrameRing);
+	NO_MOVE(FrameRing);
+
+	/// <summary>
+	/// Offset returned when an allocation does not fit in the current segment
+	/// </summary>
+	static constexpr uint32_t INVALID_OFFSET = ~0u;
+
+	/// <summary>
+	/// Creates and waits on the fences that guard each segment
+	/// </summary>
+	class IFenceBackend {
+	public:
+		virtual ~IFenceBackend() = default;
+		/// <summary>
+		/// Inserts a fence that will be signalled once all previously submitted GPU commands have completed
+		/// </summary>
+		/// <returns>An opaque handle to the fence</returns>
+		virtual void* InsertFence() = 0;
+		/// <summary>
+		/// Blocks until a fence has been signalled
+		/// </summary>
+		/// <returns>True if the fence was signalled, false if the wait failed or timed out</returns>
+		virtual bool WaitFence(void* fence) = 0;
+		/// <summary>
+		/// Releases a fence handle returned by InsertFence
+		/// </summary>
+		virtual void DeleteFence(void* fence) = 0;
+	};
+
+	/// <summary>
+	/// Creates a new ring
+	/// </summary>
+	/// <param name="backend">The backend for fence operations, must outlive the ring</param>
+	/// <param name="segmentSize">The number of bytes available to each frame, rounded up to the alignment</param>
+	/// <param name="segmentCount">The number of frames that may be in flight at once</param>
+	/// <param name="alignment">The alignment of every allocation, in bytes</param>
+	FrameRing(IFenceBackend* backend, uint32_t segmentSize, uint32_t segmentCount = 3, uint32_t alignment = 1);
+	~FrameRing();
+
+	/// <summary>
+	/// Moves to the next segment, waiting for the GPU to finish with it if needed
+	/// </summary>
+	void BeginFrame();
+	/// <summary>
+	/// Places a fence after all the commands that used the current segment
+	/// </summary>
+	void EndFrame();
+	/// <summary>
+	/// Waits for the GPU to finish with every segment, ex before the buffer is destroyed or resized
+	/// </summary>
+	void WaitForAll();
+
+	/// <summary>
+	/// Allocates a block of memory from the current frame's segment
+	/// </summary>
+	/// <param name="size">The size of the block, in bytes</param>
+	/// <returns>The offset of the block from the start of the buffer, or INVALID_OFFSET if the segment is full</returns>
+	uint32_t Allocate(uint32_t size);
+
+	/// <summary>
+	/// Gets the size of the entire buffer that the ring is managing, in bytes
+	/// </summary>
+	uint32_t GetTotalSize() const { return _segmentSize * _segmentCount; }
+	uint32_t GetSegmentSize() const { return _segmentSize; }
+	uint32_t GetSegmentCount() const { return _segmentCount; }
+	uint32_t GetAlignment() const { return _alignment; }
+	/// <summary>
+	/// Gets the index of the segment that allocations are currently coming from
+	/// </summary>
+	uint32_t GetCurrentSegment() const { return _segment; }
+	/// <summary>
+	/// Gets the number of bytes that have been allocated from the current segment
+	/// </summary>
+	uint32_t GetUsed() const { return _cursor; }
+	/// <summary>
+	/// Returns true if an allocation has failed since the start of the frame
+	/// </summary>
+	bool HasOverflowed() const { return _overflowed; }
+
+protected:
+	IFenceBackend*     _backend;
+	uint32_t           _segmentSize;
+	uint32_t           _segmentCount;
+	uint32_t           _alignment;
+	uint32_t           _segment;
+	uint32_t           _cursor;
+	bool               _overflowed;
+	std::vector<void*> _fences;
+
+	void _WaitAndRelease(uint32_t segment);
+};
@@ -0,0 +1,21 @@
+#include "Graphics/Buffers/GlFenceBackend.h"
+#include <glad/glad.h>
+
+GlFenceBackend* GlFenceBackend::Get() {
+	static GlFenceBackend instance;
+	return &instance;
+}
+
+void* GlFenceBackend::InsertFence() {
+	return glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+bool GlFenceBackend::WaitFence(void* fence) {
+	// Flush on the wait, otherwise the fence may never reach the GPU and we'd wait forever
+	GLenum result = glClientWaitSync(static_cast<GLsync>(fence), GL_SYNC_FLUSH_COMMANDS_BIT, WAIT_TIMEOUT);
+	return result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED;
+}
+
+void GlFenceBackend::DeleteFence(void* fence) {
+	glDeleteSync(static_cast<GLsync>(fence));
+}
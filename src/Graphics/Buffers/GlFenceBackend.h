@@ -0,0 +1,24 @@
+#pragma once
+#include "Graphics/Buffers/FrameRing.h"
+
+/// <summary>
+/// Implements frame ring fences with OpenGL sync objects
+/// </summary>
+class GlFenceBackend final : public FrameRing::IFenceBackend {
+public:
+	/// <summary>
+	/// Gets the shared instance of the backend, the backend has no state so one instance can serve every ring
+	/// </summary>
+	static GlFenceBackend* Get();
+
+	/// <summary>
+	/// How long we'll wait for a fence before giving up, in nanoseconds
+	/// </summary>
+	static constexpr uint64_t WAIT_TIMEOUT = 1000000000;
+
+	// Inherited from IFenceBackend
+
+	virtual void* InsertFence() override;
+	virtual bool WaitFence(void* fence) override;
+	virtual void DeleteFence(void* fence) override;
+};
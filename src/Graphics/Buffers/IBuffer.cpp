@@ -5,7 +5,8 @@ IBuffer::IBuffer(BufferType type, BufferUsage usage) :
 	IGraphicsResource(),
 	_elementCount(0),
 	_elementSize(0),
-	_size(0)
+	_size(0),
+	_immutable(false)
 {
 	_type = type;
 	_usage = usage;
@@ -24,6 +25,8 @@ IBuffer::~IBuffer() {
 }
 
 void IBuffer::LoadData(const void* data, uint32_t elementSize, uint32_t elementCount) {
+	LOG_ASSERT(!_immutable, "Cannot reallocate a buffer with immutable storage!");
+
 	// Note, this is part of the bindless state access stuff added in 4.5
 	glNamedBufferData(_rendererId, (GLsizeiptr)elementSize * elementCount, data, (GLenum)_usage);
 
@@ -35,7 +38,7 @@ void IBuffer::LoadData(const void* data, uint32_t elementSize, uint32_t elementC
 void IBuffer::UpdateData(const void* data, uint32_t elementSize, uint32_t elementCount, bool allowResize /*= true*/)
 {
 	if (elementSize * elementCount > _size) {
-		if (allowResize) {
+		if (allowResize && !_immutable) {
 			glNamedBufferData(_rendererId, (GLsizeiptr)elementSize * elementCount, data, (GLenum)_usage);
 
 			LOG_INFO("Expanding buffer from {} bytes to {} bytes", _size, elementCount * elementSize);
@@ -59,10 +62,30 @@ void IBuffer::UpdateData(const void* data, uint32_t elementSize, uint32_t elemen
 	}
 }
 
+void IBuffer::AllocateStorage(const void* data, uint32_t elementSize, uint32_t elementCount, BufferStorageFlags flags) {
+	LOG_ASSERT(!_immutable, "Buffer storage has already been allocated!");
+
+	glNamedBufferStorage(_rendererId, (GLsizeiptr)elementSize * elementCount, data, *flags);
+
+	_elementCount = elementCount;
+	_elementSize = elementSize;
+	_size = elementCount * elementSize;
+	_immutable = true;
+}
+
 void* IBuffer::Map(BufferMapMode mode) {
 	return glMapNamedBufferRange(_rendererId, 0, _size, *mode);
 }
 
+void* IBuffer::MapRange(uint32_t offset, uint32_t length, BufferMapMode mode) {
+	LOG_ASSERT(offset + length <= _size, "Attempting to map beyond the end of the buffer!");
+	return glMapNamedBufferRange(_rendererId, offset, length, *mode);
+}
+
+void IBuffer::FlushRange(uint32_t offset, uint32_t length) {
+	glFlushMappedNamedBufferRange(_rendererId, offset, length);
+}
+
 void IBuffer::Unmap() {
 	glUnmapNamedBuffer(_rendererId);
 }
@@ -22,6 +22,20 @@ ENUM_FLAGS(BufferMapMode, uint32_t,
 	Unsynchronized   = GL_MAP_UNSYNCHRONIZED_BIT
 );
 
+/// <summary>
+/// Flags for allocating immutable buffer storage
+/// </summary>
+/// <see>https://www.khronos.org/registry/OpenGL-Refpages/gl4/html/glBufferStorage.xhtml</see>
+ENUM_FLAGS(BufferStorageFlags, uint32_t,
+	None           = 0,
+	DynamicStorage = GL_DYNAMIC_STORAGE_BIT,
+	MapRead        = GL_MAP_READ_BIT,
+	MapWrite       = GL_MAP_WRITE_BIT,
+	MapPersistent  = GL_MAP_PERSISTENT_BIT,
+	MapCoherent    = GL_MAP_COHERENT_BIT,
+	ClientStorage  = GL_CLIENT_STORAGE_BIT
+);
+
 /// <summary>
 /// This is our abstract base class for all our OpenGL buffer types
 /// </summary>
@@ -63,6 +77,20 @@ public:
 		IBuffer::LoadData((const void*)(data), sizeof(T), count);
 	}
 
+	/// <summary>
+	/// Allocates immutable storage for this buffer using glNamedBufferStorage. Once allocated, the buffer
+	/// cannot be resized with LoadData or UpdateData, but it can be persistently mapped
+	/// </summary>
+	/// <param name="data">The initial data for the buffer, or nullptr to leave it uninitialized</param>
+	/// <param name="elementSize">The size of a single element, in bytes</param>
+	/// <param name="elementCount">The number of elements to allocate</param>
+	/// <param name="flags">The storage flags, these must include the map flags for any mapping that will be done later</param>
+	void AllocateStorage(const void* data, uint32_t elementSize, uint32_t elementCount, BufferStorageFlags flags);
+	/// <summary>
+	/// Returns true if this buffer's storage was allocated with AllocateStorage
+	/// </summary>
+	bool IsImmutable() const { return _immutable; }
+
 	/// <summary>
 	/// Returns the number of elements that are loaded into this buffer
 	/// </summary>
@@ -93,6 +121,20 @@ public:
 	/// <returns>A pointer to the data in the buffer, or nullptr if an error occurs</returns>
 	void* Map(BufferMapMode mode);
 	/// <summary>
+	/// Maps a range of the buffer's data to a pointer that the CPU can access
+	/// </summary>
+	/// <param name="offset">The offset into the buffer to start mapping at, in bytes</param>
+	/// <param name="length">The number of bytes to map</param>
+	/// <param name="mode">The mode, as a series of bit flags</param>
+	/// <returns>A pointer to the start of the range, or nullptr if an error occurs</returns>
+	void* MapRange(uint32_t offset, uint32_t length, BufferMapMode mode);
+	/// <summary>
+	/// Makes writes to a range of a buffer that was mapped with BufferMapMode::FlushExplicit visible to the GPU
+	/// </summary>
+	/// <param name="offset">The offset from the start of the mapped range, in bytes</param>
+	/// <param name="length">The number of bytes to flush</param>
+	void FlushRange(uint32_t offset, uint32_t length);
+	/// <summary>
 	/// Unmaps the buffers, so that the GPU can take control of the memory
 	/// </summary>
 	void Unmap();
@@ -134,4 +176,5 @@ protected:
 	uint32_t _size; // The size of the buffer in bytes
 	BufferUsage _usage; // The buffer usage mode (GL_STATIC_DRAW, GL_DYNAMIC_DRAW)
 	BufferType _type; // The buffer type (ex GL_ARRAY_BUFFER, GL_ARRAY_ELEMENT_BUFFER)
+	bool _immutable; // True if the storage was allocated with glNamedBufferStorage
 };
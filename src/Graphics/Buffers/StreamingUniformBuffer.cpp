@@ -0,0 +1,52 @@
+#include "Graphics/Buffers/StreamingUniformBuffer.h"
+#include "Graphics/Buffers/GlFenceBackend.h"
+#include "Logging.h"
+
+#include <cstring>
+
+// Uniform buffer ranges must start on a multiple of GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT
+static uint32_t GetUniformOffsetAlignment() {
+	GLint alignment = 0;
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+	return alignment > 0 ? static_cast<uint32_t>(alignment) : 256;
+}
+
+StreamingUniformBuffer::StreamingUniformBuffer(uint32_t segmentSize, uint32_t framesInFlight) :
+	IBuffer(BufferType::Uniform, BufferUsage::StreamDraw),
+	_ring(GlFenceBackend::Get(), segmentSize, framesInFlight, GetUniformOffsetAlignment()),
+	_mapped(nullptr)
+{
+	// Persistent and coherent, so the GPU will see our writes without any flushes or re-mapping
+	AllocateStorage(nullptr, 1, _ring.GetTotalSize(),
+		BufferStorageFlags::MapWrite | BufferStorageFlags::MapPersistent | BufferStorageFlags::MapCoherent);
+	_mapped = reinterpret_cast<uint8_t*>(MapRange(0, _ring.GetTotalSize(),
+		BufferMapMode::Write | BufferMapMode::Persistent | BufferMapMode::Coherent));
+	LOG_ASSERT(_mapped != nullptr, "Failed to map streaming uniform buffer!");
+}
+
+StreamingUniformBuffer::~StreamingUniformBuffer() {
+	// Make sure the GPU is done with the buffer before it goes away
+	_ring.WaitForAll();
+	if (_mapped != nullptr) {
+		Unmap();
+		_mapped = nullptr;
+	}
+}
+
+void StreamingUniformBuffer::BeginFrame() {
+	_ring.BeginFrame();
+}
+
+void StreamingUniformBuffer::EndFrame() {
+	_ring.EndFrame();
+}
+
+bool StreamingUniformBuffer::Push(const void* data, uint32_t size, uint32_t slot) {
+	uint32_t offset = _ring.Allocate(size);
+	if (offset == FrameRing::INVALID_OFFSET) {
+		return false;
+	}
+	memcpy(_mapped + offset, data, size);
+	glBindBufferRange(GL_UNIFORM_BUFFER, slot, _rendererId, offset, size);
+	return true;
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include "Graphics/Buffers/IBuffer.h"
+#include "Graphics/Buffers/FrameRing.h"
+#include <memory>
+
+/// <summary>
+/// A large, persistently mapped uniform buffer that small uniform blocks are streamed into. Each frame
+/// gets its own segment of the buffer (see FrameRing), and every block that is pushed gets its own
+/// aligned slot that is bound with glBindBufferRange, so updating per-draw uniforms never needs to
+/// synchronize with the driver like glNamedBufferSubData does
+/// </summary>
+class StreamingUniformBuffer final : public IBuffer {
+public:
+	typedef std::shared_ptr<StreamingUniformBuffer> Sptr;
+
+	/// <summary>
+	/// Creates a new streaming uniform buffer
+	/// </summary>
+	/// <param name="segmentSize">The number of bytes available each frame</param>
+	/// <param name="framesInFlight">The number of frames the GPU may be behind the CPU by</param>
+	static inline Sptr Create(uint32_t segmentSize, uint32_t framesInFlight = 3) {
+		return std::make_shared<StreamingUniformBuffer>(segmentSize, framesInFlight);
+	}
+
+	StreamingUniformBuffer(uint32_t segmentSize, uint32_t framesInFlight = 3);
+	virtual ~StreamingUniformBuffer();
+
+	/// <summary>
+	/// Starts writing to the next frame's segment, should be called once per frame before any pushes
+	/// </summary>
+	void BeginFrame();
+	/// <summary>
+	/// Marks the end of the commands that use this frame's segment
+	/// </summary>
+	void EndFrame();
+
+	/// <summary>
+	/// Copies a block of uniform data into the next free slot in this frame's segment, and binds that slot
+	/// </summary>
+	/// <param name="data">The uniform data to copy</param>
+	/// <param name="size">The size of the data, in bytes</param>
+	/// <param name="slot">The uniform buffer binding slot to bind the block to</param>
+	/// <returns>True if the block was pushed, false if this frame's segment is full</returns>
+	bool Push(const void* data, uint32_t size, uint32_t slot);
+
+	/// <summary>
+	/// Copies a uniform structure into the next free slot in this frame's segment, and binds that slot
+	/// </summary>
+	/// <typeparam name="Structure">The type of the C++ structure, should match the GLSL block's layout</typeparam>
+	/// <param name="data">The structure to copy</param>
+	/// <param name="slot">The uniform buffer binding slot to bind the block to</param>
+	/// <returns>True if the block was pushed, false if this frame's segment is full</returns>
+	template <typename Structure>
+	bool Push(const Structure& data, uint32_t slot) {
+		return Push(&data, sizeof(Structure), slot);
+	}
+
+	/// <summary>
+	/// Gets the ring that tracks the allocations and fences for this buffer
+	/// </summary>
+	const FrameRing& GetRing() const { return _ring; }
+
+protected:
+	FrameRing _ring;
+	uint8_t*  _mapped;
+};
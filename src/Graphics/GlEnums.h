@@ -9,6 +9,26 @@
 #include <Logging.h>
 #include <glm/glm.hpp>
 
+/*
+ * S3TC is an extension rather than core, so the loader may not define its tokens. RGTC and BPTC are core,
+ * but are listed here as well so that all of our block compressed formats are defined in one place
+ */
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT1_EXT 0x83F1
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+#ifndef GL_COMPRESSED_RED_RGTC1
+#define GL_COMPRESSED_RED_RGTC1 0x8DBB
+#endif
+#ifndef GL_COMPRESSED_RG_RGTC2
+#define GL_COMPRESSED_RG_RGTC2 0x8DBD
+#endif
+#ifndef GL_COMPRESSED_RGBA_BPTC_UNORM
+#define GL_COMPRESSED_RGBA_BPTC_UNORM 0x8E8C
+#endif
+
 // We can use an enum to make our code more readable and restrict
 // values to only ones we want to accept
 ENUM(ShaderPartType, GLint,
@@ -52,7 +72,13 @@ ENUM(InternalFormat, GLint,
 	RGBA8 = GL_RGBA8,
 	SRGBA = GL_SRGB8_ALPHA8,
 	RGBA16 = GL_RGBA16,
-	RGB32AF = GL_RGBA32F
+	RGB32AF = GL_RGBA32F,
+	// Block compressed formats, these can only be filled with pre-compressed data (see TextureCompressor)
+	BC1 = GL_COMPRESSED_RGBA_S3TC_DXT1_EXT,
+	BC3 = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT,
+	BC4 = GL_COMPRESSED_RED_RGTC1,
+	BC5 = GL_COMPRESSED_RG_RGTC2,
+	BC7 = GL_COMPRESSED_RGBA_BPTC_UNORM
 	// Note: There are sized internal formats but there is a LOT of them
 )
 
@@ -131,6 +157,70 @@ ENUM(MagFilter, GLint,
 	}
 }
 
+/*
+ * Gets the number of bytes used to store a single texel in the given internal format. Drivers may pad some
+ * formats (ex: RGB8), so this is an estimate
+ */
+constexpr size_t GetInternalFormatSize(InternalFormat format) {
+	switch (format) {
+	case InternalFormat::R8:
+		return 1;
+	case InternalFormat::Depth16:
+	case InternalFormat::R16:
+	case InternalFormat::RG8:
+		return 2;
+	case InternalFormat::RGB8:
+	case InternalFormat::SRGB:
+	case InternalFormat::Depth24:
+		return 3;
+	case InternalFormat::Depth32:
+	case InternalFormat::DepthStencil:
+	case InternalFormat::RGB10:
+	case InternalFormat::RGBA8:
+	case InternalFormat::SRGBA:
+		return 4;
+	case InternalFormat::RGB16:
+		return 6;
+	case InternalFormat::RGBA16:
+		return 8;
+	case InternalFormat::RGB32F:
+		return 12;
+	case InternalFormat::RGB32AF:
+		return 16;
+	default:
+		return 0;
+	}
+}
+
+/*
+ * Gets the number of bytes used to store a 4x4 block of texels in a block compressed format, or 0 if the
+ * format is not block compressed
+ */
+constexpr size_t GetCompressedBlockSize(InternalFormat format) {
+	switch (format) {
+	case InternalFormat::BC1:
+	case InternalFormat::BC4:
+		return 8;
+	case InternalFormat::BC3:
+	case InternalFormat::BC5:
+	case InternalFormat::BC7:
+		return 16;
+	default:
+		return 0;
+	}
+}
+
+/*
+ * Gets the number of bytes used to store a single 2D image in the given internal format, handling both
+ * block compressed and uncompressed formats
+ */
+constexpr size_t GetImageSize(InternalFormat format, size_t width, size_t height) {
+	size_t blockSize = GetCompressedBlockSize(format);
+	return blockSize > 0 ?
+		((width + 3) / 4) * ((height + 3) / 4) * blockSize :
+		width * height * GetInternalFormatSize(format);
+}
+
 constexpr InternalFormat GetInternalFormatForChannels8(int numChannels) {
 	switch (numChannels) {
 	case 1:
@@ -751,7 +841,8 @@ ENUM(FillMode, uint32_t,
 	ENUM(BufferType, GLenum,
 		Vertex = GL_ARRAY_BUFFER,
 		Index = GL_ELEMENT_ARRAY_BUFFER,
-		Uniform = GL_UNIFORM_BUFFER
+		Uniform = GL_UNIFORM_BUFFER,
+		ShaderStorage = GL_SHADER_STORAGE_BUFFER
 	)
 
 	/// <summary>
@@ -799,7 +890,9 @@ ENUM(FillMode, uint32_t,
 		User0 = 13,    //
 		User1 = 14,    //
 		User2 = 15,    // Extras
-		User3 = 16     //
+		User3 = 16,    //
+		// Per-instance transforms that are added to meshes by the renderer
+		InstanceTransform = 17
 	)
 
 	/// <summary>
@@ -866,6 +959,7 @@ ENUM(RenderTargetType, uint32_t,
 	ColorRgb10 = GL_RGB10,
 	ColorRgb8 = GL_RGB8,
 	ColorRG8 = GL_RG8,
+	ColorRG16 = GL_RG16,
 	ColorRed8 = GL_R8,
 	ColorRgb16F = GL_RGB16F,
 	ColorRgba16F = GL_RGBA16F,
@@ -878,6 +972,40 @@ ENUM(RenderTargetType, uint32_t,
 	Stencil16 = GL_STENCIL_INDEX16
 )
 
+/*
+ * Gets the number of bytes that a single pixel of a render target takes up in memory, ignoring any
+ * padding or compression that the driver may apply
+ * @param format The format of the render target
+ * @returns The size of a single pixel, in bytes
+ */
+constexpr uint32_t GetRenderTargetPixelSize(RenderTargetType format) {
+	switch (format) {
+	case RenderTargetType::ColorRed8:
+	case RenderTargetType::Stencil4:
+	case RenderTargetType::Stencil8:
+		return 1;
+	case RenderTargetType::ColorRG8:
+	case RenderTargetType::Depth16:
+	case RenderTargetType::Stencil16:
+		return 2;
+	case RenderTargetType::ColorRgb8:
+		return 3;
+	case RenderTargetType::ColorRgba8:
+	case RenderTargetType::ColorRgb10:
+	case RenderTargetType::ColorRG16:
+	case RenderTargetType::DepthStencil:
+	case RenderTargetType::Depth24:
+	case RenderTargetType::Depth32:
+		return 4;
+	case RenderTargetType::ColorRgb16F:
+		return 6;
+	case RenderTargetType::ColorRgba16F:
+		return 8;
+	default:
+		return 0;
+	}
+}
+
 /**
  * Enumerates the possible options for the glBindFramebuffer command
  */
@@ -0,0 +1,23 @@
+#include "Graphics/InstancePacker.h"
+
+void InstancePacker::Pack(const glm::mat4& model, InstanceData& out) {
+	out.Model = model;
+
+	// The normal matrix is the inverse transpose of the upper 3x3, which is the cofactor matrix divided
+	// by the determinant. Since the shaders re-normalize, we only need the sign of the determinant, and
+	// the cofactors are just the cross products of the other two axes
+	glm::vec3 x = glm::vec3(model[0]);
+	glm::vec3 y = glm::vec3(model[1]);
+	glm::vec3 z = glm::vec3(model[2]);
+	glm::vec3 cx = glm::cross(y, z);
+	float sign = glm::dot(x, cx) < 0.0f ? -1.0f : 1.0f;
+	out.NormalMatrix[0] = glm::vec4(cx * sign, 0.0f);
+	out.NormalMatrix[1] = glm::vec4(glm::cross(z, x) * sign, 0.0f);
+	out.NormalMatrix[2] = glm::vec4(glm::cross(x, y) * sign, 0.0f);
+}
+
+void InstancePacker::Pack(const glm::mat4* const* models, size_t count, InstanceData* out) {
+	for (size_t ix = 0; ix < count; ix++) {
+		Pack(*models[ix], out[ix]);
+	}
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include <cstddef>
+#include <GLM/glm.hpp>
+
+/// <summary>
+/// The per-instance data that the renderer streams to instanced draws, matches the inModelTransform
+/// and inNormalMatrix attributes in fragments/vs_common.glsl
+/// </summary>
+struct InstanceData {
+	// The object's model matrix
+	glm::mat4 Model;
+	// The columns of the object's 3x3 normal matrix, padded to vec4s
+	glm::vec4 NormalMatrix[3];
+};
+
+/// <summary>
+/// CPU side helpers for packing object transforms into the instance data layout. These do not
+/// touch OpenGL, so they can write directly into mapped buffer memory
+/// </summary>
+class InstancePacker {
+public:
+	InstancePacker() = delete;
+
+	/// <summary>
+	/// Packs a single model matrix and its normal matrix into an instance
+	/// </summary>
+	/// <param name="model">The object's model matrix</param>
+	/// <param name="out">The instance to write to</param>
+	static void Pack(const glm::mat4& model, InstanceData& out);
+
+	/// <summary>
+	/// Packs a list of model matrices into a list of instances
+	/// </summary>
+	/// <param name="models">An array of pointers to the model matrices to pack</param>
+	/// <param name="count">The number of matrices to pack</param>
+	/// <param name="out">The array of instances to write to, must have room for count instances</param>
+	static void Pack(const glm::mat4* const* models, size_t count, InstanceData* out);
+};
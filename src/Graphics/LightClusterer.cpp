@@ -0,0 +1,184 @@
+#include "Graphics/LightClusterer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "Utils/JobSystem.h"
+#include "Logging.h"
+
+LightClusterer::LightClusterer(const glm::uvec3& gridSize) :
+	_gridSize(0),
+	_projection(glm::mat4(1.0f)),
+	_zNear(0.1f),
+	_zFar(100.0f),
+	_slices(),
+	_clusters(),
+	_lightIndices(),
+	_maxClusterLights(0)
+{
+	SetGridSize(gridSize);
+}
+
+void LightClusterer::SetGridSize(const glm::uvec3& value) {
+	// Tile coordinates are packed into 16 bits while building
+	LOG_ASSERT(value.x > 0 && value.y > 0 && value.z > 0 && value.x <= 0xFFFF && value.y <= 0xFFFF, "Invalid cluster grid size {}x{}x{}", value.x, value.y, value.z);
+	_gridSize = value;
+	_slices.resize(_gridSize.z);
+	_clusters.assign((size_t)_gridSize.x * _gridSize.y * _gridSize.z, LightCluster{ 0, 0 });
+	_lightIndices.clear();
+	_maxClusterLights = 0;
+}
+
+void LightClusterer::SetProjection(const glm::mat4& projection, float zNear, float zFar) {
+	LOG_ASSERT(zNear > 0.0f && zFar > zNear, "Invalid clipping planes for light clusters ({}, {})", zNear, zFar);
+	_projection = projection;
+	_zNear = zNear;
+	_zFar = zFar;
+}
+
+uint32_t LightClusterer::GetDepthSlice(float depth) const {
+	if (depth <= _zNear) {
+		return 0;
+	}
+	glm::vec2 params = GetDepthSliceParams();
+	float slice = std::floor(std::log(depth) * params.x - params.y);
+	return static_cast<uint32_t>(glm::clamp(slice, 0.0f, static_cast<float>(_gridSize.z - 1)));
+}
+
+float LightClusterer::GetSliceDepth(uint32_t slice) const {
+	if (slice >= _gridSize.z) {
+		return _zFar;
+	}
+	return _zNear * std::pow(_zFar / _zNear, static_cast<float>(slice) / _gridSize.z);
+}
+
+glm::vec2 LightClusterer::GetDepthSliceParams() const {
+	float logRange = std::log(_zFar / _zNear);
+	return glm::vec2(_gridSize.z / logRange, _gridSize.z * std::log(_zNear) / logRange);
+}
+
+float LightClusterer::GetInfluenceRadius(float intensity, const glm::vec3& color, float attenuation, float threshold) {
+	// Solve intensity * color / (1 + attenuation * dist^2) = threshold for dist
+	float brightest = intensity * std::max(color.r, std::max(color.g, color.b));
+	if (brightest <= threshold) {
+		return 0.0f;
+	}
+	// Lights that never fall off are treated as covering everything, avoid infinity since 0 * inf = NaN
+	if (attenuation <= 0.0f) {
+		return std::numeric_limits<float>::max();
+	}
+	return std::sqrt((brightest / threshold - 1.0f) / attenuation);
+}
+
+void LightClusterer::Build(const ClusterLight* lights, size_t count) {
+	const size_t tilesPerSlice = (size_t)_gridSize.x * _gridSize.y;
+
+	// Every slice only ever writes to its own scratch data, so they can all be built at once without locking
+	JobSystem::ParallelFor(_gridSize.z, 1, [&](size_t begin, size_t end) {
+		for (size_t slice = begin; slice < end; slice++) {
+			_BuildSlice(static_cast<uint32_t>(slice), lights, count);
+		}
+	});
+
+	// Stitch the slices together, offsetting each slice's ranges by the lights in the slices before it
+	size_t totalIndices = 0;
+	for (const Slice& slice : _slices) {
+		totalIndices += slice.Indices.size();
+	}
+	_lightIndices.resize(totalIndices);
+	_maxClusterLights = 0;
+
+	uint32_t offset = 0;
+	for (uint32_t z = 0; z < _gridSize.z; z++) {
+		const Slice& slice = _slices[z];
+		std::copy(slice.Indices.begin(), slice.Indices.end(), _lightIndices.begin() + offset);
+		LightCluster* clusters = _clusters.data() + z * tilesPerSlice;
+		for (size_t ix = 0; ix < tilesPerSlice; ix++) {
+			clusters[ix].Offset = offset + slice.Offsets[ix];
+			clusters[ix].Count  = slice.Offsets[ix + 1] - slice.Offsets[ix];
+			_maxClusterLights = std::max(_maxClusterLights, clusters[ix].Count);
+		}
+		offset += static_cast<uint32_t>(slice.Indices.size());
+	}
+}
+
+void LightClusterer::_BuildSlice(uint32_t z, const ClusterLight* lights, size_t count) {
+	Slice& slice = _slices[z];
+	slice.Rects.clear();
+	slice.Offsets.assign((size_t)_gridSize.x * _gridSize.y + 1, 0);
+
+	const float sliceNear = GetSliceDepth(z);
+	const float sliceFar  = GetSliceDepth(z + 1);
+
+	// Find the tiles that each light covers within this slice, and count the lights in each tile
+	for (size_t ix = 0; ix < count; ix++) {
+		const ClusterLight& light = lights[ix];
+		float depth = -light.Position.z;
+		if (depth + light.Radius < sliceNear || depth - light.Radius > sliceFar) {
+			continue;
+		}
+
+		TileRect rect;
+		if (!_GetTileRect(light, std::max(sliceNear, depth - light.Radius), std::min(sliceFar, depth + light.Radius), rect)) {
+			continue;
+		}
+		rect.Light = static_cast<uint32_t>(ix);
+		slice.Rects.push_back(rect);
+
+		for (uint32_t y = rect.MinY; y <= rect.MaxY; y++) {
+			for (uint32_t x = rect.MinX; x <= rect.MaxX; x++) {
+				// Counts are shifted up by one so that the prefix sum below turns them into offsets in place
+				slice.Offsets[y * _gridSize.x + x + 1]++;
+			}
+		}
+	}
+
+	for (size_t ix = 1; ix < slice.Offsets.size(); ix++) {
+		slice.Offsets[ix] += slice.Offsets[ix - 1];
+	}
+
+	// Scatter the light indices into their tiles, lights stay in the order they were given within each tile
+	slice.Indices.resize(slice.Offsets.back());
+	slice.Cursors.assign(slice.Offsets.begin(), slice.Offsets.end() - 1);
+	for (const TileRect& rect : slice.Rects) {
+		for (uint32_t y = rect.MinY; y <= rect.MaxY; y++) {
+			for (uint32_t x = rect.MinX; x <= rect.MaxX; x++) {
+				slice.Indices[slice.Cursors[y * _gridSize.x + x]++] = rect.Light;
+			}
+		}
+	}
+}
+
+bool LightClusterer::_GetTileRect(const ClusterLight& light, float minDepth, float maxDepth, TileRect& result) const {
+	// The light's bounding box clipped to the depth range, the clip keeps every corner in front of
+	// the camera, so the projected corners bound the box on screen
+	glm::vec2 boundsMin = glm::vec2(std::numeric_limits<float>::max());
+	glm::vec2 boundsMax = glm::vec2(std::numeric_limits<float>::lowest());
+	for (int corner = 0; corner < 8; corner++) {
+		glm::vec4 point = glm::vec4(
+			light.Position.x + ((corner & 1) ? light.Radius : -light.Radius),
+			light.Position.y + ((corner & 2) ? light.Radius : -light.Radius),
+			(corner & 4) ? -maxDepth : -minDepth,
+			1.0f
+		);
+		glm::vec4 clip = _projection * point;
+		glm::vec2 ndc = glm::vec2(clip) / clip.w;
+		boundsMin = glm::min(boundsMin, ndc);
+		boundsMax = glm::max(boundsMax, ndc);
+	}
+
+	if (boundsMax.x < -1.0f || boundsMax.y < -1.0f || boundsMin.x > 1.0f || boundsMin.y > 1.0f) {
+		return false;
+	}
+
+	// Convert from NDC to tiles, tile 0 is at the bottom left to match texture coordinates
+	glm::vec2 tiles = glm::vec2(_gridSize.x, _gridSize.y);
+	glm::vec2 tileMin = glm::clamp(glm::floor((boundsMin * 0.5f + 0.5f) * tiles), glm::vec2(0.0f), tiles - 1.0f);
+	glm::vec2 tileMax = glm::clamp(glm::floor((boundsMax * 0.5f + 0.5f) * tiles), glm::vec2(0.0f), tiles - 1.0f);
+	result.MinX = static_cast<uint16_t>(tileMin.x);
+	result.MinY = static_cast<uint16_t>(tileMin.y);
+	result.MaxX = static_cast<uint16_t>(tileMax.x);
+	result.MaxY = static_cast<uint16_t>(tileMax.y);
+	return true;
+}
@@ -0,0 +1,148 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <GLM/glm.hpp>
+
+#include "Utils/Macros.h"
+
+/// <summary>
+/// The bounding sphere of a light, in view space
+/// </summary>
+struct ClusterLight {
+	// The light's position in view space, the camera looks down -Z
+	glm::vec3 Position;
+	// The distance past which the light no longer has a visible effect
+	float     Radius;
+};
+
+/// <summary>
+/// The range of the light index list that belongs to a single cluster, matches the uvec2
+/// cluster entries in fragment_shaders/light_accumulation.glsl
+/// </summary>
+struct LightCluster {
+	uint32_t Offset;
+	uint32_t Count;
+};
+
+/// <summary>
+/// Splits the view frustum into a grid of clusters, with tiles evenly spaced across the screen and
+/// slices that grow exponentially with depth, and finds the lights that touch each cluster. The result
+/// is a list of light indices that is sorted by cluster, and the range of that list for each cluster,
+/// so a fragment only needs to look at the lights in the cluster it falls in
+///
+/// Each depth slice is built on its own job, so building does not touch OpenGL
+/// </summary>
+class LightClusterer {
+public:
+	NO_COPY(LightClusterer);
+	NO_MOVE(LightClusterer);
+
+	/// <summary>
+	/// The default number of clusters along the x, y and z axes
+	/// </summary>
+	static constexpr uint32_t DEFAULT_TILES_X = 16;
+	static constexpr uint32_t DEFAULT_TILES_Y = 9;
+	static constexpr uint32_t DEFAULT_SLICES  = 24;
+
+	/// <summary>
+	/// Creates a new light clusterer
+	/// </summary>
+	/// <param name="gridSize">The number of tiles along the x and y axes of the screen, and the number of depth slices</param>
+	LightClusterer(const glm::uvec3& gridSize = glm::uvec3(DEFAULT_TILES_X, DEFAULT_TILES_Y, DEFAULT_SLICES));
+
+	/// <summary>
+	/// Gets or sets the number of clusters along each axis, the clusters will be empty until the next Build
+	/// </summary>
+	const glm::uvec3& GetGridSize() const { return _gridSize; }
+	void SetGridSize(const glm::uvec3& value);
+
+	/// <summary>
+	/// Sets the camera that the clusters are built for
+	/// </summary>
+	/// <param name="projection">The camera's projection matrix</param>
+	/// <param name="zNear">The distance to the camera's near plane, must be greater than 0</param>
+	/// <param name="zFar">The distance to the camera's far plane</param>
+	void SetProjection(const glm::mat4& projection, float zNear, float zFar);
+
+	/// <summary>
+	/// Assigns lights to clusters
+	/// </summary>
+	/// <param name="lights">The view space bounds of the lights</param>
+	/// <param name="count">The number of lights</param>
+	void Build(const ClusterLight* lights, size_t count);
+
+	/// <summary>
+	/// Gets the range of the light index list for each cluster, clusters are stored x first, then y, then z
+	/// </summary>
+	const std::vector<LightCluster>& GetClusters() const { return _clusters; }
+	/// <summary>
+	/// Gets the indices of the lights in each cluster, see GetClusters
+	/// </summary>
+	const std::vector<uint32_t>& GetLightIndices() const { return _lightIndices; }
+	/// <summary>
+	/// Gets the largest number of lights in a single cluster from the last build
+	/// </summary>
+	uint32_t GetMaxClusterLights() const { return _maxClusterLights; }
+
+	/// <summary>
+	/// Gets the index of the cluster at the given grid coordinates
+	/// </summary>
+	uint32_t GetClusterIndex(uint32_t x, uint32_t y, uint32_t z) const { return (z * _gridSize.y + y) * _gridSize.x + x; }
+	/// <summary>
+	/// Gets the depth slice that a view space depth (the distance along -Z) falls in, clamped to the grid
+	/// </summary>
+	uint32_t GetDepthSlice(float depth) const;
+	/// <summary>
+	/// Gets the depth at which a slice starts, slice count returns the far plane
+	/// </summary>
+	float GetSliceDepth(uint32_t slice) const;
+	/// <summary>
+	/// Gets the scale and bias that shaders can use to find a depth slice, where
+	/// slice = floor(log(depth) * scale - bias)
+	/// </summary>
+	glm::vec2 GetDepthSliceParams() const;
+
+	/// <summary>
+	/// Gets the distance at which a light's contribution falls below a threshold, using the same
+	/// attenuation as fragment_shaders/light_accumulation.glsl
+	/// </summary>
+	/// <param name="intensity">The light's intensity</param>
+	/// <param name="color">The light's color</param>
+	/// <param name="attenuation">The light's attenuation factor</param>
+	/// <param name="threshold">The smallest contribution that we care about, default is one step of an 8 bit color</param>
+	static float GetInfluenceRadius(float intensity, const glm::vec3& color, float attenuation, float threshold = 1.0f / 256.0f);
+
+protected:
+	// A light that touches a slice, and the range of tiles it covers in that slice (inclusive)
+	struct TileRect {
+		uint32_t Light;
+		uint16_t MinX, MaxX;
+		uint16_t MinY, MaxY;
+	};
+
+	// The results for a single depth slice, these are merged once every slice is done
+	struct Slice {
+		std::vector<TileRect> Rects;
+		std::vector<uint32_t> Offsets;
+		std::vector<uint32_t> Indices;
+		// The next free index in each tile while scattering
+		std::vector<uint32_t> Cursors;
+	};
+
+	glm::uvec3 _gridSize;
+	glm::mat4  _projection;
+	float      _zNear;
+	float      _zFar;
+
+	std::vector<Slice>        _slices;
+	std::vector<LightCluster> _clusters;
+	std::vector<uint32_t>     _lightIndices;
+	uint32_t                  _maxClusterLights;
+
+	void _BuildSlice(uint32_t slice, const ClusterLight* lights, size_t count);
+	/// <summary>
+	/// Finds the tiles covered by a light between two view space depths, returns false if the light is off screen
+	/// </summary>
+	bool _GetTileRect(const ClusterLight& light, float minDepth, float maxDepth, TileRect& result) const;
+};
@@ -0,0 +1,91 @@
+#pragma once
+#include <cmath>
+#include <limits>
+#include <vector>
+#include <GLM/glm.hpp>
+
+#include "Graphics/VertexArrayObject.h"
+#include "Utils/BoundingVolumes.h"
+
+/// <summary>
+/// A single level of detail for a mesh. All the levels of a mesh share the same vertex
+/// buffer, and only differ in which triangles their index buffers draw
+/// </summary>
+struct MeshLod {
+	// The VAO for rendering this level
+	VertexArrayObject::Sptr Mesh = nullptr;
+	// The approximate deviation from the full detail mesh, as a fraction of the mesh's bounding radius
+	float                   Error = 0.0f;
+
+	/// <summary>
+	/// Creates a level of detail that draws the given indices out of the base mesh's vertex buffers
+	/// </summary>
+	/// <param name="base">The full detail mesh, whose vertex buffers will be shared</param>
+	/// <param name="indices">The index data for this level</param>
+	/// <param name="indexType">The type of the indices in the index data</param>
+	/// <param name="numIndices">The number of indices in the index data</param>
+	/// <param name="error">The error of this level, as a fraction of the mesh's bounding radius</param>
+	static MeshLod Create(const VertexArrayObject::Sptr& base, const void* indices, IndexType indexType, uint32_t numIndices, float error) {
+		IndexBuffer::Sptr ibo = IndexBuffer::Create(BufferUsage::StaticDraw);
+		ibo->LoadData(indices, static_cast<uint32_t>(GetIndexTypeSize(indexType)), numIndices, indexType);
+
+		MeshLod result;
+		result.Mesh = base->Clone();
+		result.Mesh->SetIndexBuffer(ibo);
+		result.Error = error;
+		return result;
+	}
+
+	/// <summary>
+	/// Gets how large a mesh's bounding sphere appears on screen, taking the largest scale axis of the
+	/// model view matrix to be safe
+	/// </summary>
+	/// <param name="bounds">The object space bounds of the mesh</param>
+	/// <param name="modelView">The object's model view matrix</param>
+	/// <param name="projection">The projection matrix that the object is being rendered with</param>
+	/// <param name="screenHeight">The height of the render target in pixels</param>
+	/// <returns>The radius of the sphere on screen in pixels, or infinity if the camera is inside the sphere</returns>
+	static float GetProjectedRadius(const AABB& bounds, const glm::mat4& modelView, const glm::mat4& projection, float screenHeight) {
+		// Find the bounding sphere in view space
+		glm::vec3 center = modelView * glm::vec4(bounds.GetCenter(), 1.0f);
+		float scale = glm::sqrt(glm::max(glm::max(
+			glm::dot(glm::vec3(modelView[0]), glm::vec3(modelView[0])),
+			glm::dot(glm::vec3(modelView[1]), glm::vec3(modelView[1]))),
+			glm::dot(glm::vec3(modelView[2]), glm::vec3(modelView[2]))));
+		float radius = bounds.GetRadius() * scale;
+
+		// Work out how many pixels a unit at the sphere's depth covers, perspective projections
+		// shrink with distance (w = -z), but orthographic projections do not
+		float pixelsPerUnit = projection[1][1] * screenHeight * 0.5f;
+		if (projection[2][3] != 0.0f) {
+			float distance = -center.z;
+			if (distance <= radius) {
+				return std::numeric_limits<float>::infinity();
+			}
+			pixelsPerUnit /= distance;
+		}
+		return radius * pixelsPerUnit;
+	}
+
+	/// <summary>
+	/// Selects the simplest level whose error would not be noticeable when the mesh is drawn at the
+	/// given size on screen
+	/// </summary>
+	/// <param name="lods">The levels of the mesh, from most to least detailed</param>
+	/// <param name="projectedRadius">The radius of the mesh's bounding sphere on screen, in pixels (see GetProjectedRadius)</param>
+	/// <param name="maxPixelError">The largest error we are willing to accept, in pixels</param>
+	/// <returns>The index of the selected level, 0 is the full detail mesh</returns>
+	static size_t SelectLevel(const std::vector<MeshLod>& lods, float projectedRadius, float maxPixelError) {
+		// If the camera is inside the mesh's bounds, always use the full detail mesh
+		if (std::isinf(projectedRadius)) {
+			return 0;
+		}
+		// Levels get less detailed as we go, so we want the last one that is still accurate enough
+		for (size_t ix = lods.size(); ix > 1; ix--) {
+			if (lods[ix - 1].Error * projectedRadius <= maxPixelError) {
+				return ix - 1;
+			}
+		}
+		return 0;
+	}
+};
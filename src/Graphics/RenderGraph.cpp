@@ -0,0 +1,349 @@
+#include "Graphics/RenderGraph.h"
+
+#include <algorithm>
+
+#include "Logging.h"
+
+RenderGraph::TargetDescriptor::TargetDescriptor(RenderTargetType color0, const glm::vec2& scale) :
+	Scale(scale),
+	FixedSize(0),
+	Color{ color0, RenderTargetType::Unknown, RenderTargetType::Unknown, RenderTargetType::Unknown },
+	Depth(RenderTargetType::Unknown)
+{ }
+
+glm::uvec2 RenderGraph::TargetDescriptor::GetSize(const glm::uvec2& screenSize) const {
+	if (FixedSize.x > 0 && FixedSize.y > 0) {
+		return FixedSize;
+	}
+	return glm::max(glm::uvec2(glm::vec2(screenSize) * Scale), glm::uvec2(1));
+}
+
+uint32_t RenderGraph::TargetDescriptor::GetPixelSize() const {
+	uint32_t result = GetRenderTargetPixelSize(Depth);
+	for (RenderTargetType format : Color) {
+		result += GetRenderTargetPixelSize(format);
+	}
+	return result;
+}
+
+bool RenderGraph::TargetDescriptor::operator==(const TargetDescriptor& other) const {
+	return Scale == other.Scale && FixedSize == other.FixedSize && Depth == other.Depth &&
+		std::equal(std::begin(Color), std::end(Color), std::begin(other.Color));
+}
+
+RenderGraph::RenderGraph() :
+	_screenSize(0),
+	_targets(),
+	_passes(),
+	_isCompiled(false),
+	_passOrder(),
+	_slots(),
+	_errors(),
+	_culledPassCount(0),
+	_droppedBlitCount(0),
+	_transientCount(0),
+	_isLive(),
+	_slotLastUse(),
+	_slotOrder()
+{ }
+
+void RenderGraph::Reset(const glm::uvec2& screenSize) {
+	_screenSize = screenSize;
+	_targets.clear();
+	_passes.clear();
+	_isCompiled = false;
+	_passOrder.clear();
+	_slots.clear();
+	_errors.clear();
+}
+
+RenderGraph::Handle RenderGraph::Import(const std::string& name, const TargetDescriptor& descriptor) {
+	_targets.push_back({ name, descriptor, true, INVALID_HANDLE, INVALID_HANDLE, INVALID_HANDLE, INVALID_HANDLE });
+	_isCompiled = false;
+	return static_cast<Handle>(_targets.size() - 1);
+}
+
+RenderGraph::Handle RenderGraph::CreateTarget(const std::string& name, const TargetDescriptor& descriptor) {
+	_targets.push_back({ name, descriptor, false, INVALID_HANDLE, INVALID_HANDLE, INVALID_HANDLE, INVALID_HANDLE });
+	_isCompiled = false;
+	return static_cast<Handle>(_targets.size() - 1);
+}
+
+uint32_t RenderGraph::AddPass(const std::string& name, const std::vector<Handle>& reads, const std::vector<Handle>& writes, const std::function<void()>& execute) {
+	_passes.push_back({ name, reads, writes, execute, false, false });
+	_isCompiled = false;
+	return static_cast<uint32_t>(_passes.size() - 1);
+}
+
+uint32_t RenderGraph::AddBlit(const std::string& name, Handle source, Handle dest, const std::function<void()>& execute) {
+	_passes.push_back({ name, { source }, { dest }, execute, true, false });
+	_isCompiled = false;
+	return static_cast<uint32_t>(_passes.size() - 1);
+}
+
+bool RenderGraph::Compile() {
+	_ResetCompileState();
+	if (!_Validate()) {
+		_isCompiled = false;
+		return false;
+	}
+
+	_DropBlits();
+	_CullPasses();
+	_AssignSlots();
+
+	_isCompiled = true;
+	return true;
+}
+
+void RenderGraph::CompileInOrder() {
+	_ResetCompileState();
+
+	for (uint32_t passIx = 0; passIx < _passes.size(); passIx++) {
+		Pass& pass = _passes[passIx];
+		bool isValid = true;
+		for (const std::vector<Handle>* handles : { &pass.Reads, &pass.Writes }) {
+			for (Handle handle : *handles) {
+				isValid &= handle < _targets.size();
+			}
+		}
+		if (!isValid) {
+			pass.IsCulled = true;
+			_culledPassCount++;
+			continue;
+		}
+
+		_passOrder.push_back(passIx);
+		for (const std::vector<Handle>* handles : { &pass.Reads, &pass.Writes }) {
+			for (Handle handle : *handles) {
+				Target& target = _targets[handle];
+				target.FirstUse = std::min(target.FirstUse, passIx);
+				target.LastUse = target.LastUse == INVALID_HANDLE ? passIx : std::max(target.LastUse, passIx);
+			}
+		}
+	}
+
+	// Every used transient target gets a slot to itself
+	for (Target& target : _targets) {
+		if (!target.IsImported && target.FirstUse != INVALID_HANDLE) {
+			target.Slot = static_cast<uint32_t>(_slots.size());
+			_slots.push_back(target.Descriptor);
+			_transientCount++;
+		}
+	}
+
+	_isCompiled = true;
+}
+
+void RenderGraph::_ResetCompileState() {
+	for (Target& target : _targets) {
+		target.FirstUse = INVALID_HANDLE;
+		target.LastUse = INVALID_HANDLE;
+		target.Slot = INVALID_HANDLE;
+		target.AliasOf = INVALID_HANDLE;
+	}
+	for (Pass& pass : _passes) {
+		pass.IsCulled = false;
+	}
+	_passOrder.clear();
+	_slots.clear();
+	_errors.clear();
+	_culledPassCount = 0;
+	_droppedBlitCount = 0;
+	_transientCount = 0;
+	_isCompiled = false;
+}
+
+void RenderGraph::Execute() const {
+	LOG_ASSERT(_isCompiled, "Render graph must be compiled before it is executed");
+	for (uint32_t ix : _passOrder) {
+		if (_passes[ix].Execute) {
+			_passes[ix].Execute();
+		}
+	}
+}
+
+const RenderGraph::Target& RenderGraph::GetTarget(Handle handle) const {
+	LOG_ASSERT(handle < _targets.size(), "Render graph target {} does not exist", handle);
+	return _targets[handle];
+}
+
+uint32_t RenderGraph::GetSlot(Handle handle) const {
+	return GetTarget(handle).Slot;
+}
+
+RenderGraph::Handle RenderGraph::Resolve(Handle handle) const {
+	while (_targets[handle].AliasOf != INVALID_HANDLE) {
+		handle = _targets[handle].AliasOf;
+	}
+	return handle;
+}
+
+bool RenderGraph::_Validate() {
+	// Transient targets start out empty, so they have to be written before anything can read them. Targets
+	// are marked live here once something has written them
+	_isLive.assign(_targets.size(), false);
+	for (const Pass& pass : _passes) {
+		bool isValid = true;
+		for (const std::vector<Handle>* handles : { &pass.Reads, &pass.Writes }) {
+			for (Handle handle : *handles) {
+				if (handle >= _targets.size()) {
+					_errors.push_back("Pass '" + pass.Name + "' uses a target that does not exist");
+					isValid = false;
+				}
+			}
+		}
+		if (!isValid) {
+			continue;
+		}
+
+		if (pass.IsBlit && (pass.Reads.size() != 1 || pass.Writes.size() != 1)) {
+			_errors.push_back("Blit '" + pass.Name + "' must have exactly one source and one destination");
+		}
+		for (Handle read : pass.Reads) {
+			if (std::find(pass.Writes.begin(), pass.Writes.end(), read) != pass.Writes.end()) {
+				_errors.push_back("Pass '" + pass.Name + "' reads and writes '" + _targets[read].Name + "' at the same time");
+			}
+			if (!_targets[read].IsImported && !_isLive[read]) {
+				_errors.push_back("Pass '" + pass.Name + "' reads '" + _targets[read].Name + "' before anything writes it");
+			}
+		}
+		for (Handle write : pass.Writes) {
+			_isLive[write] = true;
+		}
+	}
+	return _errors.empty();
+}
+
+void RenderGraph::_DropBlits() {
+	for (uint32_t passIx = 0; passIx < _passes.size(); passIx++) {
+		Pass& blit = _passes[passIx];
+		if (!blit.IsBlit) {
+			continue;
+		}
+
+		Handle source = Resolve(blit.Reads[0]);
+		Handle dest = blit.Writes[0];
+		const Target& destTarget = _targets[dest];
+		if (destTarget.IsImported || destTarget.AliasOf != INVALID_HANDLE || destTarget.Descriptor != _targets[source].Descriptor) {
+			continue;
+		}
+
+		// The destination has to be fresh, otherwise the blit would overwrite something that is already in it
+		bool canDrop = true;
+		for (uint32_t ix = 0; canDrop && ix < passIx; ix++) {
+			const std::vector<Handle>& writes = _passes[ix].Writes;
+			canDrop = std::find(writes.begin(), writes.end(), dest) == writes.end();
+		}
+
+		// Afterwards, the source can't change while the destination is still in use. If the destination is
+		// written to, that would write over the source as well, so the source must not be needed any more
+		bool isSourceUsed = _targets[source].IsImported;
+		bool isDestWritten = false;
+		for (uint32_t ix = passIx + 1; canDrop && ix < _passes.size(); ix++) {
+			const Pass& pass = _passes[ix];
+			for (Handle write : pass.Writes) {
+				canDrop &= Resolve(write) != source;
+				isDestWritten |= write == dest;
+			}
+			for (Handle read : pass.Reads) {
+				isSourceUsed |= Resolve(read) == source;
+			}
+		}
+		if (!canDrop || (isDestWritten && isSourceUsed)) {
+			continue;
+		}
+
+		_targets[dest].AliasOf = source;
+		blit.IsCulled = true;
+		_droppedBlitCount++;
+	}
+}
+
+void RenderGraph::_CullPasses() {
+	// Walk backwards from the passes with side effects, keeping any pass that writes a target someone still needs
+	_isLive.assign(_targets.size(), false);
+	for (size_t ix = _passes.size(); ix > 0; ix--) {
+		Pass& pass = _passes[ix - 1];
+		if (pass.IsCulled) {
+			continue;
+		}
+
+		// Passes that don't write any targets are only run for their side effects
+		bool isNeeded = pass.Writes.empty();
+		for (Handle write : pass.Writes) {
+			Handle target = Resolve(write);
+			isNeeded |= _targets[target].IsImported || _isLive[target];
+		}
+
+		if (isNeeded) {
+			for (Handle read : pass.Reads) {
+				_isLive[Resolve(read)] = true;
+			}
+		} else {
+			pass.IsCulled = true;
+			_culledPassCount++;
+		}
+	}
+
+	for (uint32_t ix = 0; ix < _passes.size(); ix++) {
+		if (!_passes[ix].IsCulled) {
+			_passOrder.push_back(ix);
+		}
+	}
+}
+
+void RenderGraph::_AssignSlots() {
+	// Find how long each target is needed for, dropped blit destinations share their source's lifetime
+	for (uint32_t passIx : _passOrder) {
+		const Pass& pass = _passes[passIx];
+		for (const std::vector<Handle>* handles : { &pass.Reads, &pass.Writes }) {
+			for (Handle handle : *handles) {
+				Target& target = _targets[Resolve(handle)];
+				target.FirstUse = std::min(target.FirstUse, passIx);
+				target.LastUse = target.LastUse == INVALID_HANDLE ? passIx : std::max(target.LastUse, passIx);
+			}
+		}
+	}
+
+	// Hand out slots in the order that targets are first used, re-using a slot with the same layout
+	// once its last target is done with it
+	_slotOrder.clear();
+	for (Handle ix = 0; ix < _targets.size(); ix++) {
+		if (!_targets[ix].IsImported && _targets[ix].AliasOf == INVALID_HANDLE && _targets[ix].FirstUse != INVALID_HANDLE) {
+			_slotOrder.push_back(ix);
+		}
+	}
+	std::stable_sort(_slotOrder.begin(), _slotOrder.end(), [&](Handle a, Handle b) {
+		return _targets[a].FirstUse < _targets[b].FirstUse;
+	});
+
+	_slotLastUse.clear();
+	for (Handle handle : _slotOrder) {
+		Target& target = _targets[handle];
+		for (uint32_t slot = 0; slot < _slots.size(); slot++) {
+			if (_slotLastUse[slot] < target.FirstUse && _slots[slot] == target.Descriptor) {
+				target.Slot = slot;
+				break;
+			}
+		}
+		if (target.Slot == INVALID_HANDLE) {
+			target.Slot = static_cast<uint32_t>(_slots.size());
+			_slots.push_back(target.Descriptor);
+			_slotLastUse.push_back(0);
+		}
+		_slotLastUse[target.Slot] = target.LastUse;
+	}
+
+	for (Target& target : _targets) {
+		if (target.AliasOf != INVALID_HANDLE) {
+			const Target& source = _targets[Resolve(target.AliasOf)];
+			target.FirstUse = source.FirstUse;
+			target.LastUse = source.LastUse;
+			target.Slot = source.Slot;
+		}
+		if (!target.IsImported && target.FirstUse != INVALID_HANDLE) {
+			_transientCount++;
+		}
+	}
+}
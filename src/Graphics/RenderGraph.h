@@ -0,0 +1,229 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+#include <GLM/glm.hpp>
+
+#include "Graphics/GlEnums.h"
+#include "Utils/Macros.h"
+
+/// <summary>
+/// Describes a frame's worth of rendering as a list of passes, along with the render targets that each
+/// pass reads and writes. Once compiled, the graph knows how long every target is needed for, so:
+///  - Passes whose results are never read are culled
+///  - Blits that only copy a target into a fresh target are dropped, and readers use the source instead
+///  - Transient targets whose lifetimes don't overlap share the same physical framebuffer (slot)
+///
+/// Targets are either imported, which are owned outside of the graph (ex: the G-buffer or the screen), or
+/// transient, which only live for the frame and are handed out by a RenderTargetPool. Writing to an
+/// imported target counts as a side effect, so passes that do are never culled
+///
+/// Does not touch OpenGL, all of the actual rendering is done by the passes' execute callbacks
+/// </summary>
+class RenderGraph {
+public:
+	NO_COPY(RenderGraph);
+	NO_MOVE(RenderGraph);
+
+	typedef uint32_t Handle;
+
+	/// <summary>
+	/// Marks a missing target or slot
+	/// </summary>
+	static constexpr Handle INVALID_HANDLE = ~0u;
+	/// <summary>
+	/// The most color attachments that a target may have
+	/// </summary>
+	static constexpr uint32_t MAX_COLOR_TARGETS = 4;
+
+	/// <summary>
+	/// Describes the size and attachments of a render target, transient targets can only share a
+	/// slot if their descriptors are equal
+	/// </summary>
+	struct TargetDescriptor {
+		// The size of the target relative to the graph's screen size, used when FixedSize is 0
+		glm::vec2        Scale;
+		// The size of the target in pixels, overrides Scale when non-zero
+		glm::uvec2       FixedSize;
+		// The format of each color attachment, Unknown attachments are left empty
+		RenderTargetType Color[MAX_COLOR_TARGETS];
+		// The format of the depth attachment, or Unknown for none
+		RenderTargetType Depth;
+
+		TargetDescriptor(RenderTargetType color0 = RenderTargetType::ColorRgba8, const glm::vec2& scale = glm::vec2(1.0f));
+
+		/// <summary>
+		/// Gets the size of the target in pixels, for a given screen size
+		/// </summary>
+		glm::uvec2 GetSize(const glm::uvec2& screenSize) const;
+		/// <summary>
+		/// Gets the number of bytes that each pixel of the target takes up, across all of its attachments
+		/// </summary>
+		uint32_t GetPixelSize() const;
+
+		bool operator ==(const TargetDescriptor& other) const;
+		bool operator !=(const TargetDescriptor& other) const { return !(*this == other); }
+	};
+
+	/// <summary>
+	/// A render target that passes may read or write
+	/// </summary>
+	struct Target {
+		std::string      Name;
+		TargetDescriptor Descriptor;
+		// True if the target is owned outside of the graph
+		bool             IsImported;
+
+		// Filled in by Compile. The indices of the first and last passes that use the target (INVALID_HANDLE
+		// if unused), and the slot that the target is stored in (INVALID_HANDLE for imports)
+		uint32_t         FirstUse;
+		uint32_t         LastUse;
+		uint32_t         Slot;
+		// The target that this one was merged into when a blit between them was dropped, or INVALID_HANDLE
+		Handle           AliasOf;
+	};
+
+	/// <summary>
+	/// A single step of rendering
+	/// </summary>
+	struct Pass {
+		std::string           Name;
+		// The targets that the pass samples from, or copies from for blits
+		std::vector<Handle>   Reads;
+		// The targets that the pass renders into
+		std::vector<Handle>   Writes;
+		// Does the actual rendering, may be empty
+		std::function<void()> Execute;
+		// Blits copy their only read into their only write, and may be dropped by Compile
+		bool                  IsBlit;
+		// Set by Compile if the pass will not be executed
+		bool                  IsCulled;
+	};
+
+	RenderGraph();
+
+	/// <summary>
+	/// Removes all passes and targets, so that the next frame can be declared
+	/// </summary>
+	/// <param name="screenSize">The size in pixels that target scales are relative to</param>
+	void Reset(const glm::uvec2& screenSize);
+
+	/// <summary>
+	/// Adds a target that is owned outside of the graph
+	/// </summary>
+	/// <param name="name">The name of the target, for debugging</param>
+	/// <param name="descriptor">The layout of the target, only used to check if blits into it can be dropped</param>
+	Handle Import(const std::string& name, const TargetDescriptor& descriptor = TargetDescriptor(RenderTargetType::Unknown));
+	/// <summary>
+	/// Adds a target that only lives for this frame, the graph decides which slot it is stored in
+	/// </summary>
+	/// <param name="name">The name of the target, for debugging</param>
+	/// <param name="descriptor">The size and attachments of the target</param>
+	Handle CreateTarget(const std::string& name, const TargetDescriptor& descriptor);
+
+	/// <summary>
+	/// Adds a pass to the end of the graph
+	/// </summary>
+	/// <param name="name">The name of the pass, for debugging</param>
+	/// <param name="reads">The targets that the pass samples from</param>
+	/// <param name="writes">The targets that the pass renders into</param>
+	/// <param name="execute">The callback that does the rendering</param>
+	/// <returns>The index of the pass</returns>
+	uint32_t AddPass(const std::string& name, const std::vector<Handle>& reads, const std::vector<Handle>& writes, const std::function<void()>& execute);
+	/// <summary>
+	/// Adds a pass that copies one target into another. If the destination is a fresh transient target with
+	/// the same layout as the source, and the source is left alone afterwards, then the blit is dropped and
+	/// everything that reads the destination reads the source instead
+	/// </summary>
+	/// <param name="name">The name of the pass, for debugging</param>
+	/// <param name="source">The target to copy from</param>
+	/// <param name="dest">The target to copy into</param>
+	/// <param name="execute">The callback that does the copy</param>
+	/// <returns>The index of the pass</returns>
+	uint32_t AddBlit(const std::string& name, Handle source, Handle dest, const std::function<void()>& execute);
+
+	/// <summary>
+	/// Validates the graph, culls unused passes, drops redundant blits, and assigns transient targets to slots
+	/// </summary>
+	/// <returns>True if the graph is valid, otherwise see GetErrors</returns>
+	bool Compile();
+	/// <summary>
+	/// Prepares the graph to run every pass in the order it was added, without culling passes, dropping blits,
+	/// or sharing slots. This is the fallback for when Compile fails, passes that use targets that don't exist are skipped
+	/// </summary>
+	void CompileInOrder();
+	/// <summary>
+	/// Runs the callbacks of every pass that survived compiling, in order
+	/// </summary>
+	void Execute() const;
+
+	/// <summary>
+	/// Gets the size in pixels that target scales are relative to
+	/// </summary>
+	const glm::uvec2& GetScreenSize() const { return _screenSize; }
+
+	const std::vector<Target>& GetTargets() const { return _targets; }
+	const Target& GetTarget(Handle handle) const;
+	const std::vector<Pass>& GetPasses() const { return _passes; }
+
+	/// <summary>
+	/// Gets the indices of the passes that will be executed, in order
+	/// </summary>
+	const std::vector<uint32_t>& GetPassOrder() const { return _passOrder; }
+	/// <summary>
+	/// Gets the layout of every physical target that the transient targets were packed into
+	/// </summary>
+	const std::vector<TargetDescriptor>& GetSlots() const { return _slots; }
+	/// <summary>
+	/// Gets the slot that a target is stored in, following any dropped blits. Returns INVALID_HANDLE
+	/// for imported targets and targets that are never used
+	/// </summary>
+	uint32_t GetSlot(Handle handle) const;
+	/// <summary>
+	/// Gets the target that actually holds the contents of the given target, after dropping redundant blits
+	/// </summary>
+	Handle Resolve(Handle handle) const;
+
+	/// <summary>
+	/// Gets the problems that were found by the last call to Compile
+	/// </summary>
+	const std::vector<std::string>& GetErrors() const { return _errors; }
+	/// <summary>
+	/// Gets the number of passes that were culled in the last compile, not including dropped blits
+	/// </summary>
+	uint32_t GetCulledPassCount() const { return _culledPassCount; }
+	/// <summary>
+	/// Gets the number of blits that were dropped in the last compile
+	/// </summary>
+	uint32_t GetDroppedBlitCount() const { return _droppedBlitCount; }
+	/// <summary>
+	/// Gets the number of transient targets that are used by at least one pass
+	/// </summary>
+	uint32_t GetTransientCount() const { return _transientCount; }
+
+protected:
+	glm::uvec2               _screenSize;
+	std::vector<Target>      _targets;
+	std::vector<Pass>        _passes;
+
+	bool                     _isCompiled;
+	std::vector<uint32_t>    _passOrder;
+	std::vector<TargetDescriptor> _slots;
+	std::vector<std::string> _errors;
+	uint32_t                 _culledPassCount;
+	uint32_t                 _droppedBlitCount;
+	uint32_t                 _transientCount;
+
+	// Scratch space for compiling
+	std::vector<bool>        _isLive;
+	std::vector<uint32_t>    _slotLastUse;
+	std::vector<Handle>      _slotOrder;
+
+	void _ResetCompileState();
+	bool _Validate();
+	void _DropBlits();
+	void _CullPasses();
+	void _AssignSlots();
+};
@@ -0,0 +1,91 @@
+#include "Graphics/RenderQueue.h"
+
+#include <cstring>
+#include <utility>
+
+RenderQueue::RenderQueue() :
+	_items(),
+	_scratch()
+{ }
+
+uint64_t RenderQueue::MakeKey(RenderBucket bucket, uint32_t shaderId, uint32_t materialId, uint32_t meshId, float depth) {
+	// The bit pattern of a positive float increases with its value, so the top bits (minus the sign)
+	// give us a depth that sorts correctly without needing to know the near and far planes
+	uint32_t depthBits = 0;
+	if (depth > 0.0f) {
+		memcpy(&depthBits, &depth, sizeof(float));
+		depthBits = (depthBits >> (31 - DEPTH_BITS)) & ((1u << DEPTH_BITS) - 1);
+	}
+
+	uint64_t state =
+		(static_cast<uint64_t>(shaderId   & ((1u << SHADER_BITS) - 1)) << (MATERIAL_BITS + MESH_BITS)) |
+		(static_cast<uint64_t>(materialId & ((1u << MATERIAL_BITS) - 1)) << MESH_BITS) |
+		(static_cast<uint64_t>(meshId     & ((1u << MESH_BITS) - 1)));
+
+	if (bucket == RenderBucket::Transparent) {
+		// Transparent objects must blend over what is behind them, so depth comes first and is inverted
+		uint64_t invDepth = ((1u << DEPTH_BITS) - 1) - depthBits;
+		return (1ull << 63) | (invDepth << (SHADER_BITS + MATERIAL_BITS + MESH_BITS)) | state;
+	} else {
+		return (state << DEPTH_BITS) | depthBits;
+	}
+}
+
+void RenderQueue::Clear() {
+	_items.clear();
+}
+
+void RenderQueue::Reserve(size_t count) {
+	_items.reserve(count);
+}
+
+void RenderQueue::Push(uint64_t key, uint32_t payload) {
+	_items.push_back({ key, payload });
+}
+
+void RenderQueue::Sort() {
+	const size_t count = _items.size();
+	if (count < 2) {
+		return;
+	}
+
+	// Build the histograms for all 8 bytes in a single pass over the keys
+	uint32_t histograms[8][256];
+	memset(histograms, 0, sizeof(histograms));
+	for (const Item& item : _items) {
+		for (int pass = 0; pass < 8; pass++) {
+			histograms[pass][(item.Key >> (pass * 8)) & 0xFF]++;
+		}
+	}
+
+	_scratch.resize(count);
+	Item* source = _items.data();
+	Item* dest = _scratch.data();
+	for (int pass = 0; pass < 8; pass++) {
+		uint32_t* histogram = histograms[pass];
+		const int shift = pass * 8;
+
+		// If every key has the same value for this byte, this pass would not change the order
+		if (histogram[(source[0].Key >> shift) & 0xFF] == count) {
+			continue;
+		}
+
+		// Convert the counts into offsets
+		uint32_t offset = 0;
+		for (int ix = 0; ix < 256; ix++) {
+			uint32_t temp = histogram[ix];
+			histogram[ix] = offset;
+			offset += temp;
+		}
+
+		for (size_t ix = 0; ix < count; ix++) {
+			dest[histogram[(source[ix].Key >> shift) & 0xFF]++] = source[ix];
+		}
+		std::swap(source, dest);
+	}
+
+	// If we ended on the scratch buffer, swap it in as our item list
+	if (source != _items.data()) {
+		_items.swap(_scratch);
+	}
+}
@@ -0,0 +1,114 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <EnumToString.h>
+
+/// <summary>
+/// The buckets that draws are sorted into, buckets are drawn in the order they are declared
+/// </summary>
+ENUM(RenderBucket, uint8_t,
+	// Opaque draws are grouped by state, and drawn front to back within each group
+	Opaque      = 0,
+	// Transparent draws are drawn strictly back to front, and grouped by state only when at equal depth
+	Transparent = 1
+);
+
+/// <summary>
+/// A list of draws that is sorted by a 64 bit key, so that draws which share a shader, material, and mesh
+/// end up next to each other and state changes only happen once per group. The queue only stores keys
+/// and a caller defined payload (usually an index into the caller's own list of draws), so that it can
+/// be built and sorted without touching any OpenGL state
+///
+/// Key layout, from most to least significant bit:
+///   Opaque:      bucket (1) | shader (10) | material (14) | mesh (15) | depth (24)
+///   Transparent: bucket (1) | inverted depth (24) | shader (10) | material (14) | mesh (15)
+///
+/// IDs that don't fit in their fields wrap around, which only costs some batching, so callers
+/// should still check for actual state changes when submitting
+/// </summary>
+class RenderQueue {
+public:
+	static constexpr uint32_t SHADER_BITS   = 10;
+	static constexpr uint32_t MATERIAL_BITS = 14;
+	static constexpr uint32_t MESH_BITS     = 15;
+	static constexpr uint32_t DEPTH_BITS    = 24;
+
+	/// <summary>
+	/// A single entry in the queue
+	/// </summary>
+	struct Item {
+		uint64_t Key;
+		uint32_t Payload;
+	};
+
+	RenderQueue();
+	~RenderQueue() = default;
+
+	/// <summary>
+	/// Builds a sort key for a draw
+	/// </summary>
+	/// <param name="bucket">The bucket that the draw belongs to</param>
+	/// <param name="shaderId">A small ID for the draw's shader, unique within the frame</param>
+	/// <param name="materialId">A small ID for the draw's material, unique within the frame</param>
+	/// <param name="meshId">A small ID for the draw's mesh, unique within the frame</param>
+	/// <param name="depth">The distance from the camera to the object, along the view direction</param>
+	static uint64_t MakeKey(RenderBucket bucket, uint32_t shaderId, uint32_t materialId, uint32_t meshId, float depth);
+
+	/// <summary>
+	/// Gets the bucket that a key was built for
+	/// </summary>
+	static RenderBucket GetBucket(uint64_t key) { return static_cast<RenderBucket>(key >> 63); }
+
+	/// <summary>
+	/// Removes all items from the queue, keeping the allocated storage
+	/// </summary>
+	void Clear();
+	/// <summary>
+	/// Reserves space for the given number of items
+	/// </summary>
+	void Reserve(size_t count);
+	/// <summary>
+	/// Adds a new draw to the queue
+	/// </summary>
+	/// <param name="key">The sort key, from MakeKey</param>
+	/// <param name="payload">Data to associate with the draw, such as an index into a list of draw commands</param>
+	void Push(uint64_t key, uint32_t payload);
+	/// <summary>
+	/// Sorts the queue in ascending order of key using a least significant digit radix sort, the sort is stable,
+	/// and skips any byte of the key that is the same for every item
+	/// </summary>
+	void Sort();
+
+	/// <summary>
+	/// Gets the items in the queue, in sorted order if Sort has been called since the last push
+	/// </summary>
+	const std::vector<Item>& GetItems() const { return _items; }
+	size_t Size() const { return _items.size(); }
+	bool Empty() const { return _items.empty(); }
+
+	/// <summary>
+	/// Finds the end of a run of consecutive items that can be drawn together (ex: with a single instanced draw).
+	/// Keys alone can't decide this, since IDs may wrap around and opaque keys include depth
+	/// </summary>
+	/// <typeparam name="Predicate">A callable with the signature bool(const Item& first, const Item& next)</typeparam>
+	/// <param name="begin">The index of the first item in the run</param>
+	/// <param name="isSameRun">Returns true if the next item can be drawn with the run's first item</param>
+	/// <returns>The index one past the last item in the run</returns>
+	template <typename Predicate>
+	size_t GetRunEnd(size_t begin, Predicate&& isSameRun) const;
+
+protected:
+	std::vector<Item> _items;
+	// Scratch buffer that the radix sort ping-pongs with
+	std::vector<Item> _scratch;
+};
+
+template <typename Predicate>
+size_t RenderQueue::GetRunEnd(size_t begin, Predicate&& isSameRun) const {
+	size_t end = begin + 1;
+	while (end < _items.size() && isSameRun(_items[begin], _items[end])) {
+		end++;
+	}
+	return end;
+}
@@ -0,0 +1,110 @@
+#include "Graphics/RenderTargetPool.h"
+
+#include <algorithm>
+
+#include "Logging.h"
+
+RenderTargetPool::RenderTargetPool() :
+	_pool(),
+	_targets()
+{ }
+
+RenderGraph::Handle RenderTargetPool::Import(RenderGraph& graph, const std::string& name, const Framebuffer::Sptr& framebuffer) {
+	// Describe the framebuffer, so the graph can tell when a blit out of it can be dropped
+	RenderGraph::TargetDescriptor descriptor(RenderTargetType::Unknown);
+	if (framebuffer != nullptr) {
+		descriptor.FixedSize = glm::uvec2(framebuffer->GetSize());
+		for (uint32_t ix = 0; ix < RenderGraph::MAX_COLOR_TARGETS; ix++) {
+			Texture2D::Sptr texture = framebuffer->GetTextureAttachment((RenderTargetAttachment)(*RenderTargetAttachment::Color0 + ix));
+			descriptor.Color[ix] = texture != nullptr ? (RenderTargetType)*texture->GetFormat() : RenderTargetType::Unknown;
+		}
+		Texture2D::Sptr depth = framebuffer->GetTextureAttachment(RenderTargetAttachment::Depth);
+		descriptor.Depth = depth != nullptr ? (RenderTargetType)*depth->GetFormat() : RenderTargetType::Unknown;
+	}
+
+	RenderGraph::Handle handle = graph.Import(name, descriptor);
+	_targets.Import(handle, framebuffer);
+	return handle;
+}
+
+void RenderTargetPool::Realize(const RenderGraph& graph) {
+	for (PooledTarget& target : _pool) {
+		target.InUse = false;
+	}
+
+	// Hand out framebuffers in slot order, so that each slot keeps the same framebuffer from frame to frame
+	const std::vector<RenderGraph::TargetDescriptor>& slots = graph.GetSlots();
+	std::vector<Framebuffer::Sptr> slotTargets(slots.size());
+	for (size_t slot = 0; slot < slots.size(); slot++) {
+		glm::uvec2 size = slots[slot].GetSize(graph.GetScreenSize());
+
+		// Prefer a framebuffer that is already the right size, otherwise take any with the same layout and resize it
+		size_t match = _pool.size();
+		for (size_t ix = 0; ix < _pool.size(); ix++) {
+			if (_pool[ix].InUse || _pool[ix].Descriptor != slots[slot]) {
+				continue;
+			}
+			if (glm::uvec2(_pool[ix].Framebuffer->GetSize()) == size) {
+				match = ix;
+				break;
+			}
+			if (match == _pool.size()) {
+				match = ix;
+			}
+		}
+
+		if (match == _pool.size()) {
+			_pool.push_back({ slots[slot], _CreateFramebuffer(slots[slot], size), 0, false });
+		} else if (glm::uvec2(_pool[match].Framebuffer->GetSize()) != size) {
+			_pool[match].Framebuffer->Resize(size.x, size.y);
+		}
+		_pool[match].InUse = true;
+		_pool[match].UnusedFrames = 0;
+		slotTargets[slot] = _pool[match].Framebuffer;
+	}
+
+	// Look up each target's framebuffer ahead of time, including targets that were merged into an import
+	_targets.Realize(graph, slotTargets);
+
+	// Release anything that hasn't been needed in a while
+	for (PooledTarget& target : _pool) {
+		if (!target.InUse) {
+			target.UnusedFrames++;
+		}
+	}
+	_pool.erase(std::remove_if(_pool.begin(), _pool.end(), [](const PooledTarget& target) {
+		return target.UnusedFrames > MAX_UNUSED_FRAMES;
+	}), _pool.end());
+}
+
+const Framebuffer::Sptr& RenderTargetPool::Get(RenderGraph::Handle handle) const {
+	return _targets.Get(handle);
+}
+
+size_t RenderTargetPool::GetMemoryUsage() const {
+	size_t result = 0;
+	for (const PooledTarget& target : _pool) {
+		result += static_cast<size_t>(target.Framebuffer->GetWidth()) * target.Framebuffer->GetHeight() * target.Descriptor.GetPixelSize();
+	}
+	return result;
+}
+
+void RenderTargetPool::Clear() {
+	_pool.clear();
+	_targets.clear();
+}
+
+Framebuffer::Sptr RenderTargetPool::_CreateFramebuffer(const RenderGraph::TargetDescriptor& descriptor, const glm::uvec2& size) {
+	FramebufferDescriptor fboDescriptor;
+	fboDescriptor.Width = size.x;
+	fboDescriptor.Height = size.y;
+	for (uint32_t ix = 0; ix < RenderGraph::MAX_COLOR_TARGETS; ix++) {
+		if (descriptor.Color[ix] != RenderTargetType::Unknown) {
+			fboDescriptor.RenderTargets[(RenderTargetAttachment)(*RenderTargetAttachment::Color0 + ix)] = RenderTargetDescriptor(descriptor.Color[ix]);
+		}
+	}
+	if (descriptor.Depth != RenderTargetType::Unknown) {
+		fboDescriptor.RenderTargets[RenderTargetAttachment::Depth] = RenderTargetDescriptor(descriptor.Depth);
+	}
+	return std::make_shared<Framebuffer>(fboDescriptor);
+}
@@ -0,0 +1,74 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Graphics/Framebuffer.h"
+#include "Graphics/RenderGraph.h"
+#include "Graphics/RenderTargetTable.h"
+#include "Utils/Macros.h"
+
+/// <summary>
+/// Owns the framebuffers behind a RenderGraph's transient targets. Every frame, each slot of the compiled
+/// graph is given a framebuffer from the pool, re-using the framebuffers from earlier frames whenever their
+/// layout matches. New framebuffers are only created when the graph needs more slots than before, they are
+/// resized in place when the screen size changes, and ones that go unused for a while are released
+/// </summary>
+class RenderTargetPool {
+public:
+	NO_COPY(RenderTargetPool);
+	NO_MOVE(RenderTargetPool);
+
+	/// <summary>
+	/// The number of frames that a framebuffer may go unused for before it is released, so that
+	/// toggling a pass on and off doesn't keep re-creating its targets
+	/// </summary>
+	static constexpr uint32_t MAX_UNUSED_FRAMES = 60;
+
+	RenderTargetPool();
+
+	/// <summary>
+	/// Imports a framebuffer that is owned outside of the pool into a graph, so that passes can look it up with Get
+	/// </summary>
+	/// <param name="graph">The graph to import into</param>
+	/// <param name="name">The name of the target, for debugging</param>
+	/// <param name="framebuffer">The framebuffer to import, or nullptr for the default framebuffer</param>
+	RenderGraph::Handle Import(RenderGraph& graph, const std::string& name, const Framebuffer::Sptr& framebuffer);
+
+	/// <summary>
+	/// Gives a framebuffer to every slot of a compiled graph, this must be called before the graph is executed
+	/// </summary>
+	void Realize(const RenderGraph& graph);
+	/// <summary>
+	/// Gets the framebuffer for a target in the last graph that was realized, or nullptr for the default framebuffer
+	/// </summary>
+	const Framebuffer::Sptr& Get(RenderGraph::Handle handle) const;
+
+	/// <summary>
+	/// Gets the number of framebuffers that the pool is holding on to
+	/// </summary>
+	uint32_t GetFramebufferCount() const { return static_cast<uint32_t>(_pool.size()); }
+	/// <summary>
+	/// Gets the number of bytes used by all of the pool's framebuffers, ignoring any padding the driver may add
+	/// </summary>
+	size_t GetMemoryUsage() const;
+
+	/// <summary>
+	/// Releases all of the pool's framebuffers
+	/// </summary>
+	void Clear();
+
+protected:
+	struct PooledTarget {
+		RenderGraph::TargetDescriptor Descriptor;
+		Framebuffer::Sptr             Framebuffer;
+		uint32_t                      UnusedFrames;
+		bool                          InUse;
+	};
+	std::vector<PooledTarget>      _pool;
+	// The framebuffer for each handle of the last realized graph, imports are filled in as they are imported
+	RenderTargetTable<Framebuffer::Sptr> _targets;
+
+	static Framebuffer::Sptr _CreateFramebuffer(const RenderGraph::TargetDescriptor& descriptor, const glm::uvec2& size);
+};
@@ -0,0 +1,70 @@
+#pragma once
+#include <vector>
+
+#include "Logging.h"
+#include "Graphics/RenderGraph.h"
+
+/// <summary>
+/// Maps the handles of a RenderGraph to the objects that back them (ex: framebuffers). Imported targets are
+/// given their object when they are imported, transient targets get the object of the slot they were packed
+/// into, and targets that a dropped blit merged into another one get the object of the target they were merged into.
+/// Kept separate from RenderTargetPool so that it can be used without a GL context
+/// </summary>
+/// <typeparam name="T">The type of object backing each target, a default constructed T means no object</typeparam>
+template <typename T>
+class RenderTargetTable {
+public:
+	RenderTargetTable() : _values() { }
+
+	/// <summary>
+	/// Sets the object for an imported target
+	/// </summary>
+	void Import(RenderGraph::Handle handle, const T& value) {
+		if (_values.size() <= handle) {
+			_values.resize(handle + 1);
+		}
+		_values[handle] = value;
+	}
+
+	/// <summary>
+	/// Looks up the object for every target of a compiled graph
+	/// </summary>
+	/// <param name="graph">The graph to look up the targets of, must be compiled</param>
+	/// <param name="slotValues">The object for each of the graph's slots</param>
+	void Realize(const RenderGraph& graph, const std::vector<T>& slotValues) {
+		const std::vector<RenderGraph::Target>& targets = graph.GetTargets();
+		_values.resize(targets.size());
+
+		// Fill in the targets that hold their own contents first, imports were filled in when they were imported
+		for (RenderGraph::Handle handle = 0; handle < targets.size(); handle++) {
+			if (!targets[handle].IsImported && targets[handle].AliasOf == RenderGraph::INVALID_HANDLE) {
+				_values[handle] = targets[handle].Slot != RenderGraph::INVALID_HANDLE ? slotValues[targets[handle].Slot] : T();
+			}
+		}
+		// Then targets that were merged into another by a dropped blit use whatever they were merged into, which
+		// may be an import
+		for (RenderGraph::Handle handle = 0; handle < targets.size(); handle++) {
+			if (targets[handle].AliasOf != RenderGraph::INVALID_HANDLE) {
+				_values[handle] = _values[graph.Resolve(handle)];
+			}
+		}
+	}
+
+	/// <summary>
+	/// Gets the object for a target in the last graph that was realized
+	/// </summary>
+	const T& Get(RenderGraph::Handle handle) const {
+		LOG_ASSERT(handle < _values.size(), "Render target {} has not been imported or realized", handle);
+		return _values[handle];
+	}
+
+	/// <summary>
+	/// Forgets the objects for every target
+	/// </summary>
+	void Clear() {
+		_values.clear();
+	}
+
+protected:
+	std::vector<T> _values;
+};
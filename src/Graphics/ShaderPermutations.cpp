@@ -0,0 +1,99 @@
+#include "Graphics/ShaderPermutations.h"
+
+#include <algorithm>
+#include <cctype>
+
+#include "Utils/HashUtils.h"
+
+std::vector<std::string> ShaderPermutations::NormalizeKeywords(const std::vector<std::string>& keywords) {
+	std::vector<std::string> result;
+	result.reserve(keywords.size());
+	for (const std::string& keyword : keywords) {
+		if (!keyword.empty()) {
+			result.push_back(keyword);
+		}
+	}
+	std::sort(result.begin(), result.end());
+	result.erase(std::unique(result.begin(), result.end()), result.end());
+	return result;
+}
+
+std::string ShaderPermutations::GetKeywordKey(const std::vector<std::string>& keywords) {
+	std::string result;
+	for (const std::string& keyword : keywords) {
+		result += (result.empty() ? "" : ", ") + keyword;
+	}
+	return result;
+}
+
+bool ShaderPermutations::ReferencesSymbol(const std::string& source, const std::string& symbol) {
+	if (symbol.empty()) {
+		return false;
+	}
+	auto isIdentifier = [](char c) { return isalnum(static_cast<unsigned char>(c)) || c == '_'; };
+	for (size_t pos = source.find(symbol); pos != std::string::npos; pos = source.find(symbol, pos + 1)) {
+		// Make sure we've matched the whole symbol, and not part of a longer name
+		size_t end = pos + symbol.size();
+		if ((pos == 0 || !isIdentifier(source[pos - 1])) && (end == source.size() || !isIdentifier(source[end]))) {
+			return true;
+		}
+	}
+	return false;
+}
+
+std::string ShaderPermutations::InsertDefines(const std::string& source, const std::vector<std::string>& defines) {
+	// Only define the symbols that the source actually uses, so that unused keywords
+	// don't change the source and we can share programs between permutations
+	std::string defineBlock;
+	for (const std::string& define : defines) {
+		std::string symbol = define.substr(0, define.find_first_of(" \t("));
+		if (ReferencesSymbol(source, symbol)) {
+			defineBlock += "#define " + define + "\n";
+		}
+	}
+
+	// Defines must come after the #version directive, which has to be the first thing in the shader
+	std::string result = source;
+	size_t insertAt = 0;
+	size_t version = result.find("#version");
+	if (version != std::string::npos) {
+		size_t eol = result.find('\n', version);
+		if (eol == std::string::npos) {
+			result += '\n';
+			insertAt = result.size();
+		} else {
+			insertAt = eol + 1;
+		}
+	}
+	result.insert(insertAt, defineBlock);
+	return result;
+}
+
+uint64_t ShaderPermutations::GetSourceKey(const std::vector<std::pair<ShaderPartType, std::string>>& parts, const std::vector<std::string>& varyings, bool interleavedVaryings) {
+	// Sort the stages so the key does not depend on the order they were given in
+	std::vector<const std::pair<ShaderPartType, std::string>*> sorted;
+	sorted.reserve(parts.size());
+	for (const auto& part : parts) {
+		sorted.push_back(&part);
+	}
+	std::sort(sorted.begin(), sorted.end(), [](const auto* a, const auto* b) { return *a->first < *b->first; });
+
+	// The sources have their includes and defines resolved, so they capture everything that goes into the program
+	uint64_t result = HashUtils::DEFAULT_SEED;
+	for (const auto* part : sorted) {
+		result = HashUtils::Combine(result, static_cast<uint64_t>(*part->first));
+		result = HashUtils::Combine(result, HashUtils::Hash(part->second));
+	}
+	for (const std::string& name : varyings) {
+		result = HashUtils::Combine(result, HashUtils::Hash(name));
+	}
+	return HashUtils::Combine(result, interleavedVaryings ? 1 : 0);
+}
+
+uint64_t ShaderPermutations::GetDriverHash(const std::vector<std::string>& driverStrings) {
+	uint64_t result = HashUtils::DEFAULT_SEED;
+	for (const std::string& value : driverStrings) {
+		result = HashUtils::Combine(result, HashUtils::Hash(value));
+	}
+	return result;
+}
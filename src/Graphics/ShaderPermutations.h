@@ -0,0 +1,49 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Graphics/GlEnums.h"
+
+/// <summary>
+/// CPU side helpers for building shader permutations and their binary cache keys. These do not touch OpenGL,
+/// ShaderProgram reads the sources and driver strings and hands them to these
+/// </summary>
+class ShaderPermutations {
+public:
+	ShaderPermutations() = delete;
+
+	/// <summary>
+	/// Sorts a list of keywords and removes any duplicates and empty keywords, so that the order keywords
+	/// are given in does not matter
+	/// </summary>
+	static std::vector<std::string> NormalizeKeywords(const std::vector<std::string>& keywords);
+	/// <summary>
+	/// Joins a list of keywords into a single string
+	/// </summary>
+	static std::string GetKeywordKey(const std::vector<std::string>& keywords);
+	/// <summary>
+	/// Returns true if the source contains the given symbol as a whole word
+	/// </summary>
+	static bool ReferencesSymbol(const std::string& source, const std::string& symbol);
+	/// <summary>
+	/// Adds a #define for each of the given defines that the source references, right after the #version
+	/// directive (or at the very start if there isn't one). Defines may have values (ex: "COUNT 4")
+	/// </summary>
+	/// <param name="source">The shader source, with its includes resolved</param>
+	/// <param name="defines">The symbols to define</param>
+	/// <returns>The source with the defines added</returns>
+	static std::string InsertDefines(const std::string& source, const std::vector<std::string>& defines);
+
+	/// <summary>
+	/// Hashes the resolved source of each stage along with the varyings, so that any change that would
+	/// produce a different program produces a different key. The order of the stages does not matter
+	/// </summary>
+	static uint64_t GetSourceKey(const std::vector<std::pair<ShaderPartType, std::string>>& parts, const std::vector<std::string>& varyings, bool interleavedVaryings);
+	/// <summary>
+	/// Hashes the strings that identify a driver (vendor, renderer, version), so that binaries from another
+	/// driver are not loaded
+	/// </summary>
+	static uint64_t GetDriverHash(const std::vector<std::string>& driverStrings);
+};
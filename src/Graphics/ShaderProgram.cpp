@@ -3,20 +3,42 @@
 #include <fstream>
 #include <sstream>
 #include <filesystem>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <thread>
 
+#include "GLFW/glfw3.h"
+#include "Graphics/ShaderPermutations.h"
 #include "Utils/FileHelpers.h"
+#include "Utils/HashUtils.h"
 #include "Utils/JsonGlmHelpers.h"
 
+// Some drivers don't expose the parallel compile extensions in their headers, so we provide the token ourselves
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+std::string ShaderProgram::_binaryCacheDirectory = "";
+ShaderProgram::BinaryCacheStats ShaderProgram::_binaryCacheStats = ShaderProgram::BinaryCacheStats();
+std::unordered_map<uint64_t, std::weak_ptr<ShaderProgram>> ShaderProgram::_programsBySource;
+
 ShaderProgram::ShaderProgram() : 
 	IGraphicsResource(),
-	IResource()
+	IResource(),
+	_interleavedVaryings(true),
+	_isLinked(false),
+	_sourceKey(0)
 {
 	_rendererId = glCreateProgram();
 }
 
 ShaderProgram::ShaderProgram(const std::unordered_map<ShaderPartType, std::string>& filePaths) :
 	IGraphicsResource(),
-	IResource()
+	IResource(),
+	_interleavedVaryings(true),
+	_isLinked(false),
+	_sourceKey(0)
 {
 	_rendererId = glCreateProgram();
 	for (auto& [type, path] : filePaths) {
@@ -33,53 +55,20 @@ ShaderProgram::~ShaderProgram() {
 }
 
 bool ShaderProgram::LoadShaderPart(const char* source, ShaderPartType type) {
-	// Creates a new shader part (VS, FS, GS, etc...)
-	GLuint handle = glCreateShader((GLenum)type);
-
-	// Load the GLSL source and compile it
-	glShaderSource(handle, 1, &source, nullptr);
-	glCompileShader(handle);
-
-	// Get the compilation status for the shader part
-	GLint status = 0;
-	glGetShaderiv(handle, GL_COMPILE_STATUS, &status);
-
-	if (status == GL_FALSE) {
-		// Get the size of the error log
-		GLint logSize = 0;
-		glGetShaderiv(handle, GL_INFO_LOG_LENGTH, &logSize);
-
-		// Create a new character buffer for the log
-		char* log = new char[logSize];
-
-		// Get the log
-		glGetShaderInfoLog(handle, logSize, &logSize, log);
-
-		// Dump error log
-		LOG_ERROR("Failed to compile shader part:\n{}", log);
-
-		// Clean up our log memory
-		delete[] log;
-
-		// Delete the broken shader result
-		glDeleteShader(handle);
-		handle = 0;
-
-		return false;
-	}
-
-	// If we're overwriting, warn and clean up the old program before we store
-	if (_handles[type] != 0) {
+	// If we're overwriting, warn before we replace the old source
+	if (_pendingParts.find(type) != _pendingParts.end()) {
 		LOG_WARN("Another shader has been attached to this slot, overwriting");
-		glDeleteShader(_handles[type]);
 	}
-	_handles[type] = handle;
+
+	// We hold on to the source until we link, since we may not need to compile it at all
+	_pendingParts[type].Source = source;
+	_pendingParts[type].Label = "";
 
 	// Store info about where we got this data from
 	_fileSourceMap[type].IsFilePath = false;
 	_fileSourceMap[type].Source = source;
 
-	return status != GL_FALSE;
+	return true;
 }
 
 bool ShaderProgram::LoadShaderPartFromFile(const char* path, ShaderPartType type) {
@@ -92,10 +81,7 @@ bool ShaderProgram::LoadShaderPartFromFile(const char* path, ShaderPartType type
 		bool result =  LoadShaderPart(source.c_str(), type);
 		_fileSourceMap[type].IsFilePath = true;
 		_fileSourceMap[type].Source = path;
-		if (result == false) {
-			LOG_ERROR("Source File: {}", path);
-		}
-		glObjectLabel(GL_SHADER, _handles[type], -1, path);
+		_pendingParts[type].Label = path;
 		return result; 
 	} else {
 		LOG_WARN("Could not open file at \"{}\"", path);
@@ -104,63 +90,485 @@ bool ShaderProgram::LoadShaderPartFromFile(const char* path, ShaderPartType type
 }
 
 bool ShaderProgram::Link() {
+	_StartLink();
+	return _FinishLink();
+}
 
+void ShaderProgram::LinkBatch(const std::vector<ShaderProgram::Sptr>& programs) {
+	// Let the driver use as many threads as it wants, so that the compiles we're about to kick off overlap
+	bool parallel = _EnableParallelCompile();
+
+	for (const ShaderProgram::Sptr& program : programs) {
+		program->_StartLink();
+	}
+
+	// Without parallel compilation the driver has already done the work, so we can finish in order
+	if (!parallel) {
+		for (const ShaderProgram::Sptr& program : programs) {
+			program->_FinishLink();
+		}
+		return;
+	}
+
+	// Otherwise we finish programs as the driver completes them, so introspection and binary
+	// cache writes for the finished programs overlap with the ones that are still compiling
+	std::vector<ShaderProgram*> remaining;
+	remaining.reserve(programs.size());
+	for (const ShaderProgram::Sptr& program : programs) {
+		remaining.push_back(program.get());
+	}
+	while (!remaining.empty()) {
+		size_t numFinished = 0;
+		for (size_t ix = 0; ix < remaining.size();) {
+			GLint complete = GL_TRUE;
+			if (!remaining[ix]->_pendingLink.FromCache) {
+				glGetProgramiv(remaining[ix]->_rendererId, GL_COMPLETION_STATUS_KHR, &complete);
+			}
+			if (complete == GL_TRUE) {
+				remaining[ix]->_FinishLink();
+				remaining[ix] = remaining.back();
+				remaining.pop_back();
+				numFinished++;
+			} else {
+				ix++;
+			}
+		}
+		if (numFinished == 0) {
+			std::this_thread::yield();
+		}
+	}
+}
+
+void ShaderProgram::_StartLink() {
 	LOG_TRACE("Starting shader link:");
-	GLenum err = glGetError();
-	
-	// Attach all our shaders
-	for (auto& [type, id] : _handles) {
-		if (id != 0) {
-			glAttachShader(_rendererId, id);
-			LOG_TRACE("\t{} - {}", ~type, _fileSourceMap[type].IsFilePath ? _fileSourceMap[type].Source : "<from source>");
+	for (auto& [type, part] : _pendingParts) {
+		LOG_TRACE("\t{} - {}", ~type, part.Label.empty() ? "<from source>" : part.Label);
+	}
+
+	_pendingLink = PendingLink();
+	// Grab the name now, since it may come from the parts we're about to clear
+	_pendingLink.LogName = _GetLogName();
+	_pendingLink.StartTime = glfwGetTime();
+
+	// The key lets us find identical permutations, as well as our entry in the binary cache
+	_sourceKey = _GetBinaryCacheKey();
+
+	// The binary cache needs the driver to support at least one binary format
+	GLint numBinaryFormats = 0;
+	if (!_binaryCacheDirectory.empty()) {
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &numBinaryFormats);
+	}
+	_pendingLink.UseCache = numBinaryFormats > 0;
+	_pendingLink.FromCache = _pendingLink.UseCache && _LoadProgramBinary(_sourceKey, _pendingLink.CachedCompileMilliseconds);
+	if (!_pendingLink.FromCache) {
+		_StartCompile();
+	}
+
+	// We don't need the sources anymore, the program has everything it needs
+	_pendingParts.clear();
+}
+
+void ShaderProgram::_StartCompile() {
+	// Note that we don't check any statuses here, since that would wait for the driver to finish compiling
+	for (auto& [type, part] : _pendingParts) {
+		// Creates a new shader part (VS, FS, GS, etc...)
+		GLuint handle = glCreateShader((GLenum)type);
+		if (!part.Label.empty()) {
+			glObjectLabel(GL_SHADER, handle, -1, part.Label.c_str());
 		}
+
+		// Load the GLSL source and compile it
+		const char* source = part.Source.c_str();
+		glShaderSource(handle, 1, &source, nullptr);
+		glCompileShader(handle);
+
+		glAttachShader(_rendererId, handle);
+		_pendingLink.Handles.push_back({ handle, part.Label });
 	}
 
-	// Perform linking
+	// Varyings are part of the program state that linking consumes, so they need to be
+	// re-applied in case a rejected binary reset the program
+	if (!_varyings.empty()) {
+		std::vector<const char*> names;
+		names.reserve(_varyings.size());
+		for (const std::string& name : _varyings) {
+			names.push_back(name.c_str());
+		}
+		glTransformFeedbackVaryings(_rendererId, static_cast<GLsizei>(names.size()), names.data(), _interleavedVaryings ? GL_INTERLEAVED_ATTRIBS : GL_SEPARATE_ATTRIBS);
+	}
+
+	// Ask the driver to keep the binary around so we can save it to the cache
+	if (_pendingLink.UseCache) {
+		glProgramParameteri(_rendererId, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	}
+
+	// Perform linking, this will fail if any of the parts failed to compile
 	glLinkProgram(_rendererId);
-	err = glGetError();
+}
 
-	// Remove shader parts to save space (we can do this since we only needed the shader parts to compile an actual shader program)
-	for (auto& [type, id] : _handles) { 
-		if (id != 0) {
-			glDetachShader(_rendererId, id);
-			glDeleteShader(id);
+bool ShaderProgram::_FinishLink() {
+	bool linked = _pendingLink.FromCache || _FinishCompile();
+
+	float elapsedMilliseconds = static_cast<float>((glfwGetTime() - _pendingLink.StartTime) * 1000.0);
+	if (_pendingLink.FromCache) {
+		_binaryCacheStats.NumCached++;
+		_binaryCacheStats.CacheSeconds += elapsedMilliseconds / 1000.0;
+		LOG_INFO("Loaded shader \"{}\" from binary cache in {:.2f} ms (compiling took {:.2f} ms)", _pendingLink.LogName, elapsedMilliseconds, _pendingLink.CachedCompileMilliseconds);
+	} else if (linked) {
+		_binaryCacheStats.NumCompiled++;
+		_binaryCacheStats.CompileSeconds += elapsedMilliseconds / 1000.0;
+		LOG_INFO("Compiled shader \"{}\" in {:.2f} ms", _pendingLink.LogName, elapsedMilliseconds);
+		if (_pendingLink.UseCache) {
+			_SaveProgramBinary(_sourceKey, elapsedMilliseconds);
 		}
 	}
-	// Remove all the handles so we don't accidentally use them
-	_handles.clear();
 
-	err = glGetError();
+	if (linked) {
+		LOG_TRACE("Linking complete, starting introspection");
+	}
+
+	// Perform our uniform introspection to see what uniforms are in the shader
+	_Introspect();
+
+	_pendingLink = PendingLink();
+	_isLinked = linked;
+	return linked;
+}
 
+bool ShaderProgram::_FinishCompile() {
 	GLint status = 0;
 	glGetProgramiv(_rendererId, GL_LINK_STATUS, &status);
 
 	// If linking failed, figure out why
 	if (status == GL_FALSE)
 	{
-		// Get the length of the log
-		GLint length = 0;
-		glGetProgramiv(_rendererId, GL_INFO_LOG_LENGTH, &length);
-
-		if (length > 0) {
-			// Read the log from openGL
-			char* log = new char[length];
-			glGetProgramInfoLog(_rendererId, length, &length, log);
-			LOG_ERROR("Shader failed to link:\n{}", log);
-			delete[] log; 
-		} else {
-			LOG_ERROR("Shader failed to link for an unknown reason!");
+		// Linking fails if any of the parts failed to compile, in which case the part's log is more useful
+		bool compiled = true;
+		for (const auto& [handle, label] : _pendingLink.Handles) {
+			GLint compileStatus = 0;
+			glGetShaderiv(handle, GL_COMPILE_STATUS, &compileStatus);
+			if (compileStatus == GL_FALSE) {
+				// Get the size of the error log
+				GLint logSize = 0;
+				glGetShaderiv(handle, GL_INFO_LOG_LENGTH, &logSize);
+
+				// Create a new character buffer for the log
+				char* log = new char[logSize];
+
+				// Get the log
+				glGetShaderInfoLog(handle, logSize, &logSize, log);
+
+				// Dump error log
+				LOG_ERROR("Failed to compile shader part:\n{}", log);
+				if (!label.empty()) {
+					LOG_ERROR("Source File: {}", label);
+				}
+
+				// Clean up our log memory
+				delete[] log;
+				compiled = false;
+			}
+		}
+
+		if (compiled) {
+			// Get the length of the log
+			GLint length = 0;
+			glGetProgramiv(_rendererId, GL_INFO_LOG_LENGTH, &length);
+
+			if (length > 0) {
+				// Read the log from openGL
+				char* log = new char[length];
+				glGetProgramInfoLog(_rendererId, length, &length, log);
+				LOG_ERROR("Shader failed to link:\n{}", log);
+				delete[] log; 
+			} else {
+				LOG_ERROR("Shader failed to link for an unknown reason!");
+			}
 		}
-	} else {
-		LOG_TRACE("Linking complete, starting introspection");
 	}
 
-	// Perform our uniform introspection to see what uniforms are in the shader
-	_Introspect();
+	// Remove shader parts to save space (we can do this since we only needed the shader parts to compile an actual shader program)
+	for (const auto& [handle, label] : _pendingLink.Handles) {
+		glDetachShader(_rendererId, handle);
+		glDeleteShader(handle);
+	}
+	_pendingLink.Handles.clear();
 
 	return status != GL_FALSE;
 }
 
+bool ShaderProgram::_EnableParallelCompile() {
+	typedef void (APIENTRY* MaxShaderCompilerThreadsFunc)(GLuint count);
+
+	// We only need to do this once, the setting is global to the context
+	static int supported = -1;
+	if (supported == -1) {
+		supported = 0;
+		for (const char* extension : { "GL_KHR_parallel_shader_compile", "GL_ARB_parallel_shader_compile" }) {
+			if (glfwExtensionSupported(extension)) {
+				const char* function = extension[3] == 'K' ? "glMaxShaderCompilerThreadsKHR" : "glMaxShaderCompilerThreadsARB";
+				MaxShaderCompilerThreadsFunc maxThreads = reinterpret_cast<MaxShaderCompilerThreadsFunc>(glfwGetProcAddress(function));
+				if (maxThreads != nullptr) {
+					// 0xFFFFFFFF lets the driver pick the number of threads
+					maxThreads(0xFFFFFFFF);
+					supported = 1;
+					LOG_INFO("Using {} for shader compilation", extension);
+					break;
+				}
+			}
+		}
+	}
+	return supported == 1;
+}
+
+uint64_t ShaderProgram::_GetBinaryCacheKey() const {
+	std::vector<std::pair<ShaderPartType, std::string>> parts;
+	parts.reserve(_pendingParts.size());
+	for (auto& [type, part] : _pendingParts) {
+		parts.emplace_back(type, part.Source);
+	}
+	return ShaderPermutations::GetSourceKey(parts, _varyings, _interleavedVaryings);
+}
+
+bool ShaderProgram::_LoadProgramBinary(uint64_t key, float& compileMilliseconds) {
+	std::string path = _GetBinaryCachePath(key);
+	std::ifstream file(path, std::ios::binary);
+	if (!file) { return false; }
+
+	BinaryHeader header = BinaryHeader();
+	file.read(reinterpret_cast<char*>(&header), sizeof(BinaryHeader));
+	if (!file || memcmp(header.HeaderBytes, BinaryHeader().HeaderBytes, sizeof(header.HeaderBytes)) != 0 || header.Version != 0x01 ||
+		header.HeaderSize != sizeof(BinaryHeader) || header.SourceHash != key) {
+		LOG_WARN("Program binary \"{}\" has an invalid header, recompiling", path);
+		return false;
+	}
+
+	// Binaries are specific to the driver that built them, so any driver update invalidates the whole cache
+	if (header.DriverHash != _GetDriverHash()) {
+		LOG_TRACE("Program binary \"{}\" was built by a different driver, recompiling", path);
+		return false;
+	}
+
+	// The driver may also have dropped support for the format the binary was saved in
+	GLint numFormats = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &numFormats);
+	std::vector<GLint> formats(numFormats);
+	glGetIntegerv(GL_PROGRAM_BINARY_FORMATS, formats.data());
+	if (std::find(formats.begin(), formats.end(), static_cast<GLint>(header.BinaryFormat)) == formats.end()) {
+		LOG_TRACE("Program binary \"{}\" is in an unsupported format, recompiling", path);
+		return false;
+	}
+
+	std::vector<char> binary(header.BinarySize);
+	file.read(binary.data(), binary.size());
+	if (!file || HashUtils::Hash(binary.data(), binary.size()) != header.Checksum) {
+		LOG_WARN("Program binary \"{}\" failed checksum validation, recompiling", path);
+		return false;
+	}
+
+	// The driver can still reject a binary for its own reasons, in which case the program acts as if linking failed
+	glProgramBinary(_rendererId, header.BinaryFormat, binary.data(), static_cast<GLsizei>(binary.size()));
+	GLint status = 0;
+	glGetProgramiv(_rendererId, GL_LINK_STATUS, &status);
+	if (status == GL_FALSE) {
+		LOG_TRACE("Program binary \"{}\" was rejected by the driver, recompiling", path);
+		return false;
+	}
+
+	compileMilliseconds = header.CompileMilliseconds;
+	return true;
+}
+
+void ShaderProgram::_SaveProgramBinary(uint64_t key, float compileMilliseconds) {
+	GLint length = 0;
+	glGetProgramiv(_rendererId, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0) {
+		return;
+	}
+
+	std::vector<char> binary(length);
+	GLenum format = 0;
+	glGetProgramBinary(_rendererId, length, &length, &format, binary.data());
+	binary.resize(length);
+
+	BinaryHeader header = BinaryHeader();
+	header.HeaderSize          = sizeof(BinaryHeader);
+	header.BinaryFormat        = format;
+	header.BinarySize          = static_cast<uint32_t>(binary.size());
+	header.DriverHash          = _GetDriverHash();
+	header.SourceHash          = key;
+	header.Checksum            = HashUtils::Hash(binary.data(), binary.size());
+	header.CompileMilliseconds = compileMilliseconds;
+
+	std::error_code error;
+	std::filesystem::create_directories(_binaryCacheDirectory, error);
+
+	// Write to a temporary file first, so that a crash mid-write never leaves a partial binary behind
+	std::string path = _GetBinaryCachePath(key);
+	std::string tempFile = path + ".tmp";
+	{
+		std::ofstream file(tempFile, std::ios::binary);
+		if (!file) {
+			LOG_WARN("Failed to open program binary \"{}\" for writing", tempFile);
+			return;
+		}
+		file.write(reinterpret_cast<const char*>(&header), sizeof(BinaryHeader));
+		file.write(binary.data(), binary.size());
+		if (!file) {
+			LOG_WARN("Failed to write program binary \"{}\"", tempFile);
+			return;
+		}
+	}
+
+	std::filesystem::rename(tempFile, path, error);
+	if (error) {
+		LOG_WARN("Failed to replace program binary \"{}\": {}", path, error.message());
+		std::filesystem::remove(tempFile, error);
+	}
+}
+
+std::string ShaderProgram::_GetLogName() const {
+	if (!_debugName.empty()) {
+		return _debugName;
+	}
+	std::string result;
+	for (auto& [type, part] : _pendingParts) {
+		result += (result.empty() ? "" : ", ") + (part.Label.empty() ? std::string("<from source>") : part.Label);
+	}
+	return result;
+}
+
+void ShaderProgram::SetBinaryCacheDirectory(const std::string& directory) {
+	_binaryCacheDirectory = directory;
+}
+
+std::string ShaderProgram::_GetBinaryCachePath(uint64_t key) {
+	char name[32];
+	snprintf(name, sizeof(name), "%016llx.bprog", static_cast<unsigned long long>(key));
+	return (std::filesystem::path(_binaryCacheDirectory) / name).string();
+}
+
+uint64_t ShaderProgram::_GetDriverHash() {
+	static uint64_t result = 0;
+	if (result == 0) {
+		std::vector<std::string> driverStrings;
+		for (GLenum name : { GL_VENDOR, GL_RENDERER, GL_VERSION, GL_SHADING_LANGUAGE_VERSION }) {
+			const char* value = reinterpret_cast<const char*>(glGetString(name));
+			driverStrings.push_back(value != nullptr ? value : "");
+		}
+		result = ShaderPermutations::GetDriverHash(driverStrings);
+	}
+	return result;
+}
+
+ShaderProgram::Sptr ShaderProgram::GetPermutation(const std::vector<std::string>& keywords) {
+	return CompilePermutations({ keywords })[0];
+}
+
+std::vector<ShaderProgram::Sptr> ShaderProgram::CompilePermutations(const std::vector<std::vector<std::string>>& keywordSets) {
+	// Permutations of a permutation are built from the original shader, with the keywords combined
+	ShaderProgram::Sptr base = _base.lock();
+	if (base != nullptr) {
+		std::vector<std::vector<std::string>> combined = keywordSets;
+		for (std::vector<std::string>& keywords : combined) {
+			keywords.insert(keywords.end(), _keywords.begin(), _keywords.end());
+		}
+		return base->CompilePermutations(combined);
+	}
+
+	std::vector<ShaderProgram::Sptr> result(keywordSets.size());
+	std::vector<ShaderProgram::Sptr> toLink;
+	for (size_t ix = 0; ix < keywordSets.size(); ix++) {
+		std::vector<std::string> keywords = ShaderPermutations::NormalizeKeywords(keywordSets[ix]);
+		std::string name = ShaderPermutations::GetKeywordKey(keywords);
+
+		// If we've already built this permutation, we can return it right away
+		auto it = _permutations.find(name);
+		if (it != _permutations.end()) {
+			result[ix] = it->second.IsBase ? shared_from_this() : it->second.Program;
+			continue;
+		}
+		Permutation& permutation = _permutations[name];
+
+		// Keywords that none of our stages use are dropped while generating the sources, so the
+		// permutation may turn out to be identical to this program or to one we've already built
+		ShaderProgram::Sptr program = _CreatePermutationProgram(keywords);
+		uint64_t key = program->_GetBinaryCacheKey();
+		if (_isLinked && key == _sourceKey) {
+			permutation.IsBase = true;
+			result[ix] = shared_from_this();
+			continue;
+		}
+		auto existing = _programsBySource.find(key);
+		if (existing != _programsBySource.end() && !existing->second.expired()) {
+			permutation.Program = existing->second.lock();
+			result[ix] = permutation.Program;
+			continue;
+		}
+
+		program->_base = weak_from_this();
+		program->_keywords = keywords;
+		_programsBySource[key] = program;
+		permutation.Program = program;
+		result[ix] = program;
+		toLink.push_back(program);
+	}
+
+	if (!toLink.empty()) {
+		// Permutations that have since been freed leave expired entries behind, clear them out while we're adding new ones
+		for (auto it = _programsBySource.begin(); it != _programsBySource.end(); ) {
+			it = it->second.expired() ? _programsBySource.erase(it) : std::next(it);
+		}
+
+		LinkBatch(toLink);
+
+		// Don't hand out programs that failed to link, and make sure we don't find them again
+		for (const ShaderProgram::Sptr& program : toLink) {
+			if (!program->_isLinked) {
+				LOG_ERROR("Failed to link permutation [{}] of shader \"{}\"", ShaderPermutations::GetKeywordKey(program->_keywords), GetDebugName());
+				_programsBySource.erase(program->_sourceKey);
+			}
+		}
+		for (auto& [name, permutation] : _permutations) {
+			if (permutation.Program != nullptr && !permutation.Program->_isLinked) {
+				permutation.Program = nullptr;
+			}
+		}
+		for (ShaderProgram::Sptr& program : result) {
+			if (program != nullptr && !program->_isLinked) {
+				program = nullptr;
+			}
+		}
+	}
+
+	return result;
+}
+
+ShaderProgram::Sptr ShaderProgram::_CreatePermutationProgram(const std::vector<std::string>& defines) const {
+	ShaderProgram::Sptr result = ShaderProgram::Create();
+	result->SetDebugName(GetDebugName() + " [" + ShaderPermutations::GetKeywordKey(defines) + "]");
+	result->_varyings = _varyings;
+	result->_interleavedVaryings = _interleavedVaryings;
+
+	for (const auto& [type, source] : _fileSourceMap) {
+		// Each stage only gets the defines that it actually uses, so that unused keywords don't change
+		// the source and we can share programs between permutations
+		std::string code = source.IsFilePath ? FileHelpers::ReadResolveIncludes(source.Source) : source.Source;
+		code = ShaderPermutations::InsertDefines(code, defines);
+
+		result->LoadShaderPart(code.c_str(), type);
+		if (source.IsFilePath) {
+			result->_pendingParts[type].Label = source.Source;
+		}
+	}
+
+	return result;
+}
+
+int ShaderProgram::GetAttributeLocation(const std::string& name) const {
+	return glGetAttribLocation(_rendererId, name.c_str());
+}
+
 void ShaderProgram::Bind() {
 	// Simply calls glUseProgram with our shader handle
 	glUseProgram(_rendererId);
@@ -478,17 +886,21 @@ void ShaderProgram::_IntrospectUnifromBlocks() {
 				GL_NAME_LENGTH,
 				GL_TYPE,
 				GL_ARRAY_SIZE,
-				GL_OFFSET
+				GL_OFFSET,
+				GL_ARRAY_STRIDE,
+				GL_MATRIX_STRIDE
 			};
 			// Query data from the program
-			int props[4];
-			glGetProgramResourceiv(_rendererId, GL_UNIFORM, activeVars[v], 4, pNames, 4, NULL, props);
+			int props[6];
+			glGetProgramResourceiv(_rendererId, GL_UNIFORM, activeVars[v], 6, pNames, 6, NULL, props);
 
 			// Store properties into the UniformInfo
 			UniformInfo var = UniformInfo();
 			var.Type = FromGLShaderDataType(props[1]);
 			var.Location = props[3];
 			var.ArraySize = props[2];
+			var.ArrayStride = props[4];
+			var.MatrixStride = props[5];
 
 			// Get the uniform name
 			var.Name.resize(props[0] - 1);
@@ -537,5 +949,7 @@ GlResourceType ShaderProgram::GetResourceClass() const {
 
 void ShaderProgram::RegisterVaryings(const char* const* names, int numVaryings, bool interleaved /*= true*/)
 {
-	glTransformFeedbackVaryings(_rendererId, numVaryings, names, interleaved ? GL_INTERLEAVED_ATTRIBS : GL_SEPARATE_ATTRIBS);
+	// These get applied when we link, since they're also part of the binary cache key
+	_varyings.assign(names, names + numVaryings);
+	_interleavedVaryings = interleaved;
 }
@@ -15,7 +15,7 @@
 /// <summary>
 /// This class will wrap around an OpenGL shader program
 /// </summary>
-class ShaderProgram final : public IGraphicsResource, public IResource
+class ShaderProgram final : public IGraphicsResource, public IResource, public std::enable_shared_from_this<ShaderProgram>
 {
 public:
 	DEFINE_RESOURCE(ShaderProgram);
@@ -31,6 +31,9 @@ public:
 		int            ArraySize;
 		int            Location;
 		int            Binding;
+		// For uniforms in a block, the distance in bytes between array elements and matrix columns
+		int            ArrayStride;
+		int            MatrixStride;
 		std::string    Name;
 
 		UniformInfo() :
@@ -38,6 +41,8 @@ public:
 			ArraySize(0),
 			Location(-1),
 			Binding(-1),
+			ArrayStride(0),
+			MatrixStride(0),
 			Name("") {}
 	};
 
@@ -57,6 +62,17 @@ public:
 
 		std::vector<UniformInfo> SubUniforms;
 	};
+
+	/// <summary>
+	/// Counts how many programs were loaded from the program binary cache, and how
+	/// long we spent loading them compared to the programs that had to be compiled
+	/// </summary>
+	struct BinaryCacheStats {
+		uint32_t NumCompiled = 0;
+		uint32_t NumCached = 0;
+		double   CompileSeconds = 0.0;
+		double   CacheSeconds = 0.0;
+	};
 	
 public:
 	/// <summary>
@@ -71,6 +87,7 @@ public:
 
 	/// <summary>
 	/// Loads a single shader stage into this shader object (ex: Vertex Shader or Fragment Shader)
+	/// Compilation is deferred until Link, so that we can skip it entirely if the program is in the binary cache
 	/// </summary>
 	/// <param name="source">The source code of the shader to load</param>
 	/// <param name="type">The stage to load (GL_VERTEX_SHADER or GL_FRAGMENT_SHADER)</param>
@@ -93,11 +110,54 @@ public:
 	void RegisterVaryings(const char* const* names, int numVaryings, bool interleaved = true);
 
 	/// <summary>
-	/// Links the vertex and fragment shader, and allows this shader program to be used
+	/// Links the vertex and fragment shader, and allows this shader program to be used. If the binary cache
+	/// is enabled, the program is loaded from there when possible, otherwise the parts are compiled and
+	/// the linked binary is saved to the cache for next time
 	/// </summary>
 	/// <returns>True if the linking was successful, false if otherwise</returns>
 	bool Link();
 
+	/// <summary>
+	/// Gets the permutation of this shader with the given keywords defined, compiling it the first time
+	/// it is requested. Keywords that none of the stages reference are ignored, so permutations that
+	/// end up with identical sources share a single program. Calling this on a permutation combines
+	/// its keywords with the permutation's own
+	/// </summary>
+	/// <param name="keywords">The symbols to define, in any order, ex: "INSTANCED" or "ALPHA_TEST"</param>
+	/// <returns>The permutation, this program if none of the keywords are used, or nullptr if it failed to compile</returns>
+	ShaderProgram::Sptr GetPermutation(const std::vector<std::string>& keywords);
+	/// <summary>
+	/// Gets several permutations of this shader at once, compiling any that we don't have yet as a single
+	/// batch so that their compiles can overlap. Useful for warming up permutations during loading
+	/// </summary>
+	/// <param name="keywordSets">The set of keywords for each permutation</param>
+	/// <returns>The permutation for each set of keywords, see GetPermutation</returns>
+	std::vector<ShaderProgram::Sptr> CompilePermutations(const std::vector<std::vector<std::string>>& keywordSets);
+	/// <summary>
+	/// Gets the keywords that this permutation was compiled with, empty if this is not a permutation
+	/// </summary>
+	const std::vector<std::string>& GetKeywords() const { return _keywords; }
+
+	/// <summary>
+	/// Links a group of programs that have all had their parts loaded. All the compiles are issued before
+	/// we wait on any of them, so drivers that support parallel shader compilation can work on them at
+	/// the same time
+	/// </summary>
+	/// <param name="programs">The programs to link</param>
+	static void LinkBatch(const std::vector<ShaderProgram::Sptr>& programs);
+
+	/// <summary>
+	/// Returns true if the program has been successfully linked
+	/// </summary>
+	bool IsLinked() const { return _isLinked; }
+
+	/// <summary>
+	/// Gets the location of a vertex attribute in the linked program
+	/// </summary>
+	/// <param name="name">The name of the attribute in the vertex shader</param>
+	/// <returns>The location of the attribute, or -1 if it is not an active attribute</returns>
+	int GetAttributeLocation(const std::string& name) const;
+
 	/// <summary>
 	/// Binds this shader for use
 	/// </summary>
@@ -108,6 +168,25 @@ public:
 	static void Unbind();
 
 	const std::unordered_map<std::string, UniformInfo>& GetUniforms() const { return _uniforms; }
+	/// <summary>
+	/// Gets the uniform blocks in the program, the Location of each uniform in a block is its offset in bytes
+	/// </summary>
+	const std::unordered_map<std::string, UniformBlockInfo>& GetUniformBlocks() const { return _uniformBlocks; }
+
+	/// <summary>
+	/// Sets the directory that linked program binaries are cached in, pass an empty
+	/// string to disable the cache. Programs are keyed on the hash of their fully
+	/// resolved sources, so editing a shader or one of its includes will miss the cache
+	/// </summary>
+	static void SetBinaryCacheDirectory(const std::string& directory);
+	/// <summary>
+	/// Gets the directory that program binaries are cached in, empty if the cache is disabled
+	/// </summary>
+	static const std::string& GetBinaryCacheDirectory() { return _binaryCacheDirectory; }
+	/// <summary>
+	/// Gets the number of programs that have been compiled vs loaded from the binary cache since startup
+	/// </summary>
+	static const BinaryCacheStats& GetBinaryCacheStats() { return _binaryCacheStats; }
 
 	// Inherited from IGraphicsResource
 
@@ -177,13 +256,83 @@ public:
 			LOG_WARN("Ignoring uniform \"{}\"", name);
 		}
 	}
+	template <typename T>
+	void SetUniformMatrix(const std::string& name, const T* values, int count, bool transposed = false) {
+		int location = __GetUniformLocation(name);
+		if (location != -1) {
+			SetUniformMatrix(location, values, count, transposed);
+		} else {
+			LOG_WARN("Ignoring uniform \"{}\"", name);
+		}
+	}
 	
 	void BindUniformBlockToSlot(const std::string& name, int uboSlot);
 
 protected:
-	// Stores all the handles to our shaders until we
-	// are ready to compile them into a program
-	std::unordered_map<ShaderPartType, int> _handles;
+	// Header for a cached program binary, followed by the binary itself
+	struct alignas(16) BinaryHeader {
+		// A check value so we can ensure that we're loading in the right file type
+		char      HeaderBytes[4] = { 'B', 'P', 'R', 'G' };
+		// The version code, we can use this to create different loaders if our format changes
+		uint16_t  Version = 0x01;
+		// The size of this header, in bytes
+		uint16_t  HeaderSize = 0;
+		// The format returned by glGetProgramBinary, and the size of the binary in bytes
+		uint32_t  BinaryFormat = 0;
+		uint32_t  BinarySize = 0;
+		// Hash of the vendor, renderer and version strings, binaries are only valid for the driver that made them
+		uint64_t  DriverHash = 0;
+		// The key the program was cached under, see _GetBinaryCacheKey
+		uint64_t  SourceHash = 0;
+		// Hash of the binary data
+		uint64_t  Checksum = 0;
+		// How long the program took to compile and link, so we can report what the cache saved us
+		float     CompileMilliseconds = 0.0f;
+	};
+	static_assert(sizeof(BinaryHeader) == 48, "BinaryHeader layout has changed, update the version number!");
+
+	// The source of each shader stage, kept until we either compile
+	// them or load the linked program from the binary cache
+	struct PendingPart {
+		std::string Source;
+		// Used to label the shader part in error logs and graphics debuggers
+		std::string Label;
+	};
+	std::unordered_map<ShaderPartType, PendingPart> _pendingParts;
+
+	// The transform feedback varyings to capture, see RegisterVaryings
+	std::vector<std::string> _varyings;
+	bool                     _interleavedVaryings;
+
+	// State for a link that has been started but not finished, see _StartLink
+	struct PendingLink {
+		struct Part {
+			GLuint      Handle;
+			std::string Label;
+		};
+		std::vector<Part> Handles;
+		std::string       LogName;
+		double            StartTime = 0.0;
+		float             CachedCompileMilliseconds = 0.0f;
+		bool              FromCache = false;
+		bool              UseCache = false;
+	};
+	PendingLink _pendingLink;
+	bool        _isLinked;
+	// The hash of the sources the program was linked from, see _GetBinaryCacheKey
+	uint64_t    _sourceKey;
+
+	// A permutation that we have built, see GetPermutation
+	struct Permutation {
+		// The linked permutation, nullptr if it failed to compile or is identical to this program
+		ShaderProgram::Sptr Program;
+		bool                IsBase = false;
+	};
+	// Our permutations, keyed by their sorted list of keywords
+	std::unordered_map<std::string, Permutation> _permutations;
+	// If this is a permutation, the program it was built from and the keywords it was built with
+	std::weak_ptr<ShaderProgram> _base;
+	std::vector<std::string>     _keywords;
 	
 	// Map access to look up uniform locations and blocks
 	std::unordered_map<std::string, UniformInfo> _uniforms;
@@ -213,5 +362,71 @@ protected:
 	/// </summary>
 	void _IntrospectUnifromBlocks();
 
+	/// <summary>
+	/// Starts linking the program, either by loading it from the binary cache or by issuing the
+	/// compile and link commands. Must be followed by _FinishLink
+	/// </summary>
+	void _StartLink();
+	/// <summary>
+	/// Issues the compile commands for all pending parts and links them, without waiting for the results
+	/// </summary>
+	void _StartCompile();
+	/// <summary>
+	/// Waits for a link started with _StartLink, reports any errors and performs introspection
+	/// </summary>
+	/// <returns>True if the program linked</returns>
+	bool _FinishLink();
+	/// <summary>
+	/// Checks the result of _StartCompile, logging errors from the parts or the link and cleaning up the parts
+	/// </summary>
+	/// <returns>True if all the parts compiled and the program linked</returns>
+	bool _FinishCompile();
+	/// <summary>
+	/// Creates an unlinked program with our parts loaded, and the given symbols defined in each stage that uses them
+	/// </summary>
+	ShaderProgram::Sptr _CreatePermutationProgram(const std::vector<std::string>& defines) const;
+	/// <summary>
+	/// Hashes the resolved source of each pending part along with the varyings, see ShaderPermutations::GetSourceKey
+	/// </summary>
+	uint64_t _GetBinaryCacheKey() const;
+	/// <summary>
+	/// Tries to load the program from the binary cache, returns false if the cached binary
+	/// is missing, stale, or was rejected by the driver
+	/// </summary>
+	/// <param name="key">The key from _GetBinaryCacheKey</param>
+	/// <param name="compileMilliseconds">Set to how long the program took to compile when it was cached</param>
+	bool _LoadProgramBinary(uint64_t key, float& compileMilliseconds);
+	/// <summary>
+	/// Saves the linked program to the binary cache
+	/// </summary>
+	/// <param name="key">The key from _GetBinaryCacheKey</param>
+	/// <param name="compileMilliseconds">How long the program took to compile and link</param>
+	void _SaveProgramBinary(uint64_t key, float compileMilliseconds);
+	/// <summary>
+	/// Gets the name to use for this program in logs, falling back to the source files
+	/// if the program has not been given a debug name
+	/// </summary>
+	std::string _GetLogName() const;
+
+	/// <summary>
+	/// Gets the path of the binary cache file for a given key
+	/// </summary>
+	static std::string _GetBinaryCachePath(uint64_t key);
+	/// <summary>
+	/// Hashes the strings that identify the current driver, computed once and then reused
+	/// </summary>
+	static uint64_t _GetDriverHash();
+
+	/// <summary>
+	/// Tells the driver to compile shaders on multiple threads if it supports it
+	/// </summary>
+	/// <returns>True if the driver supports parallel shader compilation</returns>
+	static bool _EnableParallelCompile();
+
+	static std::string      _binaryCacheDirectory;
+	static BinaryCacheStats _binaryCacheStats;
+	// All the permutations that are alive, keyed on the hash of their sources so that identical permutations can be shared
+	static std::unordered_map<uint64_t, std::weak_ptr<ShaderProgram>> _programsBySource;
+
 	int __GetUniformLocation(const std::string& name);
 };
\ No newline at end of file
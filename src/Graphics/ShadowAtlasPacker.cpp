@@ -0,0 +1,122 @@
+#include "Graphics/ShadowAtlasPacker.h"
+
+#include <algorithm>
+#include <numeric>
+
+#include "Logging.h"
+
+ShadowAtlasPacker::ShadowAtlasPacker(uint32_t atlasSize) :
+	_atlasSize(atlasSize),
+	_requests(),
+	_tiles(),
+	_droppedCount(0),
+	_sizes()
+{
+	LOG_ASSERT(atlasSize >= MIN_TILE_SIZE, "Shadow atlas must be at least {} pixels across", MIN_TILE_SIZE);
+}
+
+bool ShadowAtlasPacker::Update(const std::vector<Request>& requests) {
+	// Importance changes all the time as the camera moves, so only the owners and sizes decide if we need to re-pack
+	bool changed = requests.size() != _requests.size();
+	for (size_t ix = 0; !changed && ix < requests.size(); ix++) {
+		changed = requests[ix].Owner != _requests[ix].Owner || requests[ix].Size != _requests[ix].Size;
+	}
+	if (!changed) {
+		return false;
+	}
+
+	_requests = requests;
+	_Pack();
+	return true;
+}
+
+bool ShadowAtlasPacker::PackShelves(uint32_t atlasSize, const std::vector<glm::uvec2>& sizes, std::vector<glm::uvec4>& result) {
+	result.assign(sizes.size(), glm::uvec4(0));
+
+	// Packing the tallest tiles first keeps the shelves full, with pow2 sized tiles there's no wasted space at all
+	std::vector<uint32_t> order(sizes.size());
+	std::iota(order.begin(), order.end(), 0);
+	std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+		return sizes[a].y != sizes[b].y ? sizes[a].y > sizes[b].y : sizes[a].x > sizes[b].x;
+	});
+
+	struct Shelf {
+		uint32_t Y;
+		uint32_t Height;
+		uint32_t Cursor;
+	};
+	std::vector<Shelf> shelves;
+	uint32_t top = 0;
+
+	for (uint32_t ix : order) {
+		const glm::uvec2& size = sizes[ix];
+		if (size.x == 0 || size.y == 0) {
+			continue;
+		}
+		if (size.x > atlasSize || size.y > atlasSize) {
+			return false;
+		}
+
+		// Use the first shelf that the tile fits on, or start a new shelf above the others
+		Shelf* shelf = nullptr;
+		for (Shelf& candidate : shelves) {
+			if (size.y <= candidate.Height && candidate.Cursor + size.x <= atlasSize) {
+				shelf = &candidate;
+				break;
+			}
+		}
+		if (shelf == nullptr) {
+			if (top + size.y > atlasSize) {
+				return false;
+			}
+			shelves.push_back({ top, size.y, 0 });
+			shelf = &shelves.back();
+			top += size.y;
+		}
+
+		result[ix] = glm::uvec4(shelf->Cursor, shelf->Y, size.x, size.y);
+		shelf->Cursor += size.x;
+	}
+	return true;
+}
+
+void ShadowAtlasPacker::_Pack() {
+	_sizes.resize(_requests.size());
+	for (size_t ix = 0; ix < _requests.size(); ix++) {
+		_sizes[ix] = glm::min(_requests[ix].Size, glm::uvec2(_atlasSize));
+	}
+
+	_droppedCount = 0;
+	while (!PackShelves(_atlasSize, _sizes, _tiles)) {
+		// Halve the tile that has the least importance for the number of pixels it uses, so that unimportant
+		// lights shrink first but no light ends up much larger than its importance warrants. Once nothing
+		// can shrink any more, the least important tiles are dropped entirely
+		size_t shrink = _sizes.size();
+		size_t drop = _sizes.size();
+		float shrinkScore = 0.0f;
+		for (size_t ix = 0; ix < _sizes.size(); ix++) {
+			if (_sizes[ix].x == 0) {
+				continue;
+			}
+			float score = std::max(_requests[ix].Importance, 1e-6f) / (static_cast<float>(_sizes[ix].x) * _sizes[ix].y);
+			if (glm::max(_sizes[ix].x, _sizes[ix].y) > MIN_TILE_SIZE && (shrink == _sizes.size() || score < shrinkScore)) {
+				shrink = ix;
+				shrinkScore = score;
+			}
+			if (drop == _sizes.size() || _requests[ix].Importance < _requests[drop].Importance) {
+				drop = ix;
+			}
+		}
+
+		if (shrink != _sizes.size()) {
+			_sizes[shrink] = glm::max(_sizes[shrink] / 2u, glm::uvec2(1));
+		} else {
+			_sizes[drop] = glm::uvec2(0);
+			_droppedCount++;
+		}
+	}
+
+	if (_droppedCount > 0) {
+		LOG_WARN("Shadow atlas is full, {} of {} shadowed lights will not be drawn", _droppedCount, _requests.size());
+	}
+}
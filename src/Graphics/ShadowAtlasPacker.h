@@ -0,0 +1,86 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <GLM/glm.hpp>
+
+#include "Utils/Macros.h"
+
+/// <summary>
+/// Splits a square shadow atlas into one rectangular tile per shadowed light. Tiles are packed onto
+/// shelves, tallest first, and if they don't all fit then the least important tiles are halved in size
+/// until they do. The layout is only rebuilt when the set of requested tiles changes, so that lights
+/// keep their tiles (and any cached depth in them) from frame to frame
+///
+/// Does not touch OpenGL
+/// </summary>
+class ShadowAtlasPacker {
+public:
+	NO_COPY(ShadowAtlasPacker);
+	NO_MOVE(ShadowAtlasPacker);
+
+	/// <summary>
+	/// The smallest size that a tile will be shrunk to before we give up on fitting it
+	/// </summary>
+	static constexpr uint32_t MIN_TILE_SIZE = 64;
+
+	/// <summary>
+	/// A tile that a light would like to have
+	/// </summary>
+	struct Request {
+		// Identifies the light that wants the tile, only used to tell when the requests change
+		const void* Owner;
+		// The size of the tile, in pixels
+		glm::uvec2  Size;
+		// How much the light matters on screen, less important tiles are shrunk first
+		float       Importance;
+	};
+
+	/// <summary>
+	/// Creates a new packer for an atlas of the given size
+	/// </summary>
+	/// <param name="atlasSize">The width and height of the atlas, in pixels</param>
+	ShadowAtlasPacker(uint32_t atlasSize);
+
+	/// <summary>
+	/// Gets the width and height of the atlas, in pixels
+	/// </summary>
+	uint32_t GetAtlasSize() const { return _atlasSize; }
+
+	/// <summary>
+	/// Lays out the tiles for a set of requests, re-using the last layout if the requests have not changed
+	/// </summary>
+	/// <param name="requests">The tiles that are wanted this frame</param>
+	/// <returns>True if the layout has changed since the last update</returns>
+	bool Update(const std::vector<Request>& requests);
+
+	/// <summary>
+	/// Gets the tile for each request from the last update, in the same order as the requests. Tiles
+	/// are stored as (x, y, width, height) in pixels, a tile with a width of 0 could not be fit in the atlas
+	/// </summary>
+	const std::vector<glm::uvec4>& GetTiles() const { return _tiles; }
+	/// <summary>
+	/// Gets the number of requests that could not be given a tile in the last update
+	/// </summary>
+	uint32_t GetDroppedCount() const { return _droppedCount; }
+
+	/// <summary>
+	/// Packs a set of tile sizes onto shelves, without shrinking anything
+	/// </summary>
+	/// <param name="atlasSize">The width and height of the atlas, in pixels</param>
+	/// <param name="sizes">The sizes of the tiles to pack</param>
+	/// <param name="result">The packed tiles, in the same order as sizes</param>
+	/// <returns>True if every tile fit in the atlas</returns>
+	static bool PackShelves(uint32_t atlasSize, const std::vector<glm::uvec2>& sizes, std::vector<glm::uvec4>& result);
+
+protected:
+	uint32_t                _atlasSize;
+	std::vector<Request>    _requests;
+	std::vector<glm::uvec4> _tiles;
+	uint32_t                _droppedCount;
+
+	// Scratch space for packing
+	std::vector<glm::uvec2> _sizes;
+
+	void _Pack();
+};
@@ -0,0 +1,97 @@
+#include "Graphics/ShadowCascades.h"
+
+#include <cmath>
+#include <GLM/gtc/matrix_transform.hpp>
+
+#include "Logging.h"
+
+void ShadowCascades::ComputeSplits(float zNear, float zFar, uint32_t count, float lambda, float* splits) {
+	LOG_ASSERT(zNear > 0.0f && zFar > zNear, "Cascade depth range must be positive and non-empty");
+	LOG_ASSERT(count > 0 && count <= MAX_CASCADES, "Cascade count must be between 1 and {}", MAX_CASCADES);
+
+	splits[0] = zNear;
+	for (uint32_t ix = 1; ix < count; ix++) {
+		float t = static_cast<float>(ix) / count;
+		float logSplit = zNear * std::pow(zFar / zNear, t);
+		float uniformSplit = zNear + (zFar - zNear) * t;
+		splits[ix] = lambda * logSplit + (1.0f - lambda) * uniformSplit;
+	}
+	splits[count] = zFar;
+}
+
+void ShadowCascades::GetSliceCorners(
+	const glm::mat4& cameraTransform, const glm::mat4& cameraProjection,
+	float splitNear, float splitFar, glm::vec3* corners)
+{
+	static const glm::vec2 ndcCorners[4] = {
+		{ -1.0f, -1.0f }, { 1.0f, -1.0f }, { 1.0f, 1.0f }, { -1.0f, 1.0f }
+	};
+
+	glm::mat4 invProjection = glm::inverse(cameraProjection);
+	for (int ix = 0; ix < 4; ix++) {
+		// Find the edge of the frustum that runs through this corner, in view space
+		glm::vec4 nearPoint = invProjection * glm::vec4(ndcCorners[ix], -1.0f, 1.0f);
+		glm::vec4 farPoint = invProjection * glm::vec4(ndcCorners[ix], 1.0f, 1.0f);
+		glm::vec3 edgeStart = glm::vec3(nearPoint) / nearPoint.w;
+		glm::vec3 edgeEnd = glm::vec3(farPoint) / farPoint.w;
+
+		// Depth is linear along the edge, so we can slide along it to the split depths
+		float deltaZ = edgeEnd.z - edgeStart.z;
+		float tNear = (-splitNear - edgeStart.z) / deltaZ;
+		float tFar = (-splitFar - edgeStart.z) / deltaZ;
+
+		corners[ix]     = cameraTransform * glm::vec4(glm::mix(edgeStart, edgeEnd, tNear), 1.0f);
+		corners[ix + 4] = cameraTransform * glm::vec4(glm::mix(edgeStart, edgeEnd, tFar), 1.0f);
+	}
+}
+
+ShadowCascades::Cascade ShadowCascades::FitCascade(
+	const glm::mat4& cameraTransform, const glm::mat4& cameraProjection,
+	float splitNear, float splitFar,
+	const glm::mat4& lightTransform, uint32_t resolution, float casterDistance)
+{
+	LOG_ASSERT(resolution > 0, "Cascade resolution must be > 0");
+
+	glm::vec3 corners[8];
+	GetSliceCorners(cameraTransform, cameraProjection, splitNear, splitFar, corners);
+
+	// Fit a sphere instead of a box, so that the size of the cascade doesn't change as the camera turns
+	glm::vec3 center = glm::vec3(0.0f);
+	for (const glm::vec3& corner : corners) {
+		center += corner;
+	}
+	center /= 8.0f;
+	float radius = 0.0f;
+	for (const glm::vec3& corner : corners) {
+		radius = glm::max(radius, glm::length(corner - center));
+	}
+	// Round the radius up, so that floating point noise doesn't change the texel size from frame to frame
+	radius = std::ceil(radius * 16.0f) / 16.0f;
+
+	// Only the light's rotation matters, strip any scale from it
+	glm::mat3 lightRotation = glm::mat3(
+		glm::normalize(glm::vec3(lightTransform[0])),
+		glm::normalize(glm::vec3(lightTransform[1])),
+		glm::normalize(glm::vec3(lightTransform[2]))
+	);
+	glm::mat3 worldToLight = glm::transpose(lightRotation);
+
+	// Snap the center of the cascade to whole texels in light space, so that as the camera moves
+	// the shadow map moves in whole texel steps, and the rasterized shadow edges stay put
+	Cascade result;
+	result.SplitNear = splitNear;
+	result.SplitFar = splitFar;
+	result.TexelSize = 2.0f * radius / resolution;
+
+	glm::vec3 lightCenter = worldToLight * center;
+	lightCenter.x = std::floor(lightCenter.x / result.TexelSize) * result.TexelSize;
+	lightCenter.y = std::floor(lightCenter.y / result.TexelSize) * result.TexelSize;
+
+	result.View = glm::mat4(worldToLight);
+	result.View[3] = glm::vec4(-lightCenter, 1.0f);
+
+	// The light looks down -Z, so casters between the light and the slice are behind the center.
+	// Pull the near plane back past the slice so that they still cast shadows into it
+	result.Projection = glm::ortho(-radius, radius, -radius, radius, -(radius + casterDistance), radius);
+	return result;
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include <cstdint>
+#include <GLM/glm.hpp>
+
+/// <summary>
+/// CPU-side math for cascaded shadow maps. The main camera's frustum is split into a few depth
+/// ranges, and each range gets its own orthographic shadow projection that is fit tightly around
+/// it. Cascades are fit around a bounding sphere of the frustum slice, and snapped to whole texels
+/// in light space, so shadow edges don't shimmer as the camera moves or turns
+///
+/// Does not touch OpenGL
+/// </summary>
+class ShadowCascades {
+public:
+	ShadowCascades() = delete;
+
+	/// <summary>
+	/// The most cascades that a single light may use, matches MAX_CASCADES in fragment_shaders/shadow_composite.glsl
+	/// </summary>
+	static constexpr uint32_t MAX_CASCADES = 4;
+
+	/// <summary>
+	/// The view and projection for a single cascade
+	/// </summary>
+	struct Cascade {
+		// World space to light space, the light looks down -Z
+		glm::mat4 View;
+		// Orthographic projection around the cascade's bounding sphere
+		glm::mat4 Projection;
+		// The range of main camera view depths that this cascade covers
+		float     SplitNear;
+		float     SplitFar;
+		// The size of one shadow map texel, in world units
+		float     TexelSize;
+	};
+
+	/// <summary>
+	/// Splits a depth range into cascades, blending between logarithmic splits (which give each
+	/// cascade the same texel density on screen) and uniform splits (which avoid cascades that are
+	/// too small near the camera), also known as the practical split scheme
+	/// </summary>
+	/// <param name="zNear">The start of the depth range, must be greater than 0</param>
+	/// <param name="zFar">The end of the depth range</param>
+	/// <param name="count">The number of cascades, between 1 and MAX_CASCADES</param>
+	/// <param name="lambda">The blend between uniform (0) and logarithmic (1) splits</param>
+	/// <param name="splits">Receives count + 1 split depths, from zNear to zFar</param>
+	static void ComputeSplits(float zNear, float zFar, uint32_t count, float lambda, float* splits);
+
+	/// <summary>
+	/// Fits a texel snapped orthographic projection around a slice of the main camera's frustum
+	/// </summary>
+	/// <param name="cameraTransform">The main camera's local to world transform</param>
+	/// <param name="cameraProjection">The main camera's projection matrix</param>
+	/// <param name="splitNear">The view depth that the slice starts at</param>
+	/// <param name="splitFar">The view depth that the slice ends at</param>
+	/// <param name="lightTransform">The light's local to world transform, only the rotation is used</param>
+	/// <param name="resolution">The width and height of the cascade's shadow map, in pixels</param>
+	/// <param name="casterDistance">How far towards the light past the slice to look for shadow casters</param>
+	static Cascade FitCascade(
+		const glm::mat4& cameraTransform, const glm::mat4& cameraProjection,
+		float splitNear, float splitFar,
+		const glm::mat4& lightTransform, uint32_t resolution, float casterDistance);
+
+	/// <summary>
+	/// Gets the world space corners of a slice of the main camera's frustum, near plane first
+	/// </summary>
+	/// <param name="cameraTransform">The main camera's local to world transform</param>
+	/// <param name="cameraProjection">The main camera's projection matrix</param>
+	/// <param name="splitNear">The view depth that the slice starts at</param>
+	/// <param name="splitFar">The view depth that the slice ends at</param>
+	/// <param name="corners">Receives the 8 corners of the slice</param>
+	static void GetSliceCorners(
+		const glm::mat4& cameraTransform, const glm::mat4& cameraProjection,
+		float splitNear, float splitFar, glm::vec3* corners);
+};
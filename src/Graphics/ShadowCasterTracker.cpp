@@ -0,0 +1,91 @@
+#include "Graphics/ShadowCasterTracker.h"
+
+#include <algorithm>
+
+ShadowCasterTracker::ShadowCasterTracker(uint32_t settleFrames) :
+	_casters(),
+	_settleFrames(settleFrames),
+	_staticCount(0),
+	_staticVersion(0),
+	_frame(0)
+{ }
+
+void ShadowCasterTracker::BeginFrame() {
+	_frame++;
+}
+
+bool ShadowCasterTracker::Track(const void* caster, uint32_t transformVersion, ShadowCasterMode mode) {
+	auto it = _casters.find(caster);
+	if (it == _casters.end()) {
+		// New casters start out dynamic unless we're told otherwise, since we don't know if they're going to move yet
+		Caster entry = Caster();
+		entry.TransformVersion = transformVersion;
+		entry.LastSeenFrame = _frame;
+		it = _casters.emplace(caster, entry).first;
+		_SetStatic(it->second, mode == ShadowCasterMode::Static);
+		return it->second.IsStatic;
+	}
+
+	Caster& entry = it->second;
+	entry.LastSeenFrame = _frame;
+
+	bool moved = entry.TransformVersion != transformVersion;
+	entry.TransformVersion = transformVersion;
+	entry.StillFrames = moved ? 0 : entry.StillFrames + 1;
+
+	switch (mode) {
+		case ShadowCasterMode::Static:
+			// Forced static casters stay in the static set, but the caches still need to see where they moved to
+			if (!entry.IsStatic) {
+				_SetStatic(entry, true);
+			} else if (moved) {
+				_staticVersion++;
+			}
+			break;
+
+		case ShadowCasterMode::Dynamic:
+			_SetStatic(entry, false);
+			break;
+
+		default:
+			if (entry.IsStatic && moved) {
+				entry.Demotions = std::min(entry.Demotions + 1, MAX_SETTLE_BACKOFF);
+				_SetStatic(entry, false);
+			} else if (!entry.IsStatic && entry.StillFrames >= (_settleFrames << entry.Demotions)) {
+				_SetStatic(entry, true);
+			}
+			break;
+	}
+	return entry.IsStatic;
+}
+
+void ShadowCasterTracker::EndFrame() {
+	for (auto it = _casters.begin(); it != _casters.end();) {
+		if (it->second.LastSeenFrame != _frame) {
+			_SetStatic(it->second, false);
+			it = _casters.erase(it);
+		} else {
+			it++;
+		}
+	}
+}
+
+bool ShadowCasterTracker::IsStatic(const void* caster) const {
+	auto it = _casters.find(caster);
+	return it != _casters.end() && it->second.IsStatic;
+}
+
+void ShadowCasterTracker::Clear() {
+	_casters.clear();
+	_staticCount = 0;
+	_staticVersion++;
+}
+
+void ShadowCasterTracker::_SetStatic(Caster& caster, bool value) {
+	if (caster.IsStatic == value) {
+		return;
+	}
+	caster.IsStatic = value;
+	_staticCount = value ? _staticCount + 1 : _staticCount - 1;
+	_staticVersion++;
+}
@@ -0,0 +1,100 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <EnumToString.h>
+
+#include "Utils/Macros.h"
+
+/// <summary>
+/// Controls whether a shadow caster is drawn into the cached static shadow maps, or re-drawn every frame
+/// Auto:    The caster becomes static once it has stopped moving for a while
+/// Static:  The caster is always cached, the caches are rebuilt whenever it moves
+/// Dynamic: The caster is always re-drawn (ex: for vertex animation that transforms can't see)
+/// </summary>
+ENUM(ShadowCasterMode, int,
+	Auto    = 0,
+	Static  = 1,
+	Dynamic = 2
+);
+
+/// <summary>
+/// Splits shadow casters into static and dynamic sets, by watching their transform versions from
+/// frame to frame. Whenever the static set changes (a caster is promoted, demoted, moved or removed)
+/// the static version is bumped, so any shadow map that cached the static casters knows to rebuild
+///
+/// Casters are identified by pointer and never dereferenced, so this does not depend on the scene or OpenGL
+/// </summary>
+class ShadowCasterTracker {
+public:
+	NO_COPY(ShadowCasterTracker);
+	NO_MOVE(ShadowCasterTracker);
+
+	/// <summary>
+	/// The default number of frames that an Auto caster must stay still for before it is treated as static
+	/// </summary>
+	static constexpr uint32_t DEFAULT_SETTLE_FRAMES = 30;
+	/// <summary>
+	/// Every time an Auto caster is demoted, the frames it must stay still for doubles, up to this many times.
+	/// This keeps objects that move now and then from rebuilding the caches over and over
+	/// </summary>
+	static constexpr uint32_t MAX_SETTLE_BACKOFF = 4;
+
+	ShadowCasterTracker(uint32_t settleFrames = DEFAULT_SETTLE_FRAMES);
+
+	/// <summary>
+	/// Starts a new frame, every caster that is still alive should be tracked before EndFrame
+	/// </summary>
+	void BeginFrame();
+	/// <summary>
+	/// Records a caster for this frame
+	/// </summary>
+	/// <param name="caster">The caster to track</param>
+	/// <param name="transformVersion">A value that changes whenever the caster's world transform changes</param>
+	/// <param name="mode">How the caster should be classified</param>
+	/// <returns>True if the caster is currently static</returns>
+	bool Track(const void* caster, uint32_t transformVersion, ShadowCasterMode mode = ShadowCasterMode::Auto);
+	/// <summary>
+	/// Removes any casters that were not tracked since BeginFrame
+	/// </summary>
+	void EndFrame();
+
+	/// <summary>
+	/// Returns true if the caster is in the static set, casters that have never been tracked are dynamic
+	/// </summary>
+	bool IsStatic(const void* caster) const;
+	/// <summary>
+	/// Gets a value that changes whenever the set of static casters, or any of their transforms, changes
+	/// </summary>
+	uint64_t GetStaticVersion() const { return _staticVersion; }
+
+	/// <summary>
+	/// Gets the number of casters in the static and dynamic sets
+	/// </summary>
+	uint32_t GetStaticCount() const { return _staticCount; }
+	uint32_t GetDynamicCount() const { return static_cast<uint32_t>(_casters.size()) - _staticCount; }
+
+	/// <summary>
+	/// Forgets every caster, and invalidates the static set
+	/// </summary>
+	void Clear();
+
+protected:
+	struct Caster {
+		uint32_t TransformVersion;
+		// The number of frames since the caster last moved
+		uint32_t StillFrames;
+		// The number of times the caster has been demoted, for backing off promotion
+		uint32_t Demotions;
+		uint64_t LastSeenFrame;
+		bool     IsStatic;
+	};
+
+	std::unordered_map<const void*, Caster> _casters;
+	uint32_t _settleFrames;
+	uint32_t _staticCount;
+	uint64_t _staticVersion;
+	uint64_t _frame;
+
+	void _SetStatic(Caster& caster, bool value);
+};
@@ -4,6 +4,27 @@
 #include "GLM/glm.hpp"
 #include "Utils/JsonGlmHelpers.h"
 #include "Utils/Base64.h"
+#include "Graphics/Textures/TextureCache.h"
+
+struct Texture2D::DecodedData {
+	NO_COPY(DecodedData);
+	NO_MOVE(DecodedData);
+
+	int      Width = 0;
+	int      Height = 0;
+	int      NumChannels = 0;
+	// Allocated by STBI
+	uint8_t* Pixels = nullptr;
+	// Set instead of the pixels when the texture is loaded from the texture cache
+	TextureCache::Image::Sptr Compressed = nullptr;
+
+	DecodedData() = default;
+	~DecodedData() {
+		if (Pixels != nullptr) {
+			stbi_image_free(Pixels);
+		}
+	}
+};
 
 /// <summary>
 /// Get the number of mipmap levels required for a texture of the given size
@@ -23,6 +44,7 @@ nlohmann::json Texture2D::ToJson() const {
 		{ "filter_mag",       ~_description.MagnificationFilter },
 		{ "anisotropic",       _description.MaxAnisotropic },
 		{ "generate_mipmaps",  _description.GenerateMipMaps },
+		{ "compression",      ~_description.Compression },
 	};
 
 	if (!_description.Filename.empty()) {
@@ -45,7 +67,27 @@ nlohmann::json Texture2D::ToJson() const {
 	return result;
 }
 
+size_t Texture2D::GetMemoryUsage() const {
+	size_t size = GetImageSize(_description.Format, _description.Width, _description.Height) * _description.MultisampleCount;
+	// A full mip chain adds another third on top of the base level
+	return _description.GenerateMipMaps && _description.MultisampleCount == 1 ? size + size / 3 : size;
+}
+
 Texture2D::Sptr Texture2D::FromJson(const nlohmann::json& data)
+{
+	return FromDecoded(data, Decode(data));
+}
+
+std::shared_ptr<Texture2D::DecodedData> Texture2D::Decode(const nlohmann::json& data) {
+	std::string filename = JsonGet<std::string>(data, "filename", "");
+	if (filename.empty()) {
+		return nullptr;
+	}
+	return _DecodeFile(filename, Texture2DDescription().FormatHint, JsonParseEnum(BlockCompression, data, "compression", BlockCompression::None),
+		JsonGet(data, "generate_mipmaps", false));
+}
+
+Texture2D::Sptr Texture2D::FromDecoded(const nlohmann::json& data, const std::shared_ptr<DecodedData>& decoded)
 {
 	Texture2DDescription descr = Texture2DDescription();
 	descr.Filename = data["filename"];
@@ -55,8 +97,19 @@ Texture2D::Sptr Texture2D::FromJson(const nlohmann::json& data)
 	descr.MagnificationFilter = JsonParseEnum(MagFilter, data, "filter_mag", MagFilter::Linear);
 	descr.MaxAnisotropic      = JsonGet(data, "anisotropic", 0.0f);
 	descr.GenerateMipMaps     = JsonGet(data, "generate_mipmaps", false);
+	descr.Compression         = JsonParseEnum(BlockCompression, data, "compression", BlockCompression::None);
 
+	// The file has already been decoded, so we create the texture without a filename and upload the pixels ourselves
+	std::string filename = descr.Filename;
+	descr.Filename = "";
 	Texture2D::Sptr result = std::make_shared<Texture2D>(descr);
+	result->_description.Filename = filename;
+	if (!filename.empty()) {
+		if (decoded != nullptr) {
+			result->_LoadDecodedData(*decoded);
+		}
+		result->SetDebugName(filename);
+	}
 
 	// If we embedded data into the JSON, load it now
 	if (descr.Filename.empty() && data.contains("data") && data["data"].is_string()) {
@@ -118,7 +171,8 @@ void Texture2D::SetAnisoLevel(float value) {
 		_description.MaxAnisotropic = glm::clamp(value, 1.0f, ITexture::GetLimits().MAX_ANISOTROPY);
 		glTextureParameterf(_rendererId, GL_TEXTURE_MAX_ANISOTROPY, _description.MaxAnisotropic);
 
-		if (_description.GenerateMipMaps) {
+		// Compressed textures are loaded with their full mip chain, and OpenGL can't generate mips for them
+		if (_description.GenerateMipMaps && GetCompressedBlockSize(_description.Format) == 0) {
 			glGenerateTextureMipmap(_rendererId);
 		}
 	}
@@ -150,53 +204,108 @@ void Texture2D::_LoadDataFromFile() {
 	LOG_ASSERT(_description.Width + _description.Height == 0, "This texture has already been configured with a size! Cannot re-allocate memory!");
 
 	if (!_description.Filename.empty()) {
-		// Variables that will store properties about our image
-		int width, height, numChannels;
-		const int targetChannels = GetTexelComponentCount(_description.FormatHint);
+		std::shared_ptr<DecodedData> data = _DecodeFile(_description.Filename, _description.FormatHint, _description.Compression, _description.GenerateMipMaps);
+		// If we could not load any data, we've already warned
+		if (data == nullptr) {
+			return;
+		}
+		_LoadDecodedData(*data);
+	}
+	
+	SetDebugName(_description.Filename);
+}
 
-		// Use STBI to load the image
-		stbi_set_flip_vertically_on_load(true);
-		uint8_t* data = stbi_load(_description.Filename.c_str(), &width, &height, &numChannels, targetChannels);
+void Texture2D::_LoadDecodedData(const DecodedData& data) {
+	LOG_ASSERT(_description.Width + _description.Height == 0, "This texture has already been configured with a size! Cannot re-allocate memory!");
 
-		// If we could not load any data, warn and return null
-		if (data == nullptr) {
-			LOG_WARN("STBI Failed to load image from \"{}\"", _description.Filename);
-			return ;
+	// Compressed images go straight from the mapped cache file to OpenGL
+	if (data.Compressed != nullptr) {
+		const TextureCache::Image& image = *data.Compressed;
+		_description.Format = TextureCache::GetInternalFormat(image.Format);
+		_description.Width = image.Width;
+		_description.Height = image.Height;
+		_SetTextureParams();
+
+		// The cache may hold a full mip chain that another texture asked for, but we only allocated the levels we asked for
+		size_t levels = _description.GenerateMipMaps ? image.Levels.size() : 1;
+		for (size_t ix = 0; ix < levels; ix++) {
+			const TextureCache::Image::Level& level = image.Levels[ix];
+			glCompressedTextureSubImage2D(_rendererId, (GLint)ix, 0, 0, level.Width, level.Height, *_description.Format, (GLsizei)level.LayerSize, level.Data);
 		}
+		return;
+	}
 
-		// We should estimate a good format for our data
+	// We'll determine a recommended format for the image based on number of channels
+	// We hinted that we wanted a certain number of channels, but we're not guaranteed
+	// that all those channels exist (ex: loading an RGB image but requesting RGBA)
+	InternalFormat internal_format = GetInternalFormatForChannels8(data.NumChannels);
+	PixelFormat    image_format = GetPixelFormatForChannels(data.NumChannels);
 
-		// numChannels will store the number of channels in the image on disk, if we overrode that we should use the override value
-		if (targetChannels != 0)
-			numChannels = targetChannels;
+	// This is one of those poorly documented things in OpenGL
+	if ((data.NumChannels * data.Width) % 4 != 0) {
+		LOG_WARN("The alignment of a horizontal line is not a multiple of 4, this will require a call to glPixelStorei(GL_PACK_ALIGNMENT)");
+	}
 
-		// We'll determine a recommended format for the image based on number of channels
-		// We hinted that we wanted a certain number of channels, but we're not guaranteed
-		// that all those channels exist (ex: loading an RGB image but requesting RGBA)
-		InternalFormat internal_format = GetInternalFormatForChannels8(numChannels);
-		PixelFormat    image_format = GetPixelFormatForChannels(numChannels);
+	// Update our description to match what we loaded
+	_description.Format = internal_format;
+	_description.Width = data.Width;
+	_description.Height = data.Height;
 
-		// This is one of those poorly documented things in OpenGL
-		if ((numChannels * width) % 4 != 0) {
-			LOG_WARN("The alignment of a horizontal line is not a multiple of 4, this will require a call to glPixelStorei(GL_PACK_ALIGNMENT)");
-		}
+	// Allocates our memory
+	_SetTextureParams();
+
+	// Upload data to our texture
+	LoadData(data.Width, data.Height, image_format, PixelType::UByte, data.Pixels);
+}
 
-		// Update our description to match what we loaded
-		_description.Format = internal_format;
-		_description.Width = width;
-		_description.Height = height;
+std::shared_ptr<Texture2D::DecodedData> Texture2D::_DecodeFile(const std::string& filename, PixelFormat formatHint, BlockCompression compression, bool mipMaps) {
+	std::shared_ptr<DecodedData> result = std::make_shared<DecodedData>();
+	const int targetChannels = GetTexelComponentCount(formatHint);
+
+	if (compression != BlockCompression::None) {
+		result->Compressed = TextureCache::LoadOrBuild(TextureCache::GetCachePath(filename), { filename }, compression, 1, mipMaps,
+			[&](std::vector<uint8_t>& pixels, uint32_t& width, uint32_t& height, int& numChannels) {
+				// The compressor always works on RGBA, the channel count tells it what the texture would have been
+				int fileWidth, fileHeight, fileNumChannels;
+				stbi_set_flip_vertically_on_load(true);
+				uint8_t* data = stbi_load(filename.c_str(), &fileWidth, &fileHeight, &fileNumChannels, 4);
+				if (data == nullptr) {
+					LOG_WARN("STBI Failed to load image from \"{}\"", filename);
+					return false;
+				}
+				pixels.assign(data, data + (size_t)fileWidth * fileHeight * 4);
+				stbi_image_free(data);
+				width = fileWidth;
+				height = fileHeight;
+				numChannels = targetChannels != 0 ? targetChannels : fileNumChannels;
+				return true;
+			});
+
+		// If the cache could not be built, we fall back to loading the uncompressed image
+		if (result->Compressed != nullptr) {
+			result->Width = result->Compressed->Width;
+			result->Height = result->Compressed->Height;
+			return result;
+		}
+	}
 
-		// Allocates our memory
-		_SetTextureParams();
+	// Use STBI to load the image, every loader in the engine sets the same flip value, so it is safe
+	// to set from a worker thread
+	stbi_set_flip_vertically_on_load(true);
+	result->Pixels = stbi_load(filename.c_str(), &result->Width, &result->Height, &result->NumChannels, targetChannels);
 
-		// Upload data to our texture
-		LoadData(width, height, image_format, PixelType::UByte, data);
+	// If we could not load any data, warn and return null
+	if (result->Pixels == nullptr) {
+		LOG_WARN("STBI Failed to load image from \"{}\"", filename);
+		return nullptr;
+	}
 
-		// We now have data in the image, we can clear the STBI data
-		stbi_image_free(data);
+	// numChannels will store the number of channels in the image on disk, if we overrode that we should use the override value
+	if (targetChannels != 0) {
+		result->NumChannels = targetChannels;
 	}
-	
-	SetDebugName(_description.Filename);
+
+	return result;
 }
 
 void Texture2D::_SetTextureParams() {
@@ -1,5 +1,6 @@
 #pragma once
 #include "ITexture.h"
+#include "Utils/TextureCompressor.h"
 
 /// <summary>
 /// Describes all parameters we can manipulate with our 2D Textures
@@ -62,6 +63,13 @@ struct Texture2DDescription {
 	/// </summary>
 	PixelFormat    FormatHint;
 
+	/// <summary>
+	/// The block compression to use when loading this texture from a file, default None. Compression is lossy,
+	/// so it is opted into per texture (ex: Auto for color textures). The compressed image (and its mip chain,
+	/// if GenerateMipMaps is set) is cached next to the source file, see TextureCache
+	/// </summary>
+	BlockCompression Compression;
+
 	Texture2DDescription() :
 		Width(0), Height(0),
 		Format(InternalFormat::Unknown),
@@ -74,7 +82,8 @@ struct Texture2DDescription {
 		MultisampleCount(1),
 		Filename(""),
 		FormatHint(PixelFormat::RGBA),
-		EnableShadowSampling(false)
+		EnableShadowSampling(false),
+		Compression(BlockCompression::None)
 	{ }
 };
 
@@ -146,6 +155,21 @@ public:
 
 	virtual nlohmann::json ToJson() const override;
 	static Texture2D::Sptr FromJson(const nlohmann::json& data);
+	virtual size_t GetMemoryUsage() const override;
+
+	/// <summary>
+	/// The pixels for a texture that has been decoded from a file, see Decode
+	/// </summary>
+	struct DecodedData;
+	/// <summary>
+	/// Decodes the image file referenced by a texture's JSON without touching OpenGL, so that the resource
+	/// manager can run it on a worker thread. Returns nullptr if the texture has no file, or it failed to load
+	/// </summary>
+	static std::shared_ptr<DecodedData> Decode(const nlohmann::json& data);
+	/// <summary>
+	/// Creates a texture from its JSON and the data returned by Decode, must be called on the main thread
+	/// </summary>
+	static Texture2D::Sptr FromDecoded(const nlohmann::json& data, const std::shared_ptr<DecodedData>& decoded);
 
 protected:
 	Texture2DDescription _description;
@@ -157,6 +181,17 @@ protected:
 	/// </summary>
 	void _LoadDataFromFile();
 	/// <summary>
+	/// Allocates our texture's memory to fit a decoded image, and uploads the image's pixels to it
+	/// Will overwrite description size
+	/// </summary>
+	void _LoadDecodedData(const DecodedData& data);
+	/// <summary>
+	/// Loads an image file into memory using STBI, returns nullptr if the file could not be loaded. If compression
+	/// is requested, the compressed image is loaded from the texture cache instead (building it if needed), with a
+	/// full mip chain if mipMaps is set
+	/// </summary>
+	static std::shared_ptr<DecodedData> _DecodeFile(const std::string& filename, PixelFormat formatHint, BlockCompression compression, bool mipMaps);
+	/// <summary>
 	/// Allocates our texture's memory and sets sampling / filtering parameters
 	/// </summary>
 	void _SetTextureParams();
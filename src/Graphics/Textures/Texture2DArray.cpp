@@ -4,6 +4,7 @@
 #include "GLM/glm.hpp"
 #include "Utils/JsonGlmHelpers.h"
 #include "Utils/Base64.h"
+#include "Graphics/Textures/TextureCache.h"
 
 /// <summary>
 /// Get the number of mipmap levels required for a texture of the given size
@@ -25,6 +26,7 @@ nlohmann::json Texture2DArray::ToJson() const {
 		{ "generate_mipmaps",  _description.GenerateMipMaps },
 		{ "x_split",           _description.XDivisions },
 		{ "y_split",           _description.YDivisions },
+		{ "compression",      ~_description.Compression },
 	};
 
 	if (!_description.Filename.empty()) {
@@ -60,6 +62,7 @@ Texture2DArray::Sptr Texture2DArray::FromJson(const nlohmann::json& data)
 	descr.GenerateMipMaps = JsonGet(data, "generate_mipmaps", false);
 	descr.XDivisions = JsonGet(data, "x_split", descr.XDivisions);
 	descr.YDivisions = JsonGet(data, "y_split", descr.YDivisions);
+	descr.Compression = JsonParseEnum(BlockCompression, data, "compression", BlockCompression::None);
 
 	Texture2DArray::Sptr result = std::make_shared<Texture2DArray>(descr);
 
@@ -121,7 +124,8 @@ void Texture2DArray::SetAnisoLevel(float value) {
 		_description.MaxAnisotropic = glm::clamp(value, 1.0f, ITexture::GetLimits().MAX_ANISOTROPY);
 		glTextureParameterf(_rendererId, GL_TEXTURE_MAX_ANISOTROPY, _description.MaxAnisotropic);
 
-		if (_description.GenerateMipMaps) {
+		// Compressed textures are loaded with their full mip chain, and OpenGL can't generate mips for them
+		if (_description.GenerateMipMaps && GetCompressedBlockSize(_description.Format) == 0) {
 			glGenerateTextureMipmap(_rendererId);
 		}
 	}
@@ -152,6 +156,11 @@ void Texture2DArray::LoadData(uint32_t width, uint32_t height, uint32_t layers,
 void Texture2DArray::_LoadDataFromFile() {
 	LOG_ASSERT(_description.Width + _description.Height == 0, "This texture has already been configured with a size! Cannot re-allocate memory!");
 
+	if (!_description.Filename.empty() && _description.Compression != BlockCompression::None && _LoadCompressedFromFile()) {
+		SetDebugName(_description.Filename);
+		return;
+	}
+
 	if (!_description.Filename.empty()) {
 		// Variables that will store properties about our image
 		int width, height, numChannels;
@@ -216,25 +225,10 @@ void Texture2DArray::_LoadDataFromFile() {
 
 		size_t texelSize = GetTexelSize(_description.FormatHint, PixelType::UByte);
 
-		uint64_t size = xSize * ySize;
-
 		uint8_t* repack = (uint8_t*)malloc(width * height * texelSize);
 
 		// We need to remap our 2D image to 3D space
-		uint64_t sourceLoc{ 0 }, xLoc{ 0 }, yLoc{ 0 };
-		for (uint64_t iz = 0; iz < layers; iz++) {
-			for (uint64_t iy = 0; iy < ySize; iy++) {
-				for (uint64_t ix = 0; ix < xSize; ix++) {
-					xLoc = (iz % _description.XDivisions) * xSize + ix;
-					yLoc = (iz / _description.YDivisions) * ySize + iy;
-					memcpy(
-						repack + (iz * size + iy * xSize + ix) * texelSize,
-						data + (yLoc * width + xLoc) * texelSize,
-						texelSize
-					);
-				}
-			}
-		}
+		_RepackLayers(data, width, height, texelSize, repack);
 
 		_CrtCheckMemory();
 
@@ -250,6 +244,79 @@ void Texture2DArray::_LoadDataFromFile() {
 	SetDebugName(_description.Filename);
 }
 
+bool Texture2DArray::_LoadCompressedFromFile() {
+	const std::string& filename = _description.Filename;
+	const uint32_t layers = _description.XDivisions * _description.YDivisions;
+	const int targetChannels = GetTexelComponentCount(_description.FormatHint);
+
+	// The cache file name includes the split, so different splits of the same image don't fight over one file
+	std::string suffix = "_" + std::to_string(_description.XDivisions) + "x" + std::to_string(_description.YDivisions);
+	TextureCache::Image::Sptr image = TextureCache::LoadOrBuild(TextureCache::GetCachePath(filename, suffix), { filename }, _description.Compression, layers, _description.GenerateMipMaps,
+		[&](std::vector<uint8_t>& pixels, uint32_t& sliceWidth, uint32_t& sliceHeight, int& numChannels) {
+			// The compressor always works on RGBA, the channel count tells it what the texture would have been
+			int width, height, fileNumChannels;
+			stbi_set_flip_vertically_on_load(true);
+			uint8_t* data = stbi_load(filename.c_str(), &width, &height, &fileNumChannels, 4);
+			if (data == nullptr) {
+				LOG_WARN("STBI Failed to load image from \"{}\"", filename);
+				return false;
+			}
+			if (width % _description.XDivisions != 0 || height % _description.YDivisions != 0) {
+				stbi_image_free(data);
+				LOG_ERROR("Could not load image, dimensions not divisible by the number of slices");
+				return false;
+			}
+
+			pixels.resize((size_t)width * height * 4);
+			_RepackLayers(data, width, height, 4, pixels.data());
+			stbi_image_free(data);
+
+			sliceWidth = width / _description.XDivisions;
+			sliceHeight = height / _description.YDivisions;
+			numChannels = targetChannels != 0 ? targetChannels : fileNumChannels;
+			return true;
+		});
+	if (image == nullptr) {
+		return false;
+	}
+
+	_description.Format = TextureCache::GetInternalFormat(image->Format);
+	_description.Width = image->Width * _description.XDivisions;
+	_description.Height = image->Height * _description.YDivisions;
+	_SetTextureParams();
+
+	// The cache may hold a full mip chain that another texture asked for, but we only allocated the levels we asked for
+	size_t levels = _description.GenerateMipMaps ? image->Levels.size() : 1;
+	for (size_t ix = 0; ix < levels; ix++) {
+		const TextureCache::Image::Level& level = image->Levels[ix];
+		glCompressedTextureSubImage3D(_rendererId, (GLint)ix, 0, 0, 0, level.Width, level.Height, layers,
+			*_description.Format, (GLsizei)(level.LayerSize * layers), level.Data);
+	}
+	return true;
+}
+
+void Texture2DArray::_RepackLayers(const uint8_t* data, uint64_t width, uint64_t height, size_t texelSize, uint8_t* output) const {
+	uint64_t layers = _description.XDivisions * _description.YDivisions;
+	uint64_t xSize = width / _description.XDivisions;
+	uint64_t ySize = height / _description.YDivisions;
+	uint64_t size = xSize * ySize;
+
+	uint64_t xLoc{ 0 }, yLoc{ 0 };
+	for (uint64_t iz = 0; iz < layers; iz++) {
+		for (uint64_t iy = 0; iy < ySize; iy++) {
+			for (uint64_t ix = 0; ix < xSize; ix++) {
+				xLoc = (iz % _description.XDivisions) * xSize + ix;
+				yLoc = (iz / _description.YDivisions) * ySize + iy;
+				memcpy(
+					output + (iz * size + iy * xSize + ix) * texelSize,
+					data + (yLoc * width + xLoc) * texelSize,
+					texelSize
+				);
+			}
+		}
+	}
+}
+
 void Texture2DArray::_SetTextureParams() {
 	// If the anisotropy is negative, we assume that we want max anisotropy
 	if (_description.MaxAnisotropic < 0.0f) {
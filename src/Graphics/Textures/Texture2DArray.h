@@ -1,5 +1,6 @@
 #pragma once
 #include "ITexture.h"
+#include "Utils/TextureCompressor.h"
 
 /// <summary>
 /// Describes all parameters we can manipulate with our 2D Textures
@@ -64,6 +65,13 @@ struct Texture2DArrayDescription {
 	/// </summary>
 	PixelFormat    FormatHint;
 
+	/// <summary>
+	/// The block compression to use when loading this texture from a file, default None. Compression is lossy,
+	/// so it is opted into per texture. The compressed layers (and their mip chains, if GenerateMipMaps is set)
+	/// are cached next to the source file, see TextureCache
+	/// </summary>
+	BlockCompression Compression;
+
 	Texture2DArrayDescription() :
 		Width(0), Height(0),
 		XDivisions(1), YDivisions(1),
@@ -75,7 +83,8 @@ struct Texture2DArrayDescription {
 		MaxAnisotropic(-1.0f), // max aniso by default
 		GenerateMipMaps(true),
 		Filename(""),
-		FormatHint(PixelFormat::RGBA)
+		FormatHint(PixelFormat::RGBA),
+		Compression(BlockCompression::None)
 	{ }
 };
 
@@ -160,6 +169,15 @@ protected:
 	/// </summary>
 	void _LoadDataFromFile();
 	/// <summary>
+	/// Tries to load this texture from the texture cache, building the cache if needed. Returns false
+	/// if the cache could not be used, in which case the texture should be loaded uncompressed
+	/// </summary>
+	bool _LoadCompressedFromFile();
+	/// <summary>
+	/// Splits an image into the layers of this texture, storing the layers back to back in the output
+	/// </summary>
+	void _RepackLayers(const uint8_t* data, uint64_t width, uint64_t height, size_t texelSize, uint8_t* output) const;
+	/// <summary>
 	/// Allocates our texture's memory and sets sampling / filtering parameters
 	/// </summary>
 	void _SetTextureParams();
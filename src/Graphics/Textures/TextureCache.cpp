@@ -0,0 +1,275 @@
+#include "Graphics/Textures/TextureCache.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+
+#include "Utils/HashUtils.h"
+#include "GLFW/glfw3.h"
+#include "Logging.h"
+
+namespace fs = std::filesystem;
+
+std::string TextureCache::GetCachePath(const std::string& sourceFile, const std::string& suffix) {
+	fs::path result = fs::path(sourceFile);
+	result.replace_filename(result.stem().string() + suffix + EXTENSION);
+	return result.string();
+}
+
+TextureCache::Image::Sptr TextureCache::LoadOrBuild(const std::string& cacheFile, const std::vector<std::string>& sourceFiles,
+	BlockCompression format, uint32_t numLayers, bool mipMaps, const DecodeFunc& decode)
+{
+	LOG_ASSERT(format != BlockCompression::None, "Cannot build a texture cache without compression");
+
+	// Most of the time the cache is already built, and we can go straight to the mapped file
+	if (fs::exists(cacheFile) && IsCacheFileCurrent(cacheFile, sourceFiles, format, numLayers, mipMaps)) {
+		Image::Sptr result = std::make_shared<Image>();
+		if (Load(cacheFile, *result)) {
+			return result;
+		}
+	}
+
+	float startTime = static_cast<float>(glfwGetTime());
+
+	std::vector<uint8_t> pixels;
+	uint32_t width = 0, height = 0;
+	int numChannels = 0;
+	if (!decode(pixels, width, height, numChannels)) {
+		return nullptr;
+	}
+	if (width * height == 0 || pixels.size() != (size_t)width * height * 4 * numLayers) {
+		LOG_ERROR("Source images for \"{}\" did not decode to {} RGBA layers", cacheFile, numLayers);
+		return nullptr;
+	}
+
+	BlockCompression actualFormat = TextureCompressor::ResolveFormat(format, numChannels, pixels.data(), pixels.size() / 4);
+	// If another load of the same texture beat us to writing the file, we can still use theirs
+	if (!Build(cacheFile, sourceFiles, pixels.data(), width, height, numLayers, format, actualFormat, mipMaps) &&
+		!IsCacheFileCurrent(cacheFile, sourceFiles, format, numLayers, mipMaps)) {
+		return nullptr;
+	}
+
+	float endTime = static_cast<float>(glfwGetTime());
+	LOG_TRACE("Compressed \"{}\" to {} in {} seconds ({}x{}, {} layers)", cacheFile, ~actualFormat, endTime - startTime, width, height, numLayers);
+
+	Image::Sptr result = std::make_shared<Image>();
+	return Load(cacheFile, *result) ? result : nullptr;
+}
+
+bool TextureCache::IsCacheFileCurrent(const std::string& cacheFile, const std::vector<std::string>& sourceFiles, BlockCompression format, uint32_t numLayers, bool mipMaps) {
+	// We only need the header, so there's no need to map the whole file
+	std::ifstream file(cacheFile, std::ios::binary);
+	if (!file) { return false; }
+
+	BinaryHeader header = BinaryHeader();
+	file.read(reinterpret_cast<char*>(&header), sizeof(BinaryHeader));
+	if (!file || memcmp(header.HeaderBytes, BinaryHeader().HeaderBytes, sizeof(header.HeaderBytes)) != 0 || header.Version != 0x01) {
+		return false;
+	}
+
+	// If the texture's settings have changed, we need to rebuild even if the source has not
+	if (header.RequestedFormat != *format || header.NumLayers != numLayers) {
+		return false;
+	}
+	// A cache with only the top level can't be used for a mipmapped texture, but a full chain is fine without mipmaps
+	if (mipMaps && header.NumLevels < GetNumMipLevels(header.Width, header.Height)) {
+		return false;
+	}
+
+	// Fast path, if the size and timestamp match we can skip hashing the sources
+	SourceInfo source;
+	if (!_GetSourceInfo(sourceFiles, false, source)) {
+		return false;
+	}
+	if (source.Size == header.SourceSize && source.Timestamp == header.SourceTimestamp) {
+		return true;
+	}
+
+	// Timestamps change all the time (ex: version control checkouts), so fall back to the content hash
+	return source.Size == header.SourceSize && _GetSourceInfo(sourceFiles, true, source) && source.Hash == header.SourceHash;
+}
+
+bool TextureCache::Build(const std::string& cacheFile, const std::vector<std::string>& sourceFiles,
+	const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t numLayers,
+	BlockCompression requestedFormat, BlockCompression format, bool mipMaps)
+{
+	LOG_ASSERT(TextureCompressor::GetBlockSize(format) > 0, "Cannot build a texture cache in format {}", ~format);
+
+	auto align = [](size_t value) { return (value + SECTION_ALIGNMENT - 1) & ~(SECTION_ALIGNMENT - 1); };
+
+	// Lay out the mip chain (or just the top level), each level's layers are stored back to back
+	std::vector<BinaryLevel> levels(mipMaps ? GetNumMipLevels(width, height) : 1);
+	size_t offset = align(sizeof(BinaryHeader));
+	uint32_t levelWidth = width, levelHeight = height;
+	for (BinaryLevel& level : levels) {
+		level.Width = levelWidth;
+		level.Height = levelHeight;
+		level.LayerSize = TextureCompressor::GetCompressedSize(format, levelWidth, levelHeight);
+		levelWidth = std::max(1u, levelWidth / 2);
+		levelHeight = std::max(1u, levelHeight / 2);
+	}
+
+	BinaryHeader header = BinaryHeader();
+	header.HeaderSize      = sizeof(BinaryHeader);
+	header.RequestedFormat = *requestedFormat;
+	header.Format          = *format;
+	header.Width           = width;
+	header.Height          = height;
+	header.NumLayers       = numLayers;
+	header.NumLevels       = static_cast<uint32_t>(levels.size());
+	header.LevelsOffset    = offset;
+	header.DataOffset      = align(header.LevelsOffset + levels.size() * sizeof(BinaryLevel));
+	offset = header.DataOffset;
+	for (BinaryLevel& level : levels) {
+		level.Offset = offset;
+		offset = align(offset + level.LayerSize * numLayers);
+	}
+	header.FileSize = offset;
+
+	// Store info about where the texture came from so we can detect when it goes stale
+	SourceInfo source;
+	if (_GetSourceInfo(sourceFiles, true, source)) {
+		header.SourceHash      = source.Hash;
+		header.SourceSize      = source.Size;
+		header.SourceTimestamp = source.Timestamp;
+	}
+
+	// Build the body of the file in memory so we can checksum it (padding is left zeroed)
+	std::vector<uint8_t> body(header.FileSize - header.HeaderSize, 0);
+	uint8_t* base = body.data() - header.HeaderSize;
+	memcpy(base + header.LevelsOffset, levels.data(), levels.size() * sizeof(BinaryLevel));
+
+	const size_t layerPixels = (size_t)width * height * 4;
+	for (uint32_t layer = 0; layer < numLayers; layer++) {
+		// Each level is filtered from the one above it, so we only keep the current level around
+		std::vector<uint8_t> mip;
+		const uint8_t* current = pixels + layer * layerPixels;
+		for (size_t ix = 0; ix < levels.size(); ix++) {
+			const BinaryLevel& level = levels[ix];
+			TextureCompressor::Compress(current, level.Width, level.Height, format, base + level.Offset + layer * level.LayerSize);
+			if (ix + 1 < levels.size()) {
+				mip = TextureCompressor::Downsample(current, level.Width, level.Height);
+				current = mip.data();
+			}
+		}
+	}
+	header.Checksum = HashUtils::Hash(body.data(), body.size());
+
+	// Write to a temporary file first, so that anything else loading the same texture never sees a partial file
+	// The thread ID keeps two loads of the same texture from writing to the same temporary file
+	std::string tempFile = cacheFile + "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+	{
+		std::ofstream file(tempFile, std::ios::binary);
+		if (!file) {
+			LOG_WARN("Failed to open texture cache \"{}\" for writing", tempFile);
+			return false;
+		}
+		file.write(reinterpret_cast<const char*>(&header), sizeof(BinaryHeader));
+		file.write(reinterpret_cast<const char*>(body.data()), body.size());
+		if (!file) {
+			LOG_WARN("Failed to write texture cache \"{}\"", tempFile);
+			return false;
+		}
+	}
+
+	std::error_code error;
+	fs::rename(tempFile, cacheFile, error);
+	if (error) {
+		LOG_WARN("Failed to replace texture cache \"{}\": {}", cacheFile, error.message());
+		fs::remove(tempFile, error);
+		return false;
+	}
+	return true;
+}
+
+bool TextureCache::Load(const std::string& cacheFile, Image& result) {
+	if (!result.File.Open(cacheFile)) {
+		LOG_ERROR("Failed to map texture cache \"{}\"", cacheFile);
+		return false;
+	}
+
+	const MemoryMappedFile& file = result.File;
+	size_t size = file.GetSize();
+
+	BinaryHeader header = BinaryHeader();
+	if (size < sizeof(BinaryHeader)) {
+		LOG_ERROR("Not enough data in the file!");
+		return false;
+	}
+	memcpy(&header, file.GetData(), sizeof(BinaryHeader));
+
+	// Validate the header, making sure all the sections are within the file
+	BlockCompression format = (BlockCompression)header.Format;
+	if (memcmp(header.HeaderBytes, BinaryHeader().HeaderBytes, sizeof(header.HeaderBytes)) != 0 || header.Version != 0x01 ||
+		header.HeaderSize != sizeof(BinaryHeader) || header.FileSize != size ||
+		TextureCompressor::GetBlockSize(format) == 0 || header.NumLayers == 0 || header.NumLevels == 0 ||
+		header.LevelsOffset + header.NumLevels * sizeof(BinaryLevel) > size) {
+		LOG_ERROR("Texture cache \"{}\" has an invalid header!", cacheFile);
+		return false;
+	}
+
+	// Make sure the contents have not been corrupted
+	if (HashUtils::Hash(file.GetData() + header.HeaderSize, size - header.HeaderSize) != header.Checksum) {
+		LOG_ERROR("Texture cache \"{}\" failed checksum validation!", cacheFile);
+		return false;
+	}
+
+	result.Format = format;
+	result.Width = header.Width;
+	result.Height = header.Height;
+	result.NumLayers = header.NumLayers;
+	result.Levels.clear();
+	result.Levels.reserve(header.NumLevels);
+	for (uint32_t ix = 0; ix < header.NumLevels; ix++) {
+		BinaryLevel level = BinaryLevel();
+		memcpy(&level, file.GetData() + header.LevelsOffset + ix * sizeof(BinaryLevel), sizeof(BinaryLevel));
+		if (level.LayerSize != TextureCompressor::GetCompressedSize(format, level.Width, level.Height) ||
+			level.Offset + level.LayerSize * header.NumLayers > size) {
+			LOG_ERROR("Texture cache \"{}\" has an invalid level table!", cacheFile);
+			return false;
+		}
+		result.Levels.push_back({ level.Width, level.Height, file.GetData() + level.Offset, level.LayerSize });
+	}
+
+	return true;
+}
+
+InternalFormat TextureCache::GetInternalFormat(BlockCompression format) {
+	switch (format) {
+		case BlockCompression::BC1: return InternalFormat::BC1;
+		case BlockCompression::BC3: return InternalFormat::BC3;
+		case BlockCompression::BC4: return InternalFormat::BC4;
+		case BlockCompression::BC5: return InternalFormat::BC5;
+		case BlockCompression::BC7: return InternalFormat::BC7;
+		default:                    return InternalFormat::Unknown;
+	}
+}
+
+uint32_t TextureCache::GetNumMipLevels(uint32_t width, uint32_t height) {
+	uint32_t result = 1;
+	for (uint32_t size = std::max(width, height); size > 1; size /= 2) {
+		result++;
+	}
+	return result;
+}
+
+bool TextureCache::_GetSourceInfo(const std::vector<std::string>& sourceFiles, bool hashContents, SourceInfo& result) {
+	result = SourceInfo{ HashUtils::DEFAULT_SEED, 0, 0 };
+	for (const std::string& filename : sourceFiles) {
+		std::error_code error;
+		result.Size += fs::file_size(filename, error);
+		if (error) { return false; }
+		int64_t timestamp = static_cast<int64_t>(fs::last_write_time(filename, error).time_since_epoch().count());
+		if (error) { return false; }
+		// Timestamps of multiple files are combined the same way as hashes, we only ever compare them for equality
+		result.Timestamp = static_cast<int64_t>(HashUtils::Combine(static_cast<uint64_t>(result.Timestamp), static_cast<uint64_t>(timestamp)));
+
+		if (hashContents) {
+			uint64_t hash = 0;
+			if (!HashUtils::HashFile(filename, hash)) { return false; }
+			result.Hash = HashUtils::Combine(result.Hash, hash);
+		}
+	}
+	return true;
+}
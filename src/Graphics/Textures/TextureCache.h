@@ -0,0 +1,182 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Graphics/GlEnums.h"
+#include "Utils/Macros.h"
+#include "Utils/MemoryMappedFile.h"
+#include "Utils/TextureCompressor.h"
+
+/// <summary>
+/// Stores block compressed textures on disk alongside their source images, so that we only need to
+/// run the (slow) compressor the first time an image is loaded. Each cache file holds every layer of
+/// the texture (1 for 2D textures, 6 for cubemaps) along with either the full mip chain down to 1x1 or
+/// just the top level, and remembers the size, timestamp and hash of its source images so it can be
+/// rebuilt when they change
+/// </summary>
+class TextureCache {
+public:
+	TextureCache() = delete;
+
+	/// <summary>
+	/// The file extension that cache files are saved with
+	/// </summary>
+	static constexpr const char* EXTENSION = ".btex";
+
+	// Header for a texture cache file, all fields are explicitly sized and each section is 16 byte aligned
+	struct alignas(16) BinaryHeader {
+		// A check value so we can ensure that we're loading in the right file type
+		char      HeaderBytes[4] = { 'B', 'T', 'E', 'X' };
+		// The version code, we can use this to create different loaders if our format changes
+		uint16_t  Version = 0x01;
+		// The size of this header, in bytes
+		uint16_t  HeaderSize = 0;
+		// The format that was requested when the file was built, and the format it was actually compressed to
+		uint32_t  RequestedFormat = 0;
+		uint32_t  Format = 0;
+		// The size of the top level of the texture, in pixels
+		uint32_t  Width = 0;
+		uint32_t  Height = 0;
+		// The number of images stored in each level (ex: 6 for cubemaps)
+		uint32_t  NumLayers = 0;
+		uint32_t  NumLevels = 0;
+		// Byte offsets from the start of the file to the level table and the first level's data
+		uint64_t  LevelsOffset = 0;
+		uint64_t  DataOffset = 0;
+		// The total size of the file in bytes
+		uint64_t  FileSize = 0;
+		// Info about the source images, so we can tell when they have changed
+		uint64_t  SourceHash = 0;
+		uint64_t  SourceSize = 0;
+		int64_t   SourceTimestamp = 0;
+		// Hash of everything in the file after the header
+		uint64_t  Checksum = 0;
+	};
+	static_assert(sizeof(BinaryHeader) == 96, "BinaryHeader layout has changed, update the version number!");
+
+	// A single mip level, the layers of a level are stored back to back
+	struct BinaryLevel {
+		uint32_t Width = 0;
+		uint32_t Height = 0;
+		// The offset of the level's first layer, from the start of the file
+		uint64_t Offset = 0;
+		// The size of a single layer, in bytes
+		uint64_t LayerSize = 0;
+	};
+	static_assert(sizeof(BinaryLevel) == 24, "BinaryLevel layout has changed, update the version number!");
+
+	// The alignment that each section in the file starts on
+	static constexpr size_t SECTION_ALIGNMENT = 16;
+
+	/// <summary>
+	/// A cache file that has been mapped into memory and validated, the level pointers point into
+	/// the mapped file, so they are only valid for as long as the image is alive
+	/// </summary>
+	struct Image {
+		MAKE_PTRS(Image);
+		NO_COPY(Image);
+		NO_MOVE(Image);
+
+		struct Level {
+			uint32_t       Width;
+			uint32_t       Height;
+			// The data for every layer of the level, back to back
+			const uint8_t* Data;
+			size_t         LayerSize;
+		};
+
+		MemoryMappedFile   File;
+		BlockCompression   Format = BlockCompression::None;
+		uint32_t           Width = 0;
+		uint32_t           Height = 0;
+		uint32_t           NumLayers = 0;
+		std::vector<Level> Levels;
+
+		Image() = default;
+	};
+
+	/// <summary>
+	/// Loads the layers of a source image as tightly packed RGBA8 pixels, one layer after another. Returns
+	/// false if the image could not be loaded. Also returns the number of channels the texture would have
+	/// if it was not compressed, so that Auto compression can pick a matching format
+	/// </summary>
+	typedef std::function<bool(std::vector<uint8_t>& pixels, uint32_t& width, uint32_t& height, int& numChannels)> DecodeFunc;
+
+	/// <summary>
+	/// Gets the path of the cache file for a source image, which sits next to the source
+	/// </summary>
+	/// <param name="sourceFile">The path to the source image</param>
+	/// <param name="suffix">Added to the file name, so that different kinds of texture made from the same image don't share a file</param>
+	static std::string GetCachePath(const std::string& sourceFile, const std::string& suffix = "");
+
+	/// <summary>
+	/// Loads the cache file for the given source images, building it first if it does not exist or is out of date.
+	/// This does not touch OpenGL, so it is safe to call from a worker thread
+	/// </summary>
+	/// <param name="cacheFile">The path of the cache file, see GetCachePath</param>
+	/// <param name="sourceFiles">The files that the image is built from, used to check whether the cache is current</param>
+	/// <param name="format">The format to compress to, must not be None</param>
+	/// <param name="numLayers">The number of layers in the image</param>
+	/// <param name="mipMaps">True if the full mip chain is needed, false if only the top level is. A cache that already
+	/// has the full chain is still used when only the top level is needed</param>
+	/// <param name="decode">Loads the source pixels if the cache needs to be rebuilt</param>
+	/// <returns>The mapped image, or nullptr if the image could not be built or loaded</returns>
+	static Image::Sptr LoadOrBuild(const std::string& cacheFile, const std::vector<std::string>& sourceFiles,
+		BlockCompression format, uint32_t numLayers, bool mipMaps, const DecodeFunc& decode);
+
+	/// <summary>
+	/// Checks whether a cache file was built with the given settings from the current version of the source files
+	/// </summary>
+	static bool IsCacheFileCurrent(const std::string& cacheFile, const std::vector<std::string>& sourceFiles, BlockCompression format, uint32_t numLayers, bool mipMaps);
+
+	/// <summary>
+	/// Compresses the layers of an image, optionally along with a full mip chain, and writes the result to a cache file
+	/// </summary>
+	/// <param name="cacheFile">The path to write the cache file to</param>
+	/// <param name="sourceFiles">The files that the image was built from</param>
+	/// <param name="pixels">The RGBA8 pixels of each layer, back to back</param>
+	/// <param name="width">The width of each layer, in pixels</param>
+	/// <param name="height">The height of each layer, in pixels</param>
+	/// <param name="numLayers">The number of layers in the image</param>
+	/// <param name="requestedFormat">The format that was requested, stored so we can tell if the settings change</param>
+	/// <param name="format">The format to compress to, must not be None or Auto</param>
+	/// <param name="mipMaps">True to store the full mip chain, false to only store the top level</param>
+	/// <returns>True if the file was written</returns>
+	static bool Build(const std::string& cacheFile, const std::vector<std::string>& sourceFiles,
+		const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t numLayers,
+		BlockCompression requestedFormat, BlockCompression format, bool mipMaps);
+
+	/// <summary>
+	/// Maps and validates a cache file
+	/// </summary>
+	/// <param name="cacheFile">The path of the cache file to load</param>
+	/// <param name="result">The image to load the file into</param>
+	/// <returns>True if the file is a valid cache file</returns>
+	static bool Load(const std::string& cacheFile, Image& result);
+
+	/// <summary>
+	/// Gets the OpenGL format that matches a block compressed format
+	/// </summary>
+	static InternalFormat GetInternalFormat(BlockCompression format);
+
+	/// <summary>
+	/// Gets the number of levels in a full mip chain for an image of the given size, including the top level
+	/// </summary>
+	static uint32_t GetNumMipLevels(uint32_t width, uint32_t height);
+
+protected:
+	struct SourceInfo {
+		uint64_t Hash;
+		uint64_t Size;
+		int64_t  Timestamp;
+	};
+
+	/// <summary>
+	/// Combines the size and timestamp of all the source files, and optionally their contents
+	/// </summary>
+	static bool _GetSourceInfo(const std::vector<std::string>& sourceFiles, bool hashContents, SourceInfo& result);
+};
@@ -2,6 +2,7 @@
 #include <filesystem>
 #include "stb_image.h"
 #include "Utils/JsonGlmHelpers.h"
+#include "Graphics/Textures/TextureCache.h"
 
 TextureCube::TextureCube(const std::string& baseFilename) :
 	ITexture(TextureType::Cubemap),
@@ -31,6 +32,7 @@ nlohmann::json TextureCube::ToJson() const
 	nlohmann::json result;
 	result["filter_min"] = ~_description.MinificationFilter;
 	result["filter_mag"] = ~_description.MagnificationFilter;
+	result["compression"] = ~_description.Compression;
 	
 	if (!_description.FaceFileNames.empty()) {
 		result["face_filenames"] = nlohmann::json();
@@ -44,11 +46,17 @@ nlohmann::json TextureCube::ToJson() const
 	return result;
 }
 
+size_t TextureCube::GetMemoryUsage() const {
+	// Cubemaps are allocated with a single level for each of the 6 faces
+	return GetImageSize(_description.Format, _description.Size, _description.Size) * 6;
+}
+
 TextureCube::Sptr TextureCube::FromJson(const nlohmann::json& data)
 {
 	TextureCubeDescription descr = TextureCubeDescription();
 	descr.MinificationFilter  = JsonParseEnum(MinFilter, data, "filter_min", MinFilter::NearestMipNearest);
 	descr.MagnificationFilter = JsonParseEnum(MagFilter, data, "filter_mag", MagFilter::Linear);
+	descr.Compression         = JsonParseEnum(BlockCompression, data, "compression", BlockCompression::None);
 	descr.Filename       = JsonGet<std::string>(data, "base_filename", "");
 	if (data.contains("face_filenames") && data["face_filenames"].is_object()) {
 		for (auto& [key, value] : data["face_filenames"].items()) {
@@ -100,6 +108,10 @@ void TextureCube::_LoadFromDescription()
 
 void TextureCube::_LoadImages(const std::unordered_map<CubeMapFace, std::string>& faceFilenames)
 {
+	if (_description.Compression != BlockCompression::None && _LoadCompressedImages(faceFilenames)) {
+		return;
+	}
+
 	// Will store all of our texture data, back to back in memory
 	uint8_t* datastore = nullptr;
 	// The size of a single face's texture, in bytes
@@ -177,6 +189,55 @@ void TextureCube::_LoadImages(const std::unordered_map<CubeMapFace, std::string>
 	delete[] datastore;
 }
 
+bool TextureCube::_LoadCompressedImages(const std::unordered_map<CubeMapFace, std::string>& faceFilenames)
+{
+	// All 6 faces go into a single cache file, named after the base file if we have one
+	std::vector<std::string> sources;
+	for (int ix = 0; ix < 6; ix++) {
+		sources.push_back(faceFilenames.at((CubeMapFace)ix));
+	}
+	std::string cacheFile = TextureCache::GetCachePath(_description.Filename.empty() ? sources[0] : _description.Filename, "_cube");
+
+	// Cubemaps only allocate a single level, so the cache only needs the top of the mip chain
+	TextureCache::Image::Sptr image = TextureCache::LoadOrBuild(cacheFile, sources, _description.Compression, 6, false,
+		[&](std::vector<uint8_t>& pixels, uint32_t& width, uint32_t& height, int& numChannels) {
+			for (int ix = 0; ix < 6; ix++) {
+				const std::string& filename = sources[ix];
+				int fileWidth, fileHeight, fileNumChannels;
+
+				// The compressor always works on RGBA, the channel count tells it what the texture would have been
+				stbi_set_flip_vertically_on_load(true);
+				uint8_t* data = stbi_load(filename.c_str(), &fileWidth, &fileHeight, &fileNumChannels, 4);
+				if (data == nullptr) {
+					LOG_ERROR("STBI Failed to load image from \"{}\"", filename);
+					return false;
+				}
+				if (fileWidth != fileHeight || (ix > 0 && ((uint32_t)fileWidth != width || fileNumChannels != numChannels))) {
+					LOG_WARN("Image \"{}\" did not match size or format of texture cube", filename);
+					stbi_image_free(data);
+					return false;
+				}
+
+				width = height = fileWidth;
+				numChannels = fileNumChannels;
+				pixels.insert(pixels.end(), data, data + (size_t)fileWidth * fileHeight * 4);
+				stbi_image_free(data);
+			}
+			return true;
+		});
+	if (image == nullptr) {
+		return false;
+	}
+
+	_description.Size = image->Width;
+	_description.Format = TextureCache::GetInternalFormat(image->Format);
+	_SetTextureParams();
+
+	const TextureCache::Image::Level& level = image->Levels[0];
+	glCompressedTextureSubImage3D(_rendererId, 0, 0, 0, 0, level.Width, level.Height, 6, *_description.Format, (GLsizei)(level.LayerSize * 6), level.Data);
+	return true;
+}
+
 void TextureCube::_SetTextureParams(){
 	// Make sure the size is greater than zero and that we have a format specified before trying to set parameters
 	if (_description.Size > 0 && _description.Format != InternalFormat::Unknown) {
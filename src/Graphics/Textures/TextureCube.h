@@ -1,6 +1,7 @@
 #pragma once
 #include <EnumToString.h>
 #include "ITexture.h"
+#include "Utils/TextureCompressor.h"
 
 /*
 0 	GL_TEXTURE_CUBE_MAP_POSITIVE_X
@@ -60,6 +61,12 @@ struct TextureCubeDescription {
 	/// </summary>
 	PixelFormat    FormatHint;
 
+	/// <summary>
+	/// The block compression to use when loading the faces, default None. Compression is lossy, so it
+	/// is opted into per texture. The compressed faces are cached next to the source files, see TextureCache
+	/// </summary>
+	BlockCompression Compression;
+
 	/// <summary>
 	/// Creates a default (empty) cubemap description
 	/// </summary>
@@ -69,7 +76,8 @@ struct TextureCubeDescription {
 		MinificationFilter(MinFilter::NearestMipLinear),
 		MagnificationFilter(MagFilter::Linear),
 		Filename(""),
-		FormatHint(PixelFormat::RGBA)
+		FormatHint(PixelFormat::RGBA),
+		Compression(BlockCompression::None)
 	{ }
 };
 
@@ -109,6 +117,7 @@ public:
 	const TextureCubeDescription& GetDescription() const { return _description; }
 
 	virtual nlohmann::json ToJson() const override;
+	virtual size_t GetMemoryUsage() const override;
 	static TextureCube::Sptr FromJson(const nlohmann::json& data);
 
 protected:
@@ -116,6 +125,11 @@ protected:
 
 	virtual void _LoadFromDescription();
 	virtual void _LoadImages(const std::unordered_map<CubeMapFace, std::string>& faceFilenames);
+	/// <summary>
+	/// Tries to load the faces from the texture cache, building the cache if needed. Returns false
+	/// if the cache could not be used, in which case the faces should be loaded uncompressed
+	/// </summary>
+	bool _LoadCompressedImages(const std::unordered_map<CubeMapFace, std::string>& faceFilenames);
 
 	/// <summary>
 	/// Allocates our texture's memory and sets sampling / filtering parameters
@@ -0,0 +1,46 @@
+#include "Graphics/UniformBlockPacker.h"
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+
+void UniformBlockPacker::Write(const UniformBlockMember& member, const void* value, uint8_t* block, size_t blockSize) {
+	const uint8_t* source = static_cast<const uint8_t*>(value);
+	ShaderDataTypecode typeCode = GetShaderDataTypeCode(member.Type);
+	uint32_t elementSize = ShaderDataTypeSize(member.Type);
+
+	// Our matrices are tightly packed columns, but in a block each column starts on the matrix stride
+	uint32_t numColumns = 1;
+	if ((typeCode == ShaderDataTypecode::Matrix || typeCode == ShaderDataTypecode::MatrixD) && member.MatrixStride > 0) {
+		numColumns = ((uint32_t)member.Type & ShaderDataType_Size2Mask) >> 3;
+	}
+	uint32_t columnSize = elementSize / numColumns;
+
+	size_t numElements = std::max<size_t>(member.ArraySize, 1);
+	for (size_t element = 0; element < numElements; element++) {
+		for (uint32_t column = 0; column < numColumns; column++) {
+			size_t offset = member.Offset + element * member.ArrayStride + column * member.MatrixStride;
+			const uint8_t* data = source + element * elementSize + column * columnSize;
+
+			// Bools are a single byte for us, but take up 4 bytes each in a block
+			if (typeCode == ShaderDataTypecode::Bool) {
+				for (uint32_t component = 0; component < columnSize && offset + (component + 1) * sizeof(uint32_t) <= blockSize; component++) {
+					uint32_t flag = data[component] ? 1 : 0;
+					memcpy(block + offset + component * sizeof(uint32_t), &flag, sizeof(uint32_t));
+				}
+			}
+			else if (offset + columnSize <= blockSize) {
+				memcpy(block + offset, data, columnSize);
+			}
+		}
+	}
+}
+
+std::vector<size_t> UniformBlockPacker::AssignTextureSlots(const std::vector<std::string>& names, int maxSlots) {
+	std::vector<size_t> result(names.size());
+	std::iota(result.begin(), result.end(), 0);
+	std::sort(result.begin(), result.end(), [&](size_t a, size_t b) {
+		return names[a] < names[b];
+	});
+	result.resize(std::min(result.size(), static_cast<size_t>(std::max(maxSlots, 0))));
+	return result;
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Graphics/GlEnums.h"
+
+/// <summary>
+/// Where a single uniform lives in a uniform block, as reflected from the shader. For std140 blocks, the
+/// strides follow the std140 rules (ex: every element of a float array is padded out to a vec4)
+/// </summary>
+struct UniformBlockMember {
+	ShaderDataType Type = ShaderDataType::None;
+	// The number of elements, 1 for uniforms that aren't arrays
+	size_t         ArraySize = 1;
+	// Offset of the first element from the start of the block, in bytes
+	int            Offset = 0;
+	// Distance between array elements, and between the columns of a matrix, in bytes
+	int            ArrayStride = 0;
+	int            MatrixStride = 0;
+};
+
+/// <summary>
+/// CPU side helpers for laying out material parameters to match a shader. These do not touch OpenGL, the
+/// material uploads the blocks and sets the sampler uniforms with the results
+/// </summary>
+class UniformBlockPacker {
+public:
+	UniformBlockPacker() = delete;
+
+	/// <summary>
+	/// Copies a value into a block, converting it from our tightly packed layout to the block's layout.
+	/// Anything that would land past the end of the block is skipped
+	/// </summary>
+	/// <param name="member">Where the value goes in the block</param>
+	/// <param name="value">The value, laid out as we store it (ex: a glm::mat3, or an array of bools as bytes)</param>
+	/// <param name="block">The block's contents</param>
+	/// <param name="blockSize">The size of the block, in bytes</param>
+	static void Write(const UniformBlockMember& member, const void* value, uint8_t* block, size_t blockSize);
+
+	/// <summary>
+	/// Assigns texture slots to a shader's samplers in order of their names, so that every material using
+	/// the shader agrees on which slot each texture goes in
+	/// </summary>
+	/// <param name="names">The names of the shader's samplers, in any order</param>
+	/// <param name="maxSlots">The number of slots available, samplers past this are left without a slot</param>
+	/// <returns>For each slot in order, the index into names of the sampler that uses it</returns>
+	static std::vector<size_t> AssignTextureSlots(const std::vector<std::string>& names, int maxSlots);
+};
@@ -43,7 +43,7 @@ VertexArrayObject::VertexBufferBinding* VertexArrayObject::AddVertexBuffer(const
 			_elementCount = _vertexCount;
 		}
 	} 
-	else if (buffer->GetElementCount() != _vertexCount) {
+	else if (!instanced && buffer->GetElementCount() != _vertexCount) {
 		LOG_WARN("Buffer element count does not match vertex count of this VAO!!!");
 	}
 
@@ -77,7 +77,7 @@ void VertexArrayObject::ReplaceVertexBuffer(VertexBufferBinding* binding, const
 	});
 
 	if (it != _vertexBuffers.end()) {
-		if (buffer->GetElementCount() != _vertexCount) {
+		if (!binding->Instanced && buffer->GetElementCount() != _vertexCount) {
 			LOG_WARN("Buffer element count does not match vertex count of this VAO!!!");
 		}
 
@@ -128,6 +128,20 @@ void VertexArrayObject::DrawInstanced(uint32_t instanceCount, DrawMode mode /*=
 	
 }
 
+void VertexArrayObject::DrawInstanced(uint32_t instanceCount, uint32_t baseInstance, DrawMode mode /*= DrawMode::TriangleList*/)
+{
+	Bind();
+	if (_indexBuffer == nullptr) {
+		uint32_t elements = _elementCount == 0 ? _vertexBuffers[0]->Buffer->GetElementCount() : _elementCount;
+		glDrawArraysInstancedBaseInstance((GLenum)mode, 0, elements, instanceCount, baseInstance);
+	}
+	else {
+		uint32_t elements = _elementCount == 0 ? _indexBuffer->GetElementCount() : _elementCount;
+		glDrawElementsInstancedBaseInstance((GLenum)mode, elements, (GLenum)_indexBuffer->GetElementType(), nullptr, instanceCount, baseInstance);
+	}
+	Unbind();
+}
+
 void VertexArrayObject::Bind() {
 	glBindVertexArray(_handle);
 }
@@ -101,6 +101,10 @@ public:
 	/// <param name="ibo">The index buffer to bind to this VAO</param>
 	void SetIndexBuffer(const IndexBuffer::Sptr& ibo);
 	IndexBuffer::Sptr GetIndexBuffer() const { return _indexBuffer; }
+	/// <summary>
+	/// Gets all the vertex buffers that are bound to this VAO
+	/// </summary>
+	const std::vector<VertexBufferBinding*>& GetVertexBuffers() const { return _vertexBuffers; }
 
 	/// <summary>
 	/// Adds a vertex buffer to this VAO, with the specified attributes
@@ -133,6 +137,15 @@ public:
 	/// <param name="instanceCount">The number of instances to render</param>
 	/// <param name="mode">The primitive mode for rendering the mesh</param>
 	void DrawInstanced(uint32_t instanceCount, DrawMode mode = DrawMode::TriangleList);
+	/// <summary>
+	/// Renders this VAO with the given instance count, reading instanced attributes starting at baseInstance
+	/// rather than the start of their buffers. Internally this will call glDrawArraysInstancedBaseInstance or
+	/// glDrawElementsInstancedBaseInstance
+	/// </summary>
+	/// <param name="instanceCount">The number of instances to render</param>
+	/// <param name="baseInstance">The index of the first element to read from instanced buffers</param>
+	/// <param name="mode">The primitive mode for rendering the mesh</param>
+	void DrawInstanced(uint32_t instanceCount, uint32_t baseInstance, DrawMode mode = DrawMode::TriangleList);
 
 	/// <summary>
 	/// Binds this VAO as the source of data for draw operations
@@ -0,0 +1,303 @@
+#include "Utils/BinaryMeshFormat.h"
+
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <thread>
+
+#include "Graphics/VertexParamMap.h"
+#include "Utils/HashUtils.h"
+#include "Logging.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+	const char HEADER_BYTES[4] = { 'B', 'O', 'B', 'J' };
+}
+
+std::vector<uint8_t> BinaryMeshFormat::Write(const Mesh& mesh, const SourceInfo& source) {
+	auto align = [](size_t value) { return (value + SECTION_ALIGNMENT - 1) & ~(SECTION_ALIGNMENT - 1); };
+
+	std::vector<BinaryLod> lodTable;
+	lodTable.reserve(mesh.Lods.size());
+	for (const Mesh::LodRange& lod : mesh.Lods) {
+		lodTable.push_back({ lod.FirstIndex, lod.NumIndices, lod.Error, 0 });
+	}
+
+	size_t attribBytes = mesh.VertexDeclaration.size() * sizeof(BufferAttribute);
+	size_t lodBytes    = lodTable.size() * sizeof(BinaryLod);
+	size_t indexBytes  = mesh.NumIndices * GetIndexTypeSize(mesh.IndicesType);
+	size_t vertexBytes = mesh.NumVertices * (size_t)mesh.VertexStride;
+
+	// Create the fixed size header for our output file, laying out each section on an aligned boundary
+	BinaryHeaderV3 header = BinaryHeaderV3();
+	header.HeaderSize       = sizeof(BinaryHeaderV3);
+	header.NumIndices       = mesh.NumIndices;
+	header.IndicesType      = static_cast<uint32_t>(mesh.IndicesType);
+	header.NumVertices      = mesh.NumVertices;
+	header.VertexStride     = mesh.VertexStride;
+	header.NumAttributes    = static_cast<uint32_t>(mesh.VertexDeclaration.size());
+	header.NumLods          = static_cast<uint32_t>(lodTable.size());
+	header.AttributesOffset = align(sizeof(BinaryHeaderV3));
+	header.LodsOffset       = align(header.AttributesOffset + attribBytes);
+	header.IndicesOffset    = align(header.LodsOffset + lodBytes);
+	header.VerticesOffset   = align(header.IndicesOffset + indexBytes);
+	header.FileSize         = header.VerticesOffset + vertexBytes;
+
+	// Store the bounds of the mesh, so we don't need to read the vertices to get them when loading
+	if (mesh.Bounds.IsValid()) {
+		memcpy(header.BoundsMin, &mesh.Bounds.Min, sizeof(header.BoundsMin));
+		memcpy(header.BoundsMax, &mesh.Bounds.Max, sizeof(header.BoundsMax));
+	}
+
+	// Store info about where the mesh came from so we can detect when it goes stale
+	header.SourceHash      = source.Hash;
+	header.SourceSize      = source.Size;
+	header.SourceTimestamp = source.Timestamp;
+
+	// Lay out the whole file, padding is left zeroed. The section offsets are from the start of the file
+	std::vector<uint8_t> result(header.FileSize, 0);
+	uint8_t* base = result.data();
+	if (attribBytes > 0) { memcpy(base + header.AttributesOffset, mesh.VertexDeclaration.data(), attribBytes); }
+	if (lodBytes > 0)    { memcpy(base + header.LodsOffset, lodTable.data(), lodBytes); }
+	if (indexBytes > 0)  { memcpy(base + header.IndicesOffset, mesh.IndexData, indexBytes); }
+	if (vertexBytes > 0) { memcpy(base + header.VerticesOffset, mesh.VertexData, vertexBytes); }
+
+	// The checksum covers everything after the header, so it has to go in last
+	header.Checksum = HashUtils::Hash(base + header.HeaderSize, result.size() - header.HeaderSize);
+	memcpy(base, &header, sizeof(BinaryHeaderV3));
+
+	return result;
+}
+
+bool BinaryMeshFormat::Read(const uint8_t* data, size_t size, Mesh& result, const std::string& name) {
+	// All versions of the header start with the header bytes and version code
+	const size_t versionOffset = sizeof(HEADER_BYTES);
+	if (size < versionOffset + sizeof(uint16_t)) {
+		LOG_ERROR("Not enough data in the file!");
+		return false;
+	}
+	if (memcmp(data, HEADER_BYTES, sizeof(HEADER_BYTES)) != 0) {
+		LOG_ERROR("\"{}\" is not a binary mesh file!", name);
+		return false;
+	}
+
+	// Handle our version
+	uint16_t version = 0;
+	memcpy(&version, data + versionOffset, sizeof(uint16_t));
+	switch (version) {
+		case 0x01: return _ReadV1(data, size, result, name);
+		// Version 3 only adds fields to the end of the version 2 header, so they share a reader
+		case 0x02:
+		case 0x03: return _ReadV3(data, size, result, name);
+		default:
+			LOG_ERROR("Unknown binary mesh version {} in \"{}\"", version, name);
+			return false;
+	}
+}
+
+bool BinaryMeshFormat::ReadSourceInfo(const uint8_t* data, size_t size, SourceInfo& result) {
+	BinaryHeaderV3 header = BinaryHeaderV3();
+	if (size < sizeof(BinaryHeaderV3)) {
+		return false;
+	}
+	memcpy(&header, data, sizeof(BinaryHeaderV3));
+	if (memcmp(header.HeaderBytes, HEADER_BYTES, sizeof(HEADER_BYTES)) != 0 || header.Version != VERSION) {
+		return false;
+	}
+
+	result.Hash      = header.SourceHash;
+	result.Size      = header.SourceSize;
+	result.Timestamp = header.SourceTimestamp;
+	return true;
+}
+
+bool BinaryMeshFormat::GetSourceInfo(const std::string& filename, SourceInfo& result) {
+	std::error_code error;
+	result.Size = fs::file_size(filename, error);
+	if (error) { return false; }
+	result.Timestamp = static_cast<int64_t>(fs::last_write_time(filename, error).time_since_epoch().count());
+	if (error) { return false; }
+	return HashUtils::HashFile(filename, result.Hash);
+}
+
+bool BinaryMeshFormat::IsFileCurrent(const std::string& binFile, const std::string& sourceFile) {
+	// We only need the header, so there's no need to map the whole file
+	std::ifstream file(binFile, std::ios::binary);
+	if (!file) { return false; }
+
+	uint8_t header[sizeof(BinaryHeaderV3)];
+	file.read(reinterpret_cast<char*>(header), sizeof(header));
+	SourceInfo stored;
+	if (!file || !ReadSourceInfo(header, sizeof(header), stored)) {
+		// Older files either do not know where they came from, or are missing LODs, so we need to regenerate them
+		return false;
+	}
+
+	// Fast path, if the size and timestamp match we can skip hashing the source
+	std::error_code error;
+	uint64_t sourceSize = fs::file_size(sourceFile, error);
+	if (error) { return false; }
+	int64_t timestamp = static_cast<int64_t>(fs::last_write_time(sourceFile, error).time_since_epoch().count());
+	if (error) { return false; }
+	if (sourceSize == stored.Size && timestamp == stored.Timestamp) {
+		return true;
+	}
+
+	// Timestamps change all the time (ex: version control checkouts), so fall back to the content hash
+	uint64_t hash = 0;
+	return sourceSize == stored.Size && HashUtils::HashFile(sourceFile, hash) && hash == stored.Hash;
+}
+
+void BinaryMeshFormat::WriteFile(const std::string& filename, const std::vector<uint8_t>& contents) {
+	// Several loaders can convert the same mesh at once, so each write gets its own temporary file. The thread ID
+	// keeps threads apart, and the counter keeps repeated writes on one thread apart
+	static std::atomic<uint32_t> counter{ 0 };
+	std::string tempFile = filename + "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) +
+		"." + std::to_string(counter++) + ".tmp";
+	{
+		std::ofstream file(tempFile, std::ios::binary);
+		if (!file) {
+			throw std::runtime_error("Failed to open output file");
+		}
+		file.write(reinterpret_cast<const char*>(contents.data()), contents.size());
+		if (!file) {
+			file.close();
+			std::error_code error;
+			fs::remove(tempFile, error);
+			throw std::runtime_error("Failed to write output file");
+		}
+	}
+
+	std::error_code error;
+	fs::rename(tempFile, filename, error);
+	if (error) {
+		fs::remove(tempFile, error);
+		throw std::runtime_error("Failed to replace output file");
+	}
+}
+
+AABB BinaryMeshFormat::CalculateBounds(const std::vector<BufferAttribute>& vDecl, const void* vertexData, uint32_t vertexStride, uint32_t numVertices) {
+	VertexParamMap vMap = VertexParamMap(vDecl);
+	if (vMap.PositionOffset == (uint32_t)-1) {
+		return AABB();
+	}
+	return AABB::FromPoints(static_cast<const uint8_t*>(vertexData) + vMap.PositionOffset, vertexStride, numVertices);
+}
+
+bool BinaryMeshFormat::_ReadV1(const uint8_t* data, size_t size, Mesh& result, const std::string& name) {
+	// Read the header from the file
+	BinaryHeader header = BinaryHeader();
+	if (size >= sizeof(BinaryHeader)) {
+		memcpy(&header, data, sizeof(BinaryHeader));
+	} else {
+		LOG_ERROR("Not enough data in the file!");
+		return false;
+	}
+
+	// Determine how many bytes we need in the file
+	size_t requiredBytes =
+		sizeof(BinaryHeader) +
+		(header.NumAttributes * sizeof(BufferAttribute)) +
+		(header.VertexStride * (size_t)header.NumVertices) +
+		(header.NumIndices * GetIndexTypeSize(header.IndicesType));
+
+	// Make sure there's enough data in the file
+	if (size < requiredBytes) {
+		LOG_ERROR("Not enough data in \"{}\"!", name);
+		return false;
+	}
+
+	// Read all attributes from the file, this is basically our VDECL
+	size_t seek = sizeof(BinaryHeader);
+	result.VertexDeclaration.resize(header.NumAttributes);
+	memcpy(result.VertexDeclaration.data(), data + seek, header.NumAttributes * sizeof(BufferAttribute));
+	seek += header.NumAttributes * sizeof(BufferAttribute);
+
+	// V1 files are tightly packed, indices come first followed by vertices
+	result.IndexData = data + seek;
+	result.IndicesType = header.IndicesType;
+	result.NumIndices = header.NumIndices;
+	seek += header.NumIndices * GetIndexTypeSize(header.IndicesType);
+	result.VertexData = data + seek;
+	result.VertexStride = header.VertexStride;
+	result.NumVertices = header.NumVertices;
+
+	// V1 files have a single level, and don't know their bounds
+	result.Lods = { Mesh::LodRange{ 0, header.NumIndices, 0.0f } };
+	result.Bounds = CalculateBounds(result.VertexDeclaration, result.VertexData, header.VertexStride, header.NumVertices);
+
+	return true;
+}
+
+bool BinaryMeshFormat::_ReadV3(const uint8_t* data, size_t size, Mesh& result, const std::string& name) {
+	// Read the header from the file, V2 headers are the start of a V3 header so the remaining fields are left defaulted
+	BinaryHeaderV3 header = BinaryHeaderV3();
+	size_t headerSize = sizeof(BinaryHeaderV3);
+	if (size >= V2_HEADER_SIZE) {
+		memcpy(&header, data, V2_HEADER_SIZE);
+		headerSize = header.Version == 0x02 ? V2_HEADER_SIZE : sizeof(BinaryHeaderV3);
+	}
+	if (size >= headerSize) {
+		memcpy(&header, data, headerSize);
+	} else {
+		LOG_ERROR("Not enough data in \"{}\"!", name);
+		return false;
+	}
+
+	IndexType indexType = (IndexType)header.IndicesType;
+	size_t indexBytes  = header.NumIndices * GetIndexTypeSize(indexType);
+	size_t vertexBytes = header.VertexStride * (size_t)header.NumVertices;
+
+	// Validate the header, making sure all the sections are within the file
+	if (header.HeaderSize != headerSize || header.FileSize != size ||
+		header.AttributesOffset + header.NumAttributes * sizeof(BufferAttribute) > size ||
+		header.IndicesOffset + indexBytes > size ||
+		header.VerticesOffset + vertexBytes > size ||
+		header.LodsOffset + header.NumLods * sizeof(BinaryLod) > size ||
+		(header.NumIndices > 0 && indexBytes == 0)) {
+		LOG_ERROR("Binary mesh \"{}\" has an invalid header!", name);
+		return false;
+	}
+
+	// Make sure the contents have not been corrupted
+	if (HashUtils::Hash(data + header.HeaderSize, size - header.HeaderSize) != header.Checksum) {
+		LOG_ERROR("Binary mesh \"{}\" failed checksum validation!", name);
+		return false;
+	}
+
+	// Read all attributes from the file, this is basically our VDECL
+	result.VertexDeclaration.resize(header.NumAttributes);
+	memcpy(result.VertexDeclaration.data(), data + header.AttributesOffset, header.NumAttributes * sizeof(BufferAttribute));
+
+	// Read the LOD table, files without one have a single level that covers all the indices
+	std::vector<BinaryLod> lodTable(header.NumLods);
+	if (header.NumLods > 0) {
+		memcpy(lodTable.data(), data + header.LodsOffset, header.NumLods * sizeof(BinaryLod));
+	} else {
+		lodTable.push_back({ 0, header.NumIndices, 0.0f, 0 });
+	}
+	result.Lods.clear();
+	result.Lods.reserve(lodTable.size());
+	for (const BinaryLod& lod : lodTable) {
+		if ((size_t)lod.FirstIndex + lod.NumIndices > header.NumIndices) {
+			LOG_ERROR("Binary mesh \"{}\" has an invalid LOD table!", name);
+			return false;
+		}
+		result.Lods.push_back({ lod.FirstIndex, lod.NumIndices, lod.Error });
+	}
+
+	result.IndexData = data + header.IndicesOffset;
+	result.IndicesType = indexType;
+	result.NumIndices = header.NumIndices;
+	result.VertexData = data + header.VerticesOffset;
+	result.VertexStride = header.VertexStride;
+	result.NumVertices = header.NumVertices;
+	result.Bounds = header.Version >= 0x03 ?
+		AABB(glm::vec3(header.BoundsMin[0], header.BoundsMin[1], header.BoundsMin[2]), glm::vec3(header.BoundsMax[0], header.BoundsMax[1], header.BoundsMax[2])) :
+		CalculateBounds(result.VertexDeclaration, result.VertexData, header.VertexStride, header.NumVertices);
+
+	return true;
+}
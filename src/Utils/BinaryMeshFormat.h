@@ -0,0 +1,195 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Graphics/VertexArrayObject.h"
+#include "Utils/BoundingVolumes.h"
+
+/// <summary>
+/// Describes the binary mesh files that OptimizedObjLoader converts OBJ files into, and handles
+/// validating, reading and writing them. None of this touches OpenGL, the loader uploads the results
+/// </summary>
+class BinaryMeshFormat {
+public:
+	BinaryMeshFormat() = delete;
+
+	// The version code that new files are written with, older versions can still be read but should be regenerated
+	static constexpr uint16_t VERSION = 0x03;
+
+	// Version 1 header, will be put at the start of the binary file, contains info about the contents of the file
+	// NOTE: this is kept around so that we can still load older binary files, new files are written as V3
+	struct BinaryHeader {
+		// A check value so we can ensure that we're loading in the right file type
+		char      HeaderBytes[4] ={ 'B', 'O', 'B', 'J' };
+		// The version code, we can use this to create different loaders if our format changes
+		uint16_t  Version = 0;
+		// The number of indices in the mesh
+		uint32_t  NumIndices = 0;
+		// The type of index to load
+		IndexType IndicesType = IndexType::Unknown;
+		// The number of vertices in the mesh
+		uint32_t  NumVertices = 0;
+		// The size of a single vertex structure
+		uint16_t  VertexStride = 0;
+		// The number of vertex attributes (basically how many VDECL entries there are)
+		uint8_t   NumAttributes = 0;
+	};
+
+	// Version 3 header, all fields are explicitly sized and the header and each section are 16 byte aligned,
+	// so the index and vertex sections can be handed to OpenGL straight from a memory mapped view of the file
+	// NOTE: version 2 files use the same layout, but end after the Checksum field (they have no LODs or bounds)
+	struct alignas(16) BinaryHeaderV3 {
+		// A check value so we can ensure that we're loading in the right file type (same position as V1)
+		char      HeaderBytes[4] ={ 'B', 'O', 'B', 'J' };
+		// The version code (same position as V1)
+		uint16_t  Version = VERSION;
+		// The size of this header, in bytes
+		uint16_t  HeaderSize = 0;
+		// The number of indices in the mesh (including all levels of detail)
+		uint32_t  NumIndices = 0;
+		// The type of index to load, stored as the underlying GLenum
+		uint32_t  IndicesType = 0;
+		// The number of vertices in the mesh
+		uint32_t  NumVertices = 0;
+		// The size of a single vertex structure
+		uint32_t  VertexStride = 0;
+		// The number of vertex attributes (basically how many VDECL entries there are)
+		uint32_t  NumAttributes = 0;
+		// Reserved for future use
+		uint32_t  Flags = 0;
+		// Byte offsets from the start of the file to each section
+		uint64_t  AttributesOffset = 0;
+		uint64_t  IndicesOffset = 0;
+		uint64_t  VerticesOffset = 0;
+		// The total size of the file in bytes
+		uint64_t  FileSize = 0;
+		// Info about the file this mesh was generated from, used to detect when the binary is stale
+		uint64_t  SourceHash = 0;
+		uint64_t  SourceSize = 0;
+		int64_t   SourceTimestamp = 0;
+		// Hash of everything in the file after the header
+		uint64_t  Checksum = 0;
+		// The number of entries in the LOD table, the first entry is always the full detail mesh
+		uint32_t  NumLods = 0;
+		uint32_t  Reserved = 0;
+		// Byte offset from the start of the file to the LOD table
+		uint64_t  LodsOffset = 0;
+		// The object space bounds of the mesh
+		float     BoundsMin[3] = { 0.0f, 0.0f, 0.0f };
+		float     BoundsMax[3] = { 0.0f, 0.0f, 0.0f };
+	};
+	static_assert(sizeof(BinaryHeaderV3) == 144, "BinaryHeaderV3 layout has changed, update the version number!");
+	static_assert(offsetof(BinaryHeaderV3, NumLods) == 96, "Version 2 fields must stay at the start of BinaryHeaderV3!");
+
+	// The size of a version 2 header, which is the start of a V3 header
+	static constexpr size_t V2_HEADER_SIZE = 96;
+
+	// An entry in the LOD table, describes a range of the index section
+	struct BinaryLod {
+		uint32_t FirstIndex = 0;
+		uint32_t NumIndices = 0;
+		// The error of this level, as a fraction of the mesh's bounding radius
+		float    Error = 0.0f;
+		uint32_t Reserved = 0;
+	};
+	static_assert(sizeof(BinaryLod) == 16, "BinaryLod layout has changed, update the version number!");
+
+	// The alignment that each section in a V2 or V3 file starts on
+	static constexpr size_t SECTION_ALIGNMENT = 16;
+
+	// Describes the file that a binary mesh was generated from
+	struct SourceInfo {
+		uint64_t Hash = 0;
+		uint64_t Size = 0;
+		int64_t  Timestamp = 0;
+	};
+
+	/// <summary>
+	/// The contents of a binary mesh file. The vertex and index pointers point into the buffer that the
+	/// mesh was read from (or will be written from), so they are only valid for as long as that buffer is
+	/// </summary>
+	struct Mesh {
+		// A range of the index data that makes up a single level of detail
+		struct LodRange {
+			uint32_t FirstIndex = 0;
+			uint32_t NumIndices = 0;
+			float    Error = 0.0f;
+		};
+
+		std::vector<BufferAttribute> VertexDeclaration;
+		const uint8_t*               VertexData = nullptr;
+		uint32_t                     VertexStride = 0;
+		uint32_t                     NumVertices = 0;
+		// The indices for every level of detail, back to back
+		const uint8_t*               IndexData = nullptr;
+		IndexType                    IndicesType = IndexType::Unknown;
+		uint32_t                     NumIndices = 0;
+		// When read, the first range is always the full detail mesh. When written, an empty list stores
+		// a single level covering all the indices
+		std::vector<LodRange>        Lods;
+		AABB                         Bounds;
+	};
+
+	/// <summary>
+	/// Lays out a mesh as a V3 binary mesh file, including its checksum
+	/// </summary>
+	/// <param name="mesh">The mesh to write</param>
+	/// <param name="source">Info about the file the mesh was generated from, or all zeroes if there is none</param>
+	/// <returns>The contents of the file</returns>
+	static std::vector<uint8_t> Write(const Mesh& mesh, const SourceInfo& source);
+
+	/// <summary>
+	/// Validates a binary mesh file of any version and reads its contents. The header, the section
+	/// bounds, the LOD table and (for V2 and up) the checksum are all checked before anything is read
+	/// </summary>
+	/// <param name="data">The contents of the file</param>
+	/// <param name="size">The size of the file, in bytes</param>
+	/// <param name="result">The mesh to read into, its pointers will point into data</param>
+	/// <param name="name">The name of the file, used when logging errors</param>
+	/// <returns>True if the file was valid and has been read</returns>
+	static bool Read(const uint8_t* data, size_t size, Mesh& result, const std::string& name = "");
+
+	/// <summary>
+	/// Reads the source info from the start of a binary mesh file. Fails for anything other than the current
+	/// version, since older files either do not know where they came from or are missing LODs
+	/// </summary>
+	/// <param name="data">The start of the file, at least a full V3 header</param>
+	/// <param name="size">The number of bytes available in data</param>
+	/// <param name="result">Set to the source info stored in the file</param>
+	/// <returns>True if data starts with a current version header</returns>
+	static bool ReadSourceInfo(const uint8_t* data, size_t size, SourceInfo& result);
+
+	/// <summary>
+	/// Gets the size, timestamp and content hash of a source file
+	/// </summary>
+	static bool GetSourceInfo(const std::string& filename, SourceInfo& result);
+
+	/// <summary>
+	/// Checks whether a binary file is the current version, and was generated from the current contents of
+	/// the given source file
+	/// </summary>
+	/// <param name="binFile">The path to the binary mesh file</param>
+	/// <param name="sourceFile">The path to the file that the binary was generated from</param>
+	/// <returns>True if the binary file is up to date, false if it needs to be regenerated</returns>
+	static bool IsFileCurrent(const std::string& binFile, const std::string& sourceFile);
+
+	/// <summary>
+	/// Writes the contents of a binary mesh file to disk. The contents go to a temporary file that is then
+	/// renamed over the output, so that a crash mid-write never leaves a partial binary behind. Throws if the
+	/// file could not be written
+	/// </summary>
+	/// <param name="filename">The path to write the file to</param>
+	/// <param name="contents">The contents of the file, as returned by Write</param>
+	static void WriteFile(const std::string& filename, const std::vector<uint8_t>& contents);
+
+	/// <summary>
+	/// Calculates the bounds of a mesh from its vertex data, for files that do not store their bounds
+	/// </summary>
+	static AABB CalculateBounds(const std::vector<BufferAttribute>& vDecl, const void* vertexData, uint32_t vertexStride, uint32_t numVertices);
+
+protected:
+	static bool _ReadV1(const uint8_t* data, size_t size, Mesh& result, const std::string& name);
+	static bool _ReadV3(const uint8_t* data, size_t size, Mesh& result, const std::string& name);
+};
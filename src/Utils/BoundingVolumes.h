@@ -0,0 +1,206 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <GLM/glm.hpp>
+#include <EnumToString.h>
+
+/// <summary>
+/// An axis aligned bounding box, stored as its minimum and maximum corners. A default
+/// constructed box is empty (Min > Max), and can be grown by adding points to it
+/// </summary>
+struct AABB {
+	glm::vec3 Min = glm::vec3(std::numeric_limits<float>::max());
+	glm::vec3 Max = glm::vec3(std::numeric_limits<float>::lowest());
+
+	AABB() = default;
+	AABB(const glm::vec3& min, const glm::vec3& max) : Min(min), Max(max) { }
+
+	/// <summary>
+	/// Returns true if this box contains at least one point
+	/// </summary>
+	bool IsValid() const { return Min.x <= Max.x && Min.y <= Max.y && Min.z <= Max.z; }
+
+	/// <summary>
+	/// Gets the center point of the box
+	/// </summary>
+	glm::vec3 GetCenter() const { return (Min + Max) * 0.5f; }
+	/// <summary>
+	/// Gets the half-size of the box along each axis
+	/// </summary>
+	glm::vec3 GetExtents() const { return (Max - Min) * 0.5f; }
+	/// <summary>
+	/// Gets the radius of the sphere centered on the box that encloses it
+	/// </summary>
+	float GetRadius() const { return IsValid() ? glm::length(GetExtents()) : 0.0f; }
+
+	/// <summary>
+	/// Gets the surface area of the box, used as the cost heuristic when building bounding volume hierarchies
+	/// </summary>
+	float GetSurfaceArea() const {
+		glm::vec3 size = Max - Min;
+		return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+	}
+
+	/// <summary>
+	/// Returns true if this box completely contains another box
+	/// </summary>
+	bool Contains(const AABB& other) const {
+		return
+			Min.x <= other.Min.x && Min.y <= other.Min.y && Min.z <= other.Min.z &&
+			Max.x >= other.Max.x && Max.y >= other.Max.y && Max.z >= other.Max.z;
+	}
+
+	/// <summary>
+	/// Returns true if this box overlaps another box
+	/// </summary>
+	bool Intersects(const AABB& other) const {
+		return
+			Min.x <= other.Max.x && Min.y <= other.Max.y && Min.z <= other.Max.z &&
+			Max.x >= other.Min.x && Max.y >= other.Min.y && Max.z >= other.Min.z;
+	}
+
+	/// <summary>
+	/// Gets a copy of this box that has been grown by the given amount in every direction
+	/// </summary>
+	AABB Inflated(float amount) const {
+		return AABB(Min - glm::vec3(amount), Max + glm::vec3(amount));
+	}
+
+	/// <summary>
+	/// Transforms this box by an affine matrix, returning the axis aligned box that encloses the result
+	/// </summary>
+	/// <see>Jim Arvo, "Transforming Axis-Aligned Bounding Boxes", Graphics Gems 1990</see>
+	AABB Transform(const glm::mat4& transform) const {
+		if (!IsValid()) {
+			return AABB();
+		}
+		// Each axis of the matrix either grows the min or the max, depending on its sign
+		glm::vec3 center  = glm::vec3(transform * glm::vec4(GetCenter(), 1.0f));
+		glm::vec3 extents = GetExtents();
+		glm::vec3 newExtents =
+			glm::abs(glm::vec3(transform[0])) * extents.x +
+			glm::abs(glm::vec3(transform[1])) * extents.y +
+			glm::abs(glm::vec3(transform[2])) * extents.z;
+		return AABB(center - newExtents, center + newExtents);
+	}
+
+	/// <summary>
+	/// Grows the box to contain the given point
+	/// </summary>
+	void Expand(const glm::vec3& point) {
+		Min = glm::min(Min, point);
+		Max = glm::max(Max, point);
+	}
+	/// <summary>
+	/// Grows the box to contain another box
+	/// </summary>
+	void Expand(const AABB& other) {
+		if (other.IsValid()) {
+			Min = glm::min(Min, other.Min);
+			Max = glm::max(Max, other.Max);
+		}
+	}
+
+	/// <summary>
+	/// Calculates the bounds of a set of positions stored in an interleaved vertex buffer
+	/// </summary>
+	/// <param name="positions">A pointer to the first vertex position (3 floats)</param>
+	/// <param name="stride">The number of bytes between consecutive positions</param>
+	/// <param name="count">The number of positions to read</param>
+	static AABB FromPoints(const void* positions, size_t stride, size_t count) {
+		AABB result;
+		const uint8_t* bytes = static_cast<const uint8_t*>(positions);
+		for (size_t ix = 0; ix < count; ix++) {
+			glm::vec3 point;
+			memcpy(&point, bytes + ix * stride, sizeof(glm::vec3));
+			result.Expand(point);
+		}
+		return result;
+	}
+};
+
+/// <summary>
+/// The result of testing a volume against a frustum
+/// </summary>
+ENUM(FrustumTest, uint8_t,
+	Outside    = 0,
+	Intersects = 1,
+	Inside     = 2
+);
+
+/// <summary>
+/// A view frustum, stored as six planes whose normals point inwards
+/// </summary>
+/// <see>Gribb and Hartmann, "Fast Extraction of Viewing Frustum Planes from the World-View-Projection Matrix"</see>
+struct Frustum {
+	// Left, right, bottom, top, near, far, as (normal, distance)
+	glm::vec4 Planes[6];
+
+	// A plane mask with all six planes enabled
+	static constexpr uint8_t ALL_PLANES = 0x3F;
+
+	Frustum() = default;
+
+	/// <summary>
+	/// Extracts the frustum planes from an OpenGL view projection matrix, the resulting planes
+	/// are in whatever space the matrix transforms from (so world space for projection * view)
+	/// </summary>
+	explicit Frustum(const glm::mat4& viewProjection) {
+		// GLM matrices are column major, so grab the rows of the matrix
+		glm::vec4 rows[4];
+		for (int ix = 0; ix < 4; ix++) {
+			rows[ix] = glm::vec4(viewProjection[0][ix], viewProjection[1][ix], viewProjection[2][ix], viewProjection[3][ix]);
+		}
+		Planes[0] = rows[3] + rows[0];
+		Planes[1] = rows[3] - rows[0];
+		Planes[2] = rows[3] + rows[1];
+		Planes[3] = rows[3] - rows[1];
+		Planes[4] = rows[3] + rows[2];
+		Planes[5] = rows[3] - rows[2];
+		for (glm::vec4& plane : Planes) {
+			float length = glm::length(glm::vec3(plane));
+			plane = length > 0.0f ? plane / length : plane;
+		}
+	}
+
+	/// <summary>
+	/// Tests a box against the frustum
+	/// </summary>
+	/// <param name="box">The box to test</param>
+	/// <param name="planeMask">
+	/// The planes to test against. On return, planes that the box is fully inside of are cleared, so that the
+	/// mask can be passed down to any volumes contained by the box (this is what makes hierarchical culling cheap)
+	/// </param>
+	/// <returns>Whether the box is outside, inside, or crossing the frustum</returns>
+	FrustumTest Test(const AABB& box, uint8_t& planeMask) const {
+		glm::vec3 center  = box.GetCenter();
+		glm::vec3 extents = box.GetExtents();
+		for (int ix = 0; ix < 6; ix++) {
+			uint8_t bit = 1 << ix;
+			if ((planeMask & bit) == 0) {
+				continue;
+			}
+			// Find how far the box's center is from the plane, and how far the box reaches towards the plane
+			glm::vec3 normal = glm::vec3(Planes[ix]);
+			float distance = glm::dot(normal, center) + Planes[ix].w;
+			float reach    = glm::dot(glm::abs(normal), extents);
+			if (distance + reach < 0.0f) {
+				return FrustumTest::Outside;
+			}
+			if (distance - reach >= 0.0f) {
+				planeMask &= ~bit;
+			}
+		}
+		return planeMask == 0 ? FrustumTest::Inside : FrustumTest::Intersects;
+	}
+
+	/// <summary>
+	/// Tests a box against all planes of the frustum
+	/// </summary>
+	FrustumTest Test(const AABB& box) const {
+		uint8_t planeMask = ALL_PLANES;
+		return Test(box, planeMask);
+	}
+};
@@ -0,0 +1,232 @@
+#include "Utils/DynamicBvh.h"
+
+#include <algorithm>
+
+DynamicBvh::DynamicBvh(float margin) :
+	_nodes(),
+	_root(NULL_NODE),
+	_freeList(NULL_NODE),
+	_proxyCount(0),
+	_margin(margin),
+	_stack()
+{ }
+
+uint32_t DynamicBvh::Insert(const AABB& bounds, void* userData) {
+	uint32_t proxy = _AllocateNode();
+	Node& node = _nodes[proxy];
+	node.Bounds   = bounds.Inflated(_margin);
+	node.UserData = userData;
+	node.Height   = 0;
+
+	_InsertLeaf(proxy);
+	_proxyCount++;
+	return proxy;
+}
+
+void DynamicBvh::Remove(uint32_t proxy) {
+	_RemoveLeaf(proxy);
+	_FreeNode(proxy);
+	_proxyCount--;
+}
+
+bool DynamicBvh::Update(uint32_t proxy, const AABB& bounds) {
+	// If the object is still within its fat bounds, there's nothing to do
+	if (_nodes[proxy].Bounds.Contains(bounds)) {
+		return false;
+	}
+
+	_RemoveLeaf(proxy);
+	_nodes[proxy].Bounds = bounds.Inflated(_margin);
+	_InsertLeaf(proxy);
+	return true;
+}
+
+void DynamicBvh::Clear() {
+	_nodes.clear();
+	_root       = NULL_NODE;
+	_freeList   = NULL_NODE;
+	_proxyCount = 0;
+}
+
+uint32_t DynamicBvh::_AllocateNode() {
+	// Grow the node pool if we've run out of free nodes
+	if (_freeList == NULL_NODE) {
+		_nodes.emplace_back();
+		return static_cast<uint32_t>(_nodes.size() - 1);
+	}
+
+	uint32_t result = _freeList;
+	_freeList = _nodes[result].Parent;
+	_nodes[result] = Node();
+	return result;
+}
+
+void DynamicBvh::_FreeNode(uint32_t node) {
+	_nodes[node].Parent   = _freeList;
+	_nodes[node].Height   = -1;
+	_nodes[node].UserData = nullptr;
+	_freeList = node;
+}
+
+void DynamicBvh::_InsertLeaf(uint32_t leaf) {
+	if (_root == NULL_NODE) {
+		_root = leaf;
+		_nodes[_root].Parent = NULL_NODE;
+		return;
+	}
+
+	// Walk down the tree to find the best sibling for our leaf, using the surface area heuristic
+	const AABB leafBounds = _nodes[leaf].Bounds;
+	uint32_t index = _root;
+	while (!_nodes[index].IsLeaf()) {
+		const Node& node = _nodes[index];
+		uint32_t child0 = node.Children[0];
+		uint32_t child1 = node.Children[1];
+
+		float area = node.Bounds.GetSurfaceArea();
+		AABB combined = node.Bounds;
+		combined.Expand(leafBounds);
+		float combinedArea = combined.GetSurfaceArea();
+
+		// Cost of creating a new parent for this node and the new leaf
+		float cost = 2.0f * combinedArea;
+		// Minimum cost of pushing the leaf further down the tree
+		float inheritanceCost = 2.0f * (combinedArea - area);
+
+		// Cost of descending into each child
+		auto descendCost = [&](uint32_t child) {
+			AABB bounds = leafBounds;
+			bounds.Expand(_nodes[child].Bounds);
+			float newArea = bounds.GetSurfaceArea();
+			return _nodes[child].IsLeaf() ?
+				newArea + inheritanceCost :
+				(newArea - _nodes[child].Bounds.GetSurfaceArea()) + inheritanceCost;
+		};
+		float cost0 = descendCost(child0);
+		float cost1 = descendCost(child1);
+
+		if (cost < cost0 && cost < cost1) {
+			break;
+		}
+		index = cost0 < cost1 ? child0 : child1;
+	}
+	uint32_t sibling = index;
+
+	// Create a new parent to hold the sibling and our new leaf
+	uint32_t oldParent = _nodes[sibling].Parent;
+	uint32_t newParent = _AllocateNode();
+	_nodes[newParent].Parent   = oldParent;
+	_nodes[newParent].UserData = nullptr;
+	_nodes[newParent].Bounds   = leafBounds;
+	_nodes[newParent].Bounds.Expand(_nodes[sibling].Bounds);
+	_nodes[newParent].Height   = _nodes[sibling].Height + 1;
+	_nodes[newParent].Children[0] = sibling;
+	_nodes[newParent].Children[1] = leaf;
+	_nodes[sibling].Parent = newParent;
+	_nodes[leaf].Parent    = newParent;
+
+	if (oldParent != NULL_NODE) {
+		Node& parent = _nodes[oldParent];
+		parent.Children[parent.Children[0] == sibling ? 0 : 1] = newParent;
+	} else {
+		_root = newParent;
+	}
+
+	// Walk back up the tree fixing heights and bounds
+	_RefitAncestors(_nodes[leaf].Parent);
+}
+
+void DynamicBvh::_RemoveLeaf(uint32_t leaf) {
+	if (leaf == _root) {
+		_root = NULL_NODE;
+		return;
+	}
+
+	// The leaf's sibling takes the place of their parent
+	uint32_t parent      = _nodes[leaf].Parent;
+	uint32_t grandParent = _nodes[parent].Parent;
+	uint32_t sibling     = _nodes[parent].Children[0] == leaf ? _nodes[parent].Children[1] : _nodes[parent].Children[0];
+
+	if (grandParent != NULL_NODE) {
+		Node& node = _nodes[grandParent];
+		node.Children[node.Children[0] == parent ? 0 : 1] = sibling;
+		_nodes[sibling].Parent = grandParent;
+		_FreeNode(parent);
+		_RefitAncestors(grandParent);
+	} else {
+		_root = sibling;
+		_nodes[sibling].Parent = NULL_NODE;
+		_FreeNode(parent);
+	}
+}
+
+void DynamicBvh::_RefitAncestors(uint32_t index) {
+	while (index != NULL_NODE) {
+		index = _Balance(index);
+
+		Node& node = _nodes[index];
+		const Node& child0 = _nodes[node.Children[0]];
+		const Node& child1 = _nodes[node.Children[1]];
+		node.Height = 1 + std::max(child0.Height, child1.Height);
+		node.Bounds = child0.Bounds;
+		node.Bounds.Expand(child1.Bounds);
+
+		index = node.Parent;
+	}
+}
+
+uint32_t DynamicBvh::_Balance(uint32_t a) {
+	// Performs a left or right rotation if node A is imbalanced, returns the new root of the subtree
+	Node& nodeA = _nodes[a];
+	if (nodeA.IsLeaf() || nodeA.Height < 2) {
+		return a;
+	}
+
+	uint32_t b = nodeA.Children[0];
+	uint32_t c = nodeA.Children[1];
+	int32_t balance = _nodes[c].Height - _nodes[b].Height;
+
+	// Rotates the taller child up to take A's place, and moves A down to be one of its children
+	auto rotate = [&](uint32_t up, uint32_t other, int upSlot) {
+		Node& nodeUp = _nodes[up];
+		uint32_t f = nodeUp.Children[0];
+		uint32_t g = nodeUp.Children[1];
+
+		nodeUp.Children[0] = a;
+		nodeUp.Parent = nodeA.Parent;
+		nodeA.Parent = up;
+
+		if (nodeUp.Parent != NULL_NODE) {
+			Node& parent = _nodes[nodeUp.Parent];
+			parent.Children[parent.Children[0] == a ? 0 : 1] = up;
+		} else {
+			_root = up;
+		}
+
+		// Keep the taller of up's children, and give the shorter one to A
+		uint32_t keep  = _nodes[f].Height > _nodes[g].Height ? f : g;
+		uint32_t give  = keep == f ? g : f;
+		nodeUp.Children[1] = keep;
+		nodeA.Children[upSlot] = give;
+		_nodes[give].Parent = a;
+
+		nodeA.Bounds = _nodes[other].Bounds;
+		nodeA.Bounds.Expand(_nodes[give].Bounds);
+		nodeUp.Bounds = nodeA.Bounds;
+		nodeUp.Bounds.Expand(_nodes[keep].Bounds);
+
+		nodeA.Height  = 1 + std::max(_nodes[other].Height, _nodes[give].Height);
+		nodeUp.Height = 1 + std::max(nodeA.Height, _nodes[keep].Height);
+		return up;
+	};
+
+	// C is too tall, rotate it up
+	if (balance > 1) {
+		return rotate(c, b, 1);
+	}
+	// B is too tall, rotate it up
+	if (balance < -1) {
+		return rotate(b, c, 0);
+	}
+	return a;
+}
@@ -0,0 +1,144 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "Utils/BoundingVolumes.h"
+
+/// <summary>
+/// A dynamic bounding volume hierarchy over axis aligned boxes, in the style of Box2D's dynamic tree.
+/// Leaves are stored with "fat" bounds that are slightly larger than the real bounds, so objects that
+/// move a small amount don't need to be re-inserted every frame. The tree is kept balanced with AVL
+/// style rotations, and new leaves are placed using the surface area heuristic
+/// </summary>
+/// <see>https://box2d.org/files/ErinCatto_DynamicBVH_Full.pdf</see>
+class DynamicBvh {
+public:
+	/// <summary>
+	/// Value used to represent an invalid node or proxy
+	/// </summary>
+	static constexpr uint32_t NULL_NODE = ~0u;
+
+	/// <summary>
+	/// Creates a new empty tree
+	/// </summary>
+	/// <param name="margin">The amount that leaf bounds are grown by, to avoid re-inserting objects that are moving slightly</param>
+	DynamicBvh(float margin = 0.1f);
+	~DynamicBvh() = default;
+
+	/// <summary>
+	/// Inserts a new object into the tree
+	/// </summary>
+	/// <param name="bounds">The bounds of the object</param>
+	/// <param name="userData">A user defined pointer that will be handed back when the object is found in a query</param>
+	/// <returns>The proxy ID for the object, used to update or remove it later</returns>
+	uint32_t Insert(const AABB& bounds, void* userData);
+	/// <summary>
+	/// Removes an object from the tree
+	/// </summary>
+	/// <param name="proxy">The proxy ID returned by Insert</param>
+	void Remove(uint32_t proxy);
+	/// <summary>
+	/// Updates the bounds of an object in the tree, the object is only re-inserted if it has left its fat bounds
+	/// </summary>
+	/// <param name="proxy">The proxy ID returned by Insert</param>
+	/// <param name="bounds">The new bounds of the object</param>
+	/// <returns>True if the object was re-inserted, false if otherwise</returns>
+	bool Update(uint32_t proxy, const AABB& bounds);
+	/// <summary>
+	/// Removes all objects from the tree
+	/// </summary>
+	void Clear();
+
+	/// <summary>
+	/// Gets the user data that an object was inserted with
+	/// </summary>
+	void* GetUserData(uint32_t proxy) const { return _nodes[proxy].UserData; }
+	/// <summary>
+	/// Gets the fat bounds that are stored in the tree for an object
+	/// </summary>
+	const AABB& GetFatBounds(uint32_t proxy) const { return _nodes[proxy].Bounds; }
+	/// <summary>
+	/// Gets the number of objects in the tree
+	/// </summary>
+	uint32_t GetProxyCount() const { return _proxyCount; }
+	/// <summary>
+	/// Gets the height of the tree, a leaf has a height of 0
+	/// </summary>
+	int32_t GetHeight() const { return _root == NULL_NODE ? 0 : _nodes[_root].Height; }
+
+	/// <summary>
+	/// Finds all objects whose fat bounds are at least partially inside a frustum. Any subtree that is
+	/// completely inside the frustum is accepted without testing the objects inside it
+	/// </summary>
+	/// <typeparam name="Callback">A callable with the signature void(void* userData)</typeparam>
+	/// <param name="frustum">The frustum to test against</param>
+	/// <param name="callback">The function to invoke for each visible object</param>
+	/// <returns>The number of nodes in the tree that had to be tested against the frustum</returns>
+	template <typename Callback>
+	uint32_t Query(const Frustum& frustum, Callback&& callback) const;
+
+protected:
+	struct Node {
+		// The fat bounds for leaves, or the union of the children for internal nodes
+		AABB     Bounds;
+		void*    UserData = nullptr;
+		// The parent of the node, or the next free node if this node is on the free list
+		uint32_t Parent = NULL_NODE;
+		uint32_t Children[2] = { NULL_NODE, NULL_NODE };
+		// Leaves have a height of 0, free nodes have a height of -1
+		int32_t  Height = -1;
+
+		bool IsLeaf() const { return Children[0] == NULL_NODE; }
+	};
+
+	std::vector<Node> _nodes;
+	uint32_t          _root;
+	uint32_t          _freeList;
+	uint32_t          _proxyCount;
+	float             _margin;
+
+	// Scratch stack for queries, so we don't allocate every frame
+	mutable std::vector<std::pair<uint32_t, uint8_t>> _stack;
+
+	uint32_t _AllocateNode();
+	void _FreeNode(uint32_t node);
+	void _InsertLeaf(uint32_t leaf);
+	void _RemoveLeaf(uint32_t leaf);
+	uint32_t _Balance(uint32_t node);
+	void _RefitAncestors(uint32_t node);
+};
+
+template <typename Callback>
+uint32_t DynamicBvh::Query(const Frustum& frustum, Callback&& callback) const {
+	uint32_t tested = 0;
+	if (_root == NULL_NODE) {
+		return tested;
+	}
+
+	// Each stack entry stores the planes that the node still needs to be tested against
+	_stack.clear();
+	_stack.emplace_back(_root, Frustum::ALL_PLANES);
+	while (!_stack.empty()) {
+		auto [index, planeMask] = _stack.back();
+		_stack.pop_back();
+		const Node& node = _nodes[index];
+
+		// Once a node is fully inside, every plane has been cleared from the mask and we can skip testing
+		FrustumTest result = FrustumTest::Inside;
+		if (planeMask != 0) {
+			tested++;
+			result = frustum.Test(node.Bounds, planeMask);
+		}
+		if (result == FrustumTest::Outside) {
+			continue;
+		}
+
+		if (node.IsLeaf()) {
+			callback(node.UserData);
+		} else {
+			_stack.emplace_back(node.Children[1], planeMask);
+			_stack.emplace_back(node.Children[0], planeMask);
+		}
+	}
+	return tested;
+}
@@ -0,0 +1,52 @@
+#include "Utils/HashUtils.h"
+
+#include <cstring>
+
+#include "Utils/MemoryMappedFile.h"
+
+namespace {
+	constexpr uint64_t PRIME = 0x100000001b3ull;
+
+	inline uint64_t Rotate(uint64_t value, int amount) {
+		return (value << amount) | (value >> (64 - amount));
+	}
+
+	// Final avalanche step, spreads the entropy from the last few bytes over the whole result
+	inline uint64_t Finalize(uint64_t value) {
+		value ^= value >> 33;
+		value *= 0xff51afd7ed558ccdull;
+		value ^= value >> 33;
+		value *= 0xc4ceb9fe1a85ec53ull;
+		value ^= value >> 33;
+		return value;
+	}
+}
+
+uint64_t HashUtils::Hash(const void* data, size_t size, uint64_t seed) {
+	const uint8_t* bytes = static_cast<const uint8_t*>(data);
+	uint64_t result = seed ^ (size * PRIME);
+
+	// Handle the bulk of the data as 64 bit words, this is much faster than a byte-wise FNV
+	size_t words = size / sizeof(uint64_t);
+	for (size_t ix = 0; ix < words; ix++) {
+		uint64_t word;
+		memcpy(&word, bytes + ix * sizeof(uint64_t), sizeof(uint64_t));
+		result = Rotate(result ^ (word * 0x87c37b91114253d5ull), 31) * PRIME;
+	}
+
+	// Handle any leftovers one byte at a time
+	for (size_t ix = words * sizeof(uint64_t); ix < size; ix++) {
+		result = (result ^ bytes[ix]) * PRIME;
+	}
+
+	return Finalize(result);
+}
+
+bool HashUtils::HashFile(const std::string& filename, uint64_t& result) {
+	MemoryMappedFile file;
+	if (!file.Open(filename)) {
+		return false;
+	}
+	result = Hash(file.GetData(), file.GetSize());
+	return true;
+}
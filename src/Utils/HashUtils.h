@@ -0,0 +1,52 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+/// <summary>
+/// Provides helpers for generating stable 64 bit hashes of data. Unlike std::hash, these
+/// hashes are identical across runs and platforms, so they can be stored in files on disk
+/// and used to detect when a cached file is out of date
+/// </summary>
+class HashUtils {
+public:
+	HashUtils() = delete;
+
+	/// <summary>
+	/// The value hashes start at if no seed is provided
+	/// </summary>
+	static constexpr uint64_t DEFAULT_SEED = 0xcbf29ce484222325ull;
+
+	/// <summary>
+	/// Hashes a block of memory, processing 8 bytes at a time
+	/// </summary>
+	/// <param name="data">The data to hash</param>
+	/// <param name="size">The number of bytes in data</param>
+	/// <param name="seed">The seed for the hash, can be used to chain together multiple blocks</param>
+	/// <returns>A 64 bit hash of the data</returns>
+	static uint64_t Hash(const void* data, size_t size, uint64_t seed = DEFAULT_SEED);
+
+	/// <summary>
+	/// Hashes the contents of a string
+	/// </summary>
+	/// <param name="value">The string to hash</param>
+	/// <param name="seed">The seed for the hash, can be used to chain together multiple blocks</param>
+	/// <returns>A 64 bit hash of the string</returns>
+	static uint64_t Hash(const std::string& value, uint64_t seed = DEFAULT_SEED) {
+		return Hash(value.data(), value.size(), seed);
+	}
+
+	/// <summary>
+	/// Hashes the entire contents of a file on disk
+	/// </summary>
+	/// <param name="filename">The path to the file to hash</param>
+	/// <param name="result">Will be set to the hash of the file's contents</param>
+	/// <returns>True if the file could be read, false if otherwise</returns>
+	static bool HashFile(const std::string& filename, uint64_t& result);
+
+	/// <summary>
+	/// Combines two hashes into one, order dependent
+	/// </summary>
+	static uint64_t Combine(uint64_t seed, uint64_t value) {
+		return seed ^ (value + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2));
+	}
+};
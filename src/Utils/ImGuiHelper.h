@@ -84,7 +84,7 @@ public:
 
 	static bool DrawTextureDrop(Texture2D::Sptr& image, ImVec2 size);
 
-	static void DrawLinearDepthTexture(const Texture2D::Sptr& image, const glm::ivec2& size, float zNear, float zFar);
+	static void DrawLinearDepthTexture(const Texture2D::Sptr& image, const glm::ivec2& size, float zNear, float zFar, const glm::vec2& uvMin = glm::vec2(0.0f), const glm::vec2& uvMax = glm::vec2(1.0f));
 
 	static void DrawTextureArraySlice(const Texture2DArray::Sptr& image, uint32_t slice, const glm::ivec2& size, const ImVec4& border = ImVec4(0, 0, 0, 0));
 
@@ -0,0 +1,188 @@
+#include "Utils/JobSystem.h"
+
+#include <algorithm>
+#include <Logging.h>
+
+namespace {
+	// The queue that the current thread pushes to and pops from, 0 for non-worker threads
+	thread_local uint32_t t_QueueIndex = 0;
+	// How many jobs the current thread is running, jobs can run other jobs while they wait
+	thread_local uint32_t t_JobDepth = 0;
+}
+
+void JobSystem::Init(uint32_t workerCount) {
+	LOG_ASSERT(_queues.empty(), "Job system has already been initialized!");
+
+	if (workerCount == 0) {
+		workerCount = std::max(1u, std::thread::hardware_concurrency()) - 1;
+	}
+
+	_isShuttingDown = false;
+	_pendingTasks = 0;
+	for (uint32_t ix = 0; ix <= workerCount; ix++) {
+		_queues.push_back(std::make_unique<WorkQueue>());
+	}
+	for (uint32_t ix = 1; ix <= workerCount; ix++) {
+		_workers.emplace_back(&JobSystem::_WorkerMain, ix);
+	}
+
+	LOG_INFO("Started job system with {} worker threads", workerCount);
+}
+
+void JobSystem::Shutdown() {
+	if (_queues.empty()) {
+		return;
+	}
+
+	// Workers will finish any remaining tasks before they exit
+	{
+		std::lock_guard<std::mutex> lock(_sleepMutex);
+		_isShuttingDown = true;
+	}
+	_wakeCondition.notify_all();
+	for (std::thread& worker : _workers) {
+		worker.join();
+	}
+	_workers.clear();
+
+	// Anything that was left on the main thread's queue gets run now
+	while (_TryRunTask(0)) { }
+	_queues.clear();
+}
+
+uint32_t JobSystem::GetWorkerCount() {
+	return static_cast<uint32_t>(_workers.size());
+}
+
+bool JobSystem::IsInJob() {
+	return t_JobDepth > 0;
+}
+
+void JobSystem::Run(Job job, Counter* counter) {
+	Task task;
+	task.Function = std::move(job);
+	task.Group = counter;
+
+	if (counter != nullptr) {
+		counter->_value.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	// Without any workers, just run the job now
+	if (_workers.empty()) {
+		_Execute(task);
+		return;
+	}
+
+	WorkQueue& queue = *_queues[_GetQueueIndex()];
+	{
+		std::lock_guard<std::mutex> lock(queue.Mutex);
+		queue.Tasks.push_back(std::move(task));
+	}
+	_pendingTasks.fetch_add(1, std::memory_order_release);
+
+	// Lock before notifying so that a worker can't miss the wake up between checking for work and sleeping
+	{
+		std::lock_guard<std::mutex> lock(_sleepMutex);
+	}
+	_wakeCondition.notify_one();
+}
+
+void JobSystem::Wait(Counter& counter) {
+	uint32_t queueIndex = _GetQueueIndex();
+	while (!counter.IsDone()) {
+		if (_queues.empty() || !_TryRunTask(queueIndex)) {
+			std::this_thread::yield();
+		}
+	}
+}
+
+void JobSystem::ParallelFor(size_t count, size_t batchSize, const std::function<void(size_t begin, size_t end)>& body) {
+	if (count == 0) {
+		return;
+	}
+	batchSize = std::max<size_t>(batchSize, 1);
+
+	// Not worth queueing anything if there's only one batch. It still counts as a job, so that the body
+	// sees the same IsInJob() no matter how many batches it was split into
+	if (count <= batchSize || _workers.empty()) {
+		t_JobDepth++;
+		body(0, count);
+		t_JobDepth--;
+		return;
+	}
+
+	Counter counter;
+	for (size_t begin = batchSize; begin < count; begin += batchSize) {
+		size_t end = std::min(begin + batchSize, count);
+		Run([&body, begin, end]() { body(begin, end); }, &counter);
+	}
+
+	// Do the first batch ourselves, then help with the rest
+	t_JobDepth++;
+	body(0, batchSize);
+	t_JobDepth--;
+	Wait(counter);
+}
+
+void JobSystem::_WorkerMain(uint32_t queueIndex) {
+	t_QueueIndex = queueIndex;
+	while (true) {
+		if (_TryRunTask(queueIndex)) {
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(_sleepMutex);
+		_wakeCondition.wait(lock, []() {
+			return _pendingTasks.load(std::memory_order_acquire) > 0 || _isShuttingDown;
+		});
+		if (_isShuttingDown && _pendingTasks.load(std::memory_order_acquire) == 0) {
+			return;
+		}
+	}
+}
+
+bool JobSystem::_TryRunTask(uint32_t queueIndex) {
+	Task task;
+	bool found = false;
+
+	// Newest task from our own queue first, since it's most likely to still be in cache
+	{
+		WorkQueue& queue = *_queues[queueIndex];
+		std::lock_guard<std::mutex> lock(queue.Mutex);
+		if (!queue.Tasks.empty()) {
+			task = std::move(queue.Tasks.back());
+			queue.Tasks.pop_back();
+			found = true;
+		}
+	}
+
+	// Otherwise steal the oldest task from someone else
+	for (size_t offset = 1; !found && offset < _queues.size(); offset++) {
+		WorkQueue& queue = *_queues[(queueIndex + offset) % _queues.size()];
+		std::lock_guard<std::mutex> lock(queue.Mutex);
+		if (!queue.Tasks.empty()) {
+			task = std::move(queue.Tasks.front());
+			queue.Tasks.pop_front();
+			found = true;
+		}
+	}
+
+	if (found) {
+		_pendingTasks.fetch_sub(1, std::memory_order_acq_rel);
+		_Execute(task);
+	}
+	return found;
+}
+
+void JobSystem::_Execute(Task& task) {
+	t_JobDepth++;
+	task.Function();
+	t_JobDepth--;
+	if (task.Group != nullptr) {
+		task.Group->_value.fetch_sub(1, std::memory_order_release);
+	}
+}
+
+uint32_t JobSystem::_GetQueueIndex() {
+	return t_QueueIndex < _queues.size() ? t_QueueIndex : 0;
+}
@@ -0,0 +1,113 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Utils/Macros.h"
+
+/// <summary>
+/// A small work stealing job system. Each worker thread has its own queue of jobs that it takes work
+/// from the back of, and when it runs out it steals jobs from the front of the other queues. Threads
+/// that wait on jobs help out by running queued jobs instead of blocking
+///
+/// Jobs must not throw, and must not touch OpenGL, since only the main thread has a context.
+/// If the job system has not been initialized, jobs are run immediately on the calling thread
+/// </summary>
+class JobSystem {
+public:
+	typedef std::function<void()> Job;
+
+	/// <summary>
+	/// Tracks the number of unfinished jobs in a group, so that a thread can wait on the group
+	/// </summary>
+	class Counter {
+	public:
+		NO_COPY(Counter);
+		NO_MOVE(Counter);
+
+		Counter() : _value(0) { }
+
+		/// <summary>
+		/// Returns true if every job that was added with this counter has finished
+		/// </summary>
+		bool IsDone() const { return _value.load(std::memory_order_acquire) == 0; }
+
+	private:
+		friend class JobSystem;
+		std::atomic<uint32_t> _value;
+	};
+
+	JobSystem() = delete;
+
+	/// <summary>
+	/// Starts the worker threads
+	/// </summary>
+	/// <param name="workerCount">The number of worker threads to start, or 0 to use one less than the number of hardware threads</param>
+	static void Init(uint32_t workerCount = 0);
+	/// <summary>
+	/// Finishes any remaining jobs and stops the worker threads
+	/// </summary>
+	static void Shutdown();
+
+	/// <summary>
+	/// Gets the number of worker threads, not including the main thread
+	/// </summary>
+	static uint32_t GetWorkerCount();
+	/// <summary>
+	/// Returns true if the calling thread is currently running a job
+	/// </summary>
+	static bool IsInJob();
+
+	/// <summary>
+	/// Queues a job to be run on any thread
+	/// </summary>
+	/// <param name="job">The job to run</param>
+	/// <param name="counter">An optional counter that can be used to wait for the job</param>
+	static void Run(Job job, Counter* counter = nullptr);
+	/// <summary>
+	/// Waits for every job added with the given counter to finish, running queued jobs while waiting
+	/// </summary>
+	static void Wait(Counter& counter);
+
+	/// <summary>
+	/// Splits a range into batches and runs them in parallel, returning once every batch has finished.
+	/// The calling thread runs the first batch itself. Every batch runs as a job, so IsInJob() is true inside
+	/// the body even when the range fits in a single batch
+	/// </summary>
+	/// <param name="count">The number of items in the range</param>
+	/// <param name="batchSize">The number of items in each batch</param>
+	/// <param name="body">The function to invoke with the [begin, end) range of each batch</param>
+	static void ParallelFor(size_t count, size_t batchSize, const std::function<void(size_t begin, size_t end)>& body);
+
+private:
+	struct Task {
+		Job      Function;
+		Counter* Group = nullptr;
+	};
+
+	struct WorkQueue {
+		std::mutex       Mutex;
+		std::deque<Task> Tasks;
+	};
+
+	// Queue 0 belongs to the main thread (and any other thread that isn't a worker), the rest to the workers
+	inline static std::vector<std::unique_ptr<WorkQueue>> _queues;
+	inline static std::vector<std::thread>                _workers;
+	inline static std::atomic<uint32_t>                   _pendingTasks = 0;
+	inline static std::atomic<bool>                       _isShuttingDown = false;
+	// Idle workers sleep on this until a task is queued
+	inline static std::mutex                              _sleepMutex;
+	inline static std::condition_variable                 _wakeCondition;
+
+	static void _WorkerMain(uint32_t queueIndex);
+	static bool _TryRunTask(uint32_t queueIndex);
+	static void _Execute(Task& task);
+	static uint32_t _GetQueueIndex();
+};
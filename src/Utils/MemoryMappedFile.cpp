@@ -0,0 +1,155 @@
+#include "Utils/MemoryMappedFile.h"
+
+#include <Logging.h>
+
+#ifdef WINDOWS
+	#ifndef WIN32_LEAN_AND_MEAN
+		#define WIN32_LEAN_AND_MEAN
+	#endif
+	#ifndef NOMINMAX
+		#define NOMINMAX
+	#endif
+	#include <Windows.h>
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+MemoryMappedFile::MemoryMappedFile() :
+	_data(nullptr),
+	_size(0),
+	_isOpen(false),
+	_fileHandle(-1),
+	_mappingHandle(-1)
+{ }
+
+MemoryMappedFile::MemoryMappedFile(const std::string& filename) :
+	MemoryMappedFile()
+{
+	Open(filename);
+}
+
+MemoryMappedFile::~MemoryMappedFile() {
+	Close();
+}
+
+#ifdef WINDOWS
+
+bool MemoryMappedFile::Open(const std::string& filename) {
+	Close();
+
+	HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		LOG_WARN("Failed to open \"{}\" for mapping", filename);
+		return false;
+	}
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size)) {
+		CloseHandle(file);
+		LOG_WARN("Failed to query size of \"{}\"", filename);
+		return false;
+	}
+
+	_fileHandle = reinterpret_cast<intptr_t>(file);
+	_size       = static_cast<size_t>(size.QuadPart);
+	_isOpen     = true;
+
+	// Windows will not map an empty file, but an empty file is still a valid file
+	if (_size == 0) {
+		return true;
+	}
+
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mapping == nullptr) {
+		LOG_WARN("Failed to create file mapping for \"{}\"", filename);
+		Close();
+		return false;
+	}
+	_mappingHandle = reinterpret_cast<intptr_t>(mapping);
+
+	_data = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+	if (_data == nullptr) {
+		LOG_WARN("Failed to map view of \"{}\"", filename);
+		Close();
+		return false;
+	}
+
+	return true;
+}
+
+void MemoryMappedFile::Close() {
+	if (_data != nullptr) {
+		UnmapViewOfFile(_data);
+	}
+	if (_mappingHandle != -1) {
+		CloseHandle(reinterpret_cast<HANDLE>(_mappingHandle));
+	}
+	if (_fileHandle != -1) {
+		CloseHandle(reinterpret_cast<HANDLE>(_fileHandle));
+	}
+
+	_data          = nullptr;
+	_size          = 0;
+	_isOpen        = false;
+	_fileHandle    = -1;
+	_mappingHandle = -1;
+}
+
+#else
+
+bool MemoryMappedFile::Open(const std::string& filename) {
+	Close();
+
+	int file = open(filename.c_str(), O_RDONLY);
+	if (file < 0) {
+		LOG_WARN("Failed to open \"{}\" for mapping", filename);
+		return false;
+	}
+
+	struct stat info;
+	if (fstat(file, &info) != 0) {
+		close(file);
+		LOG_WARN("Failed to query size of \"{}\"", filename);
+		return false;
+	}
+
+	_fileHandle = file;
+	_size       = static_cast<size_t>(info.st_size);
+	_isOpen     = true;
+
+	// mmap will reject zero-length mappings, but an empty file is still a valid file
+	if (_size == 0) {
+		return true;
+	}
+
+	void* data = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, file, 0);
+	if (data == MAP_FAILED) {
+		LOG_WARN("Failed to map \"{}\"", filename);
+		Close();
+		return false;
+	}
+	madvise(data, _size, MADV_SEQUENTIAL);
+	_data = static_cast<const uint8_t*>(data);
+
+	return true;
+}
+
+void MemoryMappedFile::Close() {
+	if (_data != nullptr) {
+		munmap(const_cast<uint8_t*>(_data), _size);
+	}
+	if (_fileHandle != -1) {
+		close(static_cast<int>(_fileHandle));
+	}
+
+	_data          = nullptr;
+	_size          = 0;
+	_isOpen        = false;
+	_fileHandle    = -1;
+	_mappingHandle = -1;
+}
+
+#endif
@@ -0,0 +1,68 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+#include "Utils/Macros.h"
+
+/// <summary>
+/// A read-only view of a file that has been mapped into our address space by the OS. This lets
+/// us parse or upload large files without first copying them into a temporary buffer, the OS
+/// will page the data in for us as we touch it
+/// </summary>
+class MemoryMappedFile {
+public:
+	MAKE_PTRS(MemoryMappedFile);
+	NO_COPY(MemoryMappedFile);
+	NO_MOVE(MemoryMappedFile);
+
+	MemoryMappedFile();
+	/// <summary>
+	/// Creates a new mapped file and opens the given path
+	/// </summary>
+	/// <param name="filename">The path of the file to map</param>
+	explicit MemoryMappedFile(const std::string& filename);
+	~MemoryMappedFile();
+
+	/// <summary>
+	/// Maps the given file into memory, closing any file that this object already had open
+	/// </summary>
+	/// <param name="filename">The path of the file to map</param>
+	/// <returns>True if the file was opened and mapped, false if otherwise</returns>
+	bool Open(const std::string& filename);
+	/// <summary>
+	/// Unmaps the file and releases any OS handles, invalidating any pointers returned by GetData
+	/// </summary>
+	void Close();
+
+	/// <summary>
+	/// Returns true if a file is currently mapped (note that empty files are open, but have no data)
+	/// </summary>
+	bool IsOpen() const { return _isOpen; }
+	/// <summary>
+	/// Returns a pointer to the start of the mapped data, or nullptr if no file is open
+	/// </summary>
+	const uint8_t* GetData() const { return _data; }
+	/// <summary>
+	/// Returns the size of the mapped file in bytes
+	/// </summary>
+	size_t GetSize() const { return _size; }
+
+	/// <summary>
+	/// Helper for reinterpreting the data at a given byte offset in the file
+	/// </summary>
+	/// <typeparam name="T">The type of data to interpret the bytes as</typeparam>
+	/// <param name="offset">The offset from the start of the file, in bytes</param>
+	template <typename T>
+	const T* GetDataAs(size_t offset = 0) const {
+		return reinterpret_cast<const T*>(_data + offset);
+	}
+
+protected:
+	const uint8_t* _data;
+	size_t         _size;
+	bool           _isOpen;
+
+	// Platform handles, stored as opaque values so we don't need to drag OS headers into this one
+	intptr_t       _fileHandle;
+	intptr_t       _mappingHandle;
+};
@@ -0,0 +1,268 @@
+#include "Utils/MeshOptimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+	// The size of the LRU cache used to score vertices during vertex cache optimization
+	constexpr int32_t SCORE_CACHE_SIZE = 32;
+
+	// Scoring function from Forsyth's paper, vertices that are in the cache score higher, with
+	// the last triangle's vertices being scored lower to avoid strip-like patterns. Vertices with
+	// fewer remaining triangles get a boost so that we don't leave lonely triangles behind
+	float ScoreVertex(int32_t cachePosition, uint32_t remainingTriangles) {
+		if (remainingTriangles == 0) {
+			return -1.0f;
+		}
+
+		float score = 0.0f;
+		if (cachePosition >= 0) {
+			if (cachePosition < 3) {
+				score = 0.75f;
+			} else {
+				const float scale = 1.0f / (SCORE_CACHE_SIZE - 3);
+				score = powf(1.0f - (cachePosition - 3) * scale, 1.5f);
+			}
+		}
+
+		score += 2.0f / sqrtf(static_cast<float>(remainingTriangles));
+		return score;
+	}
+
+	glm::vec3 ReadPosition(const uint8_t* positions, size_t stride, uint32_t index) {
+		glm::vec3 result;
+		memcpy(&result, positions + stride * index, sizeof(glm::vec3));
+		return result;
+	}
+}
+
+float MeshOptimizer::CalculateACMR(const std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize) {
+	if (indices.size() < 3) {
+		return 0.0f;
+	}
+
+	// We can simulate a FIFO cache by tracking when each vertex was last added to the cache,
+	// if more than cacheSize vertices have been added since, it's been pushed out
+	std::vector<uint32_t> timestamps(vertexCount, 0);
+	uint32_t time = cacheSize + 1;
+	size_t misses = 0;
+	for (uint32_t index : indices) {
+		if (time - timestamps[index] > cacheSize) {
+			timestamps[index] = time++;
+			misses++;
+		}
+	}
+
+	return static_cast<float>(misses) / (indices.size() / 3);
+}
+
+MeshOptimizer::Stats MeshOptimizer::CalculateStats(const std::vector<uint32_t>& indices, size_t vertexCount, size_t vertexStride, size_t indexSize) {
+	Stats result;
+	result.ACMR        = CalculateACMR(indices, vertexCount);
+	result.ATVR        = vertexCount > 0 ? result.ACMR * (indices.size() / 3) / vertexCount : 0.0f;
+	result.VertexBytes = vertexCount * vertexStride;
+	result.IndexBytes  = indices.size() * indexSize;
+	return result;
+}
+
+void MeshOptimizer::OptimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount) {
+	const size_t triangleCount = indices.size() / 3;
+	if (triangleCount == 0) {
+		return;
+	}
+
+	// Build a flat vertex -> triangle adjacency list
+	std::vector<uint32_t> remaining(vertexCount, 0);
+	for (uint32_t index : indices) {
+		remaining[index]++;
+	}
+	std::vector<uint32_t> offsets(vertexCount + 1, 0);
+	for (size_t ix = 0; ix < vertexCount; ix++) {
+		offsets[ix + 1] = offsets[ix] + remaining[ix];
+	}
+	std::vector<uint32_t> adjacency(indices.size());
+	{
+		std::vector<uint32_t> cursor(offsets.begin(), offsets.end() - 1);
+		for (size_t ix = 0; ix < indices.size(); ix++) {
+			adjacency[cursor[indices[ix]]++] = static_cast<uint32_t>(ix / 3);
+		}
+	}
+
+	// Calculate our initial scores
+	std::vector<int32_t> cachePosition(vertexCount, -1);
+	std::vector<float>   vertexScores(vertexCount);
+	for (size_t ix = 0; ix < vertexCount; ix++) {
+		vertexScores[ix] = ScoreVertex(-1, remaining[ix]);
+	}
+	std::vector<bool> emitted(triangleCount, false);
+
+	std::vector<uint32_t> result;
+	result.reserve(indices.size());
+
+	// The cache has room for 3 extra entries, so the newest triangle can push the oldest entries out
+	uint32_t cache[SCORE_CACHE_SIZE + 3];
+	uint32_t newCache[SCORE_CACHE_SIZE + 3];
+	int32_t  cacheCount = 0;
+
+	size_t  seekCursor = 0;
+	int64_t best = -1;
+
+	for (size_t emittedCount = 0; emittedCount < triangleCount; emittedCount++) {
+		// If nothing in the cache had any triangles left, grab the next triangle in input order
+		if (best < 0) {
+			while (emitted[seekCursor]) { seekCursor++; }
+			best = static_cast<int64_t>(seekCursor);
+		}
+
+		const uint32_t* tri = &indices[best * 3];
+		result.insert(result.end(), tri, tri + 3);
+		emitted[best] = true;
+
+		// Remove the triangle from each vertex's list of remaining triangles
+		for (int ix = 0; ix < 3; ix++) {
+			uint32_t vertex = tri[ix];
+			uint32_t* begin = &adjacency[offsets[vertex]];
+			uint32_t* end   = begin + remaining[vertex];
+			uint32_t* found = std::find(begin, end, static_cast<uint32_t>(best));
+			if (found != end) {
+				std::swap(*found, *(end - 1));
+				remaining[vertex]--;
+			}
+		}
+
+		// Push the triangle's vertices to the front of the cache
+		int32_t newCount = 0;
+		newCache[newCount++] = tri[0];
+		newCache[newCount++] = tri[1];
+		newCache[newCount++] = tri[2];
+		for (int32_t ix = 0; ix < cacheCount; ix++) {
+			uint32_t vertex = cache[ix];
+			if (vertex != tri[0] && vertex != tri[1] && vertex != tri[2]) {
+				newCache[newCount++] = vertex;
+			}
+		}
+
+		// Re-score everything that was in the cache, and find the best triangle to emit next
+		best = -1;
+		float bestScore = -1.0f;
+		for (int32_t ix = 0; ix < newCount; ix++) {
+			uint32_t vertex = newCache[ix];
+			cachePosition[vertex] = ix < SCORE_CACHE_SIZE ? ix : -1;
+			vertexScores[vertex] = ScoreVertex(cachePosition[vertex], remaining[vertex]);
+		}
+		for (int32_t ix = 0; ix < newCount; ix++) {
+			uint32_t vertex = newCache[ix];
+			for (uint32_t adj = offsets[vertex]; adj < offsets[vertex] + remaining[vertex]; adj++) {
+				uint32_t triangle = adjacency[adj];
+				float score = vertexScores[indices[triangle * 3 + 0]] + vertexScores[indices[triangle * 3 + 1]] + vertexScores[indices[triangle * 3 + 2]];
+				if (score > bestScore) {
+					bestScore = score;
+					best = triangle;
+				}
+			}
+		}
+
+		cacheCount = std::min(newCount, SCORE_CACHE_SIZE);
+		memcpy(cache, newCache, cacheCount * sizeof(uint32_t));
+	}
+
+	indices = std::move(result);
+}
+
+void MeshOptimizer::OptimizeOverdraw(std::vector<uint32_t>& indices, const void* positions, size_t positionStride, size_t vertexCount, uint32_t cacheSize) {
+	const size_t triangleCount = indices.size() / 3;
+	if (triangleCount == 0 || positions == nullptr) {
+		return;
+	}
+	const uint8_t* positionBytes = static_cast<const uint8_t*>(positions);
+
+	// Split the triangles into clusters wherever all 3 vertices miss the cache. These are the places where
+	// the vertex cache optimizer had to jump to a new area of the mesh, so re-ordering the clusters won't
+	// cost us anything in terms of vertex cache efficiency
+	std::vector<uint32_t> clusterStarts;
+	std::vector<uint32_t> timestamps(vertexCount, 0);
+	uint32_t time = cacheSize + 1;
+	for (size_t tri = 0; tri < triangleCount; tri++) {
+		int misses = 0;
+		for (int ix = 0; ix < 3; ix++) {
+			uint32_t index = indices[tri * 3 + ix];
+			if (time - timestamps[index] > cacheSize) {
+				timestamps[index] = time++;
+				misses++;
+			}
+		}
+		if (misses == 3 || tri == 0) {
+			clusterStarts.push_back(static_cast<uint32_t>(tri));
+		}
+	}
+	if (clusterStarts.size() < 2) {
+		return;
+	}
+	clusterStarts.push_back(static_cast<uint32_t>(triangleCount));
+
+	// Find the area-weighted centroid of the whole mesh
+	glm::vec3 meshCentroid = glm::vec3(0.0f);
+	float     meshArea = 0.0f;
+	for (size_t tri = 0; tri < triangleCount; tri++) {
+		glm::vec3 a = ReadPosition(positionBytes, positionStride, indices[tri * 3 + 0]);
+		glm::vec3 b = ReadPosition(positionBytes, positionStride, indices[tri * 3 + 1]);
+		glm::vec3 c = ReadPosition(positionBytes, positionStride, indices[tri * 3 + 2]);
+		float area = glm::length(glm::cross(b - a, c - a));
+		meshCentroid += (a + b + c) * (area / 3.0f);
+		meshArea += area;
+	}
+	meshCentroid = meshArea > 0.0f ? meshCentroid / meshArea : meshCentroid;
+
+	// Score each cluster by how much it faces away from the center of the mesh, clusters that face outwards
+	// are more likely to occlude other parts of the mesh, so they should be drawn first
+	const size_t clusterCount = clusterStarts.size() - 1;
+	std::vector<float> clusterScores(clusterCount);
+	for (size_t cluster = 0; cluster < clusterCount; cluster++) {
+		glm::vec3 centroid = glm::vec3(0.0f);
+		glm::vec3 normal   = glm::vec3(0.0f);
+		float     area     = 0.0f;
+		for (uint32_t tri = clusterStarts[cluster]; tri < clusterStarts[cluster + 1]; tri++) {
+			glm::vec3 a = ReadPosition(positionBytes, positionStride, indices[tri * 3 + 0]);
+			glm::vec3 b = ReadPosition(positionBytes, positionStride, indices[tri * 3 + 1]);
+			glm::vec3 c = ReadPosition(positionBytes, positionStride, indices[tri * 3 + 2]);
+			glm::vec3 cross = glm::cross(b - a, c - a);
+			float triArea = glm::length(cross);
+			centroid += (a + b + c) * (triArea / 3.0f);
+			normal += cross;
+			area += triArea;
+		}
+		centroid = area > 0.0f ? centroid / area : centroid;
+		float normalLength = glm::length(normal);
+		normal = normalLength > 0.0f ? normal / normalLength : normal;
+		clusterScores[cluster] = glm::dot(centroid - meshCentroid, normal);
+	}
+
+	std::vector<uint32_t> order(clusterCount);
+	for (size_t ix = 0; ix < clusterCount; ix++) {
+		order[ix] = static_cast<uint32_t>(ix);
+	}
+	std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+		return clusterScores[a] > clusterScores[b];
+	});
+
+	std::vector<uint32_t> result;
+	result.reserve(indices.size());
+	for (uint32_t cluster : order) {
+		result.insert(result.end(), indices.begin() + clusterStarts[cluster] * 3, indices.begin() + clusterStarts[cluster + 1] * 3);
+	}
+	indices = std::move(result);
+}
+
+std::vector<uint32_t> MeshOptimizer::OptimizeVertexFetch(std::vector<uint32_t>& indices, size_t vertexCount, size_t& newVertexCount) {
+	std::vector<uint32_t> remap(vertexCount, ~0u);
+	uint32_t next = 0;
+	for (uint32_t& index : indices) {
+		if (remap[index] == ~0u) {
+			remap[index] = next++;
+		}
+		index = remap[index];
+	}
+	newVertexCount = next;
+	return remap;
+}
@@ -0,0 +1,137 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <GLM/glm.hpp>
+
+#include "Utils/MeshBuilder.h"
+#include "Graphics/VertexParamMap.h"
+
+/// <summary>
+/// CPU-side tools for re-ordering mesh data so that it plays nicer with the GPU. Triangles are
+/// re-ordered to make better use of the post-transform vertex cache and to reduce overdraw, and
+/// vertices are re-ordered so that they are fetched from memory roughly in order
+/// </summary>
+class MeshOptimizer {
+public:
+	MeshOptimizer() = delete;
+
+	/// <summary>
+	/// The size of the FIFO cache that we simulate when reporting ACMR, this is in the range
+	/// of most modern desktop hardware
+	/// </summary>
+	static constexpr uint32_t DEFAULT_CACHE_SIZE = 16;
+
+	/// <summary>
+	/// Stats about how GPU friendly a mesh is
+	/// </summary>
+	struct Stats {
+		// Average cache miss ratio, the number of vertex shader invocations per triangle (lower is better, 0.5 is ideal)
+		float    ACMR = 0.0f;
+		// Average transform to vertex ratio, the number of vertex shader invocations per vertex (lower is better, 1.0 is ideal)
+		float    ATVR = 0.0f;
+		// The number of bytes the vertex buffer occupies
+		size_t   VertexBytes = 0;
+		// The number of bytes the index buffer occupies
+		size_t   IndexBytes = 0;
+	};
+
+	/// <summary>
+	/// Calculates the average cache miss ratio for an index buffer, using a simulated FIFO cache
+	/// </summary>
+	/// <param name="indices">The triangle list indices</param>
+	/// <param name="vertexCount">The number of vertices that the indices refer to</param>
+	/// <param name="cacheSize">The size of the FIFO cache to simulate</param>
+	/// <returns>The number of cache misses per triangle</returns>
+	static float CalculateACMR(const std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize = DEFAULT_CACHE_SIZE);
+
+	/// <summary>
+	/// Calculates stats for an index buffer and the vertex buffer that it refers to
+	/// </summary>
+	/// <param name="indices">The triangle list indices</param>
+	/// <param name="vertexCount">The number of vertices that the indices refer to</param>
+	/// <param name="vertexStride">The size of a single vertex in bytes</param>
+	/// <param name="indexSize">The size of a single index in bytes</param>
+	static Stats CalculateStats(const std::vector<uint32_t>& indices, size_t vertexCount, size_t vertexStride, size_t indexSize);
+
+	/// <summary>
+	/// Re-orders triangles in place to improve post-transform vertex cache usage, using Tom Forsyth's
+	/// linear-speed vertex cache optimization
+	/// </summary>
+	/// <see>https://tomforsyth1000.github.io/papers/fast_vert_cache_opt.html</see>
+	/// <param name="indices">The triangle list indices to re-order</param>
+	/// <param name="vertexCount">The number of vertices that the indices refer to</param>
+	static void OptimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount);
+
+	/// <summary>
+	/// Re-orders clusters of triangles so that outward facing clusters get drawn first, reducing overdraw.
+	/// This should be run after OptimizeVertexCache, clusters are only split where the vertex cache would
+	/// have been flushed anyways so this does not hurt ACMR
+	/// </summary>
+	/// <param name="indices">The triangle list indices to re-order</param>
+	/// <param name="positions">A pointer to the first vertex position (3 floats)</param>
+	/// <param name="positionStride">The number of bytes between consecutive positions</param>
+	/// <param name="vertexCount">The number of vertices that the indices refer to</param>
+	/// <param name="cacheSize">The size of the FIFO cache to simulate when finding cluster boundaries</param>
+	static void OptimizeOverdraw(std::vector<uint32_t>& indices, const void* positions, size_t positionStride, size_t vertexCount, uint32_t cacheSize = DEFAULT_CACHE_SIZE);
+
+	/// <summary>
+	/// Generates a remap table that orders vertices by the order in which they are first referenced by
+	/// the index buffer, and rewrites the index buffer to use the new vertex indices
+	/// </summary>
+	/// <param name="indices">The triangle list indices to re-write</param>
+	/// <param name="vertexCount">The number of vertices that the indices refer to</param>
+	/// <param name="newVertexCount">Will be set to the number of vertices that are actually referenced</param>
+	/// <returns>A table mapping old vertex indices to new ones, unreferenced vertices map to ~0u</returns>
+	static std::vector<uint32_t> OptimizeVertexFetch(std::vector<uint32_t>& indices, size_t vertexCount, size_t& newVertexCount);
+
+	/// <summary>
+	/// Returns true if a mesh with the given number of vertices can use 16 bit indices
+	/// </summary>
+	static bool CanUseShortIndices(size_t vertexCount) { return vertexCount <= 0xFFFF; }
+
+	/// <summary>
+	/// Runs all optimization passes on a mesh, in place
+	/// </summary>
+	/// <typeparam name="VertType">The type of vertex the mesh consists of</typeparam>
+	/// <param name="mesh">The mesh to optimize</param>
+	/// <param name="before">If not null, will be filled with stats from before the optimization</param>
+	/// <param name="after">If not null, will be filled with stats from after the optimization</param>
+	template <typename VertType>
+	static void Optimize(MeshBuilder<VertType>& mesh, Stats* before = nullptr, Stats* after = nullptr);
+};
+
+template <typename VertType>
+void MeshOptimizer::Optimize(MeshBuilder<VertType>& mesh, Stats* before, Stats* after) {
+	// Only indexed meshes can be optimized, un-indexed meshes have no re-use to take advantage of
+	if (mesh._indices.empty()) {
+		return;
+	}
+
+	if (before != nullptr) {
+		*before = CalculateStats(mesh._indices, mesh._vertices.size(), sizeof(VertType), sizeof(uint32_t));
+	}
+
+	// Re-order our triangles
+	OptimizeVertexCache(mesh._indices, mesh._vertices.size());
+	VertexParamMap vMap = VertexParamMap(VertType::V_DECL);
+	if (vMap.PositionOffset != (uint32_t)-1 && !mesh._vertices.empty()) {
+		const uint8_t* positions = reinterpret_cast<const uint8_t*>(mesh._vertices.data()) + vMap.PositionOffset;
+		OptimizeOverdraw(mesh._indices, positions, sizeof(VertType), mesh._vertices.size());
+	}
+
+	// Re-order our vertices to match, dropping any that are never used
+	size_t newVertexCount = 0;
+	std::vector<uint32_t> remap = OptimizeVertexFetch(mesh._indices, mesh._vertices.size(), newVertexCount);
+	std::vector<VertType> vertices(newVertexCount);
+	for (size_t ix = 0; ix < remap.size(); ix++) {
+		if (remap[ix] != ~0u) {
+			vertices[remap[ix]] = mesh._vertices[ix];
+		}
+	}
+	mesh._vertices = std::move(vertices);
+
+	if (after != nullptr) {
+		size_t indexSize = CanUseShortIndices(mesh._vertices.size()) ? sizeof(uint16_t) : sizeof(uint32_t);
+		*after = CalculateStats(mesh._indices, mesh._vertices.size(), sizeof(VertType), indexSize);
+	}
+}
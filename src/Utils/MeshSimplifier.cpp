@@ -0,0 +1,468 @@
+#include "Utils/MeshSimplifier.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <queue>
+#include <unordered_map>
+
+#include "Utils/BoundingVolumes.h"
+
+namespace {
+	// Triangles whose normal rotates further than this (as a cosine) during a collapse are considered
+	// to have flipped, and the collapse is rejected
+	constexpr float FLIP_THRESHOLD = 0.2f;
+
+	// If a level can't get below this fraction of the previous level's triangle count, we stop generating levels
+	constexpr float MIN_LEVEL_PROGRESS = 0.85f;
+
+	// We don't bother simplifying below this many triangles
+	constexpr size_t MIN_TRIANGLES = 8;
+
+	// How strongly open borders resist moving away from their original shape
+	constexpr double BORDER_WEIGHT = 10.0;
+
+	// How a welded position is allowed to move, higher values are more restrictive
+	constexpr uint8_t KIND_MANIFOLD = 0;
+	constexpr uint8_t KIND_BORDER   = 1;
+	constexpr uint8_t KIND_LOCKED   = 2;
+
+	/// <summary>
+	/// A symmetric 4x4 matrix representing the sum of squared distances to a set of planes, weighted by area
+	/// </summary>
+	struct Quadric {
+		double A00 = 0.0, A11 = 0.0, A22 = 0.0;
+		double A01 = 0.0, A02 = 0.0, A12 = 0.0;
+		double B0  = 0.0, B1  = 0.0, B2  = 0.0;
+		double C   = 0.0;
+		double Weight = 0.0;
+
+		void AddPlane(const glm::dvec3& n, double d, double weight) {
+			A00 += weight * n.x * n.x; A11 += weight * n.y * n.y; A22 += weight * n.z * n.z;
+			A01 += weight * n.x * n.y; A02 += weight * n.x * n.z; A12 += weight * n.y * n.z;
+			B0  += weight * n.x * d;   B1  += weight * n.y * d;   B2  += weight * n.z * d;
+			C   += weight * d * d;
+			Weight += weight;
+		}
+
+		Quadric& operator +=(const Quadric& other) {
+			A00 += other.A00; A11 += other.A11; A22 += other.A22;
+			A01 += other.A01; A02 += other.A02; A12 += other.A12;
+			B0  += other.B0;  B1  += other.B1;  B2  += other.B2;
+			C   += other.C;
+			Weight += other.Weight;
+			return *this;
+		}
+
+		// Evaluates p^T * Q * p, without dividing by the weight
+		double Evaluate(const glm::dvec3& p) const {
+			return
+				A00 * p.x * p.x + A11 * p.y * p.y + A22 * p.z * p.z +
+				2.0 * (A01 * p.x * p.y + A02 * p.x * p.z + A12 * p.y * p.z) +
+				2.0 * (B0 * p.x + B1 * p.y + B2 * p.z) +
+				C;
+		}
+	};
+
+	// Key for welding together vertices that share the exact same position
+	struct PositionKey {
+		uint32_t X, Y, Z;
+		bool operator ==(const PositionKey& other) const { return X == other.X && Y == other.Y && Z == other.Z; }
+	};
+	struct PositionKeyHash {
+		size_t operator()(const PositionKey& key) const {
+			uint64_t h = (uint64_t)key.X * 0x9e3779b97f4a7c15ull;
+			h ^= (uint64_t)key.Y * 0xc2b2ae3d27d4eb4full + (h << 6) + (h >> 2);
+			h ^= (uint64_t)key.Z * 0x165667b19e3779f9ull + (h << 6) + (h >> 2);
+			return static_cast<size_t>(h);
+		}
+	};
+
+	inline uint64_t EdgeKey(uint32_t from, uint32_t to) {
+		return ((uint64_t)from << 32) | to;
+	}
+
+	// A candidate collapse of one vertex onto a neighbour, only valid while From is still at the given version
+	struct Collapse {
+		uint32_t From;
+		uint32_t To;
+		float    Cost;
+		uint32_t Version;
+	};
+}
+
+std::vector<uint32_t> MeshSimplifier::Simplify(const std::vector<uint32_t>& indices, const void* positions, size_t positionStride, size_t vertexCount,
+	size_t targetIndexCount, float targetError, float* resultError)
+{
+	if (resultError != nullptr) {
+		*resultError = 0.0f;
+	}
+
+	// Copy our triangles, dropping any that are already degenerate
+	std::vector<uint32_t> result;
+	result.reserve(indices.size());
+	for (size_t ix = 0; ix + 2 < indices.size(); ix += 3) {
+		uint32_t a = indices[ix], b = indices[ix + 1], c = indices[ix + 2];
+		if (a != b && b != c && a != c) {
+			result.push_back(a); result.push_back(b); result.push_back(c);
+		}
+	}
+	if (result.size() <= targetIndexCount || positions == nullptr) {
+		return result;
+	}
+
+	// Load our positions, and scale them so that the mesh fits in a unit sphere. This keeps errors relative
+	// to the size of the mesh, and keeps the quadrics well conditioned
+	const uint8_t* positionBytes = static_cast<const uint8_t*>(positions);
+	AABB bounds = AABB::FromPoints(positions, positionStride, vertexCount);
+	float radius = bounds.GetRadius();
+	if (radius <= 0.0f) {
+		return result;
+	}
+	glm::vec3 center = bounds.GetCenter();
+	std::vector<glm::vec3> points(vertexCount);
+	for (size_t ix = 0; ix < vertexCount; ix++) {
+		memcpy(&points[ix], positionBytes + ix * positionStride, sizeof(glm::vec3));
+		points[ix] = (points[ix] - center) / radius;
+	}
+
+	// Weld vertices that share a position, so that we see the mesh's real topology rather than one that is
+	// split up along every UV and normal seam. Each welded position keeps a list of the vertices (wedges) at it
+	std::vector<uint32_t> canonical(vertexCount);
+	std::vector<uint32_t> wedgeOffsets(vertexCount + 1, 0);
+	std::vector<uint32_t> wedges;
+	{
+		std::unordered_map<PositionKey, uint32_t, PositionKeyHash> welds;
+		welds.reserve(vertexCount);
+		for (size_t ix = 0; ix < vertexCount; ix++) {
+			PositionKey key;
+			memcpy(&key, positionBytes + ix * positionStride, sizeof(PositionKey));
+			canonical[ix] = welds.emplace(key, static_cast<uint32_t>(ix)).first->second;
+			wedgeOffsets[canonical[ix] + 1]++;
+		}
+		for (size_t ix = 0; ix < vertexCount; ix++) {
+			wedgeOffsets[ix + 1] += wedgeOffsets[ix];
+		}
+		wedges.resize(vertexCount);
+		std::vector<uint32_t> cursor(wedgeOffsets.begin(), wedgeOffsets.end() - 1);
+		for (size_t ix = 0; ix < vertexCount; ix++) {
+			wedges[cursor[canonical[ix]]++] = static_cast<uint32_t>(ix);
+		}
+	}
+
+	// Counts how many times each directed edge between welded positions appears. An edge that isn't matched by
+	// exactly one edge going the other way is on an open border (or is non-manifold)
+	std::unordered_map<uint64_t, int32_t> edges;
+	edges.reserve(result.size());
+	for (size_t ix = 0; ix < result.size(); ix += 3) {
+		for (int k = 0; k < 3; k++) {
+			edges[EdgeKey(canonical[result[ix + k]], canonical[result[ix + (k + 1) % 3]])]++;
+		}
+	}
+	auto edgeCount = [&](uint32_t a, uint32_t b) {
+		auto it = edges.find(EdgeKey(a, b));
+		return it != edges.end() ? it->second : 0;
+	};
+	auto isBorderEdge = [&](uint32_t a, uint32_t b) {
+		return edgeCount(a, b) + edgeCount(b, a) == 1;
+	};
+
+	// Accumulate the plane of every triangle into the quadric of each of its corners
+	std::vector<Quadric> quadrics(vertexCount);
+	for (size_t ix = 0; ix < result.size(); ix += 3) {
+		glm::dvec3 corners[3] = { points[result[ix]], points[result[ix + 1]], points[result[ix + 2]] };
+		glm::dvec3 normal = glm::cross(corners[1] - corners[0], corners[2] - corners[0]);
+		double length = glm::length(normal);
+		if (length <= 0.0) {
+			continue;
+		}
+		normal /= length;
+		Quadric plane;
+		plane.AddPlane(normal, -glm::dot(normal, corners[0]), length * 0.5);
+
+		for (int k = 0; k < 3; k++) {
+			uint32_t a = canonical[result[ix + k]], b = canonical[result[ix + (k + 1) % 3]];
+			quadrics[a] += plane;
+
+			// Border edges get an extra plane perpendicular to the triangle, which stops the border from shrinking inwards
+			if (isBorderEdge(a, b)) {
+				glm::dvec3 edge = corners[(k + 1) % 3] - corners[k];
+				double edgeLength = glm::length(edge);
+				if (edgeLength > 0.0) {
+					glm::dvec3 borderNormal = glm::cross(edge / edgeLength, normal);
+					Quadric border;
+					border.AddPlane(borderNormal, -glm::dot(borderNormal, corners[k]), edgeLength * edgeLength * BORDER_WEIGHT);
+					quadrics[a] += border;
+					quadrics[b] += border;
+				}
+			}
+		}
+	}
+
+	// Returns the error of moving the position "from" onto the position "to"
+	auto collapseCost = [&](uint32_t from, uint32_t to) {
+		const Quadric& qa = quadrics[from];
+		const Quadric& qb = quadrics[to];
+		double weight = qa.Weight + qb.Weight;
+		glm::dvec3 p = points[to];
+		double error = weight > 0.0 ? (qa.Evaluate(p) + qb.Evaluate(p)) / weight : 0.0;
+		return static_cast<float>(std::max(error, 0.0));
+	};
+
+	// The triangles around each vertex. Dead triangles are skipped, and pruned whenever a vertex gains triangles
+	const size_t triangleCount = result.size() / 3;
+	std::vector<std::vector<uint32_t>> vertexTriangles(vertexCount);
+	std::vector<bool> deadTriangles(triangleCount, false);
+	{
+		std::vector<uint32_t> counts(vertexCount, 0);
+		for (uint32_t index : result) {
+			counts[index]++;
+		}
+		for (size_t ix = 0; ix < vertexCount; ix++) {
+			vertexTriangles[ix].reserve(counts[ix]);
+		}
+		for (size_t ix = 0; ix < result.size(); ix++) {
+			vertexTriangles[result[ix]].push_back(static_cast<uint32_t>(ix / 3));
+		}
+	}
+
+	// Calls a function with every live triangle at a welded position, and the corner of the triangle at that position
+	auto forEachTriangle = [&](uint32_t position, auto&& function) {
+		for (uint32_t w = wedgeOffsets[position]; w < wedgeOffsets[position + 1]; w++) {
+			for (uint32_t triangle : vertexTriangles[wedges[w]]) {
+				if (!deadTriangles[triangle]) {
+					function(triangle, wedges[w]);
+				}
+			}
+		}
+	};
+
+	// Checks whether we can collapse a position onto a neighbour, and if so fills in which wedge each of its wedges moves onto
+	std::vector<std::pair<uint32_t, uint32_t>> wedgeMoves;
+	auto canCollapse = [&](uint32_t from, uint32_t to) {
+		// Every wedge at the collapsing position needs to move onto a wedge at the target position that it shares
+		// an edge with, this way the triangles around it keep their UVs and normals, and seams stay where they are
+		wedgeMoves.clear();
+		for (uint32_t w = wedgeOffsets[from]; w < wedgeOffsets[from + 1]; w++) {
+			uint32_t wedge = wedges[w];
+			uint32_t partner = ~0u;
+			bool used = false;
+			for (uint32_t triangle : vertexTriangles[wedge]) {
+				if (deadTriangles[triangle]) {
+					continue;
+				}
+				used = true;
+				const uint32_t* tri = &result[triangle * 3];
+				for (int k = 0; k < 3; k++) {
+					if (canonical[tri[k]] == to) {
+						if (partner != ~0u && partner != tri[k]) {
+							return false;
+						}
+						partner = tri[k];
+					}
+				}
+			}
+			if (used) {
+				if (partner == ~0u) {
+					return false;
+				}
+				wedgeMoves.emplace_back(wedge, partner);
+			}
+		}
+
+		// Make sure that none of the triangles that will remain are flipped by the collapse
+		for (const auto& [wedge, partner] : wedgeMoves) {
+			for (uint32_t triangle : vertexTriangles[wedge]) {
+				const uint32_t* tri = &result[triangle * 3];
+				if (deadTriangles[triangle] || canonical[tri[0]] == to || canonical[tri[1]] == to || canonical[tri[2]] == to) {
+					continue;
+				}
+				// Rotate the triangle so that the collapsing vertex comes first
+				int corner = tri[0] == wedge ? 0 : (tri[1] == wedge ? 1 : 2);
+				const glm::vec3& b = points[tri[(corner + 1) % 3]];
+				const glm::vec3& c = points[tri[(corner + 2) % 3]];
+				glm::vec3 before = glm::cross(b - points[from], c - points[from]);
+				glm::vec3 after  = glm::cross(b - points[to], c - points[to]);
+				float lengths = glm::length(before) * glm::length(after);
+				if (lengths <= 0.0f || glm::dot(before, after) <= FLIP_THRESHOLD * lengths) {
+					return false;
+				}
+			}
+		}
+		return !wedgeMoves.empty();
+	};
+
+	// Each position has its cheapest valid collapse in a min-heap. Rather than removing a position's entry when
+	// something around it changes, we bump its version and push a new one, and stale entries are skipped when popped
+	const float errorLimit = targetError * targetError;
+	std::vector<uint32_t> versions(vertexCount, 0);
+	std::vector<bool> collapsed(vertexCount, false);
+	auto compare = [](const Collapse& a, const Collapse& b) {
+		return a.Cost != b.Cost ? a.Cost > b.Cost : (a.From != b.From ? a.From > b.From : a.To > b.To);
+	};
+	std::priority_queue<Collapse, std::vector<Collapse>, decltype(compare)> heap(compare);
+
+	// Pushes the cheapest collapse of a position that we're allowed to make. The edges around it are counted the
+	// same way as above, borders can only slide along the border, and non-manifold positions can't move at all
+	std::vector<uint32_t> edgesOut, edgesIn;
+	std::vector<std::pair<float, uint32_t>> targets;
+	auto pushCollapse = [&](uint32_t from) {
+		edgesOut.clear();
+		edgesIn.clear();
+		forEachTriangle(from, [&](uint32_t triangle, uint32_t wedge) {
+			const uint32_t* tri = &result[triangle * 3];
+			int corner = tri[0] == wedge ? 0 : (tri[1] == wedge ? 1 : 2);
+			edgesOut.push_back(canonical[tri[(corner + 1) % 3]]);
+			edgesIn.push_back(canonical[tri[(corner + 2) % 3]]);
+		});
+
+		uint8_t kind = KIND_MANIFOLD;
+		for (const std::vector<uint32_t>* list : { &edgesOut, &edgesIn }) {
+			for (uint32_t other : *list) {
+				auto out = std::count(edgesOut.begin(), edgesOut.end(), other);
+				auto in  = std::count(edgesIn.begin(), edgesIn.end(), other);
+				kind = std::max(kind, (out > 1 || in > 1) ? KIND_LOCKED : ((out == 0 || in == 0) ? KIND_BORDER : KIND_MANIFOLD));
+			}
+		}
+		if (kind == KIND_LOCKED) {
+			return;
+		}
+
+		// Around an interior position every neighbour is in both lists, so we only need to look at the incoming edges
+		// that don't have an outgoing edge to go with them
+		targets.clear();
+		for (uint32_t to : edgesOut) {
+			bool border = std::find(edgesIn.begin(), edgesIn.end(), to) == edgesIn.end();
+			if (to != from && (kind != KIND_BORDER || border)) {
+				targets.emplace_back(collapseCost(from, to), to);
+			}
+		}
+		for (uint32_t to : edgesIn) {
+			if (to != from && std::find(edgesOut.begin(), edgesOut.end(), to) == edgesOut.end()) {
+				targets.emplace_back(collapseCost(from, to), to);
+			}
+		}
+		std::sort(targets.begin(), targets.end());
+		for (const auto& [cost, to] : targets) {
+			if (cost > errorLimit) {
+				break;
+			}
+			if (canCollapse(from, to)) {
+				heap.push({ from, to, cost, versions[from] });
+				break;
+			}
+		}
+	};
+
+	for (size_t ix = 0; ix < vertexCount; ix++) {
+		if (canonical[ix] == ix) {
+			pushCollapse(static_cast<uint32_t>(ix));
+		}
+	}
+
+	float maxError = 0.0f;
+	size_t liveTriangles = triangleCount;
+	std::vector<uint32_t> neighbours;
+
+	while (!heap.empty() && liveTriangles * 3 > targetIndexCount) {
+		Collapse collapse = heap.top();
+		heap.pop();
+		uint32_t from = collapse.From, to = collapse.To;
+		// Entries pushed before something around the position changed are stale. This also fills in wedgeMoves
+		if (collapse.Version != versions[from] || collapsed[from] || !canCollapse(from, to)) {
+			continue;
+		}
+
+		// Move every triangle around the collapsing position onto the target, dropping the ones that collapse to nothing
+		quadrics[to] += quadrics[from];
+		maxError = std::max(maxError, collapse.Cost);
+		collapsed[from] = true;
+		neighbours.clear();
+		for (const auto& [wedge, partner] : wedgeMoves) {
+			for (uint32_t triangle : vertexTriangles[wedge]) {
+				if (deadTriangles[triangle]) {
+					continue;
+				}
+				uint32_t* tri = &result[triangle * 3];
+				for (int k = 0; k < 3; k++) {
+					neighbours.push_back(canonical[tri[k]]);
+					if (tri[k] == wedge) {
+						tri[k] = partner;
+					}
+				}
+				if (tri[0] == tri[1] || tri[1] == tri[2] || tri[0] == tri[2]) {
+					deadTriangles[triangle] = true;
+					liveTriangles--;
+				} else {
+					vertexTriangles[partner].push_back(triangle);
+				}
+			}
+			vertexTriangles[wedge].clear();
+		}
+		for (const auto& [wedge, partner] : wedgeMoves) {
+			std::vector<uint32_t>& list = vertexTriangles[partner];
+			list.erase(std::remove_if(list.begin(), list.end(), [&](uint32_t triangle) { return deadTriangles[triangle]; }), list.end());
+		}
+
+		// Everything around the target has new edges or a new quadric, so its collapses need to be rebuilt
+		forEachTriangle(to, [&](uint32_t triangle, uint32_t) {
+			for (int k = 0; k < 3; k++) {
+				neighbours.push_back(canonical[result[triangle * 3 + k]]);
+			}
+		});
+		std::sort(neighbours.begin(), neighbours.end());
+		neighbours.erase(std::unique(neighbours.begin(), neighbours.end()), neighbours.end());
+		for (uint32_t position : neighbours) {
+			if (!collapsed[position]) {
+				versions[position]++;
+				pushCollapse(position);
+			}
+		}
+	}
+
+	// Keep the remaining triangles in their original order
+	size_t write = 0;
+	for (size_t ix = 0; ix < triangleCount; ix++) {
+		if (!deadTriangles[ix]) {
+			result[write++] = result[ix * 3]; result[write++] = result[ix * 3 + 1]; result[write++] = result[ix * 3 + 2];
+		}
+	}
+	result.resize(write);
+
+	if (resultError != nullptr) {
+		*resultError = sqrtf(maxError);
+	}
+	return result;
+}
+
+std::vector<MeshSimplifier::Lod> MeshSimplifier::GenerateLods(const std::vector<uint32_t>& indices, const void* positions, size_t positionStride, size_t vertexCount,
+	uint32_t maxLevels, float reduction)
+{
+	std::vector<Lod> result;
+	size_t previousCount = indices.size();
+	float  previousError = 0.0f;
+	size_t target = indices.size();
+
+	for (uint32_t level = 0; level < maxLevels; level++) {
+		target = static_cast<size_t>(target * reduction) / 3 * 3;
+		if (target < MIN_TRIANGLES * 3) {
+			break;
+		}
+
+		// Each level is simplified from the last one, which is much cheaper than starting from the full detail mesh
+		// every time. The error of a level is measured against the level before it, so the errors add up
+		Lod lod;
+		lod.Indices = Simplify(result.empty() ? indices : result.back().Indices, positions, positionStride, vertexCount, target, 1.0f, &lod.Error);
+		if (lod.Indices.empty() || lod.Indices.size() > previousCount * MIN_LEVEL_PROGRESS) {
+			break;
+		}
+
+		lod.Error += previousError;
+		previousError = lod.Error;
+		previousCount = lod.Indices.size();
+		result.push_back(std::move(lod));
+	}
+
+	return result;
+}
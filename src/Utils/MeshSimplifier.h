@@ -0,0 +1,91 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <GLM/glm.hpp>
+
+#include "Utils/MeshBuilder.h"
+#include "Graphics/VertexParamMap.h"
+
+/// <summary>
+/// A CPU mesh simplifier based on quadric error metrics (Garland and Heckbert). Vertices are collapsed
+/// onto their neighbours in order of how little they change the surface, so simplified meshes share
+/// the vertex buffer of the original mesh and only need a new index buffer
+///
+/// Vertices on attribute seams (where several vertices share a position) and on open borders can only slide
+/// along their seam or border, so UVs and normals do not get smeared across seams and open meshes keep their
+/// silhouettes. Meshes that are split up by seams everywhere will not simplify very far as a result
+/// </summary>
+/// <see>https://www.cs.cmu.edu/~garland/Papers/quadrics.pdf</see>
+class MeshSimplifier {
+public:
+	MeshSimplifier() = delete;
+
+	/// <summary>
+	/// The default maximum number of levels to generate, not including the full detail mesh
+	/// </summary>
+	static constexpr uint32_t DEFAULT_MAX_LODS = 4;
+
+	/// <summary>
+	/// A simplified level of detail for a mesh
+	/// </summary>
+	struct Lod {
+		// Triangle list indices into the original mesh's vertices
+		std::vector<uint32_t> Indices;
+		// The approximate deviation from the original surface, as a fraction of the mesh's bounding radius
+		float Error = 0.0f;
+	};
+
+	/// <summary>
+	/// Simplifies a triangle list until it has at most targetIndexCount indices, or until no more
+	/// vertices can be collapsed without exceeding the target error
+	/// </summary>
+	/// <param name="indices">The triangle list indices to simplify</param>
+	/// <param name="positions">A pointer to the first vertex position (3 floats)</param>
+	/// <param name="positionStride">The number of bytes between consecutive positions</param>
+	/// <param name="vertexCount">The number of vertices that the indices refer to</param>
+	/// <param name="targetIndexCount">The number of indices we would like to end up with</param>
+	/// <param name="targetError">The maximum error allowed, as a fraction of the mesh's bounding radius</param>
+	/// <param name="resultError">If not null, will be set to the error of the resulting mesh</param>
+	/// <returns>The simplified index buffer</returns>
+	static std::vector<uint32_t> Simplify(const std::vector<uint32_t>& indices, const void* positions, size_t positionStride, size_t vertexCount,
+		size_t targetIndexCount, float targetError = 1.0f, float* resultError = nullptr);
+
+	/// <summary>
+	/// Generates a chain of progressively simpler levels of detail for a mesh, each level will have roughly
+	/// reduction times as many triangles as the last. Generation stops early once the mesh can no longer
+	/// be simplified by a meaningful amount
+	/// </summary>
+	/// <param name="indices">The triangle list indices of the full detail mesh</param>
+	/// <param name="positions">A pointer to the first vertex position (3 floats)</param>
+	/// <param name="positionStride">The number of bytes between consecutive positions</param>
+	/// <param name="vertexCount">The number of vertices that the indices refer to</param>
+	/// <param name="maxLevels">The maximum number of levels to generate</param>
+	/// <param name="reduction">The ratio of triangles between one level and the next</param>
+	/// <returns>The generated levels, from most to least detailed, not including the full detail mesh</returns>
+	static std::vector<Lod> GenerateLods(const std::vector<uint32_t>& indices, const void* positions, size_t positionStride, size_t vertexCount,
+		uint32_t maxLevels = DEFAULT_MAX_LODS, float reduction = 0.5f);
+
+	/// <summary>
+	/// Generates a chain of levels of detail for an indexed mesh
+	/// </summary>
+	/// <typeparam name="VertType">The type of vertex the mesh consists of</typeparam>
+	/// <param name="mesh">The mesh to generate levels for</param>
+	/// <param name="maxLevels">The maximum number of levels to generate</param>
+	/// <param name="reduction">The ratio of triangles between one level and the next</param>
+	/// <returns>The generated levels, from most to least detailed, not including the full detail mesh</returns>
+	template <typename VertType>
+	static std::vector<Lod> GenerateLods(const MeshBuilder<VertType>& mesh, uint32_t maxLevels = DEFAULT_MAX_LODS, float reduction = 0.5f);
+};
+
+template <typename VertType>
+std::vector<MeshSimplifier::Lod> MeshSimplifier::GenerateLods(const MeshBuilder<VertType>& mesh, uint32_t maxLevels, float reduction) {
+	// We need both positions and indices to simplify a mesh
+	VertexParamMap vMap = VertexParamMap(VertType::V_DECL);
+	if (mesh.GetIndexCount() == 0 || vMap.PositionOffset == (uint32_t)-1) {
+		return std::vector<Lod>();
+	}
+
+	std::vector<uint32_t> indices(mesh.GetIndexDataPtr(), mesh.GetIndexDataPtr() + mesh.GetIndexCount());
+	const uint8_t* positions = reinterpret_cast<const uint8_t*>(mesh.GetVertexDataPtr()) + vMap.PositionOffset;
+	return GenerateLods(indices, positions, sizeof(VertType), mesh.GetVertexCount(), maxLevels, reduction);
+}
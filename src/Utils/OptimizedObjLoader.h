@@ -7,11 +7,18 @@
  */
 #pragma once
 #include <fstream>
+#include <cstddef>
 
 #include "Graphics/VertexArrayObject.h"
 #include "Graphics/VertexTypes.h"
 
 #include "Utils/MeshBuilder.h"
+#include "Utils/MemoryMappedFile.h"
+#include "Utils/MeshOptimizer.h"
+#include "Utils/MeshSimplifier.h"
+#include "Utils/BoundingVolumes.h"
+#include "Utils/BinaryMeshFormat.h"
+#include "Graphics/MeshLod.h"
 
 /// <summary>
 /// An optimized OBJ loader that can convert an OBJ file to a binary representation
@@ -24,79 +31,146 @@ public:
 	/// to a binary file and load that instead. On subsequent runs, the binary file will be loaded instead
 	/// </summary>
 	/// <param name="filename">The path to the .obj or .bin file to load</param>
+	/// <param name="lods">If not null, will be filled with the mesh's levels of detail, starting with the full detail mesh</param>
+	/// <param name="bounds">If not null, will be set to the object space bounds of the mesh</param>
 	/// <returns>A VAO loaded from disk</returns>
-	static VertexArrayObject::Sptr LoadFromFile(const std::string& filename);
+	static VertexArrayObject::Sptr LoadFromFile(const std::string& filename, std::vector<MeshLod>* lods = nullptr, AABB* bounds = nullptr);
+
+	/// <summary>
+	/// The CPU side contents of a binary mesh file, ready to be uploaded to OpenGL. The vertex and index
+	/// pointers point into the mapped file, so they are valid for as long as the decoded mesh is alive
+	/// </summary>
+	struct DecodedMesh : BinaryMeshFormat::Mesh {
+		MAKE_PTRS(DecodedMesh);
+
+		std::string      Filename;
+		MemoryMappedFile File;
+	};
+
+		std::string                  Filename;
+		MemoryMappedFile             File;
+		std::vector<BufferAttribute> VertexDeclaration;
+		const uint8_t*               VertexData = nullptr;
+		uint32_t                     VertexStride = 0;
+		uint32_t                     NumVertices = 0;
+		const uint8_t*               IndexData = nullptr;
+		IndexType                    IndicesType = IndexType::Unknown;
+		// The first range is always the full detail mesh
+		std::vector<LodRange>        Lods;
+		AABB                         Bounds;
+	};
+
+	/// <summary>
+	/// Performs all the file work for LoadFromFile (converting stale OBJ files, mapping and validating
+	/// the binary file) without touching OpenGL, so it can be called from a worker thread
+	/// </summary>
+	/// <param name="filename">The path to the .obj or .bin file to load</param>
+	/// <param name="result">The mesh to decode the file into</param>
+	/// <returns>True if the file was decoded, false if otherwise</returns>
+	static bool Decode(const std::string& filename, DecodedMesh& result);
+	/// <summary>
+	/// Creates a VAO and levels of detail from a decoded mesh, must be called on the main thread
+	/// </summary>
+	/// <param name="mesh">The mesh to upload, as filled in by Decode</param>
+	/// <param name="lods">If not null, will be filled with the mesh's levels of detail, starting with the full detail mesh</param>
+	/// <param name="bounds">If not null, will be set to the object space bounds of the mesh</param>
+	/// <returns>The VAO for the full detail mesh</returns>
+	static VertexArrayObject::Sptr Upload(const DecodedMesh& mesh, std::vector<MeshLod>* lods = nullptr, AABB* bounds = nullptr);
 	/// <summary>
 	/// Manually converts an OBJ file into a binary mesh file
 	/// </summary>
 	/// <param name="inFile">The path to OBJ file to convert</param>
 	/// <param name="outFile">The output path for the bin file, or empty to use the inFile path and replace the extension with .bin</param>
-	static void ConvertToBinary(const std::string& inFile, const std::string& outFile = "");
+	/// <param name="optimize">True to re-order the mesh for the GPU's vertex cache and vertex fetch, and use 16 bit indices where possible</param>
+	/// <param name="generateLods">True to generate simplified levels of detail for the mesh and store them in the binary file</param>
+	static void ConvertToBinary(const std::string& inFile, const std::string& outFile = "", bool optimize = true, bool generateLods = true);
 
 	/// <summary>
 	/// Saves a mesh builder of the given type to a binary file
 	/// </summary>
-	/// <typeparam name="VertexType"></typeparam>
-	/// <param name="mesh"></param>
-	/// <param name="outFilename"></param>
+	/// <typeparam name="VertexType">The type of vertex stored in the mesh</typeparam>
+	/// <param name="mesh">The mesh to save</param>
+	/// <param name="outFilename">The path to write the binary file to</param>
+	/// <param name="sourceFile">The optional path to the file the mesh was generated from, used to detect stale binary files</param>
+	/// <param name="allowShortIndices">True to store indices as 16 bit integers if the mesh has few enough vertices</param>
+	/// <param name="lods">Simplified levels of detail for the mesh to store alongside the full detail mesh</param>
 	template <typename VertexType>
-	static void SaveBinaryFile(MeshBuilder<VertexType>& mesh, const std::string& outFilename);
+	static void SaveBinaryFile(MeshBuilder<VertexType>& mesh, const std::string& outFilename, const std::string& sourceFile = "", bool allowShortIndices = false,
+		const std::vector<MeshSimplifier::Lod>& lods = std::vector<MeshSimplifier::Lod>());
 
-protected:
-	// Will be put at the start of the binary file, contains info about the contents of the file
-	struct BinaryHeader {
-		// A check value so we can ensure that we're loading in the right file type
-		char      HeaderBytes[4] ={ 'B', 'O', 'B', 'J' };
-		// The version code, we can use this to create different loaders if our format changes
-		uint16_t  Version = 0;
-		// The number of indices in the mesh
-		uint32_t  NumIndices = 0;
-		// The type of index to load
-		IndexType IndicesType = IndexType::Unknown;
-		// The number of vertices in the mesh
-		uint32_t  NumVertices = 0;
-		// The size of a single vertex structure
-		uint16_t  VertexStride = 0;
-		// The number of vertex attributes (basically how many VDECL entries there are)
-		uint8_t   NumAttributes = 0;
-	};
+	/// <summary>
+	/// Checks whether a binary file is the current version, and was generated from the current contents of
+	/// the given source file
+	/// </summary>
+	/// <param name="binFile">The path to the binary mesh file</param>
+	/// <param name="sourceFile">The path to the OBJ file that the binary was generated from</param>
+	/// <returns>True if the binary file is up to date, false if it needs to be regenerated</returns>
+	static bool IsBinaryFileCurrent(const std::string& binFile, const std::string& sourceFile);
 
+protected:
 	OptimizedObjLoader() = default;
 	~OptimizedObjLoader() = default;
 
 	static MeshBuilder<VertexPosNormTexColTangents>* _LoadFromObjFile(const std::string& filename);
-	static VertexArrayObject::Sptr _LoadFromBinFile(const std::string& filename);
+	static bool _DecodeBinFile(const std::string& filename, DecodedMesh& result);
+
+	/// <summary>
+	/// Creates a VAO from raw vertex and index data, data is uploaded directly from the given pointers
+	/// </summary>
+	static VertexArrayObject::Sptr _CreateVao(const std::vector<BufferAttribute>& vDecl,
+		const void* vertexData, uint32_t vertexStride, uint32_t numVertices,
+		const void* indexData, IndexType indexType, uint32_t numIndices);
+
+	/// <summary>
+	/// Writes a V3 binary mesh file from raw vertex and index data, the index data contains the indices
+	/// for every level of detail, with the ranges for each level described by the LOD table
+	/// </summary>
+	static void _WriteBinaryFile(const std::string& outFilename, const std::vector<BufferAttribute>& vDecl,
+		const void* vertexData, uint32_t vertexStride, uint32_t numVertices,
+		const void* indexData, IndexType indexType, uint32_t numIndices,
+		const std::vector<BinaryMeshFormat::Mesh::LodRange>& lods, const AABB& bounds,
+		const std::string& sourceFile);
+
+	/// <summary>
+	/// Writes a V3 binary mesh file, storing the indices for all levels of detail as the given index type
+	/// </summary>
+	template <typename IndexT, typename VertexType>
+	static void _WriteBinaryFile(MeshBuilder<VertexType>& mesh, const std::string& outFilename, IndexType indexType,
+		const std::vector<MeshSimplifier::Lod>& lods, const std::string& sourceFile);
 };
 
 template <typename VertexType>
-void OptimizedObjLoader::SaveBinaryFile(MeshBuilder<VertexType>& mesh, const std::string& outFilename) {
-	// Open the output file
-	std::ofstream file(outFilename, std::ios::binary);
-	if (!file) {
-		throw std::runtime_error("Failed to open output file");
+void OptimizedObjLoader::SaveBinaryFile(MeshBuilder<VertexType>& mesh, const std::string& outFilename, const std::string& sourceFile, bool allowShortIndices,
+	const std::vector<MeshSimplifier::Lod>& lods)
+{
+	// If all our indices fit in 16 bits, we can halve the size of the index buffer
+	if (allowShortIndices && mesh.GetIndexCount() > 0 && MeshOptimizer::CanUseShortIndices(mesh.GetVertexCount())) {
+		_WriteBinaryFile<uint16_t>(mesh, outFilename, IndexType::UShort, lods, sourceFile);
+	} else {
+		_WriteBinaryFile<uint32_t>(mesh, outFilename, IndexType::UInt, lods, sourceFile);
 	}
+}
 
-	// Create the fixed size header for our output file
-	BinaryHeader header  = BinaryHeader();
-	header.Version       = 0x01; // This is version 1! Update this and implement different readers if changes to format are made
-	header.NumIndices    = mesh.GetIndexCount();
-	header.IndicesType   = IndexType::UInt;
-	header.NumVertices   = mesh.GetVertexCount();
-	header.VertexStride  = sizeof(VertexType);
-	header.NumAttributes = VertexType::V_DECL.size();
-
-	// Write header bytes to the stream
-	file.write(reinterpret_cast<const char*>(&header), sizeof(BinaryHeader));
-
-	// Write which attributes we have to the stream
-	for (int ix = 0; ix < VertexType::V_DECL.size(); ix++) {
-		file.write(reinterpret_cast<const char*>(&VertexType::V_DECL[ix]), sizeof(BufferAttribute));
-	}
-	// Write any index data to the file
-	if (mesh.GetIndexCount() > 0) {
-		file.write(reinterpret_cast<const char*>(mesh.GetIndexDataPtr()), mesh.GetIndexCount() * sizeof(uint32_t));
+template <typename IndexT, typename VertexType>
+void OptimizedObjLoader::_WriteBinaryFile(MeshBuilder<VertexType>& mesh, const std::string& outFilename, IndexType indexType,
+	const std::vector<MeshSimplifier::Lod>& lods, const std::string& sourceFile)
+{
+	// The full detail mesh is always the first level, the simplified levels follow it in the index section
+	std::vector<IndexT> indices(mesh.GetIndexDataPtr(), mesh.GetIndexDataPtr() + mesh.GetIndexCount());
+	std::vector<BinaryMeshFormat::Mesh::LodRange> lodTable;
+	if (!lods.empty()) {
+		lodTable.push_back({ 0, static_cast<uint32_t>(indices.size()), 0.0f });
+		for (const auto& lod : lods) {
+			lodTable.push_back({ static_cast<uint32_t>(indices.size()), static_cast<uint32_t>(lod.Indices.size()), lod.Error });
+			indices.insert(indices.end(), lod.Indices.begin(), lod.Indices.end());
+		}
 	}
 
-	// Write vertex data to file
-	file.write(reinterpret_cast<const char*>(mesh.GetVertexDataPtr()), mesh.GetVertexCount() * sizeof(VertexType));
+	// Store the bounds so that loading doesn't need to touch the vertex data
+	AABB bounds = BinaryMeshFormat::CalculateBounds(VertexType::V_DECL, mesh.GetVertexDataPtr(), sizeof(VertexType), static_cast<uint32_t>(mesh.GetVertexCount()));
+
+	_WriteBinaryFile(outFilename, VertexType::V_DECL,
+		mesh.GetVertexDataPtr(), sizeof(VertexType), static_cast<uint32_t>(mesh.GetVertexCount()),
+		indices.data(), indexType, static_cast<uint32_t>(indices.size()),
+		lodTable, bounds, sourceFile);
 }
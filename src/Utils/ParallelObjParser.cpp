@@ -0,0 +1,367 @@
+#include "Utils/ParallelObjParser.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+
+#include "Utils/MemoryMappedFile.h"
+
+namespace {
+	// Files smaller than this will not be split any further, the cost of spinning up
+	// a thread outweighs the cost of just parsing the data
+	constexpr size_t MIN_CHUNK_SIZE = 64 * 1024;
+
+	// A single corner of a face as it appears in the file (1-based, 0 means not specified or failed to read)
+	struct FaceCorner {
+		int32_t Values[3];
+	};
+
+	// Stores all the data parsed from a single line-aligned section of the file
+	struct Chunk {
+		const char* Begin = nullptr;
+		const char* End   = nullptr;
+
+		std::vector<glm::vec3>  Positions;
+		std::vector<glm::vec3>  Normals;
+		std::vector<glm::vec2>  UVs;
+		std::vector<FaceCorner> Corners;
+		// The number of corners stored for each face, in order
+		std::vector<uint8_t>    FaceSizes;
+		// Corner components that used negative (relative) indices. These are stored relative
+		// to the start of the chunk, and need to be offset once we know where the chunk starts
+		std::vector<uint32_t>   RelativeComponents;
+	};
+
+	inline bool IsSpace(char c) {
+		return c == ' ' || c == '\t' || c == '\r';
+	}
+
+	// The characters the old loaders' streams (and StringTools::Trim) treated as whitespace
+	inline bool IsStreamSpace(char c) {
+		return c == ' ' || (c >= '\t' && c <= '\r');
+	}
+
+	inline const char* SkipSpace(const char* p, const char* end) {
+		while (p < end && IsSpace(*p)) { p++; }
+		return p;
+	}
+
+	inline const char* ParseFloat(const char* p, const char* end, float& value) {
+		p = SkipSpace(p, end);
+		// from_chars does not accept a leading plus, but iostreams did
+		if (p < end && *p == '+') { p++; }
+		value = 0.0f;
+		return std::from_chars(p, end, value).ptr;
+	}
+
+	/// <summary>
+	/// Reads the corners of a face line following the same rules as the std::stringstream the old loaders
+	/// used, so that every face (including the p, p/t and p//n forms they misread) gives the same result.
+	/// Like a stream, any read that fails stores 0 and makes every read after it fail as well
+	/// </summary>
+	struct FaceStream {
+		const char* P;
+		const char* End;
+		bool Failed = false;
+		bool AtEnd  = false;
+
+		FaceStream(const char* begin, const char* end) : P(begin), End(end) {}
+
+		// Matches stream.peek() != EOF
+		bool HasMore() {
+			if (Failed || AtEnd) { return false; }
+			AtEnd = P == End;
+			return !AtEnd;
+		}
+
+		// Matches stream >> value for an int
+		void ReadInt(int32_t& value) {
+			if (!_SkipSpace()) { return; }
+			bool negative = false;
+			if (*P == '+' || *P == '-') {
+				negative = *P == '-';
+				P++;
+			}
+			const char* digits = P;
+			int64_t magnitude = 0;
+			for (; P < End && *P >= '0' && *P <= '9'; P++) {
+				// Saturate so we can still tell when the value is out of range
+				magnitude = std::min<int64_t>(magnitude * 10 + (*P - '0'), INT64_C(1) << 32);
+			}
+			AtEnd = P == End;
+			if (P == digits) {
+				value  = 0;
+				Failed = true;
+			} else if (negative) {
+				Failed = magnitude > -static_cast<int64_t>(INT32_MIN);
+				value  = Failed ? INT32_MIN : static_cast<int32_t>(-magnitude);
+			} else {
+				Failed = magnitude > INT32_MAX;
+				value  = Failed ? INT32_MAX : static_cast<int32_t>(magnitude);
+			}
+		}
+
+		// Matches stream >> c for a char, we never need the value
+		void SkipChar() {
+			if (_SkipSpace()) { P++; }
+		}
+
+	private:
+		// Emulates the stream's sentry, returns false if the stream is failed or there is nothing left to read
+		bool _SkipSpace() {
+			if (!Failed && !AtEnd) {
+				while (P < End && IsStreamSpace(*P)) { P++; }
+				AtEnd = P == End;
+			}
+			Failed = Failed || AtEnd;
+			return !Failed;
+		}
+	};
+
+	// Parses all the lines in the given chunk
+	void ParseChunk(Chunk& chunk) {
+		const char* p   = chunk.Begin;
+		const char* end = chunk.End;
+
+		// Rough guesses based on typical exported files, avoids most of the regrowth
+		size_t estimatedLines = (end - p) / 32;
+		chunk.Positions.reserve(estimatedLines / 4);
+		chunk.Normals.reserve(estimatedLines / 4);
+		chunk.UVs.reserve(estimatedLines / 4);
+		chunk.Corners.reserve(estimatedLines);
+		chunk.FaceSizes.reserve(estimatedLines / 2);
+
+		while (p < end) {
+			// Find the end of this line so we can skip anything we don't care about
+			const char* eol = static_cast<const char*>(memchr(p, '\n', end - p));
+			if (eol == nullptr) { eol = end; }
+
+			p = SkipSpace(p, eol);
+
+			if (p + 1 < eol && p[0] == 'v' && IsSpace(p[1])) {
+				glm::vec3 pos;
+				p = ParseFloat(p + 1, eol, pos.x);
+				p = ParseFloat(p, eol, pos.y);
+				p = ParseFloat(p, eol, pos.z);
+				chunk.Positions.push_back(pos);
+			}
+			else if (p + 2 < eol && p[0] == 'v' && p[1] == 'n' && IsSpace(p[2])) {
+				glm::vec3 normal;
+				p = ParseFloat(p + 2, eol, normal.x);
+				p = ParseFloat(p, eol, normal.y);
+				p = ParseFloat(p, eol, normal.z);
+				chunk.Normals.push_back(normal);
+			}
+			else if (p + 2 < eol && p[0] == 'v' && p[1] == 't' && IsSpace(p[2])) {
+				glm::vec2 uv;
+				p = ParseFloat(p + 2, eol, uv.x);
+				p = ParseFloat(p, eol, uv.y);
+				chunk.UVs.push_back(uv);
+			}
+			// NOTE: like the original loaders, we only handle triangles and quads. Any corners past
+			// the fourth are ignored, so make sure to triangulate on export
+			else if (p + 1 < eol && p[0] == 'f' && IsSpace(p[1])) {
+				// The old loaders trimmed the rest of the line before reading it
+				const char* begin = p + 1;
+				const char* lineEnd = eol;
+				while (begin < lineEnd && IsStreamSpace(*begin)) { begin++; }
+				while (lineEnd > begin && IsStreamSpace(lineEnd[-1])) { lineEnd--; }
+
+				// Corners are read as p/t/n. A corner that fails to read part way through (such as the
+				// p//n form) is still added, but it's the last one read, so the face gets dropped
+				FaceStream stream(begin, lineEnd);
+				uint8_t count = 0;
+				for (; count < 4 && stream.HasMore(); count++) {
+					FaceCorner corner ={ 0, 0, 0 };
+					stream.ReadInt(corner.Values[0]);
+					stream.SkipChar();
+					stream.ReadInt(corner.Values[1]);
+					stream.SkipChar();
+					stream.ReadInt(corner.Values[2]);
+
+					// Negative values are relative to the most recently added attributes. We only
+					// know how many attributes this chunk has seen so far, so store it relative to
+					// the chunk and fix it up after all chunks are parsed
+					const size_t counts[3] ={ chunk.Positions.size(), chunk.UVs.size(), chunk.Normals.size() };
+					for (int ix = 0; ix < 3; ix++) {
+						if (corner.Values[ix] < 0) {
+							corner.Values[ix] = static_cast<int32_t>(counts[ix]) + 1 + corner.Values[ix];
+							chunk.RelativeComponents.push_back(static_cast<uint32_t>(chunk.Corners.size() * 3 + ix));
+						}
+					}
+
+					chunk.Corners.push_back(corner);
+				}
+				chunk.FaceSizes.push_back(count);
+			}
+
+			p = eol + 1;
+		}
+	}
+
+	/// <summary>
+	/// Minimal open-addressing hash map from an attribute key to a vertex index. Since we know roughly
+	/// how many keys we'll have up front, we can allocate once and skip all of the per-node allocations
+	/// that std::unordered_map would make
+	/// </summary>
+	class FlatVertexMap {
+	public:
+		explicit FlatVertexMap(size_t expectedKeys) {
+			size_t capacity = 16;
+			while (capacity < expectedKeys * 2) { capacity <<= 1; }
+			_mask = capacity - 1;
+			_keys.resize(capacity, EMPTY);
+			_values.resize(capacity);
+		}
+
+		// Returns the value associated with key, inserting value if the key is not present
+		// Returns true if the value was inserted
+		bool FindOrInsert(uint64_t key, uint32_t value, uint32_t& outValue) {
+			size_t slot = _Hash(key) & _mask;
+			while (true) {
+				if (_keys[slot] == key) {
+					outValue = _values[slot];
+					return false;
+				}
+				if (_keys[slot] == EMPTY) {
+					_keys[slot]   = key;
+					_values[slot] = value;
+					outValue = value;
+					return true;
+				}
+				slot = (slot + 1) & _mask;
+			}
+		}
+
+	private:
+		// Our keys only ever use the low 63 bits, so we can use this as a sentinel
+		static constexpr uint64_t EMPTY = ~0ull;
+
+		std::vector<uint64_t> _keys;
+		std::vector<uint32_t> _values;
+		size_t _mask;
+
+		static size_t _Hash(uint64_t key) {
+			// Fibonacci hashing, keeps sequential keys from clustering
+			key *= 0x9E3779B97F4A7C15ull;
+			return static_cast<size_t>(key ^ (key >> 32));
+		}
+	};
+}
+
+bool ParallelObjParser::ParseFile(const std::string& filename, Result& result, uint32_t maxThreads) {
+	MemoryMappedFile file;
+	if (!file.Open(filename)) {
+		return false;
+	}
+	Parse(file.GetDataAs<char>(), file.GetSize(), result, maxThreads);
+	return true;
+}
+
+void ParallelObjParser::Parse(const char* data, size_t size, Result& result, uint32_t maxThreads) {
+	result.Positions.clear();
+	result.Normals.clear();
+	result.UVs.clear();
+	result.Vertices.clear();
+	result.Indices.clear();
+
+	if (data == nullptr || size == 0) {
+		return;
+	}
+
+	// Determine how many chunks to split the file into
+	uint32_t threadCount = maxThreads > 0 ? maxThreads : std::max(1u, std::thread::hardware_concurrency());
+	size_t chunkCount = std::clamp<size_t>(size / MIN_CHUNK_SIZE, 1, threadCount);
+
+	// Split the file into chunks, moving the split points forward to the next line break
+	std::vector<Chunk> chunks(chunkCount);
+	const char* end = data + size;
+	const char* seek = data;
+	for (size_t ix = 0; ix < chunkCount; ix++) {
+		chunks[ix].Begin = seek;
+		if (ix == chunkCount - 1) {
+			seek = end;
+		} else {
+			seek = std::max(seek, data + (size * (ix + 1)) / chunkCount);
+			const char* eol = static_cast<const char*>(memchr(seek, '\n', end - seek));
+			seek = eol != nullptr ? eol + 1 : end;
+		}
+		chunks[ix].End = seek;
+	}
+
+	// Parse all the chunks, using the calling thread for the first one
+	std::vector<std::thread> workers;
+	workers.reserve(chunkCount - 1);
+	for (size_t ix = 1; ix < chunkCount; ix++) {
+		workers.emplace_back(ParseChunk, std::ref(chunks[ix]));
+	}
+	ParseChunk(chunks[0]);
+	for (auto& worker : workers) {
+		worker.join();
+	}
+
+	// Stitch the attributes together, and fix up any relative indices now that we know the offsets
+	size_t totalCorners = 0;
+	size_t offsets[3] ={ 0, 0, 0 };
+	for (Chunk& chunk : chunks) {
+		for (uint32_t component : chunk.RelativeComponents) {
+			chunk.Corners[component / 3].Values[component % 3] += static_cast<int32_t>(offsets[component % 3]);
+		}
+		offsets[0] += chunk.Positions.size();
+		offsets[1] += chunk.UVs.size();
+		offsets[2] += chunk.Normals.size();
+		totalCorners += chunk.Corners.size();
+	}
+
+	result.Positions.reserve(offsets[0]);
+	result.UVs.reserve(offsets[1]);
+	result.Normals.reserve(offsets[2]);
+	for (const Chunk& chunk : chunks) {
+		result.Positions.insert(result.Positions.end(), chunk.Positions.begin(), chunk.Positions.end());
+		result.UVs.insert(result.UVs.end(), chunk.UVs.begin(), chunk.UVs.end());
+		result.Normals.insert(result.Normals.end(), chunk.Normals.begin(), chunk.Normals.end());
+	}
+
+	// De-duplicating has to happen in file order so the vertex order matches the original loaders
+	FlatVertexMap vertexMap(totalCorners);
+	result.Vertices.reserve(totalCorners);
+	result.Indices.reserve(totalCorners * 3 / 2);
+
+	const int32_t positionCount = static_cast<int32_t>(result.Positions.size());
+
+	for (const Chunk& chunk : chunks) {
+		const FaceCorner* corner = chunk.Corners.data();
+		for (uint8_t faceSize : chunk.FaceSizes) {
+			uint32_t edges[4];
+			for (int ix = 0; ix < faceSize; ix++, corner++) {
+				const int32_t* values = corner->Values;
+				if (values[0] < 1 || values[0] > positionCount) {
+					throw std::runtime_error("OBJ face references a position that does not exist");
+				}
+
+				// We can construct a key using a bitmask of the attribute indices
+				// Note that this limits us to 2,097,150 unique attributes for positions, normals and textures
+				const uint64_t mask = 0b0'000000000000000000000'000000000000000000000'111111111111111111111;
+				uint64_t key = ((values[0] & mask) << 42) | ((values[1] & mask) << 21) | (values[2] & mask);
+
+				uint32_t index;
+				if (vertexMap.FindOrInsert(key, static_cast<uint32_t>(result.Vertices.size()), index)) {
+					result.Vertices.push_back(glm::ivec3(values[0], values[1], values[2]) - glm::ivec3(1));
+				}
+				edges[ix] = index;
+			}
+
+			// Handling for triangle faces
+			if (faceSize == 3) {
+				result.Indices.insert(result.Indices.end(), { edges[0], edges[1], edges[2] });
+			}
+			// Handling for quad faces
+			else if (faceSize == 4) {
+				result.Indices.insert(result.Indices.end(), { edges[0], edges[1], edges[2], edges[0], edges[2], edges[3] });
+			}
+		}
+	}
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <GLM/glm.hpp>
+
+/// <summary>
+/// A fast OBJ parser that memory maps the source file, splits it into line-aligned chunks and
+/// parses those chunks in parallel. Number parsing is done with std::from_chars straight out of
+/// the mapped file, so there are no per-token allocations like with the iostream based loaders
+///
+/// The result is the same de-duplicated set of vertices (in the same first-seen order) that the iostream
+/// based ObjLoader and OptimizedObjLoader generated. Faces are read with the same rules those loaders used,
+/// so faces with corners in the p, p/t and p//n forms are misread or dropped exactly like they were before
+/// </summary>
+class ParallelObjParser {
+public:
+	/// <summary>
+	/// The parsed contents of an OBJ file
+	/// </summary>
+	struct Result {
+		std::vector<glm::vec3>  Positions;
+		std::vector<glm::vec3>  Normals;
+		std::vector<glm::vec2>  UVs;
+		// The OBJ indices minus one into Positions, UVs and Normals for each unique vertex, -1 indicates that
+		// the face did not specify that attribute. Use ObjLoader::BuildMesh to turn these into vertices
+		std::vector<glm::ivec3> Vertices;
+		// Triangle list indices into Vertices (quads are split into two triangles)
+		std::vector<uint32_t>   Indices;
+	};
+
+	/// <summary>
+	/// Parses an OBJ file from disk
+	/// </summary>
+	/// <param name="filename">The path to the .obj file to parse</param>
+	/// <param name="result">The result to store the file contents in, any existing contents will be overwritten</param>
+	/// <param name="maxThreads">The maximum number of threads to parse with, or 0 to use all hardware threads</param>
+	/// <returns>True if the file was loaded, false if it could not be opened</returns>
+	static bool ParseFile(const std::string& filename, Result& result, uint32_t maxThreads = 0);
+
+	/// <summary>
+	/// Parses OBJ file contents that are already in memory
+	/// </summary>
+	/// <param name="data">The text of the OBJ file</param>
+	/// <param name="size">The number of bytes in data</param>
+	/// <param name="result">The result to store the file contents in, any existing contents will be overwritten</param>
+	/// <param name="maxThreads">The maximum number of threads to parse with, or 0 to use all hardware threads</param>
+	static void Parse(const char* data, size_t size, Result& result, uint32_t maxThreads = 0);
+
+protected:
+	ParallelObjParser() = default;
+	~ParallelObjParser() = default;
+};
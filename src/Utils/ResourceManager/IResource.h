@@ -33,6 +33,12 @@ public:
 
 	virtual void ResolveReferences() {};
 
+	/// <summary>
+	/// Gets an estimate of the memory used by this resource (including GPU memory), in bytes. The
+	/// resource manager uses this to decide when to evict unused resources
+	/// </summary>
+	virtual size_t GetMemoryUsage() const { return 0; }
+
 	/// <summary>
 	/// Converts this resource into it's JSON manifest format
 	/// Should contain all the data required to reconstruct the
@@ -1,11 +1,26 @@
 #include "Utils/ResourceManager/ResourceManager.h"
 
+#include <chrono>
+
 #include "Utils/ObjLoader.h"
 #include "Utils/FileHelpers.h"
 #include "Utils/StringUtils.h"
+#include "Logging.h"
+
+std::unordered_map<std::type_index, std::unordered_map<Guid, ResourceManager::ResourceEntry>> ResourceManager::_resources;
+std::list<ResourceManager::ResidencyKey> ResourceManager::_lru;
+std::unordered_map<std::type_index, ResourceManager::TypeStats> ResourceManager::_typeStats;
+std::unordered_set<Guid> ResourceManager::_evicted;
+size_t ResourceManager::_memoryBudget = 0;
+
+std::unordered_map<std::string, std::function<Guid(const nlohmann::json&)>> ResourceManager::_typeLoaders;
+std::unordered_map<std::string, std::function<std::shared_ptr<void>(const nlohmann::json&)>> ResourceManager::_typeDecoders;
+std::unordered_map<std::string, std::function<Guid(const nlohmann::json&, const std::shared_ptr<void>&)>> ResourceManager::_typeUploaders;
 
-std::map<std::type_index, std::map<Guid, IResource::Sptr>> ResourceManager::_resources;
-std::map<std::string, std::function<Guid(const nlohmann::json&)>> ResourceManager::_typeLoaders;
+std::unordered_map<Guid, std::shared_ptr<ResourceManager::LoadRequest>> ResourceManager::_requests;
+std::deque<std::shared_ptr<ResourceManager::LoadRequest>> ResourceManager::_pendingRequests;
+std::deque<std::shared_ptr<ResourceManager::LoadRequest>> ResourceManager::_uploadQueue;
+uint32_t ResourceManager::_maxLoadsInFlight = 16;
 
 nlohmann::ordered_json ResourceManager::_manifest;
 
@@ -27,22 +42,296 @@ void ResourceManager::LoadManifest(const std::string& path, bool preloadAssets)
 	_manifest = blob;
 
 	if (preloadAssets) {
-		for (auto& [typeName, items] : blob.items()) {
-			auto& func = _typeLoaders[typeName];
-			if (func) {
-				for (auto& [guid, blob] : items.items()) {
-					func(blob);
+		// Queue everything in manifest order, so that assets are created after the assets they depend on
+		for (auto& [typeName, items] : _manifest.items()) {
+			if (_typeLoaders[typeName]) {
+				for (auto& [guid, data] : items.items()) {
+					_Submit(typeName, Guid(guid), data);
+				}
+			}
+		}
+		LOG_INFO("Queued {} assets from \"{}\" for background loading", _requests.size(), path);
+	}
+}
+
+void ResourceManager::ProcessUploads(float budgetMs) {
+	using Clock = std::chrono::steady_clock;
+	const Clock::time_point end = Clock::now() + std::chrono::microseconds(static_cast<int64_t>(budgetMs * 1000.0f));
+
+	_DispatchPending();
+
+	bool first = true;
+	while (!_uploadQueue.empty() && (first || Clock::now() < end)) {
+		std::shared_ptr<LoadRequest> request = _uploadQueue.front();
+
+		// Assets are created in request order, so if the next one is still decoding we stop here
+		// (it may also have already been finished early by a call to Get)
+		AssetLoadState state = request->State.load(std::memory_order_acquire);
+		if (state == AssetLoadState::Decoding) {
+			break;
+		}
+		_uploadQueue.pop_front();
+		if (state != AssetLoadState::Loaded) {
+			_Complete(request);
+			first = false;
+		}
+
+		// Now that there's room in the queue, start decoding the next asset
+		_DispatchPending();
+	}
+
+	// Assets may have become unused since last frame
+	EnforceMemoryBudget();
+}
+
+size_t ResourceManager::GetPendingLoadCount() {
+	return _requests.size();
+}
+
+void ResourceManager::SetMaxLoadsInFlight(uint32_t value) {
+	_maxLoadsInFlight = value > 0 ? value : 1;
+}
+
+void ResourceManager::SetMemoryBudget(size_t bytes) {
+	_memoryBudget = bytes;
+	EnforceMemoryBudget();
+}
+
+size_t ResourceManager::GetMemoryBudget() {
+	return _memoryBudget;
+}
+
+size_t ResourceManager::EnforceMemoryBudget() {
+	if (_memoryBudget == 0) {
+		return 0;
+	}
+
+	// Assets can change size after they're loaded (ex: framebuffers being resized), so we re-measure everything
+	size_t total = GetResidentBytes();
+	if (total <= _memoryBudget) {
+		return 0;
+	}
+
+	// Walk from the least recently used asset towards the most recently used one
+	size_t freed = 0;
+	auto it = _lru.end();
+	while (it != _lru.begin() && total > _memoryBudget) {
+		--it;
+		auto& map = _resources[it->Type];
+		auto entry = map.find(it->Id);
+		LOG_ASSERT(entry != map.end(), "LRU list is out of sync with the resource pool!");
+
+		// We can only evict assets that we know how to reload, and that nobody outside of the resource manager is using
+		if (entry->second.Evictable && entry->second.Bytes > 0 && entry->second.Resource.use_count() == 1) {
+			total -= entry->second.Bytes;
+			freed += entry->second.Bytes;
+			_typeStats[it->Type].Evictions++;
+			_evicted.insert(it->Id);
+
+			map.erase(entry);
+			it = _lru.erase(it);
+		}
+	}
+
+	if (freed > 0) {
+		LOG_TRACE("Evicted {} bytes of unused assets, {} bytes resident of {} byte budget", freed, total, _memoryBudget);
+	}
+	return freed;
+}
+
+size_t ResourceManager::GetResidentBytes() {
+	size_t total = 0;
+	for (auto& [type, map] : _resources) {
+		for (auto& [id, entry] : map) {
+			entry.Bytes = entry.Resource->GetMemoryUsage();
+			total += entry.Bytes;
+		}
+	}
+	return total;
+}
+
+std::vector<ResourceManager::ResidencyStats> ResourceManager::GetResidencyStats() {
+	std::vector<ResidencyStats> result;
+	for (auto& [type, stats] : _typeStats) {
+		ResidencyStats item;
+		item.TypeName  = stats.TypeName;
+		item.Loads     = stats.Loads;
+		item.Evictions = stats.Evictions;
+		item.Reloads   = stats.Reloads;
+
+		auto map = _resources.find(type);
+		if (map != _resources.end()) {
+			for (auto& [id, entry] : map->second) {
+				size_t bytes = entry.Resource->GetMemoryUsage();
+				item.ResidentCount++;
+				item.ResidentBytes += bytes;
+				if (entry.Evictable && entry.Resource.use_count() == 1) {
+					item.EvictableBytes += bytes;
 				}
 			}
 		}
+		result.push_back(item);
 	}
+	return result;
+}
+
+void ResourceManager::_Track(std::type_index type, const IResource::Sptr& resource, bool evictable) {
+	Guid id = resource->GetGUID();
+	auto& map = _resources[type];
+
+	// If we're replacing an asset, drop the old one's place in the LRU list
+	auto existing = map.find(id);
+	if (existing != map.end()) {
+		_lru.erase(existing->second.LruPosition);
+	}
+
+	ResourceEntry& entry = map[id];
+	entry.Resource = resource;
+	entry.Bytes = resource->GetMemoryUsage();
+	entry.Evictable = evictable;
+	_lru.push_front(ResidencyKey{ type, id });
+	entry.LruPosition = _lru.begin();
+
+	TypeStats& stats = _typeStats[type];
+	if (stats.TypeName.empty()) {
+		stats.TypeName = StringTools::SanitizeClassName(type.name());
+	}
+	stats.Loads++;
+	if (_evicted.erase(id) > 0) {
+		stats.Reloads++;
+	}
+}
+
+IResource::Sptr ResourceManager::_Find(std::type_index type, Guid id) {
+	auto map = _resources.find(type);
+	if (map == _resources.end()) {
+		return nullptr;
+	}
+	auto entry = map->second.find(id);
+	if (entry == map->second.end()) {
+		return nullptr;
+	}
+
+	// Move the asset to the front of the LRU list
+	_lru.splice(_lru.begin(), _lru, entry->second.LruPosition);
+	return entry->second.Resource;
+}
+
+std::shared_ptr<ResourceManager::LoadRequest> ResourceManager::_Submit(const std::string& typeName, Guid id, const nlohmann::json& data) {
+	// If we're already loading this asset, share the existing load
+	auto it = _requests.find(id);
+	if (it != _requests.end()) {
+		return it->second;
+	}
+
+	std::shared_ptr<LoadRequest> request = std::make_shared<LoadRequest>();
+	request->TypeName = typeName;
+	request->Id = id;
+	request->Data = data;
+	_requests[id] = request;
+	_pendingRequests.push_back(request);
+	_DispatchPending();
+	return request;
+}
+
+void ResourceManager::_DispatchPending() {
+	while (!_pendingRequests.empty() && _uploadQueue.size() < _maxLoadsInFlight) {
+		std::shared_ptr<LoadRequest> request = _pendingRequests.front();
+		_pendingRequests.pop_front();
+
+		// Loads that were finished early by Get don't need to go through the queue
+		if (!request->IsDispatched) {
+			_Dispatch(request);
+			_uploadQueue.push_back(request);
+		}
+	}
+}
+
+void ResourceManager::_Dispatch(const std::shared_ptr<LoadRequest>& request) {
+	request->IsDispatched = true;
+
+	// Types without a decode step are created entirely on the main thread
+	auto decoder = _typeDecoders.find(request->TypeName);
+	if (decoder == _typeDecoders.end()) {
+		request->State.store(AssetLoadState::ReadyToUpload, std::memory_order_release);
+		return;
+	}
+
+	request->State.store(AssetLoadState::Decoding, std::memory_order_release);
+	// The decoder and request are captured by value, since the job may outlive this call
+	JobSystem::Run([request, decode = decoder->second]() {
+		// Jobs must not throw, so we report decode errors and let the main thread fail the load
+		try {
+			request->Payload = decode(request->Data);
+			request->State.store(AssetLoadState::ReadyToUpload, std::memory_order_release);
+		}
+		catch (const std::exception& e) {
+			LOG_ERROR("Failed to decode asset {} ({}) from \"{}\": {}", request->Id.str(), request->TypeName, _GetSourcePath(request->Data), e.what());
+			request->State.store(AssetLoadState::Failed, std::memory_order_release);
+		}
+	}, &request->Decoded);
+}
+
+void ResourceManager::_Complete(const std::shared_ptr<LoadRequest>& request) {
+	LOG_ASSERT(!JobSystem::IsInJob(), "Assets can only be created on the main thread!");
+
+	AssetLoadState state = request->State.load(std::memory_order_acquire);
+	if (state == AssetLoadState::Loaded) {
+		return;
+	}
+
+	// Loads that haven't made it into the upload queue yet get decoded right away
+	if (!request->IsDispatched) {
+		_Dispatch(request);
+	}
+	JobSystem::Wait(request->Decoded);
+
+	// We remove the request first, so that a Get for this asset during creation doesn't try to finish it again
+	_requests.erase(request->Id);
+
+	if (request->State.load(std::memory_order_acquire) == AssetLoadState::ReadyToUpload) {
+		// A single bad asset shouldn't take down everything else that is loading, so we only fail this load
+		try {
+			auto uploader = _typeUploaders.find(request->TypeName);
+			if (uploader != _typeUploaders.end()) {
+				uploader->second(request->Data, request->Payload);
+			} else {
+				_typeLoaders[request->TypeName](request->Data);
+			}
+
+			// Search the resources for the asset we just created
+			for (auto& [type, map] : _resources) {
+				auto it = map.find(request->Id);
+				if (it != map.end()) {
+					request->Result = it->second.Resource;
+					break;
+				}
+			}
+		}
+		catch (const std::exception& e) {
+			LOG_ERROR("Failed to load asset {} ({}) from \"{}\": {}", request->Id.str(), request->TypeName, _GetSourcePath(request->Data), e.what());
+		}
+		request->Payload = nullptr;
+	}
+	request->State.store(request->Result != nullptr ? AssetLoadState::Loaded : AssetLoadState::Failed, std::memory_order_release);
+}
+
+std::string ResourceManager::_GetSourcePath(const nlohmann::json& data) {
+	// Most assets are loaded from a single file, cubemaps are named after their base file
+	for (const char* key : { "filename", "base_filename" }) {
+		if (data.contains(key) && data[key].is_string()) {
+			return data[key].get<std::string>();
+		}
+	}
+	return "";
 }
 
 void ResourceManager::SaveManifest(const std::string& path) {
 	// Update all resources in the manifest so they match their current representation
 	for (auto& [type, map] : _resources) {
 		std::string typeName = StringTools::SanitizeClassName(type.name());
-		for (auto& [guid, res] : map) {
+		for (auto& [guid, entry] : map) {
+			const IResource::Sptr& res = entry.Resource;
 			if (res != nullptr) {
 				_manifest[typeName][guid.str()] = res->ToJson();
 				_manifest[typeName][guid.str()]["guid"] = res->GetGUID().str();
@@ -53,8 +342,18 @@ void ResourceManager::SaveManifest(const std::string& path) {
 }
 
 void ResourceManager::Cleanup() {
+	// Let any loads that are still decoding finish before we drop them
+	for (auto& [id, request] : _requests) {
+		JobSystem::Wait(request->Decoded);
+	}
+	_requests.clear();
+	_pendingRequests.clear();
+	_uploadQueue.clear();
+
 	for (auto& [type, map] : _resources) {
 		map.clear();
 	}
+	_lru.clear();
+	_evicted.clear();
 }
 
@@ -2,18 +2,145 @@
 
 #include <json.hpp>
 #include <unordered_map>
+#include <unordered_set>
 #include <typeindex>
+#include <atomic>
+#include <deque>
+#include <list>
+#include <EnumToString.h>
 
 #include "Utils/GUID.hpp"
 #include "Utils/ResourceManager/IResource.h"
 #include "Utils/StringUtils.h"
+#include "Utils/JobSystem.h"
+#include "Utils/Macros.h"
+
+/// <summary>
+/// The stages that an asset goes through when it is loaded in the background
+/// </summary>
+ENUM(AssetLoadState, uint8_t,
+	// Waiting for room in the upload queue
+	Queued        = 0,
+	// Files are being decoded on a worker thread
+	Decoding      = 1,
+	// Decoded, waiting for the main thread to create the OpenGL objects
+	ReadyToUpload = 2,
+	// The asset is loaded and can be used
+	Loaded        = 3,
+	// The asset could not be loaded
+	Failed        = 4
+);
 
 /// <summary>
 /// Utility class for managing and loading resources from JSON
 /// manifest files
+///
+/// Resource types can optionally split their loading into two steps, which lets the resource manager
+/// decode their files on the job system instead of the main thread:
+/// 
+/// static std::shared_ptr<DecodedType> Decode(const nlohmann::json&);
+/// static std::shared_ptr<Type> FromDecoded(const nlohmann::json&, const std::shared_ptr<DecodedType>&);
+/// 
+/// where Decode must not touch OpenGL. Types without these are created on the main thread
+///
+/// Assets that were loaded from the manifest are evicted in least recently used order once the
+/// resident assets go over the memory budget (see SetMemoryBudget), but only while nothing outside of
+/// the resource manager holds a reference to them. Evicted assets are reloaded by the next Get
 /// </summary>
 class ResourceManager {
 public:
+	/// <summary>
+	/// Residency information for a single resource type, see GetResidencyStats
+	/// </summary>
+	struct ResidencyStats {
+		std::string TypeName;
+		// The number of assets of this type that are currently loaded
+		size_t      ResidentCount = 0;
+		// The memory used by the loaded assets, as reported by IResource::GetMemoryUsage
+		size_t      ResidentBytes = 0;
+		// The memory used by loaded assets that could be evicted right now
+		size_t      EvictableBytes = 0;
+		// Totals since startup
+		size_t      Loads = 0;
+		size_t      Evictions = 0;
+		// Loads of assets that had previously been evicted
+		size_t      Reloads = 0;
+	};
+
+protected:
+	/// <summary>
+	/// Shared state for an asset that is being loaded in the background. Everything except State
+	/// and Payload is only touched on the main thread
+	/// </summary>
+	struct LoadRequest {
+		NO_COPY(LoadRequest);
+		NO_MOVE(LoadRequest);
+
+		LoadRequest() : State(AssetLoadState::Queued), IsDispatched(false) { }
+
+		std::string                 TypeName;
+		Guid                        Id;
+		nlohmann::json              Data;
+		// The result of the type's Decode function, written by the decode job
+		std::shared_ptr<void>       Payload;
+		std::atomic<AssetLoadState> State;
+		// Tracks the decode job, so the main thread can wait on it
+		JobSystem::Counter          Decoded;
+		bool                        IsDispatched;
+		IResource::Sptr             Result;
+	};
+
+public:
+	/// <summary>
+	/// A handle to an asset that was requested with GetAsync, which can be polled to see
+	/// whether the asset has finished loading
+	/// </summary>
+	/// <typeparam name="T">The type of resource being loaded</typeparam>
+	template <typename T>
+	class AsyncAsset {
+	public:
+		AsyncAsset() : _request(nullptr), _resource(nullptr) { }
+
+		/// <summary>
+		/// Gets the current stage of the asset's load
+		/// </summary>
+		AssetLoadState GetState() const {
+			if (_resource != nullptr) { return AssetLoadState::Loaded; }
+			if (_request == nullptr) { return AssetLoadState::Failed; }
+			return _request->State.load(std::memory_order_acquire);
+		}
+		/// <summary>
+		/// Returns true if the asset has finished loading (or failed to load)
+		/// </summary>
+		bool IsReady() const {
+			AssetLoadState state = GetState();
+			return state == AssetLoadState::Loaded || state == AssetLoadState::Failed;
+		}
+		/// <summary>
+		/// Gets the asset if it has finished loading, or nullptr if it is not ready yet
+		/// </summary>
+		std::shared_ptr<T> Get() const {
+			if (_resource == nullptr && _request != nullptr && _request->State.load(std::memory_order_acquire) == AssetLoadState::Loaded) {
+				return std::dynamic_pointer_cast<T>(_request->Result);
+			}
+			return _resource;
+		}
+		/// <summary>
+		/// Finishes loading the asset right away and returns it, must be called on the main thread
+		/// </summary>
+		std::shared_ptr<T> Wait() const {
+			if (_resource == nullptr && _request != nullptr) {
+				ResourceManager::_Complete(_request);
+			}
+			return Get();
+		}
+
+	private:
+		friend class ResourceManager;
+		std::shared_ptr<LoadRequest> _request;
+		std::shared_ptr<T>           _resource;
+	};
+
 	/// <summary>
 	/// Initializes the resource manager and performs any first-time
 	/// setup required
@@ -31,7 +158,8 @@ public:
 	static std::shared_ptr<T> CreateAsset(TArgs&&... args) {
 		// Create and store the asset
 		std::shared_ptr<T> asset = std::make_shared<T>(std::forward<TArgs>(args)...);
-		_resources[std::type_index(typeid(T))][asset->IResource::GetGUID()] = asset;
+		// Assets created at runtime may hold state that their manifest entry doesn't capture, so they are never evicted
+		_Track(std::type_index(typeid(T)), asset, false);
 
 		// Get the JSON representation of the asset so we can store it in the manifest
 		nlohmann::json data = asset->ToJson();
@@ -53,21 +181,37 @@ public:
 	/// <returns>The resource with the given GUID, or nullptr if none exists</returns>
 	template<typename T, typename = std::enable_if<is_valid_resource<T>()>::type>
 	static std::shared_ptr<T> Get(Guid id) {
+		std::type_index type = std::type_index(typeid(T));
+
 		// Try and grab the asset from the resource pool
-		std::shared_ptr<T> result =  std::dynamic_pointer_cast<T>(_resources[std::type_index(typeid(T))][id]);
+		std::shared_ptr<T> result = std::dynamic_pointer_cast<T>(_Find(type, id));
 
 		// If the asset is null, we can try finding it in the manifest to load it
 		if (result == nullptr) {
-			// Get the type name it'll be stored under
-			std::string typeName = StringTools::SanitizeClassName(typeid(T).name());
+			// If the asset is already being loaded in the background, finish loading it now
+			auto it = _requests.find(id);
+			if (it != _requests.end()) {
+				std::shared_ptr<LoadRequest> request = it->second;
+				_Complete(request);
+				result = std::dynamic_pointer_cast<T>(_Find(type, id));
+			}
+			else {
+				// Get the type name it'll be stored under
+				std::string typeName = StringTools::SanitizeClassName(typeid(T).name());
+
+				// If the manifest has an entry, we can load it!
+				if (_manifest[typeName].contains(id)) {
+					// Invoke the loader function with the manifest data
+					_typeLoaders[typeName](_manifest[typeName][id]);
 
-			// If the manifest has an entry, we can load it!
-			if (_manifest[typeName].contains(id)) {
-				// Invoke the loader function with the manifest data
-				_typeLoaders[typeName](_manifest[typeName][id]);
+					// Search resources again to get the resource
+					result = std::dynamic_pointer_cast<T>(_Find(type, id));
+				}
+			}
 
-				// Search resources again to get the resource
-				return std::dynamic_pointer_cast<T>(_resources[std::type_index(typeid(T))][id]);
+			// Loading may have put us over budget, since we're holding the new asset it won't be evicted
+			if (result != nullptr) {
+				EnforceMemoryBudget();
 			}
 		}
 
@@ -75,6 +219,72 @@ public:
 		return result;
 	}
 
+	/// <summary>
+	/// Starts loading the resource with the given type and GUID in the background. Its files are decoded
+	/// on the job system, and the asset is created on the main thread by ProcessUploads
+	/// </summary>
+	/// <typeparam name="T">The type of resource to retreive</typeparam>
+	/// <param name="id">The ID of the resource to load</param>
+	/// <returns>A handle that can be polled for the asset, which is failed if the asset is not in the manifest</returns>
+	template<typename T, typename = std::enable_if<is_valid_resource<T>()>::type>
+	static AsyncAsset<T> GetAsync(Guid id) {
+		AsyncAsset<T> result;
+
+		// If the asset is already loaded, the handle is ready right away
+		result._resource = std::dynamic_pointer_cast<T>(_Find(std::type_index(typeid(T)), id));
+		if (result._resource != nullptr) {
+			return result;
+		}
+
+		std::string typeName = StringTools::SanitizeClassName(typeid(T).name());
+		if (_manifest.contains(typeName) && _manifest[typeName].contains(id.str())) {
+			result._request = _Submit(typeName, id, _manifest[typeName][id.str()]);
+		}
+		return result;
+	}
+
+	/// <summary>
+	/// Creates assets that have finished decoding in the background, must be called on the main thread
+	/// once per frame. Assets are created in the order they were requested, so assets that depend on
+	/// others are always created after them
+	/// </summary>
+	/// <param name="budgetMs">The time to spend creating assets, in milliseconds. At least one asset is always created</param>
+	static void ProcessUploads(float budgetMs);
+	/// <summary>
+	/// Gets the number of assets that are still being loaded in the background
+	/// </summary>
+	static size_t GetPendingLoadCount();
+	/// <summary>
+	/// Sets how many background loads may be decoding or waiting for upload at once, this limits how
+	/// much decoded data is held in memory. Default 16
+	/// </summary>
+	static void SetMaxLoadsInFlight(uint32_t value);
+
+	/// <summary>
+	/// Sets the amount of memory that loaded assets may use before the resource manager starts
+	/// evicting unused assets, or 0 for no limit (the default)
+	/// </summary>
+	/// <param name="bytes">The budget, in bytes</param>
+	static void SetMemoryBudget(size_t bytes);
+	/// <summary>
+	/// Gets the current memory budget in bytes, or 0 if there is no limit
+	/// </summary>
+	static size_t GetMemoryBudget();
+	/// <summary>
+	/// Evicts unused assets, least recently used first, until the resident assets fit in the memory
+	/// budget. This is done automatically when assets are loaded, and once per frame by ProcessUploads
+	/// </summary>
+	/// <returns>The number of bytes that were freed</returns>
+	static size_t EnforceMemoryBudget();
+	/// <summary>
+	/// Gets the total memory used by all loaded assets, in bytes
+	/// </summary>
+	static size_t GetResidentBytes();
+	/// <summary>
+	/// Gets residency information for each resource type that has been loaded or registered
+	/// </summary>
+	static std::vector<ResidencyStats> GetResidencyStats();
+
 	/// <summary>
 	/// Registers a resource type with the resource manager, only types that have been registered
 	/// can be loaded from JSON manifest files!
@@ -90,9 +300,24 @@ public:
 		_typeLoaders[typeName] = [](const nlohmann::json& data) {
 			IResource::Sptr res = T::FromJson(data);
 			res->OverrideGUID(Guid(data["guid"]));
-			_resources[std::type_index(typeid(T))][res->GetGUID()] = res;
+			_Track(std::type_index(typeid(T)), res, true);
 			return res->GetGUID();
 		};
+		_typeStats[std::type_index(typeid(T))].TypeName = typeName;
+
+		// Types that can decode their files without OpenGL get loaded on the job system
+		if constexpr (test_decode<T, const nlohmann::json&>::value) {
+			_typeDecoders[typeName] = [](const nlohmann::json& data) {
+				return std::static_pointer_cast<void>(T::Decode(data));
+			};
+			_typeUploaders[typeName] = [](const nlohmann::json& data, const std::shared_ptr<void>& payload) {
+				using DecodedType = typename decltype(T::Decode(data))::element_type;
+				IResource::Sptr res = T::FromDecoded(data, std::static_pointer_cast<DecodedType>(payload));
+				res->OverrideGUID(Guid(data["guid"]));
+				_Track(std::type_index(typeid(T)), res, true);
+				return res->GetGUID();
+			};
+		}
 
 		// Make sure we haven't registered the type yet, then add an empty object
 		// to the manifest to ensure it can be saved
@@ -116,11 +341,11 @@ public:
 		std::type_index type = std::type_index(typeid(ResourceType));
 
 		// Iterate over all the resources in the store
-		for (auto& [key, value] : _resources[type]) {
+		for (auto& [key, entry] : _resources[type]) {
 			// If the pointer is alive and matches our enabled criteria, invoke the callback
-			if (value != nullptr) {
+			if (entry.Resource != nullptr) {
 				// Upcast to resource type and invoke the callback
-				callback(std::dynamic_pointer_cast<ResourceType>(value));
+				callback(std::dynamic_pointer_cast<ResourceType>(entry.Resource));
 			}
 		}
 	}
@@ -131,7 +356,7 @@ public:
 	static const nlohmann::ordered_json& GetManifest();
 	/// <summary>
 	/// Loads a manifest file into the resource manager. Note that this will not perform load on the assets themselves 
-	/// unless preloadAssets is set to true
+	/// unless preloadAssets is set to true, in which case they are loaded in the background (see GetAsync)
 	/// </summary>
 	/// <param name="path">The path to the JSON manifest file</param>
 	/// <param name="preloadAssets">True if all assets should be loaded into memory</param>
@@ -148,20 +373,107 @@ public:
 	static void Cleanup();
 
 protected:
+	// Identifies a loaded asset in the LRU list
+	struct ResidencyKey {
+		std::type_index Type;
+		Guid            Id;
+	};
+
+	// A loaded asset
+	struct ResourceEntry {
+		IResource::Sptr Resource;
+		// The asset's memory usage when it was last measured
+		size_t          Bytes = 0;
+		// True if the asset was loaded from the manifest, so we can reload it if it gets evicted
+		bool            Evictable = false;
+		// The asset's position in _lru
+		std::list<ResidencyKey>::iterator LruPosition;
+	};
+
+	// Totals for a resource type since startup
+	struct TypeStats {
+		std::string TypeName;
+		size_t      Loads = 0;
+		size_t      Evictions = 0;
+		size_t      Reloads = 0;
+	};
+
 	/// <summary>
 	/// This is a map of maps
 	/// The top level map uses type_index, so there's a map per resource type
 	/// The inner map handles mapping GUIDs to the corresponding resource
 	/// </summary>
-	static std::map<std::type_index, std::map<Guid, IResource::Sptr>> _resources;
+	static std::unordered_map<std::type_index, std::unordered_map<Guid, ResourceEntry>> _resources;
+	/// <summary>
+	/// Every loaded asset, from most to least recently used
+	/// </summary>
+	static std::list<ResidencyKey> _lru;
+	static std::unordered_map<std::type_index, TypeStats> _typeStats;
+	/// <summary>
+	/// The assets that have been evicted, so we can count how often we reload them
+	/// </summary>
+	static std::unordered_set<Guid> _evicted;
+	static size_t _memoryBudget;
+
 	/// <summary>
 	/// This map stores registered types, so we can load them from JSON files
 	/// </summary>
-	static std::map<std::string, std::function<Guid(const nlohmann::json&)>> _typeLoaders;
+	static std::unordered_map<std::string, std::function<Guid(const nlohmann::json&)>> _typeLoaders;
+	/// <summary>
+	/// The decode and upload halves of the loaders for types that can be decoded on the job system
+	/// </summary>
+	static std::unordered_map<std::string, std::function<std::shared_ptr<void>(const nlohmann::json&)>> _typeDecoders;
+	static std::unordered_map<std::string, std::function<Guid(const nlohmann::json&, const std::shared_ptr<void>&)>> _typeUploaders;
+
+	/// <summary>
+	/// Background loads that have not finished yet, by asset GUID
+	/// </summary>
+	static std::unordered_map<Guid, std::shared_ptr<LoadRequest>> _requests;
+	/// <summary>
+	/// Loads waiting for room in the upload queue
+	/// </summary>
+	static std::deque<std::shared_ptr<LoadRequest>> _pendingRequests;
+	/// <summary>
+	/// Loads that have been dispatched, in the order they were requested. This is bounded by
+	/// _maxLoadsInFlight, so decoded data can't pile up faster than we upload it
+	/// </summary>
+	static std::deque<std::shared_ptr<LoadRequest>> _uploadQueue;
+	static uint32_t _maxLoadsInFlight;
 
 	/// <summary>
 	/// We use an ORDERED JSON file to allow serializing types in the order they are registered.
 	/// This allows us to register dependencies before the dependent resource
 	/// </summary>
 	static nlohmann::ordered_json _manifest;
+
+	/// <summary>
+	/// Adds a newly loaded or created asset to the resource pool, as the most recently used asset
+	/// </summary>
+	static void _Track(std::type_index type, const IResource::Sptr& resource, bool evictable);
+	/// <summary>
+	/// Finds a loaded asset and marks it as the most recently used, or returns nullptr if it isn't loaded
+	/// </summary>
+	static IResource::Sptr _Find(std::type_index type, Guid id);
+
+	/// <summary>
+	/// Queues a background load for the given manifest entry, or returns the existing load for it
+	/// </summary>
+	static std::shared_ptr<LoadRequest> _Submit(const std::string& typeName, Guid id, const nlohmann::json& data);
+	/// <summary>
+	/// Starts decoding queued loads until the upload queue is full
+	/// </summary>
+	static void _DispatchPending();
+	/// <summary>
+	/// Starts decoding a single load on the job system
+	/// </summary>
+	static void _Dispatch(const std::shared_ptr<LoadRequest>& request);
+	/// <summary>
+	/// Waits for a load to finish decoding, then creates the asset on the calling (main) thread. If decoding
+	/// or creating the asset fails, the error is logged and the load is marked as failed
+	/// </summary>
+	static void _Complete(const std::shared_ptr<LoadRequest>& request);
+	/// <summary>
+	/// Gets the file that an asset's manifest entry loads from, for error messages. Empty if there is none
+	/// </summary>
+	static std::string _GetSourcePath(const nlohmann::json& data);
 };
\ No newline at end of file
@@ -0,0 +1,617 @@
+#include "Utils/TextureCompressor.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <Logging.h>
+
+#include "Utils/JobSystem.h"
+
+namespace {
+	// The interpolation weights for BC7's 4 bit indices, out of 64
+	constexpr int BC7_WEIGHTS[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+	// The interpolation weights for BC7's 2 bit indices, out of 64
+	constexpr int BC7_WEIGHTS_2BIT[4] = { 0, 21, 43, 64 };
+	// The position of each BC1 index along the line from color 0 to color 1
+	constexpr float BC1_POSITIONS[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+
+	// Expands 5 and 6 bit channels to 8 bits the same way the hardware does
+	inline int Expand5(int value) { return (value << 3) | (value >> 2); }
+	inline int Expand6(int value) { return (value << 2) | (value >> 4); }
+
+	inline int QuantizeChannel(float value, int maxValue) {
+		return std::clamp((int)std::lround(value * maxValue / 255.0f), 0, maxValue);
+	}
+
+	inline uint16_t PackColor565(const float* color) {
+		return (uint16_t)((QuantizeChannel(color[0], 31) << 11) | (QuantizeChannel(color[1], 63) << 5) | QuantizeChannel(color[2], 31));
+	}
+
+	inline void UnpackColor565(uint16_t color, int* result) {
+		result[0] = Expand5((color >> 11) & 31);
+		result[1] = Expand6((color >> 5) & 63);
+		result[2] = Expand5(color & 31);
+	}
+
+	/// <summary>
+	/// Finds the mean of a block and the axis that its points are most spread out along, using a
+	/// few rounds of power iteration on the covariance matrix. The axis is all zeros for flat blocks
+	/// </summary>
+	template <int N>
+	void FitPrincipalAxis(const float points[16][N], float* mean, float* axis) {
+		for (int c = 0; c < N; c++) {
+			mean[c] = 0.0f;
+			for (int ix = 0; ix < 16; ix++) {
+				mean[c] += points[ix][c];
+			}
+			mean[c] /= 16.0f;
+		}
+
+		float covariance[N][N] = { };
+		for (int ix = 0; ix < 16; ix++) {
+			for (int a = 0; a < N; a++) {
+				for (int b = 0; b < N; b++) {
+					covariance[a][b] += (points[ix][a] - mean[a]) * (points[ix][b] - mean[b]);
+				}
+			}
+		}
+
+		// Start from the variance of each channel, which is never orthogonal to the real axis for natural images
+		for (int c = 0; c < N; c++) {
+			axis[c] = covariance[c][c];
+		}
+		for (int iteration = 0; iteration < 8; iteration++) {
+			float next[N] = { };
+			float length = 0.0f;
+			for (int a = 0; a < N; a++) {
+				for (int b = 0; b < N; b++) {
+					next[a] += covariance[a][b] * axis[b];
+				}
+				length += next[a] * next[a];
+			}
+			if (length < 1e-8f) {
+				break;
+			}
+			length = 1.0f / std::sqrt(length);
+			for (int c = 0; c < N; c++) {
+				axis[c] = next[c] * length;
+			}
+		}
+
+		// Normalize in case we bailed out early
+		float length = 0.0f;
+		for (int c = 0; c < N; c++) {
+			length += axis[c] * axis[c];
+		}
+		float scale = length > 1e-8f ? 1.0f / std::sqrt(length) : 0.0f;
+		for (int c = 0; c < N; c++) {
+			axis[c] *= scale;
+		}
+	}
+
+	/// <summary>
+	/// Projects a block onto its principal axis and returns the two extreme points
+	/// </summary>
+	template <int N>
+	void FitEndpoints(const float points[16][N], float endpoints[2][N]) {
+		float mean[N], axis[N];
+		FitPrincipalAxis<N>(points, mean, axis);
+
+		float minT = 0.0f, maxT = 0.0f;
+		for (int ix = 0; ix < 16; ix++) {
+			float t = 0.0f;
+			for (int c = 0; c < N; c++) {
+				t += (points[ix][c] - mean[c]) * axis[c];
+			}
+			minT = std::min(minT, t);
+			maxT = std::max(maxT, t);
+		}
+		for (int c = 0; c < N; c++) {
+			endpoints[0][c] = std::clamp(mean[c] + axis[c] * minT, 0.0f, 255.0f);
+			endpoints[1][c] = std::clamp(mean[c] + axis[c] * maxT, 0.0f, 255.0f);
+		}
+	}
+
+	/// <summary>
+	/// Solves for the endpoints that best reproduce a block given the position of each pixel along
+	/// the line between them. Returns false if every pixel sits at the same position
+	/// </summary>
+	template <int N>
+	bool SolveEndpoints(const float points[16][N], const float positions[16], float endpoints[2][N]) {
+		float aa = 0.0f, bb = 0.0f, ab = 0.0f;
+		float ax[N] = { }, bx[N] = { };
+		for (int ix = 0; ix < 16; ix++) {
+			float b = positions[ix];
+			float a = 1.0f - b;
+			aa += a * a;
+			bb += b * b;
+			ab += a * b;
+			for (int c = 0; c < N; c++) {
+				ax[c] += a * points[ix][c];
+				bx[c] += b * points[ix][c];
+			}
+		}
+
+		float determinant = aa * bb - ab * ab;
+		if (std::abs(determinant) < 1e-6f) {
+			return false;
+		}
+		determinant = 1.0f / determinant;
+		for (int c = 0; c < N; c++) {
+			endpoints[0][c] = std::clamp((ax[c] * bb - bx[c] * ab) * determinant, 0.0f, 255.0f);
+			endpoints[1][c] = std::clamp((bx[c] * aa - ax[c] * ab) * determinant, 0.0f, 255.0f);
+		}
+		return true;
+	}
+
+	/// <summary>
+	/// Picks the closest palette entry for each pixel, returning the total squared error
+	/// </summary>
+	template <int N>
+	float FitPaletteIndices(const float points[16][N], const int palette[][N], int numEntries, uint8_t indices[16]) {
+		float error = 0.0f;
+		for (int ix = 0; ix < 16; ix++) {
+			float best = INFINITY;
+			for (int entry = 0; entry < numEntries; entry++) {
+				float distance = 0.0f;
+				for (int c = 0; c < N; c++) {
+					float delta = points[ix][c] - palette[entry][c];
+					distance += delta * delta;
+				}
+				if (distance < best) {
+					best = distance;
+					indices[ix] = (uint8_t)entry;
+				}
+			}
+			error += best;
+		}
+		return error;
+	}
+
+	/// <summary>
+	/// Picks the closest BC1 palette entry for each pixel, returning the total squared error
+	/// </summary>
+	float FitColorIndices(const float points[16][3], uint16_t color0, uint16_t color1, uint8_t indices[16]) {
+		int palette[4][3];
+		UnpackColor565(color0, palette[0]);
+		UnpackColor565(color1, palette[1]);
+		for (int c = 0; c < 3; c++) {
+			palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+			palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+		}
+		return FitPaletteIndices<3>(points, palette, 4, indices);
+	}
+
+	/// <summary>
+	/// Builds a BC7 palette by interpolating between two 8 bit endpoints with the given weights
+	/// </summary>
+	template <int N>
+	void BuildBC7Palette(const int endpoints[2][N], const int* weights, int numEntries, int palette[][N]) {
+		for (int entry = 0; entry < numEntries; entry++) {
+			for (int c = 0; c < N; c++) {
+				palette[entry][c] = ((64 - weights[entry]) * endpoints[0][c] + weights[entry] * endpoints[1][c] + 32) >> 6;
+			}
+		}
+	}
+
+	/// <summary>
+	/// Quantizes an endpoint to BC7 mode 6's 7 bits per channel plus a shared p-bit, picking whichever p-bit is closer
+	/// </summary>
+	void QuantizeBC7Endpoint(const float* endpoint, int* quantized, int& pBit) {
+		float bestError = INFINITY;
+		for (int bit = 0; bit < 2; bit++) {
+			int values[4];
+			float error = 0.0f;
+			for (int c = 0; c < 4; c++) {
+				values[c] = std::clamp((int)std::lround((endpoint[c] - bit) / 2.0f), 0, 127);
+				float delta = endpoint[c] - ((values[c] << 1) | bit);
+				error += delta * delta;
+			}
+			if (error < bestError) {
+				bestError = error;
+				pBit = bit;
+				memcpy(quantized, values, sizeof(values));
+			}
+		}
+	}
+
+	/// <summary>
+	/// Picks the closest BC7 mode 6 palette entry for each pixel, returning the total squared error
+	/// </summary>
+	float FitBC7Indices(const float points[16][4], const int quantized[2][4], const int pBits[2], uint8_t indices[16]) {
+		int endpoints[2][4];
+		for (int c = 0; c < 4; c++) {
+			endpoints[0][c] = (quantized[0][c] << 1) | pBits[0];
+			endpoints[1][c] = (quantized[1][c] << 1) | pBits[1];
+		}
+		int palette[16][4];
+		BuildBC7Palette<4>(endpoints, BC7_WEIGHTS, 16, palette);
+		return FitPaletteIndices<4>(points, palette, 16, indices);
+	}
+
+	/// <summary>
+	/// Fits one half of a BC7 mode 5 block, which has 2 bit indices and stores its endpoints with the given number of bits
+	/// per channel. The color and alpha halves of the block are fit separately. Returns the total squared error
+	/// </summary>
+	template <int N>
+	float FitBC7Mode5Channels(const float points[16][N], int numBits, int quantized[2][N], uint8_t indices[16]) {
+		const int maxValue = (1 << numBits) - 1;
+		float endpoints[2][N];
+		FitEndpoints<N>(points, endpoints);
+
+		float error = INFINITY;
+		for (int iteration = 0; iteration < 3; iteration++) {
+			int candidate[2][N], expanded[2][N];
+			for (int e = 0; e < 2; e++) {
+				for (int c = 0; c < N; c++) {
+					candidate[e][c] = QuantizeChannel(endpoints[e][c], maxValue);
+					expanded[e][c] = (candidate[e][c] << (8 - numBits)) | (candidate[e][c] >> (2 * numBits - 8));
+				}
+			}
+			int palette[4][N];
+			uint8_t candidateIndices[16];
+			BuildBC7Palette<N>(expanded, BC7_WEIGHTS_2BIT, 4, palette);
+			float candidateError = FitPaletteIndices<N>(points, palette, 4, candidateIndices);
+			if (candidateError >= error) {
+				break;
+			}
+			error = candidateError;
+			memcpy(quantized, candidate, sizeof(candidate));
+			memcpy(indices, candidateIndices, 16);
+
+			// Refine the endpoints now that we know where each pixel lands
+			float positions[16];
+			for (int ix = 0; ix < 16; ix++) {
+				positions[ix] = BC7_WEIGHTS_2BIT[indices[ix]] / 64.0f;
+			}
+			if (error == 0.0f || !SolveEndpoints<N>(points, positions, endpoints)) {
+				break;
+			}
+		}
+
+		// The first index has an implied high bit of 0, so swap the endpoints if it would be set
+		if (indices[0] >= 2) {
+			std::swap(quantized[0], quantized[1]);
+			for (int ix = 0; ix < 16; ix++) {
+				indices[ix] = 3 - indices[ix];
+			}
+		}
+		return error;
+	}
+
+	/// <summary>
+	/// Writes values into a block least significant bit first, which is how BC7 blocks are laid out
+	/// </summary>
+	struct BitWriter {
+		uint8_t* Data;
+		uint32_t Position = 0;
+
+		void Write(uint32_t value, uint32_t numBits) {
+			for (uint32_t bit = 0; bit < numBits; bit++, Position++) {
+				if ((value >> bit) & 1) {
+					Data[Position >> 3] |= (uint8_t)(1 << (Position & 7));
+				}
+			}
+		}
+	};
+}
+
+size_t TextureCompressor::GetBlockSize(BlockCompression format) {
+	switch (format) {
+		case BlockCompression::BC1:
+		case BlockCompression::BC4:
+			return 8;
+		case BlockCompression::BC3:
+		case BlockCompression::BC5:
+		case BlockCompression::BC7:
+			return 16;
+		default:
+			return 0;
+	}
+}
+
+size_t TextureCompressor::GetCompressedSize(BlockCompression format, uint32_t width, uint32_t height) {
+	return (size_t)((width + 3) / 4) * ((height + 3) / 4) * GetBlockSize(format);
+}
+
+BlockCompression TextureCompressor::ResolveFormat(BlockCompression requested, int numChannels, const uint8_t* rgba, size_t numPixels) {
+	if (requested != BlockCompression::Auto) {
+		return requested;
+	}
+	switch (numChannels) {
+		case 1: return BlockCompression::BC4;
+		case 2: return BlockCompression::BC5;
+		case 3: return BlockCompression::BC1;
+		default:
+			for (size_t ix = 0; ix < numPixels; ix++) {
+				if (rgba[ix * 4 + 3] != 255) {
+					return BlockCompression::BC7;
+				}
+			}
+			return BlockCompression::BC1;
+	}
+}
+
+void TextureCompressor::Compress(const uint8_t* rgba, uint32_t width, uint32_t height, BlockCompression format, uint8_t* output) {
+	const size_t blockSize = GetBlockSize(format);
+	LOG_ASSERT(blockSize > 0, "Cannot compress to format {}", ~format);
+
+	const uint32_t blocksX = (width + 3) / 4;
+	const uint32_t blocksY = (height + 3) / 4;
+
+	// Each batch is a handful of rows of blocks, small mips end up as a single batch
+	JobSystem::ParallelFor(blocksY, std::max<size_t>(1, 256 / blocksX), [&](size_t begin, size_t end) {
+		uint8_t block[64];
+		for (size_t by = begin; by < end; by++) {
+			for (uint32_t bx = 0; bx < blocksX; bx++) {
+				// Gather the block, repeating the edge pixels for blocks that hang off the image
+				for (uint32_t y = 0; y < 4; y++) {
+					uint32_t sourceY = std::min<uint32_t>((uint32_t)by * 4 + y, height - 1);
+					for (uint32_t x = 0; x < 4; x++) {
+						uint32_t sourceX = std::min<uint32_t>(bx * 4 + x, width - 1);
+						memcpy(block + (y * 4 + x) * 4, rgba + ((size_t)sourceY * width + sourceX) * 4, 4);
+					}
+				}
+				EncodeBlock(block, format, output + (by * blocksX + bx) * blockSize);
+			}
+		}
+	});
+}
+
+std::vector<uint8_t> TextureCompressor::Downsample(const uint8_t* rgba, uint32_t width, uint32_t height) {
+	const uint32_t outWidth = std::max(1u, width / 2);
+	const uint32_t outHeight = std::max(1u, height / 2);
+	std::vector<uint8_t> result((size_t)outWidth * outHeight * 4);
+
+	for (uint32_t y = 0; y < outHeight; y++) {
+		const uint8_t* row0 = rgba + (size_t)std::min(y * 2, height - 1) * width * 4;
+		const uint8_t* row1 = rgba + (size_t)std::min(y * 2 + 1, height - 1) * width * 4;
+		for (uint32_t x = 0; x < outWidth; x++) {
+			uint32_t x0 = std::min(x * 2, width - 1) * 4;
+			uint32_t x1 = std::min(x * 2 + 1, width - 1) * 4;
+			uint8_t* out = result.data() + ((size_t)y * outWidth + x) * 4;
+			for (int c = 0; c < 4; c++) {
+				out[c] = (uint8_t)((row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c] + 2) / 4);
+			}
+		}
+	}
+
+	return result;
+}
+
+void TextureCompressor::EncodeBlock(const uint8_t* block, BlockCompression format, uint8_t* output) {
+	switch (format) {
+		case BlockCompression::BC1:
+			_EncodeColorBlock(block, output);
+			break;
+		case BlockCompression::BC3:
+			_EncodeSingleChannelBlock(block, 3, output);
+			_EncodeColorBlock(block, output + 8);
+			break;
+		case BlockCompression::BC4:
+			_EncodeSingleChannelBlock(block, 0, output);
+			break;
+		case BlockCompression::BC5:
+			_EncodeSingleChannelBlock(block, 0, output);
+			_EncodeSingleChannelBlock(block, 1, output + 8);
+			break;
+		case BlockCompression::BC7:
+			_EncodeBC7Block(block, output);
+			break;
+		default:
+			LOG_ASSERT(false, "Cannot encode a block in format {}", ~format);
+	}
+}
+
+void TextureCompressor::_EncodeColorBlock(const uint8_t* block, uint8_t* output) {
+	float points[16][3];
+	for (int ix = 0; ix < 16; ix++) {
+		for (int c = 0; c < 3; c++) {
+			points[ix][c] = block[ix * 4 + c];
+		}
+	}
+
+	float endpoints[2][3];
+	FitEndpoints<3>(points, endpoints);
+	uint16_t color0 = PackColor565(endpoints[1]);
+	uint16_t color1 = PackColor565(endpoints[0]);
+	uint8_t indices[16];
+	float error = FitColorIndices(points, color0, color1, indices);
+
+	// Refine the endpoints now that we know where each pixel lands, keeping whichever is better
+	for (int iteration = 0; iteration < 2 && error > 0.0f; iteration++) {
+		float positions[16];
+		for (int ix = 0; ix < 16; ix++) {
+			positions[ix] = BC1_POSITIONS[indices[ix]];
+		}
+		if (!SolveEndpoints<3>(points, positions, endpoints)) {
+			break;
+		}
+		uint16_t refined0 = PackColor565(endpoints[0]);
+		uint16_t refined1 = PackColor565(endpoints[1]);
+		uint8_t refinedIndices[16];
+		float refinedError = FitColorIndices(points, refined0, refined1, refinedIndices);
+		if (refinedError >= error) {
+			break;
+		}
+		color0 = refined0;
+		color1 = refined1;
+		error = refinedError;
+		memcpy(indices, refinedIndices, sizeof(indices));
+	}
+
+	// The first color must be larger to select the 4 color mode, swapping the colors means swapping index 0 with 1 and 2 with 3
+	uint8_t flip = 0;
+	if (color0 < color1) {
+		std::swap(color0, color1);
+		flip = 1;
+	}
+	uint32_t packedIndices = 0;
+	if (color0 != color1) {
+		for (int ix = 0; ix < 16; ix++) {
+			packedIndices |= (uint32_t)(indices[ix] ^ flip) << (ix * 2);
+		}
+	}
+
+	output[0] = (uint8_t)(color0 & 0xFF);
+	output[1] = (uint8_t)(color0 >> 8);
+	output[2] = (uint8_t)(color1 & 0xFF);
+	output[3] = (uint8_t)(color1 >> 8);
+	for (int ix = 0; ix < 4; ix++) {
+		output[4 + ix] = (uint8_t)(packedIndices >> (ix * 8));
+	}
+}
+
+void TextureCompressor::_EncodeSingleChannelBlock(const uint8_t* block, int channel, uint8_t* output) {
+	int minValue = 255, maxValue = 0;
+	for (int ix = 0; ix < 16; ix++) {
+		minValue = std::min<int>(minValue, block[ix * 4 + channel]);
+		maxValue = std::max<int>(maxValue, block[ix * 4 + channel]);
+	}
+
+	// Putting the larger value first selects the mode with 6 interpolated values instead of 4
+	output[0] = (uint8_t)maxValue;
+	output[1] = (uint8_t)minValue;
+
+	uint64_t packedIndices = 0;
+	if (maxValue > minValue) {
+		int palette[8] = { maxValue, minValue };
+		for (int ix = 1; ix < 7; ix++) {
+			palette[ix + 1] = ((7 - ix) * maxValue + ix * minValue) / 7;
+		}
+		for (int ix = 0; ix < 16; ix++) {
+			int value = block[ix * 4 + channel];
+			uint64_t bestIndex = 0;
+			int best = 256;
+			for (int entry = 0; entry < 8; entry++) {
+				int distance = std::abs(value - palette[entry]);
+				if (distance < best) {
+					best = distance;
+					bestIndex = entry;
+				}
+			}
+			packedIndices |= bestIndex << (ix * 3);
+		}
+	}
+
+	for (int ix = 0; ix < 6; ix++) {
+		output[2 + ix] = (uint8_t)(packedIndices >> (ix * 8));
+	}
+}
+
+void TextureCompressor::_EncodeBC7Block(const uint8_t* block, uint8_t* output) {
+	float points[16][4];
+	bool isOpaque = true;
+	for (int ix = 0; ix < 16; ix++) {
+		for (int c = 0; c < 4; c++) {
+			points[ix][c] = block[ix * 4 + c];
+		}
+		isOpaque &= block[ix * 4 + 3] == 255;
+	}
+
+	float error = _EncodeBC7Mode6(points, output);
+
+	// Mode 6 puts color and alpha on the same line, which falls apart when alpha does not follow the
+	// color (ex: the edges of sprites), so blocks with alpha also try mode 5, which fits them separately
+	if (!isOpaque && error > 0.0f) {
+		uint8_t candidate[16];
+		if (_EncodeBC7Mode5(points, candidate) < error) {
+			memcpy(output, candidate, sizeof(candidate));
+		}
+	}
+}
+
+float TextureCompressor::_EncodeBC7Mode6(const float points[16][4], uint8_t* output) {
+	float endpoints[2][4];
+	FitEndpoints<4>(points, endpoints);
+	int quantized[2][4], pBits[2];
+	QuantizeBC7Endpoint(endpoints[0], quantized[0], pBits[0]);
+	QuantizeBC7Endpoint(endpoints[1], quantized[1], pBits[1]);
+	uint8_t indices[16];
+	float error = FitBC7Indices(points, quantized, pBits, indices);
+
+	// Refine the endpoints now that we know where each pixel lands, keeping whichever is better
+	for (int iteration = 0; iteration < 2 && error > 0.0f; iteration++) {
+		float positions[16];
+		for (int ix = 0; ix < 16; ix++) {
+			positions[ix] = BC7_WEIGHTS[indices[ix]] / 64.0f;
+		}
+		if (!SolveEndpoints<4>(points, positions, endpoints)) {
+			break;
+		}
+		int refined[2][4], refinedBits[2];
+		QuantizeBC7Endpoint(endpoints[0], refined[0], refinedBits[0]);
+		QuantizeBC7Endpoint(endpoints[1], refined[1], refinedBits[1]);
+		uint8_t refinedIndices[16];
+		float refinedError = FitBC7Indices(points, refined, refinedBits, refinedIndices);
+		if (refinedError >= error) {
+			break;
+		}
+		memcpy(quantized, refined, sizeof(quantized));
+		memcpy(pBits, refinedBits, sizeof(pBits));
+		memcpy(indices, refinedIndices, sizeof(indices));
+		error = refinedError;
+	}
+
+	// The first index has an implied high bit of 0, so swap the endpoints if it would be set
+	if (indices[0] >= 8) {
+		std::swap(quantized[0], quantized[1]);
+		std::swap(pBits[0], pBits[1]);
+		for (int ix = 0; ix < 16; ix++) {
+			indices[ix] = 15 - indices[ix];
+		}
+	}
+
+	memset(output, 0, 16);
+	BitWriter writer = BitWriter{ output };
+	// Mode 6 is encoded as six zero bits followed by a one
+	writer.Write(1 << 6, 7);
+	for (int c = 0; c < 4; c++) {
+		writer.Write(quantized[0][c], 7);
+		writer.Write(quantized[1][c], 7);
+	}
+	writer.Write(pBits[0], 1);
+	writer.Write(pBits[1], 1);
+	writer.Write(indices[0], 3);
+	for (int ix = 1; ix < 16; ix++) {
+		writer.Write(indices[ix], 4);
+	}
+
+	return error;
+}
+
+float TextureCompressor::_EncodeBC7Mode5(const float points[16][4], uint8_t* output) {
+	float colors[16][3], alphas[16][1];
+	for (int ix = 0; ix < 16; ix++) {
+		memcpy(colors[ix], points[ix], sizeof(colors[ix]));
+		alphas[ix][0] = points[ix][3];
+	}
+
+	// Colors are stored with 7 bits per channel and alpha with 8, each with their own 2 bit indices
+	int colorEndpoints[2][3], alphaEndpoints[2][1];
+	uint8_t colorIndices[16], alphaIndices[16];
+	float error = FitBC7Mode5Channels<3>(colors, 7, colorEndpoints, colorIndices);
+	error += FitBC7Mode5Channels<1>(alphas, 8, alphaEndpoints, alphaIndices);
+
+	memset(output, 0, 16);
+	BitWriter writer = BitWriter{ output };
+	// Mode 5 is encoded as five zero bits followed by a one, then the channel rotation (which we don't use)
+	writer.Write(1 << 5, 6);
+	writer.Write(0, 2);
+	for (int c = 0; c < 3; c++) {
+		writer.Write(colorEndpoints[0][c], 7);
+		writer.Write(colorEndpoints[1][c], 7);
+	}
+	writer.Write(alphaEndpoints[0][0], 8);
+	writer.Write(alphaEndpoints[1][0], 8);
+	writer.Write(colorIndices[0], 1);
+	for (int ix = 1; ix < 16; ix++) {
+		writer.Write(colorIndices[ix], 2);
+	}
+	writer.Write(alphaIndices[0], 1);
+	for (int ix = 1; ix < 16; ix++) {
+		writer.Write(alphaIndices[ix], 2);
+	}
+
+	return error;
+}
@@ -0,0 +1,89 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <EnumToString.h>
+
+/// <summary>
+/// The block compressed formats that we can encode textures to
+/// </summary>
+ENUM(BlockCompression, uint32_t,
+	// Textures are uploaded uncompressed
+	None = 0,
+	// RGB at 4 bits per texel, alpha is dropped
+	BC1  = 1,
+	// RGBA at 8 bits per texel, alpha is stored as a BC4 block
+	BC3  = 3,
+	// A single channel (red) at 4 bits per texel
+	BC4  = 4,
+	// Two channels (red and green) at 8 bits per texel, good for normal maps
+	BC5  = 5,
+	// RGBA at 8 bits per texel, with much better quality than BC1 or BC3
+	BC7  = 7,
+	// Picks BC1 for opaque images and BC7 for images with alpha
+	Auto = 255
+);
+
+/// <summary>
+/// Encodes RGBA8 images into GPU block compressed formats on the CPU. Images are split into 4x4
+/// blocks, and blocks are encoded in parallel on the job system
+///
+/// BC1, BC3 and BC4/BC5 endpoints are fit along the principal axis of each block, then refined
+/// with a least squares pass. BC7 blocks are all encoded with mode 6 (a single RGBA subset with
+/// 16 weights), which is the most generally useful mode and keeps the encoder fast
+/// </summary>
+class TextureCompressor {
+public:
+	TextureCompressor() = delete;
+
+	/// <summary>
+	/// Gets the number of bytes in a single 4x4 block of the given format, or 0 if the format is not compressed
+	/// </summary>
+	static size_t GetBlockSize(BlockCompression format);
+	/// <summary>
+	/// Gets the number of bytes needed to store an image of the given size in the given format
+	/// </summary>
+	static size_t GetCompressedSize(BlockCompression format, uint32_t width, uint32_t height);
+
+	/// <summary>
+	/// Picks a concrete format for an image when the requested format is Auto, otherwise returns the requested format.
+	/// Auto keeps the same channels that an uncompressed texture would have, so 1 and 2 channel images use BC4 and BC5,
+	/// and RGBA images only pay for BC7 if they actually use their alpha channel
+	/// </summary>
+	/// <param name="requested">The format that was requested</param>
+	/// <param name="numChannels">The number of channels the texture would have if it was not compressed</param>
+	/// <param name="rgba">The RGBA8 pixels of the image</param>
+	/// <param name="numPixels">The number of pixels in the image</param>
+	static BlockCompression ResolveFormat(BlockCompression requested, int numChannels, const uint8_t* rgba, size_t numPixels);
+
+	/// <summary>
+	/// Compresses an RGBA8 image. Blocks that hang off the edge of the image repeat the edge pixels
+	/// </summary>
+	/// <param name="rgba">The pixels to compress, tightly packed</param>
+	/// <param name="width">The width of the image in pixels</param>
+	/// <param name="height">The height of the image in pixels</param>
+	/// <param name="format">The format to compress to, must not be None or Auto</param>
+	/// <param name="output">The output buffer, must be at least GetCompressedSize bytes</param>
+	static void Compress(const uint8_t* rgba, uint32_t width, uint32_t height, BlockCompression format, uint8_t* output);
+
+	/// <summary>
+	/// Creates the next level of a mip chain from an RGBA8 image using a box filter
+	/// </summary>
+	/// <param name="rgba">The pixels of the source level</param>
+	/// <param name="width">The width of the source level, the result will be max(1, width / 2) wide</param>
+	/// <param name="height">The height of the source level, the result will be max(1, height / 2) tall</param>
+	static std::vector<uint8_t> Downsample(const uint8_t* rgba, uint32_t width, uint32_t height);
+
+	/// <summary>
+	/// Encodes a single 4x4 block, the block is 16 RGBA8 pixels in row order
+	/// </summary>
+	static void EncodeBlock(const uint8_t* block, BlockCompression format, uint8_t* output);
+
+protected:
+	static void _EncodeColorBlock(const uint8_t* block, uint8_t* output);
+	static void _EncodeSingleChannelBlock(const uint8_t* block, int channel, uint8_t* output);
+	static void _EncodeBC7Block(const uint8_t* block, uint8_t* output);
+	// Both of these return the squared error of the encoded block
+	static float _EncodeBC7Mode6(const float points[16][4], uint8_t* output);
+	static float _EncodeBC7Mode5(const float points[16][4], uint8_t* output);
+};
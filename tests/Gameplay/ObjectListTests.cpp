@@ -0,0 +1,129 @@
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Gameplay/ObjectList.h"
+
+#include "TestFramework.h"
+
+using namespace Gameplay;
+
+namespace {
+	// Stands in for GameObject, which needs a scene and physics
+	struct TestObject {
+		Guid        Id = Guid::New();
+		std::string Name;
+
+		Guid GetGUID() const { return Id; }
+		const std::string& GetName() const { return Name; }
+	};
+	typedef std::shared_ptr<TestObject> TestObjectPtr;
+
+	TestObjectPtr MakeObject(ObjectList<TestObject>& list, const std::string& name) {
+		TestObjectPtr result = std::make_shared<TestObject>();
+		result->Name = name;
+		list.Add(result);
+		return result;
+	}
+
+	// Checks the list against the expected order, and that every object can be found again
+	void CheckOrder(const ObjectList<TestObject>& list, const std::vector<TestObjectPtr>& expected) {
+		REQUIRE(list.Size() == expected.size());
+		for (size_t ix = 0; ix < expected.size(); ix++) {
+			CHECK(list[ix] == expected[ix]);
+			CHECK_EQ(list.IndexOf(expected[ix].get()), ix);
+			CHECK(list.FindByGuid(expected[ix]->Id) == expected[ix]);
+		}
+	}
+}
+
+TEST_CASE(ObjectList_RemoveKeepsOrder) {
+	ObjectList<TestObject> list;
+	std::vector<TestObjectPtr> objects;
+	for (int ix = 0; ix < 10; ix++) {
+		objects.push_back(MakeObject(list, "Object " + std::to_string(ix)));
+	}
+
+	// Removed out of order, with duplicates and an object that was never added
+	std::vector<TestObject*> removed;
+	TestObjectPtr stranger = std::make_shared<TestObject>();
+	size_t count = list.Remove({ objects[7], objects[2], stranger, objects[7], objects[3], nullptr }, [&](TestObject& object) {
+		removed.push_back(&object);
+	});
+	CHECK_EQ(count, 3u);
+	REQUIRE(removed.size() == 3u);
+	CHECK(removed[0] == objects[2].get());
+	CHECK(removed[1] == objects[3].get());
+	CHECK(removed[2] == objects[7].get());
+
+	CheckOrder(list, { objects[0], objects[1], objects[4], objects[5], objects[6], objects[8], objects[9] });
+	CHECK(list.FindByGuid(objects[2]->Id) == nullptr);
+	CHECK(list.FindByName("Object 3") == nullptr);
+	CHECK(list.FindByName("Object 9") == objects[9]);
+	CHECK_EQ(list.IndexOf(objects[7].get()), ObjectList<TestObject>::NOT_FOUND);
+
+	// Removing the first and last objects
+	CHECK_EQ(list.Remove({ objects[9], objects[0] }, [](TestObject&) { }), 2u);
+	CheckOrder(list, { objects[1], objects[4], objects[5], objects[6], objects[8] });
+	CHECK_EQ(list.Remove({ objects[0] }, [](TestObject&) { }), 0u);
+}
+
+TEST_CASE(ObjectList_FindsFirstAddedName) {
+	ObjectList<TestObject> list;
+	TestObjectPtr first = MakeObject(list, "Player");
+	TestObjectPtr other = MakeObject(list, "Enemy");
+	TestObjectPtr second = MakeObject(list, "Player");
+	TestObjectPtr third = MakeObject(list, "Player");
+	CHECK(list.FindByName("Player") == first);
+
+	// Removing the first falls back to the next one added, no matter how many objects move
+	list.Remove({ first }, [](TestObject&) { });
+	CHECK(list.FindByName("Player") == second);
+
+	// An object renamed to a name that's in use goes by when it was added, not when it was renamed
+	other->Name = "Player";
+	list.OnRenamed(other.get(), "Enemy");
+	CHECK(list.FindByName("Player") == other);
+	CHECK(list.FindByName("Enemy") == nullptr);
+
+	other->Name = "Enemy";
+	list.OnRenamed(other.get(), "Player");
+	CHECK(list.FindByName("Player") == second);
+	CHECK(list.FindByName("Enemy") == other);
+
+	list.Remove({ second, other }, [](TestObject&) { });
+	CHECK(list.FindByName("Player") == third);
+	CHECK(list.FindByName("Enemy") == nullptr);
+
+	// Renaming an object that isn't in the list doesn't add it
+	TestObjectPtr stranger = std::make_shared<TestObject>();
+	stranger->Name = "Player";
+	list.OnRenamed(stranger.get(), "Someone");
+	CHECK(list.FindByName("Player") == third);
+	CHECK(list.FindByName("Someone") == nullptr);
+}
+
+TEST_CASE(ObjectList_FindsFirstAddedGuid) {
+	ObjectList<TestObject> list;
+	TestObjectPtr first = MakeObject(list, "A");
+	TestObjectPtr filler = MakeObject(list, "B");
+	TestObjectPtr copy = std::make_shared<TestObject>();
+	copy->Id = first->Id;
+	copy->Name = "C";
+	list.Add(copy);
+
+	// Both copies stay reachable by position, but lookups always find the first
+	CHECK(list.FindByGuid(first->Id) == first);
+	CHECK_EQ(list.IndexOf(copy.get()), 2u);
+	list.Remove({ filler }, [](TestObject&) { });
+	CHECK(list.FindByGuid(first->Id) == first);
+	CHECK_EQ(list.IndexOf(copy.get()), 1u);
+	list.Remove({ first }, [](TestObject&) { });
+	CHECK(list.FindByGuid(copy->Id) == copy);
+	CHECK_EQ(list.IndexOf(copy.get()), 0u);
+
+	list.Clear();
+	CHECK(list.Empty());
+	CHECK(list.FindByGuid(copy->Id) == nullptr);
+	CHECK(list.FindByName("C") == nullptr);
+}
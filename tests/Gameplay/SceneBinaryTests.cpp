@@ -0,0 +1,164 @@
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "Gameplay/SceneBinary.h"
+
+#include "TestFramework.h"
+
+using namespace Gameplay;
+
+namespace {
+	nlohmann::json Vec(float x, float y, float z) {
+		return { { "x", x }, { "y", y }, { "z", z } };
+	}
+	nlohmann::json Quat(float x, float y, float z, float w) {
+		return { { "x", x }, { "y", y }, { "z", z }, { "w", w } };
+	}
+
+	// Builds an object the same way GameObject::ToJson does, children are filled in by the caller
+	nlohmann::json MakeObject(const std::string& name, const Guid& guid, const Guid& parent, const nlohmann::json& components) {
+		nlohmann::json result;
+		result["name"] = name;
+		result["guid"] = guid.str();
+		result["parent"] = parent.isValid() ? parent.str() : "null";
+		result["position"] = Vec(1.5f, -2.0f, 0.1f);
+		result["rotation"] = Quat(0.0f, 0.7071068f, 0.0f, 0.7071068f);
+		result["scale"] = Vec(1.0f, 2.0f, 0.5f);
+		result["hide_in_inspector"] = false;
+		result["components"] = components;
+		result["children"] = std::vector<nlohmann::json>();
+		return result;
+	}
+
+	// A scene in the layout that Scene::ToJson writes and Scene::FromJson reads, with a nested hierarchy,
+	// components, invalid GUIDs and a top level key that the binary format doesn't have a field for
+	nlohmann::json MakeScene() {
+		Guid cameraGuid = Guid::New();
+		Guid rootGuid = Guid::New();
+		Guid childGuid = Guid::New();
+		Guid grandchildGuid = Guid::New();
+
+		nlohmann::json camera = MakeObject("Main Camera", Guid::New(), Guid(), {
+			{ "Gameplay::Camera", {
+				{ "guid", cameraGuid.str() }, { "enabled", true },
+				{ "fov_radians", 1.5707963705062866 }, { "near_plane", 0.1f }, { "far_plane", 1000.0f },
+				{ "ortho_enabled", false }, { "clear_color", Quat(0.1f, 0.2f, 0.3f, 1.0f) }
+			} },
+			{ "SimpleCameraControl", {
+				{ "guid", Guid::New().str() }, { "enabled", false },
+				{ "mouse_sensitivity", { { "x", 0.5f }, { "y", 0.3f } } }
+			} }
+		});
+		nlohmann::json grandchild = MakeObject("Grandchild", grandchildGuid, childGuid, nlohmann::json());
+		grandchild["hide_in_inspector"] = true;
+		nlohmann::json child = MakeObject("Child", childGuid, rootGuid, {
+			{ "Gameplay::Physics::RigidBody", { { "guid", Guid::New().str() }, { "enabled", true }, { "mass", 2.5f }, { "colliders", { 1, 2, 3 } } } }
+		});
+		nlohmann::json root = MakeObject("Root", rootGuid, Guid(), {
+			{ "RenderComponent", { { "guid", Guid::New().str() }, { "enabled", true }, { "mesh", Guid::New().str() }, { "material", "null" } } }
+		});
+		// Another object sharing the root's name, strings are de-duplicated in the file
+		nlohmann::json sibling = MakeObject("Root", Guid::New(), rootGuid, nlohmann::json());
+
+		child["children"].push_back(grandchild);
+		root["children"].push_back(child);
+		root["children"].push_back(sibling);
+
+		nlohmann::json scene;
+		scene["default_material"] = "null";
+		scene["main_camera"] = cameraGuid.str();
+		scene["ambient"] = Vec(0.1f, 0.1f, 0.1f);
+		scene["skybox"] = {
+			{ "mesh", Guid::New().str() }, { "shader", Guid::New().str() }, { "texture", "null" },
+			{ "orientation", Quat(0.0f, 0.0f, 0.0f, 1.0f) }
+		};
+		scene["lights"] = { { { "color", Vec(1.0f, 0.2f, 0.1f) }, { "position", Vec(0.0f, 1.0f, 3.0f) }, { "range", 4.0f } } };
+		// Objects are listed flat in the order they were added to the scene, with children nested as copies
+		scene["objects"] = { camera, root, child, grandchild, sibling };
+		return scene;
+	}
+
+	std::string TempPath(const std::string& name) {
+		return (std::filesystem::temp_directory_path() / name).string();
+	}
+}
+
+TEST_CASE(SceneBinary_RoundTripMatchesJson) {
+	nlohmann::json scene = MakeScene();
+	std::string path = TempPath("scene-binary-test.bscene");
+	SceneBinary::Write(scene, path);
+	CHECK(SceneBinary::IsBinaryFile(path));
+
+	SceneBinary::Reader reader;
+	REQUIRE(reader.Open(path));
+	CHECK_EQ(reader.GetNumObjects(), 5u);
+
+	// The JSON loader should see exactly what it would have read from the original scene
+	nlohmann::json result = SceneBinary::ToJson(reader);
+	CHECK(result == scene);
+	if (result != scene) {
+		printf("    expected: %s\n    got:      %s\n", scene.dump().c_str(), result.dump().c_str());
+	}
+	std::filesystem::remove(path);
+}
+
+TEST_CASE(SceneBinary_ConvertsFilesBothWays) {
+	nlohmann::json scene = MakeScene();
+	std::string jsonPath = TempPath("scene-binary-test.json");
+	std::string binaryPath = TempPath("scene-binary-test.bscene");
+	std::string backPath = TempPath("scene-binary-test-back.json");
+	std::ofstream(jsonPath) << scene.dump(1, '\t');
+
+	SceneBinary::ConvertJsonToBinary(jsonPath, binaryPath);
+	CHECK(SceneBinary::IsBinaryFile(binaryPath));
+	CHECK(!SceneBinary::IsBinaryFile(jsonPath));
+	SceneBinary::ConvertBinaryToJson(binaryPath, backPath);
+
+	std::ifstream back(backPath);
+	CHECK(nlohmann::json::parse(back) == scene);
+
+	std::filesystem::remove(jsonPath);
+	std::filesystem::remove(binaryPath);
+	std::filesystem::remove(backPath);
+}
+
+TEST_CASE(SceneBinary_RejectsDamagedFiles) {
+	std::string path = TempPath("scene-binary-test.bscene");
+	SceneBinary::Write(MakeScene(), path);
+	std::vector<char> bytes;
+	{
+		std::ifstream file(path, std::ios::binary);
+		bytes.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	}
+	REQUIRE(bytes.size() > sizeof(SceneBinary::BinaryHeader));
+
+	auto writeAndOpen = [&](const std::vector<char>& data) {
+		{
+			std::ofstream file(path, std::ios::binary | std::ios::trunc);
+			file.write(data.data(), data.size());
+		}
+		SceneBinary::Reader reader;
+		return reader.Open(path);
+	};
+	CHECK(writeAndOpen(bytes));
+
+	// Truncated anywhere, in the header or in the body
+	CHECK(!writeAndOpen(std::vector<char>(bytes.begin(), bytes.begin() + sizeof(SceneBinary::BinaryHeader) / 2)));
+	CHECK(!writeAndOpen(std::vector<char>(bytes.begin(), bytes.end() - 1)));
+
+	// A flipped byte in the body fails the checksum
+	std::vector<char> corrupted = bytes;
+	corrupted[corrupted.size() - 3] ^= 0x5A;
+	CHECK(!writeAndOpen(corrupted));
+
+	// Not a scene at all
+	std::vector<char> wrongMagic = bytes;
+	wrongMagic[0] = '{';
+	CHECK(!writeAndOpen(wrongMagic));
+
+	std::filesystem::remove(path);
+}
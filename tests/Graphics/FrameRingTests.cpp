@@ -0,0 +1,150 @@
+#include <cstdint>
+#include <random>
+#include <set>
+#include <vector>
+
+#include "Graphics/Buffers/FrameRing.h"
+
+#include "TestFramework.h"
+
+namespace {
+	// Pretends to be the GPU: a fence stays pending until someone waits on it, and every call is checked
+	// for use after delete and double deletes
+	class MockFenceBackend : public FrameRing::IFenceBackend {
+	public:
+		std::set<uintptr_t> LiveFences;
+		std::set<uintptr_t> SignalledFences;
+		uintptr_t           NextFence = 1;
+		uint32_t            Inserted = 0;
+		uint32_t            Waits = 0;
+		uint32_t            Deleted = 0;
+		uint32_t            Errors = 0;
+		bool                FailWaits = false;
+
+		void* InsertFence() override {
+			Inserted++;
+			LiveFences.insert(NextFence);
+			return reinterpret_cast<void*>(NextFence++);
+		}
+		bool WaitFence(void* fence) override {
+			Waits++;
+			uintptr_t id = reinterpret_cast<uintptr_t>(fence);
+			Errors += LiveFences.count(id) == 0 ? 1 : 0;
+			SignalledFences.insert(id);
+			return !FailWaits;
+		}
+		void DeleteFence(void* fence) override {
+			Deleted++;
+			Errors += LiveFences.erase(reinterpret_cast<uintptr_t>(fence)) == 1 ? 0 : 1;
+		}
+		bool IsSignalled(uintptr_t fence) const {
+			return SignalledFences.count(fence) > 0;
+		}
+	};
+}
+
+TEST_CASE(FrameRing_AllocationsStayInTheirSegment) {
+	MockFenceBackend backend;
+	{
+		FrameRing ring(&backend, 1000, 3, 256);
+		// Segments are rounded up so that each one starts aligned
+		CHECK_EQ(ring.GetSegmentSize(), 1024u);
+		CHECK_EQ(ring.GetTotalSize(), 3072u);
+
+		std::mt19937 random(2);
+		for (int frame = 0; frame < 20; frame++) {
+			ring.BeginFrame();
+			uint32_t segment = ring.GetCurrentSegment();
+			CHECK_EQ(segment, static_cast<uint32_t>((frame + 1) % 3));
+
+			uint32_t lastEnd = segment * ring.GetSegmentSize();
+			for (;;) {
+				uint32_t size = 1 + random() % 300;
+				uint32_t offset = ring.Allocate(size);
+				if (offset == FrameRing::INVALID_OFFSET) {
+					break;
+				}
+				CHECK_EQ(offset % 256, 0u);
+				CHECK(offset >= lastEnd);
+				CHECK(offset + size <= (segment + 1) * ring.GetSegmentSize());
+				lastEnd = offset + size;
+			}
+			CHECK(ring.HasOverflowed());
+			ring.EndFrame();
+		}
+	}
+	// Every fence was cleaned up exactly once, including the ones still pending when the ring was destroyed
+	CHECK_EQ(backend.Errors, 0u);
+	CHECK(backend.LiveFences.empty());
+	CHECK_EQ(backend.Inserted, 20u);
+	CHECK_EQ(backend.Deleted, 20u);
+}
+
+TEST_CASE(FrameRing_WaitsBeforeReusingASegment) {
+	MockFenceBackend backend;
+	FrameRing ring(&backend, 4096, 3);
+
+	// The fence that guards each segment's last use, or 0 if the segment hasn't been used yet
+	std::vector<uintptr_t> segmentFences(3, 0);
+	for (int frame = 0; frame < 30; frame++) {
+		ring.BeginFrame();
+		uint32_t segment = ring.GetCurrentSegment();
+
+		// Before the CPU writes to a segment again, the GPU must have been waited on for its last frame
+		if (segmentFences[segment] != 0) {
+			CHECK(backend.IsSignalled(segmentFences[segment]));
+		}
+		// But the frames in flight after it must not have been waited on, or we'd be stalling for no reason
+		for (uint32_t other = 0; other < 3; other++) {
+			if (other != segment && segmentFences[other] != 0) {
+				CHECK(!backend.IsSignalled(segmentFences[other]));
+			}
+		}
+
+		CHECK(ring.Allocate(128) != FrameRing::INVALID_OFFSET);
+		CHECK(!ring.HasOverflowed());
+		ring.EndFrame();
+		segmentFences[segment] = backend.NextFence - 1;
+	}
+	// One wait per frame, once every segment has been used
+	CHECK_EQ(backend.Waits, 27u);
+	CHECK_EQ(backend.Errors, 0u);
+
+	ring.WaitForAll();
+	for (uintptr_t fence : segmentFences) {
+		CHECK(backend.IsSignalled(fence));
+	}
+	CHECK(backend.LiveFences.empty());
+	CHECK_EQ(backend.Errors, 0u);
+}
+
+TEST_CASE(FrameRing_OverflowAndFailedWaits) {
+	MockFenceBackend backend;
+	FrameRing ring(&backend, 256, 2, 16);
+
+	ring.BeginFrame();
+	CHECK(ring.Allocate(257) == FrameRing::INVALID_OFFSET);
+	CHECK(ring.HasOverflowed());
+	// Failing a big allocation doesn't use up the segment
+	CHECK(ring.Allocate(256) != FrameRing::INVALID_OFFSET);
+	CHECK_EQ(ring.GetUsed(), 256u);
+	CHECK(ring.Allocate(1) == FrameRing::INVALID_OFFSET);
+	// Calling EndFrame twice replaces the fence instead of leaking it
+	ring.EndFrame();
+	ring.EndFrame();
+	CHECK_EQ(backend.LiveFences.size(), 1u);
+
+	// The overflow flag and cursor reset every frame
+	ring.BeginFrame();
+	CHECK(!ring.HasOverflowed());
+	CHECK_EQ(ring.GetUsed(), 0u);
+	ring.EndFrame();
+
+	// A failed wait is reported, but the fence is still released and the ring keeps going
+	backend.FailWaits = true;
+	ring.BeginFrame();
+	CHECK(ring.Allocate(16) != FrameRing::INVALID_OFFSET);
+	ring.EndFrame();
+	CHECK_EQ(backend.Errors, 0u);
+	CHECK_EQ(backend.LiveFences.size(), 2u);
+}
@@ -0,0 +1,80 @@
+#include <cmath>
+#include <random>
+#include <GLM/glm.hpp>
+#include <GLM/gtc/matrix_transform.hpp>
+
+#include "TestFramework.h"
+
+// The shared G-buffer math, compiled as C++ so that these test exactly what the shaders run
+namespace GBufferShader {
+	using namespace glm;
+#include "../../res/shaders/fragments/gbuffer_packing.glsl"
+}
+
+namespace {
+	// Stores a value in [0, 1] the way an RG16 (unorm) attachment would
+	float QuantizeUnorm16(float value) {
+		return std::round(glm::clamp(value, 0.0f, 1.0f) * 65535.0f) / 65535.0f;
+	}
+
+	// atan2 instead of acos, since acos can't resolve small angles in floats (one ulp below 1 is already ~0.02 degrees)
+	float AngleDegrees(const glm::vec3& a, const glm::vec3& b) {
+		return glm::degrees(std::atan2(glm::length(glm::cross(a, b)), glm::dot(a, b)));
+	}
+}
+
+TEST_CASE(GBufferEncoding_OctahedralRoundTrip) {
+	std::mt19937 random(42);
+	std::normal_distribution<float> gaussian;
+
+	float maxError = 0.0f;
+	for (int ix = 0; ix < 100000; ix++) {
+		glm::vec3 normal = glm::normalize(glm::vec3(gaussian(random), gaussian(random), gaussian(random)));
+		glm::vec2 encoded = GBufferShader::OctEncode(normal);
+		CHECK(std::abs(encoded.x) <= 1.0f && std::abs(encoded.y) <= 1.0f);
+
+		// Without quantization the round trip should be exact, up to float precision
+		CHECK(AngleDegrees(GBufferShader::OctDecode(encoded), normal) < 0.01f);
+
+		glm::vec2 packed = GBufferShader::PackOctNormal(normal);
+		glm::vec2 stored = glm::vec2(QuantizeUnorm16(packed.x), QuantizeUnorm16(packed.y));
+		maxError = std::max(maxError, AngleDegrees(GBufferShader::UnpackOctNormal(stored), normal));
+	}
+	// With 16 bits per channel the worst case is around 0.0036 degrees
+	CHECK(maxError < 0.005f);
+}
+
+TEST_CASE(GBufferEncoding_OctahedralEdgeCases) {
+	// The axes, and normals on the fold between the two halves of the octahedron
+	const glm::vec3 normals[] = {
+		{ 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 },
+		glm::normalize(glm::vec3(1, 1, 0)), glm::normalize(glm::vec3(-1, 1, 0)), glm::normalize(glm::vec3(1, -1, 0)),
+		glm::normalize(glm::vec3(1, 1, -0.001f)), glm::normalize(glm::vec3(-1, -1, -1))
+	};
+	for (const glm::vec3& normal : normals) {
+		glm::vec2 encoded = GBufferShader::OctEncode(normal);
+		CHECK(std::abs(encoded.x) <= 1.0f && std::abs(encoded.y) <= 1.0f);
+		CHECK(AngleDegrees(GBufferShader::OctDecode(encoded), normal) < 0.01f);
+	}
+}
+
+TEST_CASE(GBufferEncoding_PositionFromDepth) {
+	glm::mat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 500.0f);
+	glm::mat4 invProjection = glm::inverse(projection);
+
+	std::mt19937 random(7);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	for (int ix = 0; ix < 10000; ix++) {
+		float depth = 0.2f + unit(random) * 100.0f;
+		glm::vec3 viewPos = glm::vec3((unit(random) * 2.0f - 1.0f) * depth, (unit(random) * 2.0f - 1.0f) * depth * 0.5f, -depth);
+		glm::vec4 clip = projection * glm::vec4(viewPos, 1.0f);
+		glm::vec3 ndc = glm::vec3(clip) / clip.w;
+		if (std::abs(ndc.x) > 1.0f || std::abs(ndc.y) > 1.0f) {
+			continue;
+		}
+
+		glm::vec3 rebuilt = GBufferShader::ViewPositionFromDepth(invProjection, glm::vec2(ndc) * 0.5f + 0.5f, ndc.z * 0.5f + 0.5f);
+		// Float depth, the error grows with distance since depth precision is spent near the camera
+		CHECK(glm::length(rebuilt - viewPos) < 1e-3f * depth);
+	}
+}
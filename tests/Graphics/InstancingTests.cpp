@@ -0,0 +1,187 @@
+#include <cmath>
+#include <random>
+#include <set>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <GLM/glm.hpp>
+#include <GLM/gtc/matrix_transform.hpp>
+
+#include "Graphics/InstancePacker.h"
+#include "Graphics/RenderQueue.h"
+
+#include "TestFramework.h"
+
+namespace {
+	// Stand-ins for what RenderLayer::_RenderScene sorts by, only their addresses matter
+	struct FakeMaterial {
+		int  Shader;
+		bool IsTransparent;
+	};
+
+	struct FakeDraw {
+		const FakeMaterial* Material;
+		const int*          Mesh;
+		float               Depth;
+	};
+
+	// Builds and sorts the queue the same way RenderLayer::_RenderScene does, and splits it into instanced runs
+	std::vector<std::pair<size_t, size_t>> GroupRuns(RenderQueue& queue, const std::vector<FakeDraw>& draws) {
+		std::unordered_map<const void*, uint32_t> shaderIds, materialIds, meshIds;
+		auto getSortId = [](std::unordered_map<const void*, uint32_t>& ids, const void* ptr) {
+			return ids.emplace(ptr, static_cast<uint32_t>(ids.size())).first->second;
+		};
+
+		queue.Clear();
+		for (size_t ix = 0; ix < draws.size(); ix++) {
+			const FakeDraw& draw = draws[ix];
+			queue.Push(RenderQueue::MakeKey(
+				draw.Material->IsTransparent ? RenderBucket::Transparent : RenderBucket::Opaque,
+				getSortId(shaderIds, &draw.Material->Shader),
+				getSortId(materialIds, draw.Material),
+				getSortId(meshIds, draw.Mesh),
+				draw.Depth
+			), static_cast<uint32_t>(ix));
+		}
+		queue.Sort();
+
+		std::vector<std::pair<size_t, size_t>> runs;
+		for (size_t ix = 0; ix < queue.Size();) {
+			const FakeDraw& first = draws[queue.GetItems()[ix].Payload];
+			size_t end = queue.GetRunEnd(ix, [&](const RenderQueue::Item&, const RenderQueue::Item& next) {
+				return draws[next.Payload].Mesh == first.Mesh && draws[next.Payload].Material == first.Material;
+			});
+			runs.emplace_back(ix, end);
+			ix = end;
+		}
+		return runs;
+	}
+
+	// Checks that every run shares a mesh and material, and that no two neighbouring runs could have been merged
+	void CheckRuns(const RenderQueue& queue, const std::vector<FakeDraw>& draws, const std::vector<std::pair<size_t, size_t>>& runs) {
+		const std::vector<RenderQueue::Item>& items = queue.GetItems();
+		size_t covered = 0;
+		for (size_t runIx = 0; runIx < runs.size(); runIx++) {
+			auto [begin, end] = runs[runIx];
+			CHECK_EQ(begin, covered);
+			CHECK(end > begin);
+			covered = end;
+
+			const FakeDraw& first = draws[items[begin].Payload];
+			for (size_t ix = begin + 1; ix < end; ix++) {
+				CHECK(draws[items[ix].Payload].Mesh == first.Mesh);
+				CHECK(draws[items[ix].Payload].Material == first.Material);
+			}
+			if (runIx + 1 < runs.size()) {
+				const FakeDraw& next = draws[items[end].Payload];
+				CHECK(next.Mesh != first.Mesh || next.Material != first.Material);
+			}
+		}
+		CHECK_EQ(covered, draws.size());
+	}
+}
+
+TEST_CASE(Instancing_OpaqueDrawsGroupIntoOneRunPerMeshAndMaterial) {
+	std::mt19937 random(21);
+	std::uniform_real_distribution<float> depth(0.5f, 300.0f);
+
+	std::vector<FakeMaterial> materials = { { 0, false }, { 0, false }, { 1, false }, { 2, false } };
+	std::vector<int> meshes(6);
+	std::vector<FakeDraw> draws;
+	std::set<std::pair<const void*, const void*>> pairs;
+	for (int ix = 0; ix < 2000; ix++) {
+		FakeDraw draw = { &materials[random() % materials.size()], &meshes[random() % meshes.size()], depth(random) };
+		draws.push_back(draw);
+		pairs.emplace(draw.Material, draw.Mesh);
+	}
+
+	RenderQueue queue;
+	std::vector<std::pair<size_t, size_t>> runs = GroupRuns(queue, draws);
+	CheckRuns(queue, draws, runs);
+	// Depth is the least significant part of an opaque key, so every mesh and material pair ends up in a single run
+	CHECK_EQ(runs.size(), pairs.size());
+
+	// Within a run, instances are still drawn front to back
+	for (auto [begin, end] : runs) {
+		for (size_t ix = begin + 1; ix < end; ix++) {
+			CHECK(draws[queue.GetItems()[ix - 1].Payload].Depth <= draws[queue.GetItems()[ix].Payload].Depth);
+		}
+	}
+}
+
+TEST_CASE(Instancing_TransparentRunsKeepDepthOrder) {
+	std::mt19937 random(8);
+	std::uniform_real_distribution<float> depth(0.5f, 300.0f);
+
+	FakeMaterial glass = { 0, true };
+	FakeMaterial water = { 1, true };
+	std::vector<int> meshes(2);
+	std::vector<FakeDraw> draws;
+	for (int ix = 0; ix < 500; ix++) {
+		draws.push_back({ random() % 2 ? &glass : &water, &meshes[random() % 2], depth(random) });
+	}
+	// A few draws at exactly the same depth can be batched together
+	for (int ix = 0; ix < 10; ix++) {
+		draws.push_back({ &glass, &meshes[0], 1000.0f });
+	}
+
+	RenderQueue queue;
+	std::vector<std::pair<size_t, size_t>> runs = GroupRuns(queue, draws);
+	CheckRuns(queue, draws, runs);
+
+	// Grouping must never break the back to front order that blending relies on, instances are drawn in
+	// order so this holds inside runs too. Keys only keep ~16 bits of the depth's mantissa, closer than that is a tie
+	const std::vector<RenderQueue::Item>& items = queue.GetItems();
+	for (size_t ix = 1; ix < items.size(); ix++) {
+		CHECK(draws[items[ix - 1].Payload].Depth >= draws[items[ix].Payload].Depth * (1.0f - 1e-4f));
+	}
+	CHECK(runs.front().second - runs.front().first >= 10);
+}
+
+TEST_CASE(Instancing_WrappedIdsDontMergeRuns) {
+	// More meshes than fit in the key's mesh field, so different meshes end up with the same ID
+	const size_t meshCount = (1u << RenderQueue::MESH_BITS) + 100;
+	std::vector<int> meshes(meshCount);
+	FakeMaterial material = { 0, false };
+	std::vector<FakeDraw> draws;
+	for (size_t ix = 0; ix < meshCount; ix++) {
+		draws.push_back({ &material, &meshes[ix], 10.0f });
+	}
+	// Draw the meshes whose IDs wrapped around again, so their keys match the first meshes exactly
+	for (size_t ix = meshCount - 100; ix < meshCount; ix++) {
+		draws.push_back({ &material, &meshes[ix], 10.0f });
+	}
+
+	RenderQueue queue;
+	std::vector<std::pair<size_t, size_t>> runs = GroupRuns(queue, draws);
+	CheckRuns(queue, draws, runs);
+	// Colliding meshes share a key, so only the pointer check keeps them apart. The stable sort keeps each
+	// repeated mesh next to its first draw, so there is exactly one run per mesh
+	CHECK_EQ(runs.size(), meshCount);
+}
+
+TEST_CASE(Instancing_PackedNormalMatrix) {
+	std::mt19937 random(4);
+	std::uniform_real_distribution<float> value(-2.0f, 2.0f);
+	for (int ix = 0; ix < 1000; ix++) {
+		glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(value(random), value(random), value(random)));
+		model = glm::rotate(model, value(random), glm::normalize(glm::vec3(value(random), value(random), 1.0f)));
+		// Non-uniform and sometimes mirrored scale, which is where the normal matrix matters
+		glm::vec3 scale = glm::vec3(value(random), value(random), value(random));
+		scale = glm::sign(scale) * glm::max(glm::abs(scale), glm::vec3(0.1f));
+		model = glm::scale(model, scale);
+
+		InstanceData instance;
+		InstancePacker::Pack(model, instance);
+		CHECK(instance.Model == model);
+
+		// The shaders normalize, so the packed matrix only has to match the inverse transpose up to a positive scale
+		glm::mat3 expected = glm::transpose(glm::inverse(glm::mat3(model)));
+		glm::mat3 packed = glm::mat3(glm::vec3(instance.NormalMatrix[0]), glm::vec3(instance.NormalMatrix[1]), glm::vec3(instance.NormalMatrix[2]));
+		glm::vec3 normal = glm::normalize(glm::vec3(value(random), value(random), value(random)));
+		glm::vec3 a = glm::normalize(expected * normal);
+		glm::vec3 b = glm::normalize(packed * normal);
+		CHECK(glm::dot(a, b) > 0.9999f);
+		CHECK_EQ(instance.NormalMatrix[0].w, 0.0f);
+	}
+}
@@ -0,0 +1,128 @@
+#include <algorithm>
+#include <random>
+#include <vector>
+#include <GLM/glm.hpp>
+#include <GLM/gtc/matrix_transform.hpp>
+
+#include "Graphics/LightClusterer.h"
+
+#include "TestFramework.h"
+
+static const float ZNEAR = 0.1f;
+static const float ZFAR = 100.0f;
+
+static void SetupClusterer(LightClusterer& clusterer) {
+	clusterer.SetProjection(glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, ZNEAR, ZFAR), ZNEAR, ZFAR);
+}
+
+// Finds the cluster that a view space point falls in by projecting it, independently of how Build walks the tiles
+static uint32_t FindCluster(const LightClusterer& clusterer, const glm::mat4& projection, const glm::vec3& point) {
+	glm::vec4 clip = projection * glm::vec4(point, 1.0f);
+	glm::vec2 uv = glm::vec2(clip) / clip.w * 0.5f + 0.5f;
+	glm::uvec3 grid = clusterer.GetGridSize();
+	uint32_t x = std::min(static_cast<uint32_t>(uv.x * grid.x), grid.x - 1);
+	uint32_t y = std::min(static_cast<uint32_t>(uv.y * grid.y), grid.y - 1);
+	return clusterer.GetClusterIndex(x, y, clusterer.GetDepthSlice(-point.z));
+}
+
+TEST_CASE(LightClusterer_SliceDepthsRoundTrip) {
+	LightClusterer clusterer;
+	SetupClusterer(clusterer);
+
+	CHECK_NEAR(clusterer.GetSliceDepth(0), ZNEAR, 1e-5f);
+	CHECK_EQ(clusterer.GetSliceDepth(LightClusterer::DEFAULT_SLICES), ZFAR);
+	for (uint32_t slice = 0; slice < LightClusterer::DEFAULT_SLICES; slice++) {
+		// Just inside the start and end of each slice
+		CHECK_EQ(clusterer.GetDepthSlice(clusterer.GetSliceDepth(slice) * 1.001f), slice);
+		CHECK_EQ(clusterer.GetDepthSlice(clusterer.GetSliceDepth(slice + 1) * 0.999f), slice);
+	}
+	CHECK_EQ(clusterer.GetDepthSlice(ZNEAR * 0.5f), 0u);
+	CHECK_EQ(clusterer.GetDepthSlice(ZFAR * 2.0f), LightClusterer::DEFAULT_SLICES - 1);
+}
+
+TEST_CASE(LightClusterer_InfluenceRadiusMatchesThreshold) {
+	float radius = LightClusterer::GetInfluenceRadius(4.0f, glm::vec3(1.0f, 0.5f, 0.25f), 0.2f);
+	// Same falloff as light_accumulation.glsl
+	float contribution = 4.0f / (1.0f + 0.2f * radius * radius);
+	CHECK_NEAR(contribution, 1.0f / 256.0f, 1e-6f);
+
+	CHECK_EQ(LightClusterer::GetInfluenceRadius(0.001f, glm::vec3(1.0f), 1.0f), 0.0f);
+	CHECK(LightClusterer::GetInfluenceRadius(1.0f, glm::vec3(1.0f), 0.0f) > 1e30f);
+}
+
+TEST_CASE(LightClusterer_ClustersAreConservative) {
+	const glm::mat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, ZNEAR, ZFAR);
+	LightClusterer clusterer;
+	SetupClusterer(clusterer);
+
+	std::mt19937 random(1234);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	std::vector<ClusterLight> lights(300);
+	for (ClusterLight& light : lights) {
+		float depth = 0.5f + unit(random) * 60.0f;
+		light.Position = glm::vec3((unit(random) * 2.0f - 1.0f) * depth * 0.9f, (unit(random) * 2.0f - 1.0f) * depth * 0.5f, -depth);
+		light.Radius = 0.1f + unit(random) * 3.0f;
+	}
+	clusterer.Build(lights.data(), lights.size());
+
+	const std::vector<LightCluster>& clusters = clusterer.GetClusters();
+	const std::vector<uint32_t>& indices = clusterer.GetLightIndices();
+	REQUIRE(clusters.size() == (size_t)LightClusterer::DEFAULT_TILES_X * LightClusterer::DEFAULT_TILES_Y * LightClusterer::DEFAULT_SLICES);
+
+	// The ranges must tile the index list exactly, and keep lights in the order they were given
+	uint32_t expectedOffset = 0;
+	uint32_t maxCount = 0;
+	for (const LightCluster& cluster : clusters) {
+		CHECK_EQ(cluster.Offset, expectedOffset);
+		CHECK(std::is_sorted(indices.begin() + cluster.Offset, indices.begin() + cluster.Offset + cluster.Count));
+		expectedOffset += cluster.Count;
+		maxCount = std::max(maxCount, cluster.Count);
+	}
+	CHECK_EQ(expectedOffset, indices.size());
+	CHECK_EQ(clusterer.GetMaxClusterLights(), maxCount);
+
+	// Brute force: sample points inside every light, whatever cluster a point lands in must list that light
+	auto contains = [&](uint32_t clusterIx, uint32_t light) {
+		const LightCluster& cluster = clusters[clusterIx];
+		return std::binary_search(indices.begin() + cluster.Offset, indices.begin() + cluster.Offset + cluster.Count, light);
+	};
+	for (uint32_t ix = 0; ix < lights.size(); ix++) {
+		for (int sample = 0; sample < 32; sample++) {
+			glm::vec3 offset = glm::vec3(unit(random), unit(random), unit(random)) * 2.0f - 1.0f;
+			if (glm::length(offset) > 1.0f) {
+				continue;
+			}
+			glm::vec3 point = lights[ix].Position + offset * lights[ix].Radius;
+			glm::vec4 clip = projection * glm::vec4(point, 1.0f);
+			if (-point.z <= ZNEAR || -point.z >= ZFAR || std::abs(clip.x) > clip.w || std::abs(clip.y) > clip.w) {
+				continue;
+			}
+			CHECK(contains(FindCluster(clusterer, projection, point), ix));
+		}
+	}
+}
+
+TEST_CASE(LightClusterer_SkipsLightsOutsideTheFrustum) {
+	LightClusterer clusterer;
+	SetupClusterer(clusterer);
+
+	std::vector<ClusterLight> lights = {
+		// Behind the camera
+		{ glm::vec3(0.0f, 0.0f, 5.0f), 1.0f },
+		// Past the far plane
+		{ glm::vec3(0.0f, 0.0f, -150.0f), 1.0f },
+		// Far off to the side
+		{ glm::vec3(500.0f, 0.0f, -10.0f), 1.0f }
+	};
+	clusterer.Build(lights.data(), lights.size());
+	CHECK_EQ(clusterer.GetLightIndices().size(), 0u);
+	CHECK_EQ(clusterer.GetMaxClusterLights(), 0u);
+
+	// Rebuilding after the grid changes must not leave old results behind
+	clusterer.SetGridSize(glm::uvec3(4, 4, 4));
+	ClusterLight visible = { glm::vec3(0.0f, 0.0f, -10.0f), 0.5f };
+	clusterer.Build(&visible, 1);
+	CHECK_EQ(clusterer.GetClusters().size(), 64u);
+	CHECK(clusterer.GetLightIndices().size() > 0);
+	CHECK(clusterer.GetMaxClusterLights() == 1);
+}
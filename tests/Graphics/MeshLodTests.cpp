@@ -0,0 +1,79 @@
+#include <cmath>
+#include <limits>
+#include <vector>
+#include <GLM/glm.hpp>
+#include <GLM/gtc/matrix_transform.hpp>
+
+#include "Graphics/MeshLod.h"
+
+#include "TestFramework.h"
+
+namespace {
+	// Levels with power of two errors, so that the thresholds can be hit exactly
+	std::vector<MeshLod> MakeLods() {
+		std::vector<MeshLod> result(4);
+		result[1].Error = 1.0f / 64.0f;
+		result[2].Error = 1.0f / 16.0f;
+		result[3].Error = 1.0f / 4.0f;
+		return result;
+	}
+}
+
+TEST_CASE(MeshLod_SelectLevelThresholds) {
+	std::vector<MeshLod> lods = MakeLods();
+
+	// A level is used up until its error covers exactly the pixel error we allow
+	CHECK_EQ(MeshLod::SelectLevel(lods, 1.0f, 1.0f), 3u);
+	CHECK_EQ(MeshLod::SelectLevel(lods, 4.0f, 1.0f), 3u);
+	CHECK_EQ(MeshLod::SelectLevel(lods, 4.5f, 1.0f), 2u);
+	CHECK_EQ(MeshLod::SelectLevel(lods, 16.0f, 1.0f), 2u);
+	CHECK_EQ(MeshLod::SelectLevel(lods, 16.5f, 1.0f), 1u);
+	CHECK_EQ(MeshLod::SelectLevel(lods, 64.0f, 1.0f), 1u);
+	CHECK_EQ(MeshLod::SelectLevel(lods, 64.5f, 1.0f), 0u);
+
+	// Allowing more error moves every threshold out by the same factor
+	CHECK_EQ(MeshLod::SelectLevel(lods, 8.0f, 2.0f), 3u);
+	CHECK_EQ(MeshLod::SelectLevel(lods, 129.0f, 2.0f), 0u);
+	CHECK_EQ(MeshLod::SelectLevel(lods, 16.0f, 0.0f), 0u);
+
+	// Inside the bounds, or with no simplified levels, we always get the full detail mesh
+	CHECK_EQ(MeshLod::SelectLevel(lods, std::numeric_limits<float>::infinity(), 1.0f), 0u);
+	CHECK_EQ(MeshLod::SelectLevel(std::vector<MeshLod>(1), 1.0f, 1.0f), 0u);
+	CHECK_EQ(MeshLod::SelectLevel(std::vector<MeshLod>(), 1.0f, 1.0f), 0u);
+}
+
+TEST_CASE(MeshLod_ProjectedRadius) {
+	const AABB bounds = AABB(glm::vec3(-1.0f), glm::vec3(1.0f));
+	const float radius = std::sqrt(3.0f);
+	const float screenHeight = 1000.0f;
+
+	// With a 90 degree FOV, a unit at distance d covers half the screen height over d
+	glm::mat4 perspective = glm::perspective(glm::radians(90.0f), 16.0f / 9.0f, 0.1f, 1000.0f);
+	glm::mat4 modelView = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, -10.0f));
+	CHECK_NEAR(MeshLod::GetProjectedRadius(bounds, modelView, perspective, screenHeight), radius * 500.0f / 10.0f, 1e-2f);
+	modelView = glm::translate(glm::mat4(1.0f), glm::vec3(3.0f, -2.0f, -100.0f));
+	CHECK_NEAR(MeshLod::GetProjectedRadius(bounds, modelView, perspective, screenHeight), radius * 500.0f / 100.0f, 1e-3f);
+
+	// Scaled meshes use their largest axis
+	modelView = glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, -10.0f)), glm::vec3(1.0f, 3.0f, 0.5f));
+	CHECK_NEAR(MeshLod::GetProjectedRadius(bounds, modelView, perspective, screenHeight), 3.0f * radius * 500.0f / 10.0f, 1e-2f);
+
+	// Inside the bounding sphere, or behind the camera
+	modelView = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, -1.5f));
+	CHECK(std::isinf(MeshLod::GetProjectedRadius(bounds, modelView, perspective, screenHeight)));
+	modelView = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, 10.0f));
+	CHECK(std::isinf(MeshLod::GetProjectedRadius(bounds, modelView, perspective, screenHeight)));
+
+	// Orthographic projections don't shrink with distance
+	glm::mat4 ortho = glm::ortho(-10.0f, 10.0f, -10.0f, 10.0f, 0.1f, 1000.0f);
+	for (float distance : { 5.0f, 50.0f, 500.0f }) {
+		modelView = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, -distance));
+		CHECK_NEAR(MeshLod::GetProjectedRadius(bounds, modelView, ortho, screenHeight), radius * 50.0f, 1e-3f);
+	}
+
+	// Putting the two together, a level with 1/64 error stops being used once the mesh is 64 pixels across
+	modelView = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, -radius * 500.0f / 63.0f));
+	CHECK_EQ(MeshLod::SelectLevel(MakeLods(), MeshLod::GetProjectedRadius(bounds, modelView, perspective, screenHeight), 1.0f), 1u);
+	modelView = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, -radius * 500.0f / 65.0f));
+	CHECK_EQ(MeshLod::SelectLevel(MakeLods(), MeshLod::GetProjectedRadius(bounds, modelView, perspective, screenHeight), 1.0f), 0u);
+}
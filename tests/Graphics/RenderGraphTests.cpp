@@ -0,0 +1,289 @@
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Graphics/RenderGraph.h"
+
+#include "TestFramework.h"
+
+typedef RenderGraph::Handle Handle;
+
+// Checks that no two targets that share a slot are alive at the same time
+static void CheckSlotLifetimes(const RenderGraph& graph) {
+	const std::vector<RenderGraph::Target>& targets = graph.GetTargets();
+	for (Handle a = 0; a < targets.size(); a++) {
+		for (Handle b = a + 1; b < targets.size(); b++) {
+			if (targets[a].Slot == RenderGraph::INVALID_HANDLE || targets[a].Slot != targets[b].Slot) {
+				continue;
+			}
+			// Dropped blits share their source's storage on purpose
+			if (graph.Resolve(a) == graph.Resolve(b)) {
+				continue;
+			}
+			CHECK(targets[a].LastUse < targets[b].FirstUse || targets[b].LastUse < targets[a].FirstUse);
+			CHECK(graph.GetSlots()[targets[a].Slot] == targets[a].Descriptor);
+		}
+	}
+}
+
+TEST_CASE(RenderGraph_ChainAliasesSlots) {
+	RenderGraph graph;
+	graph.Reset(glm::uvec2(1920, 1080));
+	Handle scene = graph.Import("Scene");
+	Handle backBuffer = graph.Import("BackBuffer");
+
+	// A post processing chain of 4 effects, each reading the last one's output
+	std::vector<std::string> executed;
+	Handle current = scene;
+	for (int ix = 0; ix < 4; ix++) {
+		std::string name = "Effect" + std::to_string(ix);
+		Handle output = graph.CreateTarget(name, RenderGraph::TargetDescriptor());
+		graph.AddPass(name, { current }, { output }, [&executed, name]() { executed.push_back(name); });
+		current = output;
+	}
+	graph.AddBlit("Present", current, backBuffer, [&executed]() { executed.push_back("Present"); });
+
+	REQUIRE(graph.Compile());
+	// Each effect only needs the one before it, so two framebuffers can be ping-ponged for the whole chain
+	CHECK_EQ(graph.GetSlots().size(), 2u);
+	CHECK_EQ(graph.GetTransientCount(), 4u);
+	CHECK_EQ(graph.GetPassOrder().size(), 5u);
+	CHECK_EQ(graph.GetCulledPassCount(), 0u);
+	CheckSlotLifetimes(graph);
+
+	graph.Execute();
+	REQUIRE(executed.size() == 5);
+	CHECK_EQ(executed[0], "Effect0");
+	CHECK_EQ(executed[3], "Effect3");
+	CHECK_EQ(executed[4], "Present");
+}
+
+TEST_CASE(RenderGraph_CullsUnreadPasses) {
+	RenderGraph graph;
+	graph.Reset(glm::uvec2(100, 100));
+	Handle scene = graph.Import("Scene");
+	Handle backBuffer = graph.Import("BackBuffer");
+	Handle a = graph.CreateTarget("A", RenderGraph::TargetDescriptor());
+	Handle b = graph.CreateTarget("B", RenderGraph::TargetDescriptor());
+	Handle c = graph.CreateTarget("C", RenderGraph::TargetDescriptor());
+
+	bool ranUnread = false;
+	graph.AddPass("WriteA", { scene }, { a }, nullptr);
+	// B is only read by C's pass, and nothing reads C, so both are culled
+	uint32_t writeB = graph.AddPass("WriteB", { scene }, { b }, [&]() { ranUnread = true; });
+	uint32_t writeC = graph.AddPass("WriteC", { b }, { c }, [&]() { ranUnread = true; });
+	// Passes without outputs are kept for their side effects
+	uint32_t sideEffect = graph.AddPass("Readback", { a }, { }, nullptr);
+	graph.AddBlit("Present", a, backBuffer, nullptr);
+
+	REQUIRE(graph.Compile());
+	CHECK_EQ(graph.GetCulledPassCount(), 2u);
+	CHECK(graph.GetPasses()[writeB].IsCulled);
+	CHECK(graph.GetPasses()[writeC].IsCulled);
+	CHECK(!graph.GetPasses()[sideEffect].IsCulled);
+	CHECK_EQ(graph.GetSlot(b), RenderGraph::INVALID_HANDLE);
+	CHECK_EQ(graph.GetSlot(c), RenderGraph::INVALID_HANDLE);
+	CHECK_EQ(graph.GetTransientCount(), 1u);
+
+	graph.Execute();
+	CHECK(!ranUnread);
+}
+
+TEST_CASE(RenderGraph_DropsRedundantBlits) {
+	RenderGraph graph;
+	graph.Reset(glm::uvec2(100, 100));
+	Handle scene = graph.Import("Scene");
+	Handle backBuffer = graph.Import("BackBuffer");
+	Handle a = graph.CreateTarget("A", RenderGraph::TargetDescriptor());
+	Handle copy = graph.CreateTarget("Copy", RenderGraph::TargetDescriptor());
+
+	bool copied = false;
+	graph.AddPass("WriteA", { scene }, { a }, nullptr);
+	uint32_t blit = graph.AddBlit("CopyA", a, copy, [&]() { copied = true; });
+	graph.AddPass("Use", { copy }, { backBuffer }, nullptr);
+
+	REQUIRE(graph.Compile());
+	CHECK_EQ(graph.GetDroppedBlitCount(), 1u);
+	CHECK(graph.GetPasses()[blit].IsCulled);
+	// Dropped blits aren't counted as culled passes
+	CHECK_EQ(graph.GetCulledPassCount(), 0u);
+	CHECK_EQ(graph.Resolve(copy), a);
+	CHECK_EQ(graph.GetSlot(copy), graph.GetSlot(a));
+	CHECK_EQ(graph.GetSlots().size(), 1u);
+	CHECK_EQ(graph.GetPassOrder().size(), 2u);
+
+	graph.Execute();
+	CHECK(!copied);
+}
+
+TEST_CASE(RenderGraph_KeepsBlitsThatAreNeeded) {
+	RenderGraph graph;
+
+	// The copy is drawn over while the source is still read afterwards, so they need separate storage
+	graph.Reset(glm::uvec2(100, 100));
+	Handle scene = graph.Import("Scene");
+	Handle backBuffer = graph.Import("BackBuffer");
+	Handle a = graph.CreateTarget("A", RenderGraph::TargetDescriptor());
+	Handle copy = graph.CreateTarget("Copy", RenderGraph::TargetDescriptor());
+	graph.AddPass("WriteA", { scene }, { a }, nullptr);
+	graph.AddBlit("CopyA", a, copy, nullptr);
+	graph.AddPass("DrawOverCopy", { scene }, { copy }, nullptr);
+	graph.AddPass("Use", { a, copy }, { backBuffer }, nullptr);
+	REQUIRE(graph.Compile());
+	CHECK_EQ(graph.GetDroppedBlitCount(), 0u);
+	CHECK_EQ(graph.GetSlots().size(), 2u);
+	CheckSlotLifetimes(graph);
+
+	// The source is drawn over after the copy, so the copy has to keep the old contents
+	graph.Reset(glm::uvec2(100, 100));
+	scene = graph.Import("Scene");
+	backBuffer = graph.Import("BackBuffer");
+	a = graph.CreateTarget("A", RenderGraph::TargetDescriptor());
+	copy = graph.CreateTarget("Copy", RenderGraph::TargetDescriptor());
+	graph.AddPass("WriteA", { scene }, { a }, nullptr);
+	graph.AddBlit("CopyA", a, copy, nullptr);
+	graph.AddPass("DrawOverA", { scene }, { a }, nullptr);
+	graph.AddPass("Use", { a, copy }, { backBuffer }, nullptr);
+	REQUIRE(graph.Compile());
+	CHECK_EQ(graph.GetDroppedBlitCount(), 0u);
+	CHECK(graph.GetSlot(a) != graph.GetSlot(copy));
+
+	// Changing formats is a real conversion
+	graph.Reset(glm::uvec2(100, 100));
+	scene = graph.Import("Scene");
+	backBuffer = graph.Import("BackBuffer");
+	a = graph.CreateTarget("A", RenderGraph::TargetDescriptor());
+	copy = graph.CreateTarget("Copy", RenderGraph::TargetDescriptor(RenderTargetType::ColorRgba16F));
+	graph.AddPass("WriteA", { scene }, { a }, nullptr);
+	graph.AddBlit("CopyA", a, copy, nullptr);
+	graph.AddPass("Use", { copy }, { backBuffer }, nullptr);
+	REQUIRE(graph.Compile());
+	CHECK_EQ(graph.GetDroppedBlitCount(), 0u);
+	CHECK_EQ(graph.GetSlots().size(), 2u);
+
+	// Blits into imported targets (ex: presenting to the screen) always have to run
+	graph.Reset(glm::uvec2(100, 100));
+	scene = graph.Import("Scene");
+	backBuffer = graph.Import("BackBuffer", RenderGraph::TargetDescriptor());
+	a = graph.CreateTarget("A", RenderGraph::TargetDescriptor());
+	graph.AddPass("WriteA", { scene }, { a }, nullptr);
+	graph.AddBlit("Present", a, backBuffer, nullptr);
+	REQUIRE(graph.Compile());
+	CHECK_EQ(graph.GetDroppedBlitCount(), 0u);
+	CHECK_EQ(graph.GetPassOrder().size(), 2u);
+}
+
+TEST_CASE(RenderGraph_RandomGraphsNeverOverlapSlots) {
+	std::mt19937 random(99);
+	RenderGraph graph;
+	for (int iteration = 0; iteration < 200; iteration++) {
+		graph.Reset(glm::uvec2(640, 480));
+		Handle scene = graph.Import("Scene");
+		Handle backBuffer = graph.Import("BackBuffer");
+		const RenderGraph::TargetDescriptor formats[] = {
+			RenderGraph::TargetDescriptor(),
+			RenderGraph::TargetDescriptor(RenderTargetType::ColorRgba16F),
+			RenderGraph::TargetDescriptor(RenderTargetType::ColorRgba8, glm::vec2(0.5f))
+		};
+
+		// Every pass reads from targets that were already written, so the graph is always valid
+		std::vector<Handle> written = { scene };
+		int passCount = 3 + random() % 10;
+		for (int ix = 0; ix < passCount; ix++) {
+			Handle source = written[random() % written.size()];
+			Handle output = graph.CreateTarget("T" + std::to_string(ix), formats[random() % 3]);
+			if (random() % 4 == 0) {
+				graph.AddBlit("Blit" + std::to_string(ix), source, output, nullptr);
+			} else {
+				graph.AddPass("Pass" + std::to_string(ix), { source, written[random() % written.size()] }, { output }, nullptr);
+			}
+			written.push_back(output);
+		}
+		graph.AddPass("Present", { written.back(), written[random() % written.size()] }, { backBuffer }, nullptr);
+
+		REQUIRE(graph.Compile());
+		CheckSlotLifetimes(graph);
+		CHECK(graph.GetSlots().size() <= graph.GetTransientCount());
+	}
+}
+
+TEST_CASE(RenderGraph_ReportsValidationErrors) {
+	RenderGraph graph;
+	graph.Reset(glm::uvec2(100, 100));
+	Handle backBuffer = graph.Import("BackBuffer");
+	Handle a = graph.CreateTarget("A", RenderGraph::TargetDescriptor());
+
+	bool ran = false;
+	// Reads A before anything writes it
+	graph.AddPass("ReadA", { a }, { backBuffer }, [&]() { ran = true; });
+	// Reads and writes A at the same time, which is also a read before write
+	graph.AddPass("Loop", { a }, { a }, nullptr);
+	// Uses a target that doesn't exist
+	graph.AddPass("Missing", { 42 }, { backBuffer }, nullptr);
+
+	CHECK(!graph.Compile());
+	CHECK_EQ(graph.GetErrors().size(), 4u);
+
+	// Fixing the graph clears the errors
+	graph.Reset(glm::uvec2(100, 100));
+	backBuffer = graph.Import("BackBuffer");
+	a = graph.CreateTarget("A", RenderGraph::TargetDescriptor());
+	graph.AddPass("WriteA", { }, { a }, nullptr);
+	graph.AddPass("ReadA", { a }, { backBuffer }, nullptr);
+	CHECK(graph.Compile());
+	CHECK(graph.GetErrors().empty());
+	CHECK(!ran);
+}
+
+TEST_CASE(RenderGraph_CompileInOrderRunsEveryPass) {
+	RenderGraph graph;
+	graph.Reset(glm::uvec2(100, 100));
+	Handle scene = graph.Import("Scene");
+	Handle backBuffer = graph.Import("BackBuffer");
+	Handle a = graph.CreateTarget("A", RenderGraph::TargetDescriptor());
+	Handle b = graph.CreateTarget("B", RenderGraph::TargetDescriptor());
+	Handle copy = graph.CreateTarget("Copy", RenderGraph::TargetDescriptor());
+
+	std::vector<std::string> executed;
+	// Reads B before anything writes it, so the graph is invalid
+	graph.AddPass("ReadB", { b }, { a }, [&]() { executed.push_back("ReadB"); });
+	graph.AddPass("WriteB", { scene }, { b }, [&]() { executed.push_back("WriteB"); });
+	// Would normally be culled, since nothing reads A afterwards
+	graph.AddPass("Unread", { scene }, { a }, [&]() { executed.push_back("Unread"); });
+	// Would normally be dropped
+	graph.AddBlit("CopyB", b, copy, [&]() { executed.push_back("CopyB"); });
+	graph.AddPass("Missing", { 42 }, { backBuffer }, [&]() { executed.push_back("Missing"); });
+	graph.AddPass("Present", { copy }, { backBuffer }, [&]() { executed.push_back("Present"); });
+	REQUIRE(!graph.Compile());
+
+	graph.CompileInOrder();
+	graph.Execute();
+	std::vector<std::string> expected = { "ReadB", "WriteB", "Unread", "CopyB", "Present" };
+	CHECK(executed == expected);
+	CHECK_EQ(graph.GetCulledPassCount(), 1u);
+	CHECK_EQ(graph.GetDroppedBlitCount(), 0u);
+
+	// No two transient targets share a slot
+	CHECK_EQ(graph.GetTransientCount(), 3u);
+	CHECK_EQ(graph.GetSlots().size(), 3u);
+	CHECK(graph.GetSlot(a) != graph.GetSlot(b));
+	CHECK(graph.GetSlot(a) != graph.GetSlot(copy));
+	CHECK(graph.GetSlot(b) != graph.GetSlot(copy));
+	CHECK(graph.Resolve(copy) == copy);
+	CHECK(graph.GetSlot(scene) == RenderGraph::INVALID_HANDLE);
+}
+
+TEST_CASE(RenderGraph_TargetSizes) {
+	RenderGraph::TargetDescriptor quarter(RenderTargetType::ColorRgba8, glm::vec2(0.25f));
+	CHECK(quarter.GetSize(glm::uvec2(1920, 1080)) == glm::uvec2(480, 270));
+	// Never rounds down to nothing
+	CHECK(quarter.GetSize(glm::uvec2(2, 2)) == glm::uvec2(1, 1));
+	CHECK_EQ(quarter.GetPixelSize(), 4u);
+
+	RenderGraph::TargetDescriptor fixed(RenderTargetType::ColorRgba16F);
+	fixed.FixedSize = glm::uvec2(256, 128);
+	fixed.Depth = RenderTargetType::Depth32;
+	CHECK(fixed.GetSize(glm::uvec2(1920, 1080)) == glm::uvec2(256, 128));
+	CHECK_EQ(fixed.GetPixelSize(), 12u);
+	CHECK(fixed != quarter);
+}
@@ -0,0 +1,103 @@
+#include <algorithm>
+#include <iterator>
+#include <random>
+#include <vector>
+
+#include "Graphics/RenderQueue.h"
+
+#include "TestFramework.h"
+
+// Fills a queue with the given keys, using the item's index as the payload so that stability can be checked
+static void FillQueue(RenderQueue& queue, const std::vector<uint64_t>& keys) {
+	queue.Clear();
+	for (size_t ix = 0; ix < keys.size(); ix++) {
+		queue.Push(keys[ix], static_cast<uint32_t>(ix));
+	}
+}
+
+// Checks the queue's order against std::stable_sort on the same keys
+static void CheckMatchesStdSort(RenderQueue& queue, const std::vector<uint64_t>& keys) {
+	FillQueue(queue, keys);
+	queue.Sort();
+
+	std::vector<RenderQueue::Item> expected;
+	for (size_t ix = 0; ix < keys.size(); ix++) {
+		expected.push_back({ keys[ix], static_cast<uint32_t>(ix) });
+	}
+	std::stable_sort(expected.begin(), expected.end(), [](const RenderQueue::Item& a, const RenderQueue::Item& b) {
+		return a.Key < b.Key;
+	});
+
+	const std::vector<RenderQueue::Item>& items = queue.GetItems();
+	REQUIRE(items.size() == expected.size());
+	size_t mismatches = 0;
+	for (size_t ix = 0; ix < items.size(); ix++) {
+		mismatches += (items[ix].Key != expected[ix].Key || items[ix].Payload != expected[ix].Payload) ? 1 : 0;
+	}
+	CHECK_EQ(mismatches, 0u);
+}
+
+TEST_CASE(RenderQueue_RadixSortMatchesStdSort) {
+	std::mt19937_64 random(17);
+	std::uniform_real_distribution<float> depth(0.1f, 500.0f);
+	RenderQueue queue;
+
+	for (size_t count : { 0, 1, 2, 3, 255, 256, 257, 5000, 70000 }) {
+		// Fully random keys exercise all 8 passes
+		std::vector<uint64_t> keys(count);
+		for (uint64_t& key : keys) {
+			key = random();
+		}
+		CheckMatchesStdSort(queue, keys);
+
+		// Real keys, with lots of duplicate state, both buckets, and bytes that never change
+		for (uint64_t& key : keys) {
+			RenderBucket bucket = random() % 4 == 0 ? RenderBucket::Transparent : RenderBucket::Opaque;
+			key = RenderQueue::MakeKey(bucket, random() % 4, random() % 30, random() % 50, depth(random));
+		}
+		CheckMatchesStdSort(queue, keys);
+
+		// Only a few distinct keys, so stability matters
+		for (uint64_t& key : keys) {
+			key = RenderQueue::MakeKey(RenderBucket::Opaque, 1, random() % 3, 2, 10.0f);
+		}
+		CheckMatchesStdSort(queue, keys);
+	}
+
+	// Already sorted and reverse sorted input
+	std::vector<uint64_t> keys(1000);
+	for (size_t ix = 0; ix < keys.size(); ix++) {
+		keys[ix] = ix * 0x0101010101ull;
+	}
+	CheckMatchesStdSort(queue, keys);
+	std::reverse(keys.begin(), keys.end());
+	CheckMatchesStdSort(queue, keys);
+}
+
+TEST_CASE(RenderQueue_KeyOrdering) {
+	// Opaque draws come before transparent ones
+	CHECK(RenderQueue::MakeKey(RenderBucket::Opaque, 1023, 0, 0, 1e6f) < RenderQueue::MakeKey(RenderBucket::Transparent, 0, 0, 0, 1.0f));
+	CHECK(RenderQueue::GetBucket(RenderQueue::MakeKey(RenderBucket::Opaque, 5, 6, 7, 8.0f)) == RenderBucket::Opaque);
+	CHECK(RenderQueue::GetBucket(RenderQueue::MakeKey(RenderBucket::Transparent, 5, 6, 7, 8.0f)) == RenderBucket::Transparent);
+
+	// Opaque: grouped by shader, then material, then mesh, then front to back
+	CHECK(RenderQueue::MakeKey(RenderBucket::Opaque, 0, 9, 9, 100.0f) < RenderQueue::MakeKey(RenderBucket::Opaque, 1, 0, 0, 1.0f));
+	CHECK(RenderQueue::MakeKey(RenderBucket::Opaque, 1, 0, 9, 100.0f) < RenderQueue::MakeKey(RenderBucket::Opaque, 1, 1, 0, 1.0f));
+	CHECK(RenderQueue::MakeKey(RenderBucket::Opaque, 1, 1, 0, 100.0f) < RenderQueue::MakeKey(RenderBucket::Opaque, 1, 1, 1, 1.0f));
+	CHECK(RenderQueue::MakeKey(RenderBucket::Opaque, 1, 1, 1, 1.0f) < RenderQueue::MakeKey(RenderBucket::Opaque, 1, 1, 1, 1.5f));
+
+	// Transparent: strictly back to front, state only breaks ties
+	CHECK(RenderQueue::MakeKey(RenderBucket::Transparent, 9, 9, 9, 50.0f) < RenderQueue::MakeKey(RenderBucket::Transparent, 0, 0, 0, 49.0f));
+	CHECK(RenderQueue::MakeKey(RenderBucket::Transparent, 0, 0, 0, 50.0f) < RenderQueue::MakeKey(RenderBucket::Transparent, 1, 0, 0, 50.0f));
+
+	// Depth order holds over a wide range without knowing the clip planes, and things behind the camera sort first
+	float depths[] = { -5.0f, 0.0f, 0.001f, 0.1f, 1.0f, 10.0f, 1000.0f, 1e6f };
+	for (size_t ix = 1; ix < std::size(depths); ix++) {
+		CHECK(RenderQueue::MakeKey(RenderBucket::Opaque, 0, 0, 0, depths[ix - 1]) <= RenderQueue::MakeKey(RenderBucket::Opaque, 0, 0, 0, depths[ix]));
+		CHECK(RenderQueue::MakeKey(RenderBucket::Transparent, 0, 0, 0, depths[ix - 1]) >= RenderQueue::MakeKey(RenderBucket::Transparent, 0, 0, 0, depths[ix]));
+	}
+
+	// IDs that don't fit wrap around instead of spilling into other fields
+	CHECK_EQ(RenderQueue::MakeKey(RenderBucket::Opaque, 1u << RenderQueue::SHADER_BITS, 0, 0, 1.0f), RenderQueue::MakeKey(RenderBucket::Opaque, 0, 0, 0, 1.0f));
+	CHECK_EQ(RenderQueue::GetBucket(RenderQueue::MakeKey(RenderBucket::Opaque, ~0u, ~0u, ~0u, 1e30f)), RenderBucket::Opaque);
+}
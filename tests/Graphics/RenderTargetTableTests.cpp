@@ -0,0 +1,57 @@
+#include <string>
+#include <vector>
+
+#include "Graphics/RenderGraph.h"
+#include "Graphics/RenderTargetTable.h"
+
+#include "TestFramework.h"
+
+typedef RenderGraph::Handle Handle;
+
+TEST_CASE(RenderTargetTable_TransientsUseTheirSlot) {
+	RenderGraph graph;
+	graph.Reset(glm::uvec2(64, 64));
+	RenderTargetTable<std::string> table;
+
+	Handle scene = graph.Import("Scene");
+	table.Import(scene, "Scene");
+	Handle backBuffer = graph.Import("BackBuffer");
+	table.Import(backBuffer, "BackBuffer");
+	Handle a = graph.CreateTarget("A", RenderGraph::TargetDescriptor());
+	graph.AddPass("WriteA", { scene }, { a }, nullptr);
+	graph.AddPass("Use", { a }, { backBuffer }, nullptr);
+	REQUIRE(graph.Compile());
+
+	std::vector<std::string> slots(graph.GetSlots().size());
+	for (size_t ix = 0; ix < slots.size(); ix++) {
+		slots[ix] = "Slot" + std::to_string(ix);
+	}
+	table.Realize(graph, slots);
+
+	REQUIRE(graph.GetTarget(a).Slot != RenderGraph::INVALID_HANDLE);
+	CHECK_EQ(table.Get(a), slots[graph.GetTarget(a).Slot]);
+	CHECK_EQ(table.Get(scene), std::string("Scene"));
+	CHECK_EQ(table.Get(backBuffer), std::string("BackBuffer"));
+}
+
+TEST_CASE(RenderTargetTable_AliasOfImportUsesTheImport) {
+	RenderGraph graph;
+	graph.Reset(glm::uvec2(64, 64));
+	RenderTargetTable<std::string> table;
+
+	// Copying the scene into a fresh target of the same layout gets dropped, so the copy has no slot of its own
+	Handle scene = graph.Import("Scene");
+	table.Import(scene, "Scene");
+	Handle backBuffer = graph.Import("BackBuffer");
+	table.Import(backBuffer, "BackBuffer");
+	Handle copy = graph.CreateTarget("Copy", RenderGraph::TargetDescriptor(RenderTargetType::Unknown));
+	graph.AddBlit("CopyScene", scene, copy, nullptr);
+	graph.AddPass("Use", { copy }, { backBuffer }, nullptr);
+	REQUIRE(graph.Compile());
+	REQUIRE(graph.GetDroppedBlitCount() == 1u);
+	REQUIRE(graph.Resolve(copy) == scene);
+
+	table.Realize(graph, std::vector<std::string>(graph.GetSlots().size(), "Slot"));
+	CHECK_EQ(table.Get(copy), std::string("Scene"));
+	CHECK_EQ(table.Get(scene), std::string("Scene"));
+}
@@ -0,0 +1,103 @@
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Graphics/ShaderPermutations.h"
+
+#include "TestFramework.h"
+
+typedef std::vector<std::string> Keywords;
+typedef std::vector<std::pair<ShaderPartType, std::string>> Parts;
+
+TEST_CASE(ShaderPermutations_NormalizeKeywords) {
+	// Order doesn't matter, duplicates and empty keywords are dropped
+	CHECK(ShaderPermutations::NormalizeKeywords({ "SKINNED", "ALPHA_TEST", "SKINNED", "", "FOG" }) == Keywords({ "ALPHA_TEST", "FOG", "SKINNED" }));
+	CHECK(ShaderPermutations::NormalizeKeywords({ "B", "A" }) == ShaderPermutations::NormalizeKeywords({ "A", "B", "A" }));
+	CHECK(ShaderPermutations::NormalizeKeywords({ }).empty());
+	CHECK(ShaderPermutations::NormalizeKeywords({ "", "" }).empty());
+
+	// Keywords with values are kept whole, so different values are different keywords
+	CHECK(ShaderPermutations::NormalizeKeywords({ "COUNT 4", "COUNT 2" }) == Keywords({ "COUNT 2", "COUNT 4" }));
+
+	CHECK_EQ(ShaderPermutations::GetKeywordKey({ "A", "B" }), std::string("A, B"));
+	CHECK_EQ(ShaderPermutations::GetKeywordKey({ }), std::string(""));
+}
+
+TEST_CASE(ShaderPermutations_ReferencesSymbolWholeWords) {
+	CHECK(ShaderPermutations::ReferencesSymbol("#ifdef TOON_SHADING\n", "TOON_SHADING"));
+	CHECK(ShaderPermutations::ReferencesSymbol("TOON_SHADING", "TOON_SHADING"));
+	CHECK(ShaderPermutations::ReferencesSymbol("#if defined(FOG)&&1", "FOG"));
+
+	// Part of a longer identifier on either side doesn't count
+	CHECK(!ShaderPermutations::ReferencesSymbol("#ifdef TOON_SHADING_2\n", "TOON_SHADING"));
+	CHECK(!ShaderPermutations::ReferencesSymbol("#ifdef USE_TOON_SHADING\n", "TOON_SHADING"));
+	CHECK(!ShaderPermutations::ReferencesSymbol("float fog2 = FOGGY;", "FOG"));
+	// But a later whole word match is still found
+	CHECK(ShaderPermutations::ReferencesSymbol("FOGGY FOG", "FOG"));
+	CHECK(!ShaderPermutations::ReferencesSymbol("", "FOG"));
+	CHECK(!ShaderPermutations::ReferencesSymbol("FOG", ""));
+}
+
+TEST_CASE(ShaderPermutations_InsertDefinesAfterVersion) {
+	const std::string source = "#version 450\n#ifdef SKINNED\n#endif\nvoid main() { COUNT; }\n";
+	CHECK_EQ(ShaderPermutations::InsertDefines(source, { "COUNT 4", "SKINNED", "UNUSED" }),
+		std::string("#version 450\n#define COUNT 4\n#define SKINNED\n#ifdef SKINNED\n#endif\nvoid main() { COUNT; }\n"));
+
+	// Comments before the version directive stay where they are
+	CHECK_EQ(ShaderPermutations::InsertDefines("// header\n#version 450 core\nFOG\n", { "FOG" }),
+		std::string("// header\n#version 450 core\n#define FOG\nFOG\n"));
+
+	// A version directive on the last line still gets the defines after it
+	CHECK_EQ(ShaderPermutations::InsertDefines("FOG\n#version 450", { "FOG" }), std::string("FOG\n#version 450\n#define FOG\n"));
+
+	// Without a version directive, the defines go at the very start
+	CHECK_EQ(ShaderPermutations::InsertDefines("void main() { FOG; }\n", { "FOG" }), std::string("#define FOG\nvoid main() { FOG; }\n"));
+
+	// Keywords the source doesn't use leave it untouched
+	CHECK_EQ(ShaderPermutations::InsertDefines(source, { "UNUSED" }), source);
+	CHECK_EQ(ShaderPermutations::InsertDefines(source, { }), source);
+}
+
+TEST_CASE(ShaderPermutations_SourceKeyChanges) {
+	const std::string vertex = "#version 450\nvoid main() { }\n";
+	const std::string fragment = "#version 450\n#ifdef TOON_SHADING\n#endif\nvoid main() { }\n";
+	const Parts parts = { { ShaderPartType::Vertex, vertex }, { ShaderPartType::Fragment, fragment } };
+	const uint64_t key = ShaderPermutations::GetSourceKey(parts, { }, false);
+
+	// The same sources always give the same key, whatever order the stages are in
+	CHECK_EQ(ShaderPermutations::GetSourceKey(parts, { }, false), key);
+	CHECK_EQ(ShaderPermutations::GetSourceKey({ parts[1], parts[0] }, { }, false), key);
+
+	// Changing the source does change it
+	CHECK(ShaderPermutations::GetSourceKey({ parts[0], { ShaderPartType::Fragment, fragment + " " } }, { }, false) != key);
+	// As does swapping which stage a source belongs to
+	CHECK(ShaderPermutations::GetSourceKey({ { ShaderPartType::Vertex, fragment }, { ShaderPartType::Fragment, vertex } }, { }, false) != key);
+	// And the varyings
+	CHECK(ShaderPermutations::GetSourceKey(parts, { "outPosition" }, false) != key);
+	CHECK(ShaderPermutations::GetSourceKey(parts, { "outPosition" }, true) != ShaderPermutations::GetSourceKey(parts, { "outPosition" }, false));
+
+	// Keywords change the key when a stage uses them, and otherwise share the program
+	auto getKey = [&](const Keywords& keywords) {
+		Parts defined = parts;
+		for (auto& [type, source] : defined) {
+			source = ShaderPermutations::InsertDefines(source, ShaderPermutations::NormalizeKeywords(keywords));
+		}
+		return ShaderPermutations::GetSourceKey(defined, { }, false);
+	};
+	CHECK_EQ(getKey({ }), key);
+	CHECK(getKey({ "TOON_SHADING" }) != key);
+	CHECK_EQ(getKey({ "UNUSED" }), key);
+	CHECK_EQ(getKey({ "TOON_SHADING", "UNUSED" }), getKey({ "TOON_SHADING" }));
+}
+
+TEST_CASE(ShaderPermutations_DriverHashChanges) {
+	const Keywords driver = { "Vendor", "Renderer", "4.6.0 Driver 1.0", "4.60" };
+	const uint64_t hash = ShaderPermutations::GetDriverHash(driver);
+	CHECK_EQ(ShaderPermutations::GetDriverHash(driver), hash);
+
+	// A driver update only changes the version string
+	CHECK(ShaderPermutations::GetDriverHash({ "Vendor", "Renderer", "4.6.0 Driver 1.1", "4.60" }) != hash);
+	CHECK(ShaderPermutations::GetDriverHash({ "Vendor", "Other Renderer", "4.6.0 Driver 1.0", "4.60" }) != hash);
+	// Strings that are split differently are different drivers
+	CHECK(ShaderPermutations::GetDriverHash({ "VendorRenderer", "", "4.6.0 Driver 1.0", "4.60" }) != hash);
+}
@@ -0,0 +1,134 @@
+#include <algorithm>
+#include <vector>
+#include <GLM/glm.hpp>
+
+#include "Graphics/ShadowAtlasPacker.h"
+
+#include "TestFramework.h"
+
+typedef ShadowAtlasPacker::Request Request;
+
+// Owners are only compared, so any unique address will do
+static int OWNERS[32];
+
+// Checks that every tile that was given space is inside the atlas, and that no two tiles overlap
+static void CheckTilesFit(const ShadowAtlasPacker& packer) {
+	const std::vector<glm::uvec4>& tiles = packer.GetTiles();
+	for (size_t a = 0; a < tiles.size(); a++) {
+		if (tiles[a].z == 0) {
+			continue;
+		}
+		CHECK(tiles[a].x + tiles[a].z <= packer.GetAtlasSize());
+		CHECK(tiles[a].y + tiles[a].w <= packer.GetAtlasSize());
+		for (size_t b = a + 1; b < tiles.size(); b++) {
+			if (tiles[b].z == 0) {
+				continue;
+			}
+			bool isApart =
+				tiles[a].x + tiles[a].z <= tiles[b].x || tiles[b].x + tiles[b].z <= tiles[a].x ||
+				tiles[a].y + tiles[a].w <= tiles[b].y || tiles[b].y + tiles[b].w <= tiles[a].y;
+			CHECK(isApart);
+		}
+	}
+}
+
+TEST_CASE(ShadowAtlasPacker_TilesDontOverlap) {
+	ShadowAtlasPacker packer(2048);
+
+	// A mix of square, wide, tall, and non power of two tiles that all fit without shrinking
+	const glm::uvec2 sizes[] = {
+		{ 512, 512 }, { 256, 256 }, { 1024, 512 }, { 128, 256 }, { 300, 200 }, { 64, 64 },
+		{ 512, 256 }, { 256, 512 }, { 100, 100 }, { 1024, 1024 }, { 96, 160 }, { 256, 256 }
+	};
+	std::vector<Request> requests;
+	for (size_t ix = 0; ix < sizeof(sizes) / sizeof(sizes[0]); ix++) {
+		requests.push_back({ &OWNERS[ix], sizes[ix], 1.0f });
+	}
+
+	CHECK(packer.Update(requests));
+	REQUIRE(packer.GetTiles().size() == requests.size());
+	CHECK_EQ(packer.GetDroppedCount(), 0u);
+	CheckTilesFit(packer);
+	for (size_t ix = 0; ix < requests.size(); ix++) {
+		CHECK(glm::uvec2(packer.GetTiles()[ix].z, packer.GetTiles()[ix].w) == requests[ix].Size);
+	}
+}
+
+TEST_CASE(ShadowAtlasPacker_ShrinksBeforeDropping) {
+	ShadowAtlasPacker packer(1024);
+
+	// Eight full size tiles can't fit, but they all fit once they are shrunk
+	std::vector<Request> requests;
+	for (size_t ix = 0; ix < 8; ix++) {
+		requests.push_back({ &OWNERS[ix], glm::uvec2(1024), 1.0f + ix });
+	}
+
+	CHECK(packer.Update(requests));
+	CHECK_EQ(packer.GetDroppedCount(), 0u);
+	CheckTilesFit(packer);
+
+	const std::vector<glm::uvec4>& tiles = packer.GetTiles();
+	for (size_t ix = 0; ix < tiles.size(); ix++) {
+		CHECK(tiles[ix].z >= ShadowAtlasPacker::MIN_TILE_SIZE);
+		CHECK(tiles[ix].z < 1024u);
+	}
+	// The most important light should never end up with less space than the least important one
+	CHECK(tiles.back().z * tiles.back().w >= tiles.front().z * tiles.front().w);
+}
+
+TEST_CASE(ShadowAtlasPacker_DropsLeastImportantFirst) {
+	// Only four of the smallest tiles fit in an atlas this size
+	ShadowAtlasPacker packer(ShadowAtlasPacker::MIN_TILE_SIZE * 2);
+
+	const float importance[] = { 4.0f, 1.0f, 6.0f, 3.0f, 2.0f, 5.0f };
+	std::vector<Request> requests;
+	for (size_t ix = 0; ix < 6; ix++) {
+		requests.push_back({ &OWNERS[ix], glm::uvec2(256), importance[ix] });
+	}
+
+	CHECK(packer.Update(requests));
+	CHECK_EQ(packer.GetDroppedCount(), 2u);
+	CheckTilesFit(packer);
+
+	// Importance 1 and 2 are dropped, everything else is shrunk down to the smallest tile
+	const std::vector<glm::uvec4>& tiles = packer.GetTiles();
+	for (size_t ix = 0; ix < tiles.size(); ix++) {
+		if (importance[ix] <= 2.0f) {
+			CHECK_EQ(tiles[ix].z, 0u);
+		} else {
+			CHECK_EQ(tiles[ix].z, ShadowAtlasPacker::MIN_TILE_SIZE);
+			CHECK_EQ(tiles[ix].w, ShadowAtlasPacker::MIN_TILE_SIZE);
+		}
+	}
+}
+
+TEST_CASE(ShadowAtlasPacker_LayoutIsStable) {
+	ShadowAtlasPacker packer(1024);
+
+	std::vector<Request> requests;
+	for (size_t ix = 0; ix < 12; ix++) {
+		requests.push_back({ &OWNERS[ix], glm::uvec2(ix % 3 == 0 ? 512 : 256), 1.0f + ix });
+	}
+	CHECK(packer.Update(requests));
+	std::vector<glm::uvec4> first = packer.GetTiles();
+	std::vector<Request> original = requests;
+
+	// Nothing changes from frame to frame while the requests stay the same, even as importance changes
+	for (int frame = 0; frame < 4; frame++) {
+		for (Request& request : requests) {
+			request.Importance *= 1.5f;
+		}
+		CHECK(!packer.Update(requests));
+		CHECK(packer.GetTiles() == first);
+	}
+
+	// Re-packing the same requests from scratch lands on the same layout
+	ShadowAtlasPacker other(1024);
+	CHECK(other.Update(original));
+	CHECK(other.GetTiles() == first);
+
+	// Changing a size does re-pack
+	requests[1].Size = glm::uvec2(128);
+	CHECK(packer.Update(requests));
+	CheckTilesFit(packer);
+}
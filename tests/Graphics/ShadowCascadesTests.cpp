@@ -0,0 +1,108 @@
+#include <cmath>
+#include <GLM/glm.hpp>
+#include <GLM/gtc/matrix_transform.hpp>
+
+#include "Graphics/ShadowCascades.h"
+
+#include "TestFramework.h"
+
+static const uint32_t RESOLUTION = 1024;
+
+static glm::mat4 GetCameraProjection() {
+	return glm::perspective(glm::radians(70.0f), 16.0f / 9.0f, 0.1f, 200.0f);
+}
+
+static glm::mat4 GetLightTransform() {
+	// A light shining down and to the side, at an angle that isn't aligned with any world axis
+	return glm::inverse(glm::lookAt(glm::vec3(0.0f), glm::vec3(-0.4f, -1.0f, -0.3f), glm::vec3(0.0f, 0.0f, 1.0f)));
+}
+
+// Gets the shadow map texel coordinates that a world space point lands on for a cascade
+static glm::vec2 GetTexelCoords(const ShadowCascades::Cascade& cascade, const glm::vec3& point) {
+	glm::vec4 clip = cascade.Projection * cascade.View * glm::vec4(point, 1.0f);
+	return (glm::vec2(clip) / clip.w * 0.5f + 0.5f) * static_cast<float>(RESOLUTION);
+}
+
+TEST_CASE(ShadowCascades_SplitsBlendUniformAndLog) {
+	float splits[ShadowCascades::MAX_CASCADES + 1];
+
+	ShadowCascades::ComputeSplits(1.0f, 81.0f, 4, 0.0f, splits);
+	for (int ix = 0; ix <= 4; ix++) {
+		CHECK_NEAR(splits[ix], 1.0f + 20.0f * ix, 1e-3f);
+	}
+
+	ShadowCascades::ComputeSplits(1.0f, 81.0f, 4, 1.0f, splits);
+	for (int ix = 0; ix <= 4; ix++) {
+		CHECK_NEAR(splits[ix], std::pow(3.0f, static_cast<float>(ix)), 1e-3f);
+	}
+
+	ShadowCascades::ComputeSplits(0.1f, 200.0f, 3, 0.75f, splits);
+	CHECK_EQ(splits[0], 0.1f);
+	CHECK_EQ(splits[3], 200.0f);
+	CHECK(splits[0] < splits[1] && splits[1] < splits[2] && splits[2] < splits[3]);
+}
+
+TEST_CASE(ShadowCascades_SliceCornersLieOnSplitPlanes) {
+	glm::mat4 cameraTransform = glm::translate(glm::mat4(1.0f), glm::vec3(3.0f, 2.0f, -5.0f)) * glm::rotate(glm::mat4(1.0f), 0.7f, glm::vec3(0.0f, 1.0f, 0.0f));
+	glm::mat4 view = glm::inverse(cameraTransform);
+
+	glm::vec3 corners[8];
+	ShadowCascades::GetSliceCorners(cameraTransform, GetCameraProjection(), 5.0f, 20.0f, corners);
+	for (int ix = 0; ix < 8; ix++) {
+		glm::vec3 viewPos = glm::vec3(view * glm::vec4(corners[ix], 1.0f));
+		CHECK_NEAR(viewPos.z, ix < 4 ? -5.0f : -20.0f, 1e-3f);
+
+		// And on the edges of the frustum
+		glm::vec4 clip = GetCameraProjection() * glm::vec4(viewPos, 1.0f);
+		CHECK_NEAR(std::abs(clip.x / clip.w), 1.0f, 1e-3f);
+		CHECK_NEAR(std::abs(clip.y / clip.w), 1.0f, 1e-3f);
+	}
+}
+
+TEST_CASE(ShadowCascades_CascadeContainsSlice) {
+	glm::mat4 cameraTransform = glm::translate(glm::mat4(1.0f), glm::vec3(10.0f, 3.0f, 4.0f));
+	ShadowCascades::Cascade cascade = ShadowCascades::FitCascade(cameraTransform, GetCameraProjection(), 2.0f, 30.0f, GetLightTransform(), RESOLUTION, 50.0f);
+
+	glm::vec3 corners[8];
+	ShadowCascades::GetSliceCorners(cameraTransform, GetCameraProjection(), 2.0f, 30.0f, corners);
+	for (const glm::vec3& corner : corners) {
+		glm::vec4 clip = cascade.Projection * cascade.View * glm::vec4(corner, 1.0f);
+		glm::vec3 ndc = glm::vec3(clip) / clip.w;
+		CHECK(std::abs(ndc.x) <= 1.0f && std::abs(ndc.y) <= 1.0f && std::abs(ndc.z) <= 1.0f);
+	}
+
+	// Casters up to casterDistance towards the light from the slice must still land in front of the near plane
+	// The light looks down its -Z axis, so +Z points back towards it
+	glm::vec3 towardsLight = glm::normalize(glm::vec3(GetLightTransform()[2]));
+	glm::vec4 clip = cascade.Projection * cascade.View * glm::vec4(corners[0] + towardsLight * 45.0f, 1.0f);
+	CHECK(clip.z / clip.w >= -1.0f);
+}
+
+TEST_CASE(ShadowCascades_TexelSnappingIsStable) {
+	const glm::vec3 fixedPoint = glm::vec3(1.3f, 0.2f, -7.9f);
+
+	ShadowCascades::Cascade first;
+	glm::vec2 firstFraction;
+	for (int frame = 0; frame < 50; frame++) {
+		// Move and turn the camera by amounts that aren't multiples of a texel
+		glm::mat4 cameraTransform =
+			glm::translate(glm::mat4(1.0f), glm::vec3(frame * 0.0137f, frame * 0.0051f, -frame * 0.0093f)) *
+			glm::rotate(glm::mat4(1.0f), frame * 0.02f, glm::vec3(0.0f, 1.0f, 0.0f));
+		ShadowCascades::Cascade cascade = ShadowCascades::FitCascade(cameraTransform, GetCameraProjection(), 1.0f, 25.0f, GetLightTransform(), RESOLUTION, 50.0f);
+
+		// The texel size must not change as the camera turns, and a point in the world must stay at the same
+		// spot within its texel, otherwise the shadow edges shimmer
+		glm::vec2 texel = GetTexelCoords(cascade, fixedPoint);
+		glm::vec2 fraction = texel - glm::floor(texel);
+		if (frame == 0) {
+			first = cascade;
+			firstFraction = fraction;
+			continue;
+		}
+		CHECK_EQ(cascade.TexelSize, first.TexelSize);
+		glm::vec2 delta = glm::abs(fraction - firstFraction);
+		// Wrapping around a texel edge shows up as a difference close to 1
+		delta = glm::min(delta, 1.0f - delta);
+		CHECK(delta.x < 1e-2f && delta.y < 1e-2f);
+	}
+}
@@ -0,0 +1,119 @@
+#include "Graphics/ShadowCasterTracker.h"
+
+#include "TestFramework.h"
+
+// Runs a single frame that tracks one caster, returning whether it ended up static
+static bool TrackFrame(ShadowCasterTracker& tracker, const void* caster, uint32_t version, ShadowCasterMode mode = ShadowCasterMode::Auto) {
+	tracker.BeginFrame();
+	bool result = tracker.Track(caster, version, mode);
+	tracker.EndFrame();
+	return result;
+}
+
+TEST_CASE(ShadowCasterTracker_AutoCastersSettle) {
+	ShadowCasterTracker tracker(4);
+	int caster;
+
+	// New casters are dynamic, and become static after staying still for the settle time
+	CHECK(!TrackFrame(tracker, &caster, 0));
+	for (int frame = 1; frame < 4; frame++) {
+		CHECK(!TrackFrame(tracker, &caster, 0));
+	}
+	uint64_t version = tracker.GetStaticVersion();
+	CHECK(TrackFrame(tracker, &caster, 0));
+	CHECK(tracker.IsStatic(&caster));
+	CHECK_EQ(tracker.GetStaticCount(), 1u);
+	CHECK(tracker.GetStaticVersion() != version);
+
+	// Staying still doesn't invalidate the caches
+	version = tracker.GetStaticVersion();
+	for (int frame = 0; frame < 10; frame++) {
+		CHECK(TrackFrame(tracker, &caster, 0));
+	}
+	CHECK_EQ(tracker.GetStaticVersion(), version);
+}
+
+TEST_CASE(ShadowCasterTracker_MovingDemotesWithBackoff) {
+	ShadowCasterTracker tracker(2);
+	int caster;
+	uint32_t transform = 0;
+
+	int frames = 0;
+	while (!TrackFrame(tracker, &caster, transform)) {
+		frames++;
+	}
+	CHECK_EQ(frames, 2);
+
+	// Moving a static caster demotes it and invalidates the caches
+	uint64_t version = tracker.GetStaticVersion();
+	CHECK(!TrackFrame(tracker, &caster, ++transform));
+	CHECK(tracker.GetStaticVersion() != version);
+	CHECK_EQ(tracker.GetDynamicCount(), 1u);
+
+	// Each demotion doubles the time it takes to settle again, up to the backoff limit
+	for (uint32_t demotions = 1; demotions <= ShadowCasterTracker::MAX_SETTLE_BACKOFF + 1; demotions++) {
+		frames = 0;
+		while (!TrackFrame(tracker, &caster, transform)) {
+			frames++;
+		}
+		uint32_t backoff = demotions < ShadowCasterTracker::MAX_SETTLE_BACKOFF ? demotions : ShadowCasterTracker::MAX_SETTLE_BACKOFF;
+		CHECK_EQ(frames + 1, (2 << backoff));
+		CHECK(!TrackFrame(tracker, &caster, ++transform));
+	}
+}
+
+TEST_CASE(ShadowCasterTracker_ForcedModes) {
+	ShadowCasterTracker tracker(4);
+	int staticCaster;
+	int dynamicCaster;
+
+	tracker.BeginFrame();
+	CHECK(tracker.Track(&staticCaster, 0, ShadowCasterMode::Static));
+	CHECK(!tracker.Track(&dynamicCaster, 0, ShadowCasterMode::Dynamic));
+	tracker.EndFrame();
+
+	// Forced static casters stay static when they move, but still invalidate the caches
+	uint64_t version = tracker.GetStaticVersion();
+	tracker.BeginFrame();
+	CHECK(tracker.Track(&staticCaster, 1, ShadowCasterMode::Static));
+	CHECK(!tracker.Track(&dynamicCaster, 1, ShadowCasterMode::Dynamic));
+	tracker.EndFrame();
+	CHECK(tracker.GetStaticVersion() != version);
+
+	// Dynamic casters never settle, and moving them doesn't touch the static version
+	for (int frame = 0; frame < 20; frame++) {
+		tracker.BeginFrame();
+		tracker.Track(&staticCaster, 1, ShadowCasterMode::Static);
+		version = tracker.GetStaticVersion();
+		CHECK(!tracker.Track(&dynamicCaster, frame, ShadowCasterMode::Dynamic));
+		CHECK_EQ(tracker.GetStaticVersion(), version);
+		tracker.EndFrame();
+	}
+	CHECK_EQ(tracker.GetStaticCount(), 1u);
+	CHECK_EQ(tracker.GetDynamicCount(), 1u);
+}
+
+TEST_CASE(ShadowCasterTracker_RemovesUntrackedCasters) {
+	ShadowCasterTracker tracker(1);
+	int a;
+	int b;
+
+	tracker.BeginFrame();
+	tracker.Track(&a, 0, ShadowCasterMode::Static);
+	tracker.Track(&b, 0, ShadowCasterMode::Static);
+	tracker.EndFrame();
+	CHECK_EQ(tracker.GetStaticCount(), 2u);
+
+	// A static caster that goes missing (ex: destroyed) has to invalidate the caches
+	uint64_t version = tracker.GetStaticVersion();
+	TrackFrame(tracker, &a, 0, ShadowCasterMode::Static);
+	CHECK(!tracker.IsStatic(&b));
+	CHECK_EQ(tracker.GetStaticCount(), 1u);
+	CHECK_EQ(tracker.GetDynamicCount(), 0u);
+	CHECK(tracker.GetStaticVersion() != version);
+
+	version = tracker.GetStaticVersion();
+	tracker.Clear();
+	CHECK_EQ(tracker.GetStaticCount(), 0u);
+	CHECK(tracker.GetStaticVersion() != version);
+}
@@ -0,0 +1,157 @@
+#include <cstring>
+#include <string>
+#include <vector>
+#include <GLM/glm.hpp>
+
+#include "Graphics/UniformBlockPacker.h"
+
+#include "TestFramework.h"
+
+namespace {
+	// Padding is filled with this, so we can check that nothing writes into it
+	const uint8_t PADDING = 0xCD;
+
+	UniformBlockMember MakeMember(ShaderDataType type, int offset, size_t arraySize = 1, int arrayStride = 0, int matrixStride = 0) {
+		UniformBlockMember result;
+		result.Type = type;
+		result.Offset = offset;
+		result.ArraySize = arraySize;
+		result.ArrayStride = arrayStride;
+		result.MatrixStride = matrixStride;
+		return result;
+	}
+
+	template <typename T>
+	T ReadAt(const std::vector<uint8_t>& block, size_t offset) {
+		T result;
+		memcpy(&result, block.data() + offset, sizeof(T));
+		return result;
+	}
+
+	// True if every byte in [begin, end) is still padding
+	bool IsPadding(const std::vector<uint8_t>& block, size_t begin, size_t end) {
+		for (size_t ix = begin; ix < end; ix++) {
+			if (block[ix] != PADDING) {
+				return false;
+			}
+		}
+		return true;
+	}
+}
+
+// The offsets and strides in these tests are what the std140 rules give for this block, which is what the
+// shader reflects for it:
+//   layout (std140) uniform b_Material {
+//       vec3  u_Tint;           //   0
+//       float u_Shininess;      //  12
+//       mat3  u_UvTransform;    //  16, matrix stride 16
+//       float u_Weights[3];     //  64, array stride 16
+//       bool  u_Flags[2];       // 112, array stride 16
+//       bvec3 u_Mask;           // 144
+//       mat4  u_Bones[2];       // 160, array stride 64, matrix stride 16
+//   };                          // 288 bytes
+
+TEST_CASE(UniformBlockPacker_Vectors) {
+	std::vector<uint8_t> block(288, PADDING);
+	glm::vec3 tint = glm::vec3(0.25f, 0.5f, 0.75f);
+	float shininess = 32.0f;
+	UniformBlockPacker::Write(MakeMember(ShaderDataType::Float3, 0), &tint, block.data(), block.size());
+	UniformBlockPacker::Write(MakeMember(ShaderDataType::Float, 12), &shininess, block.data(), block.size());
+
+	// A float after a vec3 fills in its padding
+	CHECK(ReadAt<glm::vec3>(block, 0) == tint);
+	CHECK_EQ(ReadAt<float>(block, 12), shininess);
+	CHECK(IsPadding(block, 16, block.size()));
+}
+
+TEST_CASE(UniformBlockPacker_Matrices) {
+	std::vector<uint8_t> block(288, PADDING);
+
+	// Each column of a mat3 is padded out to a vec4
+	glm::mat3 uvTransform;
+	uvTransform[0] = glm::vec3(1.0f, 2.0f, 3.0f);
+	uvTransform[1] = glm::vec3(4.0f, 5.0f, 6.0f);
+	uvTransform[2] = glm::vec3(7.0f, 8.0f, 9.0f);
+	UniformBlockPacker::Write(MakeMember(ShaderDataType::Mat3, 16, 1, 0, 16), &uvTransform, block.data(), block.size());
+	for (int column = 0; column < 3; column++) {
+		CHECK(ReadAt<glm::vec3>(block, 16 + column * 16) == uvTransform[column]);
+		CHECK(IsPadding(block, 16 + column * 16 + 12, 16 + (column + 1) * 16));
+	}
+
+	// Arrays of mat4s are already tightly packed
+	glm::mat4 bones[2] = { glm::mat4(1.0f), glm::mat4(2.0f) };
+	bones[1][3] = glm::vec4(1.0f, 2.0f, 3.0f, 1.0f);
+	UniformBlockPacker::Write(MakeMember(ShaderDataType::Mat4, 160, 2, 64, 16), bones, block.data(), block.size());
+	CHECK(ReadAt<glm::mat4>(block, 160) == bones[0]);
+	CHECK(ReadAt<glm::mat4>(block, 224) == bones[1]);
+
+	CHECK(IsPadding(block, 0, 16));
+	CHECK(IsPadding(block, 64, 160));
+}
+
+TEST_CASE(UniformBlockPacker_Arrays) {
+	std::vector<uint8_t> block(288, PADDING);
+
+	// Every element of a scalar array starts on a vec4
+	float weights[3] = { 0.5f, 0.25f, 0.125f };
+	UniformBlockPacker::Write(MakeMember(ShaderDataType::Float, 64, 3, 16), weights, block.data(), block.size());
+	for (int ix = 0; ix < 3; ix++) {
+		CHECK_EQ(ReadAt<float>(block, 64 + ix * 16), weights[ix]);
+		CHECK(IsPadding(block, 64 + ix * 16 + 4, 64 + (ix + 1) * 16));
+	}
+	CHECK(IsPadding(block, 0, 64));
+	CHECK(IsPadding(block, 112, block.size()));
+}
+
+TEST_CASE(UniformBlockPacker_Bools) {
+	std::vector<uint8_t> block(288, PADDING);
+
+	// Our bools are bytes, in a block they're 4 byte integers that are 0 or 1
+	bool flags[2] = { true, false };
+	UniformBlockPacker::Write(MakeMember(ShaderDataType::Bool, 112, 2, 16), flags, block.data(), block.size());
+	CHECK_EQ(ReadAt<uint32_t>(block, 112), 1u);
+	CHECK_EQ(ReadAt<uint32_t>(block, 128), 0u);
+	CHECK(IsPadding(block, 116, 128));
+	CHECK(IsPadding(block, 132, 144));
+
+	// Any non zero byte counts as true
+	uint8_t mask[3] = { 0, 7, 1 };
+	UniformBlockPacker::Write(MakeMember(ShaderDataType::Bool3, 144), mask, block.data(), block.size());
+	CHECK_EQ(ReadAt<uint32_t>(block, 144), 0u);
+	CHECK_EQ(ReadAt<uint32_t>(block, 148), 1u);
+	CHECK_EQ(ReadAt<uint32_t>(block, 152), 1u);
+	CHECK(IsPadding(block, 156, 160));
+}
+
+TEST_CASE(UniformBlockPacker_ClipsToBlock) {
+	// Reflection that doesn't match the block (ex: a stale layout) must not write past the end
+	std::vector<uint8_t> block(48 + 8, PADDING);
+	float weights[3] = { 1.0f, 2.0f, 3.0f };
+	UniformBlockPacker::Write(MakeMember(ShaderDataType::Float, 16, 3, 16), weights, block.data(), 40);
+	CHECK_EQ(ReadAt<float>(block, 16), 1.0f);
+	CHECK_EQ(ReadAt<float>(block, 32), 2.0f);
+	CHECK(IsPadding(block, 40, block.size()));
+
+	bool flags[2] = { true, true };
+	UniformBlockPacker::Write(MakeMember(ShaderDataType::Bool, 0, 2, 36), flags, block.data(), 40);
+	CHECK_EQ(ReadAt<uint32_t>(block, 0), 1u);
+	CHECK_EQ(ReadAt<uint32_t>(block, 36), 1u);
+	CHECK(IsPadding(block, 40, block.size()));
+}
+
+TEST_CASE(UniformBlockPacker_TextureSlots) {
+	std::vector<std::string> names = { "s_Specular", "s_Albedo", "s_Normal", "s_Emissive" };
+	std::vector<size_t> slots = UniformBlockPacker::AssignTextureSlots(names, 8);
+	REQUIRE(slots.size() == 4u);
+	CHECK_EQ(names[slots[0]], std::string("s_Albedo"));
+	CHECK_EQ(names[slots[1]], std::string("s_Emissive"));
+	CHECK_EQ(names[slots[2]], std::string("s_Normal"));
+	CHECK_EQ(names[slots[3]], std::string("s_Specular"));
+
+	// Samplers that don't fit are left without a slot, the rest keep theirs
+	slots = UniformBlockPacker::AssignTextureSlots(names, 2);
+	REQUIRE(slots.size() == 2u);
+	CHECK_EQ(names[slots[0]], std::string("s_Albedo"));
+	CHECK_EQ(names[slots[1]], std::string("s_Emissive"));
+	CHECK(UniformBlockPacker::AssignTextureSlots({}, 8).empty());
+}
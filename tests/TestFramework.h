@@ -0,0 +1,64 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/// <summary>
+/// A minimal test harness for the headless test project. Test cases register themselves when their
+/// translation unit is loaded, and TestMain.cpp runs them all (or the ones whose names contain the first
+/// command line argument). CHECK records a failure and keeps going, REQUIRE stops the current test case
+///
+/// Tests must not touch OpenGL, there is no window or context in the test project
+/// </summary>
+namespace Testing {
+	typedef void(*TestFunction)();
+
+	struct TestCase {
+		const char*  Name;
+		const char*  File;
+		TestFunction Function;
+	};
+
+	/// <summary>
+	/// Thrown by REQUIRE to abandon the current test case
+	/// </summary>
+	struct RequireFailed { };
+
+	/// <summary>
+	/// Gets every test case that has been registered
+	/// </summary>
+	std::vector<TestCase>& GetTestCases();
+
+	/// <summary>
+	/// Records a failed check in the current test case
+	/// </summary>
+	void ReportFailure(const char* file, int line, const std::string& message);
+
+	/// <summary>
+	/// Registers a test case from a static initializer
+	/// </summary>
+	struct Registrar {
+		Registrar(const char* name, const char* file, TestFunction function) {
+			GetTestCases().push_back({ name, file, function });
+		}
+	};
+
+	template <typename TLeft, typename TRight>
+	std::string FormatComparison(const char* expression, const TLeft& left, const TRight& right) {
+		std::stringstream stream;
+		stream << expression << " (" << left << " vs " << right << ")";
+		return stream.str();
+	}
+}
+
+#define TEST_CASE(name) \
+	static void name(); \
+	static Testing::Registrar name##_registrar(#name, __FILE__, &name); \
+	static void name()
+
+#define CHECK(expr) do { if (!(expr)) { Testing::ReportFailure(__FILE__, __LINE__, #expr); } } while (0)
+#define REQUIRE(expr) do { if (!(expr)) { Testing::ReportFailure(__FILE__, __LINE__, #expr); throw Testing::RequireFailed(); } } while (0)
+#define CHECK_EQ(a, b) do { auto&& _a = (a); auto&& _b = (b); if (!(_a == _b)) { Testing::ReportFailure(__FILE__, __LINE__, Testing::FormatComparison(#a " == " #b, _a, _b)); } } while (0)
+#define CHECK_NEAR(a, b, epsilon) do { auto _a = (a); auto _b = (b); if (!(std::abs(_a - _b) <= (epsilon))) { Testing::ReportFailure(__FILE__, __LINE__, Testing::FormatComparison(#a " ~= " #b, _a, _b)); } } while (0)
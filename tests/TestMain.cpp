@@ -0,0 +1,58 @@
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <string>
+
+#include "Logging.h"
+#include "Utils/JobSystem.h"
+
+#include "TestFramework.h"
+
+namespace Testing {
+	static int _failureCount = 0;
+
+	std::vector<TestCase>& GetTestCases() {
+		// Function local so that it exists before any of the static registrars run
+		static std::vector<TestCase> testCases;
+		return testCases;
+	}
+
+	void ReportFailure(const char* file, int line, const std::string& message) {
+		printf("    %s(%d): failed %s\n", file, line, message.c_str());
+		_failureCount++;
+	}
+}
+
+int main(int argc, char** args) {
+	Logger::Init();
+	// Some of the code under test splits its work into jobs, run it on a few workers so that path is covered
+	JobSystem::Init(3);
+
+	const char* filter = argc > 1 ? args[1] : nullptr;
+	int run = 0;
+	int failed = 0;
+	for (const Testing::TestCase& test : Testing::GetTestCases()) {
+		if (filter != nullptr && strstr(test.Name, filter) == nullptr) {
+			continue;
+		}
+
+		int failuresBefore = Testing::_failureCount;
+		try {
+			test.Function();
+		} catch (const Testing::RequireFailed&) {
+			// Already reported
+		} catch (const std::exception& e) {
+			Testing::ReportFailure(test.File, 0, std::string("with exception: ") + e.what());
+		}
+		bool passed = Testing::_failureCount == failuresBefore;
+		printf("[%s] %s\n", passed ? "  OK  " : " FAIL ", test.Name);
+
+		run++;
+		failed += passed ? 0 : 1;
+	}
+	printf("%d of %d tests passed\n", run - failed, run);
+
+	JobSystem::Shutdown();
+	Logger::Uninitialize();
+	return failed;
+}
@@ -0,0 +1,229 @@
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "Graphics/VertexTypes.h"
+#include "Utils/BinaryMeshFormat.h"
+#include "Utils/FileHelpers.h"
+
+#include "TestFramework.h"
+
+namespace {
+	// A quad, with a simplified level that is just its first triangle. The mesh points into the vectors,
+	// so this is filled in place rather than returned
+	struct TestQuad {
+		std::vector<VertexPosCol> Vertices;
+		std::vector<uint16_t>     Indices;
+		BinaryMeshFormat::Mesh    Mesh;
+	};
+
+	void MakeQuad(TestQuad& result) {
+		result.Vertices = {
+			VertexPosCol(-1.0f, -2.0f, 0.5f, 1.0f, 0.0f, 0.0f),
+			VertexPosCol( 1.0f, -2.0f, 0.5f, 0.0f, 1.0f, 0.0f),
+			VertexPosCol( 1.0f,  2.0f, 0.5f, 0.0f, 0.0f, 1.0f),
+			VertexPosCol(-1.0f,  2.0f, 3.0f, 1.0f, 1.0f, 1.0f)
+		};
+		// The full quad, followed by the simplified level
+		result.Indices = { 0, 1, 2, 0, 2, 3, 0, 1, 2 };
+
+		BinaryMeshFormat::Mesh& mesh = result.Mesh;
+		mesh.VertexDeclaration = VertexPosCol::V_DECL;
+		mesh.VertexData   = reinterpret_cast<const uint8_t*>(result.Vertices.data());
+		mesh.VertexStride = sizeof(VertexPosCol);
+		mesh.NumVertices  = static_cast<uint32_t>(result.Vertices.size());
+		mesh.IndexData    = reinterpret_cast<const uint8_t*>(result.Indices.data());
+		mesh.IndicesType  = IndexType::UShort;
+		mesh.NumIndices   = static_cast<uint32_t>(result.Indices.size());
+		mesh.Lods         = { { 0, 6, 0.0f }, { 6, 3, 0.25f } };
+		mesh.Bounds       = AABB(glm::vec3(-1.0f, -2.0f, 0.5f), glm::vec3(1.0f, 2.0f, 3.0f));
+	}
+
+	template <typename T>
+	void Append(std::vector<uint8_t>& buffer, const T* data, size_t count) {
+		const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+		buffer.insert(buffer.end(), bytes, bytes + count * sizeof(T));
+	}
+
+	// Lays out the quad the way the original loader did, a header followed by tightly packed sections
+	std::vector<uint8_t> MakeV1File(const TestQuad& quad) {
+		BinaryMeshFormat::BinaryHeader header;
+		header.Version       = 0x01;
+		header.NumIndices    = 6;
+		header.IndicesType   = IndexType::UShort;
+		header.NumVertices   = static_cast<uint32_t>(quad.Vertices.size());
+		header.VertexStride  = sizeof(VertexPosCol);
+		header.NumAttributes = static_cast<uint8_t>(VertexPosCol::V_DECL.size());
+
+		std::vector<uint8_t> result;
+		Append(result, &header, 1);
+		Append(result, VertexPosCol::V_DECL.data(), VertexPosCol::V_DECL.size());
+		Append(result, quad.Indices.data(), 6);
+		Append(result, quad.Vertices.data(), quad.Vertices.size());
+		return result;
+	}
+
+	// A V2 file is a V3 file with the header cut off after the checksum, so it has no LODs or bounds. The body
+	// is the same, so the checksum still matches
+	std::vector<uint8_t> MakeV2File(const TestQuad& quad, const BinaryMeshFormat::SourceInfo& source) {
+		BinaryMeshFormat::Mesh fullDetail = quad.Mesh;
+		fullDetail.NumIndices = 6;
+		fullDetail.Lods.clear();
+		const std::vector<uint8_t> v3File = BinaryMeshFormat::Write(fullDetail, source);
+
+		BinaryMeshFormat::BinaryHeaderV3 header;
+		memcpy(&header, v3File.data(), sizeof(header));
+		const uint64_t shift = sizeof(BinaryMeshFormat::BinaryHeaderV3) - BinaryMeshFormat::V2_HEADER_SIZE;
+		header.Version    = 0x02;
+		header.HeaderSize = BinaryMeshFormat::V2_HEADER_SIZE;
+		header.AttributesOffset -= shift;
+		header.IndicesOffset    -= shift;
+		header.VerticesOffset   -= shift;
+		header.FileSize         -= shift;
+
+		std::vector<uint8_t> result(v3File.size() - shift);
+		memcpy(result.data(), &header, BinaryMeshFormat::V2_HEADER_SIZE);
+		memcpy(result.data() + BinaryMeshFormat::V2_HEADER_SIZE, v3File.data() + sizeof(header), v3File.size() - sizeof(header));
+		return result;
+	}
+
+	// Checks that a mesh read back from a file matches the full detail quad
+	void CheckMatchesQuad(const BinaryMeshFormat::Mesh& mesh, const TestQuad& quad) {
+		REQUIRE(mesh.NumVertices == quad.Vertices.size());
+		CHECK_EQ(mesh.VertexStride, (uint32_t)sizeof(VertexPosCol));
+		CHECK(mesh.IndicesType == IndexType::UShort);
+		REQUIRE(mesh.VertexDeclaration.size() == VertexPosCol::V_DECL.size());
+		for (size_t ix = 0; ix < mesh.VertexDeclaration.size(); ix++) {
+			CHECK_EQ(mesh.VertexDeclaration[ix].Slot, VertexPosCol::V_DECL[ix].Slot);
+			CHECK_EQ(mesh.VertexDeclaration[ix].Offset, VertexPosCol::V_DECL[ix].Offset);
+		}
+		CHECK(memcmp(mesh.VertexData, quad.Vertices.data(), quad.Vertices.size() * sizeof(VertexPosCol)) == 0);
+		REQUIRE(!mesh.Lods.empty());
+		CHECK_EQ(mesh.Lods[0].FirstIndex, 0u);
+		CHECK_EQ(mesh.Lods[0].NumIndices, 6u);
+		CHECK(memcmp(mesh.IndexData, quad.Indices.data(), 6 * sizeof(uint16_t)) == 0);
+		CHECK_NEAR(mesh.Bounds.Min.x, -1.0f, 0.0f);
+		CHECK_NEAR(mesh.Bounds.Min.z, 0.5f, 0.0f);
+		CHECK_NEAR(mesh.Bounds.Max.y, 2.0f, 0.0f);
+		CHECK_NEAR(mesh.Bounds.Max.z, 3.0f, 0.0f);
+	}
+
+	std::string TempPath(const std::string& name) {
+		return (std::filesystem::temp_directory_path() / name).string();
+	}
+}
+
+TEST_CASE(BinaryMeshFormat_RoundTripV3) {
+	TestQuad quad;
+	MakeQuad(quad);
+	BinaryMeshFormat::SourceInfo source;
+	source.Hash = 0x0123456789ABCDEF;
+	source.Size = 1234;
+	source.Timestamp = -42;
+	std::vector<uint8_t> file = BinaryMeshFormat::Write(quad.Mesh, source);
+
+	BinaryMeshFormat::Mesh mesh;
+	REQUIRE(BinaryMeshFormat::Read(file.data(), file.size(), mesh));
+	CheckMatchesQuad(mesh, quad);
+	CHECK_EQ(mesh.NumIndices, 9u);
+	REQUIRE(mesh.Lods.size() == 2);
+	CHECK_EQ(mesh.Lods[1].FirstIndex, 6u);
+	CHECK_EQ(mesh.Lods[1].NumIndices, 3u);
+	CHECK_NEAR(mesh.Lods[1].Error, 0.25f, 0.0f);
+
+	// Every section is aligned, so the index and vertex data can go straight to OpenGL
+	CHECK((mesh.IndexData - file.data()) % BinaryMeshFormat::SECTION_ALIGNMENT == 0);
+	CHECK((mesh.VertexData - file.data()) % BinaryMeshFormat::SECTION_ALIGNMENT == 0);
+
+	BinaryMeshFormat::SourceInfo stored;
+	REQUIRE(BinaryMeshFormat::ReadSourceInfo(file.data(), file.size(), stored));
+	CHECK_EQ(stored.Hash, source.Hash);
+	CHECK_EQ(stored.Size, source.Size);
+	CHECK_EQ(stored.Timestamp, source.Timestamp);
+}
+
+TEST_CASE(BinaryMeshFormat_RejectsBadMagicOrVersion) {
+	TestQuad quad;
+	MakeQuad(quad);
+	const std::vector<uint8_t> file = BinaryMeshFormat::Write(quad.Mesh, BinaryMeshFormat::SourceInfo());
+	BinaryMeshFormat::Mesh mesh;
+	BinaryMeshFormat::SourceInfo source;
+
+	std::vector<uint8_t> badMagic = file;
+	badMagic[0] = 'X';
+	CHECK(!BinaryMeshFormat::Read(badMagic.data(), badMagic.size(), mesh));
+	CHECK(!BinaryMeshFormat::ReadSourceInfo(badMagic.data(), badMagic.size(), source));
+
+	std::vector<uint8_t> badVersion = file;
+	const uint16_t version = 0x07;
+	memcpy(badVersion.data() + offsetof(BinaryMeshFormat::BinaryHeaderV3, Version), &version, sizeof(version));
+	CHECK(!BinaryMeshFormat::Read(badVersion.data(), badVersion.size(), mesh));
+	CHECK(!BinaryMeshFormat::ReadSourceInfo(badVersion.data(), badVersion.size(), source));
+
+	// Files that end partway through a header are rejected rather than read past the end
+	CHECK(!BinaryMeshFormat::Read(file.data(), 3, mesh));
+	CHECK(!BinaryMeshFormat::Read(file.data(), sizeof(BinaryMeshFormat::BinaryHeaderV3) - 1, mesh));
+	CHECK(!BinaryMeshFormat::ReadSourceInfo(file.data(), sizeof(BinaryMeshFormat::BinaryHeaderV3) - 1, source));
+}
+
+TEST_CASE(BinaryMeshFormat_RejectsChecksumMismatch) {
+	TestQuad quad;
+	MakeQuad(quad);
+	const std::vector<uint8_t> file = BinaryMeshFormat::Write(quad.Mesh, BinaryMeshFormat::SourceInfo());
+	BinaryMeshFormat::Mesh mesh;
+
+	// The header is still valid, only the checksum can catch this
+	std::vector<uint8_t> corrupt = file;
+	corrupt.back() ^= 0xFF;
+	CHECK(!BinaryMeshFormat::Read(corrupt.data(), corrupt.size(), mesh));
+
+	// A truncated file fails the header's size check before the checksum is even looked at
+	CHECK(!BinaryMeshFormat::Read(file.data(), file.size() - 1, mesh));
+}
+
+TEST_CASE(BinaryMeshFormat_OlderVersionsAreRebuilt) {
+	TestQuad quad;
+	MakeQuad(quad);
+	std::string sourcePath = TempPath("binary-mesh-format-test.obj");
+	std::string binPath = TempPath("binary-mesh-format-test.bin");
+	FileHelpers::WriteContentsToFile(sourcePath, "v 0 0 0\nv 1 0 0\nv 0 1 0\nf 1 2 3\n");
+
+	BinaryMeshFormat::SourceInfo source;
+	REQUIRE(BinaryMeshFormat::GetSourceInfo(sourcePath, source));
+	const std::vector<uint8_t> v3File = BinaryMeshFormat::Write(quad.Mesh, source);
+	const std::vector<uint8_t> v2File = MakeV2File(quad, source);
+	const std::vector<uint8_t> v1File = MakeV1File(quad);
+
+	// Older files can still be read, they just don't know their bounds so they are calculated from the vertices
+	BinaryMeshFormat::Mesh mesh;
+	REQUIRE(BinaryMeshFormat::Read(v1File.data(), v1File.size(), mesh));
+	CheckMatchesQuad(mesh, quad);
+	CHECK_EQ(mesh.Lods.size(), (size_t)1);
+	REQUIRE(BinaryMeshFormat::Read(v2File.data(), v2File.size(), mesh));
+	CheckMatchesQuad(mesh, quad);
+	CHECK_EQ(mesh.Lods.size(), (size_t)1);
+
+	// But since they are missing LODs and source info, they are never current and get regenerated
+	BinaryMeshFormat::WriteFile(binPath, v1File);
+	CHECK(!BinaryMeshFormat::IsFileCurrent(binPath, sourcePath));
+	BinaryMeshFormat::WriteFile(binPath, v2File);
+	CHECK(!BinaryMeshFormat::IsFileCurrent(binPath, sourcePath));
+	BinaryMeshFormat::WriteFile(binPath, v3File);
+	CHECK(BinaryMeshFormat::IsFileCurrent(binPath, sourcePath));
+
+	// Changing the source makes the current version stale as well
+	FileHelpers::WriteContentsToFile(sourcePath, "v 0 0 0\nv 2 0 0\nv 0 2 0\nf 1 2 3\n", true);
+	CHECK(!BinaryMeshFormat::IsFileCurrent(binPath, sourcePath));
+
+	// Every write went through its own temporary file, and none of them were left behind
+	size_t leftovers = 0;
+	for (const auto& entry : std::filesystem::directory_iterator(std::filesystem::temp_directory_path())) {
+		leftovers += entry.path().filename().string().rfind("binary-mesh-format-test.bin.", 0) == 0 ? 1 : 0;
+	}
+	CHECK_EQ(leftovers, (size_t)0);
+
+	std::filesystem::remove(sourcePath);
+	std::filesystem::remove(binPath);
+}
@@ -0,0 +1,153 @@
+#include <algorithm>
+#include <random>
+#include <vector>
+#include <GLM/glm.hpp>
+#include <GLM/gtc/matrix_transform.hpp>
+
+#include "Utils/DynamicBvh.h"
+
+#include "TestFramework.h"
+
+namespace {
+	struct TestObject {
+		AABB     Bounds;
+		uint32_t Proxy = DynamicBvh::NULL_NODE;
+	};
+
+	AABB RandomBox(std::mt19937& random) {
+		std::uniform_real_distribution<float> position(-200.0f, 200.0f);
+		std::uniform_real_distribution<float> size(0.1f, 5.0f);
+		glm::vec3 min = glm::vec3(position(random), position(random) * 0.1f, position(random));
+		return AABB(min, min + glm::vec3(size(random), size(random), size(random)));
+	}
+
+	Frustum RandomFrustum(std::mt19937& random) {
+		std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+		glm::vec3 eye = glm::vec3(unit(random) * 200.0f - 100.0f, 5.0f, unit(random) * 200.0f - 100.0f);
+		float angle = unit(random) * 6.2831853f;
+		glm::mat4 view = glm::lookAt(eye, eye + glm::vec3(std::cos(angle), -0.1f, std::sin(angle)), glm::vec3(0.0f, 1.0f, 0.0f));
+		glm::mat4 projection = glm::perspective(glm::radians(30.0f + unit(random) * 60.0f), 16.0f / 9.0f, 0.1f, 50.0f + unit(random) * 150.0f);
+		return Frustum(projection * view);
+	}
+
+	// Compares a BVH query against testing every object's fat bounds on its own
+	void CheckAgainstBruteForce(const DynamicBvh& bvh, const std::vector<TestObject>& objects, const Frustum& frustum) {
+		std::vector<const TestObject*> found;
+		bvh.Query(frustum, [&](void* userData) { found.push_back(static_cast<const TestObject*>(userData)); });
+		std::sort(found.begin(), found.end());
+		CHECK(std::adjacent_find(found.begin(), found.end()) == found.end());
+
+		std::vector<const TestObject*> expected;
+		for (const TestObject& object : objects) {
+			if (object.Proxy == DynamicBvh::NULL_NODE) {
+				continue;
+			}
+			if (frustum.Test(bvh.GetFatBounds(object.Proxy)) != FrustumTest::Outside) {
+				expected.push_back(&object);
+			}
+			// The real bounds are inside the fat bounds, so nothing that is actually visible can be missed
+			if (frustum.Test(object.Bounds) != FrustumTest::Outside) {
+				CHECK(std::binary_search(found.begin(), found.end(), &object));
+			}
+		}
+		CHECK_EQ(found.size(), expected.size());
+		CHECK(found == expected);
+	}
+}
+
+TEST_CASE(DynamicBvh_QueryMatchesBruteForce) {
+	std::mt19937 random(5);
+	DynamicBvh bvh;
+	std::vector<TestObject> objects(2000);
+	for (TestObject& object : objects) {
+		object.Bounds = RandomBox(random);
+		object.Proxy = bvh.Insert(object.Bounds, &object);
+	}
+	CHECK_EQ(bvh.GetProxyCount(), 2000u);
+	// AVL balancing keeps the tree shallow, a perfectly balanced tree of 2000 leaves has a height of 11
+	CHECK(bvh.GetHeight() <= 22);
+
+	for (int ix = 0; ix < 50; ix++) {
+		CheckAgainstBruteForce(bvh, objects, RandomFrustum(random));
+	}
+}
+
+TEST_CASE(DynamicBvh_QueryAfterUpdatesAndRemoves) {
+	std::mt19937 random(11);
+	std::uniform_real_distribution<float> nudge(-0.05f, 0.05f);
+	std::uniform_real_distribution<float> jump(-20.0f, 20.0f);
+	DynamicBvh bvh(0.1f);
+	std::vector<TestObject> objects(1000);
+	for (TestObject& object : objects) {
+		object.Bounds = RandomBox(random);
+		object.Proxy = bvh.Insert(object.Bounds, &object);
+	}
+
+	uint32_t reinserted = 0;
+	for (int frame = 0; frame < 20; frame++) {
+		for (TestObject& object : objects) {
+			if (object.Proxy == DynamicBvh::NULL_NODE) {
+				if (random() % 10 == 0) {
+					object.Bounds = RandomBox(random);
+					object.Proxy = bvh.Insert(object.Bounds, &object);
+				}
+				continue;
+			}
+			switch (random() % 10) {
+				case 0:
+					bvh.Remove(object.Proxy);
+					object.Proxy = DynamicBvh::NULL_NODE;
+					break;
+				case 1: {
+					glm::vec3 offset = glm::vec3(jump(random), 0.0f, jump(random));
+					object.Bounds = AABB(object.Bounds.Min + offset, object.Bounds.Max + offset);
+					reinserted += bvh.Update(object.Proxy, object.Bounds) ? 1 : 0;
+					break;
+				}
+				default: {
+					// Small moves stay inside the fat bounds, and shouldn't touch the tree
+					glm::vec3 offset = glm::vec3(nudge(random), nudge(random), nudge(random));
+					object.Bounds = AABB(object.Bounds.Min + offset, object.Bounds.Max + offset);
+					if (bvh.GetFatBounds(object.Proxy).Contains(object.Bounds)) {
+						CHECK(!bvh.Update(object.Proxy, object.Bounds));
+					} else {
+						reinserted += bvh.Update(object.Proxy, object.Bounds) ? 1 : 0;
+					}
+					break;
+				}
+			}
+			if (object.Proxy != DynamicBvh::NULL_NODE) {
+				CHECK(bvh.GetFatBounds(object.Proxy).Contains(object.Bounds));
+				CHECK(bvh.GetUserData(object.Proxy) == &object);
+			}
+		}
+		CheckAgainstBruteForce(bvh, objects, RandomFrustum(random));
+	}
+	CHECK(reinserted > 0);
+
+	uint32_t alive = static_cast<uint32_t>(std::count_if(objects.begin(), objects.end(), [](const TestObject& object) { return object.Proxy != DynamicBvh::NULL_NODE; }));
+	CHECK_EQ(bvh.GetProxyCount(), alive);
+
+	bvh.Clear();
+	CHECK_EQ(bvh.GetProxyCount(), 0u);
+	CHECK_EQ(bvh.Query(RandomFrustum(random), [](void*) { CHECK(false); }), 0u);
+}
+
+TEST_CASE(DynamicBvh_HierarchyPrunesTests) {
+	std::mt19937 random(3);
+	DynamicBvh bvh;
+	std::vector<TestObject> objects(4000);
+	for (TestObject& object : objects) {
+		object.Bounds = RandomBox(random);
+		object.Proxy = bvh.Insert(object.Bounds, &object);
+	}
+
+	// A narrow view only covers a small part of the scene, so most of the tree should be skipped
+	glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 5.0f, 0.0f), glm::vec3(1.0f, 5.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	Frustum frustum(glm::perspective(glm::radians(20.0f), 1.0f, 0.1f, 60.0f) * view);
+	uint32_t found = 0;
+	uint32_t tested = bvh.Query(frustum, [&](void*) { found++; });
+	CHECK(found > 0);
+	CHECK(tested < objects.size() / 4);
+	CheckAgainstBruteForce(bvh, objects, frustum);
+}
@@ -0,0 +1,113 @@
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+#include "Utils/JobSystem.h"
+
+#include "TestFramework.h"
+
+// Scene defers object creation and removal while in a job, so every batch of a ParallelFor has to agree on
+// IsInJob(), whether or not the range was big enough to be split up
+TEST_CASE(JobSystem_ParallelForBodiesAreInJob) {
+	CHECK(!JobSystem::IsInJob());
+
+	for (size_t count : { size_t(1), size_t(64), size_t(1000) }) {
+		std::atomic<uint32_t> batches = 0;
+		std::atomic<uint32_t> batchesInJob = 0;
+		JobSystem::ParallelFor(count, 64, [&](size_t begin, size_t end) {
+			batches++;
+			batchesInJob += JobSystem::IsInJob() ? 1 : 0;
+		});
+		CHECK_EQ(batches.load(), static_cast<uint32_t>((count + 63) / 64));
+		CHECK_EQ(batchesInJob.load(), batches.load());
+		CHECK(!JobSystem::IsInJob());
+	}
+}
+
+// Gives every index its own hit count, so that visiting an index twice is caught as well as missing it
+static std::unique_ptr<std::atomic<uint32_t>[]> MakeHits(size_t count) {
+	std::unique_ptr<std::atomic<uint32_t>[]> hits(new std::atomic<uint32_t>[count == 0 ? 1 : count]);
+	for (size_t ix = 0; ix < count; ix++) {
+		hits[ix] = 0;
+	}
+	return hits;
+}
+
+TEST_CASE(JobSystem_RunThenWait) {
+	const size_t count = 500;
+	std::unique_ptr<std::atomic<uint32_t>[]> hits = MakeHits(count);
+
+	JobSystem::Counter counter;
+	CHECK(counter.IsDone());
+	for (size_t ix = 0; ix < count; ix++) {
+		JobSystem::Run([&hits, ix]() { hits[ix]++; }, &counter);
+	}
+	JobSystem::Wait(counter);
+
+	CHECK(counter.IsDone());
+	for (size_t ix = 0; ix < count; ix++) {
+		CHECK_EQ(hits[ix].load(), 1u);
+	}
+}
+
+// Jobs that wait on their own child jobs must help run them rather than block, otherwise once every
+// worker is waiting nothing is left to run the children
+TEST_CASE(JobSystem_NestedWaitDoesNotDeadlock) {
+	const size_t outerCount = 16;
+	const size_t innerCount = 32;
+	std::unique_ptr<std::atomic<uint32_t>[]> hits = MakeHits(outerCount * innerCount);
+	std::atomic<uint32_t> finishedOuter = 0;
+
+	JobSystem::Counter counter;
+	for (size_t outer = 0; outer < outerCount; outer++) {
+		JobSystem::Run([&hits, &finishedOuter, outer, innerCount]() {
+			JobSystem::Counter inner;
+			for (size_t ix = 0; ix < innerCount; ix++) {
+				JobSystem::Run([&hits, outer, ix, innerCount]() { hits[outer * innerCount + ix]++; }, &inner);
+			}
+			JobSystem::Wait(inner);
+			finishedOuter++;
+		}, &counter);
+	}
+	JobSystem::Wait(counter);
+
+	CHECK(counter.IsDone());
+	CHECK_EQ(finishedOuter.load(), static_cast<uint32_t>(outerCount));
+	for (size_t ix = 0; ix < outerCount * innerCount; ix++) {
+		CHECK_EQ(hits[ix].load(), 1u);
+	}
+}
+
+TEST_CASE(JobSystem_ParallelForVisitsEveryIndexOnce) {
+	const size_t batchSize = 64;
+	// Smaller than, equal to, a multiple of, and not a multiple of the batch size
+	for (size_t count : { size_t(1), size_t(37), batchSize, batchSize * 4, batchSize * 4 + 5, size_t(1000) }) {
+		std::unique_ptr<std::atomic<uint32_t>[]> hits = MakeHits(count);
+		std::atomic<uint32_t> outOfRange = 0;
+		JobSystem::ParallelFor(count, batchSize, [&](size_t begin, size_t end) {
+			if (begin >= end || end > count || end - begin > batchSize) {
+				outOfRange++;
+				return;
+			}
+			for (size_t ix = begin; ix < end; ix++) {
+				hits[ix]++;
+			}
+		});
+
+		CHECK_EQ(outOfRange.load(), 0u);
+		uint32_t wrongCount = 0;
+		for (size_t ix = 0; ix < count; ix++) {
+			wrongCount += hits[ix].load() != 1 ? 1 : 0;
+		}
+		CHECK_EQ(wrongCount, 0u);
+	}
+}
+
+TEST_CASE(JobSystem_ParallelForEmptyRange) {
+	std::atomic<uint32_t> batches = 0;
+	JobSystem::ParallelFor(0, 64, [&](size_t begin, size_t end) {
+		batches++;
+	});
+	CHECK_EQ(batches.load(), 0u);
+	CHECK(!JobSystem::IsInJob());
+}
@@ -0,0 +1,148 @@
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Utils/MeshOptimizer.h"
+#include "Utils/ParallelObjParser.h"
+
+#include "TestFramework.h"
+#include "Utils/ObjTestData.h"
+
+namespace {
+	// Each triangle rotated so its smallest index is first, sorted, so we can compare meshes regardless of
+	// triangle order while still catching flipped winding
+	std::vector<glm::uvec3> CanonicalTriangles(const std::vector<uint32_t>& indices) {
+		std::vector<glm::uvec3> result;
+		for (size_t ix = 0; ix + 2 < indices.size(); ix += 3) {
+			glm::uvec3 tri(indices[ix], indices[ix + 1], indices[ix + 2]);
+			while (tri.x > tri.y || tri.x > tri.z) {
+				tri = glm::uvec3(tri.y, tri.z, tri.x);
+			}
+			result.push_back(tri);
+		}
+		std::sort(result.begin(), result.end(), [](const glm::uvec3& a, const glm::uvec3& b) {
+			return a.x != b.x ? a.x < b.x : a.y != b.y ? a.y < b.y : a.z < b.z;
+		});
+		return result;
+	}
+
+	// A grid mesh with its triangles in a random order, which is about as bad as an exported mesh gets
+	ParallelObjParser::Result MakeShuffledGrid(uint32_t size, uint32_t seed) {
+		std::string text = MakeGridObj(size);
+		ParallelObjParser::Result result;
+		ParallelObjParser::Parse(text.data(), text.size(), result, 1);
+
+		std::vector<glm::uvec3> triangles;
+		for (size_t ix = 0; ix < result.Indices.size(); ix += 3) {
+			triangles.emplace_back(result.Indices[ix], result.Indices[ix + 1], result.Indices[ix + 2]);
+		}
+		std::shuffle(triangles.begin(), triangles.end(), std::mt19937(seed));
+		result.Indices.clear();
+		for (const glm::uvec3& tri : triangles) {
+			result.Indices.insert(result.Indices.end(), { tri.x, tri.y, tri.z });
+		}
+		return result;
+	}
+}
+
+TEST_CASE(MeshOptimizer_CalculateACMR) {
+	// Every vertex of a lone triangle has to be transformed
+	CHECK_NEAR(MeshOptimizer::CalculateACMR({ 0, 1, 2 }, 3), 3.0f, 1e-6f);
+	// A quad shares two vertices between its triangles
+	CHECK_NEAR(MeshOptimizer::CalculateACMR({ 0, 1, 2, 0, 2, 3 }, 4), 2.0f, 1e-6f);
+	// With a cache of 3, drawing the same triangle twice in a row is free, but a FIFO doesn't refresh on a hit
+	CHECK_NEAR(MeshOptimizer::CalculateACMR({ 0, 1, 2, 0, 1, 2 }, 3, 3), 1.5f, 1e-6f);
+	CHECK_NEAR(MeshOptimizer::CalculateACMR({ 0, 1, 2, 3, 4, 5, 0, 1, 2 }, 6, 3), 3.0f, 1e-6f);
+	CHECK_NEAR(MeshOptimizer::CalculateACMR({}, 0), 0.0f, 1e-6f);
+}
+
+TEST_CASE(MeshOptimizer_VertexCacheLowersACMR) {
+	ParallelObjParser::Result grid = MakeShuffledGrid(64, 3);
+	const size_t vertexCount = grid.Vertices.size();
+	std::vector<uint32_t> indices = grid.Indices;
+
+	float before = MeshOptimizer::CalculateACMR(indices, vertexCount);
+	MeshOptimizer::OptimizeVertexCache(indices, vertexCount);
+	float after = MeshOptimizer::CalculateACMR(indices, vertexCount);
+
+	// A regular grid approaches 0.5 with a perfect order, Forsyth's algorithm should land within reach of that
+	CHECK(before > 2.0f);
+	CHECK(after < 0.75f);
+	CHECK(CanonicalTriangles(indices) == CanonicalTriangles(grid.Indices));
+
+	// Running it again on an already optimized mesh shouldn't make it any worse
+	std::vector<uint32_t> again = indices;
+	MeshOptimizer::OptimizeVertexCache(again, vertexCount);
+	CHECK(MeshOptimizer::CalculateACMR(again, vertexCount) <= after + 0.01f);
+}
+
+TEST_CASE(MeshOptimizer_OverdrawKeepsACMR) {
+	ParallelObjParser::Result grid = MakeShuffledGrid(64, 5);
+	const size_t vertexCount = grid.Vertices.size();
+	std::vector<uint32_t> indices = grid.Indices;
+	MeshOptimizer::OptimizeVertexCache(indices, vertexCount);
+	float cacheOptimized = MeshOptimizer::CalculateACMR(indices, vertexCount);
+
+	MeshOptimizer::OptimizeOverdraw(indices, grid.Positions.data(), sizeof(glm::vec3), grid.Positions.size());
+	// Clusters are only split where the cache would have been flushed anyways, so at most the first
+	// vertices of each cluster can change from a miss to a hit or back
+	CHECK(MeshOptimizer::CalculateACMR(indices, vertexCount) <= cacheOptimized * 1.02f);
+	CHECK(CanonicalTriangles(indices) == CanonicalTriangles(grid.Indices));
+}
+
+// The exported meshes in res/ already have some locality, so this checks that the optimizer never makes a
+// real mesh worse, not just that it fixes a shuffled one
+TEST_CASE(MeshOptimizer_ResMeshesDontGetWorse) {
+	std::vector<std::string> files = FindResObjFiles();
+	REQUIRE(files.size() >= 6);
+
+	for (const std::string& path : files) {
+		ParallelObjParser::Result obj;
+		REQUIRE(ParallelObjParser::ParseFile(path, obj));
+		const size_t vertexCount = obj.Vertices.size();
+		std::vector<glm::vec3> positions;
+		positions.reserve(vertexCount);
+		for (const glm::ivec3& vertex : obj.Vertices) {
+			positions.push_back(obj.Positions[vertex.x]);
+		}
+
+		std::vector<uint32_t> indices = obj.Indices;
+		float before = MeshOptimizer::CalculateACMR(indices, vertexCount);
+		MeshOptimizer::OptimizeVertexCache(indices, vertexCount);
+		float cacheOptimized = MeshOptimizer::CalculateACMR(indices, vertexCount);
+		CHECK(cacheOptimized <= before);
+		CHECK(CanonicalTriangles(indices) == CanonicalTriangles(obj.Indices));
+
+		MeshOptimizer::OptimizeOverdraw(indices, positions.data(), sizeof(glm::vec3), vertexCount);
+		float overdrawOptimized = MeshOptimizer::CalculateACMR(indices, vertexCount);
+		CHECK(overdrawOptimized <= before);
+		CHECK(overdrawOptimized <= cacheOptimized * 1.02f);
+		CHECK(CanonicalTriangles(indices) == CanonicalTriangles(obj.Indices));
+	}
+}
+
+TEST_CASE(MeshOptimizer_VertexFetchOrdersByFirstUse) {
+	// Vertex 4 is never used, and everything else is used in reverse order
+	std::vector<uint32_t> indices = { 5, 3, 2, 2, 3, 1, 1, 3, 0 };
+	const std::vector<uint32_t> original = indices;
+	size_t newVertexCount = 0;
+	std::vector<uint32_t> remap = MeshOptimizer::OptimizeVertexFetch(indices, 6, newVertexCount);
+
+	CHECK_EQ(newVertexCount, 5u);
+	REQUIRE(remap.size() == 6);
+	CHECK_EQ(remap[4], ~0u);
+	CHECK(indices == std::vector<uint32_t>({ 0, 1, 2, 2, 1, 3, 3, 1, 4 }));
+	for (size_t ix = 0; ix < indices.size(); ix++) {
+		CHECK_EQ(remap[original[ix]], indices[ix]);
+	}
+
+	// Fetch order doesn't affect the transform cache at all
+	ParallelObjParser::Result grid = MakeShuffledGrid(32, 7);
+	std::vector<uint32_t> gridIndices = grid.Indices;
+	float before = MeshOptimizer::CalculateACMR(gridIndices, grid.Vertices.size());
+	MeshOptimizer::OptimizeVertexFetch(gridIndices, grid.Vertices.size(), newVertexCount);
+	CHECK_EQ(newVertexCount, grid.Vertices.size());
+	CHECK_NEAR(MeshOptimizer::CalculateACMR(gridIndices, newVertexCount), before, 1e-6f);
+}
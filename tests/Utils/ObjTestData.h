@@ -0,0 +1,180 @@
+#pragma once
+#include <cstdint>
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <istream>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Utils/ParallelObjParser.h"
+#include "Utils/StringUtils.h"
+
+/// <summary>
+/// The parsing loop from the iostream based ObjLoader that ParallelObjParser replaced, kept as-is
+/// (minus building the mesh) so we can check that the new parser gives the same results, and see
+/// how much faster it is. Vertices are stored exactly like the old loader stored them, as the raw
+/// indices minus one
+/// </summary>
+inline void LegacyParseObj(std::istream& file, ParallelObjParser::Result& result) {
+	result = ParallelObjParser::Result();
+	std::vector<glm::vec3>&  positions = result.Positions;
+	std::vector<glm::vec3>&  normals = result.Normals;
+	std::vector<glm::vec2>&  uvs = result.UVs;
+	std::vector<glm::ivec3>& vertices = result.Vertices;
+	std::vector<uint32_t>&   indices = result.Indices;
+
+	std::unordered_map<uint64_t, uint32_t> vertexMap;
+
+	std::string line;
+	glm::vec3 vecData;
+	glm::ivec3 vertexIndices;
+
+	while (file.peek() != EOF) {
+		std::string command;
+		file >> command;
+
+		if (command == "#") {
+			std::getline(file, line);
+		}
+		else if (command == "v") {
+			file >> vecData.x >> vecData.y >> vecData.z;
+			positions.push_back(vecData);
+		}
+		else if (command == "vn") {
+			file >> vecData.x >> vecData.y >> vecData.z;
+			normals.push_back(vecData);
+		}
+		else if (command == "vt") {
+			file >> vecData.x >> vecData.y;
+			uvs.push_back(glm::vec2(vecData));
+		}
+		else if (command == "f") {
+			std::getline(file, line);
+			StringTools::Trim(line);
+			std::stringstream stream = std::stringstream(line);
+
+			uint32_t edges[4];
+			int ix = 0;
+			for (; ix < 4; ix++) {
+				if (stream.peek() != EOF) {
+					char tempChar;
+					vertexIndices = glm::ivec3(0);
+					stream >> vertexIndices.x >> tempChar >> vertexIndices.y >> tempChar >> vertexIndices.z;
+					if (vertexIndices.x < 0) { vertexIndices.x = positions.size() + 1 + vertexIndices.x; }
+					if (vertexIndices.y < 0) { vertexIndices.y = uvs.size() + 1 + vertexIndices.y; }
+					if (vertexIndices.z < 0) { vertexIndices.z = normals.size() + 1 + vertexIndices.z; }
+
+					const uint64_t mask = 0b0'000000000000000000000'000000000000000000000'111111111111111111111;
+					uint64_t key = ((vertexIndices.x & mask) << 42) | ((vertexIndices.y & mask) << 21) | (vertexIndices.z & mask);
+
+					auto it = vertexMap.find(key);
+					if (it != vertexMap.end()) {
+						edges[ix] = it->second;
+					} else {
+						vertices.push_back(vertexIndices - glm::ivec3(1));
+						uint32_t index = static_cast<uint32_t>(vertices.size()) - 1;
+						vertexMap[key] = index;
+						edges[ix] = index;
+					}
+				}
+				else { break; }
+			}
+
+			if (ix == 3) {
+				indices.push_back(edges[0]);
+				indices.push_back(edges[1]);
+				indices.push_back(edges[2]);
+			}
+			else if (ix == 4) {
+				indices.push_back(edges[0]);
+				indices.push_back(edges[1]);
+				indices.push_back(edges[2]);
+
+				indices.push_back(edges[0]);
+				indices.push_back(edges[2]);
+				indices.push_back(edges[3]);
+			}
+		}
+	}
+}
+
+/// <summary>
+/// Generates the text of an OBJ file for a size x size grid of quads, laid out like a typical export with
+/// every attribute specified. Rows are written one at a time, with each row's faces right after its
+/// vertices, so the file mixes every line type the whole way through. Every other row uses relative
+/// (negative) indices, and odd columns are split into two triangles instead of a quad
+/// </summary>
+inline std::string MakeGridObj(uint32_t size, bool windowsLineEndings = false) {
+	const char* eol = windowsLineEndings ? "\r\n" : "\n";
+	std::string result;
+	result.reserve(static_cast<size_t>(size + 1) * (size + 1) * 160);
+	char line[160];
+	auto append = [&](int length) { result.append(line, length); result += eol; };
+
+	result += "# Generated grid"; result += eol;
+	result += "mtllib grid.mtl"; result += eol;
+	result += "o Grid"; result += eol;
+	for (uint32_t row = 0; row <= size; row++) {
+		for (uint32_t col = 0; col <= size; col++) {
+			float x = col / static_cast<float>(size) * 2.0f - 1.0f;
+			float z = row / static_cast<float>(size) * 2.0f - 1.0f;
+			float y = 0.25f * x * z;
+			append(snprintf(line, sizeof(line), "v %.6f %.6f %.6f", x, y, z));
+			append(snprintf(line, sizeof(line), "vt %.6f %.6f", col / static_cast<float>(size), row / static_cast<float>(size)));
+			append(snprintf(line, sizeof(line), "vn %.6f %.6f %.6f", -0.25f * z, 1.0f, -0.25f * x));
+		}
+		if (row == 0) {
+			result += "usemtl Material"; result += eol;
+			result += "s off"; result += eol;
+			continue;
+		}
+
+		// Attributes are interleaved, so every corner uses the same index for all three of them
+		const int32_t stride = static_cast<int32_t>(size) + 1;
+		const int32_t total = static_cast<int32_t>((row + 1) * stride);
+		for (uint32_t col = 0; col < size; col++) {
+			int32_t corners[4] = {
+				static_cast<int32_t>((row - 1) * stride + col) + 1,
+				static_cast<int32_t>(row * stride + col) + 1,
+				static_cast<int32_t>(row * stride + col + 1) + 1,
+				static_cast<int32_t>((row - 1) * stride + col + 1) + 1
+			};
+			if (row % 2 == 1) {
+				for (int32_t& corner : corners) {
+					corner -= total + 1;
+				}
+			}
+			if (col % 2 == 0) {
+				append(snprintf(line, sizeof(line), "f %d/%d/%d %d/%d/%d %d/%d/%d %d/%d/%d",
+					corners[0], corners[0], corners[0], corners[1], corners[1], corners[1],
+					corners[2], corners[2], corners[2], corners[3], corners[3], corners[3]));
+			} else {
+				append(snprintf(line, sizeof(line), "f %d/%d/%d %d/%d/%d %d/%d/%d",
+					corners[0], corners[0], corners[0], corners[1], corners[1], corners[1], corners[2], corners[2], corners[2]));
+				append(snprintf(line, sizeof(line), "f %d/%d/%d %d/%d/%d %d/%d/%d",
+					corners[0], corners[0], corners[0], corners[2], corners[2], corners[2], corners[3], corners[3], corners[3]));
+			}
+		}
+	}
+	return result;
+}
+
+/// <summary>
+/// Gets the paths of the OBJ files that ship in res/, sorted by name. The tests and benchmarks are run from
+/// the project directory, so this is empty if they are run from anywhere else
+/// </summary>
+inline std::vector<std::string> FindResObjFiles() {
+	std::vector<std::string> result;
+	if (std::filesystem::is_directory("res")) {
+		for (const auto& entry : std::filesystem::directory_iterator("res")) {
+			if (entry.is_regular_file() && entry.path().extension() == ".obj") {
+				result.push_back(entry.path().string());
+			}
+		}
+	}
+	std::sort(result.begin(), result.end());
+	return result;
+}
@@ -0,0 +1,212 @@
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "Utils/ParallelObjParser.h"
+#include "Utils/ObjLoader.h"
+#include "Utils/MeshFactory.h"
+
+#include "TestFramework.h"
+#include "Utils/ObjTestData.h"
+
+namespace {
+	// Compares the raw bytes, so -0.0 vs 0.0 or a 1 ulp rounding difference would still fail
+	template <typename T>
+	bool BytesEqual(const std::vector<T>& a, const std::vector<T>& b) {
+		return a.size() == b.size() && (a.empty() || memcmp(a.data(), b.data(), a.size() * sizeof(T)) == 0);
+	}
+
+	void CheckSameResult(const ParallelObjParser::Result& a, const ParallelObjParser::Result& b) {
+		CHECK(BytesEqual(a.Positions, b.Positions));
+		CHECK(BytesEqual(a.UVs, b.UVs));
+		CHECK(BytesEqual(a.Normals, b.Normals));
+		CHECK(BytesEqual(a.Vertices, b.Vertices));
+		CHECK(BytesEqual(a.Indices, b.Indices));
+	}
+
+	ParallelObjParser::Result ParseLegacy(const std::string& text) {
+		std::istringstream stream(text, std::ios::binary);
+		ParallelObjParser::Result result;
+		LegacyParseObj(stream, result);
+		return result;
+	}
+
+	ParallelObjParser::Result Parse(const std::string& text, uint32_t maxThreads = 1) {
+		ParallelObjParser::Result result;
+		ParallelObjParser::Parse(text.data(), text.size(), result, maxThreads);
+		return result;
+	}
+
+	// The old loaders' !=0 test, except for indices they read out of bounds (the -1 for the attributes
+	// of the lone vertex a p//n face leaves behind), which were undefined and get the default here
+	template <typename T>
+	T LegacyAttribute(const std::vector<T>& attributes, int index, const T& fallback) {
+		return index > 0 && index < static_cast<int>(attributes.size()) ? attributes[index] : fallback;
+	}
+
+	// The loop that built the mesh in the old OptimizedObjLoader::_LoadFromObjFile, from what LegacyParseObj read
+	void LegacyBuildMesh(const ParallelObjParser::Result& obj, MeshBuilder<VertexPosNormTexColTangents>& mesh) {
+		glm::vec4 color = glm::vec4(1.0f);
+		mesh.ReserveVertexSpace(obj.Vertices.size());
+		for (const auto& vertexIndices : obj.Vertices) {
+			VertexPosNormTexColTangents vertex;
+			vertex.Position = obj.Positions[vertexIndices.x];
+			vertex.UV       = LegacyAttribute(obj.UVs, vertexIndices.y, glm::vec2(0.0f));
+			vertex.Normal   = LegacyAttribute(obj.Normals, vertexIndices.z, glm::vec3(0.0f, 0.0f, 1.0f));
+			vertex.Color    = color;
+			mesh.AddVertex(vertex);
+		}
+		mesh.ReserveIndexSpace(obj.Indices.size());
+		for (uint32_t ix : obj.Indices) {
+			mesh.AddIndex(ix);
+		}
+		MeshFactory::CalculateTBN(mesh);
+	}
+}
+
+TEST_CASE(ParallelObjParser_MatchesLegacyLoader) {
+	// Big enough to be split into several chunks, with relative indices that cross chunk boundaries
+	for (bool windowsLineEndings : { false, true }) {
+		std::string text = MakeGridObj(128, windowsLineEndings);
+		REQUIRE(text.size() > 8 * 64 * 1024);
+
+		ParallelObjParser::Result legacy = ParseLegacy(text);
+		CHECK_EQ(legacy.Positions.size(), 129u * 129u);
+		CHECK_EQ(legacy.Indices.size(), 128u * 128u * 6u);
+
+		for (uint32_t threads : { 1u, 3u, 8u }) {
+			CheckSameResult(Parse(text, threads), legacy);
+		}
+	}
+}
+
+// Every mesh that ships with the game has to load exactly like it did with the old loader
+TEST_CASE(ParallelObjParser_MatchesLegacyLoaderOnResMeshes) {
+	std::vector<std::string> files = FindResObjFiles();
+	REQUIRE(files.size() >= 6);
+
+	for (const std::string& path : files) {
+		std::ifstream file(path, std::ios::binary);
+		std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+		REQUIRE(!text.empty());
+
+		ParallelObjParser::Result result;
+		REQUIRE(ParallelObjParser::ParseFile(path, result));
+		ParallelObjParser::Result legacy = ParseLegacy(text);
+		CHECK(!legacy.Indices.empty());
+		CheckSameResult(result, legacy);
+	}
+}
+
+// Checks the final meshes rather than the parsed indices, so this also covers turning the indices into vertices
+TEST_CASE(ParallelObjParser_BuildsSameMeshesAsLegacyLoaderOnResMeshes) {
+	std::vector<std::string> files = FindResObjFiles();
+	REQUIRE(files.size() >= 6);
+
+	for (const std::string& path : files) {
+		std::ifstream file(path, std::ios::binary);
+		ParallelObjParser::Result legacyObj;
+		LegacyParseObj(file, legacyObj);
+		MeshBuilder<VertexPosNormTexColTangents> legacy;
+		LegacyBuildMesh(legacyObj, legacy);
+
+		// The same steps as OptimizedObjLoader::_LoadFromObjFile
+		ParallelObjParser::Result obj;
+		REQUIRE(ParallelObjParser::ParseFile(path, obj));
+		MeshBuilder<VertexPosNormTexColTangents> mesh;
+		ObjLoader::BuildMesh(obj, mesh);
+		MeshFactory::CalculateTBN(mesh);
+
+		CHECK(legacy.GetIndexCount() > 0);
+		REQUIRE(mesh.GetVertexCount() == legacy.GetVertexCount());
+		REQUIRE(mesh.GetIndexCount() == legacy.GetIndexCount());
+		CHECK(memcmp(mesh.GetVertexDataPtr(), legacy.GetVertexDataPtr(), mesh.GetVertexCount() * sizeof(VertexPosNormTexColTangents)) == 0);
+		CHECK(memcmp(mesh.GetIndexDataPtr(), legacy.GetIndexDataPtr(), mesh.GetIndexCount() * sizeof(uint32_t)) == 0);
+	}
+}
+
+TEST_CASE(ParallelObjParser_ParseFileMatchesParse) {
+	std::string text = MakeGridObj(32);
+	std::string path = (std::filesystem::temp_directory_path() / "parallel-obj-parser-test.obj").string();
+	std::ofstream(path, std::ios::binary) << text;
+
+	ParallelObjParser::Result result;
+	REQUIRE(ParallelObjParser::ParseFile(path, result));
+	CheckSameResult(result, ParseLegacy(text));
+	std::filesystem::remove(path);
+
+	CHECK(!ParallelObjParser::ParseFile(path, result));
+}
+
+// The old loader only understood p/t/n corners, and misread or dropped faces in any other form (test.obj has
+// thousands of p//n faces). We read them with the same rules, so those meshes still load like they used to
+TEST_CASE(ParallelObjParser_OtherCornerFormsMatchLegacyLoader) {
+	const std::string attributes = "v 0 0 0\nv 1 0 0\nv 0 1 0\nv 1 1 0\nvt 0.5 0.5\nvt 1 1\nvn 0 0 1\nvn 0 1 0\n";
+	const char* faces[] = {
+		// p//n: the second slash fails to read as a UV, so only the first corner is added and the face is dropped
+		"f 1//1 2//1 3//1\n",
+		// p and p/t: the next corner gets read as part of this one
+		"f 1 2 3\n",
+		"f 1/1 2/1 3/1\n",
+		"f 1/1 2/2 3/1 4/2\n",
+		// A face that ends part way through a corner
+		"f 1/2/1 2/2/2 3/2\n",
+		// Only the first 4 corners are read
+		"f 1/1/1 2/2/2 3/1/1 4/2/2 1/1/1\n",
+		// Signs, extra whitespace, and a UV index that doesn't fit in an int
+		"f +1/+2/+1 -1/-1/-1 2/1/2\n",
+		"f  1/2/1\t2/2/2 3/2/1  \r\n",
+		"f 1/2/1 2/99999999999/2 3/1/1\n",
+		"f\n"
+	};
+	for (const char* face : faces) {
+		const std::string text = attributes + face + "f 1/1/1 2/2/2 3/1/2\n";
+		CheckSameResult(Parse(text), ParseLegacy(text));
+	}
+
+	// And again at the end of a file big enough to be split into chunks
+	std::string text = MakeGridObj(64);
+	for (const char* face : faces) {
+		text += face;
+	}
+	CheckSameResult(Parse(text, 8), ParseLegacy(text));
+
+	// p//n faces are dropped, but their first corner is still a vertex
+	ParallelObjParser::Result result = Parse(attributes + "f 1//1 2//1 3//1\n");
+	CHECK(result.Indices.empty());
+	CHECK(result.Vertices.size() == 1 && result.Vertices[0] == glm::ivec3(0, -1, -1));
+
+	// Positions that don't exist are an error (the old loader read out of bounds)
+	bool threw = false;
+	try { Parse(attributes + "f 1/1/1 2/1/1 5/1/1\n"); }
+	catch (const std::runtime_error&) { threw = true; }
+	CHECK(threw);
+}
+
+TEST_CASE(ParallelObjParser_IgnoresUnknownLines) {
+	// Anything we don't understand is skipped a whole line at a time, including extra face corners
+	ParallelObjParser::Result result = Parse(
+		"# comment with v 1 2 3 in it\n"
+		"mtllib test.mtl\n"
+		"  v 1 2 3\n"
+		"vp 0.5\n"
+		"\n"
+		"v +1.5 -2e-1 3\n"
+		"v 0 0 0\n"
+		"v 1 1 1\n"
+		"v 2 2 2\n"
+		"l 1 2\n"
+		"f 1/1/1 2/1/1 3/1/1 4/1/1 5/1/1\n");
+	REQUIRE(result.Positions.size() == 5);
+	CHECK(result.Positions[1] == glm::vec3(1.5f, -0.2f, 3.0f));
+	CHECK_EQ(result.Indices.size(), 6u);
+
+	Parse("", 4);
+	CHECK(Parse("").Vertices.empty());
+}
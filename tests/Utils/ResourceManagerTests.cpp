@@ -0,0 +1,214 @@
+#include <algorithm>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "Utils/FileHelpers.h"
+#include "Utils/ResourceManager/ResourceManager.h"
+
+#include "TestFramework.h"
+
+// A resource that only reports a fixed memory usage, so the tests can control the budget exactly
+class TestBudgetResource : public IResource {
+public:
+	MAKE_PTRS(TestBudgetResource);
+
+	std::string Name;
+	size_t      Bytes = 0;
+
+	static TestBudgetResource::Sptr FromJson(const nlohmann::json& data) {
+		TestBudgetResource::Sptr result = std::make_shared<TestBudgetResource>();
+		result->Name = data["name"];
+		result->Bytes = data["bytes"];
+		return result;
+	}
+
+	size_t GetMemoryUsage() const override { return Bytes; }
+
+	nlohmann::json ToJson() const override {
+		return { { "name", Name }, { "bytes", Bytes } };
+	}
+};
+
+// A resource that fails to load when its manifest entry asks it to, like an asset whose file is missing
+class TestFailingResource : public IResource {
+public:
+	MAKE_PTRS(TestFailingResource);
+
+	static TestFailingResource::Sptr FromJson(const nlohmann::json& data) {
+		if (data["fail"].get<bool>()) {
+			throw std::runtime_error("Could not open file");
+		}
+		return std::make_shared<TestFailingResource>();
+	}
+
+	nlohmann::json ToJson() const override {
+		return { { "fail", false } };
+	}
+};
+
+namespace {
+	// Four 100 byte assets named a through d, loaded from a manifest so they can be evicted
+	std::vector<Guid> LoadTestManifest() {
+		ResourceManager::Cleanup();
+		ResourceManager::SetMemoryBudget(0);
+		ResourceManager::RegisterType<TestBudgetResource>();
+
+		std::vector<Guid> result;
+		nlohmann::json items = nlohmann::json::object();
+		for (char name = 'a'; name <= 'd'; name++) {
+			Guid id = Guid::New();
+			items[id.str()] = { { "guid", id.str() }, { "name", std::string(1, name) }, { "bytes", 100 } };
+			result.push_back(id);
+		}
+		nlohmann::json manifest;
+		manifest[StringTools::SanitizeClassName(typeid(TestBudgetResource).name())] = items;
+
+		std::string path = (std::filesystem::temp_directory_path() / "resource-manager-test.json").string();
+		FileHelpers::WriteContentsToFile(path, manifest.dump());
+		ResourceManager::LoadManifest(path);
+		std::filesystem::remove(path);
+		return result;
+	}
+
+	// The names of the loaded test assets, sorted. Each doesn't touch the LRU order
+	std::string ResidentNames() {
+		std::string result;
+		ResourceManager::Each<TestBudgetResource>([&](const TestBudgetResource::Sptr& resource) {
+			result += resource->Name;
+		});
+		std::sort(result.begin(), result.end());
+		return result;
+	}
+
+	ResourceManager::ResidencyStats GetStats() {
+		std::string typeName = StringTools::SanitizeClassName(typeid(TestBudgetResource).name());
+		for (const ResourceManager::ResidencyStats& stats : ResourceManager::GetResidencyStats()) {
+			if (stats.TypeName == typeName) {
+				return stats;
+			}
+		}
+		return ResourceManager::ResidencyStats();
+	}
+}
+
+TEST_CASE(ResourceManager_EvictsLeastRecentlyUsedFirst) {
+	std::vector<Guid> ids = LoadTestManifest();
+	for (const Guid& id : ids) {
+		REQUIRE(ResourceManager::Get<TestBudgetResource>(id) != nullptr);
+	}
+	CHECK_EQ(ResidentNames(), std::string("abcd"));
+	CHECK_EQ(ResourceManager::GetResidentBytes(), 400u);
+
+	// Using a again makes b the least recently used
+	ResourceManager::Get<TestBudgetResource>(ids[0]);
+	size_t evictions = GetStats().Evictions;
+
+	CHECK_EQ(ResourceManager::EnforceMemoryBudget(), 0u);
+	ResourceManager::SetMemoryBudget(250);
+	CHECK_EQ(ResidentNames(), std::string("ad"));
+	CHECK_EQ(ResourceManager::GetResidentBytes(), 200u);
+	CHECK_EQ(GetStats().Evictions - evictions, 2u);
+
+	// Shrinking the budget further keeps going in the same order, a was used after d was loaded
+	ResourceManager::SetMemoryBudget(150);
+	CHECK_EQ(ResidentNames(), std::string("a"));
+
+	// Evicted assets come back from the manifest on the next Get
+	size_t reloads = GetStats().Reloads;
+	TestBudgetResource::Sptr b = ResourceManager::Get<TestBudgetResource>(ids[1]);
+	REQUIRE(b != nullptr);
+	CHECK_EQ(b->Name, std::string("b"));
+	CHECK_EQ(GetStats().Reloads - reloads, 1u);
+	// Loading b put us over budget again, and since we're holding b, a has to go
+	CHECK_EQ(ResidentNames(), std::string("b"));
+
+	ResourceManager::SetMemoryBudget(0);
+	ResourceManager::Cleanup();
+}
+
+TEST_CASE(ResourceManager_DoesNotEvictAssetsInUse) {
+	std::vector<Guid> ids = LoadTestManifest();
+	std::vector<TestBudgetResource::Sptr> held;
+	for (const Guid& id : ids) {
+		held.push_back(ResourceManager::Get<TestBudgetResource>(id));
+	}
+
+	// Everything is referenced from outside the resource manager, so nothing can go
+	ResourceManager::SetMemoryBudget(100);
+	CHECK_EQ(ResidentNames(), std::string("abcd"));
+	CHECK_EQ(GetStats().EvictableBytes, 0u);
+
+	// a is the least recently used, but it is still held, so b and c are evicted instead
+	held[1].reset();
+	held[2].reset();
+	held[3].reset();
+	CHECK_EQ(GetStats().EvictableBytes, 300u);
+	ResourceManager::SetMemoryBudget(200);
+	CHECK_EQ(ResidentNames(), std::string("ad"));
+
+	// Copies handed out by Get count as users too
+	TestBudgetResource::Sptr d = ResourceManager::Get<TestBudgetResource>(ids[3]);
+	ResourceManager::SetMemoryBudget(100);
+	CHECK_EQ(ResidentNames(), std::string("ad"));
+	d.reset();
+	CHECK_EQ(ResourceManager::EnforceMemoryBudget(), 100u);
+	CHECK_EQ(ResidentNames(), std::string("a"));
+	// The held asset is never dropped, even though it's still over budget
+	CHECK(held[0]->Name == "a");
+	ResourceManager::SetMemoryBudget(1);
+	CHECK_EQ(ResidentNames(), std::string("a"));
+
+	ResourceManager::SetMemoryBudget(0);
+	ResourceManager::Cleanup();
+}
+
+TEST_CASE(ResourceManager_DoesNotEvictCreatedAssets) {
+	LoadTestManifest();
+	// Assets created at runtime have no manifest entry to reload them from
+	TestBudgetResource::Sptr created = ResourceManager::CreateAsset<TestBudgetResource>();
+	created->Name = "e";
+	created->Bytes = 100;
+	created.reset();
+
+	ResourceManager::SetMemoryBudget(1);
+	CHECK_EQ(ResidentNames(), std::string("e"));
+	CHECK_EQ(GetStats().EvictableBytes, 0u);
+
+	ResourceManager::SetMemoryBudget(0);
+	ResourceManager::Cleanup();
+}
+
+TEST_CASE(ResourceManager_FailedLoadDoesNotStopOthers) {
+	ResourceManager::Cleanup();
+	ResourceManager::RegisterType<TestFailingResource>();
+
+	// The failing asset is first in the manifest, so the other one is created after it
+	Guid bad = Guid::New();
+	Guid good = Guid::New();
+	nlohmann::json items = nlohmann::json::object();
+	items[bad.str()] = { { "guid", bad.str() }, { "filename", "missing.png" }, { "fail", true } };
+	items[good.str()] = { { "guid", good.str() }, { "fail", false } };
+	nlohmann::json manifest;
+	manifest[StringTools::SanitizeClassName(typeid(TestFailingResource).name())] = items;
+
+	std::string path = (std::filesystem::temp_directory_path() / "resource-manager-fail-test.json").string();
+	FileHelpers::WriteContentsToFile(path, manifest.dump());
+	ResourceManager::LoadManifest(path, true);
+	std::filesystem::remove(path);
+
+	ResourceManager::AsyncAsset<TestFailingResource> badAsset = ResourceManager::GetAsync<TestFailingResource>(bad);
+	ResourceManager::AsyncAsset<TestFailingResource> goodAsset = ResourceManager::GetAsync<TestFailingResource>(good);
+	for (int frame = 0; frame < 100 && ResourceManager::GetPendingLoadCount() > 0; frame++) {
+		ResourceManager::ProcessUploads(0.0f);
+	}
+
+	CHECK_EQ(ResourceManager::GetPendingLoadCount(), 0u);
+	CHECK(badAsset.GetState() == AssetLoadState::Failed);
+	CHECK(badAsset.Get() == nullptr);
+	CHECK(goodAsset.GetState() == AssetLoadState::Loaded);
+	CHECK(goodAsset.Get() != nullptr);
+
+	ResourceManager::Cleanup();
+}